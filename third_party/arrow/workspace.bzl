@@ -0,0 +1,36 @@
+"""Apache Arrow project (Parquet support)."""
+
+def deps(prefix = ""):
+    # Arrow does not provide a Bazel build. Instead, we link against a local
+    # installation of the pre-compiled Arrow and Parquet libraries e.g.
+    # "apt-get install libarrow-dev libparquet-dev" or a conda environment.
+    # If Arrow is installed somewhere else than "/usr", update "path" below.
+    #
+    # This repository is only used when compiling with "--define=use_arrow=1"
+    # (see "parquet_example_reader" in "dataset/BUILD").
+
+    build_file_content = """
+package(
+    default_visibility = ["//visibility:public"],
+    licenses = ["notice"],
+)
+
+cc_library(
+    name = "parquet",
+    hdrs = glob([
+        "include/arrow/**/*.h",
+        "include/parquet/**/*.h",
+    ]),
+    includes = ["include"],
+    linkopts = [
+        "-larrow",
+        "-lparquet",
+    ],
+)
+  """
+
+    native.new_local_repository(
+        name = "org_apache_arrow",
+        build_file_content = build_file_content,
+        path = "/usr",
+    )
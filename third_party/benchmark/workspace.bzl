@@ -0,0 +1,11 @@
+"""Google Benchmark project."""
+
+load("@bazel_tools//tools/build_defs/repo:http.bzl", "http_archive")
+
+def deps():
+    http_archive(
+        name = "com_google_benchmark",
+        urls = ["https://github.com/google/benchmark/archive/refs/tags/v1.6.1.tar.gz"],
+        strip_prefix = "benchmark-1.6.1",
+        sha256 = "6132883bc8c9b0df5375b16ab520fac1a85dc9e4cf5be59480448ece74b278d4",
+    )
@@ -31,31 +31,49 @@
 //
 // The benchmark measures one copy of the dataset (from the best possible
 // existing format; a simple memory copy in the best case) and one run of the
-// engine.
+// engine. The warmup runs are excluded from all the reported timings. In
+// addition to the average time per example, the benchmark reports the p50, p95
+// and p99 of the individual batch latencies measured over all the benchmark
+// runs. Each engine can be swept over several batch sizes (--batch_sizes) and
+// number of threads (--num_threads). With more than one thread, the batches
+// are distributed over the threads of a thread pool created before the timed
+// runs.
 //
 // Usage example:
 //
 //   bazel run -c opt --copt=-mavx2 :benchmark_inference -- \
 //     --alsologtostderr \
 //     --model=/path/to/my/model \
-//     --dataset=csv:/path/to/my/dataset.csv
+//     --dataset=csv:/path/to/my/dataset.csv \
+//     --batch_sizes=100,1000 --num_threads=1,4
 //
 // Result:
 //
-//   batch_size : 100  num_runs : 20
-//   time/example(µs)  time/batch(µs)  method
-//   ----------------------------------------
-//   0.79025         79.025  GradientBoostedTreesQuickScorerExtended
-//   9.179           917.9   GradientBoostedTreesGeneric
-//   21.547          2154.8  Generic slow engine
-//   ----------------------------------------
+//   num_runs : 20
+//   time/example(us)  time/batch(us)  p50(us)  p95(us)  p99(us)  batch  threads  method
+//   -----------------------------------------------------------------------------------
+//   0.79025         79.025  81.1  95.2  103.4  100  1  GradientBoostedTreesQuickScorerExtended
+//   9.179           917.9   920.5  1004  1113  100  1  GradientBoostedTreesGeneric
+//   21.547          2154.8  21.8  24.1  29.5   1    1  Generic slow engine
+//   -----------------------------------------------------------------------------------
 //
+// Use --format=csv to emit the same results as a CSV table e.g. to track the
+// timings of a model across versions in a continuous integration setup.
+//
+#include <algorithm>
+#include <vector>
+
 #include "absl/flags/flag.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 ABSL_FLAG(std::string, model, "", "Path to model.");
 ABSL_FLAG(std::string, dataset, "",
@@ -67,12 +85,22 @@ ABSL_FLAG(
 ABSL_FLAG(int, batch_size, 100,
           "Number of examples per batch. Note that some engine are not impacted"
           "by the batch size.");
+ABSL_FLAG(std::string, batch_sizes, "",
+          "Comma-separated list of batch sizes to benchmark e.g. "
+          "\"100,1000\". If empty (default), uses --batch_size.");
+ABSL_FLAG(std::string, num_threads, "1",
+          "Comma-separated list of number of threads to benchmark e.g. "
+          "\"1,4,8\". With more than one thread, the batches are distributed "
+          "over the threads of a thread pool.");
 ABSL_FLAG(int, warmup_runs, 1,
           "Number of runs through the dataset before the benchmark.");
 ABSL_FLAG(bool, generic, true,
           "Evaluates the slow engine i.e. model->predict(). The "
           "generic engine is slow and mostly a reference. Disable it if the "
           "benchmark runs for too long.");
+ABSL_FLAG(std::string, format, "text",
+          "Output format of the results. \"text\" prints a human readable "
+          "table. \"csv\" prints a machine readable CSV table.");
 
 constexpr char kUsageMessage[] =
     "Benchmarks the inference time of a model with the available inference "
@@ -83,16 +111,35 @@ namespace yggdrasil_decision_forests {
 // Result from a single run.
 struct Result {
   std::string name;
+  int batch_size;
+  int num_threads;
+  // Average inference duration per example.
   absl::Duration avg_inference_duration;
+  // Percentiles of the individual batch latencies (one latency per batch and
+  // per run; per example for the generic slow engine).
+  absl::Duration p50_latency;
+  absl::Duration p95_latency;
+  absl::Duration p99_latency;
 };
 
 // How to run the benchmark.
 struct RunOptions {
   int num_runs;
-  int batch_size;
+  std::vector<int> batch_sizes;
+  std::vector<int> num_threads;
   int warmup_runs;
 };
 
+// Returns the percentile "quantile" in [0,1] of the latency samples.
+// "latencies" is sorted in place.
+absl::Duration LatencyPercentile(std::vector<absl::Duration>* latencies,
+                                 const double quantile) {
+  CHECK(!latencies->empty());
+  std::sort(latencies->begin(), latencies->end());
+  const auto rank = static_cast<size_t>(quantile * (latencies->size() - 1));
+  return (*latencies)[rank];
+}
+
 std::string ResultsToString(const RunOptions& options,
                             std::vector<Result> results) {
   std::string report;
@@ -102,19 +149,47 @@ std::string ResultsToString(const RunOptions& options,
     return a.avg_inference_duration < b.avg_inference_duration;
   });
 
-  absl::StrAppendFormat(&report, "batch_size : %d  num_runs : %d\n",
-                        options.batch_size, options.num_runs);
-  absl::StrAppendFormat(&report, "time/example(us)  time/batch(us)  method\n");
-  absl::StrAppendFormat(&report, "----------------------------------------\n");
+  absl::StrAppendFormat(&report, "num_runs : %d\n", options.num_runs);
+  absl::StrAppendFormat(&report,
+                        "time/example(us)  time/batch(us)  p50(us)  p95(us)  "
+                        "p99(us)  batch  threads  method\n");
+  absl::StrAppendFormat(
+      &report,
+      "-----------------------------------------------------------------------"
+      "--------\n");
+  for (const auto& result : results) {
+    absl::StrAppendFormat(
+        &report, "%16.5g  %14.5g  %7.4g  %7.4g  %7.4g  %5d  %7d  %s\n",
+        absl::ToDoubleMicroseconds(result.avg_inference_duration),
+        absl::ToDoubleMicroseconds(result.avg_inference_duration *
+                                   result.batch_size),
+        absl::ToDoubleMicroseconds(result.p50_latency),
+        absl::ToDoubleMicroseconds(result.p95_latency),
+        absl::ToDoubleMicroseconds(result.p99_latency), result.batch_size,
+        result.num_threads, result.name);
+  }
+  absl::StrAppendFormat(
+      &report,
+      "-----------------------------------------------------------------------"
+      "--------\n");
+  return report;
+}
+
+std::string ResultsToCsv(const std::vector<Result>& results) {
+  std::string report =
+      "method,batch_size,num_threads,time_per_example_us,time_per_batch_us,"
+      "p50_latency_us,p95_latency_us,p99_latency_us\n";
   for (const auto& result : results) {
     absl::StrAppendFormat(
-        &report, "%16.5g  %14.5g  %s\n",
+        &report, "%s,%d,%d,%g,%g,%g,%g,%g\n", result.name, result.batch_size,
+        result.num_threads,
         absl::ToDoubleMicroseconds(result.avg_inference_duration),
         absl::ToDoubleMicroseconds(result.avg_inference_duration *
-                                   options.batch_size),
-        result.name);
+                                   result.batch_size),
+        absl::ToDoubleMicroseconds(result.p50_latency),
+        absl::ToDoubleMicroseconds(result.p95_latency),
+        absl::ToDoubleMicroseconds(result.p99_latency));
   }
-  absl::StrAppendFormat(&report, "----------------------------------------\n");
   return report;
 }
 
@@ -123,12 +198,17 @@ absl::Status BenchmarkGenericSlowEngine(const RunOptions& options,
                                         const dataset::VerticalDataset& dataset,
                                         std::vector<Result>* results) {
   std::vector<float> predictions(dataset.nrow());
+  std::vector<absl::Duration> latencies;
 
-  auto run_once = [&]() {
+  auto run_once = [&](const bool record_latencies) {
     model::proto::Prediction prediction;
     for (dataset::VerticalDataset::row_t example_idx = 0;
          example_idx < dataset.nrow(); example_idx++) {
+      const auto example_start_time = absl::Now();
       model.Predict(dataset, example_idx, &prediction);
+      if (record_latencies) {
+        latencies.push_back(absl::Now() - example_start_time);
+      }
       switch (prediction.type_case()) {
         case model::proto::Prediction::kClassification:
           predictions[example_idx] =
@@ -149,26 +229,33 @@ absl::Status BenchmarkGenericSlowEngine(const RunOptions& options,
 
   // Warming up.
   for (int run_idx = 0; run_idx < options.warmup_runs; run_idx++) {
-    run_once();
+    run_once(/*record_latencies=*/false);
   }
 
   // Run benchmark.
+  latencies.reserve(options.num_runs * dataset.nrow());
   const auto start_time = absl::Now();
   for (int run_idx = 0; run_idx < options.num_runs; run_idx++) {
-    run_once();
+    run_once(/*record_latencies=*/true);
   }
   const auto end_time = absl::Now();
 
   // Save results.
   results->push_back(
       {/*.name =*/"Generic slow engine",
+       /*.batch_size =*/1,
+       /*.num_threads =*/1,
        /*.avg_inference_duration =*/
-       (end_time - start_time) / (options.num_runs * dataset.nrow())});
+       (end_time - start_time) / (options.num_runs * dataset.nrow()),
+       /*.p50_latency =*/LatencyPercentile(&latencies, 0.50),
+       /*.p95_latency =*/LatencyPercentile(&latencies, 0.95),
+       /*.p99_latency =*/LatencyPercentile(&latencies, 0.99)});
   return absl::OkStatus();
 }
 
 absl::Status BenchmarkFastEngineWithVirtualInterface(
-    const RunOptions& options, const model::FastEngineFactory& engine_factory,
+    const RunOptions& options, const int batch_size, const int num_threads,
+    const model::FastEngineFactory& engine_factory,
     const model::AbstractModel& model, const dataset::VerticalDataset& dataset,
     std::vector<Result>* results) {
   // Compile the model.
@@ -183,47 +270,104 @@ absl::Status BenchmarkFastEngineWithVirtualInterface(
       /*begin_example_idx=*/0,
       /*end_example_idx=*/total_num_examples, engine_features, examples.get()));
 
-  // Allocate a batch of examples.
-  auto batch_of_examples = engine->AllocateExamples(options.batch_size);
   const int64_t num_batches =
-      (total_num_examples + options.batch_size - 1) / options.batch_size;
-
-  std::vector<float> predictions(dataset.nrow());
-
-  auto run_once = [&]() {
-    for (int64_t batch_idx = 0; batch_idx < num_batches; batch_idx++) {
-      const int64_t begin_example_idx = batch_idx * options.batch_size;
-      const int64_t end_example_idx =
-          std::min(begin_example_idx + options.batch_size, total_num_examples);
-      // Copy the examples.
-      CHECK_OK(examples->Copy(begin_example_idx, end_example_idx,
-                              engine_features, batch_of_examples.get()));
-      // Runs the engine.
-      engine->Predict(*batch_of_examples, end_example_idx - begin_example_idx,
-                      &predictions);
+      (total_num_examples + batch_size - 1) / batch_size;
+  const int num_workers =
+      std::min(static_cast<int64_t>(num_threads), num_batches);
+
+  // Each worker owns a batch of examples, a buffer of predictions and the
+  // latencies of the batches it ran. The thread pool is created (and the
+  // workers started) outside of the timed runs.
+  struct WorkerContext {
+    std::unique_ptr<serving::AbstractExampleSet> batch_of_examples;
+    std::vector<float> predictions;
+    std::vector<absl::Duration> latencies;
+  };
+  std::vector<WorkerContext> worker_contexts(num_workers);
+  for (auto& context : worker_contexts) {
+    context.batch_of_examples = engine->AllocateExamples(batch_size);
+    context.predictions.resize(batch_size * engine->NumPredictionDimension());
+  }
+  utils::concurrency::ThreadPool thread_pool("benchmark", num_workers);
+  thread_pool.StartWorkers();
+
+  auto run_once = [&](const bool record_latencies) {
+    utils::concurrency::BlockingCounter done_workers(num_workers);
+    for (int worker_idx = 0; worker_idx < num_workers; worker_idx++) {
+      thread_pool.Schedule([&, worker_idx]() {
+        auto& context = worker_contexts[worker_idx];
+        for (int64_t batch_idx = worker_idx; batch_idx < num_batches;
+             batch_idx += num_workers) {
+          const int64_t begin_example_idx = batch_idx * batch_size;
+          const int64_t end_example_idx =
+              std::min(begin_example_idx + batch_size, total_num_examples);
+          const auto batch_start_time = absl::Now();
+          // Copy the examples.
+          CHECK_OK(examples->Copy(begin_example_idx, end_example_idx,
+                                  engine_features,
+                                  context.batch_of_examples.get()));
+          // Runs the engine.
+          engine->Predict(*context.batch_of_examples,
+                          end_example_idx - begin_example_idx,
+                          &context.predictions);
+          if (record_latencies) {
+            context.latencies.push_back(absl::Now() - batch_start_time);
+          }
+        }
+        done_workers.DecrementCount();
+      });
     }
+    done_workers.Wait();
   };
 
   // Warming up.
   for (int run_idx = 0; run_idx < options.warmup_runs; run_idx++) {
-    run_once();
+    run_once(/*record_latencies=*/false);
   }
 
   // Run benchmark.
   const auto start_time = absl::Now();
   for (int run_idx = 0; run_idx < options.num_runs; run_idx++) {
-    run_once();
+    run_once(/*record_latencies=*/true);
   }
   const auto end_time = absl::Now();
 
+  // Merge the latencies of the workers.
+  std::vector<absl::Duration> latencies;
+  for (const auto& context : worker_contexts) {
+    latencies.insert(latencies.end(), context.latencies.begin(),
+                     context.latencies.end());
+  }
+
   // Save results.
   results->push_back(
       {/*.name =*/absl::StrCat(engine_factory.name(), " [virtual interface]"),
+       /*.batch_size =*/batch_size,
+       /*.num_threads =*/num_workers,
        /*.avg_inference_duration =*/
-       (end_time - start_time) / (options.num_runs * dataset.nrow())});
+       (end_time - start_time) / (options.num_runs * dataset.nrow()),
+       /*.p50_latency =*/LatencyPercentile(&latencies, 0.50),
+       /*.p95_latency =*/LatencyPercentile(&latencies, 0.95),
+       /*.p99_latency =*/LatencyPercentile(&latencies, 0.99)});
   return absl::OkStatus();
 }
 
+// Parses a comma-separated list of strictly positive integers e.g. "100,1000".
+utils::StatusOr<std::vector<int>> ParsePositiveIntList(
+    const absl::string_view text, const absl::string_view flag_name) {
+  std::vector<int> values;
+  for (const absl::string_view item : absl::StrSplit(text, ',')) {
+    int value;
+    if (!absl::SimpleAtoi(item, &value) || value <= 0) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Invalid value \"", item, "\" for ", flag_name,
+          ". Expecting a comma-separated list of strictly positive integers."));
+    }
+    values.push_back(value);
+  }
+  return values;
+}
+
 absl::Status Benchmark() {
   // Parse flags.
   const auto model_path = absl::GetFlag(FLAGS_model);
@@ -236,11 +380,26 @@ absl::Status Benchmark() {
     return absl::InvalidArgumentError("The --dataset is not specified.");
   }
 
-  const RunOptions options{
-      /*.num_runs =*/absl::GetFlag(FLAGS_num_runs),
-      /*.batch_size =*/absl::GetFlag(FLAGS_batch_size),
-      /*.warmup_runs =*/absl::GetFlag(FLAGS_warmup_runs),
-  };
+  RunOptions options;
+  options.num_runs = absl::GetFlag(FLAGS_num_runs);
+  options.warmup_runs = absl::GetFlag(FLAGS_warmup_runs);
+  const auto batch_sizes = absl::GetFlag(FLAGS_batch_sizes);
+  if (batch_sizes.empty()) {
+    options.batch_sizes = {absl::GetFlag(FLAGS_batch_size)};
+  } else {
+    ASSIGN_OR_RETURN(options.batch_sizes,
+                     ParsePositiveIntList(batch_sizes, "--batch_sizes"));
+  }
+  ASSIGN_OR_RETURN(
+      options.num_threads,
+      ParsePositiveIntList(absl::GetFlag(FLAGS_num_threads), "--num_threads"));
+
+  const auto format = absl::GetFlag(FLAGS_format);
+  if (format != "text" && format != "csv") {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid value \"", format,
+                     "\" for --format. Possible values are: text, csv."));
+  }
 
   LOG(INFO) << "Loading model";
   std::unique_ptr<model::AbstractModel> model;
@@ -259,9 +418,16 @@ absl::Status Benchmark() {
   LOG(INFO) << "Found " << engine_factories.size()
             << " compatible fast engines.";
   for (const auto& engine_factory : engine_factories) {
-    LOG(INFO) << "Running " << engine_factory->name();
-    RETURN_IF_ERROR(BenchmarkFastEngineWithVirtualInterface(
-        options, *engine_factory, *model.get(), dataset, &results));
+    for (const int batch_size : options.batch_sizes) {
+      for (const int num_threads : options.num_threads) {
+        LOG(INFO) << "Running " << engine_factory->name()
+                  << " with batch_size:" << batch_size
+                  << " num_threads:" << num_threads;
+        RETURN_IF_ERROR(BenchmarkFastEngineWithVirtualInterface(
+            options, batch_size, num_threads, *engine_factory, *model.get(),
+            dataset, &results));
+      }
+    }
   }
 
   if (absl::GetFlag(FLAGS_generic)) {
@@ -271,7 +437,11 @@ absl::Status Benchmark() {
   }
 
   // Show results.
-  std::cout << ResultsToString(options, results);
+  if (format == "csv") {
+    std::cout << ResultsToCsv(results);
+  } else {
+    std::cout << ResultsToString(options, results);
+  }
   return absl::OkStatus();
 }
 
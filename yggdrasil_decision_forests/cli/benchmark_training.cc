@@ -0,0 +1,292 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks the training time of the registered learners on a synthetic
+// dataset.
+//
+// The benchmark generates a synthetic dataset (see
+// yggdrasil_decision_forests/dataset/synthetic_dataset.cc) of configurable
+// size and shape, and then trains each of the selected learners on it. For
+// each learner, the wall time of the following phases is reported separately:
+//
+//   dataspec: Inference of the dataset specification from the dataset files.
+//   load: Reading of the dataset files into a VerticalDataset.
+//   train: Training of the model from the in-memory VerticalDataset.
+//
+// The dataset generation is excluded from all the reported timings.
+//
+// Usage example:
+//
+//   bazel run -c opt :benchmark_training -- \
+//     --alsologtostderr \
+//     --work_dir=/tmp/benchmark_training \
+//     --learners=GRADIENT_BOOSTED_TREES,RANDOM_FOREST \
+//     --num_examples=100000 --num_runs=3
+//
+// Result:
+//
+//   num_runs : 3
+//   time/run(s)   min(s)  phase     learner
+//   ---------------------------------------
+//   0.1523        0.1489  dataspec  GRADIENT_BOOSTED_TREES
+//   0.2856        0.2811  load      GRADIENT_BOOSTED_TREES
+//   12.457        12.285  train     GRADIENT_BOOSTED_TREES
+//   ...
+//   ---------------------------------------
+//
+// Use --format=csv to emit the same results as a CSV table e.g. to track the
+// training timings across versions in a continuous integration setup.
+//
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
+#include "yggdrasil_decision_forests/dataset/synthetic_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/learner/learner_library.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+
+ABSL_FLAG(std::string, work_dir, "",
+          "Directory used to store the generated dataset.");
+ABSL_FLAG(std::string, learners, "GRADIENT_BOOSTED_TREES,RANDOM_FOREST,CART",
+          "Comma-separated list of learner keys to benchmark. See "
+          "AllRegisteredLearners() or the error message of an invalid key for "
+          "the available learners.");
+ABSL_FLAG(std::string, options, "",
+          "Optional path to text serialized proto::SyntheticDatasetOptions "
+          "controlling the shape of the dataset e.g. number and type of "
+          "features, vocabulary sizes.");
+ABSL_FLAG(int, num_examples, 100000,
+          "Number of examples in the synthetic dataset. Overrides the "
+          "\"num_examples\" field of --options.");
+ABSL_FLAG(std::string, task, "classification",
+          "Task of the synthetic dataset. One of \"classification\" and "
+          "\"regression\".");
+ABSL_FLAG(
+    int, num_runs, 3,
+    "Number of times each learner is trained. Higher values increase the "
+    "precision of the timings, but increase the duration of the benchmark.");
+ABSL_FLAG(int, warmup_runs, 0,
+          "Number of non-timed trainings of each learner before the "
+          "benchmark.");
+ABSL_FLAG(int, num_threads, 6, "Number of training threads.");
+ABSL_FLAG(std::string, format, "text",
+          "Output format of the results. \"text\" prints a human readable "
+          "table. \"csv\" prints a machine readable CSV table.");
+
+constexpr char kUsageMessage[] =
+    "Benchmarks the training time of the registered learners on a synthetic "
+    "dataset.";
+
+namespace yggdrasil_decision_forests {
+
+// Timing of a single training phase of a learner.
+struct Result {
+  std::string learner;
+  std::string phase;
+  // Average duration of the phase over the benchmark runs.
+  absl::Duration avg_duration;
+  // Fastest run of the phase.
+  absl::Duration min_duration;
+};
+
+std::string ResultsToString(const int num_runs,
+                            const std::vector<Result>& results) {
+  std::string report;
+  absl::StrAppendFormat(&report, "num_runs : %d\n", num_runs);
+  absl::StrAppendFormat(&report, "time/run(s)   min(s)  phase     learner\n");
+  absl::StrAppendFormat(&report, "---------------------------------------\n");
+  for (const auto& result : results) {
+    absl::StrAppendFormat(&report, "%11.4g  %7.4g  %-8s  %s\n",
+                          absl::ToDoubleSeconds(result.avg_duration),
+                          absl::ToDoubleSeconds(result.min_duration),
+                          result.phase, result.learner);
+  }
+  absl::StrAppendFormat(&report, "---------------------------------------\n");
+  return report;
+}
+
+std::string ResultsToCsv(const std::vector<Result>& results) {
+  std::string report = "learner,phase,time_per_run_s,min_time_s\n";
+  for (const auto& result : results) {
+    absl::StrAppendFormat(&report, "%s,%s,%g,%g\n", result.learner,
+                          result.phase,
+                          absl::ToDoubleSeconds(result.avg_duration),
+                          absl::ToDoubleSeconds(result.min_duration));
+  }
+  return report;
+}
+
+// Trains "learner_key" on "typed_train_path" and appends the timing of each
+// phase to "results".
+absl::Status BenchmarkLearner(const std::string& learner_key,
+                              const absl::string_view typed_train_path,
+                              const dataset::proto::SyntheticDatasetOptions&
+                                  synthetic_options,
+                              std::vector<Result>* results) {
+  const int num_runs = absl::GetFlag(FLAGS_num_runs);
+  const int warmup_runs = absl::GetFlag(FLAGS_warmup_runs);
+
+  model::proto::TrainingConfig train_config;
+  train_config.set_learner(learner_key);
+  train_config.set_label(synthetic_options.label_name());
+  if (synthetic_options.has_regression()) {
+    train_config.set_task(model::proto::Task::REGRESSION);
+  } else {
+    train_config.set_task(model::proto::Task::CLASSIFICATION);
+  }
+
+  std::unique_ptr<model::AbstractLearner> learner;
+  RETURN_IF_ERROR(model::GetLearner(train_config, &learner));
+  learner->mutable_deployment()->set_num_threads(
+      absl::GetFlag(FLAGS_num_threads));
+
+  struct PhaseDurations {
+    std::vector<absl::Duration> dataspec;
+    std::vector<absl::Duration> load;
+    std::vector<absl::Duration> train;
+  };
+  PhaseDurations durations;
+
+  const auto run_once = [&](const bool record_durations) -> absl::Status {
+    // Infer the dataspec.
+    auto start_time = absl::Now();
+    dataset::proto::DataSpecification data_spec;
+    RETURN_IF_ERROR(dataset::CreateDataSpecWithStatus(
+        typed_train_path, /*use_flume=*/false, /*guide=*/{}, &data_spec));
+    if (record_durations) {
+      durations.dataspec.push_back(absl::Now() - start_time);
+    }
+
+    // Load the dataset in memory.
+    start_time = absl::Now();
+    dataset::VerticalDataset dataset;
+    RETURN_IF_ERROR(
+        dataset::LoadVerticalDataset(typed_train_path, data_spec, &dataset));
+    if (record_durations) {
+      durations.load.push_back(absl::Now() - start_time);
+    }
+
+    // Train the model.
+    start_time = absl::Now();
+    RETURN_IF_ERROR(learner->TrainWithStatus(dataset).status());
+    if (record_durations) {
+      durations.train.push_back(absl::Now() - start_time);
+    }
+    return absl::OkStatus();
+  };
+
+  for (int run_idx = 0; run_idx < warmup_runs; run_idx++) {
+    RETURN_IF_ERROR(run_once(/*record_durations=*/false));
+  }
+  for (int run_idx = 0; run_idx < num_runs; run_idx++) {
+    LOG(INFO) << "Run " << (run_idx + 1) << " / " << num_runs << " of "
+              << learner_key;
+    RETURN_IF_ERROR(run_once(/*record_durations=*/true));
+  }
+
+  const auto save_phase = [&](const absl::string_view phase,
+                              const std::vector<absl::Duration>& samples) {
+    absl::Duration sum;
+    absl::Duration min = absl::InfiniteDuration();
+    for (const auto& sample : samples) {
+      sum += sample;
+      min = std::min(min, sample);
+    }
+    results->push_back({/*.learner =*/learner_key, /*.phase =*/
+                        std::string(phase),
+                        /*.avg_duration =*/sum / num_runs,
+                        /*.min_duration =*/min});
+  };
+  save_phase("dataspec", durations.dataspec);
+  save_phase("load", durations.load);
+  save_phase("train", durations.train);
+  return absl::OkStatus();
+}
+
+absl::Status Benchmark() {
+  const auto work_dir = absl::GetFlag(FLAGS_work_dir);
+  if (work_dir.empty()) {
+    return absl::InvalidArgumentError("--work_dir is required");
+  }
+  RETURN_IF_ERROR(file::RecursivelyCreateDir(work_dir, file::Defaults()));
+
+  // Configure the synthetic dataset.
+  dataset::proto::SyntheticDatasetOptions synthetic_options;
+  if (!absl::GetFlag(FLAGS_options).empty()) {
+    RETURN_IF_ERROR(file::GetTextProto(absl::GetFlag(FLAGS_options),
+                                       &synthetic_options, file::Defaults()));
+  }
+  synthetic_options.set_num_examples(absl::GetFlag(FLAGS_num_examples));
+  const auto task = absl::GetFlag(FLAGS_task);
+  if (task == "regression") {
+    synthetic_options.mutable_regression();
+  } else if (task != "classification") {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Unknown task: ", task,
+                     ". Supported tasks: classification, regression."));
+  }
+
+  // Generate the dataset. Not included in the timings.
+  const auto typed_train_path =
+      absl::StrCat("csv:", file::JoinPath(work_dir, "train.csv"));
+  LOG(INFO) << "Generate synthetic dataset with "
+            << synthetic_options.num_examples() << " examples";
+  RETURN_IF_ERROR(
+      dataset::GenerateSyntheticDataset(synthetic_options, typed_train_path));
+
+  // Benchmark the learners.
+  std::vector<Result> results;
+  const std::vector<std::string> learner_keys =
+      absl::StrSplit(absl::GetFlag(FLAGS_learners), ',', absl::SkipEmpty());
+  for (const auto& learner_key : learner_keys) {
+    LOG(INFO) << "Benchmark learner " << learner_key;
+    RETURN_IF_ERROR(BenchmarkLearner(learner_key, typed_train_path,
+                                     synthetic_options, &results));
+  }
+
+  // Export the results.
+  const auto format = absl::GetFlag(FLAGS_format);
+  if (format == "text") {
+    std::cout << ResultsToString(absl::GetFlag(FLAGS_num_runs), results);
+  } else if (format == "csv") {
+    std::cout << ResultsToCsv(results);
+  } else {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "Unknown format: ", format, ". Supported formats: text, csv."));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace yggdrasil_decision_forests
+
+int main(int argc, char** argv) {
+  InitLogging(kUsageMessage, &argc, &argv, true);
+  const auto status = yggdrasil_decision_forests::Benchmark();
+  if (!status.ok()) {
+    LOG(INFO) << "The benchmark failed with the following error: " << status;
+    return 1;
+  }
+  return 0;
+}
@@ -26,13 +26,22 @@
 //     --dataspec= spec.pbtxt \
 //     --output=tfrecord+tfe:/my/dataset.tfrecord-tfe
 //
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
 #include "absl/flags/flag.h"
+#include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/example_reader.h"
 #include "yggdrasil_decision_forests/dataset/example_writer.h"
+#include "yggdrasil_decision_forests/dataset/formats.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/sharded_io.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 ABSL_FLAG(std::string, input, "",
@@ -61,12 +70,81 @@ ABSL_FLAG(bool, ignore_missing_columns, false,
           "If false (default), fails if one of the column in the dataspec is "
           "missing. If true, fill missing columns with \"missing values\".");
 
+ABSL_FLAG(int, num_threads, 8,
+          "Number of conversion threads. Only used if both the input and the "
+          "output paths are sharded (e.g. contain @10) with the same number "
+          "of shards: each input shard is then converted into the output "
+          "shard of same index, and --shard_size is ignored. Otherwise, the "
+          "conversion is done sequentially.");
+
 constexpr char kUsageMessage[] =
     "Converts a dataset from one format to another. The dataspec of the "
     "dataset should be available.";
 
 namespace yggdrasil_decision_forests {
 namespace cli {
+namespace {
+
+// Streams all the examples of "reader" into "writer". Returns the number of
+// converted examples.
+utils::StatusOr<int64_t> ConvertStream(
+    dataset::ExampleReaderInterface* reader,
+    dataset::ExampleWriterInterface* writer) {
+  dataset::proto::Example example;
+  int64_t nrow = 0;
+  while (true) {
+    ASSIGN_OR_RETURN(const bool has_example, reader->Next(&example));
+    if (!has_example) {
+      break;
+    }
+    LOG_INFO_EVERY_N_SEC(30, _ << nrow << " examples converted.");
+    RETURN_IF_ERROR(writer->Write(example));
+    nrow++;
+  }
+  return nrow;
+}
+
+// Converts the input shards into the output shards, one shard per thread.
+// "input_shards" and "output_shards" have the same size and are paths without
+// format prefix.
+int64_t ConvertShardsInParallel(
+    const dataset::proto::DataSpecification& data_spec,
+    const absl::optional<std::vector<int>>& required_columns,
+    const std::string& input_prefix,
+    const std::vector<std::string>& input_shards,
+    const std::string& output_prefix,
+    const std::vector<std::string>& output_shards, const int num_threads) {
+  const int num_shards = input_shards.size();
+  std::vector<int64_t> nrow_per_shard(num_shards, 0);
+  {
+    utils::concurrency::ThreadPool pool(
+        "ConvertDataset", std::min(num_threads, num_shards));
+    pool.StartWorkers();
+    for (int shard_idx = 0; shard_idx < num_shards; shard_idx++) {
+      pool.Schedule([&, shard_idx]() {
+        auto reader =
+            dataset::CreateExampleReader(
+                absl::StrCat(input_prefix, ":", input_shards[shard_idx]),
+                data_spec, required_columns)
+                .value();
+        auto writer =
+            dataset::CreateExampleWriter(
+                absl::StrCat(output_prefix, ":", output_shards[shard_idx]),
+                data_spec, /*num_records_by_shard=*/-1)
+                .value();
+        nrow_per_shard[shard_idx] =
+            ConvertStream(reader.get(), writer.get()).value();
+      });
+    }
+  }
+  int64_t nrow = 0;
+  for (const auto nrow_in_shard : nrow_per_shard) {
+    nrow += nrow_in_shard;
+  }
+  return nrow;
+}
+
+}  // namespace
 
 void ConvertDataset() {
   // Check required flags.
@@ -91,6 +169,33 @@ void ConvertDataset() {
     required_columns = std::vector<int>{};
   }
 
+  // Convert the shards in parallel when the input and output shards map
+  // one-to-one.
+  const int num_threads = absl::GetFlag(FLAGS_num_threads);
+  if (num_threads > 1) {
+    std::string input_prefix, input_path, output_prefix, output_path;
+    std::tie(input_prefix, input_path) =
+        dataset::SplitTypeAndPath(absl::GetFlag(FLAGS_input)).value();
+    std::tie(output_prefix, output_path) =
+        dataset::SplitTypeAndPath(absl::GetFlag(FLAGS_output)).value();
+    std::vector<std::string> input_shards;
+    std::vector<std::string> output_shards;
+    QCHECK_OK(utils::ExpandInputShards(input_path, &input_shards));
+    QCHECK_OK(utils::ExpandOutputShards(output_path, &output_shards));
+    if (input_shards.size() > 1 &&
+        input_shards.size() == output_shards.size()) {
+      if (absl::GetFlag(FLAGS_shard_size) != -1) {
+        LOG(INFO) << "--shard_size is ignored: each input shard is converted "
+                     "into the output shard of same index.";
+      }
+      const int64_t nrow = ConvertShardsInParallel(
+          data_spec, required_columns, input_prefix, input_shards,
+          output_prefix, output_shards, num_threads);
+      LOG(INFO) << "Converting done. " << nrow << " example(s) converted.";
+      return;
+    }
+  }
+
   // Create the reader.
   auto reader = dataset::CreateExampleReader(absl::GetFlag(FLAGS_input),
                                              data_spec, required_columns)
@@ -102,15 +207,7 @@ void ConvertDataset() {
                                    absl::GetFlag(FLAGS_shard_size))
           .value();
 
-  dataset::proto::Example example;
-  int64_t nrow = 0;
-  utils::StatusOr<bool> status;
-  while ((status = reader->Next(&example)).ok() && status.value()) {
-    LOG_INFO_EVERY_N_SEC(30, _ << nrow << " examples converted.");
-    QCHECK_OK(writer->Write(example));
-    nrow++;
-  }
-
+  const int64_t nrow = ConvertStream(reader.get(), writer.get()).value();
   LOG(INFO) << "Converting done. " << nrow << " example(s) converted.";
 }
 
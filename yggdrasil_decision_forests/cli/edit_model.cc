@@ -40,12 +40,31 @@
 //     the model filenames) with "new_file_prefix". Set "new_file_prefix" to the
 //     empty string (i.e. --new_file_prefix=) to remove the model prefix.
 //
+//   If prune_min_tree_output, prune_merge_identical_subtrees or
+//     prune_collapse_leaf_margin is set:
+//     Shrinks a gradient boosted trees model without retraining (see the
+//     flag documentation). If --evaluation_dataset is also set, reports the
+//     model evaluation before and after the pruning.
+//
+//   If reorder_trees_by_decisiveness is set:
+//     Reorders the trees of a classification random forest from most to least
+//     decisive, to the benefit of the early-exit serving engines. Does not
+//     change the model predictions.
+//
 #include "absl/flags/flag.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/weight.h"
+#include "yggdrasil_decision_forests/metric/metric.pb.h"
+#include "yggdrasil_decision_forests/metric/report.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/decision_tree/pruning.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/random.h"
 
 // Default string flag values. Used to detect if a flag is set by the user for
 // flag where the empty value is possible.
@@ -63,6 +82,29 @@ ABSL_FLAG(std::string, pure_serving, kStringNoSet,
           "serving.This includes debugging, model interpretation and other "
           "meta-data. Can reduce significantly the size of the model.");
 
+ABSL_FLAG(double, prune_min_tree_output, -1,
+          "If >=0, removes the boosting iterations of a gradient boosted "
+          "trees model whose tree leaf values are all in "
+          "[-prune_min_tree_output, prune_min_tree_output] i.e. the "
+          "iterations with a small contribution to the predictions.");
+ABSL_FLAG(bool, prune_merge_identical_subtrees, false,
+          "If true, removes the conditions whose two branches are "
+          "structurally identical. Does not change the model predictions.");
+ABSL_FLAG(double, prune_collapse_leaf_margin, -1,
+          "If >=0, replaces the sub-trees whose leaf values are all within "
+          "\"prune_collapse_leaf_margin\" of each other by a single leaf. "
+          "Only for models with regression leaves e.g. gradient boosted "
+          "trees.");
+ABSL_FLAG(bool, reorder_trees_by_decisiveness, false,
+          "If true, reorders the trees of a classification random forest "
+          "model from most to least decisive so that the early-exit serving "
+          "engines settle the vote with fewer trees. Does not change the "
+          "model predictions.");
+ABSL_FLAG(std::string, evaluation_dataset, kStringNoSet,
+          "Typed path to a validation dataset i.e. [type]:[path] format. If "
+          "set with one of the pruning flags, reports the model evaluation "
+          "before and after the pruning.");
+
 constexpr char kUsageMessage[] = "Edits a trained model.";
 
 namespace yggdrasil_decision_forests {
@@ -110,6 +152,96 @@ void EditModel() {
     QCHECK_OK(model->MakePureServing());
   }
 
+  // Pruning.
+  const double prune_min_tree_output =
+      absl::GetFlag(FLAGS_prune_min_tree_output);
+  const bool prune_merge_identical_subtrees =
+      absl::GetFlag(FLAGS_prune_merge_identical_subtrees);
+  const double prune_collapse_leaf_margin =
+      absl::GetFlag(FLAGS_prune_collapse_leaf_margin);
+  if (prune_min_tree_output >= 0 || prune_merge_identical_subtrees ||
+      prune_collapse_leaf_margin >= 0) {
+    auto* gbt_model =
+        dynamic_cast<model::gradient_boosted_trees::GradientBoostedTreesModel*>(
+            model.get());
+    QCHECK(gbt_model != nullptr)
+        << "The pruning operations only support gradient boosted trees "
+           "models.";
+    auto* trees = gbt_model->mutable_decision_trees();
+
+    // Evaluates the model on --evaluation_dataset.
+    const auto evaluate = [&model]() {
+      metric::proto::EvaluationOptions options;
+      options.set_task(model->task());
+      if (model->weights().has_value()) {
+        *options.mutable_weights() =
+            dataset::GetUnlinkedWeightDefinition(model->weights().value(),
+                                                 model->data_spec())
+                .value();
+      }
+      utils::RandomEngine rnd;
+      return model->Evaluate(absl::GetFlag(FLAGS_evaluation_dataset), options,
+                             &rnd);
+    };
+
+    const bool report_evaluation =
+        absl::GetFlag(FLAGS_evaluation_dataset) != kStringNoSet;
+    std::string evaluation_report_before;
+    if (report_evaluation) {
+      QCHECK_OK(metric::AppendTextReportWithStatus(evaluate(),
+                                                   &evaluation_report_before));
+    }
+    const auto num_nodes_before = model::decision_tree::NumberOfNodes(*trees);
+    const auto num_trees_before = trees->size();
+
+    if (prune_min_tree_output >= 0) {
+      const int64_t num_removed_trees =
+          model::decision_tree::RemoveSmallOutputTreeGroups(
+              trees, gbt_model->num_trees_per_iter(), prune_min_tree_output)
+              .value();
+      LOG(INFO) << "Removed " << num_removed_trees
+                << " tree(s) with an output below " << prune_min_tree_output;
+    }
+    if (prune_merge_identical_subtrees) {
+      const int64_t num_removed_nodes =
+          model::decision_tree::MergeIdenticalSubtrees(trees);
+      LOG(INFO) << "Removed " << num_removed_nodes
+                << " node(s) by merging identical sub-trees";
+    }
+    if (prune_collapse_leaf_margin >= 0) {
+      const int64_t num_removed_nodes =
+          model::decision_tree::CollapseNearEqualRegressionLeaves(
+              trees, prune_collapse_leaf_margin)
+              .value();
+      LOG(INFO) << "Removed " << num_removed_nodes
+                << " node(s) by collapsing near-equal leaves";
+    }
+
+    LOG(INFO) << "Pruning: " << num_trees_before << " -> " << trees->size()
+              << " tree(s), " << num_nodes_before << " -> "
+              << model::decision_tree::NumberOfNodes(*trees) << " node(s)";
+
+    if (report_evaluation) {
+      std::string evaluation_report_after;
+      QCHECK_OK(metric::AppendTextReportWithStatus(evaluate(),
+                                                   &evaluation_report_after));
+      LOG(INFO) << "Evaluation before pruning:\n" << evaluation_report_before;
+      LOG(INFO) << "Evaluation after pruning:\n" << evaluation_report_after;
+    }
+  }
+
+  // Tree reordering.
+  if (absl::GetFlag(FLAGS_reorder_trees_by_decisiveness)) {
+    auto* rf_model =
+        dynamic_cast<model::random_forest::RandomForestModel*>(model.get());
+    QCHECK(rf_model != nullptr)
+        << "--reorder_trees_by_decisiveness only supports random forest "
+           "models.";
+    QCHECK_OK(rf_model->ReorderTreesByDecisiveness());
+    LOG(INFO) << "Reordered " << rf_model->NumTrees()
+              << " tree(s) by decisiveness";
+  }
+
   // Change how the model is exported.
   model::ModelIOOptions output_options;
   if (absl::GetFlag(FLAGS_new_file_prefix) != kStringNoSet) {
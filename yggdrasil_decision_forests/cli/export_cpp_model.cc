@@ -0,0 +1,252 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Generates ahead-of-time C++ inference code for a decision forest model.
+//
+// The generated source contains one function per tree with all the thresholds
+// and feature indices baked in as constants, and a "Predict" function summing
+// the trees and applying the activation function of the model (if any). Since
+// the model structure is known at compile time, the C++ compiler can unroll,
+// re-order and vectorize the tree traversals, and there is no node-fetch
+// dependent load at all.
+//
+// The generated function expects the input features packed in a float array,
+// in the order listed in the generated header comment (the model's input
+// features, by increasing dataspec column index). Categorical and boolean
+// feature values are passed as their integer value stored in a float. Missing
+// values must be replaced by the caller (global imputation).
+//
+// Usage example:
+//
+//   bazel run -c opt :export_cpp_model -- \
+//     --model=/path/to/my/model \
+//     --output=/tmp/my_model.h \
+//     --namespace=my_model
+//
+#include "absl/flags/flag.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+
+ABSL_FLAG(std::string, model, "", "Model directory.");
+ABSL_FLAG(std::string, output, "", "Path to the generated C++ source.");
+ABSL_FLAG(std::string, namespace, "ydf_generated_model",
+          "C++ namespace of the generated code.");
+
+constexpr char kUsageMessage[] =
+    "Generates ahead-of-time C++ inference code for a decision forest model.";
+
+namespace yggdrasil_decision_forests {
+namespace cli {
+namespace {
+
+using model::decision_tree::NodeWithChildren;
+using model::decision_tree::proto::Condition;
+
+// Formats a float constant so it round-trips exactly.
+std::string FloatConstant(const float value) {
+  return absl::StrFormat("%.9gf", value);
+}
+
+// Returns the dense index of "column_idx" in "input_features", i.e. the index
+// of the feature in the input array of the generated code.
+utils::StatusOr<int> FeatureIndex(const std::vector<int>& input_features,
+                                  const int column_idx) {
+  const auto it = std::find(input_features.begin(), input_features.end(),
+                            column_idx);
+  if (it == input_features.end()) {
+    return absl::InternalError(
+        absl::StrCat("Unknown input feature ", column_idx));
+  }
+  return static_cast<int>(it - input_features.begin());
+}
+
+// Appends the C++ expression of the condition of "node".
+absl::Status AppendCondition(const std::vector<int>& input_features,
+                             const NodeWithChildren& node, std::string* code) {
+  const auto& condition = node.node().condition();
+  ASSIGN_OR_RETURN(const int feature_idx,
+                   FeatureIndex(input_features, condition.attribute()));
+  switch (condition.condition().type_case()) {
+    case Condition::TypeCase::kHigherCondition:
+      absl::StrAppend(
+          code, "features[", feature_idx, "] >= ",
+          FloatConstant(condition.condition().higher_condition().threshold()));
+      return absl::OkStatus();
+
+    case Condition::TypeCase::kTrueValueCondition:
+      absl::StrAppend(code, "features[", feature_idx, "] >= 0.5f");
+      return absl::OkStatus();
+
+    case Condition::TypeCase::kContainsCondition: {
+      // "feature \in {a, b, ...}" emitted as a disjunction of equalities.
+      const auto& elements =
+          condition.condition().contains_condition().elements();
+      std::vector<std::string> terms;
+      terms.reserve(elements.size());
+      for (const auto element : elements) {
+        terms.push_back(absl::StrCat("static_cast<int>(features[", feature_idx,
+                                     "]) == ", element));
+      }
+      absl::StrAppend(code, "(", absl::StrJoin(terms, " || "), ")");
+      return absl::OkStatus();
+    }
+
+    default:
+      return absl::InvalidArgumentError(
+          "The code generator only supports numerical \"is higher\", boolean "
+          "and categorical \"contains\" conditions. Unsupported condition "
+          "type in the model.");
+  }
+}
+
+// Appends the body of a tree as nested conditional expressions.
+absl::Status AppendNode(const std::vector<int>& input_features,
+                        const NodeWithChildren& node, const float leaf_scale,
+                        const int depth, std::string* code) {
+  const std::string indent(2 * (depth + 1), ' ');
+  if (node.IsLeaf()) {
+    float value;
+    if (node.node().has_regressor()) {
+      value = node.node().regressor().top_value();
+    } else {
+      return absl::InvalidArgumentError(
+          "The code generator only supports trees with regressive leaves.");
+    }
+    absl::StrAppend(code, indent, "return ", FloatConstant(value * leaf_scale),
+                    ";\n");
+    return absl::OkStatus();
+  }
+  absl::StrAppend(code, indent, "if (");
+  RETURN_IF_ERROR(AppendCondition(input_features, node, code));
+  absl::StrAppend(code, ") {\n");
+  RETURN_IF_ERROR(AppendNode(input_features, *node.pos_child(), leaf_scale,
+                             depth + 1, code));
+  absl::StrAppend(code, indent, "} else {\n");
+  RETURN_IF_ERROR(AppendNode(input_features, *node.neg_child(), leaf_scale,
+                             depth + 1, code));
+  absl::StrAppend(code, indent, "}\n");
+  return absl::OkStatus();
+}
+
+absl::Status ExportModel(const std::string& model_path,
+                         const std::string& output_path,
+                         const std::string& name_space) {
+  std::unique_ptr<model::AbstractModel> model;
+  RETURN_IF_ERROR(model::LoadModel(model_path, &model));
+
+  if (!model->IsMissingValueConditionResultFollowGlobalImputation()) {
+    return absl::InvalidArgumentError(
+        "The code generator only supports models trained with "
+        "missing_value_policy=GLOBAL_IMPUTATION.");
+  }
+
+  // Extract the trees, the bias and the activation function.
+  const std::vector<std::unique_ptr<model::decision_tree::DecisionTree>>*
+      trees = nullptr;
+  float initial_prediction = 0.f;
+  float leaf_scale = 1.f;
+  std::string activation = "value";
+
+  auto* gbt_model =
+      dynamic_cast<model::gradient_boosted_trees::GradientBoostedTreesModel*>(
+          model.get());
+  auto* rf_model =
+      dynamic_cast<model::random_forest::RandomForestModel*>(model.get());
+  if (gbt_model != nullptr) {
+    if (gbt_model->initial_predictions().size() != 1) {
+      return absl::InvalidArgumentError(
+          "The code generator only supports single-output GBT models.");
+    }
+    trees = &gbt_model->decision_trees();
+    initial_prediction = gbt_model->initial_predictions()[0];
+    if (gbt_model->loss() == model::gradient_boosted_trees::proto::Loss::
+                                 BINOMIAL_LOG_LIKELIHOOD &&
+        !gbt_model->output_logits()) {
+      activation = "1.f / (1.f + std::exp(-value))";
+    }
+  } else if (rf_model != nullptr) {
+    if (rf_model->task() != model::proto::Task::REGRESSION) {
+      return absl::InvalidArgumentError(
+          "The code generator only supports regression Random Forest "
+          "models.");
+    }
+    trees = &rf_model->decision_trees();
+    leaf_scale = 1.f / rf_model->NumTrees();
+  } else {
+    return absl::InvalidArgumentError(
+        "The code generator only supports GBT and Random Forest models.");
+  }
+
+  const auto& input_features = model->input_features();
+
+  std::string code;
+  absl::StrAppend(&code,
+                  "// Generated by :export_cpp_model. Do not edit.\n"
+                  "// Model: ",
+                  model_path, "\n//\n// Input features (in order):\n");
+  for (int dense_idx = 0; dense_idx < input_features.size(); ++dense_idx) {
+    const auto& column = model->data_spec().columns(input_features[dense_idx]);
+    absl::StrAppend(&code, "//   features[", dense_idx, "]: ", column.name(),
+                    " [", dataset::proto::ColumnType_Name(column.type()),
+                    "]\n");
+  }
+  absl::StrAppend(&code,
+                  "#ifndef YDF_GENERATED_MODEL_", name_space,
+                  "_H_\n#define YDF_GENERATED_MODEL_", name_space,
+                  "_H_\n\n#include <cmath>\n\nnamespace ", name_space,
+                  " {\n\n");
+
+  for (int tree_idx = 0; tree_idx < trees->size(); ++tree_idx) {
+    absl::StrAppend(&code, "inline float PredictTree", tree_idx,
+                    "(const float* features) {\n");
+    RETURN_IF_ERROR(AppendNode(input_features, (*trees)[tree_idx]->root(),
+                               leaf_scale, /*depth=*/0, &code));
+    absl::StrAppend(&code, "}\n\n");
+  }
+
+  absl::StrAppend(&code, "inline float Predict(const float* features) {\n",
+                  "  float value = ", FloatConstant(initial_prediction),
+                  ";\n");
+  for (int tree_idx = 0; tree_idx < trees->size(); ++tree_idx) {
+    absl::StrAppend(&code, "  value += PredictTree", tree_idx,
+                    "(features);\n");
+  }
+  absl::StrAppend(&code, "  return ", activation, ";\n}\n\n}  // namespace ",
+                  name_space, "\n\n#endif\n");
+
+  return file::SetContent(output_path, code);
+}
+
+}  // namespace
+}  // namespace cli
+}  // namespace yggdrasil_decision_forests
+
+int main(int argc, char** argv) {
+  InitLogging(kUsageMessage, &argc, &argv, true);
+  QCHECK(!absl::GetFlag(FLAGS_model).empty());
+  QCHECK(!absl::GetFlag(FLAGS_output).empty());
+  QCHECK_OK(yggdrasil_decision_forests::cli::ExportModel(
+      absl::GetFlag(FLAGS_model), absl::GetFlag(FLAGS_output),
+      absl::GetFlag(FLAGS_namespace)));
+  return 0;
+}
@@ -33,19 +33,33 @@
 //    --dataset=csv:/path/to/dataset@10 \
 //    --output=csv:/path/to/predictions.csv
 //
+// By default, the dataset is fully loaded in memory before being predicted.
+// With --streaming, the dataset is instead read, predicted and exported by
+// batches: the memory usage is then independent of the dataset size.
+//
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "absl/flags/flag.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/example_reader.h"
+#include "yggdrasil_decision_forests/dataset/example_writer.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
 #include "yggdrasil_decision_forests/model/prediction.pb.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/evaluation.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
 
 ABSL_FLAG(std::string, model, "", "Model directory.");
 
@@ -64,12 +78,168 @@ ABSL_FLAG(std::string, key, "",
           "If set, copies the column \"key\" in the output prediction file. "
           "This key column cannot be an input feature of the model.");
 
+ABSL_FLAG(bool, streaming, false,
+          "If true, the dataset is read, predicted and exported by batches "
+          "instead of being fully loaded in memory. The memory usage is then "
+          "independent of the dataset size. Requires a model compatible with "
+          "a fast inference engine.");
+
+ABSL_FLAG(int, batch_size, 1000,
+          "Number of examples per batch in streaming mode (--streaming).");
+
 constexpr char kUsageMessage[] =
     "Apply a model on a dataset and export the predictions to disk.";
 
 namespace yggdrasil_decision_forests {
 namespace cli {
 
+// Applies the model by batches over a stream of examples, and writes the
+// predictions as they are computed. Unlike the in-memory path below, the
+// memory usage is bounded by the batch size, regardless of the dataset size.
+//
+// The batches are predicted in a single-worker StreamProcessor while the
+// calling thread reads the next batch and writes the previous results
+// (double buffering): at most two batches are in flight at any time.
+absl::Status PredictStreaming(const model::AbstractModel& model,
+                              const dataset::proto::DataSpecification& data_spec,
+                              const std::vector<int>& required_columns,
+                              const absl::optional<int> key_col_idx) {
+  const int batch_size_flag = absl::GetFlag(FLAGS_batch_size);
+  QCHECK_GT(batch_size_flag, 0);
+  const size_t batch_size = batch_size_flag;
+
+  auto engine_or = model.BuildFastEngine();
+  if (!engine_or.ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "--streaming requires a model compatible with a fast inference "
+        "engine: ",
+        engine_or.status().message()));
+  }
+  const auto engine = std::move(engine_or).value();
+  const auto& engine_features = engine->features();
+  const int num_prediction_dimensions = engine->NumPredictionDimension();
+
+  // Input example stream. Only the columns consumed by the model (and the
+  // optional key) are parsed.
+  ASSIGN_OR_RETURN(
+      auto reader,
+      dataset::CreateExampleReader(absl::GetFlag(FLAGS_dataset), data_spec,
+                                   required_columns,
+                                   /*load_columns=*/required_columns));
+
+  // Output prediction stream.
+  const auto& label_column = model.data_spec().columns(model.label_col_idx());
+  absl::optional<std::string> prediction_key;
+  if (key_col_idx.has_value()) {
+    prediction_key = absl::GetFlag(FLAGS_key);
+  }
+  ASSIGN_OR_RETURN(const auto prediction_dataspec,
+                   utils::PredictionDataspec(model.task(), label_column,
+                                             prediction_key));
+  ASSIGN_OR_RETURN(
+      auto writer,
+      dataset::CreateExampleWriter(
+          absl::GetFlag(FLAGS_output), prediction_dataspec,
+          absl::GetFlag(FLAGS_num_records_by_shard_in_output)));
+
+  using Batch = std::vector<dataset::proto::Example>;
+  struct BatchResult {
+    absl::Status status;
+    std::vector<model::proto::Prediction> predictions;
+  };
+
+  utils::concurrency::StreamProcessor<Batch, BatchResult> processor(
+      "prediction", /*num_threads=*/1,
+      [&](Batch batch) -> BatchResult {
+        BatchResult result;
+        auto examples = engine->AllocateExamples(batch.size());
+        examples->FillMissing(engine_features);
+        for (size_t example_idx = 0; example_idx < batch.size();
+             example_idx++) {
+          result.status = examples->FromProtoExample(batch[example_idx],
+                                                     example_idx,
+                                                     engine_features);
+          if (!result.status.ok()) {
+            return result;
+          }
+        }
+        std::vector<float> raw_predictions;
+        engine->Predict(*examples, batch.size(), &raw_predictions);
+        result.predictions.resize(batch.size());
+        for (size_t example_idx = 0; example_idx < batch.size();
+             example_idx++) {
+          auto& prediction = result.predictions[example_idx];
+          model::FloatToProtoPrediction(raw_predictions, example_idx,
+                                        model.task(),
+                                        num_prediction_dimensions, &prediction);
+          if (key_col_idx.has_value()) {
+            prediction.set_example_key(
+                batch[example_idx].attributes(key_col_idx.value()).text());
+          }
+        }
+        return result;
+      },
+      /*result_in_order=*/true);
+  processor.StartWorkers();
+
+  // Write one batch of predictions.
+  int64_t num_predictions = 0;
+  const auto write_result = [&](BatchResult result) -> absl::Status {
+    RETURN_IF_ERROR(result.status);
+    dataset::proto::Example prediction_as_example;
+    for (const auto& prediction : result.predictions) {
+      RETURN_IF_ERROR(utils::PredictionToExample(model.task(), label_column,
+                                                 prediction,
+                                                 &prediction_as_example,
+                                                 prediction_key));
+      RETURN_IF_ERROR(writer->Write(prediction_as_example));
+    }
+    num_predictions += result.predictions.size();
+    LOG_INFO_EVERY_N_SEC(30,
+                         _ << num_predictions << " predictions exported.");
+    return absl::OkStatus();
+  };
+
+  // Number of submitted batches whose results have not been written yet.
+  int num_in_flight = 0;
+  const auto submit_batch = [&](Batch batch) -> absl::Status {
+    if (num_in_flight == 2) {
+      // Backpressure: wait for the oldest batch before reading further.
+      RETURN_IF_ERROR(write_result(std::move(processor.GetResult().value())));
+      num_in_flight--;
+    }
+    processor.Submit(std::move(batch));
+    num_in_flight++;
+    return absl::OkStatus();
+  };
+
+  Batch batch;
+  batch.reserve(batch_size);
+  dataset::proto::Example example;
+  while (true) {
+    ASSIGN_OR_RETURN(const bool has_example, reader->Next(&example));
+    if (!has_example) {
+      break;
+    }
+    batch.push_back(std::move(example));
+    if (batch.size() == batch_size) {
+      RETURN_IF_ERROR(submit_batch(std::move(batch)));
+      batch = Batch();
+      batch.reserve(batch_size);
+    }
+  }
+  if (!batch.empty()) {
+    RETURN_IF_ERROR(submit_batch(std::move(batch)));
+  }
+  processor.CloseSubmits();
+  while (num_in_flight > 0) {
+    RETURN_IF_ERROR(write_result(std::move(processor.GetResult().value())));
+    num_in_flight--;
+  }
+  LOG(INFO) << num_predictions << " predictions exported.";
+  return absl::OkStatus();
+}
+
 void Predict() {
   // Check required flags.
   QCHECK(!absl::GetFlag(FLAGS_dataset).empty());
@@ -114,15 +284,24 @@ void Predict() {
     required_columns.push_back(key_col_idx.value());
   }
 
+  if (absl::GetFlag(FLAGS_streaming)) {
+    QCHECK_OK(
+        PredictStreaming(*model, data_spec, required_columns, key_col_idx));
+    return;
+  }
+
   // Load dataset.
   //
   // The columns corresponding to the model input features are required (i.e.
   // loading the dataset will fail if one of them is missing). The other columns
-  // (e.g. label, weights) are optional.
+  // (e.g. label, weights) are optional and not even parsed.
   dataset::VerticalDataset dataset;
+  dataset::LoadConfig load_config;
+  load_config.load_columns = required_columns;
   QCHECK_OK(LoadVerticalDataset(absl::GetFlag(FLAGS_dataset), data_spec,
                                 &dataset,
-                                /*ensure_non_missing=*/required_columns));
+                                /*ensure_non_missing=*/required_columns,
+                                load_config));
 
   // Compute the predictions.
   std::vector<model::proto::Prediction> predictions;
@@ -47,8 +47,11 @@ CsvExampleReader::Implementation::Implementation(
 
 absl::Status CsvExampleReader::Implementation::OpenShard(
     const absl::string_view path) {
-  ASSIGN_OR_RETURN(auto file_handle, file::OpenInputFile(path));
-  csv_reader_ = absl::make_unique<utils::csv::Reader>(file_handle.get());
+  ASSIGN_OR_RETURN(
+      auto file_handle,
+      file::OpenInputFile(path, file::InputFileHint::kSequentialScan));
+  csv_reader_ =
+      absl::make_unique<utils::csv::ParallelReader>(file_handle.get());
   RETURN_IF_ERROR(file_closer_.reset(std::move(file_handle)));
 
   std::vector<absl::string_view>* new_header;
@@ -61,6 +64,7 @@ absl::Status CsvExampleReader::Implementation::OpenShard(
     csv_header_ = {new_header->begin(), new_header->end()};
     RETURN_IF_ERROR(BuildColIdxToFeatureLabelIdx(
         data_spec_, csv_header_, required_columns_, &col_idx_to_field_idx_));
+    MaskNonLoadedColumns(load_columns_, &col_idx_to_field_idx_);
   } else {
     if (!std::equal(csv_header_.begin(), csv_header_.end(), new_header->begin(),
                     new_header->end())) {
@@ -92,7 +96,7 @@ CsvExampleReader::CsvExampleReader(
 // Does this value looks like to be a numerical value?
 bool LooksLikeANumber(const absl::string_view value) {
   float tmp;
-  return absl::SimpleAtof(value, &tmp);
+  return ParseNumericalValue(value, &tmp);
 }
 
 // Update the dataspec with a new example. This operation is applied once the
@@ -120,7 +124,7 @@ absl::Status UpdateDataSpecWithCsvExample(
     // Mean, min and max of single dimension numerical columns.
     if (IsNumerical(col->type()) && !IsMultiDimensional(col->type())) {
       float num_value;
-      if (!absl::SimpleAtof(value, &num_value)) {
+      if (!ParseNumericalValue(value, &num_value)) {
         return absl::InvalidArgumentError(absl::StrCat(
             "The value \"", value, "\" of attribute \"", col->name(),
             "\" cannot be parsed as a float.  Possible reasons => solution: "
@@ -142,7 +146,7 @@ absl::Status UpdateDataSpecWithCsvExample(
     }
     if (col->type() == proto::ColumnType::DISCRETIZED_NUMERICAL) {
       float num_value;
-      if (!absl::SimpleAtof(value, &num_value)) {
+      if (!ParseNumericalValue(value, &num_value)) {
         return absl::InvalidArgumentError(absl::StrCat(
             "The value \"", value, "\" of attribute \"", col->name(),
             "\" cannot be parsed as a float.  Possible reasons => solution: "
@@ -154,7 +158,7 @@ absl::Status UpdateDataSpecWithCsvExample(
     }
     if (col->type() == proto::ColumnType::BOOLEAN) {
       float num_value;
-      if (!absl::SimpleAtof(value, &num_value)) {
+      if (!ParseNumericalValue(value, &num_value)) {
         return absl::InvalidArgumentError(absl::StrCat(
             "The value \"", value, "\" of attribute \"", col->name(),
             "\" cannot be parsed as a float.  Possible reasons => solution: "
@@ -180,7 +184,8 @@ absl::Status CsvDataSpecCreator::InferColumnsAndTypes(
   for (const auto& path : paths) {
     // Open the csv file.
     auto csv_file = file::OpenInputFile(path).value();
-    yggdrasil_decision_forests::utils::csv::Reader reader(csv_file.get());
+    yggdrasil_decision_forests::utils::csv::ParallelReader reader(
+        csv_file.get());
     file::InputFileCloser closer(std::move(csv_file));
 
     // Read the header.
@@ -268,7 +273,8 @@ absl::Status CsvDataSpecCreator::ComputeColumnStatistics(
 
     // Open the csv file.
     auto csv_file = file::OpenInputFile(path).value();
-    yggdrasil_decision_forests::utils::csv::Reader reader(csv_file.get());
+    yggdrasil_decision_forests::utils::csv::ParallelReader reader(
+        csv_file.get());
     file::InputFileCloser closer(std::move(csv_file));
 
     // Read the header.
@@ -315,7 +321,8 @@ utils::StatusOr<int64_t> CsvDataSpecCreator::CountExamples(
   int64_t count = 0;
 
   ASSIGN_OR_RETURN(auto csv_file, file::OpenInputFile(path));
-  yggdrasil_decision_forests::utils::csv::Reader reader(csv_file.get());
+  yggdrasil_decision_forests::utils::csv::ParallelReader reader(
+      csv_file.get());
   file::InputFileCloser closer(std::move(csv_file));
 
   std::vector<absl::string_view>* row;
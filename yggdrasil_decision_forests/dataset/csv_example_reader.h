@@ -56,12 +56,20 @@ class CsvExampleReader final : public ExampleReaderInterface {
     return sharded_csv_reader_.Open(sharded_path);
   }
 
+  void SetLoadColumns(const std::vector<int>& load_columns) override {
+    sharded_csv_reader_.set_load_columns(load_columns);
+  }
+
  private:
   class Implementation final : public utils::ShardedReader<proto::Example> {
    public:
     explicit Implementation(const proto::DataSpecification& data_spec,
                             absl::optional<std::vector<int>> required_columns);
 
+    void set_load_columns(const std::vector<int>& load_columns) {
+      load_columns_ = load_columns;
+    }
+
    protected:
     // Opens the .csv file at "path", and check that the header is as expected.
     absl::Status OpenShard(absl::string_view path) override;
@@ -74,7 +82,8 @@ class CsvExampleReader final : public ExampleReaderInterface {
     const proto::DataSpecification data_spec_;
 
     // Currently, open file;
-    std::unique_ptr<yggdrasil_decision_forests::utils::csv::Reader> csv_reader_;
+    std::unique_ptr<yggdrasil_decision_forests::utils::csv::ParallelReader>
+        csv_reader_;
     file::InputFileCloser file_closer_;
 
     // Matching between data_spec column indices and csv field indices.
@@ -84,6 +93,10 @@ class CsvExampleReader final : public ExampleReaderInterface {
     std::vector<std::string> csv_header_;
 
     const absl::optional<std::vector<int>> required_columns_;
+
+    // If set, only parse this subset of columns. The other columns are left
+    // unset in the generated examples.
+    absl::optional<std::vector<int>> load_columns_;
   };
 
   Implementation sharded_csv_reader_;
@@ -15,8 +15,12 @@
 
 #include "yggdrasil_decision_forests/dataset/csv_example_writer.h"
 
+#include <stdint.h>
+
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -30,21 +34,63 @@
 #include "yggdrasil_decision_forests/utils/csv.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/sharded_io.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
 namespace dataset {
+namespace {
+
+// Size, in bytes, of the write buffer of the csv writers.
+constexpr int64_t kWriterBufferSize = 1 << 20;  // 1MB
+
+// Number of examples formatted together by one of the worker threads of the
+// parallel writer.
+constexpr int kParallelWriterBlockNumExamples = 4096;
+
+// Number of formatting threads of the parallel writer.
+constexpr int kParallelWriterNumThreads = 8;
+
+// Maximum number of blocks in flight, per formatting thread.
+constexpr int kParallelWriterBlocksPerThread = 2;
+
+// Formats the header row i.e. the column names.
+std::string FormatHeader(const proto::DataSpecification& data_spec) {
+  std::vector<absl::string_view> fields;
+  fields.reserve(data_spec.columns_size());
+  for (const auto& column : data_spec.columns()) {
+    fields.push_back(column.name());
+  }
+  std::string header;
+  yggdrasil_decision_forests::utils::csv::AppendRow(fields, "\n", &header);
+  return header;
+}
+
+}  // namespace
 
 CsvExampleWriter::Implementation::Implementation(
     const proto::DataSpecification& data_spec)
     : data_spec_(data_spec) {}
 
+absl::Status CsvExampleWriter::Implementation::CloseWithStatus() {
+  if (csv_writer) {
+    RETURN_IF_ERROR(csv_writer->Flush());
+  }
+  return file_closer_.Close();
+}
+
 absl::Status CsvExampleWriter::Implementation::OpenShard(
     const absl::string_view path) {
+  if (csv_writer) {
+    // Flush the previous shard before its file is closed.
+    RETURN_IF_ERROR(csv_writer->Flush());
+  }
   ASSIGN_OR_RETURN(auto file_handle, file::OpenOutputFile(path));
   csv_writer =
       absl::make_unique<yggdrasil_decision_forests::utils::csv::Writer>(
-          file_handle.get());
+          file_handle.get(),
+          yggdrasil_decision_forests::utils::csv::NewLine::UNIX,
+          kWriterBufferSize);
   RETURN_IF_ERROR(file_closer_.reset(std::move(file_handle)));
 
   // Header.
@@ -61,8 +107,139 @@ absl::Status CsvExampleWriter::Implementation::WriteInShard(
   return csv_writer->WriteRow({buffer_.begin(), buffer_.end()});
 }
 
+CsvExampleWriter::ParallelImplementation::ParallelImplementation(
+    const proto::DataSpecification& data_spec, std::vector<std::string> paths,
+    const int64_t num_records_by_shard)
+    : data_spec_(data_spec),
+      paths_(std::move(paths)),
+      num_records_by_shard_(num_records_by_shard),
+      header_(FormatHeader(data_spec)),
+      processor_("CsvParallelWriter", kParallelWriterNumThreads,
+                 [this](std::vector<proto::Example> examples) {
+                   return FormatBlock(std::move(examples));
+                 },
+                 /*result_in_order=*/true) {
+  processor_.StartWorkers();
+}
+
+CsvExampleWriter::ParallelImplementation::~ParallelImplementation() {
+  CHECK_OK(CloseWithStatus());
+}
+
+utils::StatusOr<CsvExampleWriter::ParallelImplementation::FormattedBlock>
+CsvExampleWriter::ParallelImplementation::FormatBlock(
+    std::vector<proto::Example> examples) const {
+  FormattedBlock block;
+  block.row_ends.reserve(examples.size());
+  std::vector<std::string> fields;
+  for (const auto& example : examples) {
+    RETURN_IF_ERROR(ExampleToCsvRow(example, data_spec_, &fields));
+    yggdrasil_decision_forests::utils::csv::AppendRow(
+        {fields.begin(), fields.end()}, "\n", &block.characters);
+    block.row_ends.push_back(block.characters.size());
+  }
+  return block;
+}
+
+absl::Status CsvExampleWriter::ParallelImplementation::Write(
+    const proto::Example& example) {
+  pending_examples_.push_back(example);
+  if (static_cast<int>(pending_examples_.size()) >=
+      kParallelWriterBlockNumExamples) {
+    RETURN_IF_ERROR(SubmitPendingExamples());
+    // Bound the number of blocks in memory.
+    if (num_pending_blocks_ >=
+        kParallelWriterBlocksPerThread * kParallelWriterNumThreads) {
+      RETURN_IF_ERROR(WriteOneBlock());
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status
+CsvExampleWriter::ParallelImplementation::SubmitPendingExamples() {
+  if (pending_examples_.empty()) {
+    return absl::OkStatus();
+  }
+  processor_.Submit(std::move(pending_examples_));
+  pending_examples_.clear();
+  num_pending_blocks_++;
+  return absl::OkStatus();
+}
+
+absl::Status CsvExampleWriter::ParallelImplementation::OpenNextShard() {
+  num_records_in_cur_shard_ = 0;
+  if (cur_path_idx_ + 1 >= static_cast<int>(paths_.size())) {
+    LOG(INFO)
+        << "Not enough shards allocated. Continue to write in the last shard.";
+    return absl::OkStatus();
+  }
+  cur_path_idx_++;
+  ASSIGN_OR_RETURN(auto file_handle,
+                   file::OpenOutputFile(paths_[cur_path_idx_]));
+  RETURN_IF_ERROR(file_closer_.reset(std::move(file_handle)));
+  return file_closer_.stream()->Write(header_);
+}
+
+absl::Status CsvExampleWriter::ParallelImplementation::WriteOneBlock() {
+  auto result = processor_.GetResult();
+  if (!result.has_value()) {
+    return absl::InternalError("Missing formatted csv block");
+  }
+  num_pending_blocks_--;
+  ASSIGN_OR_RETURN(const FormattedBlock block, std::move(result.value()));
+  size_t begin_row = 0;
+  while (begin_row < block.row_ends.size()) {
+    if (cur_path_idx_ == -1 ||
+        num_records_in_cur_shard_ >= num_records_by_shard_) {
+      RETURN_IF_ERROR(OpenNextShard());
+    }
+    // Rows that fit in the current shard.
+    const size_t num_rows =
+        std::min<int64_t>(num_records_by_shard_ - num_records_in_cur_shard_,
+                          block.row_ends.size() - begin_row);
+    const size_t begin_char =
+        (begin_row == 0) ? 0 : block.row_ends[begin_row - 1];
+    const size_t end_char = block.row_ends[begin_row + num_rows - 1];
+    RETURN_IF_ERROR(file_closer_.stream()->Write(
+        absl::string_view(block.characters)
+            .substr(begin_char, end_char - begin_char)));
+    num_records_in_cur_shard_ += num_rows;
+    begin_row += num_rows;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CsvExampleWriter::ParallelImplementation::CloseWithStatus() {
+  if (closed_) {
+    return absl::OkStatus();
+  }
+  closed_ = true;
+  RETURN_IF_ERROR(SubmitPendingExamples());
+  while (num_pending_blocks_ > 0) {
+    RETURN_IF_ERROR(WriteOneBlock());
+  }
+  if (cur_path_idx_ == -1) {
+    // No example was written. Create the first shard with only the header.
+    RETURN_IF_ERROR(OpenNextShard());
+  }
+  return file_closer_.Close();
+}
+
 CsvExampleWriter::CsvExampleWriter(const proto::DataSpecification& data_spec)
-    : sharded_csv_writer_(data_spec) {}
+    : data_spec_(data_spec), sharded_csv_writer_(data_spec) {}
+
+absl::Status CsvExampleWriter::Open(const absl::string_view sharded_path,
+                                    const int64_t num_records_by_shard) {
+  std::vector<std::string> paths;
+  RETURN_IF_ERROR(utils::ExpandOutputShards(sharded_path, &paths));
+  if (paths.size() > 1 && num_records_by_shard > 0) {
+    parallel_writer_ = absl::make_unique<ParallelImplementation>(
+        data_spec_, std::move(paths), num_records_by_shard);
+    return absl::OkStatus();
+  }
+  return sharded_csv_writer_.Open(sharded_path, num_records_by_shard);
+}
 
 }  // namespace dataset
 }  // namespace yggdrasil_decision_forests
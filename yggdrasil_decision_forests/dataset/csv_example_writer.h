@@ -27,6 +27,8 @@
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
 #include "yggdrasil_decision_forests/dataset/example_writer_interface.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/csv.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
@@ -40,20 +42,23 @@ class CsvExampleWriter final : public ExampleWriterInterface {
   explicit CsvExampleWriter(const proto::DataSpecification& data_spec);
 
   absl::Status Write(const proto::Example& example) override {
+    if (parallel_writer_) {
+      return parallel_writer_->Write(example);
+    }
     return sharded_csv_writer_.Write(example);
   }
 
+  // Opens the output. Multi-shard paths with a record quota are written with
+  // "ParallelImplementation", the other paths with "Implementation".
   absl::Status Open(absl::string_view sharded_path,
-                    const int64_t num_records_by_shard) override {
-    return sharded_csv_writer_.Open(sharded_path, num_records_by_shard);
-  }
+                    const int64_t num_records_by_shard) override;
 
  private:
   class Implementation final : public utils::ShardedWriter<proto::Example> {
    public:
     explicit Implementation(const proto::DataSpecification& data_spec);
 
-    absl::Status CloseWithStatus() { return file_closer_.Close(); }
+    absl::Status CloseWithStatus();
 
    protected:
     absl::Status OpenShard(absl::string_view path) final;
@@ -63,14 +68,102 @@ class CsvExampleWriter final : public ExampleWriterInterface {
     // The data spec.
     const proto::DataSpecification data_spec_;
 
-    // Currently open file;
-    std::unique_ptr<yggdrasil_decision_forests::utils::csv::Writer> csv_writer;
+    // Currently open file. Declared before "csv_writer" so the writer is
+    // destructed (and flushed) before the file is closed.
     file::OutputFileCloser file_closer_;
+    std::unique_ptr<yggdrasil_decision_forests::utils::csv::Writer> csv_writer;
 
     std::vector<std::string> buffer_;
   };
 
+  // Multi-threaded writer for multi-shard csv paths. The examples are
+  // accumulated in blocks, the blocks are formatted into csv text by a small
+  // pool of threads, and the formatted text is written to the shard files, in
+  // order, by the calling thread. Produces the same files as "Implementation".
+  class ParallelImplementation {
+   public:
+    ParallelImplementation(const proto::DataSpecification& data_spec,
+                           std::vector<std::string> paths,
+                           int64_t num_records_by_shard);
+
+    // The destructor writes the pending examples and closes the last shard,
+    // and CHECKs the status.
+    ~ParallelImplementation();
+
+    absl::Status Write(const proto::Example& example);
+
+    // Writes the pending examples and closes the last shard.
+    absl::Status CloseWithStatus();
+
+   private:
+    // A block of csv rows formatted by one of the worker threads.
+    struct FormattedBlock {
+      // Formatted rows, concatenated (escaping and new lines included).
+      std::string characters;
+
+      // End index, in "characters", of each row.
+      std::vector<size_t> row_ends;
+    };
+
+    // Formats a block of examples. Runs in the worker threads.
+    utils::StatusOr<FormattedBlock> FormatBlock(
+        std::vector<proto::Example> examples) const;
+
+    // Submits the pending examples to the formatting threads.
+    absl::Status SubmitPendingExamples();
+
+    // Retrieves the oldest in-flight block and writes it to the shard files,
+    // rotating the shards like "utils::ShardedWriter".
+    absl::Status WriteOneBlock();
+
+    // Opens the next shard and writes its header row.
+    absl::Status OpenNextShard();
+
+    // The data spec.
+    const proto::DataSpecification data_spec_;
+
+    // Paths of the individual shards.
+    const std::vector<std::string> paths_;
+
+    // Number of records per shard.
+    const int64_t num_records_by_shard_;
+
+    // Formatted header row, written at the beginning of each shard.
+    std::string header_;
+
+    // Index of the shard currently written. -1 indicates that no shard is
+    // open yet.
+    int cur_path_idx_ = -1;
+
+    // Number of records written in the current shard so far.
+    int64_t num_records_in_cur_shard_ = 0;
+
+    // Currently open shard file.
+    file::OutputFileCloser file_closer_;
+
+    // Examples not yet submitted to the formatting threads.
+    std::vector<proto::Example> pending_examples_;
+
+    // Number of submitted blocks whose result was not yet retrieved.
+    int num_pending_blocks_ = 0;
+
+    // True after "CloseWithStatus" was called.
+    bool closed_ = false;
+
+    // Formatting threads. Returns the blocks in submission order.
+    utils::concurrency::StreamProcessor<std::vector<proto::Example>,
+                                        utils::StatusOr<FormattedBlock>>
+        processor_;
+  };
+
+  // The data spec.
+  const proto::DataSpecification data_spec_;
+
   Implementation sharded_csv_writer_;
+
+  // Set by "Open" for multi-shard paths with a record quota. If set, "Write"
+  // calls are routed to it instead of "sharded_csv_writer_".
+  std::unique_ptr<ParallelImplementation> parallel_writer_;
 };
 
 REGISTER_ExampleWriterInterface(CsvExampleWriter, "FORMAT_CSV");
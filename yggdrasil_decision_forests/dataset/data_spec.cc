@@ -183,6 +183,22 @@ absl::Status BuildColIdxToFeatureLabelIdx(
   return absl::OkStatus();
 }
 
+void MaskNonLoadedColumns(const absl::optional<std::vector<int>>& load_columns,
+                          std::vector<int>* col_idx_to_field_idx) {
+  if (!load_columns.has_value()) {
+    return;
+  }
+  std::vector<bool> is_loaded(col_idx_to_field_idx->size(), false);
+  for (const int col_idx : load_columns.value()) {
+    is_loaded[col_idx] = true;
+  }
+  for (int col_idx = 0; col_idx < col_idx_to_field_idx->size(); col_idx++) {
+    if (!is_loaded[col_idx]) {
+      (*col_idx_to_field_idx)[col_idx] = -1;
+    }
+  }
+}
+
 void GetMultipleColumnIdxFromName(
     const std::vector<std::string>& column_name_regexs,
     const dataset::proto::DataSpecification& data_spec,
@@ -299,7 +315,7 @@ absl::Status CsvRowToExample(const std::vector<std::string>& csv_fields,
           break;
         }
         float num_value;
-        if (!absl::SimpleAtof(value, &num_value)) {
+        if (!ParseNumericalValue(value, &num_value)) {
           return absl::InvalidArgumentError(
               absl::StrCat("Cannot parse: ", value));
         }
@@ -311,7 +327,7 @@ absl::Status CsvRowToExample(const std::vector<std::string>& csv_fields,
           break;
         }
         float num_value;
-        if (!absl::SimpleAtof(value, &num_value)) {
+        if (!ParseNumericalValue(value, &num_value)) {
           return absl::InvalidArgumentError(
               absl::StrCat("Cannot parse: ", value));
         }
@@ -328,15 +344,7 @@ absl::Status CsvRowToExample(const std::vector<std::string>& csv_fields,
         }
         std::vector<std::string> tokens;
         RETURN_IF_ERROR(Tokenize(value, col_spec.tokenizer(), &tokens));
-        dst->Reserve(tokens.size());
-        for (const std::string& token : tokens) {
-          float num_value;
-          if (!absl::SimpleAtof(token, &num_value)) {
-            return absl::InvalidArgumentError(
-                absl::StrCat("Cannot parse: ", token));
-          }
-          dst->Add(num_value);
-        }
+        RETURN_IF_ERROR(ParseNumericalValues(tokens, dst));
         if (col_spec.type() == ColumnType::NUMERICAL_SET) {
           // Sets are expected to be sorted.
           std::sort(dst->begin(), dst->end());
@@ -378,7 +386,7 @@ absl::Status CsvRowToExample(const std::vector<std::string>& csv_fields,
           break;
         }
         float num_value;
-        if (!absl::SimpleAtof(value, &num_value)) {
+        if (!ParseNumericalValue(value, &num_value)) {
           return absl::InvalidArgumentError(
               absl::StrCat("Cannot parse: ", value));
         }
@@ -398,6 +406,13 @@ absl::Status CsvRowToExample(const std::vector<std::string>& csv_fields,
   return absl::OkStatus();
 }
 
+void HashColumnStrings(const std::vector<absl::string_view>& values,
+                       std::vector<uint64_t>* hashes) {
+  hashes->resize(values.size());
+  utils::hash::HashStringViewsToUint64(values.data(), values.size(),
+                                       hashes->data());
+}
+
 absl::Status ExampleToCsvRow(const proto::Example& example,
                              const proto::DataSpecification& data_spec,
                              std::vector<std::string>* csv_fields) {
@@ -689,6 +704,19 @@ absl::Status Tokenize(const absl::string_view text,
   return absl::OkStatus();
 }
 
+absl::Status ParseNumericalValues(const std::vector<std::string>& values,
+                                  google::protobuf::RepeatedField<float>* dst) {
+  dst->Reserve(dst->size() + values.size());
+  for (const std::string& value : values) {
+    float num_value;
+    if (!ParseNumericalValue(value, &num_value)) {
+      return absl::InvalidArgumentError(absl::StrCat("Cannot parse: ", value));
+    }
+    dst->Add(num_value);
+  }
+  return absl::OkStatus();
+}
+
 void ExtractNGrams(const std::vector<std::string>& tokens, const int n,
                    const absl::string_view separator,
                    std::vector<std::string>* grouped_tokens) {
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
@@ -70,6 +71,13 @@ absl::Status BuildColIdxToFeatureLabelIdx(
     const absl::optional<std::vector<int>>& required_columns,
     std::vector<int>* col_idx_to_field_idx);
 
+// Sets to -1 the field index (in "col_idx_to_field_idx") of the columns not
+// listed in "load_columns" i.e. makes the columns look missing. Used by the
+// example readers to skip the parsing of non-requested columns. No-op if
+// "load_columns" is not set.
+void MaskNonLoadedColumns(const absl::optional<std::vector<int>>& load_columns,
+                          std::vector<int>* col_idx_to_field_idx);
+
 // Returns a sorted list (in increasing order of column idx) of column idxs from
 // a list of regular expressions on the column name.
 void GetMultipleColumnIdxFromName(
@@ -138,6 +146,65 @@ absl::Status Tokenize(const absl::string_view text,
                       const proto::Tokenizer& tokenizer,
                       std::vector<std::string>* tokens);
 
+// Parses the text representation of a numerical attribute value (e.g. a csv
+// cell) into a float. Returns false if "value" cannot be parsed. Bit-equal to
+// "absl::SimpleAtof", but with an inline fast path for the plain decimal
+// numbers that make up almost all dataset cells.
+inline bool ParseNumericalValue(const absl::string_view value,
+                                float* const result) {
+  // Fast path: an optionally signed decimal number without exponent and with
+  // at most 7 digits. The integer mantissa and the power of ten are then both
+  // exactly representable as floats, so the single division below is
+  // correctly rounded i.e. it returns the same bits as the generic parser.
+  const char* cur = value.data();
+  const char* const end = cur + value.size();
+  bool negative = false;
+  if (cur != end && (*cur == '+' || *cur == '-')) {
+    negative = (*cur == '-');
+    ++cur;
+  }
+  int32_t mantissa = 0;
+  int num_digits = 0;
+  int num_frac_digits = 0;
+  bool seen_dot = false;
+  while (cur != end) {
+    const char c = *cur;
+    if (c >= '0' && c <= '9') {
+      if (++num_digits > 7) {
+        break;
+      }
+      mantissa = mantissa * 10 + (c - '0');
+      if (seen_dot) {
+        ++num_frac_digits;
+      }
+    } else if (c == '.' && !seen_dot) {
+      seen_dot = true;
+    } else {
+      break;
+    }
+    ++cur;
+  }
+  if (cur == end && num_digits > 0 && num_digits <= 7 &&
+      (!seen_dot || num_frac_digits > 0)) {
+    static constexpr float kPowersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f,
+                                             1e4f, 1e5f, 1e6f, 1e7f};
+    const float magnitude =
+        static_cast<float>(mantissa) / kPowersOfTen[num_frac_digits];
+    *result = negative ? -magnitude : magnitude;
+    return true;
+  }
+  // Exponents, long mantissas, hexadecimal and "inf" / "nan" values,
+  // surrounding whitespace and malformed values are all delegated to the
+  // generic parser: the accepted language is unchanged.
+  return absl::SimpleAtof(value, result);
+}
+
+// Parses a batch of numerical values (e.g. all the tokens of a numerical set
+// or list attribute) and appends them to "dst". Fails on the first value that
+// cannot be parsed.
+absl::Status ParseNumericalValues(const std::vector<std::string>& values,
+                                  google::protobuf::RepeatedField<float>* dst);
+
 // Extract a ngrams of tokens from a list of token i.e. extracts all the
 // sub-sequences of length "n" from "tokens". Append "separator" in between the
 // items.
@@ -216,6 +283,12 @@ inline uint64_t HashColumnInteger(int64_t value) {
   return utils::hash::HashInt64ToUint64(value);
 }
 
+// Hashes a batch of values of a HASH column. Equivalent to (but faster than)
+// calling "HashColumnString" on each value. "hashes" is resized to
+// "values.size()".
+void HashColumnStrings(const std::vector<absl::string_view>& values,
+                       std::vector<uint64_t>* hashes);
+
 // Name of an unrolled column.
 std::string UnstackedColumnName(absl::string_view original_name, int dim_idx);
 
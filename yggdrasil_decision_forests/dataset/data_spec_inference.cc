@@ -19,6 +19,7 @@
 #include <atomic>
 #include <cmath>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <regex>  // NOLINT
 #include <string>
@@ -38,6 +39,7 @@
 #include "yggdrasil_decision_forests/utils/compatibility.h"
 #include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/quantile_sketch.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
@@ -152,6 +154,62 @@ absl::Status AddTokensToCategoricalColumnSpec(
   return absl::OkStatus();
 }
 
+namespace {
+
+// Number of summary tuples of the quantile sketches used to compute the
+// boundaries of discretized numerical columns.
+constexpr int kDiscretizedQuantileSketchNumEntries = 10000;
+
+utils::QuantileSketch QuantileSketchFromProto(
+    const proto::DataSpecificationAccumulator::Column::QuantileSketch&
+        sketch_proto) {
+  std::vector<utils::QuantileSketch::Entry> entries;
+  entries.reserve(sketch_proto.values_size());
+  for (int entry_idx = 0; entry_idx < sketch_proto.values_size();
+       entry_idx++) {
+    entries.push_back({sketch_proto.values(entry_idx),
+                       sketch_proto.min_ranks(entry_idx),
+                       sketch_proto.max_ranks(entry_idx),
+                       sketch_proto.weights(entry_idx)});
+  }
+  return utils::QuantileSketch::FromEntries(
+      kDiscretizedQuantileSketchNumEntries, std::move(entries));
+}
+
+void QuantileSketchToProto(
+    utils::QuantileSketch* sketch,
+    proto::DataSpecificationAccumulator::Column::QuantileSketch*
+        sketch_proto) {
+  sketch_proto->clear_values();
+  sketch_proto->clear_min_ranks();
+  sketch_proto->clear_max_ranks();
+  sketch_proto->clear_weights();
+  for (const auto& entry : sketch->entries()) {
+    sketch_proto->add_values(entry.value);
+    sketch_proto->add_min_ranks(entry.min_rank);
+    sketch_proto->add_max_ranks(entry.max_rank);
+    sketch_proto->add_weights(entry.weight);
+  }
+}
+
+// Collapses the exact unique value counts of the accumulator into its
+// quantile sketch and empties the exact counts.
+void CollapseDiscretizedNumericalToSketch(
+    proto::DataSpecificationAccumulator::Column* accumulator) {
+  auto* sketch_proto = accumulator->mutable_discretized_numerical_sketch();
+  auto sketch = QuantileSketchFromProto(*sketch_proto);
+  for (const auto& item : accumulator->discretized_numerical()) {
+    sketch.Add(*reinterpret_cast<const float*>(&item.first), item.second);
+  }
+  sketch_proto->set_approximate_num_unique_values(
+      sketch_proto->approximate_num_unique_values() +
+      accumulator->discretized_numerical_size());
+  accumulator->clear_discretized_numerical();
+  QuantileSketchToProto(&sketch, sketch_proto);
+}
+
+}  // namespace
+
 void UpdateComputeSpecDiscretizedNumerical(
     const float value, proto::Column* column,
     proto::DataSpecificationAccumulator::Column* accumulator) {
@@ -159,6 +217,12 @@ void UpdateComputeSpecDiscretizedNumerical(
     // TODO: Use absl::bit_cast.
     const uint32_t int_value = *reinterpret_cast<const uint32_t*>(&value);
     (*accumulator->mutable_discretized_numerical())[int_value]++;
+    const int64_t max_exact_unique_values =
+        column->discretized_numerical().max_exact_unique_values();
+    if (max_exact_unique_values >= 0 &&
+        accumulator->discretized_numerical_size() > max_exact_unique_values) {
+      CollapseDiscretizedNumericalToSketch(accumulator);
+    }
   }
 }
 
@@ -176,12 +240,38 @@ absl::Status FinalizeComputeSpecDiscretizedNumerical(
     const proto::DataSpecificationAccumulator::Column& accumulator,
     proto::Column* column) {
   std::vector<std::pair<float, int>> unique_values_and_counts;
-  unique_values_and_counts.reserve(accumulator.discretized_numerical_size());
-  for (const auto& item : accumulator.discretized_numerical()) {
-    unique_values_and_counts.emplace_back(
-        *reinterpret_cast<const float*>(&item.first), item.second);
+  int64_t original_num_unique_values;
+  if (accumulator.has_discretized_numerical_sketch()) {
+    // Part (or all) of the values were collapsed into the quantile sketch:
+    // the boundaries are computed from the summary tuples of the sketch
+    // (merged with the remaining exact counts) instead of the exact counts.
+    auto sketch =
+        QuantileSketchFromProto(accumulator.discretized_numerical_sketch());
+    for (const auto& item : accumulator.discretized_numerical()) {
+      sketch.Add(*reinterpret_cast<const float*>(&item.first), item.second);
+    }
+    const auto& entries = sketch.entries();
+    unique_values_and_counts.reserve(entries.size());
+    for (const auto& entry : entries) {
+      const double count = std::max(
+          1., std::min<double>(entry.weight,
+                               std::numeric_limits<int>::max()));
+      unique_values_and_counts.emplace_back(entry.value,
+                                            static_cast<int>(count));
+    }
+    original_num_unique_values =
+        accumulator.discretized_numerical_sketch()
+            .approximate_num_unique_values() +
+        accumulator.discretized_numerical_size();
+  } else {
+    unique_values_and_counts.reserve(accumulator.discretized_numerical_size());
+    for (const auto& item : accumulator.discretized_numerical()) {
+      unique_values_and_counts.emplace_back(
+          *reinterpret_cast<const float*>(&item.first), item.second);
+    }
+    std::sort(unique_values_and_counts.begin(), unique_values_and_counts.end());
+    original_num_unique_values = unique_values_and_counts.size();
   }
-  std::sort(unique_values_and_counts.begin(), unique_values_and_counts.end());
 
   ASSIGN_OR_RETURN(const auto bounds,
                    GenDiscretizedBoundaries(
@@ -191,7 +281,7 @@ absl::Status FinalizeComputeSpecDiscretizedNumerical(
                        {0.f, static_cast<float>(column->numerical().mean())}));
 
   column->mutable_discretized_numerical()->set_original_num_unique_values(
-      unique_values_and_counts.size());
+      original_num_unique_values);
 
   *column->mutable_discretized_numerical()->mutable_boundaries() = {
       bounds.begin(), bounds.end()};
@@ -385,10 +475,49 @@ absl::Status CreateDataSpecWithStatus(
   // each column.
   proto::DataSpecificationAccumulator accumulator;
   InitializeDataspecAccumulator(*data_spec, &accumulator);
-  // TODO: Call ComputeColumnStatistics in parallel other the different
-  // paths.
-  RETURN_IF_ERROR(
-      creator->ComputeColumnStatistics(paths, guide, data_spec, &accumulator));
+
+  // The global limit on the number of scanned rows requires a sequential
+  // scan.
+  const int num_threads =
+      std::min<int>(guide.num_accumulate_statistics_threads(), paths.size());
+  if (num_threads > 1 &&
+      guide.max_num_scanned_rows_to_accumulate_statistics() <= 0) {
+    // Each thread accumulates the statistics of a subset of the shards in its
+    // own copy of the dataspec and of the accumulator. The copies are merged
+    // at the end.
+    std::vector<proto::DataSpecification> thread_data_specs(num_threads,
+                                                            *data_spec);
+    std::vector<proto::DataSpecificationAccumulator> thread_accumulators(
+        num_threads, accumulator);
+    std::vector<absl::Status> thread_statuses(num_threads);
+    {
+      yggdrasil_decision_forests::utils::concurrency::ThreadPool pool(
+          "ComputeColumnStatistics", num_threads);
+      pool.StartWorkers();
+      for (int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+        pool.Schedule([&, thread_idx]() {
+          std::vector<std::string> thread_paths;
+          for (size_t path_idx = thread_idx; path_idx < paths.size();
+               path_idx += num_threads) {
+            thread_paths.push_back(paths[path_idx]);
+          }
+          thread_statuses[thread_idx] = creator->ComputeColumnStatistics(
+              thread_paths, guide, &thread_data_specs[thread_idx],
+              &thread_accumulators[thread_idx]);
+        });
+      }
+    }
+    for (int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+      RETURN_IF_ERROR(thread_statuses[thread_idx]);
+      RETURN_IF_ERROR(
+          MergeColumnStatistics(thread_data_specs[thread_idx], data_spec));
+      RETURN_IF_ERROR(MergeDataSpecAccumulators(
+          thread_accumulators[thread_idx], &accumulator));
+    }
+  } else {
+    RETURN_IF_ERROR(creator->ComputeColumnStatistics(paths, guide, data_spec,
+                                                     &accumulator));
+  }
   RETURN_IF_ERROR(FinalizeComputeSpec(guide, accumulator, data_spec));
 
   LOG(INFO) << "Finalizing [" << data_spec->created_num_rows()
@@ -510,6 +639,109 @@ absl::Status FinalizeComputeSpec(
   return absl::OkStatus();
 }
 
+absl::Status MergeDataSpecAccumulators(
+    const proto::DataSpecificationAccumulator& src,
+    proto::DataSpecificationAccumulator* dst) {
+  STATUS_CHECK_EQ(src.columns_size(), dst->columns_size());
+  for (int col_idx = 0; col_idx < src.columns_size(); col_idx++) {
+    const auto& src_col = src.columns(col_idx);
+    auto* dst_col = dst->mutable_columns(col_idx);
+
+    // Kahan sums.
+    AccurateSum kahan_acc(dst_col->kahan_sum(), dst_col->kahan_sum_error());
+    kahan_acc.Add(src_col.kahan_sum());
+    kahan_acc.Add(src_col.kahan_sum_error());
+    dst_col->set_kahan_sum(kahan_acc.Sum());
+    dst_col->set_kahan_sum_error(kahan_acc.ErrorSum());
+
+    AccurateSum kahan_square_acc(dst_col->kahan_sum_of_square(),
+                                 dst_col->kahan_sum_of_square_error());
+    kahan_square_acc.Add(src_col.kahan_sum_of_square());
+    kahan_square_acc.Add(src_col.kahan_sum_of_square_error());
+    dst_col->set_kahan_sum_of_square(kahan_square_acc.Sum());
+    dst_col->set_kahan_sum_of_square_error(kahan_square_acc.ErrorSum());
+
+    // Value range.
+    if (src_col.has_min_value() &&
+        (!dst_col->has_min_value() ||
+         src_col.min_value() < dst_col->min_value())) {
+      dst_col->set_min_value(src_col.min_value());
+    }
+    if (src_col.has_max_value() &&
+        (!dst_col->has_max_value() ||
+         src_col.max_value() > dst_col->max_value())) {
+      dst_col->set_max_value(src_col.max_value());
+    }
+
+    // Exact unique value counts.
+    for (const auto& item : src_col.discretized_numerical()) {
+      (*dst_col->mutable_discretized_numerical())[item.first] += item.second;
+    }
+
+    // Quantile sketches.
+    if (src_col.has_discretized_numerical_sketch()) {
+      auto* dst_sketch = dst_col->mutable_discretized_numerical_sketch();
+      auto sketch = QuantileSketchFromProto(*dst_sketch);
+      sketch.Merge(QuantileSketchFromProto(
+          src_col.discretized_numerical_sketch()));
+      dst_sketch->set_approximate_num_unique_values(
+          dst_sketch->approximate_num_unique_values() +
+          src_col.discretized_numerical_sketch()
+              .approximate_num_unique_values());
+      QuantileSketchToProto(&sketch, dst_sketch);
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MergeColumnStatistics(const proto::DataSpecification& src,
+                                   proto::DataSpecification* dst) {
+  STATUS_CHECK_EQ(src.columns_size(), dst->columns_size());
+  dst->set_created_num_rows(dst->created_num_rows() + src.created_num_rows());
+  for (int col_idx = 0; col_idx < src.columns_size(); col_idx++) {
+    const auto& src_col = src.columns(col_idx);
+    auto* dst_col = dst->mutable_columns(col_idx);
+    dst_col->set_count_nas(dst_col->count_nas() + src_col.count_nas());
+
+    if (src_col.has_categorical()) {
+      auto* dst_cat = dst_col->mutable_categorical();
+      if (src_col.categorical().number_of_unique_values() >
+          dst_cat->number_of_unique_values()) {
+        dst_cat->set_number_of_unique_values(
+            src_col.categorical().number_of_unique_values());
+      }
+      for (const auto& item : src_col.categorical().items()) {
+        auto& dst_item = (*dst_cat->mutable_items())[item.first];
+        dst_item.set_count(dst_item.count() + item.second.count());
+      }
+    }
+
+    if (src_col.has_boolean()) {
+      auto* dst_bool = dst_col->mutable_boolean();
+      dst_bool->set_count_true(dst_bool->count_true() +
+                               src_col.boolean().count_true());
+      dst_bool->set_count_false(dst_bool->count_false() +
+                                src_col.boolean().count_false());
+    }
+
+    if (src_col.has_multi_values()) {
+      auto* dst_multi = dst_col->mutable_multi_values();
+      if (src_col.multi_values().max_observed_size() >
+          dst_multi->max_observed_size()) {
+        dst_multi->set_max_observed_size(
+            src_col.multi_values().max_observed_size());
+      }
+      if (!dst_multi->has_min_observed_size() ||
+          src_col.multi_values().min_observed_size() <
+              dst_multi->min_observed_size()) {
+        dst_multi->set_min_observed_size(
+            src_col.multi_values().min_observed_size());
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
 absl::Status UpdateNumericalColumnSpec(
     const float num_value, proto::Column* col,
     proto::DataSpecificationAccumulator::Column* col_acc) {
@@ -672,6 +904,8 @@ absl::Status UpdateSingleColSpecWithGuideInfo(
         col_guide.discretized_numerical().maximum_num_bins());
     col->mutable_discretized_numerical()->set_min_obs_in_bins(
         col_guide.discretized_numerical().min_obs_in_bins());
+    col->mutable_discretized_numerical()->set_max_exact_unique_values(
+        col_guide.discretized_numerical().max_exact_unique_values());
   }
   return absl::OkStatus();
 }
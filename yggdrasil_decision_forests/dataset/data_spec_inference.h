@@ -87,6 +87,19 @@ absl::Status FinalizeComputeSpec(
     const proto::DataSpecificationAccumulator& accumulator,
     proto::DataSpecification* data_spec);
 
+// Merges the statistics accumulated in "src" into "dst". "src" and "dst"
+// should have been initialized from the same dataspec. Used to combine
+// statistics accumulated over disjoint subsets of the shards of a dataset.
+absl::Status MergeDataSpecAccumulators(
+    const proto::DataSpecificationAccumulator& src,
+    proto::DataSpecificationAccumulator* dst);
+
+// Merges the column statistics (number of rows, missing values, dictionaries,
+// etc.) accumulated in "src" into "dst". Same usage as
+// "MergeDataSpecAccumulators".
+absl::Status MergeColumnStatistics(const proto::DataSpecification& src,
+                                   proto::DataSpecification* dst);
+
 // Finalize the inference of the type of each features. Should be called after
 // "InferColumnsAndTypes" and before "ComputeColumnStatistics".
 void FinalizeInferTypes(const proto::DataSpecificationGuide& guide,
@@ -784,6 +784,77 @@ TEST(Dataset, UnknownType) {
   EXPECT_THAT(data_spec, EqualsProto(target));
 }
 
+TEST(Dataset, DiscretizedNumericalQuantileSketch) {
+  proto::DataSpecification data_spec = PARSE_TEST_PROTO(
+      R"pb(
+        created_num_rows: 10000
+        columns {
+          type: DISCRETIZED_NUMERICAL
+          name: "a"
+          discretized_numerical {
+            maximum_num_bins: 16
+            min_obs_in_bins: 1
+            max_exact_unique_values: 100
+          }
+        }
+      )pb");
+  proto::DataSpecificationAccumulator accumulator;
+  InitializeDataspecAccumulator(data_spec, &accumulator);
+  auto* column = data_spec.mutable_columns(0);
+  auto* column_accumulator = accumulator.mutable_columns(0);
+  for (int value_idx = 0; value_idx < 10000; value_idx++) {
+    const float value = value_idx * 0.001f;
+    EXPECT_OK(UpdateNumericalColumnSpec(value, column, column_accumulator));
+    UpdateComputeSpecDiscretizedNumerical(value, column, column_accumulator);
+  }
+  // The exact unique value counts were collapsed into the sketch.
+  EXPECT_TRUE(column_accumulator->has_discretized_numerical_sketch());
+  EXPECT_LE(column_accumulator->discretized_numerical_size(), 100);
+
+  EXPECT_OK(FinalizeComputeSpec({}, accumulator, &data_spec));
+  const auto& boundaries = column->discretized_numerical().boundaries();
+  EXPECT_GT(boundaries.size(), 8);
+  EXPECT_LT(boundaries.size(), 16);
+  // The values are uniform in [0,10): the boundaries should be roughly
+  // evenly spaced.
+  for (int boundary_idx = 0; boundary_idx < boundaries.size();
+       boundary_idx++) {
+    EXPECT_NEAR(boundaries.Get(boundary_idx),
+                10.f * (boundary_idx + 1) / (boundaries.size() + 1), 1.f);
+  }
+}
+
+TEST(Dataset, CreateDataSpecParallelShards) {
+  // Three csv shards with numerical, categorical and boolean columns.
+  std::vector<std::string> paths;
+  for (int shard_idx = 0; shard_idx < 3; shard_idx++) {
+    const auto path = file::JoinPath(
+        test::TmpDirectory(), absl::StrCat("shard_", shard_idx, ".csv"));
+    std::string content = "a,b,c\n";
+    for (int row_idx = 0; row_idx < 10; row_idx++) {
+      absl::StrAppend(&content, row_idx + shard_idx * 10, ",",
+                      (row_idx % 2 == 0) ? "x" : "y", ",", row_idx % 2, "\n");
+    }
+    CHECK_OK(file::SetContent(path, content));
+    paths.push_back(path);
+  }
+  const auto typed_path =
+      absl::StrCat("csv:", paths[0], ",", paths[1], ",", paths[2]);
+
+  proto::DataSpecificationGuide guide;
+  guide.set_num_accumulate_statistics_threads(1);
+  proto::DataSpecification sequential_data_spec;
+  EXPECT_OK(CreateDataSpecWithStatus(typed_path, false, guide,
+                                     &sequential_data_spec));
+  EXPECT_EQ(sequential_data_spec.created_num_rows(), 30);
+
+  guide.set_num_accumulate_statistics_threads(4);
+  proto::DataSpecification parallel_data_spec;
+  EXPECT_OK(
+      CreateDataSpecWithStatus(typed_path, false, guide, &parallel_data_spec));
+  EXPECT_THAT(parallel_data_spec, EqualsProto(sequential_data_spec));
+}
+
 }  // namespace
 }  // namespace dataset
 }  // namespace yggdrasil_decision_forests
@@ -16,6 +16,7 @@
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <utility>
@@ -25,6 +26,7 @@
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
@@ -330,6 +332,50 @@ TEST(Dataset, Tokenizer) {
                                               " wo", "wor", "orl", "rld"}));
 }
 
+TEST(Dataset, ParseNumericalValue) {
+  float value;
+  // Fast path values: bit-equal to the generic parser.
+  for (const auto& text :
+       {"0", "1", "-1", "+2", "3.14159", "-0.5", ".5", "0.0000001", "9999999",
+        "123.4567"}) {
+    ASSERT_TRUE(ParseNumericalValue(text, &value)) << text;
+    float expected_value;
+    ASSERT_TRUE(absl::SimpleAtof(text, &expected_value)) << text;
+    EXPECT_EQ(value, expected_value) << text;
+  }
+  // Values outside of the fast path.
+  for (const auto& text : {"1e3", "-1.5E-2", "123456789", "inf", "nan"}) {
+    ASSERT_TRUE(ParseNumericalValue(text, &value)) << text;
+    float expected_value;
+    ASSERT_TRUE(absl::SimpleAtof(text, &expected_value)) << text;
+    EXPECT_EQ(std::isnan(value), std::isnan(expected_value)) << text;
+    if (!std::isnan(value)) {
+      EXPECT_EQ(value, expected_value) << text;
+    }
+  }
+  // Non numerical values.
+  for (const auto& text : {"", "-", ".", "1.2.3", "hello", "1,5"}) {
+    EXPECT_FALSE(ParseNumericalValue(text, &value)) << text;
+  }
+
+  google::protobuf::RepeatedField<float> values;
+  CHECK_OK(ParseNumericalValues({"1", "2.5", "-3"}, &values));
+  EXPECT_THAT(values, ElementsAre(1.f, 2.5f, -3.f));
+  EXPECT_FALSE(ParseNumericalValues({"1", "hello"}, &values).ok());
+}
+
+TEST(Dataset, HashColumnStrings) {
+  // More than four values, to exercise both the unrolled loop and the tail.
+  const std::vector<absl::string_view> values = {
+      "", "a", "hello", "world", "a longer string value", "a", "b"};
+  std::vector<uint64_t> hashes;
+  HashColumnStrings(values, &hashes);
+  ASSERT_EQ(hashes.size(), values.size());
+  for (size_t idx = 0; idx < values.size(); idx++) {
+    EXPECT_EQ(hashes[idx], HashColumnString(values[idx])) << values[idx];
+  }
+}
+
 TEST(DataSpecUtil, CategoricalIdxsToRepresentation) {
   const std::vector<int> elements{1, 2, 3};
   proto::Column col_spec = PARSE_TEST_PROTO(
@@ -555,6 +601,15 @@ TEST(Dataset, BuildColIdxToFeatureLabelIdx) {
   EXPECT_THAT(map, ElementsAre(0, -1));
 }
 
+TEST(Dataset, MaskNonLoadedColumns) {
+  std::vector<int> map = {0, 1, 2};
+  MaskNonLoadedColumns({}, &map);
+  EXPECT_THAT(map, ElementsAre(0, 1, 2));
+
+  MaskNonLoadedColumns(std::vector<int>{1}, &map);
+  EXPECT_THAT(map, ElementsAre(-1, 1, -1));
+}
+
 }  // namespace
 }  // namespace dataset
 }  // namespace yggdrasil_decision_forests
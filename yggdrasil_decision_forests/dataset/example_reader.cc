@@ -39,7 +39,8 @@ namespace dataset {
 utils::StatusOr<std::unique_ptr<ExampleReaderInterface>> CreateExampleReader(
     const absl::string_view typed_path,
     const proto::DataSpecification& data_spec,
-    const absl::optional<std::vector<int>> required_columns) {
+    const absl::optional<std::vector<int>> required_columns,
+    const absl::optional<std::vector<int>>& load_columns) {
   std::string sharded_path;
   proto::DatasetFormat format;
   std::tie(sharded_path, format) = GetDatasetPathAndType(typed_path);
@@ -51,6 +52,9 @@ utils::StatusOr<std::unique_ptr<ExampleReaderInterface>> CreateExampleReader(
                    _ << "When creating an example reader to read "
                      << sharded_path
                      << ". Make sure the format dependency is linked");
+  if (load_columns.has_value()) {
+    reader->SetLoadColumns(load_columns.value());
+  }
   RETURN_IF_ERROR(reader->Open(sharded_path));
   return std::move(reader);
 }
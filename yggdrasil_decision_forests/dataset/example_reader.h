@@ -61,9 +61,15 @@ namespace dataset {
 // "required_columns" is not present, all its value will be assumed to be
 // "missing".
 //
+// If "load_columns" is provided, only this subset of columns is extracted:
+// the other columns are left unset (i.e. treated as missing) in the returned
+// examples, and readers supporting column projection skip their parsing
+// entirely.
+//
 utils::StatusOr<std::unique_ptr<ExampleReaderInterface>> CreateExampleReader(
     absl::string_view typed_path, const proto::DataSpecification& data_spec,
-    absl::optional<std::vector<int>> required_columns = {});
+    absl::optional<std::vector<int>> required_columns = {},
+    const absl::optional<std::vector<int>>& load_columns = {});
 
 // Checks if the format of a typed dataset is supported i.e. a dataset reader is
 // registered for this format. Returns true, if the format is supported. Returns
@@ -40,6 +40,14 @@ class ExampleReaderInterface {
   // Tries to retrieve the next available example. If no more examples are
   // available, returns false.
   virtual utils::StatusOr<bool> Next(proto::Example* example) = 0;
+
+  // Restricts the reader to only extract this subset of columns (dataspec
+  // column indices). The other columns are left unset (i.e. treated as
+  // missing) in the generated examples. Should be called before "Open".
+  //
+  // This is an optimization hint: readers without support for column
+  // projection keep extracting all the columns.
+  virtual void SetLoadColumns(const std::vector<int>& load_columns) {}
 };
 
 REGISTRATION_CREATE_POOL(ExampleReaderInterface,
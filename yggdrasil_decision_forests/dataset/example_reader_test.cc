@@ -84,6 +84,36 @@ TEST(ExampleReader, CreateExampleReader) {
   }
 }
 
+TEST(ExampleReader, CreateExampleReaderWithLoadColumns) {
+  for (const auto& dataset_path :
+       {absl::StrCat("tfrecord+tfe:",
+                     file::JoinPath(DatasetDir(), "toy.tfe-tfrecord@2")),
+        absl::StrCat("csv:", file::JoinPath(DatasetDir(), "toy.csv"))}) {
+    proto::DataSpecificationGuide guide;
+    proto::DataSpecification data_spec;
+    CreateDataSpec(dataset_path, false, guide, &data_spec);
+    const int num_1_idx = GetColumnIdxFromName("Num_1", data_spec);
+    const int num_2_idx = GetColumnIdxFromName("Num_2", data_spec);
+    auto reader =
+        CreateExampleReader(dataset_path, data_spec, /*required_columns=*/{},
+                            /*load_columns=*/std::vector<int>{num_1_idx})
+            .value();
+    proto::Example example;
+    int num_rows = 0;
+    int sum_column_num_1 = 0;
+    while (reader->Next(&example).value()) {
+      sum_column_num_1 += example.attributes(num_1_idx).numerical();
+      // The non-requested columns are left unset.
+      EXPECT_TRUE(IsNa(example.attributes(num_2_idx)));
+      num_rows++;
+    }
+    if (absl::StartsWith(dataset_path, "csv:")) {
+      EXPECT_EQ(sum_column_num_1, 1 + 2 + 3 + 4);
+    }
+    EXPECT_EQ(num_rows, 4);
+  }
+}
+
 TEST(ExampleReader, IsFormatSupported) {
   EXPECT_TRUE(IsFormatSupported("csv:/path/to/ds").value());
   EXPECT_FALSE(IsFormatSupported("capacitor:/path/to/ds").value());
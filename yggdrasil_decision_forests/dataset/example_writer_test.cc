@@ -18,6 +18,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -92,5 +93,39 @@ TEST(CreateExampleWriter, Csv) {
   EXPECT_EQ(content, "a,b,c,d,e,f,g,h\n0.5,0 1,0 1,1,0 1,0 1,1,hello\n");
 }
 
+TEST(CreateExampleWriter, CsvSharded) {
+  const proto::DataSpecification data_spec = CreateDataspec();
+  const proto::Example example = CreateExample();
+
+  const std::string output_dataset_path_csv =
+      file::JoinPath(test::TmpDirectory(), "test_sharded.csv@3");
+
+  {
+    auto writer = CreateExampleWriter(
+                      absl::StrCat("csv:", output_dataset_path_csv), data_spec,
+                      /*num_records_by_shard=*/4)
+                      .value();
+    for (int example_idx = 0; example_idx < 10; example_idx++) {
+      EXPECT_OK(writer->Write(example));
+    }
+  }
+
+  std::vector<std::string> shard_paths;
+  EXPECT_OK(utils::ExpandOutputShards(output_dataset_path_csv, &shard_paths));
+  EXPECT_EQ(shard_paths.size(), 3);
+
+  const std::string header = "a,b,c,d,e,f,g,h\n";
+  const std::string row = "0.5,0 1,0 1,1,0 1,0 1,1,hello\n";
+  const std::vector<int> rows_per_shard = {4, 4, 2};
+  for (int shard_idx = 0; shard_idx < 3; shard_idx++) {
+    std::string expected_content = header;
+    for (int row_idx = 0; row_idx < rows_per_shard[shard_idx]; row_idx++) {
+      expected_content += row;
+    }
+    EXPECT_EQ(file::GetContent(shard_paths[shard_idx]).value(),
+              expected_content);
+  }
+}
+
 }  // namespace dataset
 }  // namespace yggdrasil_decision_forests
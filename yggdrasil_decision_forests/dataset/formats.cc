@@ -87,6 +87,10 @@ std::string FormatToRecommendedExtension(proto::DatasetFormat format) {
       return "tfrecord";
     case proto::FORMAT_PARTIAL_DATASET_CACHE:
       return "partial_dataset_cache";
+    case proto::FORMAT_PARQUET:
+      return "parquet";
+    case proto::FORMAT_COLUMNAR:
+      return "columnar";
   }
 }
 
@@ -101,6 +105,10 @@ std::string DatasetFormatToPrefix(proto::DatasetFormat format) {
       return FORMAT_TFE_TFRECORD;
     case proto::FORMAT_PARTIAL_DATASET_CACHE:
       return FORMAT_PARTIAL_DATASET_CACHE;
+    case proto::FORMAT_PARQUET:
+      return FORMAT_PARQUET;
+    case proto::FORMAT_COLUMNAR:
+      return FORMAT_COLUMNAR;
   }
 }
 
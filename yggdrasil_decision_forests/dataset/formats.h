@@ -42,6 +42,13 @@ const char* const FORMAT_TFE_TFRECORD = "tfrecord+tfe";
 // Partially computed (e.g. non indexed) dataset cache.
 const char* const FORMAT_PARTIAL_DATASET_CACHE = "partial_dataset_cache";
 
+// Apache Parquet file. Only available when compiled with Arrow support
+// ("--define=use_arrow=1").
+const char* const FORMAT_PARQUET = "parquet";
+
+// Raw columnar VerticalDataset (see "vertical_dataset_columnar.h").
+const char* const FORMAT_COLUMNAR = "columnar";
+
 // Splits the format and path from a typed path.
 std::pair<std::string, proto::DatasetFormat> GetDatasetPathAndType(
     absl::string_view typed_path);
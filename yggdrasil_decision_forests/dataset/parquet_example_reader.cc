@@ -0,0 +1,474 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/dataset/parquet_example_reader.h"
+
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "arrow/api.h"
+#include "arrow/io/api.h"
+#include "parquet/arrow/reader.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+namespace {
+
+using proto::ColumnType;
+
+// Converts an Arrow status into an absl status.
+absl::Status FromArrowStatus(const arrow::Status& status) {
+  if (status.ok()) {
+    return absl::OkStatus();
+  }
+  return absl::InvalidArgumentError(status.ToString());
+}
+
+// Opens a Parquet file for reading.
+utils::StatusOr<std::unique_ptr<parquet::arrow::FileReader>> OpenParquetFile(
+    const absl::string_view path) {
+  auto file = arrow::io::ReadableFile::Open(std::string(path));
+  if (!file.ok()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Cannot open ", path, ": ", file.status().ToString()));
+  }
+  std::unique_ptr<parquet::arrow::FileReader> file_reader;
+  RETURN_IF_ERROR(FromArrowStatus(parquet::arrow::OpenFile(
+      *file, arrow::default_memory_pool(), &file_reader)));
+  return file_reader;
+}
+
+// Field names of a Parquet schema. The equivalent of a csv header.
+std::vector<std::string> FieldNames(const arrow::Schema& schema) {
+  std::vector<std::string> header;
+  header.reserve(schema.num_fields());
+  for (const auto& field : schema.fields()) {
+    header.push_back(field->name());
+  }
+  return header;
+}
+
+// Extracts the value of a cell as a float.
+utils::StatusOr<float> NumericalValue(const arrow::Array& array,
+                                      const int64_t row) {
+  switch (array.type_id()) {
+    case arrow::Type::FLOAT:
+      return static_cast<const arrow::FloatArray&>(array).Value(row);
+    case arrow::Type::DOUBLE:
+      return static_cast<const arrow::DoubleArray&>(array).Value(row);
+    case arrow::Type::INT8:
+      return static_cast<const arrow::Int8Array&>(array).Value(row);
+    case arrow::Type::INT16:
+      return static_cast<const arrow::Int16Array&>(array).Value(row);
+    case arrow::Type::INT32:
+      return static_cast<const arrow::Int32Array&>(array).Value(row);
+    case arrow::Type::INT64:
+      return static_cast<const arrow::Int64Array&>(array).Value(row);
+    case arrow::Type::UINT8:
+      return static_cast<const arrow::UInt8Array&>(array).Value(row);
+    case arrow::Type::UINT16:
+      return static_cast<const arrow::UInt16Array&>(array).Value(row);
+    case arrow::Type::UINT32:
+      return static_cast<const arrow::UInt32Array&>(array).Value(row);
+    case arrow::Type::UINT64:
+      return static_cast<const arrow::UInt64Array&>(array).Value(row);
+    case arrow::Type::BOOL:
+      return static_cast<const arrow::BooleanArray&>(array).Value(row) ? 1.f
+                                                                       : 0.f;
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Non supported Parquet type \"",
+                       array.type()->ToString(), "\" for a numerical value"));
+  }
+}
+
+// Extracts the value of a cell as a string. Integer cells are converted with
+// the same tokens as when exported to a csv file.
+utils::StatusOr<std::string> StringValue(const arrow::Array& array,
+                                         const int64_t row) {
+  switch (array.type_id()) {
+    case arrow::Type::STRING:
+      return static_cast<const arrow::StringArray&>(array).GetString(row);
+    case arrow::Type::LARGE_STRING:
+      return static_cast<const arrow::LargeStringArray&>(array).GetString(row);
+    case arrow::Type::BINARY:
+      return static_cast<const arrow::BinaryArray&>(array).GetString(row);
+    case arrow::Type::INT32:
+      return absl::StrCat(
+          static_cast<const arrow::Int32Array&>(array).Value(row));
+    case arrow::Type::INT64:
+      return absl::StrCat(
+          static_cast<const arrow::Int64Array&>(array).Value(row));
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Non supported Parquet type \"",
+                       array.type()->ToString(), "\" for a string value"));
+  }
+}
+
+// Determines the type of an attribute according to the Parquet field type.
+// Unlike for csv files, Parquet files are typed: there is no need to scan
+// the values to infer the type.
+utils::StatusOr<ColumnType> InferTypeFromArrowType(
+    const proto::DataSpecificationGuide& guide, const arrow::DataType& type) {
+  switch (type.id()) {
+    case arrow::Type::FLOAT:
+    case arrow::Type::DOUBLE:
+    case arrow::Type::INT8:
+    case arrow::Type::INT16:
+    case arrow::Type::INT32:
+    case arrow::Type::INT64:
+    case arrow::Type::UINT8:
+    case arrow::Type::UINT16:
+    case arrow::Type::UINT32:
+    case arrow::Type::UINT64:
+      return guide.detect_numerical_as_discretized_numerical()
+                 ? ColumnType::DISCRETIZED_NUMERICAL
+                 : ColumnType::NUMERICAL;
+    case arrow::Type::BOOL:
+      if (guide.detect_boolean_as_numerical()) {
+        return guide.detect_numerical_as_discretized_numerical()
+                   ? ColumnType::DISCRETIZED_NUMERICAL
+                   : ColumnType::NUMERICAL;
+      }
+      return ColumnType::BOOLEAN;
+    case arrow::Type::STRING:
+    case arrow::Type::LARGE_STRING:
+    case arrow::Type::BINARY:
+      return ColumnType::CATEGORICAL;
+    default:
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Non supported Parquet type \"", type.ToString(), "\""));
+  }
+}
+
+// Converts a single Parquet cell into an example attribute. The semantics
+// mirror "CsvRowToExample": a null cell leaves the attribute unset (i.e. NA).
+absl::Status SetExampleAttribute(const arrow::Array& array, const int64_t row,
+                                 const proto::Column& col_spec,
+                                 proto::Example::Attribute* dst_value) {
+  if (array.IsNull(row)) {
+    return absl::OkStatus();
+  }
+  switch (col_spec.type()) {
+    case ColumnType::UNKNOWN:
+      break;
+    case ColumnType::NUMERICAL: {
+      ASSIGN_OR_RETURN(const float num_value, NumericalValue(array, row));
+      dst_value->set_numerical(num_value);
+    } break;
+    case ColumnType::DISCRETIZED_NUMERICAL: {
+      ASSIGN_OR_RETURN(const float num_value, NumericalValue(array, row));
+      dst_value->set_discretized_numerical(
+          NumericalToDiscretizedNumerical(col_spec, num_value));
+    } break;
+    case ColumnType::CATEGORICAL: {
+      ASSIGN_OR_RETURN(const auto str_value, StringValue(array, row));
+      ASSIGN_OR_RETURN(const auto value,
+                       CategoricalStringToValueWithStatus(str_value, col_spec));
+      dst_value->set_categorical(value);
+    } break;
+    case ColumnType::BOOLEAN: {
+      ASSIGN_OR_RETURN(const float num_value, NumericalValue(array, row));
+      dst_value->set_boolean(num_value >= 0.5f);
+    } break;
+    case ColumnType::STRING: {
+      ASSIGN_OR_RETURN(*dst_value->mutable_text(), StringValue(array, row));
+    } break;
+    case ColumnType::HASH: {
+      ASSIGN_OR_RETURN(const auto str_value, StringValue(array, row));
+      dst_value->set_hash(HashColumnString(str_value));
+    } break;
+    default:
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Non supported column type ", proto::ColumnType_Name(col_spec.type()),
+          " for Parquet files"));
+  }
+  return absl::OkStatus();
+}
+
+// Update the dataspec with the content of a record batch. The Parquet
+// equivalent of "UpdateDataSpecWithCsvExample".
+absl::Status UpdateDataSpecWithParquetBatch(
+    const arrow::RecordBatch& batch,
+    const std::vector<int>& col_idx_to_field_idx,
+    proto::DataSpecification* data_spec,
+    proto::DataSpecificationAccumulator* accumulator) {
+  for (int col_idx = 0; col_idx < data_spec->columns_size(); col_idx++) {
+    proto::Column* col = data_spec->mutable_columns(col_idx);
+    if (col->is_unstacked()) {
+      LOG(FATAL)
+          << "Unstacked numerical features not supported for Parquet files";
+    }
+    auto* col_acc = accumulator->mutable_columns(col_idx);
+    const auto& array = *batch.column(col_idx_to_field_idx[col_idx]);
+    for (int64_t row = 0; row < batch.num_rows(); row++) {
+      // Skip NAs
+      if (array.IsNull(row)) {
+        col->set_count_nas(col->count_nas() + 1);
+        continue;
+      }
+      // Mean, min and max of single dimension numerical columns.
+      if (IsNumerical(col->type()) && !IsMultiDimensional(col->type())) {
+        ASSIGN_OR_RETURN(const float num_value, NumericalValue(array, row));
+        FillContentNumericalFeature(num_value, col_acc);
+      }
+      if (IsCategorical(col->type())) {
+        ASSIGN_OR_RETURN(const auto token, StringValue(array, row));
+        RETURN_IF_ERROR(AddTokensToCategoricalColumnSpec({token}, col));
+      }
+      if (col->type() == ColumnType::DISCRETIZED_NUMERICAL) {
+        ASSIGN_OR_RETURN(const float num_value, NumericalValue(array, row));
+        UpdateComputeSpecDiscretizedNumerical(num_value, col, col_acc);
+      }
+      if (col->type() == ColumnType::BOOLEAN) {
+        ASSIGN_OR_RETURN(const float num_value, NumericalValue(array, row));
+        UpdateComputeSpecBooleanFeature(num_value, col);
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+ParquetExampleReader::Implementation::Implementation(
+    const proto::DataSpecification& data_spec,
+    const absl::optional<std::vector<int>> required_columns)
+    : data_spec_(data_spec), required_columns_(required_columns) {}
+
+absl::Status ParquetExampleReader::Implementation::OpenShard(
+    const absl::string_view path) {
+  ASSIGN_OR_RETURN(file_reader_, OpenParquetFile(path));
+
+  std::vector<int> row_groups(file_reader_->num_row_groups());
+  std::iota(row_groups.begin(), row_groups.end(), 0);
+  RETURN_IF_ERROR(FromArrowStatus(
+      file_reader_->GetRecordBatchReader(row_groups, &batch_reader_)));
+
+  const auto new_header = FieldNames(*batch_reader_->schema());
+  if (parquet_header_.empty()) {
+    parquet_header_ = new_header;
+    RETURN_IF_ERROR(BuildColIdxToFeatureLabelIdx(data_spec_, parquet_header_,
+                                                 required_columns_,
+                                                 &col_idx_to_field_idx_));
+    MaskNonLoadedColumns(load_columns_, &col_idx_to_field_idx_);
+  } else {
+    if (parquet_header_ != new_header) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("The schema of ", path,
+                       " does not match the schema of the other files"));
+    }
+  }
+  batch_ = nullptr;
+  row_in_batch_ = 0;
+  return absl::OkStatus();
+}
+
+utils::StatusOr<bool> ParquetExampleReader::Implementation::NextInShard(
+    proto::Example* example) {
+  while (batch_ == nullptr || row_in_batch_ >= batch_->num_rows()) {
+    RETURN_IF_ERROR(FromArrowStatus(batch_reader_->ReadNext(&batch_)));
+    if (batch_ == nullptr) {
+      return false;
+    }
+    row_in_batch_ = 0;
+    RETURN_IF_ERROR(PrecomputeHashColumns());
+  }
+  example->mutable_attributes()->Clear();
+  example->mutable_attributes()->Reserve(data_spec_.columns_size());
+  for (int col_idx = 0; col_idx < data_spec_.columns_size(); col_idx++) {
+    auto* dst_value = example->mutable_attributes()->Add();
+    const int field_idx = col_idx_to_field_idx_[col_idx];
+    if (field_idx == -1) {
+      continue;
+    }
+    const auto& hashes = batch_hash_cache_[col_idx];
+    if (!hashes.empty()) {
+      // HASH column pre-hashed by "PrecomputeHashColumns". A null cell leaves
+      // the attribute unset, like "SetExampleAttribute".
+      if (!batch_->column(field_idx)->IsNull(row_in_batch_)) {
+        dst_value->set_hash(hashes[row_in_batch_]);
+      }
+      continue;
+    }
+    RETURN_IF_ERROR(SetExampleAttribute(*batch_->column(field_idx),
+                                        row_in_batch_,
+                                        data_spec_.columns(col_idx),
+                                        dst_value));
+  }
+  row_in_batch_++;
+  return true;
+}
+
+absl::Status ParquetExampleReader::Implementation::PrecomputeHashColumns() {
+  batch_hash_cache_.assign(data_spec_.columns_size(), {});
+  std::vector<absl::string_view> values;
+  for (int col_idx = 0; col_idx < data_spec_.columns_size(); col_idx++) {
+    if (data_spec_.columns(col_idx).type() != ColumnType::HASH) {
+      continue;
+    }
+    const int field_idx = col_idx_to_field_idx_[col_idx];
+    if (field_idx == -1) {
+      continue;
+    }
+    const auto& array = *batch_->column(field_idx);
+    const int64_t num_rows = batch_->num_rows();
+    values.assign(num_rows, absl::string_view());
+    // Only string-like fields are batched: the other field types (e.g.
+    // integers, which require a string conversion) keep being hashed cell by
+    // cell in "SetExampleAttribute". The values of null cells are never read.
+    switch (array.type_id()) {
+      case arrow::Type::STRING: {
+        const auto& typed_array = static_cast<const arrow::StringArray&>(array);
+        for (int64_t row = 0; row < num_rows; row++) {
+          const auto view = typed_array.GetView(row);
+          values[row] = absl::string_view(view.data(), view.size());
+        }
+      } break;
+      case arrow::Type::LARGE_STRING: {
+        const auto& typed_array =
+            static_cast<const arrow::LargeStringArray&>(array);
+        for (int64_t row = 0; row < num_rows; row++) {
+          const auto view = typed_array.GetView(row);
+          values[row] = absl::string_view(view.data(), view.size());
+        }
+      } break;
+      case arrow::Type::BINARY: {
+        const auto& typed_array = static_cast<const arrow::BinaryArray&>(array);
+        for (int64_t row = 0; row < num_rows; row++) {
+          const auto view = typed_array.GetView(row);
+          values[row] = absl::string_view(view.data(), view.size());
+        }
+      } break;
+      default:
+        continue;
+    }
+    HashColumnStrings(values, &batch_hash_cache_[col_idx]);
+  }
+  return absl::OkStatus();
+}
+
+ParquetExampleReader::ParquetExampleReader(
+    const proto::DataSpecification& data_spec,
+    const absl::optional<std::vector<int>> required_columns)
+    : sharded_parquet_reader_(data_spec, required_columns) {}
+
+absl::Status ParquetDataSpecCreator::InferColumnsAndTypes(
+    const std::vector<std::string>& paths,
+    const proto::DataSpecificationGuide& guide,
+    proto::DataSpecification* data_spec) {
+  // For each dataspec column index, gives the Parquet field index and the
+  // dataspec guide.
+  std::vector<std::pair<int, proto::ColumnGuide>> spec_col_idx_2_field_idx;
+
+  // The column types are determined by the schema of the first file: no
+  // values need to be scanned.
+  ASSIGN_OR_RETURN(const auto file_reader, OpenParquetFile(paths.front()));
+  std::shared_ptr<arrow::Schema> schema;
+  RETURN_IF_ERROR(FromArrowStatus(file_reader->GetSchema(&schema)));
+
+  const auto header = FieldNames(*schema);
+  InitializeDataSpecFromColumnNames(guide, header, data_spec,
+                                    &spec_col_idx_2_field_idx);
+
+  for (int col_idx = 0; col_idx < spec_col_idx_2_field_idx.size(); col_idx++) {
+    proto::Column* col = data_spec->mutable_columns(col_idx);
+    if (col->is_manual_type()) {
+      // The user has already specified the type of this column.
+      continue;
+    }
+    const int field_idx = spec_col_idx_2_field_idx[col_idx].first;
+    ASSIGN_OR_RETURN(
+        const auto type,
+        InferTypeFromArrowType(guide, *schema->field(field_idx)->type()));
+    col->set_type(type);
+  }
+  return UpdateColSpecsWithGuideInfo(spec_col_idx_2_field_idx, data_spec);
+}
+
+absl::Status ParquetDataSpecCreator::ComputeColumnStatistics(
+    const std::vector<std::string>& paths,
+    const proto::DataSpecificationGuide& guide,
+    proto::DataSpecification* data_spec,
+    proto::DataSpecificationAccumulator* accumulator) {
+  std::vector<int> col_idx_to_field_idx;
+  std::vector<std::string> parquet_header;
+  uint64_t nrow = 0;
+  for (const auto& path : paths) {
+    if (guide.max_num_scanned_rows_to_accumulate_statistics() > 0 &&
+        nrow > guide.max_num_scanned_rows_to_accumulate_statistics()) {
+      break;
+    }
+
+    // Open the Parquet file.
+    ASSIGN_OR_RETURN(const auto file_reader, OpenParquetFile(path));
+    std::vector<int> row_groups(file_reader->num_row_groups());
+    std::iota(row_groups.begin(), row_groups.end(), 0);
+    std::shared_ptr<arrow::RecordBatchReader> batch_reader;
+    RETURN_IF_ERROR(FromArrowStatus(
+        file_reader->GetRecordBatchReader(row_groups, &batch_reader)));
+
+    const auto new_header = FieldNames(*batch_reader->schema());
+    if (parquet_header.empty()) {
+      parquet_header = new_header;
+      RETURN_IF_ERROR(BuildColIdxToFeatureLabelIdx(
+          *data_spec, parquet_header, {}, &col_idx_to_field_idx));
+    } else {
+      if (parquet_header != new_header) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("The schema of ", path,
+                         " does not match the schema of ", paths.front()));
+      }
+    }
+
+    std::shared_ptr<arrow::RecordBatch> batch;
+    while (true) {
+      RETURN_IF_ERROR(FromArrowStatus(batch_reader->ReadNext(&batch)));
+      if (batch == nullptr) {
+        break;
+      }
+      LOG_INFO_EVERY_N_SEC(30, _ << nrow << " row(s) processed");
+      RETURN_IF_ERROR(UpdateDataSpecWithParquetBatch(
+          *batch, col_idx_to_field_idx, data_spec, accumulator));
+      nrow += batch->num_rows();
+    }
+  }
+  data_spec->set_created_num_rows(nrow);
+  return absl::OkStatus();
+}
+
+utils::StatusOr<int64_t> ParquetDataSpecCreator::CountExamples(
+    const absl::string_view path) {
+  // The number of rows is available in the file metadata.
+  ASSIGN_OR_RETURN(const auto file_reader, OpenParquetFile(path));
+  return file_reader->parquet_reader()->metadata()->num_rows();
+}
+
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Support for dataset stored as Apache Parquet.
+//
+// This format is only available when compiling with Arrow support i.e.
+// "--define=use_arrow=1". See "third_party/arrow/workspace.bzl" for the
+// required local Arrow installation.
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_DATASET_PARQUET_EXAMPLE_READER_H_
+#define YGGDRASIL_DECISION_FORESTS_DATASET_PARQUET_EXAMPLE_READER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "arrow/record_batch.h"
+#include "parquet/arrow/reader.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
+#include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/example_reader_interface.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/sharded_io.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+
+// Example reader from a Parquet file.
+// This class is thread-compatible (you can use it from multiple threads at the
+// same time, but you are in charge of the synchronization).
+//
+// Like "CsvExampleReader", this class is implemented as inheritance +
+// interface on top of "ShardedReader".
+class ParquetExampleReader final : public ExampleReaderInterface {
+ public:
+  explicit ParquetExampleReader(
+      const proto::DataSpecification& data_spec,
+      absl::optional<std::vector<int>> required_columns);
+
+  utils::StatusOr<bool> Next(proto::Example* example) override {
+    return sharded_parquet_reader_.Next(example);
+  }
+
+  absl::Status Open(absl::string_view sharded_path) override {
+    return sharded_parquet_reader_.Open(sharded_path);
+  }
+
+  void SetLoadColumns(const std::vector<int>& load_columns) override {
+    sharded_parquet_reader_.set_load_columns(load_columns);
+  }
+
+ private:
+  class Implementation final : public utils::ShardedReader<proto::Example> {
+   public:
+    explicit Implementation(const proto::DataSpecification& data_spec,
+                            absl::optional<std::vector<int>> required_columns);
+
+    void set_load_columns(const std::vector<int>& load_columns) {
+      load_columns_ = load_columns;
+    }
+
+   protected:
+    // Opens the Parquet file at "path", and check that the schema is as
+    // expected.
+    absl::Status OpenShard(absl::string_view path) override;
+
+    // Reads a new row from the current record batch (fetching the next record
+    // batch if needed), and converts it into a proto:Example.
+    utils::StatusOr<bool> NextInShard(proto::Example* example) override;
+
+   private:
+    // Hashes the HASH columns of the newly read record batch, a column chunk
+    // at a time (see "HashColumnStrings"), into "batch_hash_cache_".
+    absl::Status PrecomputeHashColumns();
+    // The data spec.
+    const proto::DataSpecification data_spec_;
+
+    // Currently, open file.
+    std::unique_ptr<parquet::arrow::FileReader> file_reader_;
+
+    // Iterator over the record batches of the open file.
+    std::shared_ptr<arrow::RecordBatchReader> batch_reader_;
+
+    // Currently, read record batch, and next row to read in it.
+    std::shared_ptr<arrow::RecordBatch> batch_;
+    int64_t row_in_batch_ = 0;
+
+    // Matching between data_spec column indices and Parquet field indices.
+    std::vector<int> col_idx_to_field_idx_;
+
+    // Pre-computed hashes of the HASH columns of the current record batch,
+    // indexed by dataspec column index (the value of a null cell is
+    // meaningless and never read). Empty vectors for the other columns and
+    // for HASH columns read from non-string Parquet fields, which fall back
+    // to the cell-by-cell conversion.
+    std::vector<std::vector<uint64_t>> batch_hash_cache_;
+
+    // Field names of the Parquet schema.
+    std::vector<std::string> parquet_header_;
+
+    const absl::optional<std::vector<int>> required_columns_;
+
+    // If set, only extract this subset of columns. The other columns are left
+    // unset in the generated examples.
+    absl::optional<std::vector<int>> load_columns_;
+  };
+
+  Implementation sharded_parquet_reader_;
+};
+
+REGISTER_ExampleReaderInterface(ParquetExampleReader, "FORMAT_PARQUET");
+
+class ParquetDataSpecCreator : public AbstractDataSpecCreator {
+ public:
+  absl::Status InferColumnsAndTypes(
+      const std::vector<std::string>& paths,
+      const proto::DataSpecificationGuide& guide,
+      proto::DataSpecification* data_spec) override;
+
+  absl::Status ComputeColumnStatistics(
+      const std::vector<std::string>& paths,
+      const proto::DataSpecificationGuide& guide,
+      proto::DataSpecification* data_spec,
+      proto::DataSpecificationAccumulator* accumulator) override;
+
+  utils::StatusOr<int64_t> CountExamples(absl::string_view path) override;
+};
+
+REGISTER_AbstractDataSpecCreator(ParquetDataSpecCreator, "FORMAT_PARQUET");
+
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_DATASET_PARQUET_EXAMPLE_READER_H_
@@ -61,10 +61,12 @@
 #include "yggdrasil_decision_forests/dataset/formats.pb.h"
 #include "yggdrasil_decision_forests/dataset/tensorflow/tf_example_io_interface.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/csv.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/hash.h"
 #include "yggdrasil_decision_forests/utils/random.h"
+#include "yggdrasil_decision_forests/utils/sharded_io.h"
 
 namespace yggdrasil_decision_forests {
 namespace dataset {
@@ -116,17 +118,14 @@ struct GeneratorState {
   std::vector<int> multidimensional_numerical_accumulator_idxs;
 };
 
-// Creates and initializes the random generator.
-utils::RandomEngine CreateRandomGenerator(
-    const proto::SyntheticDatasetOptions& options) {
-  utils::RandomEngine rnd;
+// Resolves the seed of the generation: the user specified seed, or a
+// non-deterministic seed if the user specified seed is -1.
+uint64_t ResolveSeed(const proto::SyntheticDatasetOptions& options) {
   if (options.seed() == -1) {
     std::random_device initializer;
-    rnd.seed(initializer());
-  } else {
-    rnd.seed(options.seed());
+    return initializer();
   }
-  return rnd;
+  return options.seed();
 }
 
 // Hashing of an integer that is stable for two executions of the library.
@@ -134,6 +133,21 @@ uint64_t StableHash(uint64_t value) {
   return utils::hash::HashInt64ToUint64(value);
 }
 
+// Seed of the random generator dedicated to one example. An example only
+// depends on the base seed and on the example index, so the examples can be
+// generated in parallel (and in any order) deterministically. The even/odd
+// split with "AccumulatorSeed" keeps the two families of random streams
+// distinct.
+uint64_t ExampleSeed(const uint64_t seed, const int64_t example_idx) {
+  return StableHash(seed ^ StableHash(2 * example_idx));
+}
+
+// Seed of the random generator dedicated to the rank noise of one
+// accumulator. See "ExampleSeed".
+uint64_t AccumulatorSeed(const uint64_t seed, const int accumulator_idx) {
+  return StableHash(seed ^ StableHash(2 * accumulator_idx + 1));
+}
+
 // Creates a decreasing weight for a list of features.
 float DecreasingWeight(const int feature_idx, const int num_features) {
   DCHECK_LT(feature_idx, num_features);
@@ -390,55 +404,84 @@ void AddCategoricalSetFeatures(const proto::SyntheticDatasetOptions& options,
 
 utils::StatusOr<std::vector<Example>> CreateFeatures(
     const proto::SyntheticDatasetOptions& options, const GeneratorState& state,
-    utils::RandomEngine* rnd) {
-  std::vector<Example> examples;
-  examples.reserve(options.num_examples());
-
-  for (int example_idx = 0; example_idx < options.num_examples();
-       example_idx++) {
-    Example example;
-    example.accumulators.assign(options.num_accumulators(), {});
-    example.noisy_accumulator_ranks.assign(options.num_accumulators(), {});
-
-    // Numerical features.
-    AddNumericalFeatures(options, state, &example, rnd);
-
-    // Multidimensional numerical features.
-    AddMultidimensionalNumericalFeatures(options, state, &example, rnd);
-
-    // Categorical features.
-    AddCategoricalFeatures(options, state, /*str_representation=*/false,
-                           &example, rnd);
-    AddCategoricalFeatures(options, state, /*str_representation=*/true,
-                           &example, rnd);
-
-    // Boolean features.
-    AddBooleanFeatures(options, state, &example, rnd);
-
-    // Categorical-set features.
-    AddCategoricalSetFeatures(options, state, /*str_representation=*/false,
-                              &example, rnd);
-    AddCategoricalSetFeatures(options, state, /*str_representation=*/true,
-                              &example, rnd);
-
-    examples.push_back(std::move(example));
+    const uint64_t seed) {
+  std::vector<Example> examples(options.num_examples());
+
+  const auto create_features_in_range = [&](const int begin_example_idx,
+                                            const int end_example_idx) {
+    for (int example_idx = begin_example_idx; example_idx < end_example_idx;
+         example_idx++) {
+      // Each example has its own random generator: the generated values do
+      // not depend on the number of threads.
+      utils::RandomEngine rnd(ExampleSeed(seed, example_idx));
+
+      auto& example = examples[example_idx];
+      example.accumulators.assign(options.num_accumulators(), {});
+      example.noisy_accumulator_ranks.assign(options.num_accumulators(), {});
+
+      // Numerical features.
+      AddNumericalFeatures(options, state, &example, &rnd);
+
+      // Multidimensional numerical features.
+      AddMultidimensionalNumericalFeatures(options, state, &example, &rnd);
+
+      // Categorical features.
+      AddCategoricalFeatures(options, state, /*str_representation=*/false,
+                             &example, &rnd);
+      AddCategoricalFeatures(options, state, /*str_representation=*/true,
+                             &example, &rnd);
+
+      // Boolean features.
+      AddBooleanFeatures(options, state, &example, &rnd);
+
+      // Categorical-set features.
+      AddCategoricalSetFeatures(options, state, /*str_representation=*/false,
+                                &example, &rnd);
+      AddCategoricalSetFeatures(options, state, /*str_representation=*/true,
+                                &example, &rnd);
+    }
+  };
+
+  const int num_threads =
+      std::min(options.num_threads(), options.num_examples());
+  if (num_threads > 1) {
+    // Generate the examples by blocks, one block per thread.
+    utils::concurrency::ThreadPool pool("CreateFeatures", num_threads);
+    pool.StartWorkers();
+    const int block_size =
+        (options.num_examples() + num_threads - 1) / num_threads;
+    for (int begin_example_idx = 0;
+         begin_example_idx < options.num_examples();
+         begin_example_idx += block_size) {
+      const int end_example_idx = std::min(begin_example_idx + block_size,
+                                           options.num_examples());
+      pool.Schedule([&create_features_in_range, begin_example_idx,
+                     end_example_idx]() {
+        create_features_in_range(begin_example_idx, end_example_idx);
+      });
+    }
+  } else {
+    create_features_in_range(0, options.num_examples());
   }
 
   return std::move(examples);
 }
 
 absl::Status ComputeAccumulatorRanks(
-    const proto::SyntheticDatasetOptions& options,
-    std::vector<Example>* examples, utils::RandomEngine* rnd) {
+    const proto::SyntheticDatasetOptions& options, const uint64_t seed,
+    std::vector<Example>* examples) {
   const int rank_noise =
       static_cast<int>(examples->size() * options.label_noise_ratio());
-  auto raw_label_rank_noise =
-      std::uniform_real_distribution<float>(-rank_noise, rank_noise);
 
-  std::vector<std::pair<float, int>> sorted_labels(examples->size());
-  for (int accumulator_idx = 0; accumulator_idx < options.num_accumulators();
-       accumulator_idx++) {
+  const auto compute_accumulator_ranks = [&](const int accumulator_idx) {
+    // The rank noise of each accumulator has its own random generator: the
+    // accumulators can be processed in parallel deterministically.
+    utils::RandomEngine rnd(AccumulatorSeed(seed, accumulator_idx));
+    auto raw_label_rank_noise =
+        std::uniform_real_distribution<float>(-rank_noise, rank_noise);
+
     // Gather and sort all the accumulator values.
+    std::vector<std::pair<float, int>> sorted_labels(examples->size());
     for (int example_idx = 0; example_idx < examples->size(); example_idx++) {
       sorted_labels[example_idx].first =
           (*examples)[example_idx].accumulators[accumulator_idx];
@@ -449,7 +492,7 @@ absl::Status ComputeAccumulatorRanks(
     // Update the rank field of each example.
     for (int rank_idx = 0; rank_idx < examples->size(); rank_idx++) {
       // Add some noise to the rank.
-      int noisy_rank = rank_idx + raw_label_rank_noise(*rnd);
+      int noisy_rank = rank_idx + raw_label_rank_noise(rnd);
       if (noisy_rank < 0) {
         noisy_rank = 0;
       }
@@ -461,6 +504,25 @@ absl::Status ComputeAccumulatorRanks(
       (*examples)[sorted_labels[rank_idx].second]
           .noisy_accumulator_ranks[accumulator_idx] = noisy_rank;
     }
+  };
+
+  const int num_threads =
+      std::min(options.num_threads(), options.num_accumulators());
+  if (num_threads > 1) {
+    utils::concurrency::ThreadPool pool("ComputeAccumulatorRanks",
+                                        num_threads);
+    pool.StartWorkers();
+    for (int accumulator_idx = 0; accumulator_idx < options.num_accumulators();
+         accumulator_idx++) {
+      pool.Schedule([&compute_accumulator_ranks, accumulator_idx]() {
+        compute_accumulator_ranks(accumulator_idx);
+      });
+    }
+  } else {
+    for (int accumulator_idx = 0; accumulator_idx < options.num_accumulators();
+         accumulator_idx++) {
+      compute_accumulator_ranks(accumulator_idx);
+    }
   }
   return absl::OkStatus();
 }
@@ -484,15 +546,9 @@ float ComputeLabelValue(const Example& example, const int num_examples) {
 }
 
 absl::Status CreateLabels(const proto::SyntheticDatasetOptions& options,
-                          const GeneratorState& state,
-                          std::vector<Example>* examples,
-                          utils::RandomEngine* rnd) {
-  RETURN_IF_ERROR(ComputeAccumulatorRanks(options, examples, rnd));
-
-  const int rank_noise =
-      static_cast<int>(examples->size() * options.label_noise_ratio());
-  auto raw_label_rank_noise =
-      std::uniform_real_distribution<float>(-rank_noise, rank_noise);
+                          const GeneratorState& state, const uint64_t seed,
+                          std::vector<Example>* examples) {
+  RETURN_IF_ERROR(ComputeAccumulatorRanks(options, seed, examples));
 
   utils::RandomEngine ranking_group_rnd;
 
@@ -543,14 +599,30 @@ absl::Status CreateLabels(const proto::SyntheticDatasetOptions& options,
   return absl::OkStatus();
 }
 
-// Writes the list of examples to a tensorflow.Example container.
+// Writes the list of examples to a tensorflow.Example container. The shards
+// (if any) are written in parallel.
 absl::Status WriteTFEExamples(const std::vector<Example>& examples,
-                              absl::string_view typed_path) {
-  ASSIGN_OR_RETURN(auto writer, CreateTFExampleWriter(typed_path, -1));
+                              absl::string_view typed_path,
+                              const int num_threads) {
+  std::string sharded_path;
+  proto::DatasetFormat format;
+  std::tie(sharded_path, format) = GetDatasetPathAndType(typed_path);
+  const std::string& format_name = proto::DatasetFormat_Name(format);
+
+  // Validate the format before starting the writer threads.
+  RETURN_IF_ERROR(
+      AbstractTFExampleWriterRegisterer::Create(format_name).status());
+
+  utils::ParallelShardedWriter<tensorflow::Example> writer(
+      [&format_name]() {
+        return AbstractTFExampleWriterRegisterer::Create(format_name).value();
+      },
+      num_threads);
+  RETURN_IF_ERROR(writer.Open(sharded_path, -1));
   for (const auto& example : examples) {
-    RETURN_IF_ERROR(writer->Write(example.tf_example));
+    RETURN_IF_ERROR(writer.Write(example.tf_example));
   }
-  return writer->CloseWithStatus();
+  return writer.CloseWithStatus();
 }
 
 // Writes a list of examples to a CSV file.
@@ -623,7 +695,8 @@ absl::Status WriteCsvExamples(const std::vector<Example>& examples,
 }
 
 absl::Status WriteExamples(const std::vector<Example>& examples,
-                           absl::string_view typed_path) {
+                           absl::string_view typed_path,
+                           const int num_threads) {
   // Note: We don't use the generic example writer (CreateExampleWriter) because
   // we don't have (and do not want to create) a dataspec.
   std::string sharded_path;
@@ -633,7 +706,7 @@ absl::Status WriteExamples(const std::vector<Example>& examples,
     return WriteCsvExamples(examples, typed_path);
   } else {
     // Will fail if the format is not based on tensorflow.Example protos.
-    return WriteTFEExamples(examples, typed_path);
+    return WriteTFEExamples(examples, typed_path, num_threads);
   }
 }
 
@@ -681,11 +754,12 @@ utils::StatusOr<GeneratorState> CreateState(
 absl::Status GenerateSyntheticDataset(
     const proto::SyntheticDatasetOptions& options,
     absl::string_view typed_path) {
-  auto rnd = CreateRandomGenerator(options);
+  const uint64_t seed = ResolveSeed(options);
+  utils::RandomEngine rnd(seed);
   ASSIGN_OR_RETURN(auto state, CreateState(options, &rnd));
-  ASSIGN_OR_RETURN(auto examples, CreateFeatures(options, state, &rnd));
-  RETURN_IF_ERROR(CreateLabels(options, state, &examples, &rnd));
-  return WriteExamples(examples, typed_path);
+  ASSIGN_OR_RETURN(auto examples, CreateFeatures(options, state, seed));
+  RETURN_IF_ERROR(CreateLabels(options, state, seed, &examples));
+  return WriteExamples(examples, typed_path, options.num_threads());
 }
 
 absl::Status GenerateSyntheticDatasetTrainValidTest(
@@ -711,10 +785,11 @@ absl::Status GenerateSyntheticDatasetTrainValidTest(
         "\"test\" cannot be empty if \"ratio_test\" >0.");
   }
 
-  auto rnd = CreateRandomGenerator(options);
+  const uint64_t seed = ResolveSeed(options);
+  utils::RandomEngine rnd(seed);
   ASSIGN_OR_RETURN(auto state, CreateState(options, &rnd));
-  ASSIGN_OR_RETURN(auto examples, CreateFeatures(options, state, &rnd));
-  RETURN_IF_ERROR(CreateLabels(options, state, &examples, &rnd));
+  ASSIGN_OR_RETURN(auto examples, CreateFeatures(options, state, seed));
+  RETURN_IF_ERROR(CreateLabels(options, state, seed, &examples));
 
   auto uniform = std::uniform_real_distribution<float>();
   std::vector<Example> example_train;
@@ -746,12 +821,15 @@ absl::Status GenerateSyntheticDatasetTrainValidTest(
     }
   }
 
-  RETURN_IF_ERROR(WriteExamples(example_train, typed_path_train));
+  RETURN_IF_ERROR(
+      WriteExamples(example_train, typed_path_train, options.num_threads()));
   if (!typed_path_valid.empty()) {
-    RETURN_IF_ERROR(WriteExamples(example_valid, typed_path_valid));
+    RETURN_IF_ERROR(
+        WriteExamples(example_valid, typed_path_valid, options.num_threads()));
   }
   if (!typed_path_test.empty()) {
-    RETURN_IF_ERROR(WriteExamples(example_test, typed_path_test));
+    RETURN_IF_ERROR(
+        WriteExamples(example_test, typed_path_test, options.num_threads()));
   }
   return absl::OkStatus();
 }
@@ -27,6 +27,7 @@
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
@@ -43,17 +44,41 @@ namespace {
 using proto::ColumnType;
 }  // namespace
 
-absl::Status TfExampleToYdfExample(const tensorflow::Example& tf_example,
-                                   const proto::DataSpecification& data_spec,
-                                   proto::Example* example) {
+absl::Status TfExampleToYdfExample(
+    const tensorflow::Example& tf_example,
+    const proto::DataSpecification& data_spec, proto::Example* example,
+    const absl::optional<std::vector<int>>& load_columns) {
   example->mutable_attributes()->Clear();
   example->mutable_attributes()->Reserve(data_spec.columns_size());
   for (int col_idx = 0; col_idx < data_spec.columns_size(); col_idx++) {
     example->mutable_attributes()->Add();
   }
 
+  // Columns to decode. If "load_columns" is not set, all the columns are
+  // decoded.
+  std::vector<bool> is_loaded;
+  if (load_columns.has_value()) {
+    is_loaded.assign(data_spec.columns_size(), false);
+    for (const int col_idx : load_columns.value()) {
+      is_loaded[col_idx] = true;
+    }
+  }
+
   // Stacked columns.
   for (const auto& unstacked : data_spec.unstackeds()) {
+    if (load_columns.has_value()) {
+      // Skip the feature if none of its stacked columns is requested.
+      bool any_loaded = false;
+      for (int dim_idx = 0; dim_idx < unstacked.size(); dim_idx++) {
+        if (is_loaded[unstacked.begin_column_idx() + dim_idx]) {
+          any_loaded = true;
+          break;
+        }
+      }
+      if (!any_loaded) {
+        continue;
+      }
+    }
     const auto it_feature =
         tf_example.features().feature().find(unstacked.original_name());
     if (it_feature == tf_example.features().feature().end() ||
@@ -130,6 +155,9 @@ absl::Status TfExampleToYdfExample(const tensorflow::Example& tf_example,
     if (col_spec.is_unstacked()) {
       continue;
     }
+    if (load_columns.has_value() && !is_loaded[col_idx]) {
+      continue;
+    }
     auto* dst_value = example->mutable_attributes(col_idx);
     const auto it_feature =
         tf_example.features().feature().find(col_spec.name());
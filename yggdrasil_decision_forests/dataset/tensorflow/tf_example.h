@@ -16,7 +16,10 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_DATASET_TENSORFLOW_TF_EXAMPLE_H_
 #define YGGDRASIL_DECISION_FORESTS_DATASET_TENSORFLOW_TF_EXAMPLE_H_
 
+#include <vector>
+
 #include "absl/status/status.h"
+#include "absl/types/optional.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
@@ -27,9 +30,14 @@ namespace yggdrasil_decision_forests {
 namespace dataset {
 
 // Converts a tf.Example into an Example.
-absl::Status TfExampleToYdfExample(const ::tensorflow::Example& tf_example,
-                                   const proto::DataSpecification& data_spec,
-                                   proto::Example* example);
+//
+// If "load_columns" is set, only this subset of columns (dataspec column
+// indices) is decoded. The other columns are left unset (i.e. treated as
+// missing) in the generated example.
+absl::Status TfExampleToYdfExample(
+    const ::tensorflow::Example& tf_example,
+    const proto::DataSpecification& data_spec, proto::Example* example,
+    const absl::optional<std::vector<int>>& load_columns = {});
 
 // Converts a proto::Example into a tensorflow::Example.
 absl::Status YdfExampleToTfExample(const proto::Example& example,
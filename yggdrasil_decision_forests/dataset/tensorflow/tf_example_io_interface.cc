@@ -50,6 +50,20 @@ using yggdrasil_decision_forests::dataset::GetDatasetPathAndType;
 
 using proto::ColumnType;
 
+namespace {
+
+// Number of worker threads and records per batch of the parallel decoding
+// pipeline. The raw record reading (I/O + inflate) remains sequential within
+// a shard: a few decoding workers are enough to keep up with it.
+constexpr int kNumDecodingThreads = 4;
+constexpr int kDecodingBatchSize = 256;
+
+// Maximum number of batches in flight (pending or decoded), for back
+// pressure on the raw record producer.
+constexpr int kMaxPendingDecodingBatches = 2 * kNumDecodingThreads;
+
+}  // namespace
+
 // Information attached to each feature a tf.example when parsing a tf.example
 // container, in order to determine the most likely type of each feature.
 struct InferTypeInfo {
@@ -252,8 +266,32 @@ TFExampleReaderToExampleReader::TFExampleReaderToExampleReader(
     const absl::optional<std::vector<int>> ensure_non_missing)
     : data_spec_(data_spec), ensure_non_missing_(ensure_non_missing) {}
 
+TFExampleReaderToExampleReader::~TFExampleReaderToExampleReader() {
+  StopWorkers();
+}
+
 absl::Status TFExampleReaderToExampleReader::Open(
     absl::string_view sharded_path) {
+  raw_reader_ = CreateRawReader();
+  if (raw_reader_ != nullptr) {
+    // Parallel decoding: the producer thread reads the raw records into
+    // batches, the decoder workers parse and convert the batches, and "Next"
+    // consumes the decoded batches in reading order.
+    RETURN_IF_ERROR(raw_reader_->Open(sharded_path));
+    decoder_ = absl::make_unique<
+        utils::concurrency::StreamProcessor<RawBatch, DecodedBatch>>(
+        "TFExampleDecoder", kNumDecodingThreads,
+        [this](RawBatch batch) -> DecodedBatch { return DecodeBatch(batch); },
+        /*result_in_order=*/true);
+    for (int i = 0; i < kMaxPendingDecodingBatches; i++) {
+      batch_tokens_.Push(1);
+    }
+    decoder_->StartWorkers();
+    producer_ = absl::make_unique<utils::concurrency::Thread>(
+        [this]() { ProducerLoop(); });
+    return absl::OkStatus();
+  }
+
   tf_reader_ = CreateReader();
   RETURN_IF_ERROR(tf_reader_->Open(sharded_path));
   return absl::OkStatus();
@@ -261,15 +299,91 @@ absl::Status TFExampleReaderToExampleReader::Open(
 
 utils::StatusOr<bool> TFExampleReaderToExampleReader::Next(
     proto::Example* example) {
+  if (decoder_ != nullptr) {
+    return NextParallel(example);
+  }
   ASSIGN_OR_RETURN(bool did_read, tf_reader_->Next(&tfexample_buffer_));
   if (!did_read) {
     return false;
   }
-  RETURN_IF_ERROR(
-      TfExampleToYdfExample(tfexample_buffer_, data_spec_, example));
+  RETURN_IF_ERROR(TfExampleToYdfExample(tfexample_buffer_, data_spec_, example,
+                                        load_columns_));
   return true;
 }
 
+utils::StatusOr<bool> TFExampleReaderToExampleReader::NextParallel(
+    proto::Example* example) {
+  while (decoded_batch_next_idx_ >= decoded_batch_.size()) {
+    auto result = decoder_->GetResult();
+    if (!result.has_value()) {
+      // All the records have been decoded.
+      RETURN_IF_ERROR(producer_status_);
+      return false;
+    }
+    ASSIGN_OR_RETURN(decoded_batch_, std::move(result).value());
+    decoded_batch_next_idx_ = 0;
+    // Return the batch slot to the producer.
+    batch_tokens_.Push(1);
+  }
+  *example = std::move(decoded_batch_[decoded_batch_next_idx_]);
+  decoded_batch_next_idx_++;
+  return true;
+}
+
+TFExampleReaderToExampleReader::DecodedBatch
+TFExampleReaderToExampleReader::DecodeBatch(const RawBatch& batch) const {
+  std::vector<proto::Example> examples(batch.size());
+  tensorflow::Example tf_example;
+  for (size_t record_idx = 0; record_idx < batch.size(); record_idx++) {
+    const std::string& record = batch[record_idx];
+    if (!tf_example.ParseFromArray(record.data(), record.size())) {
+      return absl::InvalidArgumentError("Cannot parse tf.Example record.");
+    }
+    RETURN_IF_ERROR(TfExampleToYdfExample(
+        tf_example, data_spec_, &examples[record_idx], load_columns_));
+  }
+  return examples;
+}
+
+void TFExampleReaderToExampleReader::ProducerLoop() {
+  while (batch_tokens_.Pop().has_value()) {
+    RawBatch batch;
+    batch.reserve(kDecodingBatchSize);
+    bool end_of_records = false;
+    while (batch.size() < kDecodingBatchSize) {
+      std::string record;
+      const auto has_record = raw_reader_->Next(&record);
+      if (!has_record.ok()) {
+        producer_status_ = has_record.status();
+        end_of_records = true;
+        break;
+      }
+      if (!has_record.value()) {
+        end_of_records = true;
+        break;
+      }
+      batch.push_back(std::move(record));
+    }
+    if (!batch.empty()) {
+      decoder_->Submit(std::move(batch));
+    }
+    if (end_of_records) {
+      break;
+    }
+  }
+  decoder_->CloseSubmits();
+}
+
+void TFExampleReaderToExampleReader::StopWorkers() {
+  if (producer_ == nullptr) {
+    return;
+  }
+  batch_tokens_.Close();  // Wakes-up and stops the producer thread.
+  producer_->Join();
+  producer_.reset();
+  decoder_->JoinAllAndStopThreads();
+}
+
 absl::Status TFExampleReaderToDataSpecCreator::InferColumnsAndTypes(
     const std::vector<std::string>& paths,
     const proto::DataSpecificationGuide& guide,
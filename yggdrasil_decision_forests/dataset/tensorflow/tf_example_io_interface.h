@@ -55,6 +55,8 @@
 #include "yggdrasil_decision_forests/dataset/example_reader_interface.h"
 #include "yggdrasil_decision_forests/dataset/example_writer_interface.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/registration.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
 
@@ -94,19 +96,74 @@ class TFExampleReaderToExampleReader : public ExampleReaderInterface {
  public:
   virtual std::unique_ptr<AbstractTFExampleReader> CreateReader() = 0;
 
+  // Reader of the raw (serialized) tf.Example records of the format, if
+  // available. When provided, "Next" parses and decodes the records in
+  // parallel batches on worker threads while preserving the record order.
+  // Formats without raw record access return nullptr and are decoded
+  // sequentially on the calling thread.
+  virtual std::unique_ptr<utils::ShardedReader<std::string>> CreateRawReader() {
+    return nullptr;
+  }
+
   TFExampleReaderToExampleReader(
       const proto::DataSpecification& data_spec,
       absl::optional<std::vector<int>> ensure_non_missing);
 
+  ~TFExampleReaderToExampleReader() override;
+
   absl::Status Open(absl::string_view sharded_path) override;
 
   utils::StatusOr<bool> Next(proto::Example* example) override;
 
+  void SetLoadColumns(const std::vector<int>& load_columns) override {
+    load_columns_ = load_columns;
+  }
+
  private:
+  // Batch of raw (serialized) tf.Example records, and its decoded result.
+  using RawBatch = std::vector<std::string>;
+  using DecodedBatch = utils::StatusOr<std::vector<proto::Example>>;
+
+  // Retrieves the next example from the parallel decoding pipeline.
+  utils::StatusOr<bool> NextParallel(proto::Example* example);
+
+  // Parses and converts a batch of raw records. Runs on the decoder threads.
+  DecodedBatch DecodeBatch(const RawBatch& batch) const;
+
+  // Reads the raw records into batches and feeds the decoder. Runs on the
+  // producer thread.
+  void ProducerLoop();
+
+  // Stops the producer thread and the decoder workers, if any.
+  void StopWorkers();
+
+  // Sequential decoding path.
   std::unique_ptr<AbstractTFExampleReader> tf_reader_;
   tensorflow::Example tfexample_buffer_;
+
   const proto::DataSpecification data_spec_;
   const absl::optional<std::vector<int>> ensure_non_missing_;
+
+  // If set, only decode this subset of columns. The other columns are left
+  // unset in the generated examples.
+  absl::optional<std::vector<int>> load_columns_;
+
+  // Parallel decoding pipeline (see "CreateRawReader"). "raw_reader_" is only
+  // accessed by the producer thread after "Open". Each in-flight batch holds
+  // one token of "batch_tokens_": back pressure on the producer.
+  std::unique_ptr<utils::ShardedReader<std::string>> raw_reader_;
+  std::unique_ptr<utils::concurrency::StreamProcessor<RawBatch, DecodedBatch>>
+      decoder_;
+  utils::concurrency::Channel<int> batch_tokens_;
+  std::unique_ptr<utils::concurrency::Thread> producer_;
+
+  // Raw reading error. Written by the producer thread; only read by the
+  // consumer after the decoder closed its result channel.
+  absl::Status producer_status_;
+
+  // Batch currently consumed by "Next", and the read position inside of it.
+  std::vector<proto::Example> decoded_batch_;
+  size_t decoded_batch_next_idx_ = 0;
 };
 
 // Wrapper around a TFExampleReader with the signature of an dataspec generator.
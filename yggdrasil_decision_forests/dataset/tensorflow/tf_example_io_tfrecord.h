@@ -50,6 +50,11 @@ class TFRecordTFEToExampleReaderInterface
   std::unique_ptr<AbstractTFExampleReader> CreateReader() override {
     return absl::make_unique<TFRecordTFExampleReader>();
   }
+
+  std::unique_ptr<utils::ShardedReader<std::string>> CreateRawReader()
+      override {
+    return absl::make_unique<utils::TFRecordRawShardedReader>();
+  }
 };
 REGISTER_ExampleReaderInterface(TFRecordTFEToExampleReaderInterface,
                                 "FORMAT_TFE_TFRECORD");
@@ -16,7 +16,9 @@
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <iterator>
 #include <memory>
 #include <numeric>
@@ -54,6 +56,32 @@ namespace {
 constexpr char kNaSymbol[] = "NA";  // NA=non-available i.e. missing value.
 constexpr char kEmptySymbol[] = "EMPTY";
 
+// Rounds a float32 to bfloat16 (to nearest, ties to even).
+uint16_t ToBFloat16(const float value) {
+  if (std::isnan(value)) {
+    // Quiet NaN. The 16 high bits of a NaN can have an empty mantissa (i.e.
+    // be an infinity).
+    return 0x7FC0;
+  }
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint16_t rounded = (bits + 0x7FFF + ((bits >> 16) & 1)) >> 16;
+  if ((rounded & 0x7FFF) == 0x7F80 && !std::isinf(value)) {
+    // Rounding overflowed a large finite value to infinity: truncate to the
+    // largest finite bfloat16 instead.
+    return bits >> 16;
+  }
+  return rounded;
+}
+
+// Widens a bfloat16 to float32 (exact).
+float FromBFloat16(const uint16_t value) {
+  const uint32_t bits = static_cast<uint32_t>(value) << 16;
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
 utils::StatusOr<std::unique_ptr<VerticalDataset::AbstractColumn>> CreateColumn(
     const proto::ColumnType type, const absl::string_view column_name) {
   std::unique_ptr<VerticalDataset::AbstractColumn> col;
@@ -830,6 +858,318 @@ std::string VerticalDataset::CategoricalListColumn::ToStringWithDigitPrecision(
   return rep;
 }
 
+utils::StatusOr<std::unique_ptr<VerticalDataset::CompressedCategoricalColumn>>
+VerticalDataset::CompressedCategoricalColumn::Compress(
+    const CategoricalColumn& column, const int64_t number_of_unique_values) {
+  // The code 0 is reserved for NA.
+  const int64_t num_codes = number_of_unique_values + 1;
+  if (num_codes > 65536) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("The vocabulary of the column \"", column.name(),
+                     "\" does not fit on two bytes."));
+  }
+  auto compressed = absl::make_unique<CompressedCategoricalColumn>();
+  compressed->set_name(column.name());
+  compressed->nrows_ = column.nrows();
+  compressed->code_bytes_ = (num_codes > 256) ? 2 : 1;
+
+  const auto& values = column.values();
+  int64_t num_runs = 0;
+  for (row_t row = 0; row < values.size(); row++) {
+    if (values[row] < CategoricalColumn::kNaValue ||
+        values[row] >= num_codes - 1) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Out of vocabulary value ", values[row],
+                       " in the column \"", column.name(), "\"."));
+    }
+    if (row == 0 || values[row] != values[row - 1]) {
+      num_runs++;
+    }
+  }
+
+  const auto add_code = [&compressed](const int32_t value) {
+    if (compressed->code_bytes_ == 1) {
+      compressed->codes8_.push_back(value + 1);
+    } else {
+      compressed->codes16_.push_back(value + 1);
+    }
+  };
+
+  // Run-length encode the codes iif. it is smaller than one code per row.
+  const uint64_t dense_size = values.size() * compressed->code_bytes_;
+  const uint64_t run_size =
+      num_runs * (sizeof(row_t) + compressed->code_bytes_);
+  if (run_size < dense_size) {
+    compressed->run_first_rows_.reserve(num_runs);
+    for (row_t row = 0; row < values.size(); row++) {
+      if (row == 0 || values[row] != values[row - 1]) {
+        compressed->run_first_rows_.push_back(row);
+        add_code(values[row]);
+      }
+    }
+  } else {
+    for (const auto value : values) {
+      add_code(value);
+    }
+  }
+  return std::move(compressed);
+}
+
+std::unique_ptr<VerticalDataset::CategoricalColumn>
+VerticalDataset::CompressedCategoricalColumn::Decompress() const {
+  auto column = absl::make_unique<CategoricalColumn>();
+  column->set_name(name());
+  auto& values = *column->mutable_values();
+  values.resize(nrows_);
+  if (run_length_encoded()) {
+    for (size_t run_idx = 0; run_idx < run_first_rows_.size(); run_idx++) {
+      const row_t begin_row = run_first_rows_[run_idx];
+      const row_t end_row = (run_idx + 1 < run_first_rows_.size())
+                                ? run_first_rows_[run_idx + 1]
+                                : nrows_;
+      const int32_t run_value =
+          ((code_bytes_ == 1) ? codes8_[run_idx] : codes16_[run_idx]) - 1;
+      std::fill(values.begin() + begin_row, values.begin() + end_row,
+                run_value);
+    }
+  } else {
+    for (row_t row = 0; row < nrows_; row++) {
+      values[row] = value(row);
+    }
+  }
+  return column;
+}
+
+int32_t VerticalDataset::CompressedCategoricalColumn::value(
+    const row_t row) const {
+  DCHECK_LT(row, nrows_);
+  size_t code_idx = row;
+  if (run_length_encoded()) {
+    // Index of the run containing "row".
+    code_idx = std::upper_bound(run_first_rows_.begin(), run_first_rows_.end(),
+                                row) -
+               run_first_rows_.begin() - 1;
+  }
+  if (code_bytes_ == 1) {
+    return static_cast<int32_t>(codes8_[code_idx]) - 1;
+  } else {
+    return static_cast<int32_t>(codes16_[code_idx]) - 1;
+  }
+}
+
+std::string
+VerticalDataset::CompressedCategoricalColumn::ToStringWithDigitPrecision(
+    const row_t row, const proto::Column& col_spec, int digit_precision) const {
+  if (IsNa(row)) {
+    return kNaSymbol;
+  }
+  if (col_spec.categorical().is_already_integerized()) {
+    return absl::StrCat(value(row));
+  } else {
+    return CategoricalIdxToRepresentation(col_spec, value(row));
+  }
+}
+
+void VerticalDataset::CompressedCategoricalColumn::ExtractExample(
+    const row_t example_idx, proto::Example::Attribute* attribute) const {
+  if (IsNa(example_idx)) {
+    return;
+  }
+  attribute->set_categorical(value(example_idx));
+}
+
+template <typename Indices>
+absl::Status
+VerticalDataset::CompressedCategoricalColumn::ExtractAndAppendTemplate(
+    const Indices& indices, AbstractColumn* dst) const {
+  auto* cast_dst = dynamic_cast<CategoricalColumn*>(dst);
+  STATUS_CHECK(cast_dst != nullptr);
+  cast_dst->Reserve(cast_dst->nrows() + indices.size());
+  for (const auto row_idx : indices) {
+    DCHECK_LT(row_idx, nrows_);
+    cast_dst->Add(value(row_idx));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status VerticalDataset::CompressedCategoricalColumn::ExtractAndAppend(
+    const std::vector<row_t>& indices, AbstractColumn* dst) const {
+  return ExtractAndAppendTemplate(indices, dst);
+}
+
+absl::Status VerticalDataset::CompressedCategoricalColumn::ExtractAndAppend(
+    const std::vector<uint32_t>& indices, AbstractColumn* dst) const {
+  return ExtractAndAppendTemplate(indices, dst);
+}
+
+absl::Status
+VerticalDataset::CompressedCategoricalColumn::ConvertToGivenDataspec(
+    AbstractColumn* dst, const proto::Column& src_spec,
+    const proto::Column& dst_spec) const {
+  return Decompress()->ConvertToGivenDataspec(dst, src_spec, dst_spec);
+}
+
+std::pair<uint64_t, uint64_t>
+VerticalDataset::CompressedCategoricalColumn::memory_usage() const {
+  return std::pair<uint64_t, uint64_t>(
+      codes8_.size() * sizeof(uint8_t) + codes16_.size() * sizeof(uint16_t) +
+          run_first_rows_.size() * sizeof(row_t),
+      codes8_.capacity() * sizeof(uint8_t) +
+          codes16_.capacity() * sizeof(uint16_t) +
+          run_first_rows_.capacity() * sizeof(row_t));
+}
+
+void VerticalDataset::CompressedCategoricalColumn::ShrinkToFit() {
+  codes8_.shrink_to_fit();
+  codes16_.shrink_to_fit();
+  run_first_rows_.shrink_to_fit();
+}
+
+void VerticalDataset::CompressedCategoricalColumn::FailReadOnly() const {
+  LOG(FATAL) << "The compressed column \"" << name()
+             << "\" is read-only. Decompress it (e.g. with "
+                "MutableColumnWithCastWithStatus<CategoricalColumn>) before "
+                "modifying it.";
+}
+
+void VerticalDataset::CompressedCategoricalColumn::AddNA() { FailReadOnly(); }
+
+void VerticalDataset::CompressedCategoricalColumn::SetNA(const row_t row) {
+  FailReadOnly();
+}
+
+void VerticalDataset::CompressedCategoricalColumn::Resize(const row_t row) {
+  FailReadOnly();
+}
+
+void VerticalDataset::CompressedCategoricalColumn::Reserve(const row_t row) {
+  FailReadOnly();
+}
+
+void VerticalDataset::CompressedCategoricalColumn::AddFromExample(
+    const proto::Example::Attribute& attribute) {
+  FailReadOnly();
+}
+
+void VerticalDataset::CompressedCategoricalColumn::Set(
+    const row_t example_idx, const proto::Example::Attribute& attribute) {
+  FailReadOnly();
+}
+
+std::unique_ptr<VerticalDataset::BFloat16NumericalColumn>
+VerticalDataset::BFloat16NumericalColumn::Compress(
+    const NumericalColumn& column) {
+  auto compressed = absl::make_unique<BFloat16NumericalColumn>();
+  compressed->set_name(column.name());
+  compressed->values16_.reserve(column.nrows());
+  for (const float value : column.values()) {
+    compressed->values16_.push_back(ToBFloat16(value));
+  }
+  return compressed;
+}
+
+std::unique_ptr<VerticalDataset::NumericalColumn>
+VerticalDataset::BFloat16NumericalColumn::Decompress() const {
+  auto column = absl::make_unique<NumericalColumn>();
+  column->set_name(name());
+  auto& values = *column->mutable_values();
+  values.reserve(values16_.size());
+  for (const uint16_t value16 : values16_) {
+    values.push_back(FromBFloat16(value16));
+  }
+  return column;
+}
+
+float VerticalDataset::BFloat16NumericalColumn::value(const row_t row) const {
+  DCHECK_LT(row, values16_.size());
+  return FromBFloat16(values16_[row]);
+}
+
+std::string
+VerticalDataset::BFloat16NumericalColumn::ToStringWithDigitPrecision(
+    const row_t row, const proto::Column& col_spec, int digit_precision) const {
+  return absl::StrFormat("%.*g", digit_precision, value(row));
+}
+
+void VerticalDataset::BFloat16NumericalColumn::ExtractExample(
+    const row_t example_idx, proto::Example::Attribute* attribute) const {
+  if (IsNa(example_idx)) {
+    return;
+  }
+  attribute->set_numerical(value(example_idx));
+}
+
+template <typename Indices>
+absl::Status
+VerticalDataset::BFloat16NumericalColumn::ExtractAndAppendTemplate(
+    const Indices& indices, AbstractColumn* dst) const {
+  auto* cast_dst = dynamic_cast<NumericalColumn*>(dst);
+  STATUS_CHECK(cast_dst != nullptr);
+  cast_dst->Reserve(cast_dst->nrows() + indices.size());
+  for (const auto row_idx : indices) {
+    DCHECK_LT(row_idx, values16_.size());
+    cast_dst->Add(value(row_idx));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status VerticalDataset::BFloat16NumericalColumn::ExtractAndAppend(
+    const std::vector<row_t>& indices, AbstractColumn* dst) const {
+  return ExtractAndAppendTemplate(indices, dst);
+}
+
+absl::Status VerticalDataset::BFloat16NumericalColumn::ExtractAndAppend(
+    const std::vector<uint32_t>& indices, AbstractColumn* dst) const {
+  return ExtractAndAppendTemplate(indices, dst);
+}
+
+absl::Status VerticalDataset::BFloat16NumericalColumn::ConvertToGivenDataspec(
+    AbstractColumn* dst, const proto::Column& src_spec,
+    const proto::Column& dst_spec) const {
+  return Decompress()->ConvertToGivenDataspec(dst, src_spec, dst_spec);
+}
+
+std::pair<uint64_t, uint64_t>
+VerticalDataset::BFloat16NumericalColumn::memory_usage() const {
+  return std::pair<uint64_t, uint64_t>(
+      values16_.size() * sizeof(uint16_t),
+      values16_.capacity() * sizeof(uint16_t));
+}
+
+void VerticalDataset::BFloat16NumericalColumn::ShrinkToFit() {
+  values16_.shrink_to_fit();
+}
+
+void VerticalDataset::BFloat16NumericalColumn::FailReadOnly() const {
+  LOG(FATAL) << "The bfloat16 column \"" << name()
+             << "\" is read-only. Decompress it (e.g. with "
+                "MutableColumnWithCastWithStatus<NumericalColumn>) before "
+                "modifying it.";
+}
+
+void VerticalDataset::BFloat16NumericalColumn::AddNA() { FailReadOnly(); }
+
+void VerticalDataset::BFloat16NumericalColumn::SetNA(const row_t row) {
+  FailReadOnly();
+}
+
+void VerticalDataset::BFloat16NumericalColumn::Resize(const row_t row) {
+  FailReadOnly();
+}
+
+void VerticalDataset::BFloat16NumericalColumn::Reserve(const row_t row) {
+  FailReadOnly();
+}
+
+void VerticalDataset::BFloat16NumericalColumn::AddFromExample(
+    const proto::Example::Attribute& attribute) {
+  FailReadOnly();
+}
+
+void VerticalDataset::BFloat16NumericalColumn::Set(
+    const row_t example_idx, const proto::Example::Attribute& attribute) {
+  FailReadOnly();
+}
 
 utils::StatusOr<VerticalDataset> VerticalDataset::ConvertToGivenDataspec(
     const proto::DataSpecification& new_data_spec,
@@ -868,10 +1208,36 @@ utils::StatusOr<VerticalDataset> VerticalDataset::ConvertToGivenDataspec(
   return std::move(new_dataset);
 }
 
-absl::Status VerticalDataset::Append(const VerticalDataset& src) {
-  std::vector<row_t> indices(src.nrow());
+absl::Status VerticalDataset::AbstractColumn::AppendColumnContent(
+    const AbstractColumn& src) {
+  // Generic fallback: extract all the rows of "src" one by one. The
+  // vector-backed columns override this function with a bulk concatenation of
+  // their storage.
+  std::vector<row_t> indices(src.nrows());
   std::iota(indices.begin(), indices.end(), 0);
-  return Append(src, indices);
+  return src.ExtractAndAppend(indices, this);
+}
+
+absl::Status VerticalDataset::Append(const VerticalDataset& src) {
+  if (columns_.empty()) {
+    data_spec_ = src.data_spec();
+    RETURN_IF_ERROR(CreateColumnsFromDataspec());
+  }
+  // Note: "MessageDifferencer" is too slow.
+  if (src.data_spec().ShortDebugString() != data_spec().ShortDebugString()) {
+    return absl::InvalidArgumentError(
+        "The source and destination datasets should have the same dataspec.");
+  }
+  nrow_ += src.nrow();
+  for (int col_idx = 0; col_idx < ncol(); col_idx++) {
+    // Columns without values (e.g. non-loaded columns) are left empty.
+    if (src.column(col_idx)->nrows() == 0) {
+      continue;
+    }
+    RETURN_IF_ERROR(
+        mutable_column(col_idx)->AppendColumnContent(*src.column(col_idx)));
+  }
+  return absl::OkStatus();
 }
 
 absl::Status VerticalDataset::Append(const VerticalDataset& src,
@@ -967,7 +1333,7 @@ void VerticalDataset::Reserve(
   }
 }
 
-std::string VerticalDataset::MemorySummary() const {
+std::pair<uint64_t, uint64_t> VerticalDataset::memory_usage() const {
   uint64_t usage = 0;
   uint64_t reserved = 0;
   for (int col_idx = 0; col_idx < ncol(); col_idx++) {
@@ -975,9 +1341,14 @@ std::string VerticalDataset::MemorySummary() const {
     usage += col_mem.first;
     reserved += col_mem.second;
   }
+  return std::make_pair(usage, reserved);
+}
+
+std::string VerticalDataset::MemorySummary() const {
+  const auto memory = memory_usage();
   const uint64_t scale = 1e6;
-  return absl::StrFormat("usage:%dMB allocated:%dMB", usage / scale,
-                         reserved / scale);
+  return absl::StrFormat("usage:%dMB allocated:%dMB", memory.first / scale,
+                         memory.second / scale);
 }
 
 void VerticalDataset::ShrinkToFit() {
@@ -986,5 +1357,67 @@ void VerticalDataset::ShrinkToFit() {
   }
 }
 
+absl::Status VerticalDataset::CompressCategoricalColumns() {
+  for (int col_idx = 0; col_idx < ncol(); col_idx++) {
+    if (!OwnsColumn(col_idx)) {
+      continue;
+    }
+    const auto* categorical_column =
+        dynamic_cast<const CategoricalColumn*>(column(col_idx));
+    if (categorical_column == nullptr) {
+      continue;
+    }
+    auto compressed_or = CompressedCategoricalColumn::Compress(
+        *categorical_column,
+        data_spec_.columns(col_idx).categorical().number_of_unique_values());
+    if (!compressed_or.ok()) {
+      // E.g. the vocabulary does not fit on two bytes.
+      continue;
+    }
+    auto compressed = std::move(compressed_or.value());
+    if (compressed->memory_usage().first >=
+        categorical_column->memory_usage().first) {
+      continue;
+    }
+    columns_[col_idx].column = compressed.get();
+    columns_[col_idx].owned_column = std::move(compressed);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status VerticalDataset::CompressNumericalColumns() {
+  for (int col_idx = 0; col_idx < ncol(); col_idx++) {
+    if (!OwnsColumn(col_idx)) {
+      continue;
+    }
+    const auto* numerical_column =
+        dynamic_cast<const NumericalColumn*>(column(col_idx));
+    if (numerical_column == nullptr) {
+      continue;
+    }
+    auto compressed = BFloat16NumericalColumn::Compress(*numerical_column);
+    columns_[col_idx].column = compressed.get();
+    columns_[col_idx].owned_column = std::move(compressed);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status VerticalDataset::DecompressColumnIfCompressed(const int col) {
+  std::unique_ptr<AbstractColumn> decompressed;
+  if (const auto* compressed =
+          dynamic_cast<const CompressedCategoricalColumn*>(column(col))) {
+    decompressed = compressed->Decompress();
+  } else if (const auto* bfloat16_column =
+                 dynamic_cast<const BFloat16NumericalColumn*>(column(col))) {
+    decompressed = bfloat16_column->Decompress();
+  } else {
+    return absl::OkStatus();
+  }
+  STATUS_CHECK(OwnsColumn(col));
+  columns_[col].column = decompressed.get();
+  columns_[col].owned_column = std::move(decompressed);
+  return absl::OkStatus();
+}
+
 }  // namespace dataset
 }  // namespace yggdrasil_decision_forests
@@ -37,6 +37,7 @@
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
@@ -54,6 +55,15 @@ class VerticalDataset {
   // Row index type.
   typedef int64_t row_t;
 
+  VerticalDataset() = default;
+  VerticalDataset(VerticalDataset&&) = default;
+  VerticalDataset& operator=(VerticalDataset&&) = default;
+
+  // Datasets cannot be copied implicitly. Use "Extract" to copy a subset of
+  // rows, or "ShallowNonOwningClone" to share the columns.
+  VerticalDataset(const VerticalDataset&) = delete;
+  VerticalDataset& operator=(const VerticalDataset&) = delete;
+
   // Abstract representation of a column.
   class AbstractColumn {
    public:
@@ -117,6 +127,12 @@ class VerticalDataset {
     virtual absl::Status ExtractAndAppend(const std::vector<uint32_t>& indices,
                                           AbstractColumn* dst) const = 0;
 
+    // Appends all the values of "src" (a column of the same concrete type) to
+    // this column. The vector-backed columns override this function with a
+    // bulk concatenation of their storage, which is considerably faster than
+    // the generic row-by-row fallback.
+    virtual absl::Status AppendColumnContent(const AbstractColumn& src);
+
     // Converts the content of a column to another dataspec.
     virtual absl::Status ConvertToGivenDataspec(
         AbstractColumn* dst, const proto::Column& src_spec,
@@ -161,6 +177,11 @@ class VerticalDataset {
     // Add a value.
     void Add(const T& value) { values_.push_back(value); }
 
+    // Add a batch of values.
+    void AddBatch(const absl::Span<const T> values) {
+      values_.insert(values_.end(), values.begin(), values.end());
+    }
+
     // Access to values.
     const std::vector<T>& values() const { return values_; }
     std::vector<T>* mutable_values() { return &values_; }
@@ -171,6 +192,15 @@ class VerticalDataset {
     absl::Status ExtractAndAppend(const std::vector<uint32_t>& indices,
                                   AbstractColumn* dst) const override;
 
+    absl::Status AppendColumnContent(const AbstractColumn& src) override {
+      const auto* cast_src =
+          dynamic_cast<const TemplateScalarStorage<T>*>(&src);
+      STATUS_CHECK(cast_src != nullptr);
+      values_.insert(values_.end(), cast_src->values_.begin(),
+                     cast_src->values_.end());
+      return absl::OkStatus();
+    }
+
     std::pair<uint64_t, uint64_t> memory_usage() const override {
       return std::pair<uint64_t, uint64_t>(values_.size() * sizeof(T),
                                            values_.capacity() * sizeof(T));
@@ -226,6 +256,23 @@ class VerticalDataset {
     absl::Status ExtractAndAppend(const std::vector<uint32_t>& indices,
                                   AbstractColumn* dst) const override;
 
+    absl::Status AppendColumnContent(const AbstractColumn& src) override {
+      const auto* cast_src =
+          dynamic_cast<const TemplateMultiValueStorage<T>*>(&src);
+      STATUS_CHECK(cast_src != nullptr);
+      const size_t bank_offset = bank_.size();
+      bank_.insert(bank_.end(), cast_src->bank_.begin(),
+                   cast_src->bank_.end());
+      values_.reserve(values_.size() + cast_src->values_.size());
+      for (const auto& value : cast_src->values_) {
+        // Note: The NA (begin > end) and empty (begin == end) encodings are
+        // preserved by the offset.
+        values_.emplace_back(value.first + bank_offset,
+                             value.second + bank_offset);
+      }
+      return absl::OkStatus();
+    }
+
     const std::vector<std::pair<size_t, size_t>>& values() const {
       return values_;
     }
@@ -409,6 +456,180 @@ class VerticalDataset {
     static constexpr int kNaValue = -1;
   };
 
+  // Read-only compact storage of a categorical column.
+  //
+  // The values are dictionary encoded on one or two bytes (chosen from the
+  // vocabulary size), optionally followed by a run-length encoding of the
+  // codes when it further reduces the memory usage. Created with
+  // "VerticalDataset::CompressCategoricalColumns".
+  //
+  // The column cannot be modified. However, requesting a mutable
+  // "CategoricalColumn" through "MutableColumnWithCastWithStatus" (or the
+  // other mutable cast accessors) transparently replaces the compressed
+  // column with its decompressed version in the dataset.
+  class CompressedCategoricalColumn : public AbstractColumn {
+   public:
+    proto::ColumnType type() const override {
+      return proto::ColumnType::CATEGORICAL;
+    }
+
+    // Compresses "column". "number_of_unique_values" is the vocabulary size
+    // defined in the dataspec. Fails if the values do not fit on two bytes.
+    static utils::StatusOr<std::unique_ptr<CompressedCategoricalColumn>>
+    Compress(const CategoricalColumn& column, int64_t number_of_unique_values);
+
+    // Rebuilds the regular int32 representation of the column.
+    std::unique_ptr<CategoricalColumn> Decompress() const;
+
+    // Value of a row. Same semantic as "CategoricalColumn::values()[row]"
+    // i.e. "kNaValue" represents a missing value.
+    int32_t value(row_t row) const;
+
+    // True iif. the codes are run-length encoded.
+    bool run_length_encoded() const { return !run_first_rows_.empty(); }
+
+    std::string ToStringWithDigitPrecision(const row_t row,
+                                           const proto::Column& col_spec,
+                                           int digit_precision) const override;
+
+    bool IsNa(const row_t row) const override {
+      return value(row) == CategoricalColumn::kNaValue;
+    }
+
+    row_t nrows() const override { return nrows_; }
+
+    void ExtractExample(row_t example_idx,
+                        proto::Example::Attribute* attribute) const override;
+
+    absl::Status ExtractAndAppend(const std::vector<row_t>& indices,
+                                  AbstractColumn* dst) const override;
+
+    absl::Status ExtractAndAppend(const std::vector<uint32_t>& indices,
+                                  AbstractColumn* dst) const override;
+
+    absl::Status ConvertToGivenDataspec(
+        AbstractColumn* dst, const proto::Column& src_spec,
+        const proto::Column& dst_spec) const override;
+
+    std::pair<uint64_t, uint64_t> memory_usage() const override;
+
+    void ShrinkToFit() override;
+
+    // The column is read-only: the following operations fail. Decompress the
+    // column to modify it.
+    void AddNA() override;
+    void SetNA(const row_t row) override;
+    void Resize(const row_t row) override;
+    void Reserve(const row_t row) override;
+    void AddFromExample(const proto::Example::Attribute& attribute) override;
+    void Set(row_t example_idx,
+             const proto::Example::Attribute& attribute) override;
+
+   private:
+    // Appends the decoded values at "indices" to "dst".
+    template <typename Indices>
+    absl::Status ExtractAndAppendTemplate(const Indices& indices,
+                                          AbstractColumn* dst) const;
+
+    // Fails with an error message explaining that the column is read-only.
+    void FailReadOnly() const;
+
+    // Number of rows.
+    row_t nrows_ = 0;
+
+    // Number of bytes of each code (1 or 2). The code 0 represents NA, and
+    // the code "c>0" represents the value "c-1".
+    int code_bytes_ = 1;
+
+    // Dictionary codes; one per row, or one per run if the column is
+    // run-length encoded. Only the vector matching "code_bytes_" is used.
+    std::vector<uint8_t> codes8_;
+    std::vector<uint16_t> codes16_;
+
+    // If non-empty, the column is run-length encoded and "run_first_rows_[i]"
+    // is the first row of the i-th run i.e. the run with the i-th code.
+    // "run_first_rows_[0]" is always 0.
+    std::vector<row_t> run_first_rows_;
+  };
+
+  // Read-only bfloat16 storage of a numerical column.
+  //
+  // The values are stored as bfloat16 i.e. float32 values rounded (to
+  // nearest, ties to even) to 8 bits of mantissa. This halves the memory
+  // footprint and bandwidth of the column while retaining ~2 significant
+  // decimal digits. Missing values (NaNs) are preserved. Created with
+  // "VerticalDataset::CompressNumericalColumns".
+  //
+  // The column cannot be modified. Like for "CompressedCategoricalColumn",
+  // requesting a mutable "NumericalColumn" through a mutable cast accessor
+  // transparently replaces the column with its (rounded) float32 version.
+  class BFloat16NumericalColumn : public AbstractColumn {
+   public:
+    proto::ColumnType type() const override {
+      return proto::ColumnType::NUMERICAL;
+    }
+
+    // Rounds "column" to bfloat16.
+    static std::unique_ptr<BFloat16NumericalColumn> Compress(
+        const NumericalColumn& column);
+
+    // Rebuilds a float32 representation of the column. The low mantissa bits
+    // lost by "Compress" are zero.
+    std::unique_ptr<NumericalColumn> Decompress() const;
+
+    // Value of a row, widened to float32.
+    float value(row_t row) const;
+
+    std::string ToStringWithDigitPrecision(const row_t row,
+                                           const proto::Column& col_spec,
+                                           int digit_precision) const override;
+
+    bool IsNa(const row_t row) const override {
+      return std::isnan(value(row));
+    }
+
+    row_t nrows() const override { return values16_.size(); }
+
+    void ExtractExample(row_t example_idx,
+                        proto::Example::Attribute* attribute) const override;
+
+    absl::Status ExtractAndAppend(const std::vector<row_t>& indices,
+                                  AbstractColumn* dst) const override;
+
+    absl::Status ExtractAndAppend(const std::vector<uint32_t>& indices,
+                                  AbstractColumn* dst) const override;
+
+    absl::Status ConvertToGivenDataspec(
+        AbstractColumn* dst, const proto::Column& src_spec,
+        const proto::Column& dst_spec) const override;
+
+    std::pair<uint64_t, uint64_t> memory_usage() const override;
+
+    void ShrinkToFit() override;
+
+    // The column is read-only: the following operations fail. Decompress the
+    // column to modify it.
+    void AddNA() override;
+    void SetNA(const row_t row) override;
+    void Resize(const row_t row) override;
+    void Reserve(const row_t row) override;
+    void AddFromExample(const proto::Example::Attribute& attribute) override;
+    void Set(row_t example_idx,
+             const proto::Example::Attribute& attribute) override;
+
+   private:
+    // Appends the widened values at "indices" to "dst".
+    template <typename Indices>
+    absl::Status ExtractAndAppendTemplate(const Indices& indices,
+                                          AbstractColumn* dst) const;
+
+    // Fails with an error message explaining that the column is read-only.
+    void FailReadOnly() const;
+
+    // Values; the 16 most significant bits of the float32 representation.
+    std::vector<uint16_t> values16_;
+  };
+
   class NumericalSetColumn : public TemplateMultiValueStorage<float> {
    public:
     proto::ColumnType type() const override {
@@ -527,6 +748,16 @@ class VerticalDataset {
       TemplateScalarStorage::Reserve(row);
       is_na_.reserve(row);
     }
+
+    absl::Status AppendColumnContent(const AbstractColumn& src) override {
+      const auto* cast_src = dynamic_cast<const StringColumn*>(&src);
+      STATUS_CHECK(cast_src != nullptr);
+      RETURN_IF_ERROR(TemplateScalarStorage::AppendColumnContent(src));
+      is_na_.insert(is_na_.end(), cast_src->is_na_.begin(),
+                    cast_src->is_na_.end());
+      return absl::OkStatus();
+    }
+
     void AddFromExample(const proto::Example::Attribute& attribute) override;
 
     void Set(row_t example_idx,
@@ -658,6 +889,13 @@ class VerticalDataset {
   int ColumnNameToColumnIdx(absl::string_view name) const;
 
   // Extract a subset of observations from the dataset.
+  //
+  // The selected rows are copied into new columns, except when "indices"
+  // selects all the rows in order: in this case the columns are shared with
+  // this dataset (owned columns are co-owned; modifying a shared column
+  // affects both datasets) and no copy takes place. A general index-mapped
+  // view is not possible: consumers (e.g. the splitters) read the columns as
+  // contiguous vectors indexed by row.
   template <typename T>
   utils::StatusOr<VerticalDataset> Extract(const std::vector<T>& indices) const;
 
@@ -670,7 +908,9 @@ class VerticalDataset {
       const proto::DataSpecification& new_data_spec,
       const std::vector<int>& required_column_idxs) const;
 
-  // Add the content of the "src" dataset at the end of this dataset.
+  // Add the content of the "src" dataset at the end of this dataset. The
+  // column storage is concatenated in bulk (see "AppendColumnContent").
+  // Columns without values in "src" (e.g. non-loaded columns) are skipped.
   absl::Status Append(const VerticalDataset& src);
   // Add a subset of "src" at the end of this dataset.
   absl::Status Append(const VerticalDataset& src,
@@ -716,6 +956,23 @@ class VerticalDataset {
   void AppendExample(
       const std::unordered_map<std::string, std::string>& example);
 
+  // Appends a batch of values at the end of the scalar column "col". Much
+  // faster than appending the examples one by one with
+  // "AppendExampleWithStatus". The values are expressed in the storage format
+  // of the column e.g. float values with NaN for the missing values in the
+  // case of a "NumericalColumn" (see the "kNaValue" of each column class).
+  // All the columns should be grown by the same number of rows, after which
+  // the caller is responsible for calling "set_nrow".
+  //
+  // Usage example:
+  //   RETURN_IF_ERROR(
+  //       dataset.AppendBatch<dataset::VerticalDataset::NumericalColumn>(
+  //           /*col=*/0, absl::MakeConstSpan(values)));
+  //   dataset.set_nrow(values.size());
+  template <typename Column>
+  absl::Status AppendBatch(int col,
+                           absl::Span<const typename Column::Format> values);
+
   // Create a shallow copy of the dataset. The created dataset does not get
   // ownership of the columns.
   VerticalDataset ShallowNonOwningClone() const;
@@ -733,6 +990,10 @@ class VerticalDataset {
   void Reserve(const row_t num_rows,
                const absl::optional<std::vector<int>>& load_columns = {});
 
+  // Used and reserved memory of the dataset, expressed in bytes. Sum of the
+  // "memory_usage" of the columns.
+  std::pair<uint64_t, uint64_t> memory_usage() const;
+
   // Generates a human readable summary of the memory.
   std::string MemorySummary() const;
 
@@ -742,16 +1003,33 @@ class VerticalDataset {
   // Calls "shrink_to_fit" on the std::vectors.
   void ShrinkToFit();
 
+  // Replaces the owned categorical columns with compressed versions (see
+  // "CompressedCategoricalColumn") when it reduces the memory usage.
+  // Compressed columns are read-only: accessing one through a mutable cast
+  // accessor decompresses it back.
+  absl::Status CompressCategoricalColumns();
+
+  // Replaces the owned numerical columns with bfloat16 versions (see
+  // "BFloat16NumericalColumn"). Warning: the conversion is lossy; the values
+  // are rounded to 8 bits of mantissa.
+  absl::Status CompressNumericalColumns();
+
  private:
+  // If the column "col" is owned and compressed, replaces it with its
+  // decompressed version. Does nothing otherwise.
+  absl::Status DecompressColumnIfCompressed(int col);
+
   struct ColumnContainer {
     // A column can either be owned or not-owned by the VerticalDataset.
     //
     // If the column is owned: "owned_column" and "column" are pointing to the
     // (same) column (owned by "owned_column"). If the column is not owned:
-    // "column" points on the data and "owned_column" is not set.
+    // "column" points on the data and "owned_column" is not set. Ownership of
+    // a column can be shared by several datasets (e.g. "Extract" with an
+    // identity selection).
 
     const AbstractColumn* column;
-    std::unique_ptr<AbstractColumn> owned_column;
+    std::shared_ptr<AbstractColumn> owned_column;
   };
 
   // Columns.
@@ -934,7 +1212,15 @@ utils::StatusOr<T*> VerticalDataset::MutableColumnWithCastWithStatus(int col) {
   static_assert(std::is_base_of<AbstractColumn, T>::value,
                 "The template class argument does not derive  AbstractColumn.");
   auto* abstract_column = mutable_column(col);
-  T* const casted_column = dynamic_cast<T* const>(abstract_column);
+  T* casted_column = dynamic_cast<T* const>(abstract_column);
+  if (!casted_column && (std::is_same<T, CategoricalColumn>::value ||
+                         std::is_same<T, NumericalColumn>::value)) {
+    // The column might be compressed. Decompressing it makes the cast
+    // possible.
+    RETURN_IF_ERROR(DecompressColumnIfCompressed(col));
+    abstract_column = mutable_column(col);
+    casted_column = dynamic_cast<T* const>(abstract_column);
+  }
   if (!casted_column) {
     return absl::InvalidArgumentError(absl::StrCat(
         "Column \"", abstract_column->name(), "\"=", col, " has type ",
@@ -955,12 +1241,48 @@ T* VerticalDataset::MutableColumnWithCastOrNull(int col) {
   static_assert(std::is_base_of<AbstractColumn, T>::value,
                 "The template class argument does not derive  AbstractColumn.");
   auto* abstract_column = mutable_column(col);
-  return dynamic_cast<T* const>(abstract_column);
+  T* casted_column = dynamic_cast<T* const>(abstract_column);
+  if (!casted_column &&
+      (std::is_same<T, CategoricalColumn>::value ||
+       std::is_same<T, NumericalColumn>::value) &&
+      DecompressColumnIfCompressed(col).ok()) {
+    casted_column = dynamic_cast<T* const>(mutable_column(col));
+  }
+  return casted_column;
+}
+
+template <typename Column>
+absl::Status VerticalDataset::AppendBatch(
+    const int col, const absl::Span<const typename Column::Format> values) {
+  ASSIGN_OR_RETURN(auto* column, MutableColumnWithCastWithStatus<Column>(col));
+  column->AddBatch(values);
+  return absl::OkStatus();
 }
 
 template <typename T>
 utils::StatusOr<VerticalDataset> VerticalDataset::Extract(
     const std::vector<T>& indices) const {
+  // Selecting all the rows in order does not require copying the columns.
+  if (static_cast<row_t>(indices.size()) == nrow_) {
+    bool is_identity = true;
+    for (size_t idx = 0; idx < indices.size(); idx++) {
+      if (indices[idx] != static_cast<T>(idx)) {
+        is_identity = false;
+        break;
+      }
+    }
+    if (is_identity) {
+      VerticalDataset shared;
+      shared.data_spec_ = data_spec_;
+      shared.nrow_ = nrow_;
+      shared.columns_.reserve(columns_.size());
+      for (const auto& container : columns_) {
+        shared.columns_.push_back(
+            ColumnContainer{container.column, container.owned_column});
+      }
+      return std::move(shared);
+    }
+  }
   VerticalDataset dst;
   dst.data_spec_ = data_spec_;
   dst.nrow_ = indices.size();
@@ -0,0 +1,418 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_columnar.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_columnar.pb.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
+#include "yggdrasil_decision_forests/utils/sharded_io.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+namespace {
+
+// Version of the columnar file format.
+constexpr int kFormatVersion = 1;
+
+// Alignment of the header and column payloads (in bytes).
+constexpr uint64_t kPayloadAlignment = 8;
+
+// Size of the buffer used to skip over non-seekable streams (in bytes).
+constexpr uint64_t kSkipBufferSizeInBytes = 1 << 20;  // 1MB
+
+// Number of padding bytes following a block of "size" bytes.
+uint64_t PaddingBytes(const uint64_t size) {
+  return (kPayloadAlignment - size % kPayloadAlignment) % kPayloadAlignment;
+}
+
+// Size (in bytes) of a single value of a scalar column.
+utils::StatusOr<uint64_t> ValueSizeBytes(const proto::ColumnType type) {
+  switch (type) {
+    case proto::ColumnType::NUMERICAL:
+      return sizeof(float);
+    case proto::ColumnType::DISCRETIZED_NUMERICAL:
+      return sizeof(DiscretizedNumericalIndex);
+    case proto::ColumnType::CATEGORICAL:
+      return sizeof(int32_t);
+    case proto::ColumnType::BOOLEAN:
+      return sizeof(char);
+    case proto::ColumnType::HASH:
+      return sizeof(uint64_t);
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Non supported column type ",
+                       proto::ColumnType_Name(type), " for columnar datasets"));
+  }
+}
+
+// Raw payload of the rows [begin_row, end_row) of a scalar column.
+template <typename Column>
+utils::StatusOr<absl::string_view> TypedPayload(
+    const VerticalDataset& dataset, const int col_idx,
+    const VerticalDataset::row_t begin_row,
+    const VerticalDataset::row_t end_row) {
+  ASSIGN_OR_RETURN(const auto* column,
+                   dataset.ColumnWithCastWithStatus<Column>(col_idx));
+  using Format = typename Column::Format;
+  return absl::string_view(
+      reinterpret_cast<const char*>(column->values().data() + begin_row),
+      (end_row - begin_row) * sizeof(Format));
+}
+
+utils::StatusOr<absl::string_view> ColumnPayload(
+    const VerticalDataset& dataset, const int col_idx,
+    const VerticalDataset::row_t begin_row,
+    const VerticalDataset::row_t end_row) {
+  switch (dataset.column(col_idx)->type()) {
+    case proto::ColumnType::NUMERICAL:
+      return TypedPayload<VerticalDataset::NumericalColumn>(
+          dataset, col_idx, begin_row, end_row);
+    case proto::ColumnType::DISCRETIZED_NUMERICAL:
+      return TypedPayload<VerticalDataset::DiscretizedNumericalColumn>(
+          dataset, col_idx, begin_row, end_row);
+    case proto::ColumnType::CATEGORICAL:
+      return TypedPayload<VerticalDataset::CategoricalColumn>(
+          dataset, col_idx, begin_row, end_row);
+    case proto::ColumnType::BOOLEAN:
+      return TypedPayload<VerticalDataset::BooleanColumn>(dataset, col_idx,
+                                                          begin_row, end_row);
+    case proto::ColumnType::HASH:
+      return TypedPayload<VerticalDataset::HashColumn>(dataset, col_idx,
+                                                       begin_row, end_row);
+    default:
+      return absl::InvalidArgumentError(absl::StrCat(
+          "Non supported column type ",
+          proto::ColumnType_Name(dataset.column(col_idx)->type()),
+          " of column \"", dataset.column(col_idx)->name(),
+          "\" for columnar datasets"));
+  }
+}
+
+// Grows a scalar column by "payload_bytes" bytes worth of values, and returns
+// the address where the payload should be copied.
+template <typename Column>
+utils::StatusOr<char*> TypedPrepareAppend(VerticalDataset* dataset,
+                                          const int col_idx,
+                                          const uint64_t payload_bytes) {
+  ASSIGN_OR_RETURN(auto* column,
+                   dataset->MutableColumnWithCastWithStatus<Column>(col_idx));
+  using Format = typename Column::Format;
+  auto* values = column->mutable_values();
+  const size_t begin_idx = values->size();
+  values->resize(begin_idx + payload_bytes / sizeof(Format));
+  return reinterpret_cast<char*>(values->data() + begin_idx);
+}
+
+utils::StatusOr<char*> PrepareColumnAppend(VerticalDataset* dataset,
+                                           const int col_idx,
+                                           const proto::ColumnType type,
+                                           const uint64_t payload_bytes) {
+  switch (type) {
+    case proto::ColumnType::NUMERICAL:
+      return TypedPrepareAppend<VerticalDataset::NumericalColumn>(
+          dataset, col_idx, payload_bytes);
+    case proto::ColumnType::DISCRETIZED_NUMERICAL:
+      return TypedPrepareAppend<VerticalDataset::DiscretizedNumericalColumn>(
+          dataset, col_idx, payload_bytes);
+    case proto::ColumnType::CATEGORICAL:
+      return TypedPrepareAppend<VerticalDataset::CategoricalColumn>(
+          dataset, col_idx, payload_bytes);
+    case proto::ColumnType::BOOLEAN:
+      return TypedPrepareAppend<VerticalDataset::BooleanColumn>(
+          dataset, col_idx, payload_bytes);
+    case proto::ColumnType::HASH:
+      return TypedPrepareAppend<VerticalDataset::HashColumn>(dataset, col_idx,
+                                                             payload_bytes);
+    default:
+      return absl::InvalidArgumentError(
+          absl::StrCat("Non supported column type ",
+                       proto::ColumnType_Name(type), " for columnar datasets"));
+  }
+}
+
+// Sequential reader over a shard, either from a memory mapping (if available
+// for this path and platform) or from a stream.
+class ShardSource {
+ public:
+  absl::Status Open(const absl::string_view path) {
+    path_ = std::string(path);
+    ASSIGN_OR_RETURN(use_mmap_, mmap_file_.TryOpen(path));
+    if (!use_mmap_) {
+      RETURN_IF_ERROR(stream_.Open(path));
+    }
+    return absl::OkStatus();
+  }
+
+  // Reads exactly "num_bytes" bytes into "dst".
+  absl::Status ReadInto(char* dst, uint64_t num_bytes) {
+    if (use_mmap_) {
+      if (offset_ + num_bytes > mmap_file_.size()) {
+        return TruncatedError();
+      }
+      std::memcpy(dst, mmap_file_.data() + offset_, num_bytes);
+      offset_ += num_bytes;
+      return absl::OkStatus();
+    }
+    // "ReadExactly" is limited to "int" sizes.
+    while (num_bytes > 0) {
+      const int chunk = std::min<uint64_t>(num_bytes, uint64_t{1} << 30);
+      ASSIGN_OR_RETURN(const bool has_read, stream_.ReadExactly(dst, chunk));
+      if (!has_read) {
+        return TruncatedError();
+      }
+      dst += chunk;
+      num_bytes -= chunk;
+    }
+    return absl::OkStatus();
+  }
+
+  // Skips "num_bytes" bytes.
+  absl::Status Skip(uint64_t num_bytes) {
+    if (use_mmap_) {
+      if (offset_ + num_bytes > mmap_file_.size()) {
+        return TruncatedError();
+      }
+      offset_ += num_bytes;
+      return absl::OkStatus();
+    }
+    std::vector<char> buffer(
+        std::min<uint64_t>(num_bytes, kSkipBufferSizeInBytes));
+    while (num_bytes > 0) {
+      const uint64_t chunk = std::min<uint64_t>(num_bytes, buffer.size());
+      RETURN_IF_ERROR(ReadInto(buffer.data(), chunk));
+      num_bytes -= chunk;
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Close() {
+    if (use_mmap_) {
+      return mmap_file_.Close();
+    }
+    return stream_.Close();
+  }
+
+ private:
+  absl::Status TruncatedError() const {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Truncated columnar dataset shard ", path_));
+  }
+
+  std::string path_;
+  utils::MemoryMappedFile mmap_file_;
+  bool use_mmap_ = false;
+  uint64_t offset_ = 0;
+  file::FileInputByteStream stream_;
+};
+
+// Saves the rows [begin_row, end_row) of the dataset into a shard file.
+absl::Status SaveShard(const VerticalDataset& dataset,
+                       const absl::string_view path,
+                       const VerticalDataset::row_t begin_row,
+                       const VerticalDataset::row_t end_row) {
+  proto::ColumnarShardHeader header;
+  header.set_version(kFormatVersion);
+  header.set_num_rows(end_row - begin_row);
+  for (int col_idx = 0; col_idx < dataset.ncol(); col_idx++) {
+    ASSIGN_OR_RETURN(const auto payload,
+                     ColumnPayload(dataset, col_idx, begin_row, end_row));
+    auto* column = header.add_columns();
+    column->set_name(dataset.column(col_idx)->name());
+    column->set_type(dataset.column(col_idx)->type());
+    column->set_size_bytes(payload.size());
+  }
+  const std::string serialized_header = header.SerializeAsString();
+  const uint64_t header_size = serialized_header.size();
+  const std::string padding(kPayloadAlignment, '\0');
+
+  file::FileOutputByteStream output;
+  RETURN_IF_ERROR(output.Open(path));
+  RETURN_IF_ERROR(
+      output.Write(absl::string_view(reinterpret_cast<const char*>(&header_size),
+                                     sizeof(header_size))));
+  RETURN_IF_ERROR(output.Write(serialized_header));
+  RETURN_IF_ERROR(output.Write(absl::string_view(
+      padding.data(), PaddingBytes(sizeof(header_size) + header_size))));
+  for (int col_idx = 0; col_idx < dataset.ncol(); col_idx++) {
+    ASSIGN_OR_RETURN(const auto payload,
+                     ColumnPayload(dataset, col_idx, begin_row, end_row));
+    RETURN_IF_ERROR(output.Write(payload));
+    RETURN_IF_ERROR(output.Write(
+        absl::string_view(padding.data(), PaddingBytes(payload.size()))));
+  }
+  return output.Close();
+}
+
+// Loads and appends a single shard into the dataset. "load_column" (resp.
+// "required_column") indicates, for each dataspec column, if the column
+// should be loaded (resp. is allowed to be missing from the file).
+absl::Status LoadColumnarShard(const absl::string_view path,
+                               const proto::DataSpecification& data_spec,
+                               const std::vector<bool>& load_column,
+                               const std::vector<bool>& required_column,
+                               VerticalDataset* dataset) {
+  ShardSource source;
+  RETURN_IF_ERROR(source.Open(path));
+
+  // Read the header.
+  uint64_t header_size;
+  RETURN_IF_ERROR(source.ReadInto(reinterpret_cast<char*>(&header_size),
+                                  sizeof(header_size)));
+  std::string serialized_header(header_size, '\0');
+  RETURN_IF_ERROR(source.ReadInto(&serialized_header[0], header_size));
+  RETURN_IF_ERROR(source.Skip(PaddingBytes(sizeof(header_size) + header_size)));
+  proto::ColumnarShardHeader header;
+  if (!header.ParseFromString(serialized_header)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat(path, " is not a columnar dataset shard"));
+  }
+  if (header.version() > kFormatVersion) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        path, " was created with a newer version of the columnar format"));
+  }
+
+  // Read the column payloads.
+  std::vector<bool> found_column(data_spec.columns_size(), false);
+  for (const auto& file_column : header.columns()) {
+    const int col_idx = dataset->ColumnNameToColumnIdx(file_column.name());
+    const uint64_t payload_bytes = file_column.size_bytes();
+    if (col_idx == -1 || !load_column[col_idx]) {
+      RETURN_IF_ERROR(
+          source.Skip(payload_bytes + PaddingBytes(payload_bytes)));
+      continue;
+    }
+    const auto& col_spec = data_spec.columns(col_idx);
+    if (col_spec.type() != file_column.type()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The type of column \"", file_column.name(), "\" in ", path, " (",
+          proto::ColumnType_Name(file_column.type()),
+          ") does not match the dataspec (",
+          proto::ColumnType_Name(col_spec.type()), ")"));
+    }
+    ASSIGN_OR_RETURN(const uint64_t value_size,
+                     ValueSizeBytes(file_column.type()));
+    if (payload_bytes != header.num_rows() * value_size) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Unexpected payload size of column \"",
+                       file_column.name(), "\" in ", path));
+    }
+    ASSIGN_OR_RETURN(char* dst, PrepareColumnAppend(dataset, col_idx,
+                                                    col_spec.type(),
+                                                    payload_bytes));
+    RETURN_IF_ERROR(source.ReadInto(dst, payload_bytes));
+    RETURN_IF_ERROR(source.Skip(PaddingBytes(payload_bytes)));
+    found_column[col_idx] = true;
+  }
+
+  // Columns missing from the shard are either an error (if required) or
+  // filled with NA values.
+  for (int col_idx = 0; col_idx < data_spec.columns_size(); col_idx++) {
+    if (found_column[col_idx] || !load_column[col_idx]) {
+      continue;
+    }
+    if (required_column[col_idx]) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Missing required column \"",
+                       data_spec.columns(col_idx).name(), "\" in ", path));
+    }
+    auto* column = dataset->mutable_column(col_idx);
+    for (int64_t row = 0; row < header.num_rows(); row++) {
+      column->AddNA();
+    }
+  }
+
+  dataset->set_nrow(dataset->nrow() + header.num_rows());
+  return source.Close();
+}
+
+}  // namespace
+
+absl::Status SaveVerticalDatasetToColumnarFiles(
+    const VerticalDataset& dataset, const absl::string_view path,
+    int64_t num_records_by_shard) {
+  std::vector<std::string> shards;
+  RETURN_IF_ERROR(utils::ExpandOutputShards(path, &shards));
+  if (num_records_by_shard <= 0) {
+    // All the examples in the first shard.
+    num_records_by_shard = dataset.nrow();
+  }
+  for (int shard_idx = 0; shard_idx < shards.size(); shard_idx++) {
+    const auto begin_row = std::min<VerticalDataset::row_t>(
+        dataset.nrow(), shard_idx * num_records_by_shard);
+    auto end_row = std::min<VerticalDataset::row_t>(
+        dataset.nrow(), begin_row + num_records_by_shard);
+    if (shard_idx == shards.size() - 1) {
+      // The last shard receives the remaining examples.
+      end_row = dataset.nrow();
+    }
+    RETURN_IF_ERROR(SaveShard(dataset, shards[shard_idx], begin_row, end_row));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status LoadVerticalDatasetFromColumnarFiles(
+    const std::vector<std::string>& shards,
+    const proto::DataSpecification& data_spec, VerticalDataset* dataset,
+    const absl::optional<std::vector<int>>& required_columns,
+    const absl::optional<std::vector<int>>& load_columns) {
+  // Initialize dataset.
+  dataset->set_data_spec(data_spec);
+  RETURN_IF_ERROR(dataset->CreateColumnsFromDataspec());
+  dataset->set_nrow(0);
+
+  std::vector<bool> load_column(data_spec.columns_size(), true);
+  if (load_columns.has_value()) {
+    load_column.assign(data_spec.columns_size(), false);
+    for (const int col_idx : *load_columns) {
+      load_column[col_idx] = true;
+    }
+  }
+  std::vector<bool> required_column(data_spec.columns_size(), true);
+  if (required_columns.has_value()) {
+    required_column.assign(data_spec.columns_size(), false);
+    for (const int col_idx : *required_columns) {
+      required_column[col_idx] = true;
+    }
+  }
+
+  for (const auto& shard : shards) {
+    RETURN_IF_ERROR(LoadColumnarShard(shard, data_spec, load_column,
+                                      required_column, dataset));
+    LOG_INFO_EVERY_N_SEC(30, _ << dataset->nrow() << " examples loaded.");
+  }
+
+  LOG_INFO_EVERY_N_SEC(30, _ << dataset->nrow()
+                             << " examples read. Memory: "
+                             << dataset->MemorySummary());
+  return absl::OkStatus();
+}
+
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Columnar storage of a VerticalDataset on disk.
+//
+// A columnar dataset (typed path prefix "columnar:") stores the raw in-memory
+// representation of the scalar VerticalDataset columns (numerical, discretized
+// numerical, categorical, boolean and hash). Loading such a dataset is a bulk
+// copy of the column payloads instead of a per-example parsing, and uses
+// memory mapping when available so that re-loading a file already in the page
+// cache does not read it from disk again.
+//
+// Like the dataset cache format (see
+// "learner/distributed_decision_tree/dataset_cache/column_cache.h"), the
+// format depends on the host endianness and might change without retro
+// compatibility guarantees: it is designed for the fast re-loading of training
+// snapshots, not for archival.
+//
+// A shard is stored as:
+//   [uint64: size of the serialized header]
+//   [serialized proto::ColumnarShardHeader]
+//   [zero padding to a 8 bytes boundary]
+//   For each column, in the order of the header:
+//     [raw column payload]
+//     [zero padding to a 8 bytes boundary]
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_DATASET_VERTICAL_DATASET_COLUMNAR_H_
+#define YGGDRASIL_DECISION_FORESTS_DATASET_VERTICAL_DATASET_COLUMNAR_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+
+namespace yggdrasil_decision_forests {
+namespace dataset {
+
+// Saves the dataset in the columnar format. "path" is a non-typed, possibly
+// sharded, path. If "num_records_by_shard==-1", all the examples are written
+// in the first shard. Fails if the dataset contains non-scalar columns (e.g.
+// categorical sets).
+absl::Status SaveVerticalDatasetToColumnarFiles(
+    const VerticalDataset& dataset, absl::string_view path,
+    int64_t num_records_by_shard = -1);
+
+// Loads and appends the content of a set of columnar shards into "dataset".
+// See "LoadVerticalDataset" for the semantic of "required_columns" and
+// "load_columns".
+absl::Status LoadVerticalDatasetFromColumnarFiles(
+    const std::vector<std::string>& shards,
+    const proto::DataSpecification& data_spec, VerticalDataset* dataset,
+    const absl::optional<std::vector<int>>& required_columns,
+    const absl::optional<std::vector<int>>& load_columns);
+
+}  // namespace dataset
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_DATASET_VERTICAL_DATASET_COLUMNAR_H_
@@ -30,6 +30,7 @@
 #include "yggdrasil_decision_forests/dataset/formats.h"
 #include "yggdrasil_decision_forests/dataset/formats.pb.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/dataset/vertical_dataset_columnar.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
 #include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
@@ -54,8 +55,9 @@ absl::Status LoadVerticalDatasetSingleThread(
   dataset->set_nrow(0);
 
   // Read and record the examples.
-  ASSIGN_OR_RETURN(auto reader, CreateExampleReader(typed_path, data_spec,
-                                                    required_columns));
+  ASSIGN_OR_RETURN(auto reader,
+                   CreateExampleReader(typed_path, data_spec, required_columns,
+                                       config.load_columns));
 
   // Number of skipped example because of "config.load_example".
   std::size_t skipped_examples = 0;
@@ -87,29 +89,40 @@ absl::Status LoadVerticalDatasetSingleThread(
   return status.status();
 }
 
-// Set of examples extracted by a worker.
-struct BlockOfExamples {
-  // List of examples. These messages are allocated in "arena".
-  std::vector<proto::Example*> examples;
-  google::protobuf::Arena arena;
+// Examples of a shard, parsed into the vertical representation by a worker.
+struct ShardFragment {
+  VerticalDataset dataset;
+  // Number of examples skipped because of "config.load_example".
+  std::size_t skipped_examples = 0;
 };
 
-// Reads a shard.
-utils::StatusOr<std::unique_ptr<BlockOfExamples>> LoadShard(
+// Reads a shard into a dataset fragment.
+utils::StatusOr<std::unique_ptr<ShardFragment>> LoadShard(
     const proto::DataSpecification& data_spec, const absl::string_view prefix,
     const absl::optional<std::vector<int>>& required_columns,
-    const absl::string_view shard) {
-  auto block = absl::make_unique<BlockOfExamples>();
+    const LoadConfig& config, const absl::string_view shard) {
+  auto fragment = absl::make_unique<ShardFragment>();
+  fragment->dataset.set_data_spec(data_spec);
+  RETURN_IF_ERROR(fragment->dataset.CreateColumnsFromDataspec());
+  fragment->dataset.set_nrow(0);
+
   ASSIGN_OR_RETURN(auto reader,
                    CreateExampleReader(absl::StrCat(prefix, ":", shard),
-                                       data_spec, required_columns));
-  auto* example = google::protobuf::Arena::CreateMessage<proto::Example>(&block->arena);
+                                       data_spec, required_columns,
+                                       config.load_columns));
+  proto::Example example;
   utils::StatusOr<bool> status;
-  while ((status = reader->Next(example)).ok() && status.value()) {
-    block->examples.push_back(example);
-    example = google::protobuf::Arena::CreateMessage<proto::Example>(&block->arena);
+  while ((status = reader->Next(&example)).ok() && status.value()) {
+    if (config.load_example.has_value() &&
+        !config.load_example.value()(example)) {
+      fragment->skipped_examples++;
+      continue;
+    }
+    RETURN_IF_ERROR(fragment->dataset.AppendExampleWithStatus(
+        example, config.load_columns));
   }
-  return block;
+  RETURN_IF_ERROR(status.status());
+  return fragment;
 }
 
 }  // namespace
@@ -125,25 +138,31 @@ absl::Status LoadVerticalDataset(
   std::vector<std::string> shards;
   RETURN_IF_ERROR(utils::ExpandInputShards(path, &shards));
 
+  if (prefix == FORMAT_COLUMNAR) {
+    // The columnar format bypasses the example readers: the column payloads
+    // are copied in bulk into the dataset columns.
+    if (config.load_example.has_value()) {
+      return absl::InvalidArgumentError(
+          "\"load_example\" is not supported for columnar datasets");
+    }
+    return LoadVerticalDatasetFromColumnarFiles(
+        shards, data_spec, dataset, required_columns, config.load_columns);
+  }
+
   if (shards.size() <= 1 || config.num_threads <= 1) {
     // Loading in a single thread.
     return LoadVerticalDatasetSingleThread(typed_path, data_spec, dataset,
                                            required_columns, config);
   }
 
-  // Initialize dataset.
-  dataset->set_data_spec(data_spec);
-  RETURN_IF_ERROR(dataset->CreateColumnsFromDataspec());
-  dataset->set_nrow(0);
-
-  // Reads the examples in a shard.
+  // Parses the examples of a shard into a dataset fragment.
   const auto load_shard = [&](const std::string shard)
-      -> utils::StatusOr<std::unique_ptr<BlockOfExamples>> {
-    return LoadShard(data_spec, prefix, required_columns, shard);
+      -> utils::StatusOr<std::unique_ptr<ShardFragment>> {
+    return LoadShard(data_spec, prefix, required_columns, config, shard);
   };
 
   utils::concurrency::StreamProcessor<
-      std::string, utils::StatusOr<std::unique_ptr<BlockOfExamples>>>
+      std::string, utils::StatusOr<std::unique_ptr<ShardFragment>>>
       processor("DatasetLoader",
                 std::min<int>(shards.size(), config.num_threads), load_shard,
                 /*result_in_order=*/true);
@@ -158,34 +177,26 @@ absl::Status LoadVerticalDataset(
   // Number of skipped example because of "config.load_example".
   std::size_t skipped_examples = 0;
 
-  // Ingest the examples in the vertical dataset.
+  // Concatenate the fragments into the vertical dataset. The columns of the
+  // first fragment are moved; the following fragments are appended with a
+  // bulk concatenation of the column storage.
   int loaded_shards = 0;
   while (true) {
-    auto examples = processor.GetResult();
-    if (!examples.has_value()) {
+    auto result = processor.GetResult();
+    if (!result.has_value()) {
       // All the shards have been read.
       break;
     }
-    RETURN_IF_ERROR(examples.value().status());
-    auto block = std::move(examples.value().value());
+    RETURN_IF_ERROR(result.value().status());
+    auto fragment = std::move(result.value().value());
+    skipped_examples += fragment->skipped_examples;
 
     if (loaded_shards == 0) {
+      *dataset = std::move(fragment->dataset);
+
       // Reserve the vertical dataset memory by assuming that all the shards
       // have ~ the same number of examples.
-
-      // Count the number of examples in the first shard.
-      std::size_t num_examples_in_shard;
-      if (config.load_example.has_value()) {
-        num_examples_in_shard = 0;
-        for (const auto* example : block->examples) {
-          if (config.load_example.value()(*example)) {
-            num_examples_in_shard++;
-          }
-        }
-      } else {
-        num_examples_in_shard = block->examples.size();
-      }
-
+      const std::size_t num_examples_in_shard = dataset->nrow();
       if (num_examples_in_shard > 100) {
         // The number of examples in the first shard is representative.
         const auto reserved_examples = num_examples_in_shard * shards.size();
@@ -202,15 +213,8 @@ absl::Status LoadVerticalDataset(
         }
         dataset->Reserve(reserved_examples, config.load_columns);
       }
-    }
-    for (const auto* example : block->examples) {
-      if (config.load_example.has_value() &&
-          !config.load_example.value()(*example)) {
-        skipped_examples++;
-        continue;
-      }
-      RETURN_IF_ERROR(
-          dataset->AppendExampleWithStatus(*example, config.load_columns));
+    } else {
+      RETURN_IF_ERROR(dataset->Append(fragment->dataset));
     }
     LOG_INFO_EVERY_N_SEC(30, _ << dataset->nrow() << " examples scanned.");
     loaded_shards++;
@@ -237,6 +241,13 @@ absl::Status LoadVerticalDataset(
 absl::Status SaveVerticalDataset(const VerticalDataset& dataset,
                                  const absl::string_view typed_path,
                                  int64_t num_records_by_shard) {
+  std::string path, prefix;
+  ASSIGN_OR_RETURN(std::tie(prefix, path), SplitTypeAndPath(typed_path));
+  if (prefix == FORMAT_COLUMNAR) {
+    return SaveVerticalDatasetToColumnarFiles(dataset, path,
+                                              num_records_by_shard);
+  }
+
   ASSIGN_OR_RETURN(auto writer,
                    CreateExampleWriter(typed_path, dataset.data_spec(),
                                        num_records_by_shard));
@@ -51,16 +51,21 @@ namespace dataset {
 //     "required_columns".
 //   num_threads: Number of reading threads. Only used for multi-sharded
 //     datasets. num_threads=1 is more memory efficient than num_threads>1.
-//   load_columns: If specified, only load this subset of columns.
+//   load_columns: If specified, only load this subset of columns. Readers
+//     supporting column projection (e.g. csv, tf.Example, Parquet) skip the
+//     parsing of the other columns entirely.
 //   load_example: If specified, only load the examples that evaluate to true.
 //
 struct LoadConfig {
   // Number of reading threads. Only used for multi-sharded datasets.
   // num_threads=1 is more memory efficient than num_threads>1.
   int num_threads = 10;
-  // If specified, only load this subset of columns.
+  // If specified, only load this subset of columns. Readers supporting column
+  // projection skip the parsing of the other columns entirely.
   absl::optional<std::vector<int>> load_columns;
-  // If specified, only load the examples that evaluate to true.
+  // If specified, only load the examples that evaluate to true. If used
+  // together with "load_columns", the predicate should only depend on loaded
+  // columns: the other attributes are unset in the tested examples.
   absl::optional<std::function<bool(const proto::Example&)>> load_example;
 };
 
@@ -21,6 +21,7 @@
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
@@ -61,6 +62,40 @@ TEST(VerticalDatasetIOTest, Load) {
   }
 }
 
+TEST(VerticalDatasetIOTest, LoadMultiShard) {
+  const std::string typed_dataset_path =
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), "toy.csv"));
+  proto::DataSpecificationGuide guide;
+  guide.mutable_default_column_guide()
+      ->mutable_categorial()
+      ->set_min_vocab_frequency(1);
+  guide.mutable_default_column_guide()
+      ->mutable_tokenizer()
+      ->mutable_tokenizer()
+      ->set_to_lower_case(false);
+  proto::DataSpecification data_spec;
+  CreateDataSpec(typed_dataset_path, false, guide, &data_spec);
+  VerticalDataset ds;
+  EXPECT_OK(LoadVerticalDataset(typed_dataset_path, data_spec, &ds));
+
+  // Save the dataset in two shards, and re-load it with the parallel
+  // multi-shard loader.
+  const std::string typed_sharded_path = absl::StrCat(
+      "csv:", file::JoinPath(test::TmpDirectory(), "sharded_copy@2"));
+  EXPECT_OK(SaveVerticalDataset(ds, typed_sharded_path,
+                                /*num_records_by_shard=*/2));
+  VerticalDataset ds2;
+  EXPECT_OK(LoadVerticalDataset(typed_sharded_path, data_spec, &ds2));
+
+  EXPECT_EQ(ds2.nrow(), ds.nrow());
+  for (int example_idx = 0; example_idx < ds.nrow(); example_idx++) {
+    proto::Example example_1, example_2;
+    ds.ExtractExample(example_idx, &example_1);
+    ds2.ExtractExample(example_idx, &example_2);
+    EXPECT_THAT(example_2, EqualsProto(example_1));
+  }
+}
+
 TEST(VerticalDatasetIOTest, LoadSaveLoad) {
   const std::string dataset_path = file::JoinPath(DatasetDir(), "toy.csv");
   const std::string format = "csv";
@@ -211,6 +246,46 @@ TEST(Dataset, TokenizeTfExample) {
   EXPECT_THAT(example, EqualsProto(expected_example_2));
 }
 
+TEST(VerticalDatasetIOTest, SaveLoadColumnar) {
+  proto::DataSpecification data_spec;
+  AddColumn("a", proto::ColumnType::NUMERICAL, &data_spec);
+  auto* b_col = AddColumn("b", proto::ColumnType::CATEGORICAL, &data_spec);
+  b_col->mutable_categorical()->set_is_already_integerized(true);
+  b_col->mutable_categorical()->set_number_of_unique_values(5);
+  AddColumn("c", proto::ColumnType::BOOLEAN, &data_spec);
+
+  VerticalDataset ds;
+  ds.set_data_spec(data_spec);
+  EXPECT_OK(ds.CreateColumnsFromDataspec());
+  const proto::Example example_1 = PARSE_TEST_PROTO(R"pb(
+    attributes { numerical: 1.5 }
+    attributes { categorical: 2 }
+    attributes { boolean: true }
+  )pb");
+  const proto::Example example_2 = PARSE_TEST_PROTO(R"pb(
+    attributes {}  # Missing value.
+    attributes { categorical: 4 }
+    attributes { boolean: false }
+  )pb");
+  EXPECT_OK(ds.AppendExampleWithStatus(example_1));
+  EXPECT_OK(ds.AppendExampleWithStatus(example_2));
+
+  const std::string typed_path = absl::StrCat(
+      "columnar:", file::JoinPath(test::TmpDirectory(), "dataset.columnar"));
+  EXPECT_OK(SaveVerticalDataset(ds, typed_path));
+
+  VerticalDataset ds2;
+  EXPECT_OK(LoadVerticalDataset(typed_path, data_spec, &ds2));
+  EXPECT_EQ(ds2.nrow(), 2);
+
+  proto::Example example, reloaded_example;
+  for (int example_idx = 0; example_idx < ds.nrow(); example_idx++) {
+    ds.ExtractExample(example_idx, &example);
+    ds2.ExtractExample(example_idx, &reloaded_example);
+    EXPECT_THAT(reloaded_example, EqualsProto(example));
+  }
+}
+
 }  // namespace
 }  // namespace dataset
 }  // namespace yggdrasil_decision_forests
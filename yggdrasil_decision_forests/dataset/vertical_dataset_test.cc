@@ -15,6 +15,7 @@
 
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 
+#include <limits>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -25,6 +26,7 @@
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_replace.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
@@ -376,6 +378,59 @@ TEST(VerticalDataset, Append) {
   }
 }
 
+TEST(VerticalDataset, AppendWithMultiValueColumns) {
+  // Exercises the bulk column concatenation, including the re-offsetting of
+  // the multi-value banks and the preservation of NA values.
+  const proto::DataSpecification data_spec = PARSE_TEST_PROTO(
+      R"pb(
+        columns { type: NUMERICAL name: "a" }
+        columns { type: NUMERICAL_SET name: "b" }
+        columns {
+          type: CATEGORICAL_SET
+          name: "c"
+          categorical { is_already_integerized: true }
+        }
+        columns { type: STRING name: "d" }
+      )pb");
+
+  const proto::Example example_1 = PARSE_TEST_PROTO(
+      R"pb(
+        attributes { numerical: 0.5 }
+        attributes { numerical_set: { values: 0 values: 1 } }
+        attributes { categorical_set: { values: 0 values: 1 } }
+        attributes { text: "hello" }
+      )pb");
+  const proto::Example example_2 = PARSE_TEST_PROTO(
+      R"pb(
+        attributes {}
+        attributes {}
+        attributes {}
+        attributes {}
+      )pb");
+
+  VerticalDataset dataset_1, dataset_2;
+  for (auto* dataset : {&dataset_1, &dataset_2}) {
+    dataset->set_data_spec(data_spec);
+    EXPECT_OK(dataset->CreateColumnsFromDataspec());
+    CHECK_OK(dataset->AppendExampleWithStatus(example_1));
+    CHECK_OK(dataset->AppendExampleWithStatus(example_2));
+  }
+
+  EXPECT_OK(dataset_1.Append(dataset_2));
+  EXPECT_EQ(dataset_1.nrow(), 4);
+
+  for (const int row_idx : {0, 2}) {
+    proto::Example extracted_example;
+    dataset_1.ExtractExample(row_idx, &extracted_example);
+    EXPECT_THAT(extracted_example, EqualsProto(example_1));
+  }
+  for (const int row_idx : {1, 3}) {
+    proto::Example extracted_example;
+    dataset_1.ExtractExample(row_idx, &extracted_example);
+    EXPECT_THAT(extracted_example, EqualsProto(example_2));
+  }
+}
+
 TEST(VerticalDataset, PushBackNotOwnedColumn) {
   VerticalDataset dataset;
   EXPECT_EQ(dataset.ncol(), 0);
@@ -424,6 +479,68 @@ TEST(VerticalDataset, ShallowNonOwningClone) {
   EXPECT_FALSE(clone_2.OwnsColumn(0));
 }
 
+TEST(VerticalDataset, AppendBatch) {
+  VerticalDataset dataset;
+  *dataset.mutable_data_spec() = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "a" }
+    columns {
+      type: CATEGORICAL
+      name: "b"
+      categorical { is_already_integerized: true number_of_unique_values: 3 }
+    }
+  )pb");
+  EXPECT_OK(dataset.CreateColumnsFromDataspec());
+
+  const std::vector<float> numerical_values = {
+      1.f, 2.f, std::numeric_limits<float>::quiet_NaN()};
+  const std::vector<int32_t> categorical_values = {
+      0, 2, VerticalDataset::CategoricalColumn::kNaValue};
+  EXPECT_OK(dataset.AppendBatch<VerticalDataset::NumericalColumn>(
+      0, absl::MakeConstSpan(numerical_values)));
+  EXPECT_OK(dataset.AppendBatch<VerticalDataset::CategoricalColumn>(
+      1, absl::MakeConstSpan(categorical_values)));
+  dataset.set_nrow(3);
+
+  EXPECT_EQ(dataset.column(0)->nrows(), 3);
+  EXPECT_EQ(dataset.ValueToString(1, 0), "2");
+  EXPECT_TRUE(dataset.column(0)->IsNa(2));
+  EXPECT_EQ(dataset.ValueToString(1, 1), "2");
+  EXPECT_TRUE(dataset.column(1)->IsNa(2));
+
+  // Appending to a column of the wrong type fails.
+  EXPECT_FALSE(dataset
+                   .AppendBatch<VerticalDataset::NumericalColumn>(
+                       1, absl::MakeConstSpan(numerical_values))
+                   .ok());
+}
+
+TEST(VerticalDataset, ExtractIdentityIsZeroCopy) {
+  VerticalDataset original;
+  AddColumn("a", proto::ColumnType::NUMERICAL, original.mutable_data_spec());
+  EXPECT_OK(original.CreateColumnsFromDataspec());
+  CHECK_OK(original.AppendExampleWithStatus({{"a", "0.1"}}));
+  CHECK_OK(original.AppendExampleWithStatus({{"a", "0.2"}}));
+
+  // Selecting all the rows in order shares the columns.
+  auto shared = original
+                    .Extract(std::vector<VerticalDataset::row_t>{0, 1})
+                    .value();
+  EXPECT_EQ(shared.nrow(), 2);
+  EXPECT_EQ(shared.column(0), original.column(0));
+  EXPECT_TRUE(shared.OwnsColumn(0));
+
+  // The shared columns outlive the original dataset.
+  original = VerticalDataset();
+  EXPECT_EQ(shared.column(0)->nrows(), 2);
+  EXPECT_EQ(shared.ValueToString(1, 0), "0.2");
+
+  // Selecting the rows out of order copies the columns.
+  const auto copied =
+      shared.Extract(std::vector<VerticalDataset::row_t>{1, 0}).value();
+  EXPECT_NE(copied.column(0), shared.column(0));
+  EXPECT_EQ(copied.ValueToString(0, 0), "0.2");
+}
+
 TEST(VerticalDataset, AddColumn) {
   VerticalDataset dataset;
   *dataset.mutable_data_spec() = PARSE_TEST_PROTO(R"pb(
@@ -495,6 +612,157 @@ TEST(VerticalDataset, Set) {
   EXPECT_EQ(dataset.ValueToString(1, 1), "BBB");
 }
 
+TEST(VerticalDataset, CompressCategoricalColumns) {
+  VerticalDataset dataset;
+  *dataset.mutable_data_spec() = PARSE_TEST_PROTO(R"pb(
+    columns {
+      type: CATEGORICAL
+      name: "a"
+      categorical { is_already_integerized: true number_of_unique_values: 3 }
+    }
+  )pb");
+  EXPECT_OK(dataset.CreateColumnsFromDataspec());
+  auto* column =
+      dataset
+          .MutableColumnWithCastWithStatus<VerticalDataset::CategoricalColumn>(
+              0)
+          .value();
+  // Long runs of identical values: the run-length encoding is the smallest.
+  for (int row_idx = 0; row_idx < 1000; row_idx++) {
+    column->Add(row_idx / 500);
+  }
+  column->AddNA();
+  dataset.set_nrow(1001);
+
+  const auto memory_before = dataset.column(0)->memory_usage().first;
+  EXPECT_OK(dataset.CompressCategoricalColumns());
+  const auto* compressed =
+      dynamic_cast<const VerticalDataset::CompressedCategoricalColumn*>(
+          dataset.column(0));
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_TRUE(compressed->run_length_encoded());
+  EXPECT_LT(compressed->memory_usage().first, memory_before);
+  EXPECT_EQ(compressed->nrows(), 1001);
+  EXPECT_EQ(compressed->value(0), 0);
+  EXPECT_EQ(compressed->value(499), 0);
+  EXPECT_EQ(compressed->value(500), 1);
+  EXPECT_EQ(compressed->value(999), 1);
+  EXPECT_TRUE(compressed->IsNa(1000));
+  EXPECT_EQ(dataset.ValueToString(500, 0), "1");
+  EXPECT_EQ(dataset.ValueToString(1000, 0), "NA");
+
+  // Extracting rows decodes the values into a regular column.
+  const auto extracted =
+      dataset.Extract(std::vector<VerticalDataset::row_t>{0, 500, 1000})
+          .value();
+  const auto* extracted_column =
+      extracted.ColumnWithCastWithStatus<VerticalDataset::CategoricalColumn>(0)
+          .value();
+  EXPECT_EQ(extracted_column->values()[0], 0);
+  EXPECT_EQ(extracted_column->values()[1], 1);
+  EXPECT_EQ(extracted_column->values()[2],
+            VerticalDataset::CategoricalColumn::kNaValue);
+
+  // Requesting a mutable "CategoricalColumn" decompresses the column in
+  // place.
+  auto* decompressed =
+      dataset
+          .MutableColumnWithCastWithStatus<VerticalDataset::CategoricalColumn>(
+              0)
+          .value();
+  ASSERT_NE(decompressed, nullptr);
+  EXPECT_EQ(decompressed->name(), "a");
+  EXPECT_EQ(decompressed->nrows(), 1001);
+  EXPECT_EQ(decompressed->values()[600], 1);
+  EXPECT_TRUE(decompressed->IsNa(1000));
+}
+
+TEST(VerticalDataset, CompressCategoricalColumnsDense) {
+  VerticalDataset dataset;
+  *dataset.mutable_data_spec() = PARSE_TEST_PROTO(R"pb(
+    columns {
+      type: CATEGORICAL
+      name: "a"
+      categorical { is_already_integerized: true number_of_unique_values: 3 }
+    }
+  )pb");
+  EXPECT_OK(dataset.CreateColumnsFromDataspec());
+  auto* column =
+      dataset
+          .MutableColumnWithCastWithStatus<VerticalDataset::CategoricalColumn>(
+              0)
+          .value();
+  // Alternating values: one code per row is the smallest.
+  for (int row_idx = 0; row_idx < 1000; row_idx++) {
+    column->Add(row_idx % 2);
+  }
+  dataset.set_nrow(1000);
+
+  EXPECT_OK(dataset.CompressCategoricalColumns());
+  const auto* compressed =
+      dynamic_cast<const VerticalDataset::CompressedCategoricalColumn*>(
+          dataset.column(0));
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_FALSE(compressed->run_length_encoded());
+  EXPECT_EQ(compressed->value(0), 0);
+  EXPECT_EQ(compressed->value(1), 1);
+  EXPECT_EQ(compressed->value(999), 1);
+}
+
+TEST(VerticalDataset, CompressNumericalColumns) {
+  VerticalDataset dataset;
+  *dataset.mutable_data_spec() = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "a" }
+  )pb");
+  EXPECT_OK(dataset.CreateColumnsFromDataspec());
+  auto* column =
+      dataset
+          .MutableColumnWithCastWithStatus<VerticalDataset::NumericalColumn>(0)
+          .value();
+  for (int row_idx = 0; row_idx < 1000; row_idx++) {
+    column->Add(row_idx * 0.001f);
+  }
+  column->AddNA();
+  dataset.set_nrow(1001);
+
+  const auto memory_before = dataset.column(0)->memory_usage().first;
+  EXPECT_OK(dataset.CompressNumericalColumns());
+  const auto* compressed =
+      dynamic_cast<const VerticalDataset::BFloat16NumericalColumn*>(
+          dataset.column(0));
+  ASSERT_NE(compressed, nullptr);
+  EXPECT_EQ(compressed->memory_usage().first, memory_before / 2);
+  EXPECT_EQ(compressed->nrows(), 1001);
+  // The values are rounded to 8 bits of mantissa.
+  EXPECT_EQ(compressed->value(0), 0.f);
+  EXPECT_NEAR(compressed->value(500), 0.5f, 1.f / 256);
+  EXPECT_NEAR(compressed->value(999), 0.999f, 1.f / 256);
+  EXPECT_TRUE(compressed->IsNa(1000));
+  EXPECT_EQ(dataset.ValueToString(1000, 0), "NA");
+
+  // Extracting rows widens the values into a regular column.
+  const auto extracted =
+      dataset.Extract(std::vector<VerticalDataset::row_t>{0, 500, 1000})
+          .value();
+  const auto* extracted_column =
+      extracted.ColumnWithCastWithStatus<VerticalDataset::NumericalColumn>(0)
+          .value();
+  EXPECT_EQ(extracted_column->values()[0], 0.f);
+  EXPECT_NEAR(extracted_column->values()[1], 0.5f, 1.f / 256);
+  EXPECT_TRUE(extracted_column->IsNa(2));
+
+  // Requesting a mutable "NumericalColumn" decompresses the column in place.
+  auto* decompressed =
+      dataset
+          .MutableColumnWithCastWithStatus<VerticalDataset::NumericalColumn>(0)
+          .value();
+  ASSERT_NE(decompressed, nullptr);
+  EXPECT_EQ(decompressed->name(), "a");
+  EXPECT_EQ(decompressed->nrows(), 1001);
+  EXPECT_NEAR(decompressed->values()[600], 0.6f, 1.f / 256);
+  EXPECT_TRUE(decompressed->IsNa(1000));
+}
+
 }  // namespace
 }  // namespace dataset
 }  // namespace yggdrasil_decision_forests
@@ -234,17 +234,23 @@ absl::Status GetWeights(const VerticalDataset& dataset,
           const auto* weight_col,
           dataset.ColumnWithCastWithStatus<VerticalDataset::CategoricalColumn>(
               weight_definition.attribute_idx()));
-      weights->resize(dataset.nrow());
-      for (VerticalDataset::row_t row_idx = 0; row_idx < dataset.nrow();
-           row_idx++) {
-        const int cat_value = weight_col->values()[row_idx];
+      // Gather the weights through a contiguous lookup table: the proto
+      // accessors and the bound checks are resolved outside of the loop.
+      const auto& idx_2_weight =
+          weight_definition.categorical().categorical_value_idx_2_weight();
+      const float* const lookup = idx_2_weight.data();
+      const auto& values = weight_col->values();
+      const VerticalDataset::row_t num_rows = dataset.nrow();
+      weights->resize(num_rows);
+      float* const dst = weights->data();
+      for (VerticalDataset::row_t row_idx = 0; row_idx < num_rows; row_idx++) {
+        const int cat_value = values[row_idx];
         if (cat_value == VerticalDataset::CategoricalColumn::kNaValue) {
           return absl::InvalidArgumentError(absl::StrCat(
               "Found NA value for weighting attribute in example #", row_idx));
         }
-        (*weights)[row_idx] =
-            weight_definition.categorical().categorical_value_idx_2_weight(
-                cat_value);
+        DCHECK_LT(cat_value, idx_2_weight.size());
+        dst[row_idx] = lookup[cat_value];
       }
     } break;
     case proto::LinkedWeightDefinition::kNumerical: {
@@ -252,17 +258,16 @@ absl::Status GetWeights(const VerticalDataset& dataset,
           const auto* weight_col,
           dataset.ColumnWithCastWithStatus<VerticalDataset::NumericalColumn>(
               weight_definition.attribute_idx()));
+      // Single copy of the column, followed by a single validation scan.
       *weights = weight_col->values();
-      if (std::find_if(weights->begin(), weights->end(), [](const float value) {
-            return std::isnan(value);
-          }) != weights->end()) {
-        return absl::InvalidArgumentError(
-            "Found NA value for weighting attribute.");
-      }
-      if (std::find_if(weights->begin(), weights->end(), [](const float value) {
-            return value < 0;
-          }) != weights->end()) {
-        return absl::InvalidArgumentError("Found negative weight value.");
+      for (const float value : *weights) {
+        if (std::isnan(value)) {
+          return absl::InvalidArgumentError(
+              "Found NA value for weighting attribute.");
+        }
+        if (value < 0) {
+          return absl::InvalidArgumentError("Found negative weight value.");
+        }
       }
     } break;
     default:
@@ -23,9 +23,11 @@
 #include <random>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
@@ -33,6 +35,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
@@ -241,22 +244,34 @@ AbstractLearner::TrainWithStatus(
   auto dataset_loading_config = OptimalDatasetLoadingConfig(link_config);
   dataset_loading_config.num_threads = deployment().num_io_threads();
 
-  dataset::VerticalDataset train_dataset;
-  RETURN_IF_ERROR(LoadVerticalDataset(typed_path, data_spec, &train_dataset,
-                                      /*required_columns=*/{},
-                                      dataset_loading_config));
-
-  RETURN_IF_ERROR(CheckNumExamples(train_dataset.nrow()));
-
+  // Load the validation dataset (if any) concurrently with the (generally
+  // much larger) training dataset.
   dataset::VerticalDataset valid_dataset_data;
   absl::optional<std::reference_wrapper<const dataset::VerticalDataset>>
       valid_dataset;
+  absl::Status valid_load_status;
+  std::unique_ptr<utils::concurrency::Thread> valid_loader;
   if (typed_valid_path.has_value()) {
-    RETURN_IF_ERROR(LoadVerticalDataset(
-        typed_valid_path.value(), data_spec, &valid_dataset_data,
-        /*required_columns=*/{}, dataset_loading_config));
+    valid_loader = absl::make_unique<utils::concurrency::Thread>([&]() {
+      valid_load_status = LoadVerticalDataset(
+          typed_valid_path.value(), data_spec, &valid_dataset_data,
+          /*required_columns=*/{}, dataset_loading_config);
+    });
     valid_dataset = valid_dataset_data;
   }
+
+  dataset::VerticalDataset train_dataset;
+  const auto train_load_status =
+      LoadVerticalDataset(typed_path, data_spec, &train_dataset,
+                          /*required_columns=*/{}, dataset_loading_config);
+  if (valid_loader) {
+    valid_loader->Join();
+  }
+  RETURN_IF_ERROR(train_load_status);
+  RETURN_IF_ERROR(valid_load_status);
+
+  RETURN_IF_ERROR(CheckNumExamples(train_dataset.nrow()));
+
   return TrainWithStatus(train_dataset, valid_dataset);
 }
 
@@ -594,11 +609,20 @@ utils::StatusOr<metric::proto::EvaluationResults> EvaluateLearnerOrStatus(
       break;
   }
 
-  // Initialize the folds.
+  // Initialize the folds. With a hashed fold assignment, the fold membership
+  // is computed on the fly instead of materializing the fold index vectors.
   utils::FoldList folds;
-  RETURN_IF_ERROR(
-      utils::GenerateFoldsConstDataset(fold_generator, dataset, &folds));
-  const int num_folds = utils::NumberOfFolds(fold_generator, folds);
+  absl::optional<utils::FoldMembershipView> fold_view;
+  if (fold_generator.cross_validation().hashed_fold_assignment()) {
+    ASSIGN_OR_RETURN(fold_view, utils::FoldMembershipView::Create(
+                                    fold_generator, dataset.nrow()));
+  } else {
+    RETURN_IF_ERROR(
+        utils::GenerateFoldsConstDataset(fold_generator, dataset, &folds));
+  }
+  const int num_folds = fold_view.has_value()
+                            ? fold_view->num_folds()
+                            : utils::NumberOfFolds(fold_generator, folds);
 
   // Get the label column specification.
   int32_t label_col_idx;
@@ -614,7 +638,8 @@ utils::StatusOr<metric::proto::EvaluationResults> EvaluateLearnerOrStatus(
   // Trains and evaluates a single model on the "fold_idx".
   const auto train_and_evaluate =
       [&aggregated_evaluation, &evaluation_mutex, &label_col_spec, &dataset,
-       &folds, &learner, &evaluation_options, &status_train_and_evaluate](
+       &folds, &fold_view, &learner, &evaluation_options,
+       &status_train_and_evaluate](
           const int fold_idx, utils::RandomEngine* rnd) {
         metric::proto::EvaluationResults evaluation;
         {
@@ -630,10 +655,20 @@ utils::StatusOr<metric::proto::EvaluationResults> EvaluateLearnerOrStatus(
         }
 
         // Extract the training and testing dataset.
-        const auto testing_dataset = dataset.Extract(folds[fold_idx]).value();
-        const auto training_indices =
-            utils::MergeIndicesExceptOneFold(folds, fold_idx);
-        const auto training_dataset = dataset.Extract(training_indices).value();
+        dataset::VerticalDataset testing_dataset;
+        dataset::VerticalDataset training_dataset;
+        if (fold_view.has_value()) {
+          // The fold index vectors only exist during the extraction.
+          testing_dataset =
+              dataset.Extract(fold_view->TestIndices(fold_idx)).value();
+          training_dataset =
+              dataset.Extract(fold_view->TrainingIndices(fold_idx)).value();
+        } else {
+          testing_dataset = dataset.Extract(folds[fold_idx]).value();
+          const auto training_indices =
+              utils::MergeIndicesExceptOneFold(folds, fold_idx);
+          training_dataset = dataset.Extract(training_indices).value();
+        }
         // Train a model.
         auto model = learner.TrainWithStatus(training_dataset).value();
         // Evaluate the model.
@@ -648,12 +683,46 @@ utils::StatusOr<metric::proto::EvaluationResults> EvaluateLearnerOrStatus(
         }
       };
 
+  // Number of folds trained and evaluated concurrently. Each of them holds a
+  // copy of approximately the entire dataset (the training and testing parts
+  // of a fold) and trains with "learner.deployment().num_threads()" threads.
+  int num_concurrent_folds =
+      std::min(deployment_evaluation.num_threads(), num_folds);
+  if (deployment_evaluation.maximum_evaluation_memory_in_bytes() > 0) {
+    const auto fold_memory_usage =
+        std::max<uint64_t>(dataset.memory_usage().first, 1);
+    const int64_t max_folds_in_memory =
+        deployment_evaluation.maximum_evaluation_memory_in_bytes() /
+        static_cast<int64_t>(fold_memory_usage);
+    if (max_folds_in_memory < num_concurrent_folds) {
+      num_concurrent_folds = std::max<int64_t>(1, max_folds_in_memory);
+      LOG(INFO) << "Number of concurrently evaluated folds capped to "
+                << num_concurrent_folds << " to fit the "
+                << deployment_evaluation.maximum_evaluation_memory_in_bytes()
+                << " bytes memory budget.";
+    }
+  }
+  const int64_t total_num_threads =
+      static_cast<int64_t>(num_concurrent_folds) *
+      learner.deployment().num_threads();
+  const int64_t num_cores = std::thread::hardware_concurrency();
+  if (num_cores > 0 && total_num_threads > num_cores) {
+    LOG(WARNING) << "Up to " << num_concurrent_folds
+                 << " folds, each trained with "
+                 << learner.deployment().num_threads()
+                 << " threads, will run concurrently. This oversubscribes the "
+                 << num_cores
+                 << " available cores. Consider reducing "
+                    "\"deployment_evaluation.num_threads\" or the learner "
+                    "\"deployment.num_threads\".";
+  }
+
   utils::RandomEngine rnd;
   RETURN_IF_ERROR(metric::InitializeEvaluation(
       evaluation_options, label_col_spec, &aggregated_evaluation));
   {
     yggdrasil_decision_forests::utils::concurrency::ThreadPool pool(
-        "Evaluator", deployment_evaluation.num_threads());
+        "Evaluator", num_concurrent_folds);
     pool.StartWorkers();
     for (int fold_idx = 0; fold_idx < num_folds; fold_idx++) {
       pool.Schedule([&train_and_evaluate, fold_idx, seed{rnd()}]() {
@@ -232,6 +232,12 @@ absl::Status CheckGenericHyperParameterSpecification(
 // If your learner is already parallelized, training and evaluating a single
 // models at a time might be best i.e. deployment_evaluation = { .num_threads =
 // 1 }.
+//
+// Each fold evaluated in parallel holds a copy of approximately the entire
+// dataset in memory. If
+// "deployment_evaluation.maximum_evaluation_memory_in_bytes" is set, the
+// number of folds evaluated concurrently is capped so that the estimated size
+// of these copies does not exceed this budget.
 
 utils::StatusOr<metric::proto::EvaluationResults> EvaluateLearnerOrStatus(
     const AbstractLearner& learner, const dataset::VerticalDataset& dataset,
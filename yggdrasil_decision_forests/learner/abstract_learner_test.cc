@@ -251,6 +251,17 @@ TEST(AbstractLearner, EvaluateLearner) {
 
   EXPECT_NEAR(metric::Accuracy(eval), 0.5f, 0.001f);
   EXPECT_NEAR(eval.count_predictions(), 4000., 0.001);
+
+  // Same evaluation with the number of concurrently evaluated folds capped by
+  // a small memory budget.
+  const proto::DeploymentConfig deployment_evaluation = PARSE_TEST_PROTO(R"pb(
+    maximum_evaluation_memory_in_bytes: 1
+  )pb");
+  const auto capped_eval = EvaluateLearner(
+      learner, dataset, fold_generator, evaluation_options,
+      deployment_evaluation);
+  EXPECT_NEAR(metric::Accuracy(capped_eval), 0.5f, 0.001f);
+  EXPECT_NEAR(capped_eval.count_predictions(), 4000., 0.001);
 }
 
 TEST(AbstractLearner, MaximumModelSizeInMemoryInBytes) {
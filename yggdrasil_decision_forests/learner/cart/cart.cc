@@ -15,6 +15,7 @@
 
 #include "yggdrasil_decision_forests/learner/cart/cart.h"
 
+#include <deque>
 #include <memory>
 #include <numeric>
 #include <string>
@@ -43,6 +44,7 @@
 #include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
 #include "yggdrasil_decision_forests/utils/adaptive_work.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/hyper_parameters.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/random.h"
@@ -208,7 +210,9 @@ utils::StatusOr<std::unique_ptr<AbstractModel>> CartLearner::TrainWithStatus(
     // Prune the tree.
     const auto num_nodes_pre_pruning = decision_tree->NumNodes();
     RETURN_IF_ERROR(internal::PruneTree(train_dataset, weights, valid_examples,
-                                        config, config_link, decision_tree));
+                                        config, config_link,
+                                        deployment().num_threads(),
+                                        decision_tree));
     mdl->set_num_pruned_nodes(num_nodes_pre_pruning -
                               decision_tree->NumNodes());
   }
@@ -258,6 +262,52 @@ namespace internal {
 //   predictions: Example predictions.
 //   node: Current node.
 //
+// The same template arguments and argument names are used by the other
+// pruning functions below.
+
+// Turns "node" into a leaf if the leaf scores at least as well as the (already
+// pruned) subtree on "example_idxs".
+template <typename ScoreAccumulator, typename Label, typename Prediction,
+          typename Secondary>
+void MaybeCollapseNode(const std::vector<float>& weights,
+                       const std::vector<Label>& labels,
+                       const std::vector<Secondary>& secondary_labels,
+                       const std::vector<UnsignedExampleIdx>& example_idxs,
+                       std::vector<Prediction>* predictions,
+                       model::decision_tree::NodeWithChildren* node) {
+  // Compare the quality of the current node as a leaf or as a non-leaf. The
+  // children of the node have already been pruned and "predictions" contains
+  // the subtree predictions for "example_idxs".
+  ScoreAccumulator score_as_leaf;
+  ScoreAccumulator score_as_non_leaf;
+  for (const auto& example_idx : example_idxs) {
+    Secondary secondary_label{};
+    if (!secondary_labels.empty()) {
+      secondary_label = secondary_labels[example_idx];
+    }
+    score_as_non_leaf.Add(labels[example_idx], secondary_label,
+                          (*predictions)[example_idx], weights[example_idx]);
+    score_as_leaf.Add(labels[example_idx], secondary_label,
+                      ScoreAccumulator::LeafToPrediction(node),
+                      weights[example_idx]);
+  }
+
+  if (score_as_leaf.Score() < score_as_non_leaf.Score()) {
+    // The node is better as a non-leaf than as a leaf: Don't prune the node.
+    return;
+  }
+
+  // Turn the node into a leaf and prune the children.
+  node->TurnIntoLeaf();
+
+  // Update the predictions with this node as a leaf.
+  for (const auto& example_idx : example_idxs) {
+    (*predictions)[example_idx] = ScoreAccumulator::LeafToPrediction(node);
+  }
+}
+
+// Recursively prunes the subtree rooted at "node", and fills "predictions"
+// with the predictions of the pruned subtree on "example_idxs".
 template <typename ScoreAccumulator, typename Label, typename Prediction,
           typename Secondary>
 absl::Status PruneNode(const dataset::VerticalDataset& dataset,
@@ -296,32 +346,92 @@ absl::Status PruneNode(const dataset::VerticalDataset& dataset,
   negative_examples.clear();
   negative_examples.shrink_to_fit();
 
-  // Compare the quality of the current node as a leaf or as a non-leaf.
-  ScoreAccumulator score_as_leaf;
-  ScoreAccumulator score_as_non_leaf;
-  for (const auto& example_idx : example_idxs) {
-    Secondary secondary_label{};
-    if (!secondary_labels.empty()) {
-      secondary_label = secondary_labels[example_idx];
-    }
-    score_as_non_leaf.Add(labels[example_idx], secondary_label,
-                          (*predictions)[example_idx], weights[example_idx]);
-    score_as_leaf.Add(labels[example_idx], secondary_label,
-                      ScoreAccumulator::LeafToPrediction(node),
-                      weights[example_idx]);
+  MaybeCollapseNode<ScoreAccumulator, Label, Prediction, Secondary>(
+      weights, labels, secondary_labels, example_idxs, predictions, node);
+  return absl::OkStatus();
+}
+
+// Prunes a tree with "num_threads" workers.
+//
+// Candidate evaluations in disjoint subtrees are independent (they touch
+// disjoint example and prediction ranges): the tree is first expanded
+// breadth-first into per-subtree tasks which are pruned in parallel with
+// "PruneNode". The expanded nodes above the task frontier are then collapsed
+// bottom-up.
+template <typename ScoreAccumulator, typename Label, typename Prediction,
+          typename Secondary>
+absl::Status PruneTreeConcurrent(
+    const dataset::VerticalDataset& dataset, const std::vector<float>& weights,
+    const std::vector<Label>& labels,
+    const std::vector<Secondary>& secondary_labels,
+    const std::vector<UnsignedExampleIdx>& example_idxs, const int num_threads,
+    std::vector<Prediction>* predictions,
+    model::decision_tree::NodeWithChildren* root) {
+  if (num_threads <= 1) {
+    return PruneNode<ScoreAccumulator, Label, Prediction, Secondary>(
+        dataset, weights, labels, secondary_labels, example_idxs, predictions,
+        root);
   }
 
-  if (score_as_leaf.Score() < score_as_non_leaf.Score()) {
-    // The node is better as a non-leaf than as a leaf: Don't prune the node.
-    return absl::OkStatus();
+  struct Task {
+    model::decision_tree::NodeWithChildren* node;
+    std::vector<UnsignedExampleIdx> example_idxs;
+  };
+
+  // Expand the tree breadth-first until there are enough subtrees to keep the
+  // workers busy. "ancestors" contains the expanded nodes by increasing depth.
+  const size_t target_num_tasks = num_threads * 2;
+  std::deque<Task> open;
+  open.push_back({root, {example_idxs.begin(), example_idxs.end()}});
+  std::vector<Task> frontier;
+  std::vector<Task> ancestors;
+  while (!open.empty()) {
+    Task task = std::move(open.front());
+    open.pop_front();
+    if (task.node->IsLeaf() ||
+        open.size() + frontier.size() + 1 >= target_num_tasks) {
+      frontier.push_back(std::move(task));
+      continue;
+    }
+    std::vector<UnsignedExampleIdx> positive_examples, negative_examples;
+    RETURN_IF_ERROR(decision_tree::internal::SplitExamples(
+        dataset, task.example_idxs, task.node->node().condition(),
+        /*dataset_is_dense=*/false,
+        /*error_on_wrong_splitter_statistics=*/false, &positive_examples,
+        &negative_examples,
+        /*examples_are_training_examples=*/false));
+    open.push_back(
+        {task.node->mutable_pos_child(), std::move(positive_examples)});
+    open.push_back(
+        {task.node->mutable_neg_child(), std::move(negative_examples)});
+    ancestors.push_back(std::move(task));
   }
 
-  // Turn the node into a leaf and prune the children.
-  node->TurnIntoLeaf();
+  // Prune the subtrees in parallel.
+  std::vector<absl::Status> statuses(frontier.size());
+  {
+    utils::concurrency::ThreadPool pool("CartPruning", num_threads);
+    pool.StartWorkers();
+    for (size_t task_idx = 0; task_idx < frontier.size(); task_idx++) {
+      pool.Schedule([&dataset, &weights, &labels, &secondary_labels, &frontier,
+                     &statuses, predictions, task_idx]() {
+        const auto& task = frontier[task_idx];
+        statuses[task_idx] =
+            PruneNode<ScoreAccumulator, Label, Prediction, Secondary>(
+                dataset, weights, labels, secondary_labels, task.example_idxs,
+                predictions, task.node);
+      });
+    }
+  }
+  for (const auto& status : statuses) {
+    RETURN_IF_ERROR(status);
+  }
 
-  // Update the predictions with this node as a leaf.
-  for (const auto& example_idx : example_idxs) {
-    (*predictions)[example_idx] = ScoreAccumulator::LeafToPrediction(node);
+  // Collapse the expanded nodes, deepest first.
+  for (auto it = ancestors.rbegin(); it != ancestors.rend(); ++it) {
+    MaybeCollapseNode<ScoreAccumulator, Label, Prediction, Secondary>(
+        weights, labels, secondary_labels, it->example_idxs, predictions,
+        it->node);
   }
   return absl::OkStatus();
 }
@@ -331,7 +441,7 @@ absl::Status PruneTreeClassification(
     const std::vector<UnsignedExampleIdx>& example_idxs,
     const model::proto::TrainingConfig& config,
     const model::proto::TrainingConfigLinking& config_link,
-    model::decision_tree::DecisionTree* tree) {
+    const int num_threads, model::decision_tree::DecisionTree* tree) {
   const auto& labels =
       dataset
           .ColumnWithCastWithStatus<
@@ -361,8 +471,8 @@ absl::Status PruneTreeClassification(
   };
 
   std::vector<int32_t> predictions(dataset.nrow());
-  return PruneNode<AccuracyAccumulator, int32_t, int32_t, bool>(
-      dataset, weights, labels, {}, example_idxs, &predictions,
+  return PruneTreeConcurrent<AccuracyAccumulator, int32_t, int32_t, bool>(
+      dataset, weights, labels, {}, example_idxs, num_threads, &predictions,
       tree->mutable_root());
 }
 
@@ -371,7 +481,7 @@ absl::Status PruneTreeRegression(
     const std::vector<UnsignedExampleIdx>& example_idxs,
     const model::proto::TrainingConfig& config,
     const model::proto::TrainingConfigLinking& config_link,
-    model::decision_tree::DecisionTree* tree) {
+    const int num_threads, model::decision_tree::DecisionTree* tree) {
   const auto& labels =
       dataset
           .ColumnWithCastWithStatus<dataset::VerticalDataset::NumericalColumn>(
@@ -402,8 +512,8 @@ absl::Status PruneTreeRegression(
   };
 
   std::vector<float> predictions(dataset.nrow());
-  return PruneNode<NegMSEAccumulator, float, float, bool>(
-      dataset, weights, labels, {}, example_idxs, &predictions,
+  return PruneTreeConcurrent<NegMSEAccumulator, float, float, bool>(
+      dataset, weights, labels, {}, example_idxs, num_threads, &predictions,
       tree->mutable_root());
 }
 
@@ -412,7 +522,7 @@ absl::Status PruneTreeUpliftCategorical(
     const std::vector<UnsignedExampleIdx>& example_idxs,
     const model::proto::TrainingConfig& config,
     const model::proto::TrainingConfigLinking& config_link,
-    model::decision_tree::DecisionTree* tree) {
+    const int num_threads, model::decision_tree::DecisionTree* tree) {
   const auto& outcomes =
       dataset
           .ColumnWithCastWithStatus<
@@ -482,10 +592,10 @@ absl::Status PruneTreeUpliftCategorical(
   std::vector<typename UpliftAccumulator::Prediction> predictions(
       dataset.nrow());
 
-  return PruneNode<UpliftAccumulator, int32_t,
-                   typename UpliftAccumulator::Prediction, int32_t>(
-      dataset, weights, outcomes, treatments, example_idxs, &predictions,
-      tree->mutable_root());
+  return PruneTreeConcurrent<UpliftAccumulator, int32_t,
+                             typename UpliftAccumulator::Prediction, int32_t>(
+      dataset, weights, outcomes, treatments, example_idxs, num_threads,
+      &predictions, tree->mutable_root());
 }
 
 absl::Status PruneTree(const dataset::VerticalDataset& dataset,
@@ -493,22 +603,26 @@ absl::Status PruneTree(const dataset::VerticalDataset& dataset,
                        const std::vector<UnsignedExampleIdx>& example_idxs,
                        const model::proto::TrainingConfig& config,
                        const model::proto::TrainingConfigLinking& config_link,
+                       const int num_threads,
                        model::decision_tree::DecisionTree* tree) {
   const auto num_nodes_pre_pruning = tree->NumNodes();
 
   switch (config.task()) {
     case model::proto::Task::CLASSIFICATION:
       RETURN_IF_ERROR(PruneTreeClassification(dataset, weights, example_idxs,
-                                              config, config_link, tree));
+                                              config, config_link, num_threads,
+                                              tree));
       break;
     case model::proto::Task::REGRESSION:
       RETURN_IF_ERROR(PruneTreeRegression(dataset, weights, example_idxs,
-                                          config, config_link, tree));
+                                          config, config_link, num_threads,
+                                          tree));
       break;
 
     case model::proto::Task::CATEGORICAL_UPLIFT:
       RETURN_IF_ERROR(PruneTreeUpliftCategorical(dataset, weights, example_idxs,
-                                                 config, config_link, tree));
+                                                 config, config_link,
+                                                 num_threads, tree));
       break;
 
     default:
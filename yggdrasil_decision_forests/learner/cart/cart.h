@@ -82,12 +82,14 @@ namespace internal {
 //
 // For each non-leaf node, test if the validation metric (accuracy or rmse)
 // would be better if the node was a leaf. If true, the node is turned into a
-// leaf and the children nodes are pruned.
+// leaf and the children nodes are pruned. Disjoint subtrees are pruned in
+// parallel with "num_threads" workers.
 absl::Status PruneTree(const dataset::VerticalDataset& train_dataset,
                        const std::vector<float>& weights,
                        const std::vector<UnsignedExampleIdx>& example_idxs,
                        const model::proto::TrainingConfig& config,
                        const model::proto::TrainingConfigLinking& config_link,
+                       int num_threads,
                        model::decision_tree::DecisionTree* tree);
 
 }  // namespace internal
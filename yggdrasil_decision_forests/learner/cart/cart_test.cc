@@ -205,7 +205,7 @@ TEST_F(CartPruningTest, PruneTree) {
   std::vector<float> weights = {1.f, 1.f, 1.f};
   std::vector<UnsignedExampleIdx> example_idxs = {0, 1, 2};
   EXPECT_OK(internal::PruneTree(dataset_, weights, example_idxs, config_,
-                                config_link_, &tree_));
+                                config_link_, /*num_threads=*/2, &tree_));
 
   // Note: There is only one way to prune the tree and make it having 3 nodes.
   EXPECT_EQ(tree_.NumNodes(), 3);
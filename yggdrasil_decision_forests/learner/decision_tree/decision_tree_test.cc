@@ -43,6 +43,7 @@
 #include "yggdrasil_decision_forests/learner/decision_tree/utils.h"
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/utils/bitmap.h"
 #include "yggdrasil_decision_forests/utils/distribution.h"
 #include "yggdrasil_decision_forests/utils/distribution.pb.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
@@ -58,6 +59,7 @@ namespace decision_tree {
 namespace {
 
 using test::EqualsProto;
+using testing::ElementsAre;
 
 std::string DatasetDir() {
   return file::JoinPath(
@@ -1136,7 +1138,7 @@ TEST(DecisionTree, FindBestCategoricalSplitCartBooleanForClassification) {
   EXPECT_EQ(FindSplitLabelClassificationFeatureBoolean(
                 selected_examples, weights, attributes, labels,
                 num_label_classes, false, min_num_obs, dt_config,
-                label_distribution, -1, &best_condition, &cache),
+                label_distribution, -1, {}, &best_condition, &cache),
             SplitSearchResult::kBetterSplitFound);
 
   EXPECT_EQ(best_condition.condition().type_case(),
@@ -1151,7 +1153,7 @@ TEST(DecisionTree, FindBestCategoricalSplitCartBooleanForClassification) {
   EXPECT_EQ(FindSplitLabelClassificationFeatureBoolean(
                 selected_examples, weights, attributes, labels,
                 num_label_classes, false, min_num_obs, dt_config,
-                label_distribution, -1, &best_condition, &cache),
+                label_distribution, -1, {}, &best_condition, &cache),
             SplitSearchResult::kNoBetterSplitFound);
   LOG(INFO) << "Condition:\n" << best_condition.DebugString();
 }
@@ -1202,6 +1204,284 @@ TEST(DecisionTree, FindBestCategoricalSplitCartBooleanForRegression) {
   LOG(INFO) << "Condition:\n" << best_condition.DebugString();
 }
 
+TEST(DecisionTree, IsDenseExampleRange) {
+  EXPECT_FALSE(IsDenseExampleRange({}));
+  EXPECT_TRUE(IsDenseExampleRange({0}));
+  EXPECT_TRUE(IsDenseExampleRange({0, 1, 2, 3}));
+  EXPECT_FALSE(IsDenseExampleRange({1, 2, 3}));
+  EXPECT_FALSE(IsDenseExampleRange({0, 2}));
+  // With a duplicate.
+  EXPECT_FALSE(IsDenseExampleRange({0, 1, 1, 3}));
+  // Non sorted.
+  EXPECT_FALSE(IsDenseExampleRange({0, 4, 2}));
+}
+
+TEST(DecisionTree, ComputeExclusiveBooleanFeatureBundles) {
+  dataset::VerticalDataset dataset;
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: BOOLEAN name: "a" }
+    columns { type: BOOLEAN name: "b" }
+    columns { type: BOOLEAN name: "c" }
+    columns { type: BOOLEAN name: "d" }
+  )pb");
+  dataset.set_data_spec(dataspec);
+  CHECK_OK(dataset.CreateColumnsFromDataspec());
+  const std::vector<std::vector<char>> values = {
+      {1, 0, 0, 0},  // "a"
+      {0, 1, 0, 0},  // "b": exclusive with "a".
+      {1, 1, 0, 0},  // "c": conflicts with both "a" and "b".
+      {0, 0, 1, 0},  // "d": exclusive with "a" and "b".
+  };
+  for (int col_idx = 0; col_idx < values.size(); col_idx++) {
+    auto* column = dataset
+                       .MutableColumnWithCastWithStatus<
+                           dataset::VerticalDataset::BooleanColumn>(col_idx)
+                       .value();
+    for (const char value : values[col_idx]) {
+      column->Add(value);
+    }
+  }
+  dataset.set_nrow(4);
+
+  model::proto::TrainingConfigLinking config_link;
+  for (int col_idx = 0; col_idx < values.size(); col_idx++) {
+    config_link.add_features(col_idx);
+  }
+
+  Preprocessing preprocessing;
+  CHECK_OK(ComputeExclusiveBooleanFeatureBundles(dataset, config_link,
+                                                 &preprocessing));
+
+  // "a", "b" and "d" are bundled together. The bundle of "c" only contains
+  // "c" and is discarded.
+  ASSERT_EQ(preprocessing.boolean_feature_bundles().size(), 1);
+  const auto& bundle = preprocessing.boolean_feature_bundles()[0];
+  EXPECT_THAT(bundle.features, ElementsAre(0, 1, 3));
+  EXPECT_THAT(bundle.values, ElementsAre(1, 2, 0, 3));
+  EXPECT_THAT(preprocessing.boolean_feature_to_bundle(),
+              ElementsAre(0, 0, -1, 0));
+}
+
+TEST(DecisionTree, FindSplitsExclusiveBooleanBundleClassification) {
+  dataset::VerticalDataset dataset;
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: BOOLEAN name: "a" }
+    columns { type: BOOLEAN name: "b" }
+  )pb");
+  dataset.set_data_spec(dataspec);
+  CHECK_OK(dataset.CreateColumnsFromDataspec());
+  const std::vector<std::vector<char>> values = {
+      {0, 1, 0, 1, 0, 0},  // "a"
+      {1, 0, 0, 0, 0, 1},  // "b": exclusive with "a".
+  };
+  for (int col_idx = 0; col_idx < values.size(); col_idx++) {
+    auto* column = dataset
+                       .MutableColumnWithCastWithStatus<
+                           dataset::VerticalDataset::BooleanColumn>(col_idx)
+                       .value();
+    for (const char value : values[col_idx]) {
+      column->Add(value);
+    }
+  }
+  dataset.set_nrow(6);
+
+  model::proto::TrainingConfigLinking config_link;
+  config_link.add_features(0);
+  config_link.add_features(1);
+
+  Preprocessing preprocessing;
+  CHECK_OK(ComputeExclusiveBooleanFeatureBundles(dataset, config_link,
+                                                 &preprocessing));
+  ASSERT_EQ(preprocessing.boolean_feature_bundles().size(), 1);
+  const auto& bundle = preprocessing.boolean_feature_bundles()[0];
+
+  const std::vector<UnsignedExampleIdx> selected_examples = {0, 1, 2, 3, 4, 5};
+  const std::vector<float> weights = {1, 1, 1, 1, 1, 1};
+  const std::vector<int32_t> labels = {1, 0, 0, 0, 0, 1};
+  const int32_t num_label_classes = 2;
+  const UnsignedExampleIdx min_num_obs = 1;
+
+  utils::IntegerDistributionDouble label_distribution;
+  label_distribution.SetNumClasses(num_label_classes);
+  for (int example_idx = 0; example_idx < selected_examples.size();
+       example_idx++) {
+    label_distribution.Add(labels[example_idx], weights[example_idx]);
+  }
+
+  // Reference: scan the feature "b" directly.
+  proto::DecisionTreeTrainingConfig dt_config;
+  proto::NodeCondition reference_condition;
+  SplitterPerThreadCache cache;
+  EXPECT_EQ(FindSplitLabelClassificationFeatureBoolean(
+                selected_examples, weights, values[1], labels,
+                num_label_classes, false, min_num_obs, dt_config,
+                label_distribution, 1, {}, &reference_condition, &cache),
+            SplitSearchResult::kBetterSplitFound);
+
+  // Evaluate both bundled features with a single scan.
+  proto::NodeCondition condition;
+  std::vector<SplitSearchResult> member_results;
+  FindSplitsLabelClassificationExclusiveBooleanBundle(
+      dataset, selected_examples, weights, bundle, /*member_features=*/{0, 1},
+      labels, num_label_classes, min_num_obs, label_distribution, &condition,
+      &member_results, &cache);
+
+  // Both features have a valid split, and "b" (which separates the labels
+  // perfectly) wins.
+  EXPECT_THAT(member_results, ElementsAre(SplitSearchResult::kBetterSplitFound,
+                                          SplitSearchResult::kBetterSplitFound));
+  EXPECT_EQ(condition.attribute(), 1);
+  EXPECT_EQ(condition.condition().type_case(),
+            proto::Condition::kTrueValueCondition);
+  EXPECT_EQ(condition.num_training_examples_without_weight(), 6);
+  EXPECT_EQ(condition.num_pos_training_examples_without_weight(), 2);
+  EXPECT_NEAR(condition.split_score(), reference_condition.split_score(),
+              0.0001);
+}
+
+TEST(DecisionTree, ComputePackedBooleanFeatures) {
+  dataset::VerticalDataset dataset;
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: BOOLEAN name: "a" }
+    columns {
+      type: CATEGORICAL
+      name: "label"
+      categorical { number_of_unique_values: 3 }
+    }
+  )pb");
+  dataset.set_data_spec(dataspec);
+  CHECK_OK(dataset.CreateColumnsFromDataspec());
+  const char na = dataset::VerticalDataset::BooleanColumn::kNaValue;
+  const std::vector<char> values = {1, 0, na, 1, 0};
+  const std::vector<int32_t> labels = {2, 1, 2, 1, 2};
+  auto* column = dataset
+                     .MutableColumnWithCastWithStatus<
+                         dataset::VerticalDataset::BooleanColumn>(0)
+                     .value();
+  auto* label_column = dataset
+                           .MutableColumnWithCastWithStatus<
+                               dataset::VerticalDataset::CategoricalColumn>(1)
+                           .value();
+  for (int example_idx = 0; example_idx < values.size(); example_idx++) {
+    column->Add(values[example_idx]);
+    label_column->Add(labels[example_idx]);
+  }
+  dataset.set_nrow(5);
+
+  model::proto::TrainingConfig config;
+  config.set_task(model::proto::Task::CLASSIFICATION);
+  model::proto::TrainingConfigLinking config_link;
+  config_link.add_features(0);
+  config_link.set_label(1);
+
+  Preprocessing preprocessing;
+  CHECK_OK(ComputePackedBooleanFeatures(dataset, config, config_link,
+                                        &preprocessing));
+
+  ASSERT_EQ(preprocessing.packed_boolean_features().size(), 2);
+  const auto& packed = preprocessing.packed_boolean_features()[0];
+  EXPECT_EQ(utils::bitmap::ToStringBit(packed.values, 5), "10010");
+  EXPECT_EQ(utils::bitmap::ToStringBit(packed.nas, 5), "00100");
+  // The second column is not a boolean input feature.
+  EXPECT_TRUE(preprocessing.packed_boolean_features()[1].values.empty());
+  EXPECT_EQ(utils::bitmap::ToStringBit(preprocessing.packed_binary_labels(), 5),
+            "10101");
+}
+
+TEST(DecisionTree, FindSplitBooleanFromPackedReplica) {
+  // Enough examples to exercise both the 64-examples words and the tail of
+  // the bitmaps.
+  const int num_examples = 70;
+  std::mt19937 random(1234);
+  std::vector<char> values;
+  std::vector<int32_t> labels;
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    const int value = random() % 3;
+    values.push_back(
+        (value == 2) ? dataset::VerticalDataset::BooleanColumn::kNaValue
+                     : value);
+    labels.push_back(1 + random() % 2);
+  }
+
+  dataset::VerticalDataset dataset;
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: BOOLEAN name: "a" }
+    columns {
+      type: CATEGORICAL
+      name: "label"
+      categorical { number_of_unique_values: 3 }
+    }
+  )pb");
+  dataset.set_data_spec(dataspec);
+  CHECK_OK(dataset.CreateColumnsFromDataspec());
+  auto* column = dataset
+                     .MutableColumnWithCastWithStatus<
+                         dataset::VerticalDataset::BooleanColumn>(0)
+                     .value();
+  auto* label_column = dataset
+                           .MutableColumnWithCastWithStatus<
+                               dataset::VerticalDataset::CategoricalColumn>(1)
+                           .value();
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    column->Add(values[example_idx]);
+    label_column->Add(labels[example_idx]);
+  }
+  dataset.set_nrow(num_examples);
+
+  model::proto::TrainingConfig config;
+  config.set_task(model::proto::Task::CLASSIFICATION);
+  model::proto::TrainingConfigLinking config_link;
+  config_link.add_features(0);
+  config_link.set_label(1);
+
+  Preprocessing preprocessing;
+  CHECK_OK(ComputePackedBooleanFeatures(dataset, config, config_link,
+                                        &preprocessing));
+
+  // A node containing two thirds of the examples.
+  std::vector<UnsignedExampleIdx> selected_examples;
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    if (example_idx % 3 != 1) {
+      selected_examples.push_back(example_idx);
+    }
+  }
+
+  const std::vector<float> weights;  // Unweighted.
+  const int32_t num_label_classes = 3;
+  const UnsignedExampleIdx min_num_obs = 1;
+  const proto::DecisionTreeTrainingConfig dt_config;
+
+  utils::IntegerDistributionDouble label_distribution;
+  label_distribution.SetNumClasses(num_label_classes);
+  for (const auto example_idx : selected_examples) {
+    label_distribution.Add(labels[example_idx]);
+  }
+
+  for (const bool na_replacement : {false, true}) {
+    // Reference: scan the "char" column directly.
+    proto::NodeCondition reference_condition;
+    SplitterPerThreadCache reference_cache;
+    const auto reference_result = FindSplitLabelClassificationFeatureBoolean(
+        selected_examples, weights, values, labels, num_label_classes,
+        na_replacement, min_num_obs, dt_config, label_distribution, 0, {},
+        &reference_condition, &reference_cache);
+
+    // Scan the bit-packed replica.
+    InternalTrainConfig internal_config;
+    internal_config.preprocessing = &preprocessing;
+    proto::NodeCondition condition;
+    SplitterPerThreadCache cache;
+    const auto result = FindSplitLabelClassificationFeatureBoolean(
+        selected_examples, weights, values, labels, num_label_classes,
+        na_replacement, min_num_obs, dt_config, label_distribution, 0,
+        internal_config, &condition, &cache);
+
+    EXPECT_EQ(result, reference_result);
+    EXPECT_EQ(result, SplitSearchResult::kBetterSplitFound);
+    EXPECT_THAT(condition, EqualsProto(reference_condition));
+  }
+}
+
 TEST(DecisionTree, LocalImputationForNumericalAttribute) {
   const std::vector<UnsignedExampleIdx> selected_examples = {0, 1, 2, 3, 4, 5};
   const std::vector<float> weights = {1.f, 1.f, 1.f, 1.f, 1.f, 1.f};
@@ -1365,7 +1645,7 @@ TEST(DecisionTree, LocalImputationForBooleanAttribute) {
   EXPECT_EQ(FindSplitLabelClassificationFeatureBoolean(
                 selected_examples, weights, attributes, labels,
                 num_label_classes, na_replacement, min_num_obs, dt_config,
-                label_distribution, -1, &best_condition, &cache),
+                label_distribution, -1, {}, &best_condition, &cache),
             SplitSearchResult::kBetterSplitFound);
 
   EXPECT_EQ(best_condition.condition().type_case(),
@@ -1379,14 +1659,14 @@ TEST(DecisionTree, LocalImputationForBooleanAttribute) {
   EXPECT_EQ(FindSplitLabelClassificationFeatureBoolean(
                 selected_examples, weights, attributes, labels,
                 num_label_classes, na_replacement, min_num_obs, dt_config,
-                label_distribution, -1, &best_condition, &cache),
+                label_distribution, -1, {}, &best_condition, &cache),
             SplitSearchResult::kNoBetterSplitFound);
 
   attributes = {1, 1, 1, 1, 1, 1};
   EXPECT_EQ(FindSplitLabelClassificationFeatureBoolean(
                 selected_examples, weights, attributes, labels,
                 num_label_classes, na_replacement, min_num_obs, dt_config,
-                label_distribution, -1, &best_condition, &cache),
+                label_distribution, -1, {}, &best_condition, &cache),
             SplitSearchResult::kInvalidAttribute);
 
   // Test majority positive case.
@@ -1396,7 +1676,8 @@ TEST(DecisionTree, LocalImputationForBooleanAttribute) {
   EXPECT_EQ(FindSplitLabelClassificationFeatureBoolean(
                 selected_examples, weights, attributes, labels,
                 num_label_classes, na_replacement, min_num_obs, dt_config,
-                label_distribution, -1, &best_condition_pos_na, &cache_pos_na),
+                label_distribution, -1, {},
+                &best_condition_pos_na, &cache_pos_na),
             SplitSearchResult::kBetterSplitFound);
 
   EXPECT_EQ(best_condition_pos_na.condition().type_case(),
@@ -2168,6 +2449,134 @@ TEST(DecisionTree, FindBestNumericalDiscretizedSplitCartBase) {
   EXPECT_EQ(best_condition.na_value(), false);
 }
 
+TEST(DecisionTree, FindBestHessianDiscretizedSplitCartBase) {
+  // More than 8 examples, so that the vectorized bucket filling (if compiled
+  // in) processes both a full block and a remainder.
+  const std::vector<UnsignedExampleIdx> selected_examples = {0, 1, 2, 3, 4, 5,
+                                                             6, 7, 8, 9, 10};
+  const std::vector<float> weights(selected_examples.size(), 1.f);
+
+  const int num_bins = 4;
+  // The best split is between bin 1 and bin 2.
+  const std::vector<dataset::DiscretizedNumericalIndex> attributes = {
+      0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3};
+  const std::vector<float> gradients = {-1.f, -1.f, -1.f, -1.f, -1.f, -1.f,
+                                        1.f,  1.f,  1.f,  1.f,  1.f};
+  const std::vector<float> hessians(selected_examples.size(), 1.f);
+
+  proto::DecisionTreeTrainingConfig dt_config;
+  InternalTrainConfig internal_config;
+  internal_config.use_hessian_gain = true;
+
+  proto::NodeCondition best_condition;
+  SplitterPerThreadCache cache;
+  EXPECT_EQ(FindSplitLabelHessianRegressionFeatureDiscretizedNumericalCart(
+                selected_examples, weights, attributes, num_bins, gradients,
+                hessians, /*na_replacement=*/0, /*min_num_obs=*/1, dt_config,
+                /*sum_gradient=*/-1., /*sum_hessian=*/11., /*sum_weights=*/11.,
+                /*attribute_idx=*/0, internal_config, &best_condition, &cache),
+            SplitSearchResult::kBetterSplitFound);
+
+  EXPECT_EQ(
+      best_condition.condition().discretized_higher_condition().threshold(), 2);
+  EXPECT_EQ(best_condition.num_training_examples_without_weight(), 11);
+  EXPECT_EQ(best_condition.num_pos_training_examples_without_weight(), 5);
+}
+
+TEST(DecisionTree, FindBestHessianDiscretizedSplitSiblingSubtraction) {
+  // Examples of a parent node and their partition into the two children.
+  const std::vector<UnsignedExampleIdx> parent_examples = {0, 1, 2, 3, 4, 5};
+  const std::vector<UnsignedExampleIdx> pos_examples = {3, 4, 5};
+  const std::vector<UnsignedExampleIdx> neg_examples = {0, 1, 2};
+  const std::vector<float> weights(parent_examples.size(), 1.f);
+
+  const int num_bins = 8;
+  const std::vector<dataset::DiscretizedNumericalIndex> attributes = {0, 1, 2,
+                                                                      4, 5, 6};
+  const std::vector<float> gradients = {-2.f, -2.f, 4.f, 4.f, 4.f, -8.f};
+  const std::vector<float> hessians(parent_examples.size(), 1.f);
+
+  proto::DecisionTreeTrainingConfig dt_config;
+  InternalTrainConfig internal_config;
+  internal_config.use_hessian_gain = true;
+
+  const auto sum_over = [&](const std::vector<UnsignedExampleIdx>& examples,
+                            const std::vector<float>& values) {
+    double sum = 0;
+    for (const auto example_idx : examples) {
+      sum += values[example_idx];
+    }
+    return sum;
+  };
+
+  const auto find_split = [&](const std::vector<UnsignedExampleIdx>& examples,
+                              proto::NodeCondition* condition,
+                              SplitterPerThreadCache* cache) {
+    return FindSplitLabelHessianRegressionFeatureDiscretizedNumericalCart(
+        examples, weights, attributes, num_bins, gradients, hessians,
+        /*na_replacement=*/0, /*min_num_obs=*/1, dt_config,
+        sum_over(examples, gradients), sum_over(examples, hessians),
+        /*sum_weights=*/examples.size(), /*attribute_idx=*/0, internal_config,
+        condition, cache);
+  };
+
+  // Reference: split of the negative child computed by scanning its examples.
+  proto::NodeCondition scan_condition;
+  SplitterPerThreadCache scan_cache;
+  EXPECT_EQ(find_split(neg_examples, &scan_condition, &scan_cache),
+            SplitSearchResult::kBetterSplitFound);
+
+  // Same split, with the histogram cache: scan the parent and the positive
+  // child, and derive the negative child by subtraction.
+  HessianHistogramCache histograms;
+  histograms.per_depth.push_back(
+      absl::make_unique<HessianHistogramCache::NodeHistograms>());
+  histograms.per_depth.push_back(
+      absl::make_unique<HessianHistogramCache::NodeHistograms>());
+  histograms.per_depth[0]->per_attribute.resize(1);
+  histograms.per_depth[1]->per_attribute.resize(1);
+
+  SplitterPerThreadCache cache;
+
+  // Parent node.
+  auto* parent_store = histograms.per_depth[0].get();
+  parent_store->node_id = ++histograms.last_node_id;
+  cache.hessian_histogram_store = parent_store;
+  proto::NodeCondition parent_condition;
+  EXPECT_EQ(find_split(parent_examples, &parent_condition, &cache),
+            SplitSearchResult::kBetterSplitFound);
+
+  // Positive child.
+  auto* child_store = histograms.per_depth[1].get();
+  child_store->node_id = ++histograms.last_node_id;
+  cache.hessian_histogram_store = child_store;
+  proto::NodeCondition pos_condition;
+  EXPECT_EQ(find_split(pos_examples, &pos_condition, &cache),
+            SplitSearchResult::kBetterSplitFound);
+
+  // Negative child. The entry of the positive child is re-used in place, as
+  // done by "NodeTrain".
+  const int64_t sibling_node_id = child_store->node_id;
+  child_store->node_id = ++histograms.last_node_id;
+  cache.hessian_histogram_store = child_store;
+  cache.hessian_histogram_parent = parent_store;
+  cache.hessian_histogram_sibling_node_id = sibling_node_id;
+  proto::NodeCondition derived_condition;
+  EXPECT_EQ(find_split(neg_examples, &derived_condition, &cache),
+            SplitSearchResult::kBetterSplitFound);
+
+  // The children of the parent split on disjoint bins: the derived histogram
+  // is exactly equal to the scanned one.
+  EXPECT_EQ(
+      derived_condition.condition().discretized_higher_condition().threshold(),
+      scan_condition.condition().discretized_higher_condition().threshold());
+  EXPECT_EQ(derived_condition.split_score(), scan_condition.split_score());
+  EXPECT_EQ(derived_condition.num_pos_training_examples_without_weight(),
+            scan_condition.num_pos_training_examples_without_weight());
+  // The entry now belongs to the negative child.
+  EXPECT_EQ(child_store->per_attribute[0].node_id, child_store->node_id);
+}
+
 TEST(UpliftCategoricalLabelDistribution, Base) {
   UpliftLabelDistribution dist;
 
@@ -2237,6 +2646,16 @@ TEST(UpliftCategoricalLabelDistribution, Base) {
   // Empty dist.
   dist2.Sub(dist);
   EXPECT_EQ(dist2.num_examples(), 0);
+
+  // Removing examples restores the previous statistics.
+  dist.SubCategoricalOutcome(/*outcome_value=*/2, /*treatment_value=*/2,
+                             /*weight=*/1.f);
+  dist.SubCategoricalOutcome(/*outcome_value=*/1, /*treatment_value=*/1,
+                             /*weight=*/1.f);
+  EXPECT_EQ(dist.num_examples(), 2);
+  EXPECT_EQ(dist.MeanOutcomePerTreatment(0), 1.0);
+  EXPECT_EQ(dist.MeanOutcomePerTreatment(1), 1.0);
+  EXPECT_EQ(dist.UpliftLeaf(), 0.);
 }
 
 TEST(UpliftCategoricalLabelDistribution, FromToLeafProto) {
@@ -2516,6 +2935,90 @@ TEST(DecisionTree, MinNumExamplePerTreatment) {
   }
 }
 
+// Splitting the examples of a node on the cached values of the winning
+// oblique projection is equivalent to re-evaluating the projection on every
+// example.
+TEST(DecisionTree, SplitExamplesWithCachedProjectionValues) {
+  const float na = std::numeric_limits<float>::quiet_NaN();
+  dataset::VerticalDataset dataset;
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "a" }
+    columns { type: NUMERICAL name: "b" }
+  )pb");
+  dataset.set_data_spec(dataspec);
+  CHECK_OK(dataset.CreateColumnsFromDataspec());
+  auto* col_a = dataset
+                    .MutableColumnWithCastWithStatus<
+                        dataset::VerticalDataset::NumericalColumn>(0)
+                    .value();
+  auto* col_b = dataset
+                    .MutableColumnWithCastWithStatus<
+                        dataset::VerticalDataset::NumericalColumn>(1)
+                    .value();
+  for (const float value : {0.f, 1.f, 2.f, 3.f, na}) {
+    col_a->Add(value);
+  }
+  for (const float value : {4.f, 3.f, 2.f, 1.f, 0.f}) {
+    col_b->Add(value);
+  }
+
+  // Condition: "a - b >= 0", with missing values evaluated positively.
+  proto::NodeCondition condition;
+  auto& oblique = *condition.mutable_condition()->mutable_oblique_condition();
+  oblique.add_attributes(0);
+  oblique.add_weights(1.f);
+  oblique.add_attributes(1);
+  oblique.add_weights(-1.f);
+  oblique.set_threshold(0.f);
+  condition.set_attribute(0);
+  condition.set_na_value(true);
+  condition.set_num_training_examples_without_weight(5);
+  condition.set_num_pos_training_examples_without_weight(3);
+
+  const std::vector<UnsignedExampleIdx> examples = {0, 1, 2, 3, 4};
+
+  // Split by re-evaluating the projection on every example.
+  std::vector<UnsignedExampleIdx> positive_examples, negative_examples;
+  CHECK_OK(internal::SplitExamples(
+      dataset, examples, condition, /*dataset_is_dense=*/false,
+      /*error_on_wrong_splitter_statistics=*/true, &positive_examples,
+      &negative_examples));
+  EXPECT_THAT(positive_examples, ElementsAre(2, 3, 4));
+  EXPECT_THAT(negative_examples, ElementsAre(0, 1));
+
+  // Split on the values cached by the sparse oblique splitter.
+  PerThreadCache cache;
+  cache.splitter_cache_list.resize(2);
+  cache.splitter_cache_list[1].best_projection_values = {-4.f, -2.f, 0.f, 2.f,
+                                                         na};
+  cache.splitter_cache_list[1].best_projection_condition = condition;
+  const auto* cached_values =
+      internal::FindCachedProjectionValues(condition, examples.size(), cache);
+  ASSERT_NE(cached_values, nullptr);
+  std::vector<UnsignedExampleIdx> cached_positive_examples,
+      cached_negative_examples;
+  CHECK_OK(internal::SplitExamples(
+      dataset, examples, condition, /*dataset_is_dense=*/false,
+      /*error_on_wrong_splitter_statistics=*/true, &cached_positive_examples,
+      &cached_negative_examples, /*examples_are_training_examples=*/true,
+      cached_values));
+  EXPECT_EQ(cached_positive_examples, positive_examples);
+  EXPECT_EQ(cached_negative_examples, negative_examples);
+
+  // The cached values only match the exact condition they were computed for,
+  // on the same number of examples.
+  proto::NodeCondition other_condition = condition;
+  other_condition.mutable_condition()
+      ->mutable_oblique_condition()
+      ->set_threshold(1.f);
+  EXPECT_EQ(internal::FindCachedProjectionValues(other_condition,
+                                                 examples.size(), cache),
+            nullptr);
+  EXPECT_EQ(internal::FindCachedProjectionValues(condition,
+                                                 examples.size() - 1, cache),
+            nullptr);
+}
+
 }  // namespace
 }  // namespace decision_tree
 }  // namespace model
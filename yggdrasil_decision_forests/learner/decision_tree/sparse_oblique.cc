@@ -15,6 +15,12 @@
 
 #include "yggdrasil_decision_forests/learner/decision_tree/sparse_oblique.h"
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <stdint.h>
+
 #include <algorithm>
 #include <cmath>
 #include <iterator>
@@ -176,29 +182,89 @@ class ProjectionEvaluator {
     }
   }
 
-  absl::Status Evaluate(const Projection& projection,
-                const std::vector<UnsignedExampleIdx>& selected_examples,
-                std::vector<float>* values) {
+  // Evaluates a batch of projections together. Equivalent to evaluating each
+  // projection with a separate pass over the examples, but the examples are
+  // processed in tiles so that the example indices and the touched regions of
+  // the feature columns stay in cache across the projections of the batch.
+  absl::Status EvaluateBatch(
+      const std::vector<Projection>& projections, const int num_projections,
+      const std::vector<UnsignedExampleIdx>& selected_examples,
+      std::vector<std::vector<float>>* values) {
     RETURN_IF_ERROR(constructor_status_);
-    values->resize(selected_examples.size());
-    for (size_t selected_idx = 0; selected_idx < selected_examples.size();
-         selected_idx++) {
+    DCHECK_LE(num_projections, projections.size());
+    DCHECK_LE(num_projections, values->size());
+    const size_t num_selected_examples = selected_examples.size();
+    for (int projection_idx = 0; projection_idx < num_projections;
+         projection_idx++) {
+      (*values)[projection_idx].resize(num_selected_examples);
+      for (const auto& item : projections[projection_idx]) {
+        DCHECK_LT(item.attribute_idx, numerical_attributes_.size());
+        DCHECK_GE(item.attribute_idx, 0);
+        DCHECK(numerical_attributes_[item.attribute_idx] != nullptr);
+      }
+    }
+
+    // Number of examples evaluated together. Multiple of the AVX2 block size.
+    constexpr size_t kTileSize = 2048;
+    for (size_t begin_idx = 0; begin_idx < num_selected_examples;
+         begin_idx += kTileSize) {
+      const size_t end_idx =
+          std::min(begin_idx + kTileSize, num_selected_examples);
+      for (int projection_idx = 0; projection_idx < num_projections;
+           projection_idx++) {
+        EvaluateRange(projections[projection_idx], selected_examples, begin_idx,
+                      end_idx, (*values)[projection_idx].data());
+      }
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  // Evaluates a projection on the examples
+  // "selected_examples[begin_idx..end_idx)". Writes the projection values in
+  // "values[begin_idx..end_idx)".
+  void EvaluateRange(const Projection& projection,
+                     const std::vector<UnsignedExampleIdx>& selected_examples,
+                     const size_t begin_idx, const size_t end_idx,
+                     float* values) const {
+    size_t selected_idx = begin_idx;
+
+#ifdef __AVX2__
+    // Vectorized evaluation: the feature values of blocks of 8 examples are
+    // gathered with AVX2 instructions and accumulated with multiply-adds.
+    if constexpr (sizeof(UnsignedExampleIdx) == sizeof(int32_t)) {
+      constexpr size_t kBlockSize = 8;
+      for (; selected_idx + kBlockSize <= end_idx;
+           selected_idx += kBlockSize) {
+        const __m256i example_idxs = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(selected_examples.data() +
+                                             selected_idx));
+        __m256 accumulator = _mm256_setzero_ps();
+        for (const auto& item : projection) {
+          const __m256 attribute_values = _mm256_i32gather_ps(
+              numerical_attributes_[item.attribute_idx]->data(), example_idxs,
+              4);
+          accumulator = _mm256_add_ps(
+              accumulator,
+              _mm256_mul_ps(attribute_values, _mm256_set1_ps(item.weight)));
+        }
+        _mm256_storeu_ps(values + selected_idx, accumulator);
+      }
+    }
+#endif  // __AVX2__
+
+    for (; selected_idx < end_idx; selected_idx++) {
       float value = 0;
       const auto example_idx = selected_examples[selected_idx];
       for (const auto& item : projection) {
-        DCHECK_LT(item.attribute_idx, numerical_attributes_.size());
-        DCHECK_GE(item.attribute_idx, 0);
         const auto* attribute_values =
             numerical_attributes_[item.attribute_idx];
-        DCHECK(attribute_values != nullptr);
         value += (*attribute_values)[example_idx] * item.weight;
       }
-      (*values)[selected_idx] = value;
+      values[selected_idx] = value;
     }
-    return absl::OkStatus();
   }
 
- private:
   // Non-owning pointer to numerical attributes.
   std::vector<const std::vector<float>*> numerical_attributes_;
   absl::Status constructor_status_;
@@ -241,22 +307,30 @@ utils::StatusOr<bool> FindBestConditionSparseObliqueTemplate(
     const proto::DecisionTreeTrainingConfig& dt_config,
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const LabelStats& label_stats,
-    const absl::optional<int>& override_num_projections,
+    const absl::optional<ObliqueProjectionSlice>& projection_slice,
     proto::NodeCondition* best_condition, utils::RandomEngine* random,
     SplitterPerThreadCache* cache) {
   if (config_link.numerical_features().empty()) {
     return false;
   }
 
-  // Effective number of projections to test.
+  // Effective number of projections to test and index of the first projection.
   int num_projections;
-  if (override_num_projections.has_value()) {
-    num_projections = override_num_projections.value();
+  int first_projection_idx = 0;
+  if (projection_slice.has_value()) {
+    num_projections = projection_slice->num_projections;
+    first_projection_idx = projection_slice->begin;
   } else {
     num_projections =
         GetNumProjections(dt_config, config_link.numerical_features_size());
   }
 
+  // Each projection is sampled with a generator seeded from "projection_seed"
+  // and the index of the projection. The sampled projections are therefore
+  // independent of how the projection search is sliced into work units (i.e.
+  // of the number of threads).
+  const uint64_t projection_seed = (*random)();
+
   const float projection_density =
       dt_config.sparse_oblique_split().projection_density_factor() /
       config_link.numerical_features_size();
@@ -266,10 +340,13 @@ utils::StatusOr<bool> FindBestConditionSparseObliqueTemplate(
   // Best and current projections.
   Projection best_projection;
   float best_projection_threshold = 0;
-  Projection current_projection;
   float best_na_replacement = 0;
   auto& projection_values = cache->projection_values;
 
+  // Invalidate the projection values possibly cached by a previous node.
+  cache->best_projection_values.clear();
+  cache->best_projection_condition.Clear();
+
   ProjectionEvaluator projection_evaluator(train_dataset,
                                            config_link.numerical_features());
 
@@ -280,53 +357,80 @@ utils::StatusOr<bool> FindBestConditionSparseObliqueTemplate(
   std::vector<UnsignedExampleIdx> dense_example_idxs(selected_examples.size());
   std::iota(dense_example_idxs.begin(), dense_example_idxs.end(), 0);
 
-  for (int projection_idx = 0; projection_idx < num_projections;
-       projection_idx++) {
-    // Generate a current_projection.
-    SampleProjection(dt_config, train_dataset.data_spec(),
-                     config_link.numerical_features(), projection_density,
-                     &current_projection, random);
-
-    // Pre-compute the result of the current_projection.
-    RETURN_IF_ERROR(projection_evaluator.Evaluate(
-        current_projection, selected_examples, &projection_values));
-
-    const auto na_replacement =
-        DefaultProjectionValue(current_projection, train_dataset.data_spec());
-
-    // Find a good split in the current_projection.
-    SplitSearchResult result;
-    if constexpr (is_same<LabelStats, ClassificationLabelStats>::value) {
-      result = FindSplitLabelClassificationFeatureNumericalCart(
-          dense_example_idxs, selected_weights, projection_values,
-          selected_labels, label_stats.num_label_classes, na_replacement,
-          min_num_obs, dt_config, label_stats.label_distribution,
-          current_projection.front().attribute_idx, {}, best_condition, cache);
-    } else if constexpr (is_same<LabelStats,
-                                 RegressionHessianLabelStats>::value) {
-      result = FindSplitLabelHessianRegressionFeatureNumericalCart(
-          dense_example_idxs, selected_weights, projection_values,
-          selected_labels.gradient_data, selected_labels.hessian_data,
-          na_replacement, min_num_obs, dt_config, label_stats.sum_gradient,
-          label_stats.sum_hessian, label_stats.sum_weights,
-          current_projection.front().attribute_idx, internal_config,
-          best_condition, cache);
-    } else if constexpr (is_same<LabelStats, RegressionLabelStats>::value) {
-      result = FindSplitLabelRegressionFeatureNumericalCart(
-          dense_example_idxs, selected_weights, projection_values,
-          selected_labels, na_replacement, min_num_obs, dt_config,
-          label_stats.label_distribution,
-          current_projection.front().attribute_idx, {}, best_condition, cache);
-    } else {
-      static_assert(!is_same<LabelStats, LabelStats>::value,
-                    "Not implemented.");
+  // Number of projections evaluated with a single pass over the examples.
+  constexpr int kProjectionBatchSize = 16;
+
+  std::vector<Projection> batch_projections(
+      std::min(num_projections, kProjectionBatchSize));
+  if (projection_values.size() < batch_projections.size()) {
+    projection_values.resize(batch_projections.size());
+  }
+
+  for (int batch_begin = 0; batch_begin < num_projections;
+       batch_begin += kProjectionBatchSize) {
+    const int batch_size =
+        std::min(kProjectionBatchSize, num_projections - batch_begin);
+
+    // Generate the projections of the batch.
+    for (int batch_idx = 0; batch_idx < batch_size; batch_idx++) {
+      utils::RandomEngine projection_random(utils::DeriveSeed(
+          projection_seed, first_projection_idx + batch_begin + batch_idx));
+      SampleProjection(dt_config, train_dataset.data_spec(),
+                       config_link.numerical_features(), projection_density,
+                       &batch_projections[batch_idx], &projection_random);
     }
 
-    if (result == SplitSearchResult::kBetterSplitFound) {
-      best_projection = current_projection;
-      best_projection_threshold =
-          best_condition->condition().higher_condition().threshold();
-      best_na_replacement = na_replacement;
+    // Pre-compute the result of the projections of the batch.
+    RETURN_IF_ERROR(projection_evaluator.EvaluateBatch(
+        batch_projections, batch_size, selected_examples, &projection_values));
+
+    for (int batch_idx = 0; batch_idx < batch_size; batch_idx++) {
+      const auto& current_projection = batch_projections[batch_idx];
+      const auto& current_projection_values = projection_values[batch_idx];
+
+      const auto na_replacement =
+          DefaultProjectionValue(current_projection, train_dataset.data_spec());
+
+      // Find a good split in the current_projection.
+      SplitSearchResult result;
+      if constexpr (is_same<LabelStats, ClassificationLabelStats>::value) {
+        result = FindSplitLabelClassificationFeatureNumericalCart(
+            dense_example_idxs, selected_weights, current_projection_values,
+            selected_labels, label_stats.num_label_classes, na_replacement,
+            min_num_obs, dt_config, label_stats.label_distribution,
+            current_projection.front().attribute_idx, {}, best_condition,
+            cache);
+      } else if constexpr (is_same<LabelStats,
+                                   RegressionHessianLabelStats>::value) {
+        result = FindSplitLabelHessianRegressionFeatureNumericalCart(
+            dense_example_idxs, selected_weights, current_projection_values,
+            selected_labels.gradient_data, selected_labels.hessian_data,
+            na_replacement, min_num_obs, dt_config, label_stats.sum_gradient,
+            label_stats.sum_hessian, label_stats.sum_weights,
+            current_projection.front().attribute_idx, internal_config,
+            best_condition, cache);
+      } else if constexpr (is_same<LabelStats, RegressionLabelStats>::value) {
+        result = FindSplitLabelRegressionFeatureNumericalCart(
+            dense_example_idxs, selected_weights, current_projection_values,
+            selected_labels, na_replacement, min_num_obs, dt_config,
+            label_stats.label_distribution,
+            current_projection.front().attribute_idx, {}, best_condition,
+            cache);
+      } else {
+        static_assert(!is_same<LabelStats, LabelStats>::value,
+                      "Not implemented.");
+      }
+
+      if (result == SplitSearchResult::kBetterSplitFound) {
+        best_projection = current_projection;
+        best_projection_threshold =
+            best_condition->condition().higher_condition().threshold();
+        best_na_replacement = na_replacement;
+        // Keep the values of the winning projection: if this condition is the
+        // final condition of the node, the split application re-uses them
+        // instead of re-evaluating the projection on every example.
+        cache->best_projection_values = current_projection_values;
+      }
     }
   }
 
@@ -334,6 +438,9 @@ utils::StatusOr<bool> FindBestConditionSparseObliqueTemplate(
   if (!best_projection.empty()) {
     RETURN_IF_ERROR(SetCondition(best_projection, best_projection_threshold,
                                  best_na_replacement, best_condition));
+    // Tag the cached projection values with the condition they belong to (see
+    // "FindCachedProjectionValues").
+    cache->best_projection_condition = *best_condition;
     return true;
   }
 
@@ -349,12 +456,12 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
     const proto::DecisionTreeTrainingConfig& dt_config,
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const ClassificationLabelStats& label_stats,
-    const absl::optional<int>& override_num_projections,
+    const absl::optional<ObliqueProjectionSlice>& projection_slice,
     proto::NodeCondition* best_condition, utils::RandomEngine* random,
     SplitterPerThreadCache* cache) {
   return FindBestConditionSparseObliqueTemplate<ClassificationLabelStats>(
       train_dataset, selected_examples, weights, config, config_link, dt_config,
-      parent, internal_config, label_stats, override_num_projections,
+      parent, internal_config, label_stats, projection_slice,
       best_condition, random, cache);
 }
 
@@ -367,12 +474,12 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
     const proto::DecisionTreeTrainingConfig& dt_config,
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const RegressionHessianLabelStats& label_stats,
-    const absl::optional<int>& override_num_projections,
+    const absl::optional<ObliqueProjectionSlice>& projection_slice,
     proto::NodeCondition* best_condition, utils::RandomEngine* random,
     SplitterPerThreadCache* cache) {
   return FindBestConditionSparseObliqueTemplate<RegressionHessianLabelStats>(
       train_dataset, selected_examples, weights, config, config_link, dt_config,
-      parent, internal_config, label_stats, override_num_projections,
+      parent, internal_config, label_stats, projection_slice,
       best_condition, random, cache);
 }
 
@@ -385,12 +492,12 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
     const proto::DecisionTreeTrainingConfig& dt_config,
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const RegressionLabelStats& label_stats,
-    const absl::optional<int>& override_num_projections,
+    const absl::optional<ObliqueProjectionSlice>& projection_slice,
     proto::NodeCondition* best_condition, utils::RandomEngine* random,
     SplitterPerThreadCache* cache) {
   return FindBestConditionSparseObliqueTemplate<RegressionLabelStats>(
       train_dataset, selected_examples, weights, config, config_link, dt_config,
-      parent, internal_config, label_stats, override_num_projections,
+      parent, internal_config, label_stats, projection_slice,
       best_condition, random, cache);
 }
 
@@ -59,7 +59,7 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
     const proto::DecisionTreeTrainingConfig& dt_config,
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const ClassificationLabelStats& label_stats,
-    const absl::optional<int>& override_num_projections,
+    const absl::optional<ObliqueProjectionSlice>& projection_slice,
     proto::NodeCondition* best_condition, utils::RandomEngine* random,
     SplitterPerThreadCache* cache);
 
@@ -73,7 +73,7 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
     const proto::DecisionTreeTrainingConfig& dt_config,
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const RegressionHessianLabelStats& label_stats,
-    const absl::optional<int>& override_num_projections,
+    const absl::optional<ObliqueProjectionSlice>& projection_slice,
     proto::NodeCondition* best_condition, utils::RandomEngine* random,
     SplitterPerThreadCache* cache);
 
@@ -87,7 +87,7 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
     const proto::DecisionTreeTrainingConfig& dt_config,
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const RegressionLabelStats& label_stats,
-    const absl::optional<int>& override_num_projections,
+    const absl::optional<ObliqueProjectionSlice>& projection_slice,
     proto::NodeCondition* best_condition, utils::RandomEngine* random,
     SplitterPerThreadCache* cache);
 
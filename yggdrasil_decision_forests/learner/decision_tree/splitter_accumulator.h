@@ -84,6 +84,15 @@ struct IntegerValueOnly {
   int value;
 };
 
+struct FloatValueAndWeight {
+  float value;
+  float weight;
+};
+
+struct FloatValueOnly {
+  float value;
+};
+
 struct SumTruesAndWeights {
   double sum_trues;
   double sum_weights;
@@ -802,17 +811,32 @@ struct LabelHessianNumericalScoreAccumulator {
 // double NormalizeScore(const double score) const;
 //
 
+template <bool weighted>
 struct LabelNumericalOneValueBucket {
-  float value;
-  float weight;
+  typedef typename std::conditional_t<weighted, internal::FloatValueAndWeight,
+                                      internal::FloatValueOnly>
+      ValueAndMaybeWeight;
+  ValueAndMaybeWeight content;
+
+  // Not called "kCount" because this is used as a template parameter and
+  // expects the name to be `count` (in other such structs it is not a
+  // constant).
   static constexpr int count = 1;  // NOLINT
 
   void AddToScoreAcc(LabelNumericalScoreAccumulator* acc) const {
-    acc->label.Add(value, weight);
+    if constexpr (weighted) {
+      acc->label.Add(content.value, content.weight);
+    } else {
+      acc->label.Add(content.value);
+    }
   }
 
   void SubToScoreAcc(LabelNumericalScoreAccumulator* acc) const {
-    acc->label.Sub(value, weight);
+    if constexpr (weighted) {
+      acc->label.Sub(content.value, content.weight);
+    } else {
+      acc->label.Sub(content.value);
+    }
   }
 
   class Initializer {
@@ -852,51 +876,76 @@ struct LabelNumericalOneValueBucket {
    public:
     Filler(const std::vector<float>& label, const std::vector<float>& weights)
         : label_(label), weights_(weights) {
-      DCHECK_EQ(weights.size(), label.size());
+      if constexpr (weighted) {
+        DCHECK_EQ(weights.size(), label.size());
+      } else {
+        DCHECK(weights.empty());
+      }
     }
 
-    void InitializeAndZero(LabelNumericalOneValueBucket* acc) const {}
+    void InitializeAndZero(
+        LabelNumericalOneValueBucket<weighted>* acc) const {}
 
-    void Finalize(LabelNumericalOneValueBucket* acc) const {}
+    void Finalize(LabelNumericalOneValueBucket<weighted>* acc) const {}
 
     void ConsumeExample(const UnsignedExampleIdx example_idx,
-                        LabelNumericalOneValueBucket* acc) const {
-      acc->value = label_[example_idx];
-      acc->weight = weights_[example_idx];
+                        LabelNumericalOneValueBucket<weighted>* acc) const {
+      acc->content.value = label_[example_idx];
+      if constexpr (weighted) {
+        acc->content.weight = weights_[example_idx];
+      }
     }
 
     template <typename ExampleIdx>
     void AddDirectToScoreAcc(const ExampleIdx example_idx,
                              LabelNumericalScoreAccumulator* acc) const {
-      acc->label.Add(label_[example_idx], weights_[example_idx]);
+      if constexpr (weighted) {
+        acc->label.Add(label_[example_idx], weights_[example_idx]);
+      } else {
+        acc->label.Add(label_[example_idx]);
+      }
     }
 
     template <typename ExampleIdx>
     void SubDirectToScoreAcc(const ExampleIdx example_idx,
                              LabelNumericalScoreAccumulator* acc) const {
-      acc->label.Sub(label_[example_idx], weights_[example_idx]);
+      if constexpr (weighted) {
+        acc->label.Sub(label_[example_idx], weights_[example_idx]);
+      } else {
+        acc->label.Sub(label_[example_idx]);
+      }
     }
 
     template <typename ExampleIdx>
     void AddDirectToScoreAccWithDuplicates(
         const ExampleIdx example_idx, const int num_duplicates,
         LabelNumericalScoreAccumulator* acc) const {
-      acc->label.Add(label_[example_idx],
-                     weights_[example_idx] * num_duplicates);
+      if constexpr (weighted) {
+        acc->label.Add(label_[example_idx],
+                       weights_[example_idx] * num_duplicates);
+      } else {
+        acc->label.Add(label_[example_idx], num_duplicates);
+      }
     }
 
     template <typename ExampleIdx>
     void SubDirectToScoreAccWithDuplicates(
         const ExampleIdx example_idx, const int num_duplicates,
         LabelNumericalScoreAccumulator* acc) const {
-      acc->label.Sub(label_[example_idx],
-                     weights_[example_idx] * num_duplicates);
+      if constexpr (weighted) {
+        acc->label.Sub(label_[example_idx],
+                       weights_[example_idx] * num_duplicates);
+      } else {
+        acc->label.Sub(label_[example_idx], num_duplicates);
+      }
     }
 
     template <typename ExampleIdx>
     void Prefetch(const ExampleIdx example_idx) const {
       PREFETCH(&label_[example_idx]);
-      PREFETCH(&weights_[example_idx]);
+      if constexpr (weighted) {
+        PREFETCH(&weights_[example_idx]);
+      }
     }
 
    private:
@@ -908,13 +957,21 @@ struct LabelNumericalOneValueBucket {
                                   const LabelNumericalOneValueBucket& data);
 };
 
-inline std::ostream& operator<<(std::ostream& os,
-                                const LabelNumericalOneValueBucket& data) {
-  os << "value:" << data.value << " weight:" << data.weight
+inline std::ostream& operator<<(
+    std::ostream& os,
+    const LabelNumericalOneValueBucket</*weighted=*/true>& data) {
+  os << "value:" << data.content.value << " weight:" << data.content.weight
      << " count:" << data.count;
   return os;
 }
 
+inline std::ostream& operator<<(
+    std::ostream& os,
+    const LabelNumericalOneValueBucket</*weighted=*/false>& data) {
+  os << "value:" << data.content.value << " count:" << data.count;
+  return os;
+}
+
 struct LabelHessianNumericalOneValueBucket {
   float gradient;
   float hessian;
@@ -1384,6 +1441,7 @@ inline std::ostream& operator<<(
   return os;
 }
 
+template <bool weighted>
 struct LabelNumericalBucket {
   utils::NormalDistributionDouble value;
   int64_t count;
@@ -1401,6 +1459,11 @@ struct LabelNumericalBucket {
     dst->count += count;
   }
 
+  void SubFromBucket(LabelNumericalBucket* dst) const {
+    dst->value.Sub(value);
+    dst->count -= count;
+  }
+
   bool operator<(const LabelNumericalBucket& other) const {
     return value.Mean() < other.value.Mean();
   }
@@ -1448,7 +1511,11 @@ struct LabelNumericalBucket {
    public:
     Filler(const std::vector<float>& label, const std::vector<float>& weights)
         : label_(label), weights_(weights) {
-      DCHECK_EQ(weights.size(), label.size());
+      if constexpr (weighted) {
+        DCHECK_EQ(weights.size(), label.size());
+      } else {
+        DCHECK(weights.empty());
+      }
     }
 
     void InitializeAndZero(LabelNumericalBucket* acc) const {
@@ -1460,7 +1527,11 @@ struct LabelNumericalBucket {
 
     void ConsumeExample(const UnsignedExampleIdx example_idx,
                         LabelNumericalBucket* acc) const {
-      acc->value.Add(label_[example_idx], weights_[example_idx]);
+      if constexpr (weighted) {
+        acc->value.Add(label_[example_idx], weights_[example_idx]);
+      } else {
+        acc->value.Add(label_[example_idx]);
+      }
       acc->count++;
     }
 
@@ -1474,7 +1545,14 @@ struct LabelNumericalBucket {
 };
 
 inline std::ostream& operator<<(std::ostream& os,
-                                const LabelNumericalBucket& data) {
+                                const LabelNumericalBucket<true>& data) {
+  os << "value:{mean:" << data.value.Mean()
+     << " obs:" << data.value.NumObservations() << "} count:" << data.count;
+  return os;
+}
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const LabelNumericalBucket<false>& data) {
   os << "value:{mean:" << data.value.Mean()
      << " obs:" << data.value.NumObservations() << "} count:" << data.count;
   return os;
@@ -1575,6 +1653,23 @@ struct LabelHessianNumericalBucket {
     acc->Sub(sum_gradient, sum_hessian, sum_weight);
   }
 
+  void AddToBucket(LabelHessianNumericalBucket* dst) const {
+    dst->sum_gradient += sum_gradient;
+    dst->sum_hessian += sum_hessian;
+    dst->sum_weight += sum_weight;
+    dst->count += count;
+  }
+
+  // Removes the content of this bucket from "dst". Used to derive the buckets
+  // of a node from the buckets of its parent and sibling. Note: "priority" is
+  // not updated; call "Filler::Finalize" on "dst" afterwards.
+  void SubFromBucket(LabelHessianNumericalBucket* dst) const {
+    dst->sum_gradient -= sum_gradient;
+    dst->sum_hessian -= sum_hessian;
+    dst->sum_weight -= sum_weight;
+    dst->count -= count;
+  }
+
   bool operator<(const LabelHessianNumericalBucket& other) const {
     return priority < priority;
   }
@@ -1671,6 +1766,22 @@ struct LabelHessianNumericalBucket {
       acc->count++;
     }
 
+    // Same as "ConsumeExample", with label data already gathered from the
+    // label columns (e.g. with SIMD gather instructions).
+    void ConsumeGatheredExample(const float gradient, const float hessian,
+                                const float weight,
+                                LabelHessianNumericalBucket* acc) const {
+      acc->sum_gradient += gradient;
+      acc->sum_hessian += hessian;
+      acc->sum_weight += weight;
+      acc->count++;
+    }
+
+    // Direct access to the label data. Used by the vectorized bucket filling.
+    const std::vector<float>& gradients() const { return gradients_; }
+    const std::vector<float>& hessians() const { return hessians_; }
+    const std::vector<float>& weights() const { return weights_; }
+
    private:
     const std::vector<float>& gradients_;
     const std::vector<float>& hessians_;
@@ -1694,15 +1805,19 @@ inline std::ostream& operator<<(std::ostream& os,
 
 template <bool weighted>
 struct LabelCategoricalBucket {
-  utils::IntegerDistributionDouble value;
+  // The per-bucket label counts are stored sparsely: with an extreme
+  // multi-class label, each bucket generally only observes a small subset of
+  // the classes and a dense count vector per bucket would be prohibitively
+  // large.
+  utils::SparseIntegerDistributionDouble value;
   int64_t count;
 
   void AddToScoreAcc(LabelCategoricalScoreAccumulator* acc) const {
-    acc->label.Add(value);
+    value.AddTo(&acc->label);
   }
 
   void SubToScoreAcc(LabelCategoricalScoreAccumulator* acc) const {
-    acc->label.Sub(value);
+    value.SubTo(&acc->label);
   }
 
   void AddToBucket(LabelCategoricalBucket* dst) const {
@@ -1710,6 +1825,11 @@ struct LabelCategoricalBucket {
     dst->count += count;
   }
 
+  void SubFromBucket(LabelCategoricalBucket* dst) const {
+    dst->value.Sub(value);
+    dst->count -= count;
+  }
+
   float SafeProportionOrMinusInfinity(int idx) const {
     return value.SafeProportionOrMinusInfinity(idx);
   }
@@ -1803,7 +1923,7 @@ struct LabelCategoricalBucket {
   };
 
   friend std::ostream& operator<<(std::ostream& os,
-                                  const LabelNumericalBucket& data);
+                                  const LabelCategoricalBucket& data);
 };
 
 inline std::ostream& operator<<(std::ostream& os,
@@ -1844,6 +1964,22 @@ struct LabelBinaryCategoricalBucket {
     }
   }
 
+  void AddToBucket(LabelBinaryCategoricalBucket* dst) const {
+    dst->content.sum_trues += content.sum_trues;
+    if constexpr (weighted) {
+      dst->content.sum_weights += content.sum_weights;
+    }
+    dst->count += count;
+  }
+
+  void SubFromBucket(LabelBinaryCategoricalBucket* dst) const {
+    dst->content.sum_trues -= content.sum_trues;
+    if constexpr (weighted) {
+      dst->content.sum_weights -= content.sum_weights;
+    }
+    dst->count -= count;
+  }
+
   float SafeProportionOrMinusInfinity(int idx) const {
     double sum_trues = content.sum_trues;
     double sum_weights;
@@ -1942,7 +2078,7 @@ struct LabelBinaryCategoricalBucket {
   };
 
   friend std::ostream& operator<<(std::ostream& os,
-                                  const LabelNumericalBucket& data);
+                                  const LabelBinaryCategoricalBucket& data);
 };
 
 inline std::ostream& operator<<(
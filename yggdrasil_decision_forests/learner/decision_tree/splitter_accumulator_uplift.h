@@ -99,13 +99,13 @@ struct UpliftLabelDistribution {
     sum_weights_per_treatment_[treatment_value] += weight;
     num_examples_per_treatment_[treatment_value] += num_examples;
 
-    // The zero outcome is ignored.
-    if (outcome_value >= 2) {
-      outcome_value -= 2;
-      sum_weights_per_treatment_and_outcome_
-          [treatment_value +
-           outcome_value * sum_weights_per_treatment_.size()] += weight;
-    }
+    // Branchless accumulation of the (binary) outcome: "outcome_value - 1" is
+    // the outcome indicator in {0, 1}, so the negative outcome contributes
+    // zero weight. This replaces a branch on the outcome value, which is
+    // unpredictable on shuffled training examples and stalls the splitter
+    // scan.
+    sum_weights_per_treatment_and_outcome_[treatment_value] +=
+        weight * static_cast<float>(outcome_value - 1);
   }
 
   void AddNumericalOutcome(float outcome_value, int treatment_value,
@@ -146,11 +146,14 @@ struct UpliftLabelDistribution {
 
     sum_weights_ += src.sum_weights_;
 
+    // One loop per array (instead of one joint loop) so that each loop
+    // operates on a single element type and can be vectorized.
     for (size_t i = 0; i < sum_weights_per_treatment_.size(); i++) {
       sum_weights_per_treatment_[i] += src.sum_weights_per_treatment_[i];
+    }
+    for (size_t i = 0; i < num_examples_per_treatment_.size(); i++) {
       num_examples_per_treatment_[i] += src.num_examples_per_treatment_[i];
     }
-
     for (size_t i = 0; i < sum_weights_per_treatment_and_outcome_.size(); i++) {
       sum_weights_per_treatment_and_outcome_[i] +=
           src.sum_weights_per_treatment_and_outcome_[i];
@@ -167,9 +170,10 @@ struct UpliftLabelDistribution {
 
     for (size_t i = 0; i < sum_weights_per_treatment_.size(); i++) {
       sum_weights_per_treatment_[i] -= src.sum_weights_per_treatment_[i];
+    }
+    for (size_t i = 0; i < num_examples_per_treatment_.size(); i++) {
       num_examples_per_treatment_[i] -= src.num_examples_per_treatment_[i];
     }
-
     for (size_t i = 0; i < sum_weights_per_treatment_and_outcome_.size(); i++) {
       sum_weights_per_treatment_and_outcome_[i] -=
           src.sum_weights_per_treatment_and_outcome_[i];
@@ -0,0 +1,338 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Microbenchmarks of the splitter kernels i.e. the
+// "FindSplitLabel{label}Feature{feature}" functions instantiating the
+// "ExampleBucketSet" templates of splitter_scanner.h and
+// splitter_accumulator.h. The kernels are exercised on synthetic node data
+// for the feature types {numerical, discretized numerical, categorical} and
+// the label types {classification, regression, hessian regression}.
+//
+// The reported "items_per_second" is the number of examples scanned per
+// second i.e. the inverse of the ns/example cost of a kernel.
+//
+// Usage example:
+//
+//   bazel run -c opt --copt=-mfma --copt=-mavx2 \
+//     //yggdrasil_decision_forests/learner/decision_tree:splitter_benchmark
+//
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
+#include "yggdrasil_decision_forests/learner/decision_tree/training.h"
+#include "yggdrasil_decision_forests/utils/distribution.h"
+
+namespace yggdrasil_decision_forests {
+namespace model {
+namespace decision_tree {
+namespace {
+
+// Shape of the synthetic node data.
+constexpr int kNumDiscretizedBins = 64;
+constexpr int kNumAttributeClasses = 32;
+constexpr int kNumLabelClasses = 3;  // Binary classification + OOV item.
+
+// Synthetic data of a node during training. All the examples are selected,
+// the attribute and label values are sampled i.i.d. and there are no missing
+// values.
+struct NodeData {
+  std::vector<UnsignedExampleIdx> selected_examples;
+  std::vector<float> weights;
+  std::vector<float> numerical_attributes;
+  std::vector<dataset::DiscretizedNumericalIndex> discretized_attributes;
+  std::vector<int32_t> categorical_attributes;
+  std::vector<int32_t> classification_labels;
+  std::vector<float> regression_labels;
+  std::vector<float> gradients;
+  std::vector<float> hessians;
+};
+
+NodeData CreateNodeData(const size_t num_examples) {
+  std::mt19937 random(1234);
+  std::uniform_real_distribution<float> unif_unit;
+  NodeData data;
+  data.selected_examples.resize(num_examples);
+  data.weights.assign(num_examples, 1.f);
+  data.numerical_attributes.resize(num_examples);
+  data.discretized_attributes.resize(num_examples);
+  data.categorical_attributes.resize(num_examples);
+  data.classification_labels.resize(num_examples);
+  data.regression_labels.resize(num_examples);
+  data.gradients.resize(num_examples);
+  data.hessians.assign(num_examples, 1.f);
+  for (size_t example_idx = 0; example_idx < num_examples; example_idx++) {
+    data.selected_examples[example_idx] = example_idx;
+    data.numerical_attributes[example_idx] = unif_unit(random);
+    data.discretized_attributes[example_idx] = random() % kNumDiscretizedBins;
+    data.categorical_attributes[example_idx] = random() % kNumAttributeClasses;
+    data.classification_labels[example_idx] =
+        1 + static_cast<int32_t>(random() % (kNumLabelClasses - 1));
+    data.regression_labels[example_idx] = unif_unit(random);
+    data.gradients[example_idx] = unif_unit(random) - 0.5f;
+  }
+  return data;
+}
+
+proto::DecisionTreeTrainingConfig CreateDtConfig() {
+  proto::DecisionTreeTrainingConfig dt_config;
+  dt_config.mutable_internal()->set_sorting_strategy(
+      proto::DecisionTreeTrainingConfig::Internal::IN_NODE);
+  return dt_config;
+}
+
+utils::IntegerDistributionDouble ClassificationLabelDistribution(
+    const NodeData& data) {
+  utils::IntegerDistributionDouble label_distribution;
+  label_distribution.SetNumClasses(kNumLabelClasses);
+  for (const auto example_idx : data.selected_examples) {
+    label_distribution.Add(data.classification_labels[example_idx],
+                           data.weights[example_idx]);
+  }
+  return label_distribution;
+}
+
+utils::NormalDistributionDouble RegressionLabelDistribution(
+    const NodeData& data) {
+  utils::NormalDistributionDouble label_distribution;
+  for (const auto example_idx : data.selected_examples) {
+    label_distribution.Add(data.regression_labels[example_idx],
+                           data.weights[example_idx]);
+  }
+  return label_distribution;
+}
+
+double SumGradient(const NodeData& data) {
+  double sum = 0;
+  for (const auto example_idx : data.selected_examples) {
+    sum += data.gradients[example_idx];
+  }
+  return sum;
+}
+
+void BM_ClassificationFeatureNumericalCart(benchmark::State& state) {
+  const auto data = CreateNodeData(state.range(0));
+  const auto dt_config = CreateDtConfig();
+  const auto label_distribution = ClassificationLabelDistribution(data);
+  proto::NodeCondition condition;
+  SplitterPerThreadCache cache;
+  for (auto _ : state) {
+    condition.Clear();
+    benchmark::DoNotOptimize(FindSplitLabelClassificationFeatureNumericalCart(
+        data.selected_examples, data.weights, data.numerical_attributes,
+        data.classification_labels, kNumLabelClasses, /*na_replacement=*/0.5f,
+        /*min_num_obs=*/1, dt_config, label_distribution, /*attribute_idx=*/0,
+        {}, &condition, &cache));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ClassificationFeatureDiscretizedNumericalCart(benchmark::State& state) {
+  const auto data = CreateNodeData(state.range(0));
+  const auto dt_config = CreateDtConfig();
+  const auto label_distribution = ClassificationLabelDistribution(data);
+  proto::NodeCondition condition;
+  SplitterPerThreadCache cache;
+  for (auto _ : state) {
+    condition.Clear();
+    benchmark::DoNotOptimize(
+        FindSplitLabelClassificationFeatureDiscretizedNumericalCart(
+            data.selected_examples, data.weights, data.discretized_attributes,
+            kNumDiscretizedBins, data.classification_labels, kNumLabelClasses,
+            /*na_replacement=*/0, /*min_num_obs=*/1, dt_config,
+            label_distribution, /*attribute_idx=*/0, &condition, &cache));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ClassificationFeatureCategoricalCart(benchmark::State& state) {
+  const auto data = CreateNodeData(state.range(0));
+  const auto dt_config = CreateDtConfig();
+  const auto label_distribution = ClassificationLabelDistribution(data);
+  proto::NodeCondition condition;
+  SplitterPerThreadCache cache;
+  utils::RandomEngine random;
+  for (auto _ : state) {
+    condition.Clear();
+    benchmark::DoNotOptimize(FindSplitLabelClassificationFeatureCategorical(
+        data.selected_examples, data.weights, data.categorical_attributes,
+        data.classification_labels, kNumAttributeClasses, kNumLabelClasses,
+        /*na_replacement=*/0, /*min_num_obs=*/1, dt_config, label_distribution,
+        /*attribute_idx=*/0, &random, &condition, &cache));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_RegressionFeatureNumericalCart(benchmark::State& state) {
+  const auto data = CreateNodeData(state.range(0));
+  const auto dt_config = CreateDtConfig();
+  const auto label_distribution = RegressionLabelDistribution(data);
+  proto::NodeCondition condition;
+  SplitterPerThreadCache cache;
+  for (auto _ : state) {
+    condition.Clear();
+    benchmark::DoNotOptimize(FindSplitLabelRegressionFeatureNumericalCart(
+        data.selected_examples, data.weights, data.numerical_attributes,
+        data.regression_labels, /*na_replacement=*/0.5f, /*min_num_obs=*/1,
+        dt_config, label_distribution, /*attribute_idx=*/0, {}, &condition,
+        &cache));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_RegressionFeatureDiscretizedNumericalCart(benchmark::State& state) {
+  const auto data = CreateNodeData(state.range(0));
+  const auto dt_config = CreateDtConfig();
+  const auto label_distribution = RegressionLabelDistribution(data);
+  proto::NodeCondition condition;
+  SplitterPerThreadCache cache;
+  for (auto _ : state) {
+    condition.Clear();
+    benchmark::DoNotOptimize(
+        FindSplitLabelRegressionFeatureDiscretizedNumericalCart(
+            data.selected_examples, data.weights, data.discretized_attributes,
+            kNumDiscretizedBins, data.regression_labels, /*na_replacement=*/0,
+            /*min_num_obs=*/1, dt_config, label_distribution,
+            /*attribute_idx=*/0, &condition, &cache));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_RegressionFeatureCategoricalCart(benchmark::State& state) {
+  const auto data = CreateNodeData(state.range(0));
+  const auto dt_config = CreateDtConfig();
+  const auto label_distribution = RegressionLabelDistribution(data);
+  proto::NodeCondition condition;
+  SplitterPerThreadCache cache;
+  utils::RandomEngine random;
+  for (auto _ : state) {
+    condition.Clear();
+    benchmark::DoNotOptimize(FindSplitLabelRegressionFeatureCategorical(
+        data.selected_examples, data.weights, data.categorical_attributes,
+        data.regression_labels, kNumAttributeClasses, /*na_replacement=*/0,
+        /*min_num_obs=*/1, dt_config, label_distribution, /*attribute_idx=*/0,
+        &condition, &cache, &random));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_HessianRegressionFeatureNumericalCart(benchmark::State& state) {
+  const auto data = CreateNodeData(state.range(0));
+  const auto dt_config = CreateDtConfig();
+  const double sum_gradient = SumGradient(data);
+  const double sum_hessian = data.selected_examples.size();
+  const double sum_weights = data.selected_examples.size();
+  InternalTrainConfig internal_config;
+  internal_config.use_hessian_gain = true;
+  proto::NodeCondition condition;
+  SplitterPerThreadCache cache;
+  for (auto _ : state) {
+    condition.Clear();
+    benchmark::DoNotOptimize(
+        FindSplitLabelHessianRegressionFeatureNumericalCart(
+            data.selected_examples, data.weights, data.numerical_attributes,
+            data.gradients, data.hessians, /*na_replacement=*/0.5f,
+            /*min_num_obs=*/1, dt_config, sum_gradient, sum_hessian,
+            sum_weights, /*attribute_idx=*/0, internal_config, &condition,
+            &cache));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_HessianRegressionFeatureDiscretizedNumericalCart(
+    benchmark::State& state) {
+  const auto data = CreateNodeData(state.range(0));
+  const auto dt_config = CreateDtConfig();
+  const double sum_gradient = SumGradient(data);
+  const double sum_hessian = data.selected_examples.size();
+  const double sum_weights = data.selected_examples.size();
+  InternalTrainConfig internal_config;
+  internal_config.use_hessian_gain = true;
+  proto::NodeCondition condition;
+  SplitterPerThreadCache cache;
+  for (auto _ : state) {
+    condition.Clear();
+    benchmark::DoNotOptimize(
+        FindSplitLabelHessianRegressionFeatureDiscretizedNumericalCart(
+            data.selected_examples, data.weights, data.discretized_attributes,
+            kNumDiscretizedBins, data.gradients, data.hessians,
+            /*na_replacement=*/0, /*min_num_obs=*/1, dt_config, sum_gradient,
+            sum_hessian, sum_weights, /*attribute_idx=*/0, internal_config,
+            &condition, &cache));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_HessianRegressionFeatureCategoricalCart(benchmark::State& state) {
+  const auto data = CreateNodeData(state.range(0));
+  const auto dt_config = CreateDtConfig();
+  const double sum_gradient = SumGradient(data);
+  const double sum_hessian = data.selected_examples.size();
+  const double sum_weights = data.selected_examples.size();
+  InternalTrainConfig internal_config;
+  internal_config.use_hessian_gain = true;
+  proto::NodeCondition condition;
+  SplitterPerThreadCache cache;
+  utils::RandomEngine random;
+  for (auto _ : state) {
+    condition.Clear();
+    benchmark::DoNotOptimize(FindSplitLabelHessianRegressionFeatureCategorical(
+        data.selected_examples, data.weights, data.categorical_attributes,
+        data.gradients, data.hessians, kNumAttributeClasses,
+        /*na_replacement=*/0, /*min_num_obs=*/1, dt_config, sum_gradient,
+        sum_hessian, sum_weights, /*attribute_idx=*/0, internal_config,
+        &condition, &cache, &random));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Node sizes representative of the root (large) and of deep nodes (small).
+constexpr int kSmallNode = 1000;
+constexpr int kLargeNode = 1000000;
+
+BENCHMARK(BM_ClassificationFeatureNumericalCart)
+    ->Arg(kSmallNode)
+    ->Arg(kLargeNode);
+BENCHMARK(BM_ClassificationFeatureDiscretizedNumericalCart)
+    ->Arg(kSmallNode)
+    ->Arg(kLargeNode);
+BENCHMARK(BM_ClassificationFeatureCategoricalCart)
+    ->Arg(kSmallNode)
+    ->Arg(kLargeNode);
+BENCHMARK(BM_RegressionFeatureNumericalCart)->Arg(kSmallNode)->Arg(kLargeNode);
+BENCHMARK(BM_RegressionFeatureDiscretizedNumericalCart)
+    ->Arg(kSmallNode)
+    ->Arg(kLargeNode);
+BENCHMARK(BM_RegressionFeatureCategoricalCart)
+    ->Arg(kSmallNode)
+    ->Arg(kLargeNode);
+BENCHMARK(BM_HessianRegressionFeatureNumericalCart)
+    ->Arg(kSmallNode)
+    ->Arg(kLargeNode);
+BENCHMARK(BM_HessianRegressionFeatureDiscretizedNumericalCart)
+    ->Arg(kSmallNode)
+    ->Arg(kLargeNode);
+BENCHMARK(BM_HessianRegressionFeatureCategoricalCart)
+    ->Arg(kSmallNode)
+    ->Arg(kLargeNode);
+
+}  // namespace
+}  // namespace decision_tree
+}  // namespace model
+}  // namespace yggdrasil_decision_forests
+
+BENCHMARK_MAIN();
@@ -51,23 +51,31 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_LEARNER_DECISION_TREE_SPLITTER_SCANNER_H_
 #define YGGDRASIL_DECISION_FORESTS_LEARNER_DECISION_TREE_SPLITTER_SCANNER_H_
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 #include <stddef.h>
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <limits>
 #include <random>
+#include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "absl/base/attributes.h"
+#include "absl/numeric/bits.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/learner/decision_tree/splitter_accumulator.h"
 #include "yggdrasil_decision_forests/learner/decision_tree/splitter_structure.h"
 #include "yggdrasil_decision_forests/learner/decision_tree/utils.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/utils/bitmap.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/random.h"
@@ -111,20 +119,51 @@ struct ExampleBucketSet {
 
 // Label: Numerical.
 
-using FeatureNumericalLabelNumericalOneValue = ExampleBucketSet<
-    ExampleBucket<FeatureNumericalBucket, LabelNumericalOneValueBucket>>;
+using LabelWeightedNumericalOneValueBucket =
+    LabelNumericalOneValueBucket<true>;
+
+using LabelWeightedNumericalBucket = LabelNumericalBucket<true>;
+
+using FeatureNumericalLabelNumericalOneValue =
+    ExampleBucketSet<ExampleBucket<FeatureNumericalBucket,
+                                   LabelWeightedNumericalOneValueBucket>>;
 
-using FeatureDiscretizedNumericalLabelNumerical = ExampleBucketSet<
-    ExampleBucket<FeatureDiscretizedNumericalBucket, LabelNumericalBucket>>;
+using FeatureDiscretizedNumericalLabelNumerical =
+    ExampleBucketSet<ExampleBucket<FeatureDiscretizedNumericalBucket,
+                                   LabelWeightedNumericalBucket>>;
 
 using FeatureCategoricalLabelNumerical = ExampleBucketSet<
-    ExampleBucket<FeatureCategoricalBucket, LabelNumericalBucket>>;
+    ExampleBucket<FeatureCategoricalBucket, LabelWeightedNumericalBucket>>;
 
-using FeatureBooleanLabelNumerical =
-    ExampleBucketSet<ExampleBucket<FeatureBooleanBucket, LabelNumericalBucket>>;
+using FeatureBooleanLabelNumerical = ExampleBucketSet<
+    ExampleBucket<FeatureBooleanBucket, LabelWeightedNumericalBucket>>;
 
 using FeatureIsMissingLabelNumerical = ExampleBucketSet<
-    ExampleBucket<FeatureIsMissingBucket, LabelNumericalBucket>>;
+    ExampleBucket<FeatureIsMissingBucket, LabelWeightedNumericalBucket>>;
+
+// Label: Unweighted Numerical.
+
+using LabelUnweightedNumericalOneValueBucket =
+    LabelNumericalOneValueBucket<false>;
+
+using LabelUnweightedNumericalBucket = LabelNumericalBucket<false>;
+
+using FeatureNumericalLabelUnweightedNumericalOneValue =
+    ExampleBucketSet<ExampleBucket<FeatureNumericalBucket,
+                                   LabelUnweightedNumericalOneValueBucket>>;
+
+using FeatureDiscretizedNumericalLabelUnweightedNumerical =
+    ExampleBucketSet<ExampleBucket<FeatureDiscretizedNumericalBucket,
+                                   LabelUnweightedNumericalBucket>>;
+
+using FeatureCategoricalLabelUnweightedNumerical = ExampleBucketSet<
+    ExampleBucket<FeatureCategoricalBucket, LabelUnweightedNumericalBucket>>;
+
+using FeatureBooleanLabelUnweightedNumerical = ExampleBucketSet<
+    ExampleBucket<FeatureBooleanBucket, LabelUnweightedNumericalBucket>>;
+
+using FeatureIsMissingLabelUnweightedNumerical = ExampleBucketSet<
+    ExampleBucket<FeatureIsMissingBucket, LabelUnweightedNumericalBucket>>;
 
 // Label: Hessian Numerical.
 
@@ -278,6 +317,13 @@ struct PerThreadCacheV2 {
   FeatureIsMissingLabelNumerical example_bucket_set_num_3;
   FeatureBooleanLabelNumerical example_bucket_set_num_4;
 
+  FeatureNumericalLabelUnweightedNumericalOneValue example_bucket_set_unum_1;
+  FeatureDiscretizedNumericalLabelUnweightedNumerical
+      example_bucket_set_unum_5;
+  FeatureCategoricalLabelUnweightedNumerical example_bucket_set_unum_2;
+  FeatureIsMissingLabelUnweightedNumerical example_bucket_set_unum_3;
+  FeatureBooleanLabelUnweightedNumerical example_bucket_set_unum_4;
+
   FeatureNumericalLabelCategoricalOneValue example_bucket_set_cat_1;
   FeatureDiscretizedNumericalLabelCategorical example_bucket_set_cat_5;
   FeatureCategoricalLabelCategorical example_bucket_set_cat_2;
@@ -337,6 +383,13 @@ struct PerThreadCacheV2 {
   std::vector<bool> selected_examples_mask;
   std::vector<uint8_t> selected_examples_count;
 
+  // Bitmap of the selected examples of the node being split, used by
+  // "ScanSplitsPackedBoolean". Built lazily on the first bit-packed boolean
+  // feature of the node; the splitter managers clear
+  // "selected_examples_bitmap_ready" when they start working on a new node.
+  std::string selected_examples_bitmap;
+  bool selected_examples_bitmap_ready = false;
+
   // Selected bucket indices;
   std::vector<int> buckets_1;
   std::vector<int> buckets_2;
@@ -365,6 +418,24 @@ auto* GetCachedExampleBucketSet(PerThreadCacheV2* cache) {
   } else if constexpr (is_same_v<ExampleBucketSet,
                                  FeatureBooleanLabelNumerical>) {
     return &cache->example_bucket_set_num_4;
+  } else if constexpr (
+      is_same_v<ExampleBucketSet,
+                FeatureNumericalLabelUnweightedNumericalOneValue>) {
+    // Unweighted Numerical.
+    return &cache->example_bucket_set_unum_1;
+  } else if constexpr (
+      is_same_v<ExampleBucketSet,
+                FeatureDiscretizedNumericalLabelUnweightedNumerical>) {
+    return &cache->example_bucket_set_unum_5;
+  } else if constexpr (is_same_v<ExampleBucketSet,
+                                 FeatureCategoricalLabelUnweightedNumerical>) {
+    return &cache->example_bucket_set_unum_2;
+  } else if constexpr (is_same_v<ExampleBucketSet,
+                                 FeatureIsMissingLabelUnweightedNumerical>) {
+    return &cache->example_bucket_set_unum_3;
+  } else if constexpr (is_same_v<ExampleBucketSet,
+                                 FeatureBooleanLabelUnweightedNumerical>) {
+    return &cache->example_bucket_set_unum_4;
   } else if constexpr (is_same_v<
                            ExampleBucketSet,
                            FeatureNumericalLabelHessianNumericalOneValue>) {
@@ -510,6 +581,28 @@ auto* GetCachedLabelScoreAccumulator(const bool side, PerThreadCacheV2* cache) {
   }
 }
 
+// True iff "selected_examples" is exactly the range [0, n) i.e. the i-th
+// selected example is the i-th example. This is the common case near the root
+// of the tree when the examples are not sampled (or sampled with a ratio of
+// 1). The checks on the first and last elements reject non-dense selections
+// in constant time in most cases.
+inline bool IsDenseExampleRange(
+    const std::vector<UnsignedExampleIdx>& selected_examples) {
+  const size_t num_selected_examples = selected_examples.size();
+  if (num_selected_examples == 0 || selected_examples.front() != 0 ||
+      selected_examples.back() != num_selected_examples - 1) {
+    return false;
+  }
+  for (size_t select_idx = 1; select_idx + 1 < num_selected_examples;
+       select_idx++) {
+    if (selected_examples[select_idx] !=
+        static_cast<UnsignedExampleIdx>(select_idx)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 template <typename ExampleBucketSet, bool require_label_sorting>
 void FillExampleBucketSet(
     const std::vector<UnsignedExampleIdx>& selected_examples,
@@ -529,8 +622,67 @@ void FillExampleBucketSet(
 
   // Fill the buckets.
   const auto num_selected_examples = selected_examples.size();
-  for (size_t select_idx = 0; select_idx < num_selected_examples;
-       select_idx++) {
+  size_t select_idx = 0;
+
+  // Dense case: the selection is exactly [0, num_selected_examples).
+  // Iterating over the examples directly avoids streaming the index vector
+  // and replaces the gathers on the feature and label data with sequential
+  // reads. This is where most of the training time is spent for the first few
+  // levels of the tree.
+  if (IsDenseExampleRange(selected_examples)) {
+    for (UnsignedExampleIdx example_idx = 0; example_idx < num_selected_examples;
+         example_idx++) {
+      const size_t item_idx =
+          feature_filler.GetBucketIndex(example_idx, example_idx);
+      auto& bucket = example_bucket_set->items[item_idx];
+      feature_filler.ConsumeExample(example_idx, &bucket.feature);
+      label_filler.ConsumeExample(example_idx, &bucket.label);
+    }
+    select_idx = num_selected_examples;
+  }
+
+#ifdef __AVX2__
+  // Vectorized filling: the label data of blocks of 8 examples is gathered
+  // with AVX2 instructions. The accumulation itself remains scalar as several
+  // examples of a block can fall in the same bucket.
+  if constexpr (utils::is_same_v<typename ExampleBucketSet::LabelBucketType,
+                                 LabelHessianNumericalBucket> &&
+                sizeof(UnsignedExampleIdx) == sizeof(int32_t)) {
+    constexpr size_t kBlockSize = 8;
+    const float* gradients = label_filler.gradients().data();
+    const float* hessians = label_filler.hessians().data();
+    const float* weights = label_filler.weights().data();
+    alignas(32) float block_gradients[kBlockSize];
+    alignas(32) float block_hessians[kBlockSize];
+    alignas(32) float block_weights[kBlockSize];
+    for (; select_idx + kBlockSize <= num_selected_examples;
+         select_idx += kBlockSize) {
+      const __m256i example_idxs = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(selected_examples.data() +
+                                           select_idx));
+      _mm256_store_ps(block_gradients,
+                      _mm256_i32gather_ps(gradients, example_idxs, 4));
+      _mm256_store_ps(block_hessians,
+                      _mm256_i32gather_ps(hessians, example_idxs, 4));
+      _mm256_store_ps(block_weights,
+                      _mm256_i32gather_ps(weights, example_idxs, 4));
+      for (size_t block_idx = 0; block_idx < kBlockSize; block_idx++) {
+        const UnsignedExampleIdx example_idx =
+            selected_examples[select_idx + block_idx];
+        const size_t item_idx =
+            feature_filler.GetBucketIndex(select_idx + block_idx, example_idx);
+        auto& bucket = example_bucket_set->items[item_idx];
+        feature_filler.ConsumeExample(example_idx, &bucket.feature);
+        label_filler.ConsumeGatheredExample(block_gradients[block_idx],
+                                            block_hessians[block_idx],
+                                            block_weights[block_idx],
+                                            &bucket.label);
+      }
+    }
+  }
+#endif  // __AVX2__
+
+  for (; select_idx < num_selected_examples; select_idx++) {
     const UnsignedExampleIdx example_idx = selected_examples[select_idx];
     const size_t item_idx =
         feature_filler.GetBucketIndex(select_idx, example_idx);
@@ -751,6 +903,184 @@ SplitSearchResult ScanSplits(
   }
 }
 
+// Evaluates the boolean splits of all the features of an exclusive boolean
+// feature bundle (see "Preprocessing::BooleanFeatureBundle") with a single
+// pass over the selected examples.
+//
+// The per-example bundle values are scanned once into "BundleExampleBucketSet"
+// (one bucket per bundle member, plus the bucket 0 of the examples for which
+// no member is true). Since the members are mutually exclusive, the label
+// statistics of the "false" side of member "m" are the statistics of the node
+// minus the statistics of bucket "m+1". Each member is then scored by running
+// "ScanSplits" on a two-buckets boolean bucket set, which is equivalent to
+// (but much cheaper than) scanning the member feature directly.
+//
+// "member_feature_fillers", "member_attribute_idxs", "member_bucket_idxs" and
+// "member_results" are indexed by evaluated bundle member (which can be a
+// subset of the bundle e.g. because of candidate attribute sampling).
+// "member_bucket_idxs[i]" is the bundle value of the i-th evaluated member.
+// "bundle_feature_filler" should map each example to its bundle value.
+// "best_condition" is updated like in "ScanSplits".
+template <typename BundleExampleBucketSet, typename BooleanExampleBucketSet,
+          typename LabelScoreAccumulator>
+void ScanSplitsExclusiveBooleanBundle(
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const FeatureCategoricalBucket::Filler& bundle_feature_filler,
+    const typename BooleanExampleBucketSet::LabelBucketType::Filler&
+        label_filler,
+    const typename BooleanExampleBucketSet::LabelBucketType::Initializer&
+        initializer,
+    const std::vector<FeatureBooleanBucket::Filler>& member_feature_fillers,
+    const std::vector<int32_t>& member_attribute_idxs,
+    const std::vector<int>& member_bucket_idxs, const int min_num_obs,
+    proto::NodeCondition* best_condition,
+    std::vector<SplitSearchResult>* member_results, PerThreadCacheV2* cache) {
+  static_assert(
+      utils::is_same_v<typename BundleExampleBucketSet::LabelBucketType,
+                       typename BooleanExampleBucketSet::LabelBucketType>,
+      "The bundle and boolean bucket sets should have the same label bucket.");
+  DCHECK_EQ(member_feature_fillers.size(), member_attribute_idxs.size());
+  DCHECK_EQ(member_bucket_idxs.size(), member_attribute_idxs.size());
+
+  // Label statistics of each bundle value.
+  auto& bundle_bucket_set =
+      *GetCachedExampleBucketSet<BundleExampleBucketSet>(cache);
+  FillExampleBucketSet<BundleExampleBucketSet,
+                       /*require_label_sorting=*/false>(
+      selected_examples, bundle_feature_filler, label_filler,
+      &bundle_bucket_set, cache);
+
+  // Label statistics of the node.
+  typename BooleanExampleBucketSet::LabelBucketType total_label_bucket;
+  label_filler.InitializeAndZero(&total_label_bucket);
+  for (const auto& item : bundle_bucket_set.items) {
+    item.label.AddToBucket(&total_label_bucket);
+  }
+
+  auto& boolean_bucket_set =
+      *GetCachedExampleBucketSet<BooleanExampleBucketSet>(cache);
+  boolean_bucket_set.items.resize(2);
+
+  const size_t num_members = member_attribute_idxs.size();
+  member_results->resize(num_members);
+  for (size_t member_idx = 0; member_idx < num_members; member_idx++) {
+    // The bucket 0 (false branch) contains the statistics of all the examples
+    // for which the member is not true.
+    auto& false_label = boolean_bucket_set.items[0].label;
+    auto& true_label = boolean_bucket_set.items[1].label;
+    true_label = bundle_bucket_set.items[member_bucket_idxs[member_idx]].label;
+    false_label = total_label_bucket;
+    true_label.SubFromBucket(&false_label);
+
+    (*member_results)[member_idx] =
+        ScanSplits<BooleanExampleBucketSet, LabelScoreAccumulator>(
+            member_feature_fillers[member_idx], initializer, boolean_bucket_set,
+            selected_examples.size(), min_num_obs,
+            member_attribute_idxs[member_idx], best_condition, cache);
+  }
+}
+
+// Evaluates the boolean split of a feature from its bit-packed replica (see
+// "Preprocessing::PackedBooleanFeature") i.e. 64 examples are processed per
+// popcount instead of one "char" read per selected example.
+//
+// "feature_values" (resp. "feature_nas") is the bitmap of the "true" (resp.
+// missing) values of the feature over all the "num_examples" training
+// examples, and "positive_labels" is the bitmap of the examples with the
+// positive label. The label statistics of the two boolean buckets are
+// recovered with three popcounts per word and injected in the regular
+// two-buckets boolean scan, so the produced split is identical to scanning
+// the "char" column. Restricted to unweighted binary classification.
+//
+// The bitmap of the selected examples is shared by all the bit-packed
+// boolean features of the node: it is built on the first call and cached in
+// "cache" until the splitter manager moves to another node (see
+// "selected_examples_bitmap_ready").
+inline SplitSearchResult ScanSplitsPackedBoolean(
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const size_t num_examples, const std::string& feature_values,
+    const std::string& feature_nas, const std::string& positive_labels,
+    const bool na_replacement,
+    const FeatureBooleanBucket::Filler& feature_filler,
+    const LabelBinaryCategoricalBucket<false>::Initializer& initializer,
+    const utils::IntegerDistributionDouble& label_distribution,
+    const int min_num_obs, const int attribute_idx,
+    proto::NodeCondition* condition, PerThreadCacheV2* cache) {
+  DCHECK_EQ(feature_values.size(), (num_examples + 7) / 8);
+  DCHECK_EQ(feature_nas.size(), feature_values.size());
+  DCHECK_EQ(positive_labels.size(), feature_values.size());
+
+  if (!cache->selected_examples_bitmap_ready) {
+    utils::bitmap::AllocateAndZeroBitMap(num_examples,
+                                         &cache->selected_examples_bitmap);
+    for (const auto example_idx : selected_examples) {
+      utils::bitmap::SetValueBit(example_idx,
+                                 &cache->selected_examples_bitmap);
+    }
+    cache->selected_examples_bitmap_ready = true;
+  }
+  const std::string& selected = cache->selected_examples_bitmap;
+
+  // Number of selected examples reaching the "true" branch, and, among them,
+  // number of examples with the positive label.
+  int64_t num_true = 0;
+  int64_t num_true_positives = 0;
+  const auto scan_word = [&](const uint64_t selected_word,
+                             const uint64_t values_word,
+                             const uint64_t nas_word,
+                             const uint64_t positives_word) {
+    const uint64_t true_word =
+        (na_replacement ? (values_word | nas_word) : values_word) &
+        selected_word;
+    num_true += absl::popcount(true_word);
+    num_true_positives += absl::popcount(true_word & positives_word);
+  };
+
+  const size_t num_bytes = selected.size();
+  size_t byte_idx = 0;
+  uint64_t selected_word, values_word, nas_word, positives_word;
+  for (; byte_idx + sizeof(uint64_t) <= num_bytes;
+       byte_idx += sizeof(uint64_t)) {
+    std::memcpy(&selected_word, selected.data() + byte_idx, sizeof(uint64_t));
+    std::memcpy(&values_word, feature_values.data() + byte_idx,
+                sizeof(uint64_t));
+    std::memcpy(&nas_word, feature_nas.data() + byte_idx, sizeof(uint64_t));
+    std::memcpy(&positives_word, positive_labels.data() + byte_idx,
+                sizeof(uint64_t));
+    scan_word(selected_word, values_word, nas_word, positives_word);
+  }
+  if (byte_idx < num_bytes) {
+    const size_t num_remaining_bytes = num_bytes - byte_idx;
+    selected_word = values_word = nas_word = positives_word = 0;
+    std::memcpy(&selected_word, selected.data() + byte_idx,
+                num_remaining_bytes);
+    std::memcpy(&values_word, feature_values.data() + byte_idx,
+                num_remaining_bytes);
+    std::memcpy(&nas_word, feature_nas.data() + byte_idx, num_remaining_bytes);
+    std::memcpy(&positives_word, positive_labels.data() + byte_idx,
+                num_remaining_bytes);
+    scan_word(selected_word, values_word, nas_word, positives_word);
+  }
+
+  // The label statistics of the "false" bucket are the statistics of the node
+  // minus the statistics of the "true" bucket.
+  auto& bucket_set = cache->example_bucket_set_ubcat_4;
+  bucket_set.items.resize(2);
+  auto& false_label = bucket_set.items[0].label;
+  auto& true_label = bucket_set.items[1].label;
+  true_label.count = num_true;
+  true_label.content.sum_trues = num_true_positives;
+  false_label.count =
+      static_cast<int64_t>(selected_examples.size()) - num_true;
+  false_label.content.sum_trues =
+      label_distribution.count(2) - num_true_positives;
+
+  return ScanSplits<FeatureBooleanLabelUnweightedBinaryCategorical,
+                    LabelBinaryCategoricalScoreAccumulator>(
+      feature_filler, initializer, bucket_set, selected_examples.size(),
+      min_num_obs, attribute_idx, condition, cache);
+}
+
 // Scans the buckets (similarly to "ScanSplits"), but in the order specified by
 // "bucket_order[i].second" (instead of the bucket order).
 template <typename ExampleBucketSet, typename LabelScoreAccumulator,
@@ -1312,6 +1642,39 @@ constexpr auto FindBestSplit_LabelRegressionFeatureNACart =
                   LabelNumericalScoreAccumulator,
                   /*require_label_sorting*/ false>;
 
+// Label: Unweighted Regression.
+
+constexpr auto FindBestSplit_LabelUnweightedRegressionFeatureNumerical =
+    FindBestSplit<FeatureNumericalLabelUnweightedNumericalOneValue,
+                  LabelNumericalScoreAccumulator,
+                  /*require_label_sorting*/ false>;
+
+constexpr auto
+    FindBestSplit_LabelUnweightedRegressionFeatureDiscretizedNumerical =
+        FindBestSplit<FeatureDiscretizedNumericalLabelUnweightedNumerical,
+                      LabelNumericalScoreAccumulator,
+                      /*require_label_sorting*/ false,
+                      /*bucket_interpolation=*/true>;
+
+constexpr auto FindBestSplit_LabelUnweightedRegressionFeatureCategoricalCart =
+    FindBestSplit<FeatureCategoricalLabelUnweightedNumerical,
+                  LabelNumericalScoreAccumulator,
+                  /*require_label_sorting*/ true>;
+
+constexpr auto FindBestSplit_LabelUnweightedRegressionFeatureCategoricalRandom =
+    FindBestSplitRandom<FeatureCategoricalLabelUnweightedNumerical,
+                        LabelNumericalScoreAccumulator>;
+
+constexpr auto FindBestSplit_LabelUnweightedRegressionFeatureBooleanCart =
+    FindBestSplit<FeatureBooleanLabelUnweightedNumerical,
+                  LabelNumericalScoreAccumulator,
+                  /*require_label_sorting*/ false>;
+
+constexpr auto FindBestSplit_LabelUnweightedRegressionFeatureNACart =
+    FindBestSplit<FeatureIsMissingLabelUnweightedNumerical,
+                  LabelNumericalScoreAccumulator,
+                  /*require_label_sorting*/ false>;
+
 // Label: Classification.
 
 constexpr auto FindBestSplit_LabelClassificationFeatureNumerical =
@@ -16,8 +16,10 @@
 #include "yggdrasil_decision_forests/learner/decision_tree/training.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include <algorithm>
+#include <cstring>
 #include <cmath>
 #include <functional>
 #include <iterator>
@@ -47,10 +49,12 @@
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/utils/bitmap.h"
 #include "yggdrasil_decision_forests/utils/cast.h"
 #include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/distribution.h"
 #include "yggdrasil_decision_forests/utils/distribution.pb.h"
+#include "yggdrasil_decision_forests/utils/instrument.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/random.h"
 
@@ -296,7 +300,6 @@ void LocalImputationForBooleanAttribute(
     const std::vector<UnsignedExampleIdx>& selected_examples,
     const std::vector<float>& weights, const std::vector<char>& attributes,
     bool* na_replacement) {
-  DCHECK(!weights.empty());
   utils::IntegerDistributionDouble attribute_distribution;
   attribute_distribution.SetNumClasses(2);
   for (const auto example_idx : selected_examples) {
@@ -347,7 +350,6 @@ std::pair<int, double> GetAttributeValueWithMaximumVarianceReduction(
     const std::vector<float>& labels, const double initial_variance,
     std::vector<UnsignedExampleIdx>* running_attr_bank_idx,
     std::vector<bool>* candidate_attributes_bitmap) {
-  DCHECK_EQ(weights.size(), labels.size());
   // Search for the attribute item that maximize the variance reduction. Note:
   // We ignore attribute that reduce the current variance reduction.
   double best_candidate_variance_reduction = variance_reduction;
@@ -400,10 +402,11 @@ std::pair<int, double> GetAttributeValueWithMaximumVarianceReduction(
       if (match) {
         // Add the example to the positive set and remove it from the
         // negative.
+        const float weight = weights.empty() ? 1.f : weights[example_idx];
         candidate_split_label_distribution.mutable_pos()->Add(
-            labels[example_idx], weights[example_idx]);
+            labels[example_idx], weight);
         candidate_split_label_distribution.mutable_neg()->Add(
-            labels[example_idx], -weights[example_idx]);
+            labels[example_idx], -weight);
       } else {
         num_absent_in_negative_set++;
       }
@@ -605,7 +608,8 @@ SplitSearchResult FindBestCondition(
       result = FindSplitLabelClassificationFeatureBoolean(
           selected_examples, weights, attribute_data, label_stats.label_data,
           label_stats.num_label_classes, na_replacement, min_num_obs, dt_config,
-          label_stats.label_distribution, attribute_idx, best_condition, cache);
+          label_stats.label_distribution, attribute_idx, internal_config,
+          best_condition, cache);
     } break;
 
     default:
@@ -1051,14 +1055,14 @@ SplitterWorkResponse FindBestConditionFromSplitterWorkRequest(
   response.manager_data = request.manager_data;
   request.splitter_cache->random.seed(request.seed);
 
-  if (request.num_oblique_projections_to_run.has_value()) {
+  if (request.oblique_projection_slice.has_value()) {
     DCHECK_EQ(request.attribute_idx, -1);
     const auto found_oblique_condition =
         FindBestConditionSparseOblique(
             request.common->train_dataset, request.common->selected_examples,
             weights, config, config_link, dt_config, request.common->parent,
             internal_config, request.common->label_stats,
-            request.num_oblique_projections_to_run.value(), request.condition,
+            request.oblique_projection_slice, request.condition,
             &request.splitter_cache->random, request.splitter_cache)
             .value();
 
@@ -1123,7 +1127,7 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
     const proto::DecisionTreeTrainingConfig& dt_config,
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const LabelStats& label_stats,
-    const absl::optional<int>& override_num_projections,
+    const absl::optional<ObliqueProjectionSlice>& projection_slice,
     proto::NodeCondition* best_condition, utils::RandomEngine* random,
     SplitterPerThreadCache* cache) {
   switch (config.task()) {
@@ -1133,7 +1137,7 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
       return FindBestConditionSparseOblique(
           train_dataset, selected_examples, weights, config, config_link,
           dt_config, parent, internal_config, class_label_stats,
-          override_num_projections, best_condition, random, cache);
+          projection_slice, best_condition, random, cache);
     } break;
     case model::proto::Task::REGRESSION:
       if (internal_config.use_hessian_gain) {
@@ -1142,14 +1146,14 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
         return FindBestConditionSparseOblique(
             train_dataset, selected_examples, weights, config, config_link,
             dt_config, parent, internal_config, reg_label_stats,
-            override_num_projections, best_condition, random, cache);
+            projection_slice, best_condition, random, cache);
       } else {
         const auto& reg_label_stats =
             utils::down_cast<const RegressionLabelStats&>(label_stats);
         return FindBestConditionSparseOblique(
             train_dataset, selected_examples, weights, config, config_link,
             dt_config, parent, internal_config, reg_label_stats,
-            override_num_projections, best_condition, random, cache);
+            projection_slice, best_condition, random, cache);
       }
       break;
     default:
@@ -1173,6 +1177,19 @@ utils::StatusOr<bool> FindBestConditionSingleThreadManager(
   // Single Thread Setup.
   cache->splitter_cache_list.resize(1);
 
+  // The bitmap of the selected examples cached for the bit-packed boolean
+  // splitter (see "ScanSplitsPackedBoolean") is specific to the node.
+  cache->splitter_cache_list[0].cache_v2.selected_examples_bitmap_ready = false;
+
+  // Export the histogram cache context of the node (set by "NodeTrain";
+  // nullptr if histogram sibling subtraction is disabled).
+  cache->splitter_cache_list[0].hessian_histogram_store =
+      cache->hessian_histogram_store;
+  cache->splitter_cache_list[0].hessian_histogram_parent =
+      cache->hessian_histogram_parent;
+  cache->splitter_cache_list[0].hessian_histogram_sibling_node_id =
+      cache->hessian_histogram_sibling_node_id;
+
   // Was a least one good split found?
   bool found_good_condition = false;
 
@@ -1198,6 +1215,27 @@ utils::StatusOr<bool> FindBestConditionSingleThreadManager(
                          &remaining_attributes_to_test, &candidate_attributes,
                          random);
 
+  // Bundles of mutually exclusive boolean features (see
+  // "Preprocessing::BooleanFeatureBundle"): all the candidate attributes of a
+  // bundle are evaluated with a single pass over the examples when the first
+  // of them is reached in the candidate list. Note that a bundle can consume
+  // more than the remaining candidate attribute budget.
+  const Preprocessing* preprocessing = internal_config.preprocessing;
+  const bool use_boolean_bundles =
+      preprocessing != nullptr &&
+      !preprocessing->boolean_feature_bundles().empty() &&
+      (config.task() == model::proto::Task::CLASSIFICATION ||
+       config.task() == model::proto::Task::REGRESSION);
+  std::vector<bool> attribute_handled;
+  std::vector<bool> attribute_is_candidate;
+  if (use_boolean_bundles) {
+    attribute_handled.assign(train_dataset.ncol(), false);
+    attribute_is_candidate.assign(train_dataset.ncol(), false);
+    for (const auto attribute_idx : candidate_attributes) {
+      attribute_is_candidate[attribute_idx] = true;
+    }
+  }
+
   // Index of the next attribute to be tested in "candidate_attributes".
   int candidate_attribute_idx_in_candidate_list = 0;
 
@@ -1209,6 +1247,81 @@ utils::StatusOr<bool> FindBestConditionSingleThreadManager(
         candidate_attributes[candidate_attribute_idx_in_candidate_list++];
     SplitSearchResult result;
 
+    if (use_boolean_bundles) {
+      if (attribute_handled[attribute_idx]) {
+        // The attribute was already evaluated with its bundle.
+        continue;
+      }
+      const int bundle_idx =
+          preprocessing->boolean_feature_to_bundle()[attribute_idx];
+      if (bundle_idx >= 0) {
+        const auto& bundle = preprocessing->boolean_feature_bundles()[bundle_idx];
+
+        // Candidate members of the bundle not evaluated yet.
+        std::vector<int> member_features;
+        for (int member = 0; member < bundle.features.size(); member++) {
+          const int member_attribute_idx = bundle.features[member];
+          if (attribute_is_candidate[member_attribute_idx] &&
+              !attribute_handled[member_attribute_idx]) {
+            member_features.push_back(member);
+            attribute_handled[member_attribute_idx] = true;
+          }
+        }
+
+        const int min_num_obs = dt_config.in_split_min_examples_check()
+                                    ? dt_config.min_examples()
+                                    : 1;
+        std::vector<SplitSearchResult> member_results;
+        switch (config.task()) {
+          case model::proto::Task::CLASSIFICATION: {
+            const auto& class_label_stats =
+                utils::down_cast<const ClassificationLabelStats&>(label_stats);
+            FindSplitsLabelClassificationExclusiveBooleanBundle(
+                train_dataset, selected_examples, weights, bundle,
+                member_features, class_label_stats.label_data,
+                class_label_stats.num_label_classes, min_num_obs,
+                class_label_stats.label_distribution, best_condition,
+                &member_results, &cache->splitter_cache_list[0]);
+          } break;
+          case model::proto::Task::REGRESSION:
+            if (internal_config.use_hessian_gain) {
+              const auto& reg_label_stats =
+                  utils::down_cast<const RegressionHessianLabelStats&>(
+                      label_stats);
+              FindSplitsLabelHessianRegressionExclusiveBooleanBundle(
+                  train_dataset, selected_examples, weights, bundle,
+                  member_features, reg_label_stats.gradient_data,
+                  reg_label_stats.hessian_data, min_num_obs, dt_config,
+                  reg_label_stats.sum_gradient, reg_label_stats.sum_hessian,
+                  reg_label_stats.sum_weights, internal_config, best_condition,
+                  &member_results, &cache->splitter_cache_list[0]);
+            } else {
+              const auto& reg_label_stats =
+                  utils::down_cast<const RegressionLabelStats&>(label_stats);
+              FindSplitsLabelRegressionExclusiveBooleanBundle(
+                  train_dataset, selected_examples, weights, bundle,
+                  member_features, reg_label_stats.label_data, min_num_obs,
+                  reg_label_stats.label_distribution, best_condition,
+                  &member_results, &cache->splitter_cache_list[0]);
+            }
+            break;
+          default:
+            // "use_boolean_bundles" is false for the other tasks.
+            break;
+        }
+
+        for (const auto member_result : member_results) {
+          if (member_result != SplitSearchResult::kInvalidAttribute) {
+            remaining_attributes_to_test--;
+            if (member_result == SplitSearchResult::kBetterSplitFound) {
+              found_good_condition = true;
+            }
+          }
+        }
+        continue;
+      }
+    }
+
     switch (config.task()) {
       case model::proto::Task::CLASSIFICATION: {
         const auto& class_label_stats =
@@ -1345,21 +1458,32 @@ utils::StatusOr<bool> FindBestConditionConcurrentManager(
     // Arbitrary minimum number of oblique projections to test in each job.
     // Because oblique jobs are expensive (more than non oblique jobs), it is
     // not efficient to create a request with too little work to do.
-    //
-    // In most real cases, this parameter does not matter as the limit is
-    // effectively constraint by the number of threads.
     const int min_projections_per_request = 10;
 
+    // Number of oblique jobs per worker thread. Oblique jobs are expensive
+    // and of uneven durations: cutting them finer than one job per thread
+    // lets the worker pool balance the stragglers dynamically and reduces the
+    // idle tail at the end of the node.
+    const int oblique_jobs_per_thread = 4;
+
     DCHECK_GE(num_threads, 1);
-    num_oblique_jobs = std::min(num_threads, (num_oblique_projections +
-                                              min_projections_per_request - 1) /
-                                                 min_projections_per_request);
+    num_oblique_jobs =
+        std::min(num_threads * oblique_jobs_per_thread,
+                 (num_oblique_projections + min_projections_per_request - 1) /
+                     min_projections_per_request);
     oblique = num_oblique_projections > 0;
   }
 
   // Prepare caches.
   cache->splitter_cache_list.resize(num_threads);
   cache->condition_list.resize(num_threads * kConditionPoolGrowthFactor);
+
+  // The bitmaps of the selected examples cached for the bit-packed boolean
+  // splitter (see "ScanSplitsPackedBoolean") are specific to the node. All the
+  // requests dispatched below are about the same node.
+  for (auto& splitter_cache : cache->splitter_cache_list) {
+    splitter_cache.cache_v2.selected_examples_bitmap_ready = false;
+  }
   const int num_jobs = num_features + num_oblique_jobs;
   cache->durable_response_list.resize(num_jobs);
 
@@ -1371,6 +1495,12 @@ utils::StatusOr<bool> FindBestConditionConcurrentManager(
   // All the oblique requests need to be tested.
   min_num_jobs_to_test += num_oblique_jobs;
 
+  // Seed of the node. The generators of the split jobs are derived from this
+  // seed and a stable stream index (the attribute index, or the projection
+  // index for oblique jobs), so the split search results do not depend on the
+  // number of jobs (i.e. on the number of threads) or on the scheduling.
+  const uint64_t node_seed = (*random)();
+
   // Marks all the caches and conditions as "available".
   cache->available_cache_idxs.fill_iota(cache->splitter_cache_list.size(), 0);
   cache->available_condition_idxs.fill_iota(cache->condition_list.size(), 0);
@@ -1387,12 +1517,13 @@ utils::StatusOr<bool> FindBestConditionConcurrentManager(
   //
   // If attribute_idx is != -1 create a request for an axis-aligned split.
   //
-  // If attribute_idx is == -1 and num_oblique_projections_to_run != -1, create
-  // a request for an oblique split.
+  // If attribute_idx is == -1 and "oblique_projection_slice" is set, create a
+  // request for an oblique split.
   //
-  auto produce =
-      [&](const int job_idx, const float best_score, const int attribute_idx,
-          const int num_oblique_projections_to_run) -> SplitterWorkRequest {
+  auto produce = [&](const int job_idx, const float best_score,
+                     const int attribute_idx,
+                     const absl::optional<ObliqueProjectionSlice>&
+                         oblique_projection_slice) -> SplitterWorkRequest {
     // Get a cache and a condition.
     DCHECK(!cache->available_cache_idxs.empty());
     DCHECK(!cache->available_condition_idxs.empty());
@@ -1406,52 +1537,72 @@ utils::StatusOr<bool> FindBestConditionConcurrentManager(
     request.manager_data.condition_idx = condition_idx;
     request.manager_data.cache_idx = cache_idx;
     request.manager_data.job_idx = job_idx;
-    DCHECK((attribute_idx == -1) != (num_oblique_projections_to_run == -1));
+    DCHECK((attribute_idx == -1) == oblique_projection_slice.has_value());
     if (attribute_idx != -1) {
       request.attribute_idx = attribute_idx;
+      // Seed keyed on the attribute: independent of the job index.
+      request.seed = utils::DeriveSeed(node_seed, attribute_idx);
     } else {
-      request.num_oblique_projections_to_run = num_oblique_projections_to_run;
+      request.oblique_projection_slice = oblique_projection_slice;
       request.attribute_idx = -1;
+      // All the oblique jobs share the node seed: the projections are
+      // individually seeded from it and their index (see
+      // "FindBestConditionSparseOblique").
+      request.seed = node_seed;
     }
     request.condition = &cache->condition_list[condition_idx];
     request.splitter_cache = &cache->splitter_cache_list[cache_idx];
     request.condition->set_split_score(best_score);  // Best score so far.
     request.common = &common;
-    request.seed = (*random)();  // Create a new seed.
 
     return request;
   };
 
-  // Schedule all the oblique jobs.
+  const int num_oblique_projections_per_job =
+      oblique
+          ? (num_oblique_projections + num_oblique_jobs - 1) / num_oblique_jobs
+          : 0;
+
+  // Schedule the job with index "next_job_to_schedule". The first
+  // "num_oblique_jobs" jobs each evaluate a slice of the oblique projections;
+  // the following jobs each evaluate one of the candidate attributes. All the
+  // jobs go through the same queue and are pulled dynamically by the workers.
+  // The requests are accumulated in "request_batch" and submitted with a
+  // single channel operation ("SubmitMany"): with many features, one channel
+  // operation per request makes the work queue a synchronization hot spot.
+  std::vector<SplitterWorkRequest>& request_batch = cache->request_batch;
+  request_batch.clear();
+
   int next_job_to_schedule = 0;
-  if (oblique) {
-    const int num_oblique_projections_per_job =
-        (num_oblique_projections + num_oblique_jobs - 1) / num_oblique_jobs;
-
-    for (int oblique_job_idx = 0; oblique_job_idx < num_oblique_jobs;
-         oblique_job_idx++) {
-      const int num_projections_in_request =
-          std::min((oblique_job_idx + 1) * num_oblique_projections_per_job,
-                   num_oblique_projections) -
-          oblique_job_idx * num_oblique_projections_per_job;
-      processor.Submit(produce(
-          next_job_to_schedule++, best_condition->split_score(),
-          /*attribute_idx=*/-1,
-          /*num_oblique_projections_to_run=*/num_projections_in_request));
+  const auto schedule_next_job = [&](const float best_score) {
+    const int job_idx = next_job_to_schedule++;
+    if (job_idx < num_oblique_jobs) {
+      const int begin_projection_idx = job_idx * num_oblique_projections_per_job;
+      const int end_projection_idx =
+          std::min((job_idx + 1) * num_oblique_projections_per_job,
+                   num_oblique_projections);
+      request_batch.push_back(
+          produce(job_idx, best_score,
+                  /*attribute_idx=*/-1,
+                  ObliqueProjectionSlice{
+                      /*.begin =*/begin_projection_idx,
+                      /*.num_projections =*/end_projection_idx -
+                          begin_projection_idx}));
+    } else {
+      const int attribute_idx = candidate_attributes[job_idx - num_oblique_jobs];
+      request_batch.push_back(produce(job_idx, best_score,
+                                      /*attribute_idx=*/attribute_idx,
+                                      /*oblique_projection_slice=*/{}));
     }
-  }
+  };
 
-  // Schedule some non-oblique jobs.
+  // Schedule the first jobs.
   while (next_job_to_schedule < std::min(num_threads, num_jobs) &&
          !cache->available_condition_idxs.empty() &&
          !cache->available_cache_idxs.empty()) {
-    const int attribute_idx =
-        candidate_attributes[next_job_to_schedule - num_oblique_jobs];
-    processor.Submit(produce(next_job_to_schedule++,
-                             best_condition->split_score(),
-                             /*attribute_idx=*/attribute_idx,
-                             /*num_oblique_projections_to_run=*/-1));
+    schedule_next_job(best_condition->split_score());
   }
+  processor.SubmitMany(&request_batch);
 
   int num_valid_job_tested = 0;
   int next_job_to_process = 0;
@@ -1461,16 +1612,20 @@ utils::StatusOr<bool> FindBestConditionConcurrentManager(
   // Score of the best found condition, or minimum condition score to look for.
   float best_split_score = best_condition->split_score();
 
+  // Responses collected from the workers, in batches of a single channel
+  // operation each ("GetResults"). At most "num_threads" jobs are in flight
+  // (bounded by the cache pool).
+  std::vector<SplitterWorkResponse>& response_batch = cache->response_batch;
+
   while (true) {
-    auto maybe_response = processor.GetResult();
-    if (!maybe_response.has_value()) {
+    // Wait for at least one worker response, and grab all the immediately
+    // available ones.
+    if (processor.GetResults(num_threads, &response_batch) == 0) {
       break;
     }
 
-    {
-      // Record, but do not process, the worker response.
-    SplitterWorkResponse& response = maybe_response.value();
-
+    // Record, but do not process, the worker responses.
+    for (SplitterWorkResponse& response : response_batch) {
       // Release the cache immediately to be reused by other workers.
       cache->available_cache_idxs.push_front(response.manager_data.cache_idx);
 
@@ -1497,7 +1652,7 @@ utils::StatusOr<bool> FindBestConditionConcurrentManager(
           durable_response.condition_idx = -1;
           durable_response.status = SplitSearchResult::kNoBetterSplitFound;
         }
-        } else {
+      } else {
         // Return the condition to the condition pool.
         cache->available_condition_idxs.push_front(
             response.manager_data.condition_idx);
@@ -1550,12 +1705,9 @@ utils::StatusOr<bool> FindBestConditionConcurrentManager(
     while (!cache->available_condition_idxs.empty() &&
            !cache->available_cache_idxs.empty() &&
            next_job_to_schedule < num_jobs) {
-      const int attribute_idx =
-          candidate_attributes[next_job_to_schedule - num_oblique_jobs];
-      processor.Submit(produce(next_job_to_schedule++, best_split_score,
-                               /*attribute_idx=*/attribute_idx,
-                               /*num_oblique_projections_to_run=*/-1));
+      schedule_next_job(best_split_score);
     }
+    processor.SubmitMany(&request_batch);
 
     // The following condition means that no work is in the pipeline and no more
     // work will be generated.
@@ -1566,17 +1718,14 @@ utils::StatusOr<bool> FindBestConditionConcurrentManager(
 
   // Drain the response channel.
   while (!cache->available_cache_idxs.full()) {
-    auto maybe_response = processor.GetResult();
-    if (!maybe_response.has_value()) {
+    if (processor.GetResults(num_threads, &response_batch) == 0) {
       break;
     }
-    SplitterWorkResponse& response = maybe_response.value();
-    cache->available_cache_idxs.push_front(response.manager_data.cache_idx);
+    for (const SplitterWorkResponse& response : response_batch) {
+      cache->available_cache_idxs.push_front(response.manager_data.cache_idx);
+    }
   }
 
-  // Move the random generator state to facilitate deterministic behavior.
-  random->discard(num_jobs - next_job_to_schedule);
-
   if (best_condition_idx != -1) {
     *best_condition = cache->condition_list[best_condition_idx];
     return true;
@@ -1595,6 +1744,9 @@ utils::StatusOr<bool> FindBestConditionManager(
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const LabelStats& label_stats, proto::NodeCondition* best_condition,
     utils::RandomEngine* random, PerThreadCache* cache) {
+  YDF_INSTRUMENT_SPAN("decision_tree.find_best_condition");
+  YDF_INSTRUMENT_COUNTER("decision_tree.find_best_condition.num_examples",
+                         selected_examples.size());
   if (splitter_concurrency_setup.concurrent_execution) {
     return FindBestConditionConcurrentManager(
         train_dataset, selected_examples, weights, config, config_link,
@@ -2165,7 +2317,7 @@ SplitSearchResult FindSplitLabelRegressionFeatureNumericalHistogram(
   // Compute the split score of each threshold.
   for (const auto example_idx : selected_examples) {
     const float label = labels[example_idx];
-    const float weight = weights[example_idx];
+    const float weight = weights.empty() ? 1.f : weights[example_idx];
     float attribute = attributes[example_idx];
     if (std::isnan(attribute)) {
       attribute = na_replacement;
@@ -2301,6 +2453,84 @@ SplitSearchResult FindSplitLabelHessianRegressionFeatureNumericalCart(
       attribute_idx, condition, &cache->cache_v2);
 }
 
+namespace {
+
+// Variation of "FindBestSplit_LabelHessianRegressionFeatureDiscretizedNumerical"
+// that maintains the histogram cache: The histogram of the node is stored in
+// "cache->hessian_histogram_store" and, when the histograms of the parent and
+// sibling nodes are available and valid, the histogram of the node is derived
+// by subtraction (histogram of the parent minus histogram of the sibling)
+// instead of scanning the selected examples. See "HessianHistogramCache".
+SplitSearchResult FindBestSplitHessianDiscretizedNumericalWithHistogramCache(
+    const std::vector<UnsignedExampleIdx>& selected_examples, const int num_bins,
+    const FeatureDiscretizedNumericalBucket::Filler& feature_filler,
+    const LabelHessianNumericalBucket::Filler& label_filler,
+    const LabelHessianNumericalBucket::Initializer& initializer,
+    const int min_num_obs, const int32_t attribute_idx,
+    proto::NodeCondition* condition, SplitterPerThreadCache* cache) {
+  using ExampleBucketSet = FeatureDiscretizedNumericalLabelHessianNumerical;
+
+  auto* store = cache->hessian_histogram_store;
+  DCHECK_LT(attribute_idx, store->per_attribute.size());
+  auto& histogram = store->per_attribute[attribute_idx];
+
+  ExampleBucketSet& example_set_accumulator =
+      *GetCachedExampleBucketSet<ExampleBucketSet>(&cache->cache_v2);
+
+  // Checks if the histogram can be derived from the histograms of the parent
+  // and sibling nodes. Before derivation, "histogram" contains the histogram
+  // of the sibling.
+  const auto* parent = cache->hessian_histogram_parent;
+  bool derived = false;
+  if (parent != nullptr) {
+    const auto& parent_histogram = parent->per_attribute[attribute_idx];
+    if (parent_histogram.node_id == parent->node_id &&
+        parent_histogram.bins.size() == num_bins &&
+        histogram.node_id == cache->hessian_histogram_sibling_node_id &&
+        histogram.bins.size() == num_bins) {
+      int64_t derived_count = 0;
+      for (int bin_idx = 0; bin_idx < num_bins; bin_idx++) {
+        auto bucket = parent_histogram.bins[bin_idx];
+        histogram.bins[bin_idx].SubFromBucket(&bucket);
+        label_filler.Finalize(&bucket);
+        histogram.bins[bin_idx] = bucket;
+        derived_count += bucket.count;
+      }
+      DCHECK_EQ(derived_count,
+                static_cast<int64_t>(selected_examples.size()));
+      derived = true;
+    }
+  }
+
+  if (derived) {
+    // Export the derived histogram into the bucket set.
+    example_set_accumulator.items.resize(num_bins);
+    for (int bin_idx = 0; bin_idx < num_bins; bin_idx++) {
+      auto& item = example_set_accumulator.items[bin_idx];
+      feature_filler.InitializeAndZero(bin_idx, &item.feature);
+      item.label = histogram.bins[bin_idx];
+    }
+  } else {
+    FillExampleBucketSet<ExampleBucketSet, /*require_label_sorting=*/false>(
+        selected_examples, feature_filler, label_filler,
+        &example_set_accumulator, &cache->cache_v2);
+    // Save the histogram for the children of the node.
+    histogram.bins.resize(num_bins);
+    for (int bin_idx = 0; bin_idx < num_bins; bin_idx++) {
+      histogram.bins[bin_idx] = example_set_accumulator.items[bin_idx].label;
+    }
+  }
+  histogram.node_id = store->node_id;
+
+  return ScanSplits<ExampleBucketSet, LabelHessianNumericalScoreAccumulator,
+                    /*bucket_interpolation=*/true>(
+      feature_filler, initializer, example_set_accumulator,
+      selected_examples.size(), min_num_obs, attribute_idx, condition,
+      &cache->cache_v2);
+}
+
+}  // namespace
+
 SplitSearchResult
 FindSplitLabelHessianRegressionFeatureDiscretizedNumericalCart(
     const std::vector<UnsignedExampleIdx>& selected_examples,
@@ -2325,6 +2555,12 @@ FindSplitLabelHessianRegressionFeatureDiscretizedNumericalCart(
       internal_config.hessian_l2_categorical,
       dt_config.internal().hessian_split_score_subtract_parent());
 
+  if (cache->hessian_histogram_store != nullptr) {
+    return FindBestSplitHessianDiscretizedNumericalWithHistogramCache(
+        selected_examples, num_bins, feature_filler, label_filler, initializer,
+        min_num_obs, attribute_idx, condition, cache);
+  }
+
   return FindBestSplit_LabelHessianRegressionFeatureDiscretizedNumerical(
       selected_examples, feature_filler, label_filler, initializer, min_num_obs,
       attribute_idx, condition, &cache->cache_v2);
@@ -2348,40 +2584,82 @@ SplitSearchResult FindSplitLabelRegressionFeatureNumericalCart(
   FeatureNumericalBucket::Filler feature_filler(selected_examples.size(),
                                                 na_replacement, attributes);
 
-  LabelNumericalOneValueBucket::Filler label_filler(labels, weights);
-
-  LabelNumericalOneValueBucket::Initializer initializer(label_distribution);
   const auto sorting_strategy = dt_config.internal().sorting_strategy();
-  if (sorting_strategy ==
-          proto::DecisionTreeTrainingConfig::Internal::PRESORTED ||
-      sorting_strategy ==
-          proto::DecisionTreeTrainingConfig::Internal::FORCE_PRESORTED) {
-    if (!internal_config.preprocessing) {
-      LOG(FATAL) << "Preprocessing missing for PRESORTED sorting "
-                    "strategy";
+
+  if (weights.empty()) {
+    LabelNumericalOneValueBucket</*weighted=*/false>::Filler label_filler(
+        labels, weights);
+    LabelNumericalOneValueBucket</*weighted=*/false>::Initializer initializer(
+        label_distribution);
+
+    if (sorting_strategy ==
+            proto::DecisionTreeTrainingConfig::Internal::PRESORTED ||
+        sorting_strategy ==
+            proto::DecisionTreeTrainingConfig::Internal::FORCE_PRESORTED) {
+      if (!internal_config.preprocessing) {
+        LOG(FATAL) << "Preprocessing missing for PRESORTED sorting "
+                      "strategy";
+      }
+
+      if (sorting_strategy ==
+              proto::DecisionTreeTrainingConfig::Internal::FORCE_PRESORTED ||
+          IsPresortingOnNumericalSplitMoreEfficient(
+              -selected_examples.size(),
+              internal_config.preprocessing->num_examples())) {
+        const auto& sorted_attributes =
+            internal_config.preprocessing
+                ->presorted_numerical_features()[attribute_idx];
+        return ScanSplitsPresortedSparse<
+            FeatureNumericalLabelUnweightedNumericalOneValue,
+            LabelNumericalScoreAccumulator>(
+            internal_config.preprocessing->num_examples(), selected_examples,
+            sorted_attributes.items, feature_filler, label_filler, initializer,
+            min_num_obs, attribute_idx,
+            internal_config.duplicated_selected_examples, condition,
+            &cache->cache_v2);
+      }
     }
 
+    return FindBestSplit_LabelUnweightedRegressionFeatureNumerical(
+        selected_examples, feature_filler, label_filler, initializer,
+        min_num_obs, attribute_idx, condition, &cache->cache_v2);
+  } else {
+    LabelNumericalOneValueBucket</*weighted=*/true>::Filler label_filler(
+        labels, weights);
+    LabelNumericalOneValueBucket</*weighted=*/true>::Initializer initializer(
+        label_distribution);
+
     if (sorting_strategy ==
-            proto::DecisionTreeTrainingConfig::Internal::FORCE_PRESORTED ||
-        IsPresortingOnNumericalSplitMoreEfficient(
-            -selected_examples.size(),
-            internal_config.preprocessing->num_examples())) {
-      const auto& sorted_attributes =
-          internal_config.preprocessing
-              ->presorted_numerical_features()[attribute_idx];
-      return ScanSplitsPresortedSparse<FeatureNumericalLabelNumericalOneValue,
-                                       LabelNumericalScoreAccumulator>(
-          internal_config.preprocessing->num_examples(), selected_examples,
-          sorted_attributes.items, feature_filler, label_filler, initializer,
-          min_num_obs, attribute_idx,
-          internal_config.duplicated_selected_examples, condition,
-          &cache->cache_v2);
+            proto::DecisionTreeTrainingConfig::Internal::PRESORTED ||
+        sorting_strategy ==
+            proto::DecisionTreeTrainingConfig::Internal::FORCE_PRESORTED) {
+      if (!internal_config.preprocessing) {
+        LOG(FATAL) << "Preprocessing missing for PRESORTED sorting "
+                      "strategy";
+      }
+
+      if (sorting_strategy ==
+              proto::DecisionTreeTrainingConfig::Internal::FORCE_PRESORTED ||
+          IsPresortingOnNumericalSplitMoreEfficient(
+              -selected_examples.size(),
+              internal_config.preprocessing->num_examples())) {
+        const auto& sorted_attributes =
+            internal_config.preprocessing
+                ->presorted_numerical_features()[attribute_idx];
+        return ScanSplitsPresortedSparse<FeatureNumericalLabelNumericalOneValue,
+                                         LabelNumericalScoreAccumulator>(
+            internal_config.preprocessing->num_examples(), selected_examples,
+            sorted_attributes.items, feature_filler, label_filler, initializer,
+            min_num_obs, attribute_idx,
+            internal_config.duplicated_selected_examples, condition,
+            &cache->cache_v2);
+      }
     }
-  }
 
-  return FindBestSplit_LabelRegressionFeatureNumerical(
-      selected_examples, feature_filler, label_filler, initializer, min_num_obs,
-      attribute_idx, condition, &cache->cache_v2);
+    return FindBestSplit_LabelRegressionFeatureNumerical(
+        selected_examples, feature_filler, label_filler, initializer,
+        min_num_obs, attribute_idx, condition, &cache->cache_v2);
+  }
 }
 
 SplitSearchResult FindSplitLabelRegressionFeatureDiscretizedNumericalCart(
@@ -2398,13 +2676,25 @@ SplitSearchResult FindSplitLabelRegressionFeatureDiscretizedNumericalCart(
   FeatureDiscretizedNumericalBucket::Filler feature_filler(
       num_bins, na_replacement, attributes);
 
-  LabelNumericalBucket::Filler label_filler(labels, weights);
+  if (weights.empty()) {
+    LabelNumericalBucket</*weighted=*/false>::Filler label_filler(labels,
+                                                                  weights);
+    LabelNumericalBucket</*weighted=*/false>::Initializer initializer(
+        label_distribution);
 
-  LabelNumericalBucket::Initializer initializer(label_distribution);
-
-  return FindBestSplit_LabelRegressionFeatureDiscretizedNumerical(
-      selected_examples, feature_filler, label_filler, initializer, min_num_obs,
-      attribute_idx, condition, &cache->cache_v2);
+    return FindBestSplit_LabelUnweightedRegressionFeatureDiscretizedNumerical(
+        selected_examples, feature_filler, label_filler, initializer,
+        min_num_obs, attribute_idx, condition, &cache->cache_v2);
+  } else {
+    LabelNumericalBucket</*weighted=*/true>::Filler label_filler(labels,
+                                                                 weights);
+    LabelNumericalBucket</*weighted=*/true>::Initializer initializer(
+        label_distribution);
+
+    return FindBestSplit_LabelRegressionFeatureDiscretizedNumerical(
+        selected_examples, feature_filler, label_filler, initializer,
+        min_num_obs, attribute_idx, condition, &cache->cache_v2);
+  }
 }
 
 SplitSearchResult FindSplitLabelClassificationFeatureNA(
@@ -2476,13 +2766,25 @@ SplitSearchResult FindSplitLabelRegressionFeatureNA(
     SplitterPerThreadCache* cache) {
   FeatureIsMissingBucket::Filler feature_filler(attributes);
 
-  LabelNumericalBucket::Filler label_filler(labels, weights);
-
-  LabelNumericalBucket::Initializer initializer(label_distribution);
+  if (weights.empty()) {
+    LabelNumericalBucket</*weighted=*/false>::Filler label_filler(labels,
+                                                                  weights);
+    LabelNumericalBucket</*weighted=*/false>::Initializer initializer(
+        label_distribution);
 
-  return FindBestSplit_LabelRegressionFeatureNACart(
-      selected_examples, feature_filler, label_filler, initializer, min_num_obs,
-      attribute_idx, condition, &cache->cache_v2);
+    return FindBestSplit_LabelUnweightedRegressionFeatureNACart(
+        selected_examples, feature_filler, label_filler, initializer,
+        min_num_obs, attribute_idx, condition, &cache->cache_v2);
+  } else {
+    LabelNumericalBucket</*weighted=*/true>::Filler label_filler(labels,
+                                                                 weights);
+    LabelNumericalBucket</*weighted=*/true>::Initializer initializer(
+        label_distribution);
+
+    return FindBestSplit_LabelRegressionFeatureNACart(
+        selected_examples, feature_filler, label_filler, initializer,
+        min_num_obs, attribute_idx, condition, &cache->cache_v2);
+  }
 }
 
 SplitSearchResult FindSplitLabelHessianRegressionFeatureNA(
@@ -2519,8 +2821,8 @@ SplitSearchResult FindSplitLabelClassificationFeatureBoolean(
     bool na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
     const utils::IntegerDistributionDouble& label_distribution,
-    int32_t attribute_idx, proto::NodeCondition* condition,
-    SplitterPerThreadCache* cache) {
+    int32_t attribute_idx, const InternalTrainConfig& internal_config,
+    proto::NodeCondition* condition, SplitterPerThreadCache* cache) {
   if (dt_config.missing_value_policy() ==
       proto::DecisionTreeTrainingConfig::LOCAL_IMPUTATION) {
     LocalImputationForBooleanAttribute(selected_examples, weights, attributes,
@@ -2532,12 +2834,30 @@ SplitSearchResult FindSplitLabelClassificationFeatureBoolean(
   if (num_label_classes == 3) {
     // Binary classification.
     if (weights.empty()) {
-      LabelBinaryCategoricalBucket</*weighted=*/false>::Filler label_filler(
-          labels, {}, label_distribution);
-
       LabelBinaryCategoricalBucket</*weighted=*/false>::Initializer initializer(
           label_distribution);
 
+      // Bit-packed evaluation (see "Preprocessing::PackedBooleanFeature").
+      if (internal_config.preprocessing != nullptr && attribute_idx >= 0) {
+        const auto& packed_features =
+            internal_config.preprocessing->packed_boolean_features();
+        const auto& packed_labels =
+            internal_config.preprocessing->packed_binary_labels();
+        if (attribute_idx < packed_features.size() &&
+            !packed_features[attribute_idx].values.empty() &&
+            !packed_labels.empty()) {
+          return ScanSplitsPackedBoolean(
+              selected_examples, attributes.size(),
+              packed_features[attribute_idx].values,
+              packed_features[attribute_idx].nas, packed_labels,
+              na_replacement, feature_filler, initializer, label_distribution,
+              min_num_obs, attribute_idx, condition, &cache->cache_v2);
+        }
+      }
+
+      LabelBinaryCategoricalBucket</*weighted=*/false>::Filler label_filler(
+          labels, {}, label_distribution);
+
       return FindBestSplit_LabelUnweightedBinaryClassificationFeatureBooleanCart(  // NOLINT(whitespace/line_length)
           selected_examples, feature_filler, label_filler, initializer,
           min_num_obs, attribute_idx, condition, &cache->cache_v2);
@@ -2594,12 +2914,26 @@ SplitSearchResult FindSplitLabelRegressionFeatureBoolean(
   }
 
   FeatureBooleanBucket::Filler feature_filler(na_replacement, attributes);
-  LabelNumericalBucket::Filler label_filler(labels, weights);
-  LabelNumericalBucket::Initializer initializer(label_distribution);
 
-  return FindBestSplit_LabelRegressionFeatureBooleanCart(
-      selected_examples, feature_filler, label_filler, initializer, min_num_obs,
-      attribute_idx, condition, &cache->cache_v2);
+  if (weights.empty()) {
+    LabelNumericalBucket</*weighted=*/false>::Filler label_filler(labels,
+                                                                  weights);
+    LabelNumericalBucket</*weighted=*/false>::Initializer initializer(
+        label_distribution);
+
+    return FindBestSplit_LabelUnweightedRegressionFeatureBooleanCart(
+        selected_examples, feature_filler, label_filler, initializer,
+        min_num_obs, attribute_idx, condition, &cache->cache_v2);
+  } else {
+    LabelNumericalBucket</*weighted=*/true>::Filler label_filler(labels,
+                                                                 weights);
+    LabelNumericalBucket</*weighted=*/true>::Initializer initializer(
+        label_distribution);
+
+    return FindBestSplit_LabelRegressionFeatureBooleanCart(
+        selected_examples, feature_filler, label_filler, initializer,
+        min_num_obs, attribute_idx, condition, &cache->cache_v2);
+  }
 }
 
 SplitSearchResult FindSplitLabelHessianRegressionFeatureBoolean(
@@ -2633,6 +2967,226 @@ SplitSearchResult FindSplitLabelHessianRegressionFeatureBoolean(
       attribute_idx, condition, &cache->cache_v2);
 }
 
+namespace {
+
+// Returns the algorithm to use for a categorical split. If the user did not
+// select an algorithm, high-arity attributes fall back to the "random"
+// algorithm. An algorithm explicitly selected by the user is honored whatever
+// the arity: in particular, the sorted one-vs-other "cart" scan is
+// O(arity*log(arity)) per pass and remains cheaper than "random" (which
+// re-scans the buckets for each trial) on large dictionaries.
+proto::Categorical::AlgorithmCase EffectiveCategoricalSplitAlgorithm(
+    const proto::DecisionTreeTrainingConfig& dt_config,
+    const int32_t num_attribute_classes) {
+  const auto algorithm = dt_config.categorical().algorithm_case();
+  if (algorithm == proto::Categorical::ALGORITHM_NOT_SET &&
+      num_attribute_classes >=
+          dt_config.categorical().arity_limit_for_random()) {
+    return proto::Categorical::kRandom;
+  }
+  return algorithm;
+}
+
+// Collects, for each evaluated member of an exclusive boolean feature bundle,
+// the data required by "ScanSplitsExclusiveBooleanBundle".
+void BuildBooleanBundleMembers(
+    const dataset::VerticalDataset& train_dataset,
+    const Preprocessing::BooleanFeatureBundle& bundle,
+    const std::vector<int>& member_features,
+    std::vector<FeatureBooleanBucket::Filler>* member_feature_fillers,
+    std::vector<int32_t>* member_attribute_idxs,
+    std::vector<int>* member_bucket_idxs) {
+  member_feature_fillers->reserve(member_features.size());
+  member_attribute_idxs->reserve(member_features.size());
+  member_bucket_idxs->reserve(member_features.size());
+  for (const int member : member_features) {
+    const int32_t attribute_idx = bundle.features[member];
+    const auto& attribute_data =
+        train_dataset
+            .ColumnWithCastWithStatus<dataset::VerticalDataset::BooleanColumn>(
+                attribute_idx)
+            .value()
+            ->values();
+    // Bundled features have no missing values.
+    member_feature_fillers->emplace_back(/*na_replacement=*/false,
+                                         attribute_data);
+    member_attribute_idxs->push_back(attribute_idx);
+    member_bucket_idxs->push_back(member + 1);
+  }
+}
+
+}  // namespace
+
+void FindSplitsLabelClassificationExclusiveBooleanBundle(
+    const dataset::VerticalDataset& train_dataset,
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const std::vector<float>& weights,
+    const Preprocessing::BooleanFeatureBundle& bundle,
+    const std::vector<int>& member_features, const std::vector<int32_t>& labels,
+    const int32_t num_label_classes, const UnsignedExampleIdx min_num_obs,
+    const utils::IntegerDistributionDouble& label_distribution,
+    proto::NodeCondition* condition,
+    std::vector<SplitSearchResult>* member_results,
+    SplitterPerThreadCache* cache) {
+  std::vector<FeatureBooleanBucket::Filler> member_feature_fillers;
+  std::vector<int32_t> member_attribute_idxs;
+  std::vector<int> member_bucket_idxs;
+  BuildBooleanBundleMembers(train_dataset, bundle, member_features,
+                            &member_feature_fillers, &member_attribute_idxs,
+                            &member_bucket_idxs);
+  const FeatureCategoricalBucket::Filler bundle_feature_filler(
+      bundle.features.size() + 1, /*na_replacement=*/0, bundle.values);
+
+  if (num_label_classes == 3) {
+    // Binary classification.
+    if (weights.empty()) {
+      LabelBinaryCategoricalBucket</*weighted=*/false>::Filler label_filler(
+          labels, {}, label_distribution);
+
+      LabelBinaryCategoricalBucket</*weighted=*/false>::Initializer initializer(
+          label_distribution);
+
+      ScanSplitsExclusiveBooleanBundle<
+          FeatureCategoricalLabelUnweightedBinaryCategorical,
+          FeatureBooleanLabelUnweightedBinaryCategorical,
+          LabelBinaryCategoricalScoreAccumulator>(
+          selected_examples, bundle_feature_filler, label_filler, initializer,
+          member_feature_fillers, member_attribute_idxs, member_bucket_idxs,
+          min_num_obs, condition, member_results, &cache->cache_v2);
+    } else {
+      LabelBinaryCategoricalBucket</*weighted=*/true>::Filler label_filler(
+          labels, weights, label_distribution);
+
+      LabelBinaryCategoricalBucket</*weighted=*/true>::Initializer initializer(
+          label_distribution);
+
+      ScanSplitsExclusiveBooleanBundle<FeatureCategoricalLabelBinaryCategorical,
+                                       FeatureBooleanLabelBinaryCategorical,
+                                       LabelBinaryCategoricalScoreAccumulator>(
+          selected_examples, bundle_feature_filler, label_filler, initializer,
+          member_feature_fillers, member_attribute_idxs, member_bucket_idxs,
+          min_num_obs, condition, member_results, &cache->cache_v2);
+    }
+  } else {
+    // Multi-class classification.
+    if (weights.empty()) {
+      LabelCategoricalBucket</*weighted=*/false>::Filler label_filler(
+          labels, weights, label_distribution);
+
+      LabelCategoricalBucket</*weighted=*/false>::Initializer initializer(
+          label_distribution);
+
+      ScanSplitsExclusiveBooleanBundle<
+          FeatureCategoricalLabelUnweightedCategorical,
+          FeatureBooleanLabelUnweightedCategorical,
+          LabelCategoricalScoreAccumulator>(
+          selected_examples, bundle_feature_filler, label_filler, initializer,
+          member_feature_fillers, member_attribute_idxs, member_bucket_idxs,
+          min_num_obs, condition, member_results, &cache->cache_v2);
+    } else {
+      LabelCategoricalBucket</*weighted=*/true>::Filler label_filler(
+          labels, weights, label_distribution);
+
+      LabelCategoricalBucket</*weighted=*/true>::Initializer initializer(
+          label_distribution);
+
+      ScanSplitsExclusiveBooleanBundle<FeatureCategoricalLabelCategorical,
+                                       FeatureBooleanLabelCategorical,
+                                       LabelCategoricalScoreAccumulator>(
+          selected_examples, bundle_feature_filler, label_filler, initializer,
+          member_feature_fillers, member_attribute_idxs, member_bucket_idxs,
+          min_num_obs, condition, member_results, &cache->cache_v2);
+    }
+  }
+}
+
+void FindSplitsLabelRegressionExclusiveBooleanBundle(
+    const dataset::VerticalDataset& train_dataset,
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const std::vector<float>& weights,
+    const Preprocessing::BooleanFeatureBundle& bundle,
+    const std::vector<int>& member_features, const std::vector<float>& labels,
+    const UnsignedExampleIdx min_num_obs,
+    const utils::NormalDistributionDouble& label_distribution,
+    proto::NodeCondition* condition,
+    std::vector<SplitSearchResult>* member_results,
+    SplitterPerThreadCache* cache) {
+  std::vector<FeatureBooleanBucket::Filler> member_feature_fillers;
+  std::vector<int32_t> member_attribute_idxs;
+  std::vector<int> member_bucket_idxs;
+  BuildBooleanBundleMembers(train_dataset, bundle, member_features,
+                            &member_feature_fillers, &member_attribute_idxs,
+                            &member_bucket_idxs);
+  const FeatureCategoricalBucket::Filler bundle_feature_filler(
+      bundle.features.size() + 1, /*na_replacement=*/0, bundle.values);
+
+  if (weights.empty()) {
+    LabelNumericalBucket</*weighted=*/false>::Filler label_filler(labels,
+                                                                  weights);
+    LabelNumericalBucket</*weighted=*/false>::Initializer initializer(
+        label_distribution);
+
+    ScanSplitsExclusiveBooleanBundle<FeatureCategoricalLabelUnweightedNumerical,
+                                     FeatureBooleanLabelUnweightedNumerical,
+                                     LabelNumericalScoreAccumulator>(
+        selected_examples, bundle_feature_filler, label_filler, initializer,
+        member_feature_fillers, member_attribute_idxs, member_bucket_idxs,
+        min_num_obs, condition, member_results, &cache->cache_v2);
+  } else {
+    LabelNumericalBucket</*weighted=*/true>::Filler label_filler(labels,
+                                                                 weights);
+    LabelNumericalBucket</*weighted=*/true>::Initializer initializer(
+        label_distribution);
+
+    ScanSplitsExclusiveBooleanBundle<FeatureCategoricalLabelNumerical,
+                                     FeatureBooleanLabelNumerical,
+                                     LabelNumericalScoreAccumulator>(
+        selected_examples, bundle_feature_filler, label_filler, initializer,
+        member_feature_fillers, member_attribute_idxs, member_bucket_idxs,
+        min_num_obs, condition, member_results, &cache->cache_v2);
+  }
+}
+
+void FindSplitsLabelHessianRegressionExclusiveBooleanBundle(
+    const dataset::VerticalDataset& train_dataset,
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const std::vector<float>& weights,
+    const Preprocessing::BooleanFeatureBundle& bundle,
+    const std::vector<int>& member_features,
+    const std::vector<float>& gradients, const std::vector<float>& hessians,
+    const UnsignedExampleIdx min_num_obs,
+    const proto::DecisionTreeTrainingConfig& dt_config,
+    const double sum_gradient, const double sum_hessian,
+    const double sum_weights, const InternalTrainConfig& internal_config,
+    proto::NodeCondition* condition,
+    std::vector<SplitSearchResult>* member_results,
+    SplitterPerThreadCache* cache) {
+  std::vector<FeatureBooleanBucket::Filler> member_feature_fillers;
+  std::vector<int32_t> member_attribute_idxs;
+  std::vector<int> member_bucket_idxs;
+  BuildBooleanBundleMembers(train_dataset, bundle, member_features,
+                            &member_feature_fillers, &member_attribute_idxs,
+                            &member_bucket_idxs);
+  const FeatureCategoricalBucket::Filler bundle_feature_filler(
+      bundle.features.size() + 1, /*na_replacement=*/0, bundle.values);
+
+  LabelHessianNumericalBucket::Filler label_filler(
+      gradients, hessians, weights, internal_config.hessian_l1,
+      internal_config.hessian_l2_numerical);
+
+  LabelHessianNumericalBucket::Initializer initializer(
+      sum_gradient, sum_hessian, sum_weights, internal_config.hessian_l1,
+      internal_config.hessian_l2_numerical,
+      dt_config.internal().hessian_split_score_subtract_parent());
+
+  ScanSplitsExclusiveBooleanBundle<FeatureCategoricalLabelHessianNumerical,
+                                   FeatureBooleanLabelHessianNumerical,
+                                   LabelHessianNumericalScoreAccumulator>(
+      selected_examples, bundle_feature_filler, label_filler, initializer,
+      member_feature_fillers, member_attribute_idxs, member_bucket_idxs,
+      min_num_obs, condition, member_results, &cache->cache_v2);
+}
+
 SplitSearchResult FindSplitLabelHessianRegressionFeatureCategorical(
     const std::vector<UnsignedExampleIdx>& selected_examples,
     const std::vector<float>& weights, const std::vector<int32_t>& attributes,
@@ -2663,9 +3217,7 @@ SplitSearchResult FindSplitLabelHessianRegressionFeatureCategorical(
       dt_config.internal().hessian_split_score_subtract_parent());
 
   const auto algorithm =
-      (num_attribute_classes < dt_config.categorical().arity_limit_for_random())
-          ? dt_config.categorical().algorithm_case()
-          : proto::Categorical::kRandom;
+      EffectiveCategoricalSplitAlgorithm(dt_config, num_attribute_classes);
 
   switch (algorithm) {
     case proto::Categorical::ALGORITHM_NOT_SET:
@@ -2704,31 +3256,58 @@ SplitSearchResult FindSplitLabelRegressionFeatureCategorical(
 
   FeatureCategoricalBucket::Filler feature_filler(num_attribute_classes,
                                                   na_replacement, attributes);
-  LabelNumericalBucket::Filler label_filler(labels, weights);
-
-  LabelNumericalBucket::Initializer initializer(label_distribution);
 
   const auto algorithm =
-      (num_attribute_classes < dt_config.categorical().arity_limit_for_random())
-          ? dt_config.categorical().algorithm_case()
-          : proto::Categorical::kRandom;
+      EffectiveCategoricalSplitAlgorithm(dt_config, num_attribute_classes);
+
+  if (weights.empty()) {
+    LabelNumericalBucket</*weighted=*/false>::Filler label_filler(labels,
+                                                                  weights);
+    LabelNumericalBucket</*weighted=*/false>::Initializer initializer(
+        label_distribution);
+
+    switch (algorithm) {
+      case proto::Categorical::ALGORITHM_NOT_SET:
+      case proto::Categorical::kCart:
+        return FindBestSplit_LabelUnweightedRegressionFeatureCategoricalCart(
+            selected_examples, feature_filler, label_filler, initializer,
+            min_num_obs, attribute_idx, condition, &cache->cache_v2);
+
+      case proto::Categorical::kRandom:
+        return FindBestSplit_LabelUnweightedRegressionFeatureCategoricalRandom(
+            selected_examples, feature_filler, label_filler, initializer,
+            min_num_obs, attribute_idx,
+            NumTrialsForRandomCategoricalSplit(
+                dt_config.categorical().random()),
+            condition, &cache->cache_v2, random);
 
-  switch (algorithm) {
-    case proto::Categorical::ALGORITHM_NOT_SET:
-    case proto::Categorical::kCart:
-      return FindBestSplit_LabelRegressionFeatureCategoricalCart(
-          selected_examples, feature_filler, label_filler, initializer,
-          min_num_obs, attribute_idx, condition, &cache->cache_v2);
-
-    case proto::Categorical::kRandom:
-      return FindBestSplit_LabelRegressionFeatureCategoricalRandom(
-          selected_examples, feature_filler, label_filler, initializer,
-          min_num_obs, attribute_idx,
-          NumTrialsForRandomCategoricalSplit(dt_config.categorical().random()),
-          condition, &cache->cache_v2, random);
+      default:
+        LOG(FATAL) << "Non supported";
+    }
+  } else {
+    LabelNumericalBucket</*weighted=*/true>::Filler label_filler(labels,
+                                                                 weights);
+    LabelNumericalBucket</*weighted=*/true>::Initializer initializer(
+        label_distribution);
+
+    switch (algorithm) {
+      case proto::Categorical::ALGORITHM_NOT_SET:
+      case proto::Categorical::kCart:
+        return FindBestSplit_LabelRegressionFeatureCategoricalCart(
+            selected_examples, feature_filler, label_filler, initializer,
+            min_num_obs, attribute_idx, condition, &cache->cache_v2);
+
+      case proto::Categorical::kRandom:
+        return FindBestSplit_LabelRegressionFeatureCategoricalRandom(
+            selected_examples, feature_filler, label_filler, initializer,
+            min_num_obs, attribute_idx,
+            NumTrialsForRandomCategoricalSplit(
+                dt_config.categorical().random()),
+            condition, &cache->cache_v2, random);
 
-    default:
-      LOG(FATAL) << "Non supported";
+      default:
+        LOG(FATAL) << "Non supported";
+    }
   }
 }
 
@@ -2967,7 +3546,6 @@ SplitSearchResult FindSplitLabelRegressionFeatureCategoricalSetGreedyForward(
     const utils::NormalDistributionDouble& label_distribution,
     int32_t attribute_idx, proto::NodeCondition* condition,
     utils::RandomEngine* random) {
-  DCHECK_EQ(weights.size(), labels.size());
   // Bitmap of available attribute values. During the course of the algorithm,
   // an attribute value is available if:
   //  - It is selected by the initial random sampling of candidate attribute
@@ -3073,10 +3651,11 @@ SplitSearchResult FindSplitLabelRegressionFeatureCategoricalSetGreedyForward(
               best_attr_value);
       if (match) {
         positive_selected_example_bitmap[select_idx] = true;
+        const float weight = weights.empty() ? 1.f : weights[example_idx];
         split_label_distribution.mutable_pos()->Add(labels[example_idx],
-                                                    weights[example_idx]);
+                                                    weight);
         split_label_distribution.mutable_neg()->Add(labels[example_idx],
-                                                    -weights[example_idx]);
+                                                    -weight);
         split_label_distribution_no_weights.mutable_pos()->Add(
             labels[example_idx]);
         split_label_distribution_no_weights.mutable_neg()->Sub(
@@ -3259,9 +3838,7 @@ SplitSearchResult FindSplitLabelClassificationFeatureCategorical(
   };
 
   const auto algorithm =
-      (num_attribute_classes < dt_config.categorical().arity_limit_for_random())
-          ? dt_config.categorical().algorithm_case()
-          : proto::Categorical::kRandom;
+      EffectiveCategoricalSplitAlgorithm(dt_config, num_attribute_classes);
 
   switch (algorithm) {
     case proto::Categorical::ALGORITHM_NOT_SET:
@@ -3430,9 +4007,7 @@ SplitSearchResult FindSplitLabelUpliftCategoricalFeatureCategorical(
   // TODO: Add support for pre-sorted splitting.
 
   const auto algorithm =
-      (num_attribute_classes < dt_config.categorical().arity_limit_for_random())
-          ? dt_config.categorical().algorithm_case()
-          : proto::Categorical::kRandom;
+      EffectiveCategoricalSplitAlgorithm(dt_config, num_attribute_classes);
 
   switch (algorithm) {
     case proto::Categorical::ALGORITHM_NOT_SET:
@@ -3483,9 +4058,7 @@ SplitSearchResult FindSplitLabelUpliftNumericalFeatureCategorical(
   // TODO: Add support for pre-sorted splitting.
 
   const auto algorithm =
-      (num_attribute_classes < dt_config.categorical().arity_limit_for_random())
-          ? dt_config.categorical().algorithm_case()
-          : proto::Categorical::kRandom;
+      EffectiveCategoricalSplitAlgorithm(dt_config, num_attribute_classes);
 
   switch (algorithm) {
     case proto::Categorical::ALGORITHM_NOT_SET:
@@ -3614,7 +4187,6 @@ absl::Status SetRegressionLabelDistribution(
     const std::vector<UnsignedExampleIdx>& selected_examples,
     const std::vector<float>& weights,
     const model::proto::TrainingConfigLinking& config_link, proto::Node* node) {
-  DCHECK(!weights.empty());
   ASSIGN_OR_RETURN(
       const auto* const labels,
       dataset
@@ -3622,7 +4194,12 @@ absl::Status SetRegressionLabelDistribution(
               config_link.label()));
   utils::NormalDistributionDouble label_distribution;
   for (const UnsignedExampleIdx example_idx : selected_examples) {
-    label_distribution.Add(labels->values()[example_idx], weights[example_idx]);
+    if (weights.empty()) {
+      label_distribution.Add(labels->values()[example_idx]);
+    } else {
+      label_distribution.Add(labels->values()[example_idx],
+                             weights[example_idx]);
+    }
   }
   label_distribution.Save(node->mutable_regressor()->mutable_distribution());
   node->mutable_regressor()->set_top_value(label_distribution.Mean());
@@ -3719,11 +4296,16 @@ absl::Status GrowTreeBestFirstGlobal(
   // List of candidate splits.
   std::priority_queue<CandidateSplit> candidate_splits;
 
+  // Example index buffers released by the split and closed nodes, recycled
+  // (with their capacity) for the children of the next splits.
+  std::vector<std::vector<UnsignedExampleIdx>> free_buffers;
+
   // Initialize a node and update the list of candidate splits with a given
-  // node.
+  // node. Takes ownership of "example_idxs": the indices are moved into the
+  // candidate queue (i.e. not copied) if the node can be split.
   const auto ingest_node =
-      [&](const std::vector<UnsignedExampleIdx>& example_idxs,
-          NodeWithChildren* node, const int depth) -> absl::Status {
+      [&](std::vector<UnsignedExampleIdx> example_idxs, NodeWithChildren* node,
+          const int depth) -> absl::Status {
     RETURN_IF_ERROR(internal_config.set_leaf_value_functor(
         train_dataset, example_idxs, weights, config, config_link, node));
 
@@ -3731,6 +4313,7 @@ absl::Status GrowTreeBestFirstGlobal(
         (dt_config.max_depth() >= 0 && depth >= dt_config.max_depth())) {
       // Stop the grow of the branch.
       node->FinalizeAsLeaf(dt_config.store_detailed_label_distribution());
+      free_buffers.push_back(std::move(example_idxs));
       return absl::OkStatus();
     }
     proto::NodeCondition condition;
@@ -3743,12 +4326,13 @@ absl::Status GrowTreeBestFirstGlobal(
     if (!has_better_condition) {
       // No good condition found. Close the branch.
       node->FinalizeAsLeaf(dt_config.store_detailed_label_distribution());
+      free_buffers.push_back(std::move(example_idxs));
       return absl::OkStatus();
     }
 
     const float score = condition.split_score() * example_idxs.size();
     candidate_splits.push({/*.condition =*/std::move(condition),
-                           /*.example_idxs =*/example_idxs,
+                           /*.example_idxs =*/std::move(example_idxs),
                            /*.score =*/score,
                            /*.node =*/node,
                            /*.depth =*/depth});
@@ -3778,8 +4362,10 @@ absl::Status GrowTreeBestFirstGlobal(
       candidate_splits.pop();
     }
 
-    // Split the node.
-    auto split = candidate_splits.top();
+    // Split the node. The candidate is moved out of the queue (the queue only
+    // exposes a const reference to its top) to avoid copying the example
+    // indices.
+    auto split = std::move(const_cast<CandidateSplit&>(candidate_splits.top()));
     candidate_splits.pop();
 
     *split.node->mutable_node()->mutable_condition() = split.condition;
@@ -3790,17 +4376,28 @@ absl::Status GrowTreeBestFirstGlobal(
 
     const auto& condition = split.node->node().condition();
 
-    // Add new candidate splits for children.
+    // Add new candidate splits for children. The example indices of the
+    // children are moved into the candidate queue, and the buffer of the
+    // parent is recycled for the next split.
+    for (auto* child_examples : {&positive_examples, &negative_examples}) {
+      if (child_examples->capacity() == 0 && !free_buffers.empty()) {
+        *child_examples = std::move(free_buffers.back());
+        free_buffers.pop_back();
+      }
+    }
     RETURN_IF_ERROR(internal::SplitExamples(
         train_dataset, split.example_idxs, condition,
         /*dataset_is_dense=*/false,
         dt_config.internal_error_on_wrong_splitter_statistics(),
         &positive_examples, &negative_examples));
-
-    RETURN_IF_ERROR(ingest_node(
-        positive_examples, split.node->mutable_pos_child(), split.depth + 1));
-    RETURN_IF_ERROR(ingest_node(
-        negative_examples, split.node->mutable_neg_child(), split.depth + 1));
+    free_buffers.push_back(std::move(split.example_idxs));
+
+    RETURN_IF_ERROR(ingest_node(std::move(positive_examples),
+                                split.node->mutable_pos_child(),
+                                split.depth + 1));
+    RETURN_IF_ERROR(ingest_node(std::move(negative_examples),
+                                split.node->mutable_neg_child(),
+                                split.depth + 1));
     num_nodes++;
   }
 
@@ -3989,6 +4586,34 @@ absl::Status NodeTrain(
     local_train_dataset_is_compact = true;
   }
 
+  // Prepare the histogram cache entry of the node (see
+  // "HessianHistogramCache"). The sibling subtraction relies on the
+  // depth-first node training order and is therefore disabled when the
+  // splitter work is distributed over multiple threads. Random local
+  // imputation re-generates the training examples at every node, which
+  // invalidates histograms across nodes.
+  const bool use_hessian_histograms =
+      dt_config.internal().hessian_histogram_sibling_subtraction() &&
+      internal_config.use_hessian_gain &&
+      !splitter_concurrency_setup.concurrent_execution &&
+      dt_config.missing_value_policy() !=
+          proto::DecisionTreeTrainingConfig::RANDOM_LOCAL_IMPUTATION;
+  HessianHistogramCache::NodeHistograms* hessian_store = nullptr;
+  if (use_hessian_histograms) {
+    auto& histograms = cache->hessian_histograms;
+    while (histograms.per_depth.size() < depth) {
+      histograms.per_depth.push_back(
+          absl::make_unique<HessianHistogramCache::NodeHistograms>());
+    }
+    hessian_store = histograms.per_depth[depth - 1].get();
+    hessian_store->per_attribute.resize(local_train_dataset->ncol());
+    hessian_store->node_id = ++histograms.last_node_id;
+    cache->hessian_histogram_store = hessian_store;
+    // "cache->hessian_histogram_parent" and
+    // "cache->hessian_histogram_sibling_node_id" have been set by the parent
+    // node (or left unset for the root).
+  }
+
   // Determine the best split.
   ASSIGN_OR_RETURN(
       const auto has_better_condition,
@@ -3997,6 +4622,12 @@ absl::Status NodeTrain(
           config_link, dt_config, splitter_concurrency_setup, node->node(),
           internal_config, node->mutable_node()->mutable_condition(), random,
           cache));
+
+  // Consume the histogram cache context of the node.
+  cache->hessian_histogram_store = nullptr;
+  cache->hessian_histogram_parent = nullptr;
+  cache->hessian_histogram_sibling_node_id = -1;
+
   if (!has_better_condition) {
     // No good condition found. Close the branch.
     node->FinalizeAsLeaf(dt_config.store_detailed_label_distribution());
@@ -4019,11 +4650,18 @@ absl::Status NodeTrain(
       per_depth_cache.positive_examples;
   std::vector<UnsignedExampleIdx>& negative_examples =
       per_depth_cache.negative_examples;
+  // If the node is split by an oblique condition, the values of the winning
+  // projection were already computed by the split finder and can be re-used
+  // to partition the examples.
+  const std::vector<float>* cached_projection_values =
+      internal::FindCachedProjectionValues(node->node().condition(),
+                                           selected_examples.size(), *cache);
   RETURN_IF_ERROR(internal::SplitExamples(
       *local_train_dataset, selected_examples, node->node().condition(),
       local_train_dataset_is_compact,
       dt_config.internal_error_on_wrong_splitter_statistics(),
-      &positive_examples, &negative_examples));
+      &positive_examples, &negative_examples,
+      /*examples_are_training_examples=*/true, cached_projection_values));
 
   // Separate the positive and negative examples used only to determine the node
   // value.
@@ -4039,11 +4677,29 @@ absl::Status NodeTrain(
         /*examples_are_training_examples=*/false));
   }
 
+  // Identifier of the next trained node. If the positive child stores its
+  // histograms, it will receive this identifier.
+  const int64_t pos_child_node_id = cache->hessian_histograms.last_node_id + 1;
+
   // Positive child.
   RETURN_IF_ERROR(NodeTrain(
       train_dataset, positive_examples, positive_node_only_examples, config,
       config_link, dt_config, deployment, splitter_concurrency_setup, weights,
       depth + 1, internal_config, node->mutable_pos_child(), random, cache));
+
+  if (use_hessian_histograms &&
+      cache->hessian_histograms.per_depth.size() > depth &&
+      cache->hessian_histograms.per_depth[depth]->node_id ==
+          pos_child_node_id) {
+    // The positive child stored its histograms: the negative child can derive
+    // its own histograms by subtracting them from the histograms of this node.
+    cache->hessian_histogram_parent = hessian_store;
+    cache->hessian_histogram_sibling_node_id = pos_child_node_id;
+  } else {
+    cache->hessian_histogram_parent = nullptr;
+    cache->hessian_histogram_sibling_node_id = -1;
+  }
+
   // Negative child.
   RETURN_IF_ERROR(NodeTrain(
       train_dataset, negative_examples, negative_node_only_examples, config,
@@ -4069,6 +4725,16 @@ utils::StatusOr<Preprocessing> PreprocessTrainingDataset(
                                              num_threads, &preprocessing));
   }
 
+  if (dt_config.internal().exclusive_boolean_feature_bundling()) {
+    RETURN_IF_ERROR(ComputeExclusiveBooleanFeatureBundles(
+        train_dataset, config_link, &preprocessing));
+  }
+
+  if (dt_config.internal().bit_packed_boolean_features()) {
+    RETURN_IF_ERROR(ComputePackedBooleanFeatures(train_dataset, config,
+                                                 config_link, &preprocessing));
+  }
+
   const auto duration = absl::Now() - time_begin;
   if (duration > absl::Seconds(10)) {
     LOG(INFO) << "Feature index computed in " << absl::FormatDuration(duration);
@@ -4076,6 +4742,74 @@ utils::StatusOr<Preprocessing> PreprocessTrainingDataset(
   return preprocessing;
 }
 
+namespace {
+
+// Feature value (transformed into an order-preserving integer) and example
+// index of a single example during the presorting of a numerical feature.
+struct PresortItem {
+  uint32_t key;
+  SparseItem::ExampleIdx example_idx;
+};
+
+// Minimum number of examples for the radix sort to be worth its constant
+// cost (digit counting and scratch buffer allocation). Below this limit, a
+// comparison sort is used instead.
+constexpr size_t kMinNumExamplesForRadixSort = 4096;
+
+// Transforms a float into an unsigned integer such that the natural ordering
+// of the transformed values matches the ordering of the original floating
+// point values, and equal floating point values map to equal integers.
+// "value" should not be NaN.
+uint32_t FloatToOrderedInteger(const float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  if (bits == 0x80000000u) {
+    // Map -0 to +0: the two values compare equal as floats.
+    bits = 0;
+  }
+  // Flip all the bits of negative values, and only the sign bit of positive
+  // values.
+  return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+// Sorts "items" by increasing "key" with a stable LSD radix sort (two passes
+// of 16 bits). Ties are kept in their original order i.e. sorted by example
+// index if "items" is initially sorted by example index.
+void RadixSortPresortItems(std::vector<PresortItem>* items) {
+  constexpr int kDigitBits = 16;
+  constexpr size_t kNumBuckets = size_t{1} << kDigitBits;
+  static_assert(sizeof(PresortItem::key) * 8 == 2 * kDigitBits,
+                "The sort expects exactly two passes");
+
+  std::vector<PresortItem> buffer(items->size());
+  std::vector<size_t> bucket_offsets(kNumBuckets);
+
+  auto* src = items;
+  auto* dst = &buffer;
+  for (int shift = 0; shift < 2 * kDigitBits; shift += kDigitBits) {
+    // Count the number of items in each bucket.
+    std::fill(bucket_offsets.begin(), bucket_offsets.end(), 0);
+    for (const auto& item : *src) {
+      bucket_offsets[(item.key >> shift) & (kNumBuckets - 1)]++;
+    }
+    // Turn the counts into write offsets.
+    size_t offset = 0;
+    for (auto& bucket_offset : bucket_offsets) {
+      const size_t num_items = bucket_offset;
+      bucket_offset = offset;
+      offset += num_items;
+    }
+    // Scatter the items.
+    for (const auto& item : *src) {
+      (*dst)[bucket_offsets[(item.key >> shift) & (kNumBuckets - 1)]++] = item;
+    }
+    std::swap(src, dst);
+  }
+  // After an even number of passes, the sorted items are back in "items".
+}
+
+}  // namespace
+
 absl::Status PresortNumericalFeatures(
     const dataset::VerticalDataset& train_dataset,
     const model::proto::TrainingConfigLinking& config_link,
@@ -4113,19 +4847,26 @@ absl::Status PresortNumericalFeatures(
       const float na_replacement_value =
           train_dataset.data_spec().columns(feature_idx).numerical().mean();
 
-      std::vector<std::pair<float, SparseItem::ExampleIdx>> items(
-          values.size());
+      std::vector<PresortItem> items(values.size());
       for (UnsignedExampleIdx example_idx = 0; example_idx < num_examples;
            example_idx++) {
         auto value = values[example_idx];
         if (std::isnan(value)) {
           value = na_replacement_value;
         }
-        items[example_idx] = {value, example_idx};
+        items[example_idx] = {FloatToOrderedInteger(value), example_idx};
       }
 
       // Sort by feature value and example index.
-      std::sort(items.begin(), items.end());
+      if (items.size() >= kMinNumExamplesForRadixSort) {
+        RadixSortPresortItems(&items);
+      } else {
+        std::sort(items.begin(), items.end(),
+                  [](const PresortItem& a, const PresortItem& b) {
+                    return a.key < b.key ||
+                           (a.key == b.key && a.example_idx < b.example_idx);
+                  });
+      }
 
       auto& sorted_values =
           (*preprocessing->mutable_presorted_numerical_features())[feature_idx];
@@ -4133,10 +4874,11 @@ absl::Status PresortNumericalFeatures(
 
       for (UnsignedExampleIdx sorted_example_idx = 0;
            sorted_example_idx < num_examples; sorted_example_idx++) {
-        SparseItem::ExampleIdx example_idx = items[sorted_example_idx].second;
+        SparseItem::ExampleIdx example_idx =
+            items[sorted_example_idx].example_idx;
         const bool change_value =
-            sorted_example_idx > 0 && (items[sorted_example_idx].first !=
-                                       items[sorted_example_idx - 1].first);
+            sorted_example_idx > 0 && (items[sorted_example_idx].key !=
+                                       items[sorted_example_idx - 1].key);
         if (change_value) {
           example_idx |= ((SparseItem::ExampleIdx)1)
                          << (sizeof(SparseItem::ExampleIdx) * 8 - 1);
@@ -4149,6 +4891,162 @@ absl::Status PresortNumericalFeatures(
   return absl::OkStatus();
 }
 
+absl::Status ComputeExclusiveBooleanFeatureBundles(
+    const dataset::VerticalDataset& train_dataset,
+    const model::proto::TrainingConfigLinking& config_link,
+    Preprocessing* preprocessing) {
+  RETURN_IF_ERROR(CheckNumExamples(train_dataset.nrow()));
+  const UnsignedExampleIdx num_examples = train_dataset.nrow();
+
+  auto& bundles = *preprocessing->mutable_boolean_feature_bundles();
+
+  // Greedy first-fit bundling: each boolean input feature is added to the
+  // first bundle with no example where both the feature and the bundle are
+  // "true". Features with missing values are skipped: bundling them would
+  // require encoding the missing value replacement in the bundle.
+  for (const auto feature_idx : config_link.features()) {
+    const auto& column_spec = train_dataset.data_spec().columns(feature_idx);
+    if (column_spec.type() != dataset::proto::ColumnType::BOOLEAN ||
+        column_spec.count_nas() > 0) {
+      continue;
+    }
+    ASSIGN_OR_RETURN(
+        const auto* column,
+        train_dataset
+            .ColumnWithCastWithStatus<dataset::VerticalDataset::BooleanColumn>(
+                feature_idx));
+    const auto& values = column->values();
+    DCHECK_EQ(values.size(), num_examples);
+
+    Preprocessing::BooleanFeatureBundle* selected_bundle = nullptr;
+    for (auto& bundle : bundles) {
+      bool conflict = false;
+      for (UnsignedExampleIdx example_idx = 0; example_idx < num_examples;
+           example_idx++) {
+        if (values[example_idx] ==
+                dataset::VerticalDataset::BooleanColumn::kTrueValue &&
+            bundle.values[example_idx] != 0) {
+          conflict = true;
+          break;
+        }
+      }
+      if (!conflict) {
+        selected_bundle = &bundle;
+        break;
+      }
+    }
+
+    if (selected_bundle == nullptr) {
+      bundles.emplace_back();
+      selected_bundle = &bundles.back();
+      selected_bundle->values.assign(num_examples, 0);
+    }
+
+    selected_bundle->features.push_back(feature_idx);
+    const int32_t bundle_value = selected_bundle->features.size();
+    for (UnsignedExampleIdx example_idx = 0; example_idx < num_examples;
+         example_idx++) {
+      if (values[example_idx] ==
+          dataset::VerticalDataset::BooleanColumn::kTrueValue) {
+        selected_bundle->values[example_idx] = bundle_value;
+      }
+    }
+  }
+
+  // Bundles with a single feature are not worth the indirection.
+  bundles.erase(std::remove_if(bundles.begin(), bundles.end(),
+                               [](const Preprocessing::BooleanFeatureBundle&
+                                      bundle) {
+                                 return bundle.features.size() < 2;
+                               }),
+                bundles.end());
+
+  auto& feature_to_bundle = *preprocessing->mutable_boolean_feature_to_bundle();
+  if (!bundles.empty()) {
+    feature_to_bundle.assign(train_dataset.data_spec().columns_size(), -1);
+    for (int bundle_idx = 0; bundle_idx < bundles.size(); bundle_idx++) {
+      for (const auto feature_idx : bundles[bundle_idx].features) {
+        feature_to_bundle[feature_idx] = bundle_idx;
+      }
+    }
+  }
+
+  return absl::OkStatus();
+}
+
+absl::Status ComputePackedBooleanFeatures(
+    const dataset::VerticalDataset& train_dataset,
+    const model::proto::TrainingConfig& config,
+    const model::proto::TrainingConfigLinking& config_link,
+    Preprocessing* preprocessing) {
+  RETURN_IF_ERROR(CheckNumExamples(train_dataset.nrow()));
+  const UnsignedExampleIdx num_examples = train_dataset.nrow();
+
+  bool has_boolean_features = false;
+  for (const auto feature_idx : config_link.features()) {
+    if (train_dataset.data_spec().columns(feature_idx).type() ==
+        dataset::proto::ColumnType::BOOLEAN) {
+      has_boolean_features = true;
+      break;
+    }
+  }
+  if (!has_boolean_features) {
+    return absl::OkStatus();
+  }
+
+  auto& packed_features = *preprocessing->mutable_packed_boolean_features();
+  packed_features.resize(train_dataset.data_spec().columns_size());
+  for (const auto feature_idx : config_link.features()) {
+    if (train_dataset.data_spec().columns(feature_idx).type() !=
+        dataset::proto::ColumnType::BOOLEAN) {
+      continue;
+    }
+    ASSIGN_OR_RETURN(
+        const auto* column,
+        train_dataset
+            .ColumnWithCastWithStatus<dataset::VerticalDataset::BooleanColumn>(
+                feature_idx));
+    const auto& values = column->values();
+    DCHECK_EQ(values.size(), num_examples);
+
+    auto& packed = packed_features[feature_idx];
+    utils::bitmap::AllocateAndZeroBitMap(num_examples, &packed.values);
+    utils::bitmap::AllocateAndZeroBitMap(num_examples, &packed.nas);
+    for (UnsignedExampleIdx example_idx = 0; example_idx < num_examples;
+         example_idx++) {
+      const char value = values[example_idx];
+      if (value == dataset::VerticalDataset::BooleanColumn::kTrueValue) {
+        utils::bitmap::SetValueBit(example_idx, &packed.values);
+      } else if (value == dataset::VerticalDataset::BooleanColumn::kNaValue) {
+        utils::bitmap::SetValueBit(example_idx, &packed.nas);
+      }
+    }
+  }
+
+  // Bit-pack the labels of binary classification.
+  if (config.task() == model::proto::Task::CLASSIFICATION &&
+      train_dataset.data_spec()
+              .columns(config_link.label())
+              .categorical()
+              .number_of_unique_values() == 3) {
+    ASSIGN_OR_RETURN(const auto* label_column,
+                     train_dataset.ColumnWithCastWithStatus<
+                         dataset::VerticalDataset::CategoricalColumn>(
+                         config_link.label()));
+    const auto& labels = label_column->values();
+    auto& packed_labels = *preprocessing->mutable_packed_binary_labels();
+    utils::bitmap::AllocateAndZeroBitMap(num_examples, &packed_labels);
+    for (UnsignedExampleIdx example_idx = 0; example_idx < num_examples;
+         example_idx++) {
+      if (labels[example_idx] == 2) {
+        utils::bitmap::SetValueBit(example_idx, &packed_labels);
+      }
+    }
+  }
+
+  return absl::OkStatus();
+}
+
 namespace internal {
 
 bool MaskPureSampledOrPrunedItemsForCategoricalSetGreedySelection(
@@ -4226,7 +5124,8 @@ absl::Status SplitExamples(const dataset::VerticalDataset& dataset,
                            const bool error_on_wrong_splitter_statistics,
                            std::vector<UnsignedExampleIdx>* positive_examples,
                            std::vector<UnsignedExampleIdx>* negative_examples,
-                           const bool examples_are_training_examples) {
+                           const bool examples_are_training_examples,
+                           const std::vector<float>* cached_projection_values) {
   if (examples_are_training_examples) {
     positive_examples->reserve(
         condition.num_pos_training_examples_without_weight());
@@ -4243,7 +5142,23 @@ absl::Status SplitExamples(const dataset::VerticalDataset& dataset,
   // Index of the example selected for this node.
   const auto column_data = dataset.column(condition.attribute());
 
-  if (!dataset_is_dense) {
+  if (cached_projection_values != nullptr &&
+      condition.condition().has_oblique_condition() &&
+      cached_projection_values->size() == examples.size()) {
+    // The split finder already evaluated the projection of the condition on
+    // the examples of the node: partition on the cached values instead of
+    // re-computing the projection for every example. A NaN value indicates
+    // that at least one of the input features is missing.
+    const float threshold =
+        condition.condition().oblique_condition().threshold();
+    const bool na_value = condition.na_value();
+    for (size_t selected_idx = 0; selected_idx < examples.size();
+         selected_idx++) {
+      const float value = (*cached_projection_values)[selected_idx];
+      const bool eval = std::isnan(value) ? na_value : value >= threshold;
+      example_sets[eval]->push_back(examples[selected_idx]);
+    }
+  } else if (!dataset_is_dense) {
     for (const UnsignedExampleIdx example_idx : examples) {
       const auto dst = example_sets[EvalConditionFromColumn(
           condition, column_data, dataset, example_idx)];
@@ -4296,6 +5211,37 @@ absl::Status SplitExamples(const dataset::VerticalDataset& dataset,
   return absl::OkStatus();
 }
 
+const std::vector<float>* FindCachedProjectionValues(
+    const proto::NodeCondition& condition, const size_t num_examples,
+    const PerThreadCache& cache) {
+  if (!condition.condition().has_oblique_condition()) {
+    return nullptr;
+  }
+  const auto& oblique = condition.condition().oblique_condition();
+  for (const auto& splitter_cache : cache.splitter_cache_list) {
+    if (splitter_cache.best_projection_values.size() != num_examples) {
+      continue;
+    }
+    const auto& candidate = splitter_cache.best_projection_condition;
+    if (!candidate.condition().has_oblique_condition()) {
+      continue;
+    }
+    const auto& candidate_oblique = candidate.condition().oblique_condition();
+    if (candidate_oblique.threshold() != oblique.threshold() ||
+        candidate.na_value() != condition.na_value() ||
+        !std::equal(candidate_oblique.attributes().begin(),
+                    candidate_oblique.attributes().end(),
+                    oblique.attributes().begin(), oblique.attributes().end()) ||
+        !std::equal(candidate_oblique.weights().begin(),
+                    candidate_oblique.weights().end(),
+                    oblique.weights().begin(), oblique.weights().end())) {
+      continue;
+    }
+    return &splitter_cache.best_projection_values;
+  }
+  return nullptr;
+}
+
 void UpliftLeafToLabelDist(const decision_tree::proto::NodeUpliftOutput& leaf,
                            UpliftLabelDistribution* dist) {
   dist->ImportSetFromLeafProto(leaf);
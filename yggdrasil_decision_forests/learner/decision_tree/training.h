@@ -19,6 +19,7 @@
 #include <functional>
 #include <memory>
 #include <random>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -121,6 +122,44 @@ struct NumericalUpliftLabelStats : LabelStats {
   UpliftLabelDistribution label_distribution;
 };
 
+// Per-bin gradient/hessian statistics (i.e. histograms) of the discretized
+// numerical features of the nodes on the path currently being trained.
+//
+// Nodes are trained depth-first, positive child first. Therefore, when the
+// negative child of a node is trained, the cache contains both the histograms
+// of the parent (at the depth of the node) and of the positive sibling (at the
+// depth of the child), and the histograms of the negative child can be derived
+// by subtraction instead of scanning the training examples.
+//
+// Entries are validated with node identifiers (unique over the lifetime of the
+// cache): an attribute histogram only belongs to a node if its "node_id"
+// matches. This handles nodes for which an attribute was not tested (e.g.
+// attribute sampling) as well as entries remaining from previously trained
+// nodes or trees.
+struct HessianHistogramCache {
+  struct AttributeHistogram {
+    // Identifier of the node that filled the histogram.
+    int64_t node_id = -1;
+    // Per-bin gradient/hessian statistics.
+    std::vector<LabelHessianNumericalBucket> bins;
+  };
+
+  struct NodeHistograms {
+    // Histograms indexed by attribute.
+    std::vector<AttributeHistogram> per_attribute;
+    // Identifier of the node the entry belongs to.
+    int64_t node_id = -1;
+  };
+
+  // "per_depth[i]" contains the histograms of the last node trained at depth
+  // "i+1" (the root node has depth 1).
+  // Note: We use a unique pointer to guaranty stability of content.
+  std::vector<std::unique_ptr<NodeHistograms>> per_depth;
+
+  // Number of node identifiers already attributed.
+  int64_t last_node_id = 0;
+};
+
 // A collection of objects used by split-finding methods.
 //
 // The purpose of this cache structure is to avoid repeated allocation of the
@@ -148,10 +187,34 @@ struct SplitterPerThreadCache {
   std::vector<int64_t> attr_to_num_examples;
 
   std::vector<int> numerical_features;
-  std::vector<float> projection_values;
+
+  // Values of a batch of oblique projections, indexed by projection then by
+  // selected example. See "FindBestConditionSparseOblique".
+  std::vector<std::vector<float>> projection_values;
+
+  // Values of the best oblique projection found by the last call to the
+  // sparse oblique splitter on this cache, aligned with the selected
+  // examples, and the condition built from this projection. If the oblique
+  // condition is the final condition of the node, "SplitExamples" partitions
+  // the examples with these values instead of re-evaluating the projection on
+  // every example. See "FindCachedProjectionValues".
+  std::vector<float> best_projection_values;
+  proto::NodeCondition best_projection_condition;
 
   PerThreadCacheV2 cache_v2;
 
+  // Where the hessian discretized numerical splitter stores the histograms of
+  // the node being split, and, if available, the histograms of the parent of
+  // the node (in which case "hessian_histogram_store" initially contains the
+  // histograms of the sibling, identified by
+  // "hessian_histogram_sibling_node_id"). Only set by the single-thread
+  // splitter manager when "hessian_histogram_sibling_subtraction" is enabled.
+  // See "HessianHistogramCache".
+  HessianHistogramCache::NodeHistograms* hessian_histogram_store = nullptr;
+  const HessianHistogramCache::NodeHistograms* hessian_histogram_parent =
+      nullptr;
+  int64_t hessian_histogram_sibling_node_id = -1;
+
   utils::RandomEngine random;
 };
 
@@ -174,6 +237,19 @@ struct SplitterWorkManagerData {
   int job_idx;
 };
 
+// Slice of the random oblique projections tested for a node. When the
+// projection search is distributed over several workers, each worker evaluates
+// a contiguous slice of the projections. Projection "begin + i" is seeded from
+// the node seed and its index (see "utils::DeriveSeed"), so the generated
+// projections only depend on the node seed and not on how the search is sliced
+// into work units.
+struct ObliqueProjectionSlice {
+  // Index of the first projection of the slice.
+  int begin;
+  // Number of projections in the slice.
+  int num_projections;
+};
+
 // Work request for a splitter i.e. finding the best possible condition for a
 // given attribute on a given dataset.
 struct SplitterWorkRequest {
@@ -192,7 +268,7 @@ struct SplitterWorkRequest {
   utils::RandomEngine::result_type seed;
   // If set, search for oblique split. In this case "attribute_idx" should be
   // -1.
-  absl::optional<int> num_oblique_projections_to_run;
+  absl::optional<ObliqueProjectionSlice> oblique_projection_slice;
 };
 
 // Contains the result of a splitter.
@@ -203,9 +279,16 @@ struct SplitterWorkResponse {
   SplitSearchResult status;
 };
 
+// The work queue is a lock-free channel: the manager pushes one request per
+// feature per node and the mutex-based "Channel" becomes a contention point
+// with many threads. The number of in-flight requests is bounded by the number
+// of threads (see "FindBestConditionConcurrentManager"), so the channel
+// capacity is never exceeded.
 using SplitterFinderStreamProcessor =
     yggdrasil_decision_forests::utils::concurrency::StreamProcessor<
-        SplitterWorkRequest, SplitterWorkResponse>;
+        SplitterWorkRequest, SplitterWorkResponse,
+        yggdrasil_decision_forests::utils::concurrency::LockFreeChannel<
+            SplitterWorkRequest>>;
 
 // Records the status of workers in a concurrent setup.
 // Part of the worker response (SplitterWorkResponse) that need to be kept in
@@ -248,6 +331,16 @@ struct PerThreadCache {
   // Note: We use a unique pointer to guaranty stability of content.
   std::vector<std::unique_ptr<PerDepth>> per_depth;
 
+  // Histograms used by the hessian discretized numerical splitter, and the
+  // context of the node currently being split. Maintained by "NodeTrain" when
+  // "hessian_histogram_sibling_subtraction" is enabled. See
+  // "HessianHistogramCache".
+  HessianHistogramCache hessian_histograms;
+  HessianHistogramCache::NodeHistograms* hessian_histogram_store = nullptr;
+  const HessianHistogramCache::NodeHistograms* hessian_histogram_parent =
+      nullptr;
+  int64_t hessian_histogram_sibling_node_id = -1;
+
   // A set of objects that are used by FindBestCondition.
   std::vector<SplitterPerThreadCache> splitter_cache_list;
   std::vector<SplitterWorkDurableResponse> durable_response_list;
@@ -257,6 +350,12 @@ struct PerThreadCache {
   utils::CircularBuffer<int32_t> available_cache_idxs;
   // List of available indices into condition_list.
   utils::CircularBuffer<int32_t> available_condition_idxs;
+
+  // Batches of requests and responses exchanged with the split finder
+  // processor with single channel operations instead of one per item. See
+  // "FindBestConditionConcurrentManager".
+  std::vector<SplitterWorkRequest> request_batch;
+  std::vector<SplitterWorkResponse> response_batch;
 };
 
 // In a concurrent setup, this structure encapsulates all the objects that are
@@ -295,6 +394,29 @@ class Preprocessing {
     std::vector<SparseItem> items;
   };
 
+  // A set of mutually exclusive boolean input features i.e. features that are
+  // never "true" on the same training example (e.g. one-hot encodings). The
+  // boolean splits of all the features of a bundle can be evaluated with a
+  // single pass over the examples. See
+  // "exclusive_boolean_feature_bundling" in the training configuration.
+  struct BooleanFeatureBundle {
+    // Column indices of the bundled features.
+    std::vector<int> features;
+
+    // Value of the bundle for each example: 0 if none of the bundled features
+    // is true, "i+1" if "features[i]" is true.
+    std::vector<int32_t> values;
+  };
+
+  // Bit-packed replica of a boolean input feature. Bit "example_idx" of
+  // "values" (resp. "nas") is set iff the feature is true (resp. missing) for
+  // the example. Bitmaps use the format of "utils/bitmap.h". See
+  // "bit_packed_boolean_features" in the training configuration.
+  struct PackedBooleanFeature {
+    std::string values;
+    std::string nas;
+  };
+
   std::vector<PresortedNumericalFeature>*
   mutable_presorted_numerical_features() {
     return &presorted_numerical_features_;
@@ -305,6 +427,36 @@ class Preprocessing {
     return presorted_numerical_features_;
   }
 
+  std::vector<BooleanFeatureBundle>* mutable_boolean_feature_bundles() {
+    return &boolean_feature_bundles_;
+  }
+
+  const std::vector<BooleanFeatureBundle>& boolean_feature_bundles() const {
+    return boolean_feature_bundles_;
+  }
+
+  std::vector<int>* mutable_boolean_feature_to_bundle() {
+    return &boolean_feature_to_bundle_;
+  }
+
+  const std::vector<int>& boolean_feature_to_bundle() const {
+    return boolean_feature_to_bundle_;
+  }
+
+  std::vector<PackedBooleanFeature>* mutable_packed_boolean_features() {
+    return &packed_boolean_features_;
+  }
+
+  const std::vector<PackedBooleanFeature>& packed_boolean_features() const {
+    return packed_boolean_features_;
+  }
+
+  std::string* mutable_packed_binary_labels() { return &packed_binary_labels_; }
+
+  const std::string& packed_binary_labels() const {
+    return packed_binary_labels_;
+  }
+
   uint64_t num_examples() const { return num_examples_; }
 
   void set_num_examples(const uint64_t value) { num_examples_ = value; }
@@ -315,6 +467,27 @@ class Preprocessing {
   // "presorted_numerical_features_[i]" will be an empty index.
   std::vector<PresortedNumericalFeature> presorted_numerical_features_;
 
+  // Bundles of mutually exclusive boolean features. Empty unless
+  // "exclusive_boolean_feature_bundling" is enabled. Only bundles with at
+  // least two features are kept.
+  std::vector<BooleanFeatureBundle> boolean_feature_bundles_;
+
+  // Mapping from feature index to the index of its bundle in
+  // "boolean_feature_bundles_", or -1 if the feature is not bundled. Empty if
+  // there are no bundles.
+  std::vector<int> boolean_feature_to_bundle_;
+
+  // Bit-packed boolean features, indexed by feature index. If feature "i" is
+  // not boolean, "packed_boolean_features_[i].values" will be empty. Empty
+  // unless "bit_packed_boolean_features" is enabled and at least one input
+  // feature is boolean.
+  std::vector<PackedBooleanFeature> packed_boolean_features_;
+
+  // Bitmap of the examples with the positive label (i.e. label value 2).
+  // Only set for binary classification, and empty unless
+  // "packed_boolean_features_" is set.
+  std::string packed_binary_labels_;
+
   // Total number of examples.
   uint64_t num_examples_ = -1;
 };
@@ -556,8 +729,8 @@ SplitSearchResult FindSplitLabelClassificationFeatureBoolean(
     bool na_replacement, UnsignedExampleIdx min_num_obs,
     const proto::DecisionTreeTrainingConfig& dt_config,
     const utils::IntegerDistributionDouble& label_distribution,
-    int32_t attribute_idx, proto::NodeCondition* condition,
-    SplitterPerThreadCache* cache);
+    int32_t attribute_idx, const InternalTrainConfig& internal_config,
+    proto::NodeCondition* condition, SplitterPerThreadCache* cache);
 
 // Search for the best split of the type Boolean for regression.
 SplitSearchResult FindSplitLabelRegressionFeatureBoolean(
@@ -580,6 +753,54 @@ SplitSearchResult FindSplitLabelHessianRegressionFeatureBoolean(
     const InternalTrainConfig& internal_config, proto::NodeCondition* condition,
     SplitterPerThreadCache* cache);
 
+// Searches for the best boolean splits of several features of an exclusive
+// boolean feature bundle (see "Preprocessing::BooleanFeatureBundle") with a
+// single pass over the examples for classification. "member_features"
+// contains the indices, in "bundle.features", of the members to evaluate.
+// "member_results" receives the search result of each evaluated member, in
+// the same order. "condition" is updated like with the per-feature splitters.
+void FindSplitsLabelClassificationExclusiveBooleanBundle(
+    const dataset::VerticalDataset& train_dataset,
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const std::vector<float>& weights,
+    const Preprocessing::BooleanFeatureBundle& bundle,
+    const std::vector<int>& member_features, const std::vector<int32_t>& labels,
+    int32_t num_label_classes, UnsignedExampleIdx min_num_obs,
+    const utils::IntegerDistributionDouble& label_distribution,
+    proto::NodeCondition* condition,
+    std::vector<SplitSearchResult>* member_results,
+    SplitterPerThreadCache* cache);
+
+// Same as "FindSplitsLabelClassificationExclusiveBooleanBundle", but for
+// regression.
+void FindSplitsLabelRegressionExclusiveBooleanBundle(
+    const dataset::VerticalDataset& train_dataset,
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const std::vector<float>& weights,
+    const Preprocessing::BooleanFeatureBundle& bundle,
+    const std::vector<int>& member_features, const std::vector<float>& labels,
+    UnsignedExampleIdx min_num_obs,
+    const utils::NormalDistributionDouble& label_distribution,
+    proto::NodeCondition* condition,
+    std::vector<SplitSearchResult>* member_results,
+    SplitterPerThreadCache* cache);
+
+// Same as "FindSplitsLabelClassificationExclusiveBooleanBundle", but for
+// regression with hessian gain.
+void FindSplitsLabelHessianRegressionExclusiveBooleanBundle(
+    const dataset::VerticalDataset& train_dataset,
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const std::vector<float>& weights,
+    const Preprocessing::BooleanFeatureBundle& bundle,
+    const std::vector<int>& member_features,
+    const std::vector<float>& gradients, const std::vector<float>& hessians,
+    UnsignedExampleIdx min_num_obs,
+    const proto::DecisionTreeTrainingConfig& dt_config, double sum_gradient,
+    double sum_hessian, double sum_weights,
+    const InternalTrainConfig& internal_config, proto::NodeCondition* condition,
+    std::vector<SplitSearchResult>* member_results,
+    SplitterPerThreadCache* cache);
+
 // Search for the best split for a numerical attribute and a categorical label
 // using the CART algorithm for a dataset loaded in memory. All the threshold
 // are evaluated. All Na values are replaced by "na_replacement". Does not
@@ -872,7 +1093,7 @@ utils::StatusOr<bool> FindBestConditionSparseOblique(
     const proto::DecisionTreeTrainingConfig& dt_config,
     const proto::Node& parent, const InternalTrainConfig& internal_config,
     const LabelStats& label_stats,
-    const absl::optional<int>& override_num_projections,
+    const absl::optional<ObliqueProjectionSlice>& projection_slice,
     proto::NodeCondition* best_condition, utils::RandomEngine* random,
     SplitterPerThreadCache* cache);
 
@@ -983,6 +1204,24 @@ absl::Status PresortNumericalFeatures(
     const model::proto::TrainingConfigLinking& config_link, int num_threads,
     Preprocessing* preprocessing);
 
+// Component of "PreprocessTrainingDataset". Greedily groups the mutually
+// exclusive boolean input features into bundles (see
+// "Preprocessing::BooleanFeatureBundle"). Boolean features with missing
+// values are not bundled. Bundles with a single feature are discarded.
+absl::Status ComputeExclusiveBooleanFeatureBundles(
+    const dataset::VerticalDataset& train_dataset,
+    const model::proto::TrainingConfigLinking& config_link,
+    Preprocessing* preprocessing);
+
+// Component of "PreprocessTrainingDataset". Bit-packs the boolean input
+// features (see "Preprocessing::PackedBooleanFeature") and, for binary
+// classification, the labels. No-op if no input feature is boolean.
+absl::Status ComputePackedBooleanFeatures(
+    const dataset::VerticalDataset& train_dataset,
+    const model::proto::TrainingConfig& config,
+    const model::proto::TrainingConfigLinking& config_link,
+    Preprocessing* preprocessing);
+
 // Set the default values of the hyper-parameters.
 void SetDefaultHyperParameters(proto::DecisionTreeTrainingConfig* config);
 
@@ -1019,6 +1258,12 @@ std::vector<float> GenHistogramBins(proto::NumericalSplit::Type type,
 //
 // If "examples_are_training_examples=true", optimizes the allocation by
 // assuming "examples" are the examples used to train the tree.
+//
+// If "cached_projection_values" is non-null, it contains the values of the
+// oblique projection of "condition" on "examples" (in the same order),
+// already computed by the split finder: the examples are partitioned on these
+// values instead of re-evaluating the projection. See
+// "FindCachedProjectionValues".
 absl::Status SplitExamples(const dataset::VerticalDataset& dataset,
                            const std::vector<UnsignedExampleIdx>& examples,
                            const proto::NodeCondition& condition,
@@ -1026,7 +1271,18 @@ absl::Status SplitExamples(const dataset::VerticalDataset& dataset,
     bool error_on_wrong_splitter_statistics,
                            std::vector<UnsignedExampleIdx>* positive_examples,
                            std::vector<UnsignedExampleIdx>* negative_examples,
-    const bool examples_are_training_examples = true);
+    const bool examples_are_training_examples = true,
+    const std::vector<float>* cached_projection_values = nullptr);
+
+// Searches the splitter caches of the node for the values of the oblique
+// projection of "condition", computed by the sparse oblique splitter when the
+// condition was found. Returns null if "condition" is not oblique or if no
+// cache holds matching values (e.g. the cache of the winning projection was
+// recycled for another oblique slice of the same node). The returned values
+// are aligned with the "num_examples" selected examples of the node.
+const std::vector<float>* FindCachedProjectionValues(
+    const proto::NodeCondition& condition, size_t num_examples,
+    const PerThreadCache& cache);
 
 // Copies the content on uplift categorical leaf output to a label distribution.
 void UpliftLeafToLabelDist(const decision_tree::proto::NodeUpliftOutput& leaf,
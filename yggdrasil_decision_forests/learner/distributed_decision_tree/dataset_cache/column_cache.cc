@@ -15,6 +15,8 @@
 
 #include "yggdrasil_decision_forests/learner/distributed_decision_tree/dataset_cache/column_cache.h"
 
+#include <algorithm>
+
 #include "absl/strings/str_format.h"
 #include "absl/strings/substitute.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
@@ -178,11 +180,25 @@ absl::Status IntegerColumnReader<Value>::Open(absl::string_view path,
                          sizeof(Value), path, file_num_bytes_));
   }
   same_user_and_file_precision_ = kUserNumBytes == file_num_bytes_;
+  max_num_values_ = max_num_values;
+  mmap_offset_bytes_ = 0;
 
-  file_buffer_.resize(file_num_bytes_ * max_num_values);
   if (!same_user_and_file_precision_) {
     user_buffer_.resize(kUserNumBytes * max_num_values);
   }
+
+  ASSIGN_OR_RETURN(use_mmap_, mmap_file_.TryOpen(path));
+  if (use_mmap_) {
+    if ((mmap_file_.size() % file_num_bytes_) != 0) {
+      return absl::InvalidArgumentError(
+          absl::Substitute("The size of $0 is not a multiple of the value "
+                           "precision ($1 bytes)",
+                           path, file_num_bytes_));
+    }
+    return absl::OkStatus();
+  }
+
+  file_buffer_.resize(file_num_bytes_ * max_num_values);
   return file_.Open(path);
 }
 
@@ -193,26 +209,33 @@ absl::Span<const Value> IntegerColumnReader<Value>::Values() {
 
 template <typename Value>
 absl::Span<const char> IntegerColumnReader<Value>::ActiveFileBuffer() {
-  return absl::Span<const char>(file_buffer_.data(),
-                                values_.size() * file_num_bytes_);
+  return file_values_;
 }
 
 template <typename Value>
 absl::Status IntegerColumnReader<Value>::Next() {
-  ASSIGN_OR_RETURN(const auto read_bytes,
-                   file_.ReadUpTo(file_buffer_.data(), file_buffer_.size()));
-  DCHECK_EQ(read_bytes % file_num_bytes_, 0);
-  const auto num_values = read_bytes / file_num_bytes_;
-  if (!same_user_and_file_precision_) {
-    // Convert to the user requested precision.
-    RETURN_IF_ERROR(ConvertIntegerBuffer<Value>(
-        file_buffer_.data(), file_num_bytes_, num_values, user_buffer_.data()));
+  if (use_mmap_) {
+    const size_t read_bytes =
+        std::min(static_cast<size_t>(max_num_values_) * file_num_bytes_,
+                 mmap_file_.size() - mmap_offset_bytes_);
+    file_values_ = absl::Span<const char>(mmap_file_.data() + mmap_offset_bytes_,
+                                          read_bytes);
+    mmap_offset_bytes_ += read_bytes;
+  } else {
+    ASSIGN_OR_RETURN(const auto read_bytes,
+                     file_.ReadUpTo(file_buffer_.data(), file_buffer_.size()));
+    DCHECK_EQ(read_bytes % file_num_bytes_, 0);
+    file_values_ = absl::Span<const char>(file_buffer_.data(), read_bytes);
   }
 
+  const auto num_values = file_values_.size() / file_num_bytes_;
   if (same_user_and_file_precision_) {
     values_ = absl::Span<const Value>(
-        reinterpret_cast<const Value*>(file_buffer_.data()), num_values);
+        reinterpret_cast<const Value*>(file_values_.data()), num_values);
   } else {
+    // Convert to the user requested precision.
+    RETURN_IF_ERROR(ConvertIntegerBuffer<Value>(
+        file_values_.data(), file_num_bytes_, num_values, user_buffer_.data()));
     values_ = absl::Span<const Value>(
         reinterpret_cast<const Value*>(user_buffer_.data()), num_values);
   }
@@ -222,6 +245,9 @@ absl::Status IntegerColumnReader<Value>::Next() {
 
 template <typename Value>
 absl::Status IntegerColumnReader<Value>::Close() {
+  if (use_mmap_) {
+    return mmap_file_.Close();
+  }
   return file_.Close();
 }
 
@@ -436,19 +462,41 @@ absl::Status FloatColumnWriter::Close() {
 
 absl::Status FloatColumnReader::Open(absl::string_view path,
                                      int max_num_values) {
+  max_num_values_ = max_num_values;
+  mmap_offset_values_ = 0;
+
+  ASSIGN_OR_RETURN(use_mmap_, mmap_file_.TryOpen(path));
+  if (use_mmap_) {
+    if ((mmap_file_.size() % sizeof(float)) != 0) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "The size of $0 is not a multiple of the value precision", path));
+    }
+    return absl::OkStatus();
+  }
+
   buffer_.resize(max_num_values);
   return file_.Open(path);
 }
 
-absl::Span<const float> FloatColumnReader::Values() {
-  return absl::Span<const float>(buffer_.data(), num_values_);
-}
+absl::Span<const float> FloatColumnReader::Values() { return values_; }
 
 absl::Status FloatColumnReader::Next() {
+  if (use_mmap_) {
+    const size_t num_total_values = mmap_file_.size() / sizeof(float);
+    const size_t num_values =
+        std::min(static_cast<size_t>(max_num_values_),
+                 num_total_values - mmap_offset_values_);
+    values_ = absl::Span<const float>(
+        reinterpret_cast<const float*>(mmap_file_.data()) + mmap_offset_values_,
+        num_values);
+    mmap_offset_values_ += num_values;
+    return absl::OkStatus();
+  }
+
   ASSIGN_OR_RETURN(const auto read_bytes,
                    file_.ReadUpTo(reinterpret_cast<char*>(buffer_.data()),
                                   buffer_.size() * sizeof(float)));
-  num_values_ = read_bytes / sizeof(float);
+  values_ = absl::Span<const float>(buffer_.data(), read_bytes / sizeof(float));
   return absl::OkStatus();
 }
 
@@ -469,7 +517,12 @@ absl::Status FloatColumnReader::ReadAndAppend(absl::string_view path,
   return reader.Close();
 }
 
-absl::Status FloatColumnReader::Close() { return file_.Close(); }
+absl::Status FloatColumnReader::Close() {
+  if (use_mmap_) {
+    return mmap_file_.Close();
+  }
+  return file_.Close();
+}
 
 absl::Status ShardedFloatColumnReader::ReadAndAppend(
     absl::string_view base_path, int begin_shard_idx, int end_shard_idx,
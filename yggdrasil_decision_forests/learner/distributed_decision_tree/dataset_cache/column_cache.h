@@ -26,8 +26,10 @@
 #define YGGDRASIL_DECISION_FORESTS_LEARNER_DISTRIBUTED_DECISION_TREE_DATASET_CACHE_COLUMN_CACHE_H_
 
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
 #include "yggdrasil_decision_forests/utils/distribute/core.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
 
 namespace yggdrasil_decision_forests {
 namespace model {
@@ -110,6 +112,10 @@ class AbstractIntegerColumnIterator {
 // The precision of "Value" (template argument) does not have to be the same as
 // the precision of "Value" in the writer. However the value of the "max_value"
 // argument should be the same.
+//
+// If possible, the file is memory mapped and the values are returned without
+// copy (if the file and user precisions are the same). Otherwise, the file is
+// read with buffered stream reads.
 template <typename Value>
 class IntegerColumnReader : public AbstractIntegerColumnIterator<Value> {
  public:
@@ -142,13 +148,24 @@ class IntegerColumnReader : public AbstractIntegerColumnIterator<Value> {
   uint8_t file_num_bytes() const { return file_num_bytes_; }
 
  private:
-  // File stream.
+  // File stream. Only used if the file is not memory mapped.
   file::FileInputByteStream file_;
 
+  // Memory mapping of the file. Used instead of "file_" if available.
+  utils::MemoryMappedFile mmap_file_;
+  bool use_mmap_ = false;
+
+  // Read offset in the memory mapped file, in bytes.
+  size_t mmap_offset_bytes_ = 0;
+
+  // Maximum number of values returned in a single "Next" call.
+  int max_num_values_ = 0;
+
   // Number of bytes used to store one value in the file data.
   uint8_t file_num_bytes_ = 0;
 
-  // Buffer containing the last read values in the file format.
+  // Buffer containing the last read values in the file format. Only allocated
+  // if the file is not memory mapped.
   std::vector<char> file_buffer_;
 
   // Buffer containing the last read values in the user format (i.e. "Value"
@@ -159,6 +176,9 @@ class IntegerColumnReader : public AbstractIntegerColumnIterator<Value> {
   // True iif. the file and user formats are the same.
   bool same_user_and_file_precision_ = false;
 
+  // File data corresponding to the last read values.
+  absl::Span<const char> file_values_;
+
   // Last set of read values.
   absl::Span<const Value> values_;
 };
@@ -306,6 +326,9 @@ class AbstractFloatColumnIterator {
   virtual absl::Status Close() = 0;
 };
 
+// Reads a sequence of float values. If possible, the file is memory mapped
+// and the values are returned without copy. Otherwise, the file is read with
+// buffered stream reads.
 class FloatColumnReader : public AbstractFloatColumnIterator {
  public:
   ~FloatColumnReader() {}
@@ -319,13 +342,25 @@ class FloatColumnReader : public AbstractFloatColumnIterator {
                                     std::vector<float>* output);
 
  private:
+  // File stream. Only used if the file is not memory mapped.
   file::FileInputByteStream file_;
 
-  // Buffer containing the last read values.
+  // Memory mapping of the file. Used instead of "file_" if available.
+  utils::MemoryMappedFile mmap_file_;
+  bool use_mmap_ = false;
+
+  // Read offset in the memory mapped file, in values.
+  size_t mmap_offset_values_ = 0;
+
+  // Maximum number of values returned in a single "Next" call.
+  int max_num_values_ = 0;
+
+  // Buffer containing the last read values. Only allocated if the file is not
+  // memory mapped.
   std::vector<float> buffer_;
 
-  // Number of values read in the last "Next".
-  int num_values_ = 0;
+  // Last set of read values.
+  absl::Span<const float> values_;
 };
 
 // Reads a sequence of float values from a sharded set of files. Follows the
@@ -65,6 +65,15 @@ absl::Status ListShards(const absl::string_view typed_path,
   return utils::ExpandInputShards(non_typed_path, shards);
 }
 
+// Number of input dataset shards combined in each shard of the feature cache.
+//
+// See definition of kNumShardPerWorkers for a high level explanation.
+int NumInputShardsPerRequest(const int num_dataset_shards,
+                             const int num_workers) {
+  return std::max<int>(
+      1, num_dataset_shards / (num_workers * kNumShardPerWorkers));
+}
+
 // Returns "column_idxs" if "column_idxs" is set. Else, returns all the column
 // indices in the dataset.
 utils::StatusOr<std::vector<int>> GetColumnsOrAll(
@@ -259,6 +268,99 @@ absl::Status CreateDatasetCacheFromShardedFiles(
   return absl::OkStatus();
 }
 
+absl::Status AppendDatasetCacheFromShardedFiles(
+    const absl::string_view typed_path,
+    const dataset::proto::DataSpecification& data_spec,
+    const absl::string_view cache_directory,
+    const proto::CreateDatasetCacheConfig& config,
+    const distribute::proto::Config& distribute_config) {
+  const auto begin = absl::Now();
+  LOG(INFO) << "Append dataset " << typed_path << " to dataset cache "
+            << cache_directory;
+
+  // Load the meta-data of the existing cache.
+  ASSIGN_OR_RETURN(auto metadata, LoadCacheMetadata(cache_directory));
+  const int64_t previous_num_examples = metadata.num_examples();
+  const int previous_num_feature_shards =
+      metadata.num_shards_in_feature_cache();
+  const int previous_num_index_shards = metadata.num_shards_in_index_cache();
+
+  // The columns of the existing cache.
+  std::vector<int> columns;
+  for (int column_idx = 0; column_idx < metadata.columns_size();
+       column_idx++) {
+    if (metadata.columns(column_idx).available()) {
+      columns.push_back(column_idx);
+    }
+  }
+
+  // Remove the "done" marker while the cache is being modified.
+  const auto done_path = file::JoinPath(cache_directory, kFilenameDone);
+  ASSIGN_OR_RETURN(const bool already_done, file::FileExists(done_path));
+  if (already_done) {
+    RETURN_IF_ERROR(file::RecursivelyDelete(done_path, file::Defaults()));
+  } else {
+    LOG(WARNING) << "The dataset cache is not finalized. Resuming an "
+                    "interrupted append.";
+  }
+
+  // List the shards of the appended dataset.
+  std::vector<std::string> dataset_shards;
+  std::string dataset_type;
+  RETURN_IF_ERROR(ListShards(typed_path, &dataset_shards, &dataset_type));
+  LOG(INFO) << "Found " << dataset_shards.size() << " new shard(s)";
+
+  // Initialize the distribution manager.
+  proto::WorkerWelcome welcome;
+  ASSIGN_OR_RETURN(
+      auto distribute_manager,
+      distribute::CreateManager(
+          distribute_config,
+          /*worker_name=*/"CREATE_DATASET_CACHE_WORKER",
+          /*welcome_blob=*/welcome.SerializeAsString(),
+          // Each worker is expected to do up to QueryPerWorker tasks in
+          // parallel.
+          /*parallel_execution_per_worker=*/kNumParallelQueriesPerWorker));
+
+  // Rename the existing raw shards: the total number of shards, which grows
+  // with the append, is part of the file names.
+  const int shards_per_requests = NumInputShardsPerRequest(
+      dataset_shards.size(), distribute_manager->NumWorkers());
+  const int num_output_shards =
+      previous_num_feature_shards +
+      (dataset_shards.size() + shards_per_requests - 1) / shards_per_requests;
+  RETURN_IF_ERROR(internal::RenumberRawShards(cache_directory, columns,
+                                              previous_num_feature_shards,
+                                              num_output_shards));
+
+  // Separate the columns of the new shards.
+  RETURN_IF_ERROR(internal::SeparateDatasetColumns(
+      dataset_shards, dataset_type, data_spec, cache_directory, columns,
+      config, distribute_manager.get(), &metadata,
+      /*begin_output_shard_idx=*/previous_num_feature_shards));
+
+  // Sort the delta of the numerical columns and merge it with the existing
+  // indexes.
+  RETURN_IF_ERROR(internal::SortNumericalColumns(
+      data_spec, cache_directory, columns, config, distribute_manager.get(),
+      &metadata,
+      /*delta_begin_shard_idx=*/previous_num_feature_shards,
+      previous_num_examples, previous_num_index_shards));
+
+  // Export the cache header.
+  const auto metadata_path = file::JoinPath(cache_directory, kFilenameMetaData);
+  RETURN_IF_ERROR(
+      file::SetBinaryProto(metadata_path, metadata, file::Defaults()));
+
+  RETURN_IF_ERROR(distribute_manager->Done());
+  RETURN_IF_ERROR(file::SetContent(done_path, "done"));
+
+  LOG(INFO) << "Dataset cache meta-data:\n" << MetaDataReport(metadata);
+  LOG(INFO) << "Appended " << metadata.num_examples() - previous_num_examples
+            << " example(s) to the dataset cache in " << absl::Now() - begin;
+  return absl::OkStatus();
+}
+
 utils::StatusOr<proto::CacheMetadata> LoadCacheMetadata(
     const absl::string_view path) {
   proto::CacheMetadata meta_data;
@@ -373,10 +475,12 @@ absl::Status SeparateDatasetColumns(
     const absl::string_view cache_directory, const std::vector<int>& columns,
     const proto::CreateDatasetCacheConfig& config,
     distribute::AbstractManager* distribute_manager,
-    proto::CacheMetadata* cache_metadata) {
+    proto::CacheMetadata* cache_metadata, const int begin_output_shard_idx) {
   LOG(INFO) << "Start separating dataset by columns";
 
-  cache_metadata->set_num_examples(0);
+  if (begin_output_shard_idx == 0) {
+    cache_metadata->set_num_examples(0);
+  }
 
   // Common part of the requests.
   proto::WorkerRequest generic_request;
@@ -392,12 +496,10 @@ absl::Status SeparateDatasetColumns(
   // Each request will combine "shards_per_requests" input shards (from the
   // input dataset; all the column values are in the same file) into 1 output
   // shards (each column in a separate file).
-  //
-  // See definition of kNumShardPerWorkers for a high level explanation.
-  const int shards_per_requests = std::max<int>(
-      1, dataset_shards.size() /
-             (distribute_manager->NumWorkers() * kNumShardPerWorkers));
+  const int shards_per_requests = NumInputShardsPerRequest(
+      dataset_shards.size(), distribute_manager->NumWorkers());
   const int num_output_shards =
+      begin_output_shard_idx +
       (dataset_shards.size() + shards_per_requests - 1) / shards_per_requests;
   request.set_num_shards(num_output_shards);
 
@@ -411,8 +513,8 @@ absl::Status SeparateDatasetColumns(
 
   cache_metadata->set_num_shards_in_feature_cache(num_output_shards);
   int pending_requests = 0;
-  for (int output_shard_idx = 0; output_shard_idx < num_output_shards;
-       output_shard_idx++) {
+  for (int output_shard_idx = begin_output_shard_idx;
+       output_shard_idx < num_output_shards; output_shard_idx++) {
     // Check if the job was already executed.
     const auto metadata_path =
         ShardMetadataPath(cache_directory, output_shard_idx, num_output_shards);
@@ -431,9 +533,11 @@ absl::Status SeparateDatasetColumns(
     }
 
     // Create the job.
-    int begin_shard_idx = output_shard_idx * shards_per_requests;
-    int end_shard_idx = std::min(static_cast<int>(dataset_shards.size()),
-                                 (output_shard_idx + 1) * shards_per_requests);
+    int begin_shard_idx =
+        (output_shard_idx - begin_output_shard_idx) * shards_per_requests;
+    int end_shard_idx = std::min(
+        static_cast<int>(dataset_shards.size()),
+        (output_shard_idx - begin_output_shard_idx + 1) * shards_per_requests);
     request.set_shard_idx(output_shard_idx);
     request.set_dataset_path(absl::StrCat(
         dataset_type, ":",
@@ -475,6 +579,44 @@ absl::Status SeparateDatasetColumns(
   return absl::OkStatus();
 }
 
+absl::Status RenumberRawShards(const absl::string_view cache_directory,
+                               const std::vector<int>& columns,
+                               const int previous_num_shards,
+                               const int new_num_shards) {
+  if (new_num_shards == previous_num_shards) {
+    return absl::OkStatus();
+  }
+
+  const auto rename_if_exists =
+      [](const std::string& src, const std::string& dst) -> absl::Status {
+    ASSIGN_OR_RETURN(const bool src_exists, file::FileExists(src));
+    if (!src_exists) {
+      // Already renamed by a previously interrupted append.
+      ASSIGN_OR_RETURN(const bool dst_exists, file::FileExists(dst));
+      if (dst_exists) {
+        return absl::OkStatus();
+      }
+      return absl::NotFoundError(
+          absl::StrCat("Missing raw shard file ", src));
+    }
+    return file::Rename(src, dst, file::Defaults());
+  };
+
+  for (int shard_idx = 0; shard_idx < previous_num_shards; shard_idx++) {
+    RETURN_IF_ERROR(rename_if_exists(
+        ShardMetadataPath(cache_directory, shard_idx, previous_num_shards),
+        ShardMetadataPath(cache_directory, shard_idx, new_num_shards)));
+    for (const int column_idx : columns) {
+      RETURN_IF_ERROR(rename_if_exists(
+          RawColumnFilePath(cache_directory, column_idx, shard_idx,
+                            previous_num_shards),
+          RawColumnFilePath(cache_directory, column_idx, shard_idx,
+                            new_num_shards)));
+    }
+  }
+  return absl::OkStatus();
+}
+
 absl::Status ConvertPartialToFinalRawData(
     const dataset::proto::DataSpecification& data_spec,
     const proto::PartialDatasetMetadata& partial_metadata,
@@ -494,38 +636,58 @@ absl::Status ConvertPartialToFinalRawData(
   request.set_num_shards(partial_metadata.num_shards());
   request.set_delete_source_file(delete_source_file);
 
+  // Number of column batches per shard. The columns of a shard are grouped in
+  // batches to amortize the per-request overhead while keeping enough requests
+  // to occupy all the workers.
+  const int num_batches_per_shard = std::max<int>(
+      1, (distribute_manager->NumWorkers() * kNumParallelQueriesPerWorker +
+          partial_metadata.num_shards() - 1) /
+             partial_metadata.num_shards());
+  const int batch_size = std::max<int>(
+      1, (columns.size() + num_batches_per_shard - 1) / num_batches_per_shard);
+
   int pending_requests = 0;
   for (int shard_idx = 0; shard_idx < partial_metadata.num_shards();
        shard_idx++) {
     request.set_shard_idx(shard_idx);
-    for (int column_idx : columns) {
-      request.set_column_idx(column_idx);
-
-      const auto& column_spec = data_spec.columns(column_idx);
-      switch (column_spec.type()) {
-        case dataset::proto::NUMERICAL:
-          request.mutable_numerical()->set_nan_value_replacement(
-              cache_metadata->columns(column_idx)
-                  .numerical()
-                  .replacement_missing_value());
-          break;
-        case dataset::proto::CATEGORICAL:
-          if (column_spec.categorical().is_already_integerized()) {
-            request.mutable_categorical_int()->set_nan_value_replacement(
-                column_spec.categorical().most_frequent_value());
-            request.mutable_categorical_int()->set_max_value(
-                cache_metadata->columns(column_idx).categorical().num_values());
-          } else {
-            *request.mutable_categorical_string()->mutable_items() =
-                column_spec.categorical().items();
-            request.mutable_categorical_string()->set_nan_value_replacement(
-                column_spec.categorical().most_frequent_value());
-          }
-          break;
-        default:
-          return absl::InternalError(absl::Substitute(
-              "Conversion not implemented for column of type $0",
-              column_spec.type()));
+    for (int begin_column_idx = 0; begin_column_idx < columns.size();
+         begin_column_idx += batch_size) {
+      const auto end_column_idx = std::min(begin_column_idx + batch_size,
+                                           static_cast<int>(columns.size()));
+      request.clear_columns();
+      for (int idx = begin_column_idx; idx < end_column_idx; idx++) {
+        const int column_idx = columns[idx];
+        auto& column = *request.add_columns();
+        column.set_column_idx(column_idx);
+
+        const auto& column_spec = data_spec.columns(column_idx);
+        switch (column_spec.type()) {
+          case dataset::proto::NUMERICAL:
+            column.mutable_numerical()->set_nan_value_replacement(
+                cache_metadata->columns(column_idx)
+                    .numerical()
+                    .replacement_missing_value());
+            break;
+          case dataset::proto::CATEGORICAL:
+            if (column_spec.categorical().is_already_integerized()) {
+              column.mutable_categorical_int()->set_nan_value_replacement(
+                  column_spec.categorical().most_frequent_value());
+              column.mutable_categorical_int()->set_max_value(
+                  cache_metadata->columns(column_idx)
+                      .categorical()
+                      .num_values());
+            } else {
+              *column.mutable_categorical_string()->mutable_items() =
+                  column_spec.categorical().items();
+              column.mutable_categorical_string()->set_nan_value_replacement(
+                  column_spec.categorical().most_frequent_value());
+            }
+            break;
+          default:
+            return absl::InternalError(absl::Substitute(
+                "Conversion not implemented for column of type $0",
+                column_spec.type()));
+        }
       }
 
       RETURN_IF_ERROR(
@@ -536,7 +698,8 @@ absl::Status ConvertPartialToFinalRawData(
 
   // Receive and rename the results.
   for (int result_idx = 0; result_idx < pending_requests; result_idx++) {
-    LOG_INFO_EVERY_N_SEC(10, _ << "\tconverted columns " << (result_idx + 1)
+    LOG_INFO_EVERY_N_SEC(10, _ << "\tconverted column batches "
+                               << (result_idx + 1)
                                << "/" << pending_requests);
 
     ASSIGN_OR_RETURN(
@@ -552,9 +715,13 @@ absl::Status SortNumericalColumns(
     absl::string_view cache_directory, const std::vector<int>& columns,
     const proto::CreateDatasetCacheConfig& config,
     distribute::AbstractManager* distribute_manager,
-    proto::CacheMetadata* cache_metadata) {
+    proto::CacheMetadata* cache_metadata, const int delta_begin_shard_idx,
+    const int64_t previous_num_examples,
+    const int previous_num_shards_in_index_cache) {
   LOG(INFO) << "Start sorting numerical columns";
 
+  const bool append = delta_begin_shard_idx > 0;
+
   // Common part of the requests.
   proto::WorkerRequest generic_request;
   auto& request = *generic_request.mutable_sort_numerical_column();
@@ -562,6 +729,12 @@ absl::Status SortNumericalColumns(
       file::JoinPath(cache_directory, kFilenameTmp));
   request.set_num_examples(cache_metadata->num_examples());
   request.set_cache_directory(std::string(cache_directory));
+  if (append) {
+    request.set_delta_begin_shard_idx(delta_begin_shard_idx);
+    request.set_previous_num_examples(previous_num_examples);
+    request.set_previous_num_shards_in_output_shards(
+        previous_num_shards_in_index_cache);
+  }
 
   // We assume that a cache entry takes 4 bytes.
   request.set_num_example_per_output_shards(
@@ -593,12 +766,17 @@ absl::Status SortNumericalColumns(
       RETURN_IF_ERROR(
           file::GetBinaryProto(metadata_path, &metadata, file::Defaults()));
 
-      auto* column_metadata =
-          cache_metadata->mutable_columns(column_idx)->mutable_numerical();
-      column_metadata->MergeFrom(metadata.metadata());
-      LOG(INFO) << "The result of job for column #" << column_idx
-                << " is already there.";
-      continue;
+      // When appending to an existing cache, the existing index of a column
+      // is only final if it already accounts for all the examples.
+      if (!append ||
+          metadata.num_examples() == cache_metadata->num_examples()) {
+        auto* column_metadata =
+            cache_metadata->mutable_columns(column_idx)->mutable_numerical();
+        column_metadata->MergeFrom(metadata.metadata());
+        LOG(INFO) << "The result of job for column #" << column_idx
+                  << " is already there.";
+        continue;
+      }
     }
 
     // Create the job.
@@ -630,8 +808,16 @@ absl::Status SortNumericalColumns(
     ASSIGN_OR_RETURN(const bool already_exist,
                      file::FileExists(final_directory));
     if (already_exist) {
-      LOG(WARNING) << "The directory result of job on column #"
-                   << result.column_idx() << " already exist.";
+      if (append) {
+        // Replace the previous index of the column.
+        RETURN_IF_ERROR(
+            file::RecursivelyDelete(final_directory, file::Defaults()));
+        RETURN_IF_ERROR(file::Rename(result.output_directory(),
+                                     final_directory, file::Defaults()));
+      } else {
+        LOG(WARNING) << "The directory result of job on column #"
+                     << result.column_idx() << " already exist.";
+      }
     } else {
       RETURN_IF_ERROR(file::Rename(result.output_directory(), final_directory,
                                    file::Defaults()));
@@ -643,6 +829,7 @@ absl::Status SortNumericalColumns(
 
     proto::SortedColumnMetadata metadata;
     *metadata.mutable_metadata() = result.metadata();
+    metadata.set_num_examples(cache_metadata->num_examples());
     auto* column_metadata = cache_metadata->mutable_columns(result.column_idx())
                                 ->mutable_numerical();
     column_metadata->MergeFrom(result.metadata());
@@ -86,6 +86,28 @@ absl::Status CreateDatasetCacheFromShardedFiles(
     const proto::CreateDatasetCacheConfig& config,
     const distribute::proto::Config& distribute_config);
 
+// Appends the examples of a dataset to an existing (finalized) dataset cache.
+// The cost of the append is proportional to the amount of new data: the new
+// examples are separated into new raw shards appended after the existing
+// ones, and only the delta is sorted before being merged with the existing
+// pre-sorted indexes.
+//
+// "data_spec" should be the dataspec used to create the cache: the per-column
+// meta-data of the cache (missing value replacements, dictionaries,
+// discretization boundaries) is reused. In particular, previously
+// discretized numerical columns keep their boundaries: the new values are
+// discretized with the existing boundaries.
+//
+// The append is resumable if interrupted before the existing pre-sorted
+// indexes start being replaced (i.e. during the column separation).
+// Afterward, an interruption can leave the cache in an invalid state.
+absl::Status AppendDatasetCacheFromShardedFiles(
+    absl::string_view typed_path,
+    const dataset::proto::DataSpecification& data_spec,
+    absl::string_view cache_directory,
+    const proto::CreateDatasetCacheConfig& config,
+    const distribute::proto::Config& distribute_config);
+
 // Create a dataset cache from a partially created dataset cache.
 //
 // A partial dataset cache only contains raw per-column and per-shard
@@ -119,6 +141,10 @@ namespace internal {
 // Splits the dataset column by column and shards by shards.
 //
 // Set the following fields in the cache metadata: num_examples, num_shards.
+//
+// If "begin_output_shard_idx" > 0, the output shards are appended after the
+// "begin_output_shard_idx" existing shards (whose example count is already
+// accounted in the cache metadata).
 absl::Status SeparateDatasetColumns(
     const std::vector<std::string>& dataset_shards,
     const std::string& dataset_type,
@@ -126,7 +152,7 @@ absl::Status SeparateDatasetColumns(
     absl::string_view cache_directory, const std::vector<int>& columns,
     const proto::CreateDatasetCacheConfig& config,
     distribute::AbstractManager* distribute_manager,
-    proto::CacheMetadata* cache_metadata);
+    proto::CacheMetadata* cache_metadata, int begin_output_shard_idx = 0);
 
 // Converts the raw value in the partial dataset cache to the value in the final
 // dataset cache. This is a simple copy of the features values with some
@@ -143,12 +169,29 @@ absl::Status ConvertPartialToFinalRawData(
     proto::CacheMetadata* cache_metadata);
 
 // Sort the numerical columns.
+//
+// If "delta_begin_shard_idx" > 0, the cache is being appended to:
+// "previous_num_examples" examples are already indexed from the raw shards
+// [0, delta_begin_shard_idx) into "previous_num_shards_in_index_cache"
+// shards, and only the delta is sorted before being merged with the existing
+// indexes.
 absl::Status SortNumericalColumns(
     const dataset::proto::DataSpecification& data_spec,
     absl::string_view cache_directory, const std::vector<int>& columns,
     const proto::CreateDatasetCacheConfig& config,
     distribute::AbstractManager* distribute_manager,
-    proto::CacheMetadata* cache_metadata);
+    proto::CacheMetadata* cache_metadata, int delta_begin_shard_idx = 0,
+    int64_t previous_num_examples = 0,
+    int previous_num_shards_in_index_cache = 0);
+
+// Renames the raw shard files (and their per-shard meta-data) of an existing
+// cache to the names they take in a cache with
+// "new_num_shards" >= "previous_num_shards" shards (the number of shards is
+// part of the file names). Used when appending to an existing cache. The
+// operation is idempotent: already renamed files are skipped.
+absl::Status RenumberRawShards(absl::string_view cache_directory,
+                               const std::vector<int>& columns,
+                               int previous_num_shards, int new_num_shards);
 
 // Initializes the meta-data content from the dataspec, column and configs.
 // TODO: Make "InitializeMetadata" return a "CacheMetadata" directly.
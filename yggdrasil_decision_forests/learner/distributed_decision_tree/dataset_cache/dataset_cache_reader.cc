@@ -312,6 +312,153 @@ bool DatasetCacheReader::has_feature(const int feature) const {
   return (it != features_.end()) && (*it == feature);
 }
 
+void DatasetCacheReader::SetInMemoryCacheFeatureWeights(
+    const std::vector<double>& weights) {
+  if (!has_in_memory_cache_budget()) {
+    return;
+  }
+  utils::concurrency::MutexLock lock(&budget_mutex_);
+  const auto num_weights =
+      std::min(weights.size(), column_budget_states_.size());
+  for (size_t column_idx = 0; column_idx < num_weights; column_idx++) {
+    // Negative weights (e.g. the cost of the non-active features of the load
+    // balancer) are ignored.
+    if (weights[column_idx] >= 0) {
+      column_budget_states_[column_idx].weight = weights[column_idx];
+    }
+  }
+}
+
+void DatasetCacheReader::RecordColumnAccess(const int column_idx) const {
+  if (!has_in_memory_cache_budget()) {
+    return;
+  }
+  utils::concurrency::MutexLock lock(&budget_mutex_);
+  auto& state = column_budget_states_[column_idx];
+  state.num_accesses++;
+  state.last_access = ++access_clock_;
+}
+
+size_t DatasetCacheReader::EstimateColumnMemoryUsage(
+    const int column_idx) const {
+  const auto num_examples = meta_data_.num_examples();
+  const auto& column = meta_data().columns(column_idx);
+  switch (column.type_case()) {
+    case proto::CacheMetadata_Column::kCategorical:
+      return num_examples * NumBytes(column.categorical().num_values());
+
+    case proto::CacheMetadata_Column::kNumerical: {
+      // Raw values.
+      size_t usage = num_examples * sizeof(float);
+      if (column.numerical().discretized()) {
+        // Discretized values and boundaries.
+        usage += num_examples *
+                 NumBytes(column.numerical().num_discretized_values());
+        usage += column.numerical().num_discretized_values() * sizeof(float);
+      } else {
+        // Pre-sorted example indices and unique values.
+        usage += num_examples * NumBytes(MaxValueWithDeltaBit(num_examples));
+        usage += column.numerical().num_unique_values() * sizeof(float);
+      }
+      return usage;
+    }
+
+    case proto::CacheMetadata_Column::kBoolean:
+      return num_examples * NumBytes(2);
+
+    case proto::CacheMetadata_Column::TYPE_NOT_SET:
+      return 0;
+  }
+  return 0;
+}
+
+absl::Status DatasetCacheReader::UpdateInMemoryCacheBudget() {
+  if (!has_in_memory_cache_budget()) {
+    return absl::OkStatus();
+  }
+  if (IsNonBlockingLoadingInProgress()) {
+    return absl::InternalError(
+        "Non-blocking feature loading already in progress.");
+  }
+
+  // Select the features to keep resident: highest score first (most recently
+  // accessed first in case of equality), until the budget is filled.
+  std::vector<int> load_features;
+  std::vector<int> unload_features;
+  {
+    utils::concurrency::MutexLock lock(&budget_mutex_);
+    std::vector<int> candidates = features_;
+    std::sort(candidates.begin(), candidates.end(),
+              [&](const int a, const int b) {
+                const auto& state_a = column_budget_states_[a];
+                const auto& state_b = column_budget_states_[b];
+                const double score_a = state_a.weight * state_a.num_accesses;
+                const double score_b = state_b.weight * state_b.num_accesses;
+                if (score_a != score_b) {
+                  return score_a > score_b;
+                }
+                if (state_a.last_access != state_b.last_access) {
+                  return state_a.last_access > state_b.last_access;
+                }
+                return a < b;
+              });
+
+    size_t budget_usage = 0;
+    const size_t budget = options_.in_memory_cache_budget_bytes();
+    for (const int column_idx : candidates) {
+      const auto& state = column_budget_states_[column_idx];
+      if (budget_usage + state.memory_usage <= budget) {
+        budget_usage += state.memory_usage;
+        if (!state.resident) {
+          load_features.push_back(column_idx);
+        }
+      } else if (state.resident) {
+        unload_features.push_back(column_idx);
+      }
+    }
+  }
+
+  if (load_features.empty() && unload_features.empty()) {
+    return absl::OkStatus();
+  }
+
+  LOG(INFO) << "Update of the in-memory cache budget: loading "
+            << load_features.size() << " and unloading "
+            << unload_features.size() << " feature(s)";
+
+  for (const int column_idx : unload_features) {
+    RETURN_IF_ERROR(UnloadInMemoryCacheColumn(column_idx));
+  }
+
+  if (!load_features.empty()) {
+    absl::Status worker_status;
+    {
+      utils::concurrency::Mutex mutex_worker_status;
+      utils::concurrency::ThreadPool pool(
+          "LoadFeatures", std::min<int>(load_features.size(), 20));
+      pool.StartWorkers();
+
+      for (const int column_idx : load_features) {
+        pool.Schedule([&, column_idx]() {
+          {
+            utils::concurrency::MutexLock l(&mutex_worker_status);
+            if (!worker_status.ok()) {
+              return;
+            }
+          }
+          size_t column_memory_usage;
+          const auto status =
+              LoadInMemoryCacheColumn(column_idx, &column_memory_usage);
+          utils::concurrency::MutexLock l(&mutex_worker_status);
+          worker_status.Update(status);
+        });
+      }
+    }
+    RETURN_IF_ERROR(worker_status);
+  }
+  return absl::OkStatus();
+}
+
 absl::Status DatasetCacheReader::UnloadInMemoryCacheColumn(
     const int column_idx) {
   const auto& column = meta_data().columns(column_idx);
@@ -360,6 +507,11 @@ absl::Status DatasetCacheReader::UnloadInMemoryCacheColumn(
     case proto::CacheMetadata_Column::TYPE_NOT_SET:
       break;
   }
+
+  if (has_in_memory_cache_budget()) {
+    utils::concurrency::MutexLock lock(&budget_mutex_);
+    column_budget_states_[column_idx].resident = false;
+  }
   return absl::OkStatus();
 }
 
@@ -499,6 +651,13 @@ absl::Status DatasetCacheReader::LoadInMemoryCacheColumn(int column_idx,
     case proto::CacheMetadata_Column::TYPE_NOT_SET:
       break;
   }
+
+  if (has_in_memory_cache_budget()) {
+    utils::concurrency::MutexLock lock(&budget_mutex_);
+    auto& state = column_budget_states_[column_idx];
+    state.resident = true;
+    state.memory_usage = *memory_usage;
+  }
   return absl::OkStatus();
 }
 
@@ -517,6 +676,25 @@ absl::Status DatasetCacheReader::InitializeAndLoadInMemoryCache() {
       num_columns);
 
   const auto begin = absl::Now();
+
+  if (has_in_memory_cache_budget()) {
+    // The initial resident features are selected by
+    // "UpdateInMemoryCacheBudget". Before the first accesses, all the scores
+    // are equal: the features with the smallest column index are loaded
+    // first.
+    {
+      utils::concurrency::MutexLock lock(&budget_mutex_);
+      column_budget_states_.resize(num_columns);
+      for (const int column_idx : features_) {
+        column_budget_states_[column_idx].memory_usage =
+            EstimateColumnMemoryUsage(column_idx);
+      }
+    }
+    RETURN_IF_ERROR(UpdateInMemoryCacheBudget());
+    load_in_memory_duration_ = absl::Now() - begin;
+    return absl::OkStatus();
+  }
+
   std::atomic<size_t> memory_usage{0};
 
   absl::Status worker_status;
@@ -575,16 +753,20 @@ DatasetCacheReader::PresortedNumericalFeatureExampleIterator(
         absl::StrCat("Column ", column_idx, " is not numerical"));
   }
 
+  RecordColumnAccess(column_idx);
   if (options_.load_cache_in_memory()) {
-    if (in_memory_cache_.presorted_numerical_example_idx_columns_[column_idx] ==
+    if (in_memory_cache_.presorted_numerical_example_idx_columns_[column_idx] !=
         nullptr) {
+      return in_memory_cache_
+          .presorted_numerical_example_idx_columns_[column_idx]
+          ->CreateIterator();
+    }
+    if (!has_in_memory_cache_budget()) {
       return absl::InvalidArgumentError(
           absl::StrCat("Column ", column_idx, " is not available"));
     }
-
-    return in_memory_cache_
-        .presorted_numerical_example_idx_columns_[column_idx]
-        ->CreateIterator();
+    // The column is not resident in the budgeted in-memory cache: stream it
+    // from disk.
   }
 
   auto reader = absl::make_unique<ShardedIntegerColumnReader<ExampleIdxType>>();
@@ -607,16 +789,19 @@ DatasetCacheReader::PresortedNumericalFeatureValueIterator(
         absl::StrCat("Column ", column_idx, " is not numerical"));
   }
 
+  RecordColumnAccess(column_idx);
   if (options_.load_cache_in_memory()) {
     if (in_memory_cache_
-            .presorted_numerical_unique_values_columns_[column_idx] ==
+            .presorted_numerical_unique_values_columns_[column_idx] !=
         nullptr) {
+      return in_memory_cache_
+          .presorted_numerical_unique_values_columns_[column_idx]
+          ->CreateIterator();
+    }
+    if (!has_in_memory_cache_budget()) {
       return absl::InvalidArgumentError(
           absl::StrCat("Column ", column_idx, " is not available"));
     }
-    return in_memory_cache_
-        .presorted_numerical_unique_values_columns_[column_idx]
-        ->CreateIterator();
   }
 
   auto reader = absl::make_unique<ShardedFloatColumnReader>();
@@ -637,13 +822,16 @@ DatasetCacheReader::InOrderNumericalFeatureValueIterator(int column_idx) const {
         absl::StrCat("Column ", column_idx, " is not numerical"));
   }
 
+  RecordColumnAccess(column_idx);
   if (options_.load_cache_in_memory()) {
-    if (in_memory_cache_.inorder_numerical_columns_[column_idx] == nullptr) {
+    if (in_memory_cache_.inorder_numerical_columns_[column_idx] != nullptr) {
+      return in_memory_cache_.inorder_numerical_columns_[column_idx]
+          ->CreateIterator();
+    }
+    if (!has_in_memory_cache_budget()) {
       return absl::InvalidArgumentError(
           absl::StrCat("Column ", column_idx, " is not available"));
     }
-    return in_memory_cache_.inorder_numerical_columns_[column_idx]
-        ->CreateIterator();
   }
 
   auto reader = absl::make_unique<ShardedFloatColumnReader>();
@@ -665,14 +853,16 @@ DatasetCacheReader::InOrderCategoricalFeatureValueIterator(
         absl::StrCat("Column ", column_idx, " is not categorical"));
   }
 
+  RecordColumnAccess(column_idx);
   if (options_.load_cache_in_memory()) {
-    if (in_memory_cache_.inorder_categorical_columns_[column_idx] == nullptr) {
+    if (in_memory_cache_.inorder_categorical_columns_[column_idx] != nullptr) {
+      return in_memory_cache_.inorder_categorical_columns_[column_idx]
+          ->CreateIterator();
+    }
+    if (!has_in_memory_cache_budget()) {
       return absl::InvalidArgumentError(
           absl::StrCat("Column ", column_idx, " is not available"));
     }
-
-    return in_memory_cache_.inorder_categorical_columns_[column_idx]
-        ->CreateIterator();
   }
 
   auto reader =
@@ -695,14 +885,16 @@ DatasetCacheReader::InOrderBooleanFeatureValueIterator(int column_idx) const {
         absl::StrCat("Column ", column_idx, " is not boolean"));
   }
 
+  RecordColumnAccess(column_idx);
   if (options_.load_cache_in_memory()) {
-    if (in_memory_cache_.inorder_boolean_columns_[column_idx] == nullptr) {
+    if (in_memory_cache_.inorder_boolean_columns_[column_idx] != nullptr) {
+      return in_memory_cache_.inorder_boolean_columns_[column_idx]
+          ->CreateIterator();
+    }
+    if (!has_in_memory_cache_budget()) {
       return absl::InvalidArgumentError(
           absl::StrCat("Column ", column_idx, " is not available"));
     }
-
-    return in_memory_cache_.inorder_boolean_columns_[column_idx]
-        ->CreateIterator();
   }
 
   auto reader = absl::make_unique<ShardedIntegerColumnReader<BooleanType>>();
@@ -731,15 +923,17 @@ DatasetCacheReader::InOrderDiscretizedNumericalFeatureValueIterator(
         absl::StrCat("Column ", column_idx, " is not discretized"));
   }
 
+  RecordColumnAccess(column_idx);
   if (options_.load_cache_in_memory()) {
-    if (in_memory_cache_.inorder_discretized_numerical_columns_[column_idx] ==
+    if (in_memory_cache_.inorder_discretized_numerical_columns_[column_idx] !=
         nullptr) {
+      return in_memory_cache_.inorder_discretized_numerical_columns_[column_idx]
+          ->CreateIterator();
+    }
+    if (!has_in_memory_cache_budget()) {
       return absl::InvalidArgumentError(
           absl::StrCat("Column ", column_idx, " is not available"));
     }
-
-    return in_memory_cache_.inorder_discretized_numerical_columns_[column_idx]
-        ->CreateIterator();
   }
 
   auto reader = absl::make_unique<
@@ -771,6 +965,7 @@ DatasetCacheReader::InOrderDiscretizedNumericalFeatureValueIterator(
         absl::StrCat("Column ", column_idx, " is not discretized"));
   }
 
+  RecordColumnAccess(column_idx);
   if (options_.load_cache_in_memory()) {
     if (in_memory_cache_.inorder_discretized_numerical_columns_[column_idx] ==
         nullptr) {
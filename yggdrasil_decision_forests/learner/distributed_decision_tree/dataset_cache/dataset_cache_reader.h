@@ -180,6 +180,28 @@ class DatasetCacheReader {
   const std::vector<int>& NonBlockingLoadingInProgressLoadedFeatures() const;
   const std::vector<int>& NonBlockingLoadingInProgressUnloadedFeatures() const;
 
+  // Sets the access weight of each feature (indexed by column index) of the
+  // budgeted in-memory cache (see "in_memory_cache_budget_bytes"). The weight
+  // of a feature multiplies its access count when selecting the features to
+  // keep resident in memory e.g. the per-feature work estimates of the
+  // "LoadBalancer" ("FeatureCostScores()") make the repeatedly-split-on and
+  // expensive-to-stream features stay resident. All the weights default to 1.
+  // Ignored if "in_memory_cache_budget_bytes" is not set.
+  void SetInMemoryCacheFeatureWeights(const std::vector<double>& weights);
+
+  // Re-selects the features kept resident in memory according to the memory
+  // budget ("in_memory_cache_budget_bytes"), the access counts since the
+  // creation of the reader and the feature weights
+  // ("SetInMemoryCacheFeatureWeights"). The features with the highest score
+  // (weight x number of accesses; most recently accessed first in case of
+  // tie) are loaded in memory until the budget is filled. The other features
+  // are unloaded and streamed from disk on access.
+  //
+  // Like "LoadingAndUnloadingFeatures", this method should not be called
+  // while column iterators are in use. No-op if
+  // "in_memory_cache_budget_bytes" is not set.
+  absl::Status UpdateInMemoryCacheBudget();
+
   // Duration of the initial loading of features in memory i.e. duration of
   // "InitializeAndLoadInMemoryCache".
   absl::Duration load_in_memory_duration() const {
@@ -208,6 +230,21 @@ class DatasetCacheReader {
       const std::vector<int>& load_features,
       const std::vector<int>& unload_features);
 
+  // Is the in-memory cache limited by a memory budget?
+  bool has_in_memory_cache_budget() const {
+    return options_.load_cache_in_memory() &&
+           options_.in_memory_cache_budget_bytes() >= 0;
+  }
+
+  // Records the access to a column by one of the iterator accessors. No-op if
+  // there is no memory budget.
+  void RecordColumnAccess(int column_idx) const;
+
+  // Estimation of the memory usage of a column once loaded in memory. Only
+  // used until the column is loaded for the first time (the measured usage is
+  // used afterward).
+  size_t EstimateColumnMemoryUsage(int column_idx) const;
+
   std::string path_;
   proto::CacheMetadata meta_data_;
   proto::DatasetCacheReaderOptions options_;
@@ -245,6 +282,34 @@ class DatasetCacheReader {
   };
   NonBlocking non_blocking_;
 
+  // Per-column state of the budgeted in-memory cache. Empty if
+  // "in_memory_cache_budget_bytes" is not set. The state is updated by the
+  // (const) iterator accessors, hence the "mutable".
+  struct ColumnBudgetState {
+    // Access weight e.g. the work estimate of the load balancer.
+    double weight = 1.0;
+
+    // Number of iterators created on the column.
+    uint64_t num_accesses = 0;
+
+    // Value of "access_clock_" at the last access.
+    uint64_t last_access = 0;
+
+    // Memory usage of the column. Estimated until the column is loaded for
+    // the first time.
+    size_t memory_usage = 0;
+
+    // Is the column currently loaded in memory?
+    bool resident = false;
+  };
+  mutable std::vector<ColumnBudgetState> column_budget_states_;
+
+  // Number of column accesses so far. Used to time-stamp the accesses.
+  mutable uint64_t access_clock_ = 0;
+
+  // Protects "column_budget_states_" and "access_clock_".
+  mutable utils::concurrency::Mutex budget_mutex_;
+
   struct {
     // Sorted numerical.
     std::vector<std::unique_ptr<InMemoryFloatColumnReaderFactory>>
@@ -152,6 +152,47 @@ TEST_F(End2End, Base) {
   LOG(INFO) << reader->MetadataInformation();
 }
 
+TEST_F(End2End, InMemoryCacheBudget) {
+  proto::DatasetCacheReaderOptions options;
+  // Budget for approximately one non-discretized numerical column: the other
+  // columns are streamed from disk.
+  options.set_in_memory_cache_budget_bytes(200000);
+  auto reader = DatasetCacheReader::Create(cache_path_, options).value();
+
+  const auto read_numerical = [&](const int column_idx) {
+    std::vector<float> values;
+    auto col_reader =
+        reader->InOrderNumericalFeatureValueIterator(column_idx).value();
+    while (true) {
+      CHECK_OK(col_reader->Next());
+      const auto batch = col_reader->Values();
+      if (batch.empty()) {
+        break;
+      }
+      values.insert(values.end(), batch.begin(), batch.end());
+    }
+    return values;
+  };
+
+  // Both resident and streamed columns can be read.
+  const auto initial_values_0 = read_numerical(0);
+  const auto initial_values_4 = read_numerical(4);
+  EXPECT_EQ(initial_values_0.size(), reader->num_examples());
+  EXPECT_EQ(initial_values_4.size(), reader->num_examples());
+
+  // Make the column 4 the most valuable column and update the resident set.
+  read_numerical(4);
+  read_numerical(4);
+  std::vector<double> weights(reader->meta_data().columns_size(), 1.0);
+  weights[4] = 10.0;
+  reader->SetInMemoryCacheFeatureWeights(weights);
+  CHECK_OK(reader->UpdateInMemoryCacheBudget());
+
+  // The values do not depend on the columns being resident or streamed.
+  EXPECT_EQ(read_numerical(0), initial_values_0);
+  EXPECT_EQ(read_numerical(4), initial_values_4);
+}
+
 }  // namespace
 }  // namespace dataset_cache
 }  // namespace distributed_decision_tree
@@ -15,6 +15,8 @@
 
 #include "yggdrasil_decision_forests/learner/distributed_decision_tree/dataset_cache/dataset_cache.h"
 
+#include <numeric>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_map.h"
@@ -305,6 +307,144 @@ TEST_F(End2End, NumericalInOrderDiscretized) {
   EXPECT_EQ(num_examples, 22792);
 }
 
+// Appending examples to an existing cache is equivalent to creating the cache
+// from the full dataset.
+TEST(DatasetCache, AppendToExistingCache) {
+  // Prepare the dataspec on the full dataset.
+  const auto dataset_path = absl::StrCat(
+      "csv:", file::JoinPath(test::DataRootDirectory(),
+                             "yggdrasil_decision_forests/test_data/"
+                             "dataset/adult_train.csv"));
+  dataset::proto::DataSpecification data_spec;
+  dataset::CreateDataSpec(dataset_path, false, {}, &data_spec);
+
+  dataset::VerticalDataset dataset;
+  CHECK_OK(LoadVerticalDataset(dataset_path, data_spec, &dataset));
+
+  // Split the dataset into a base and a delta part.
+  const dataset::VerticalDataset::row_t num_base_examples = 20000;
+  std::vector<dataset::VerticalDataset::row_t> base_idxs(num_base_examples);
+  std::iota(base_idxs.begin(), base_idxs.end(), 0);
+  std::vector<dataset::VerticalDataset::row_t> delta_idxs(dataset.nrow() -
+                                                          num_base_examples);
+  std::iota(delta_idxs.begin(), delta_idxs.end(), num_base_examples);
+  const auto base_dataset = dataset.Extract(base_idxs).value();
+  const auto delta_dataset = dataset.Extract(delta_idxs).value();
+
+  const auto full_path = absl::StrCat(
+      "csv:", file::JoinPath(test::TmpDirectory(), "append_full.csv@20"));
+  const auto base_path = absl::StrCat(
+      "csv:", file::JoinPath(test::TmpDirectory(), "append_base.csv@10"));
+  const auto delta_path = absl::StrCat(
+      "csv:", file::JoinPath(test::TmpDirectory(), "append_delta.csv@2"));
+  CHECK_OK(SaveVerticalDataset(dataset, full_path,
+                               /*num_records_by_shard=*/dataset.nrow() / 20));
+  CHECK_OK(SaveVerticalDataset(base_dataset, base_path,
+                               /*num_records_by_shard=*/
+                               base_dataset.nrow() / 10));
+  CHECK_OK(SaveVerticalDataset(delta_dataset, delta_path,
+                               /*num_records_by_shard=*/
+                               delta_dataset.nrow() / 2));
+
+  distribute::proto::Config distribute_config;
+  distribute_config.set_implementation_key("MULTI_THREAD");
+
+  proto::CreateDatasetCacheConfig config;
+  // The "age" column will not be discretized (72 unique values), while the
+  // "education_num" will be (15 unique values).
+  config.set_max_unique_values_for_discretized_numerical(32);
+  int32_t label_column_idx;
+  CHECK_OK(dataset::GetSingleColumnIdxFromName("income", data_spec,
+                                               &label_column_idx));
+  config.set_label_column_idx(label_column_idx);
+
+  // Reference: cache created from the full dataset.
+  const auto full_cache_path =
+      file::JoinPath(test::TmpDirectory(), "cache_append_full");
+  EXPECT_OK(CreateDatasetCacheFromShardedFiles(
+      full_path, data_spec, {}, full_cache_path, config, distribute_config));
+
+  // Cache created from the base dataset, then extended with the delta.
+  const auto incremental_cache_path =
+      file::JoinPath(test::TmpDirectory(), "cache_append_incremental");
+  EXPECT_OK(CreateDatasetCacheFromShardedFiles(base_path, data_spec, {},
+                                               incremental_cache_path, config,
+                                               distribute_config));
+  EXPECT_OK(AppendDatasetCacheFromShardedFiles(
+      delta_path, data_spec, incremental_cache_path, config,
+      distribute_config));
+
+  const auto full_metadata = LoadCacheMetadata(full_cache_path).value();
+  const auto incremental_metadata =
+      LoadCacheMetadata(incremental_cache_path).value();
+
+  EXPECT_EQ(full_metadata.num_examples(), incremental_metadata.num_examples());
+  EXPECT_EQ(full_metadata.num_shards_in_index_cache(),
+            incremental_metadata.num_shards_in_index_cache());
+  // The pre-sorted "age" column is re-built exactly. The pre-discretized
+  // "education_num" column reuses the boundaries of the base cache; all its
+  // values are present in the base dataset, so the boundaries (and the
+  // meta-data) are the same as with a creation from scratch.
+  EXPECT_THAT(incremental_metadata.columns(0),
+              EqualsProto(full_metadata.columns(0)));
+  EXPECT_THAT(incremental_metadata.columns(4),
+              EqualsProto(full_metadata.columns(4)));
+
+  // Raw values of the "age" column.
+  const auto read_raw_column = [](const absl::string_view cache_path,
+                                  const proto::CacheMetadata& metadata) {
+    std::vector<float> values;
+    CHECK_OK(ShardedFloatColumnReader::ReadAndAppend(
+        file::JoinPath(cache_path, kFilenameRaw,
+                       absl::StrCat(kFilenameColumn, 0),
+                       kFilenameShardNoUnderscore),
+        /*begin_shard_idx=*/0,
+        /*end_shard_idx=*/metadata.num_shards_in_feature_cache(), &values));
+    return values;
+  };
+  EXPECT_EQ(read_raw_column(full_cache_path, full_metadata),
+            read_raw_column(incremental_cache_path, incremental_metadata));
+
+  // Pre-sorted index of the "age" column. Both caches contain the same number
+  // of examples: the example indices with delta bit are directly comparable.
+  const auto read_sorted_column = [](const absl::string_view cache_path,
+                                     const proto::CacheMetadata& metadata) {
+    std::vector<int64_t> example_idxs;
+    CHECK_OK(ShardedIntegerColumnReader<int64_t>::ReadAndAppend(
+        file::JoinPath(cache_path, kFilenameIndexed,
+                       absl::StrCat(kFilenameColumn, 0),
+                       kFilenameExampleIdxNoUnderscore),
+        /*max_value=*/MaxValueWithDeltaBit(metadata.num_examples()),
+        /*begin_shard_idx=*/0,
+        /*end_shard_idx=*/metadata.num_shards_in_index_cache(),
+        &example_idxs));
+    return example_idxs;
+  };
+  EXPECT_EQ(read_sorted_column(full_cache_path, full_metadata),
+            read_sorted_column(incremental_cache_path, incremental_metadata));
+
+  // Discretized values of the "education_num" column.
+  const auto read_discretized_column =
+      [](const absl::string_view cache_path,
+         const proto::CacheMetadata& metadata) {
+        std::vector<int32_t> values;
+        CHECK_OK(ShardedIntegerColumnReader<int32_t>::ReadAndAppend(
+            file::JoinPath(cache_path, kFilenameIndexed,
+                           absl::StrCat(kFilenameColumn, 4),
+                           kFilenameDiscretizedValuesNoUnderscore),
+            /*max_value=*/
+            metadata.columns(4).numerical().num_discretized_values(),
+            /*begin_shard_idx=*/0,
+            /*end_shard_idx=*/
+            metadata.columns(4).numerical().num_discretized_shards(),
+            &values));
+        return values;
+      };
+  EXPECT_EQ(
+      read_discretized_column(full_cache_path, full_metadata),
+      read_discretized_column(incremental_cache_path, incremental_metadata));
+}
+
 class TestCreateDatasetCacheFromPartialDatasetCache : public ::testing::Test {
  public:
   void SetUp() override {
@@ -24,6 +24,7 @@
 #include "yggdrasil_decision_forests/learner/types.h"
 #include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/instrument.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 #include "yggdrasil_decision_forests/utils/uid.h"
@@ -198,6 +199,7 @@ absl::Status CreateDatasetCacheWorker::SeparateDatasetColumn(
 absl::Status CreateDatasetCacheWorker::SeparateDatasetColumns(
     const proto::WorkerRequest::SeparateDatasetColumns& request,
     proto::WorkerResult::SeparateDatasetColumns* result) {
+  YDF_INSTRUMENT_MEMORY_PHASE("dataset_cache_worker.separate_columns");
   LOG(INFO) << "Separate dataset columns on " << request.dataset_path();
   result->set_shard_idx(request.shard_idx());
 
@@ -266,6 +268,11 @@ absl::Status CreateDatasetCacheWorker::SeparateDatasetColumns(
 absl::Status CreateDatasetCacheWorker::SortNumericalColumn(
     const proto::WorkerRequest::SortNumericalColumn& request,
     proto::WorkerResult::SortNumericalColumn* result) {
+  if (request.delta_begin_shard_idx() > 0) {
+    return AppendSortedNumericalColumn(request, result);
+  }
+
+  YDF_INSTRUMENT_MEMORY_PHASE("dataset_cache_worker.sort_numerical_column");
   LOG(INFO) << "Sorting numerical column #" << request.column_idx();
 
   // Read the values.
@@ -301,6 +308,279 @@ absl::Status CreateDatasetCacheWorker::SortNumericalColumn(
   LOG(INFO) << "Sort the numerical values of column #" << request.column_idx();
   std::sort(value_and_example_idxs.begin(), value_and_example_idxs.end());
 
+  return ExportNumericalColumnIndex(request, value_and_example_idxs, result);
+}
+
+absl::Status CreateDatasetCacheWorker::AppendSortedNumericalColumn(
+    const proto::WorkerRequest::SortNumericalColumn& request,
+    proto::WorkerResult::SortNumericalColumn* result) {
+  LOG(INFO) << "Appending "
+            << request.num_examples() - request.previous_num_examples()
+            << " examples to the index of numerical column #"
+            << request.column_idx();
+
+  const auto previous_column_directory =
+      file::JoinPath(request.cache_directory(), kFilenameIndexed,
+                     absl::StrCat(kFilenameColumn, request.column_idx()));
+
+  proto::SortedColumnMetadata previous_metadata;
+  RETURN_IF_ERROR(file::GetBinaryProto(
+      file::JoinPath(previous_column_directory, kFilenamePresortedMetaData),
+      &previous_metadata, file::Defaults()));
+
+  if (previous_metadata.metadata().discretized()) {
+    // The existing boundaries are reused: only the new examples are
+    // discretized.
+    return AppendDiscretizedNumericalColumn(
+        request, previous_metadata.metadata(), result);
+  }
+
+  std::vector<std::pair<float, model::SignedExampleIdx>> value_and_example_idxs;
+  value_and_example_idxs.reserve(request.num_examples());
+
+  // Decode the existing pre-sorted values i.e. rebuild the
+  // (value, example_idx) pairs, sorted by value, from the existing delta
+  // values and example indices with delta bit.
+  std::vector<float> previous_delta_values;
+  RETURN_IF_ERROR(ShardedFloatColumnReader::ReadAndAppend(
+      file::JoinPath(previous_column_directory,
+                     kFilenameDeltaValueNoUnderscore),
+      /*begin_shard_idx=*/0, /*end_shard_idx=*/1, &previous_delta_values));
+
+  const auto previous_delta_bit_mask =
+      MaskDeltaBit(request.previous_num_examples());
+  const auto previous_example_idx_mask =
+      MaskExampleIdx(request.previous_num_examples());
+
+  ShardedIntegerColumnReader<int64_t> previous_example_idx_reader;
+  RETURN_IF_ERROR(previous_example_idx_reader.Open(
+      file::JoinPath(previous_column_directory,
+                     kFilenameExampleIdxNoUnderscore),
+      /*max_value=*/MaxValueWithDeltaBit(request.previous_num_examples()),
+      /*max_num_values=*/kIOBufferSizeInBytes / sizeof(int64_t),
+      /*begin_shard_idx=*/0,
+      /*end_shard_idx=*/request.previous_num_shards_in_output_shards()));
+
+  size_t delta_value_idx = 0;
+  while (true) {
+    RETURN_IF_ERROR(previous_example_idx_reader.Next());
+    const auto example_idxs = previous_example_idx_reader.Values();
+    if (example_idxs.empty()) {
+      break;
+    }
+    for (const int64_t example_idx_with_delta_bit : example_idxs) {
+      if (value_and_example_idxs.size() > 0 &&
+          (example_idx_with_delta_bit & previous_delta_bit_mask)) {
+        delta_value_idx++;
+        if (delta_value_idx >= previous_delta_values.size()) {
+          return absl::InternalError(absl::Substitute(
+              "Non matching delta values and example indices for the "
+              "pre-sorted numerical column #$0",
+              request.column_idx()));
+        }
+      }
+      value_and_example_idxs.push_back(
+          {previous_delta_values[delta_value_idx],
+           static_cast<model::SignedExampleIdx>(example_idx_with_delta_bit &
+                                                previous_example_idx_mask)});
+    }
+  }
+  RETURN_IF_ERROR(previous_example_idx_reader.Close());
+  const size_t num_previous_examples = value_and_example_idxs.size();
+  if (num_previous_examples !=
+      static_cast<size_t>(request.previous_num_examples())) {
+    return absl::InternalError(absl::Substitute(
+        "Unexpected number of indexed examples in numerical column #$0. "
+        "$1 != $2",
+        request.column_idx(), num_previous_examples,
+        request.previous_num_examples()));
+  }
+
+  // Read and sort the delta.
+  const int input_buffer_size = kIOBufferSizeInBytes / sizeof(float);
+  ShardedFloatColumnReader delta_reader;
+  RETURN_IF_ERROR(delta_reader.Open(
+      file::JoinPath(request.cache_directory(), kFilenameRaw,
+                     absl::StrCat(kFilenameColumn, request.column_idx()),
+                     kFilenameShardNoUnderscore),
+      /*max_num_values=*/input_buffer_size,
+      /*begin_shard_idx=*/request.delta_begin_shard_idx(),
+      /*end_shard_idx=*/request.num_shards()));
+  model::SignedExampleIdx example_idx = request.previous_num_examples();
+  while (true) {
+    RETURN_IF_ERROR(delta_reader.Next());
+    const auto values = delta_reader.Values();
+    if (values.empty()) {
+      break;
+    }
+    for (const float value : values) {
+      value_and_example_idxs.push_back({value, example_idx});
+      example_idx++;
+    }
+  }
+  RETURN_IF_ERROR(delta_reader.Close());
+  if (example_idx != request.num_examples()) {
+    return absl::InternalError(absl::Substitute(
+        "Unexpected number of examples in the delta of numerical column #$0. "
+        "$1 != $2",
+        request.column_idx(), example_idx, request.num_examples()));
+  }
+
+  std::sort(value_and_example_idxs.begin() + num_previous_examples,
+            value_and_example_idxs.end());
+
+  // Merge the delta with the existing index. The merge is stable and all the
+  // existing example indices are smaller than the delta example indices: the
+  // result is identical to sorting the whole column from scratch.
+  std::inplace_merge(value_and_example_idxs.begin(),
+                     value_and_example_idxs.begin() + num_previous_examples,
+                     value_and_example_idxs.end());
+
+  return ExportNumericalColumnIndex(request, value_and_example_idxs, result);
+}
+
+absl::Status CreateDatasetCacheWorker::AppendDiscretizedNumericalColumn(
+    const proto::WorkerRequest::SortNumericalColumn& request,
+    const proto::CacheMetadata::NumericalColumn& previous_metadata,
+    proto::WorkerResult::SortNumericalColumn* result) {
+  const auto previous_column_directory =
+      file::JoinPath(request.cache_directory(), kFilenameIndexed,
+                     absl::StrCat(kFilenameColumn, request.column_idx()));
+
+  result->set_output_directory(
+      file::JoinPath(request.output_base_directory(), utils::GenUniqueId()));
+  RETURN_IF_ERROR(
+      file::RecursivelyCreateDir(result->output_directory(), file::Defaults()));
+  result->set_column_idx(request.column_idx());
+
+  // The meta-data of the column (boundaries, replacement value and number of
+  // unique values) is reused from the existing cache.
+  *result->mutable_metadata() = previous_metadata;
+
+  // Copy the boundary values.
+  std::vector<float> boundaries;
+  RETURN_IF_ERROR(ShardedFloatColumnReader::ReadAndAppend(
+      file::JoinPath(previous_column_directory,
+                     kFilenameBoundaryValueNoUnderscore),
+      /*begin_shard_idx=*/0, /*end_shard_idx=*/1, &boundaries));
+
+  FloatColumnWriter boundary_writer;
+  RETURN_IF_ERROR(boundary_writer.Open(
+      file::JoinPath(result->output_directory(),
+                     ShardFilename(kFilenameBoundaryValueNoUnderscore, 0, 1))));
+  RETURN_IF_ERROR(boundary_writer.WriteValues(boundaries));
+  RETURN_IF_ERROR(boundary_writer.Close());
+
+  const auto num_discretized_values = boundaries.size() + 1;
+
+  IntegerColumnWriter indexed_values_writer;
+  bool indexed_values_writer_is_open = false;
+  int64_t remaining_examples_in_shard = 0;
+  int next_output_shard_idx = 0;
+  std::vector<DiscretizedIndexedNumericalType> indexed_value_buffer;
+
+  const auto write_indexed_value =
+      [&](const DiscretizedIndexedNumericalType value) -> absl::Status {
+    if (remaining_examples_in_shard == 0) {
+      if (indexed_values_writer_is_open) {
+        // Close the current shard.
+        RETURN_IF_ERROR(indexed_values_writer.Close());
+      }
+      // Open a new shard.
+      RETURN_IF_ERROR(indexed_values_writer.Open(
+          file::JoinPath(result->output_directory(),
+                         ShardFilename(kFilenameDiscretizedValuesNoUnderscore,
+                                       next_output_shard_idx++,
+                                       request.num_shards_in_output_shards())),
+          /*max_value=*/num_discretized_values));
+      indexed_values_writer_is_open = true;
+      remaining_examples_in_shard = request.num_example_per_output_shards();
+    }
+
+    indexed_value_buffer.push_back(value);
+    if (indexed_value_buffer.size() >=
+        kIOBufferSizeInBytes / sizeof(model::SignedExampleIdx)) {
+      RETURN_IF_ERROR(
+          indexed_values_writer.WriteValues<DiscretizedIndexedNumericalType>(
+              indexed_value_buffer));
+      indexed_value_buffer.clear();
+    }
+
+    remaining_examples_in_shard--;
+    return absl::OkStatus();
+  };
+
+  // Copy the existing discretized values into the new shard layout.
+  ShardedIntegerColumnReader<DiscretizedIndexedNumericalType>
+      previous_values_reader;
+  RETURN_IF_ERROR(previous_values_reader.Open(
+      file::JoinPath(previous_column_directory,
+                     kFilenameDiscretizedValuesNoUnderscore),
+      /*max_value=*/num_discretized_values,
+      /*max_num_values=*/
+      kIOBufferSizeInBytes / sizeof(DiscretizedIndexedNumericalType),
+      /*begin_shard_idx=*/0,
+      /*end_shard_idx=*/previous_metadata.num_discretized_shards()));
+  while (true) {
+    RETURN_IF_ERROR(previous_values_reader.Next());
+    const auto values = previous_values_reader.Values();
+    if (values.empty()) {
+      break;
+    }
+    for (const auto value : values) {
+      RETURN_IF_ERROR(write_indexed_value(value));
+    }
+  }
+  RETURN_IF_ERROR(previous_values_reader.Close());
+
+  // Discretize the delta with the existing boundaries.
+  ShardedFloatColumnReader delta_reader;
+  RETURN_IF_ERROR(delta_reader.Open(
+      file::JoinPath(request.cache_directory(), kFilenameRaw,
+                     absl::StrCat(kFilenameColumn, request.column_idx()),
+                     kFilenameShardNoUnderscore),
+      /*max_num_values=*/kIOBufferSizeInBytes / sizeof(float),
+      /*begin_shard_idx=*/request.delta_begin_shard_idx(),
+      /*end_shard_idx=*/request.num_shards()));
+  while (true) {
+    RETURN_IF_ERROR(delta_reader.Next());
+    const auto values = delta_reader.Values();
+    if (values.empty()) {
+      break;
+    }
+    for (const float value : values) {
+      RETURN_IF_ERROR(write_indexed_value(
+          NumericalToDiscretizedNumerical(boundaries, value)));
+    }
+  }
+  RETURN_IF_ERROR(delta_reader.Close());
+
+  if (indexed_values_writer_is_open) {
+    RETURN_IF_ERROR(
+        indexed_values_writer.WriteValues<DiscretizedIndexedNumericalType>(
+            indexed_value_buffer));
+    RETURN_IF_ERROR(indexed_values_writer.Close());
+  }
+
+  if (next_output_shard_idx != request.num_shards_in_output_shards()) {
+    return absl::InternalError(
+        absl::Substitute("Unexpected number of generated shards in discretized "
+                         "numerical feature #$0. $1 != $2",
+                         request.column_idx(), next_output_shard_idx,
+                         request.num_shards_in_output_shards()));
+  }
+
+  result->mutable_metadata()->set_num_discretized_shards(next_output_shard_idx);
+  LOG(INFO) << "Done appending to discretized column #"
+            << request.column_idx();
+  return absl::OkStatus();
+}
+
+absl::Status CreateDatasetCacheWorker::ExportNumericalColumnIndex(
+    const proto::WorkerRequest::SortNumericalColumn& request,
+    const std::vector<std::pair<float, model::SignedExampleIdx>>&
+        value_and_example_idxs,
+    proto::WorkerResult::SortNumericalColumn* result) {
   // Export the sorted values.
   LOG(INFO) << "Export the pre-sorted numerical values of column #"
             << request.column_idx();
@@ -698,18 +978,15 @@ absl::Status ConvertPartialToFinalRawDataCategoricalString(
   return absl::OkStatus();
 }
 
-absl::Status CreateDatasetCacheWorker::ConvertPartialToFinalRawData(
+absl::Status CreateDatasetCacheWorker::ConvertPartialToFinalRawDataColumn(
     const proto::WorkerRequest::ConvertPartialToFinalRawData& request,
-    proto::WorkerResult::ConvertPartialToFinalRawData* result) {
-  LOG(INFO) << "Convert partial to final for column #" << request.column_idx()
-            << " and shard #" << request.shard_idx();
-
+    const proto::WorkerRequest::ConvertPartialToFinalRawData::Column& column) {
   // Get the various paths.
   const auto tmp_file = file::JoinPath(request.final_cache_directory(),
                                        kFilenameTmp, utils::GenUniqueId());
   const auto input_file =
       PartialRawColumnFilePath(request.partial_cache_directory(),
-                               request.column_idx(), request.shard_idx());
+                               column.column_idx(), request.shard_idx());
 
   // Meta-data specific for the shard+column.
   const auto input_metadata_path =
@@ -719,10 +996,10 @@ absl::Status CreateDatasetCacheWorker::ConvertPartialToFinalRawData(
       file::GetBinaryProto(input_metadata_path, &meta_data, file::Defaults()));
 
   const auto output_file =
-      RawColumnFilePath(request.final_cache_directory(), request.column_idx(),
+      RawColumnFilePath(request.final_cache_directory(), column.column_idx(),
                         request.shard_idx(), request.num_shards());
   const auto output_directory = RawColumnFileDirectory(
-      request.final_cache_directory(), request.column_idx());
+      request.final_cache_directory(), column.column_idx());
 
   RETURN_IF_ERROR(
       file::RecursivelyCreateDir(output_directory, file::Defaults()));
@@ -733,25 +1010,26 @@ absl::Status CreateDatasetCacheWorker::ConvertPartialToFinalRawData(
     return absl::OkStatus();
   }
 
-  switch (request.transformation_case()) {
-    case proto::WorkerRequest_ConvertPartialToFinalRawData::kNumerical:
+  switch (column.transformation_case()) {
+    case proto::WorkerRequest_ConvertPartialToFinalRawData_Column::kNumerical:
       RETURN_IF_ERROR(ConvertPartialToFinalRawDataNumerical(
-          input_file, tmp_file, request.numerical()));
+          input_file, tmp_file, column.numerical()));
       break;
 
-    case proto::WorkerRequest_ConvertPartialToFinalRawData::kCategoricalInt:
+    case proto::WorkerRequest_ConvertPartialToFinalRawData_Column::
+        kCategoricalInt:
       RETURN_IF_ERROR(ConvertPartialToFinalRawDataCategoricalInt(
-          input_file, tmp_file, request.categorical_int()));
+          input_file, tmp_file, column.categorical_int()));
       break;
 
-    case proto::WorkerRequest_ConvertPartialToFinalRawData::
+    case proto::WorkerRequest_ConvertPartialToFinalRawData_Column::
         kCategoricalString: {
       RETURN_IF_ERROR(ConvertPartialToFinalRawDataCategoricalString(
-          input_file, tmp_file, request.categorical_string(), meta_data));
+          input_file, tmp_file, column.categorical_string(), meta_data));
       break;
     }
 
-    case proto::WorkerRequest_ConvertPartialToFinalRawData::
+    case proto::WorkerRequest_ConvertPartialToFinalRawData_Column::
         TRANSFORMATION_NOT_SET:
       return absl::InternalError("Transformation not set");
   }
@@ -764,6 +1042,50 @@ absl::Status CreateDatasetCacheWorker::ConvertPartialToFinalRawData(
   return absl::OkStatus();
 }
 
+absl::Status CreateDatasetCacheWorker::ConvertPartialToFinalRawData(
+    const proto::WorkerRequest::ConvertPartialToFinalRawData& request,
+    proto::WorkerResult::ConvertPartialToFinalRawData* result) {
+  YDF_INSTRUMENT_MEMORY_PHASE("dataset_cache_worker.convert_partial_to_final");
+  LOG(INFO) << "Convert partial to final for " << request.columns_size()
+            << " column(s) of shard #" << request.shard_idx();
+
+  // The columns are converted in parallel: each conversion is a sequential
+  // read+transform+write stream, so the decoding of a column overlaps with
+  // the writing of the others.
+  utils::concurrency::Mutex mutex_worker_status;
+  absl::Status worker_status;
+  int converted_columns = 0;
+
+  {
+    utils::concurrency::ThreadPool thread_pool("ConvertColumns", kNumThreads);
+    thread_pool.StartWorkers();
+    for (const auto& column : request.columns()) {
+      const auto* column_ptr = &column;
+      thread_pool.Schedule([&, column_ptr]() {
+        {
+          utils::concurrency::MutexLock l(&mutex_worker_status);
+          if (!worker_status.ok()) {
+            return;
+          }
+          LOG_INFO_EVERY_N_SEC(30, _ << "Converting columns "
+                                     << (converted_columns + 1) << "/"
+                                     << request.columns_size());
+        }
+
+        const auto local_status =
+            ConvertPartialToFinalRawDataColumn(request, *column_ptr);
+        {
+          utils::concurrency::MutexLock l(&mutex_worker_status);
+          worker_status.Update(local_status);
+          converted_columns++;
+        }
+      });
+    }
+  }
+
+  return worker_status;
+}
+
 absl::Status CreateDatasetCacheWorker::Setup(Blob serialized_welcome) {
   ASSIGN_OR_RETURN(welcome_, utils::ParseBinaryProto<proto::WorkerWelcome>(
                                  serialized_welcome));
@@ -54,10 +54,41 @@ class CreateDatasetCacheWorker : public distribute::AbstractWorker {
       const proto::WorkerRequest::ConvertPartialToFinalRawData& request,
       proto::WorkerResult::ConvertPartialToFinalRawData* result);
 
+  // Converts a single column of the shard. Used by
+  // "ConvertPartialToFinalRawData".
+  absl::Status ConvertPartialToFinalRawDataColumn(
+      const proto::WorkerRequest::ConvertPartialToFinalRawData& request,
+      const proto::WorkerRequest::ConvertPartialToFinalRawData::Column& column);
+
   absl::Status SortNumericalColumn(
       const proto::WorkerRequest::SortNumericalColumn& request,
       proto::WorkerResult::SortNumericalColumn* result);
 
+  // Indexes the delta of a numerical column when appending examples to an
+  // existing cache (i.e. "delta_begin_shard_idx" > 0). Only the new examples
+  // are sorted; the existing index is reused. Used by "SortNumericalColumn".
+  absl::Status AppendSortedNumericalColumn(
+      const proto::WorkerRequest::SortNumericalColumn& request,
+      proto::WorkerResult::SortNumericalColumn* result);
+
+  // Re-discretizes a previously discretized column extended with new
+  // examples. The existing boundaries are reused: the existing discretized
+  // values are copied and the new examples are discretized with the same
+  // boundaries. Used by "AppendSortedNumericalColumn".
+  absl::Status AppendDiscretizedNumericalColumn(
+      const proto::WorkerRequest::SortNumericalColumn& request,
+      const proto::CacheMetadata::NumericalColumn& previous_metadata,
+      proto::WorkerResult::SortNumericalColumn* result);
+
+  // Counts the unique values, selects the output format (pre-sorted or
+  // pre-discretized) and exports "value_and_example_idxs" (sorted by value).
+  // Used by "SortNumericalColumn" and "AppendSortedNumericalColumn".
+  absl::Status ExportNumericalColumnIndex(
+      const proto::WorkerRequest::SortNumericalColumn& request,
+      const std::vector<std::pair<float, model::SignedExampleIdx>>&
+          value_and_example_idxs,
+      proto::WorkerResult::SortNumericalColumn* result);
+
   // Export sorted numerical values. Used by "SortNumericalColumn".
   absl::Status ExportSortedNumericalColumn(
       const proto::WorkerRequest::SortNumericalColumn& request,
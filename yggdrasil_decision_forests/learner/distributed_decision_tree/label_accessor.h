@@ -111,7 +111,7 @@ class RegressionLabelFiller {
  public:
   // How to represent a label value.
   typedef float Label;
-  typedef decision_tree::LabelNumericalBucket LabelBucket;
+  typedef decision_tree::LabelNumericalBucket</*weighted=*/true> LabelBucket;
   typedef decision_tree::LabelNumericalScoreAccumulator Accumulator;
   typedef LabelBucket::Initializer AccumulatorInitializer;
 
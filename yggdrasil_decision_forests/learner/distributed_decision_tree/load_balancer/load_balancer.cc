@@ -88,6 +88,110 @@ absl::Status LoadBalancer::Initialize(
   return absl::OkStatus();
 }
 
+proto::LoadBalancerCostModel LoadBalancer::ToCostModel() const {
+  proto::LoadBalancerCostModel model;
+  model.set_num_workers(workers_.size());
+  if (num_feature_loading_time_ > 0) {
+    model.set_mean_feature_loading_time(sum_feature_loading_time_ /
+                                        num_feature_loading_time_);
+    model.set_num_feature_loading_times(num_feature_loading_time_);
+  }
+  for (const auto& worker : workers_) {
+    auto* dst_worker = model.add_workers();
+    *dst_worker->mutable_features() = {worker.features.begin(),
+                                       worker.features.end()};
+    for (const auto& measure : worker.measures) {
+      auto* dst_measure = dst_worker->add_measures();
+      dst_measure->set_time(measure.time);
+      dst_measure->set_num_features(measure.num_features);
+    }
+  }
+  return model;
+}
+
+absl::Status LoadBalancer::WarmStart(
+    const proto::LoadBalancerCostModel& model) {
+  if (num_measures_ > 0) {
+    return absl::InternalError(
+        "WarmStart should be called before the first work time measurement.");
+  }
+
+  // Feature loading time.
+  if (model.num_feature_loading_times() > 0) {
+    sum_feature_loading_time_ +=
+        model.mean_feature_loading_time() * model.num_feature_loading_times();
+    num_feature_loading_time_ += model.num_feature_loading_times();
+  }
+
+  if (model.num_workers() != NumWorkers()) {
+    LOG(WARNING) << "The load balancer cost model was learned with "
+                 << model.num_workers() << " worker(s) while " << NumWorkers()
+                 << " worker(s) are available. Only reusing the feature "
+                    "loading time.";
+    return absl::OkStatus();
+  }
+
+  // Restore the feature assignment for the features present in both runs.
+  std::vector<bool> assigned(features_.size(), false);
+  std::vector<std::vector<int>> new_assignment(workers_.size());
+  for (int worker_idx = 0; worker_idx < model.workers_size(); worker_idx++) {
+    for (const int feature : model.workers(worker_idx).features()) {
+      if (feature < 0 || feature >= features_.size() ||
+          !features_[feature].active) {
+        // The feature is not used in this run.
+        continue;
+      }
+      new_assignment[worker_idx].push_back(feature);
+      assigned[feature] = true;
+    }
+  }
+
+  // Assign the features absent from the model (e.g. new columns) to the
+  // least loaded workers.
+  for (const int feature : active_features_) {
+    if (assigned[feature]) {
+      continue;
+    }
+    const int worker_idx =
+        std::min_element(
+            new_assignment.begin(), new_assignment.end(),
+            [](const std::vector<int>& a, const std::vector<int>& b) {
+              return a.size() < b.size();
+            }) -
+        new_assignment.begin();
+    new_assignment[worker_idx].push_back(feature);
+  }
+
+  size_t max_num_features = 0;
+  for (int worker_idx = 0; worker_idx < workers_.size(); worker_idx++) {
+    workers_[worker_idx].features = new_assignment[worker_idx];
+    for (const int feature : new_assignment[worker_idx]) {
+      features_[feature].worker = worker_idx;
+    }
+    max_num_features =
+        std::max(max_num_features, new_assignment[worker_idx].size());
+  }
+  // Make sure the restored assignment respects the feature cap.
+  max_num_features_per_workers_ =
+      std::max<int>(max_num_features_per_workers_, max_num_features);
+
+  // Restore the worker speed measures.
+  for (int worker_idx = 0; worker_idx < workers_.size(); worker_idx++) {
+    auto& measures = workers_[worker_idx].measures;
+    measures.clear();
+    for (const auto& measure : model.workers(worker_idx).measures()) {
+      if (measures.size() >= options_.estimation_window_length()) {
+        break;
+      }
+      measures.push_back(
+          {/*time=*/measure.time(), /*num_features=*/measure.num_features()});
+    }
+  }
+
+  LOG(INFO) << "Warm-started load balancer:\n" << Info();
+  return absl::OkStatus();
+}
+
 utils::StatusOr<int> LoadBalancer::FeatureOwner(int feature) const {
   if (!features_[feature].active) {
     return absl::InternalError("Non active feature");
@@ -283,9 +387,22 @@ LoadBalancer::CreateWorkTimeEstimatePerWorker() const {
     }
 
     if (weight_wall_time > 0) {
-      const auto estimated_wall_time = sum_wall_time / weight_wall_time;
+      // Average time for the worker to process one feature.
+      const auto time_per_feature = sum_wall_time / weight_wall_time;
+      // Convert into a time per unit of feature cost using the cost of the
+      // features currently owned by the worker.
+      double sum_feature_costs = 0;
+      for (const auto feature : worker.features) {
+        sum_feature_costs += features_[feature].cost_score;
+      }
+      if (sum_feature_costs <= 0) {
+        continue;
+      }
+      const auto time_per_cost_unit =
+          time_per_feature * worker.features.size() / sum_feature_costs;
       estimates.push_back(
-          {/*time_per_features=*/estimated_wall_time,
+          {/*time_per_cost_unit=*/time_per_cost_unit,
+           /*sum_feature_costs=*/sum_feature_costs,
            /*num_features=*/static_cast<int>(worker.features.size()),
            /*worker_idx=*/worker_idx});
     }
@@ -358,9 +475,8 @@ absl::Status LoadBalancer::TryCreateBalancingOrders() {
     for (int idx = 0; idx < num_display_items && idx < time_per_worker.size();
          idx++) {
       const auto& item = time_per_worker[idx];
-      LOG(INFO) << "\tidx:" << idx
-                << " time:" << item.time_per_features * item.num_features
-                << " time-p-f:" << item.time_per_features
+      LOG(INFO) << "\tidx:" << idx << " time:" << item.time()
+                << " time-p-c:" << item.time_per_cost_unit
                 << " worker:" << item.worker_idx
                 << " num_features:" << item.num_features;
     }
@@ -370,9 +486,8 @@ absl::Status LoadBalancer::TryCreateBalancingOrders() {
                                    num_display_items);
            idx < time_per_worker.size(); idx++) {
         const auto& item = time_per_worker[idx];
-        LOG(INFO) << "\tidx:" << idx
-                  << " time:" << item.time_per_features * item.num_features
-                  << " time-p-f:" << item.time_per_features
+        LOG(INFO) << "\tidx:" << idx << " time:" << item.time()
+                  << " time-p-c:" << item.time_per_cost_unit
                   << " worker:" << item.worker_idx
                   << " num_features:" << item.num_features;
       }
@@ -427,28 +542,38 @@ absl::Status LoadBalancer::TryCreateBalancingOrders() {
     const auto dst_worker = time_per_worker[dst_time_idx].worker_idx;
 
     // TODO: After the first one, all the other transfer costs are free.
-    const double gain = time_per_worker[src_time_idx].time_per_features -
-                        time_per_worker[dst_time_idx].time_per_features;
-    if (gain <= 0) {
+    const double gain_per_cost_unit =
+        time_per_worker[src_time_idx].time_per_cost_unit -
+        time_per_worker[dst_time_idx].time_per_cost_unit;
+    if (gain_per_cost_unit <= 0) {
       break;
     }
 
-    // Select an available feature i.e. a feature not already used.
+    // Select the most expensive available feature i.e. a feature not already
+    // used. With heterogeneous features, a slow worker is often gated by a
+    // single expensive feature (e.g. a categorical feature with a large
+    // dictionary). Moving this feature first yields the largest reduction of
+    // the worker's wall time.
     const auto& candidate_features = workers_[src_worker].features;
     int feature = -1;
-    for (auto rit = candidate_features.rbegin();
-         rit != candidate_features.rend(); rit++) {
-      if (used_features.find(*rit) == used_features.end()) {
-        feature = *rit;
-        break;
+    for (const auto candidate : candidate_features) {
+      if (used_features.find(candidate) != used_features.end()) {
+        continue;
+      }
+      if (feature == -1 ||
+          features_[candidate].cost_score > features_[feature].cost_score) {
+        feature = candidate;
       }
     }
     if (feature == -1) {
       return absl::InternalError("No available feature");
     }
     used_features.insert(feature);
+    const double feature_cost = features_[feature].cost_score;
     time_per_worker[src_time_idx].num_features--;
+    time_per_worker[src_time_idx].sum_feature_costs -= feature_cost;
     time_per_worker[dst_time_idx].num_features++;
+    time_per_worker[dst_time_idx].sum_feature_costs += feature_cost;
 
     pending_orders_.push_back({
         /*source_worker=*/src_worker,
@@ -460,7 +585,8 @@ absl::Status LoadBalancer::TryCreateBalancingOrders() {
 
     LOG(INFO) << "Reassigning feature " << feature << " from worker #"
               << src_worker << " to worker #" << dst_worker
-              << " for an estimated gain of " << gain;
+              << " for an estimated gain of "
+              << gain_per_cost_unit * feature_cost;
     num_unit_orders++;
   }
 
@@ -483,6 +609,15 @@ std::vector<int> LoadBalancer::WorkersPerFeatures() const {
   return result;
 }
 
+std::vector<double> LoadBalancer::FeatureCostScores() const {
+  std::vector<double> result;
+  result.reserve(features_.size());
+  for (const auto& feature : features_) {
+    result.push_back(feature.cost_score);
+  }
+  return result;
+}
+
 std::vector<std::vector<int>> LoadBalancer::FeaturesPerWorkers() const {
   std::vector<std::vector<int>> result;
   result.reserve(workers_.size());
@@ -38,10 +38,15 @@
 //    time (the last `estimation_window_length` observations).
 // 2. Workers that run slower than "median_margin_ratio x the medium worker
 //    time" (e.g. median_margin_ratio=2) are considered "slow".
-// 3. The computation time per feature of all the workers are estimated. The
-//    balancer is proposing a balancing plan where the features of slow workers
-//    are re-assigned to faster workers (while making sure not to create new
-//    slow workers using the speed estimates).
+// 3. The computation time per unit of feature cost of all the workers are
+//    estimated. The cost of a feature is derived from the cache metadata e.g.
+//    a categorical feature with a large dictionary is more expensive than a
+//    boolean feature. The balancer is proposing a balancing plan where the
+//    most expensive features of slow workers are re-assigned to faster workers
+//    (while making sure not to create new slow workers using the speed and
+//    cost estimates). Re-assigning the most expensive features first matters
+//    on heterogeneous datasets: a worker is often slow because of a single
+//    large feature, and moving its cheap features would not help.
 // The plan is created with the following constraints:
 //   - No worker can get assigned with more than "(1 + max_unbalance_ratio) x
 //   number of initially assigned features".
@@ -103,6 +108,25 @@ class LoadBalancer {
       const dataset_cache::proto::CacheMetadata& cache_metadata,
       const proto::LoadBalancerOptions& options);
 
+  // Exports the state learned during the run (feature assignment, worker
+  // speed measures, feature loading time). Can be persisted alongside the
+  // dataset cache and used to "WarmStart" the balancer of the next run on the
+  // same cache.
+  proto::LoadBalancerCostModel ToCostModel() const;
+
+  // Bootstraps the balancer from the cost model learned by a previous run.
+  // Restores the feature assignment, the worker speed measures and the
+  // feature loading time: the balancer can re-balance from the first
+  // iterations instead of waiting for "estimation_window_length" measures.
+  //
+  // Should be called right after "Create" i.e. before the feature assignment
+  // is communicated to the workers and before the first
+  // "AddWorkDurationMeasurement". If the model was created with a different
+  // number of workers, only the feature loading time is reused. Features
+  // absent from the model (e.g. new columns) are assigned to the least loaded
+  // workers.
+  absl::Status WarmStart(const proto::LoadBalancerCostModel& model);
+
   // Gets the index of the workers currently owning a given feature.
   utils::StatusOr<int> FeatureOwner(int feature) const;
 
@@ -132,6 +156,12 @@ class LoadBalancer {
   // Mapping feature -> worker.
   std::vector<int> WorkersPerFeatures() const;
 
+  // Cost estimate of each feature (indexed by feature index). Non-active
+  // features have a cost of -1. Can be used e.g. to weight the budgeted
+  // in-memory cache of the "DatasetCacheReader"
+  // ("SetInMemoryCacheFeatureWeights").
+  std::vector<double> FeatureCostScores() const;
+
   // Mapping worker -> {list of features}. If possible use
   // "FeaturesPerWorker(worker)" instead.
   std::vector<std::vector<int>> FeaturesPerWorkers() const;
@@ -202,14 +232,15 @@ class LoadBalancer {
       const proto::LoadBalancerOptions& options,
       const dataset_cache::proto::CacheMetadata& cache_metadata);
 
-  // Estimation of the working time of a worker (total and per features) of a
-  // worker.
+  // Estimation of the working time of a worker (total and per unit of feature
+  // cost) of a worker.
   struct WorkTimeEstimate {
-    double time_per_features;
+    double time_per_cost_unit;
+    double sum_feature_costs;
     int num_features;
     int worker_idx;
 
-    double time() const { return time_per_features * num_features; }
+    double time() const { return time_per_cost_unit * sum_feature_costs; }
 
     bool operator<(const WorkTimeEstimate& other) const {
       return time() < other.time();
@@ -104,9 +104,9 @@ TEST(LoadBalancer, DynamicBalancing) {
   CHECK_OK(balancer.AddWorkDurationMeasurement({{1, 2}, {5, 2}}).status());
   CHECK_OK(balancer.ApplyPendingOrder());
   LOG(INFO) << balancer.Info();
-  // Transfer of feature expected.
+  // Transfer of the most expensive feature (4) of worker #1 expected.
   EXPECT_THAT(balancer.WorkersPerFeatures(),
-              ElementsAre(0, -1, 0, -1, 1, -1, 0));  // 3 in worker 0.
+              ElementsAre(1, -1, 0, -1, 0, -1, 0));  // 3 in worker 0.
 
   // Now, worker #1 is faster than worker #0.
   LOG(INFO) << "Step 4";
@@ -114,22 +114,63 @@ TEST(LoadBalancer, DynamicBalancing) {
   CHECK_OK(balancer.ApplyPendingOrder());
   LOG(INFO) << balancer.Info();
   EXPECT_THAT(balancer.WorkersPerFeatures(),
-              ElementsAre(0, -1, 0, -1, 1, -1, 0));  // 3 in worker 0.
+              ElementsAre(1, -1, 0, -1, 0, -1, 0));  // 3 in worker 0.
 
   LOG(INFO) << "Step 5";
   CHECK_OK(balancer.AddWorkDurationMeasurement({{8, 3}, {1, 1}}).status());
   CHECK_OK(balancer.ApplyPendingOrder());
   LOG(INFO) << balancer.Info();
+  // Transfer of the most expensive feature (2) of worker #0 expected.
   EXPECT_THAT(balancer.WorkersPerFeatures(),
-              ElementsAre(1, -1, 0, -1, 1, -1, 0));  // 2 in worker 0.
+              ElementsAre(1, -1, 1, -1, 0, -1, 0));  // 2 in each workers.
 
   LOG(INFO) << "Step 6";
   CHECK_OK(balancer.AddWorkDurationMeasurement({{4, 2}, {4, 2}}).status());
   CHECK_OK(balancer.ApplyPendingOrder());
   LOG(INFO) << balancer.Info();
-  // Two transfers of feature expected.
+  // No transfer expected: no worker is above the median margin.
   EXPECT_THAT(balancer.WorkersPerFeatures(),
-              ElementsAre(1, -1, 0, -1, 1, -1, 0));  // 2 in worker 0.
+              ElementsAre(1, -1, 1, -1, 0, -1, 0));  // 2 in each workers.
+}
+
+TEST(LoadBalancer, CostModelWarmStart) {
+  const dataset_cache::proto::CacheMetadata cache_metadata = PARSE_TEST_PROTO(
+      R"pb(
+        columns { numerical { discretized: true num_discretized_values: 6 } }
+        columns { categorical { num_values: 9 } }
+        columns { categorical { num_values: 8 } }
+        columns { categorical { num_values: 7 } }
+      )pb");
+
+  const proto::LoadBalancerOptions options = PARSE_TEST_PROTO(
+      R"pb(
+        estimation_window_length: 2
+        dynamic_balancing_frequency_iteration: 1
+      )pb");
+
+  auto balancer =
+      LoadBalancer::Create(/*features=*/{0, 1, 2, 3}, /*num_workers=*/2,
+                           cache_metadata, options)
+          .value();
+  balancer.AddFeatureLoadingDurationMeasurement(1.0);
+  CHECK_OK(balancer.AddWorkDurationMeasurement({{1, 2}, {2, 2}}).status());
+  CHECK_OK(balancer.AddWorkDurationMeasurement({{1, 2}, {2, 2}}).status());
+  CHECK_OK(balancer.ApplyPendingOrder());
+
+  const auto cost_model = balancer.ToCostModel();
+  EXPECT_EQ(cost_model.num_workers(), 2);
+  EXPECT_EQ(cost_model.num_feature_loading_times(), 1);
+  EXPECT_NEAR(cost_model.mean_feature_loading_time(), 1.0, 0.0001);
+
+  // The warm-started balancer reuses the feature assignment and the worker
+  // speed measures of the first balancer.
+  auto restored =
+      LoadBalancer::Create(/*features=*/{0, 1, 2, 3}, /*num_workers=*/2,
+                           cache_metadata, options)
+          .value();
+  CHECK_OK(restored.WarmStart(cost_model));
+  EXPECT_EQ(restored.WorkersPerFeatures(), balancer.WorkersPerFeatures());
+  EXPECT_THAT(restored.ToCostModel(), EqualsProto(cost_model));
 }
 
 TEST(LoadBalancer, MakeSplitSharingPlan) {
@@ -29,6 +29,7 @@ constexpr char kFileNameDatasetCache[] = "dataset_cache";
 constexpr char kFileNameCheckPoint[] = "checkpoint";
 constexpr char kFileNameSnapshot[] = "snapshot";
 constexpr char kFileNameTmp[] = "tmp";
+constexpr char kFileNameLoadBalancerCostModel[] = "load_balancer_cost_model";
 
 // Gets the path to the snapshot directory from the working directory.
 std::string SnapshotDirectory(absl::string_view work_directory);
@@ -26,6 +26,7 @@
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/loss/loss_library.h"
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/utils/distribute/implementations/multi_thread/multi_thread.pb.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/snapshot.h"
@@ -228,6 +229,19 @@ DistributedGradientBoostedTreesLearner::TrainWithStatus(
                                      absl::ToUnixMicros(absl::Now())));
   }
   auto updated_deployment = deployment();
+  if (updated_deployment.distribute().implementation_key().empty()) {
+    // Without a distribution strategy, the training runs entirely in-process
+    // with a single worker. Combined with
+    // "dataset_reader_options.load_cache_in_memory=false", this makes it
+    // possible to train on a dataset cache larger than the available RAM on a
+    // single machine.
+    LOG(INFO) << "No distribution strategy configured. Training in-process "
+                 "with a single worker.";
+    auto& distribute_config = *updated_deployment.mutable_distribute();
+    distribute_config.set_implementation_key("MULTI_THREAD");
+    distribute_config.MutableExtension(distribute::proto::multi_thread)
+        ->set_num_workers(1);
+  }
   updated_deployment.mutable_distribute()->set_working_directory(
       work_directory);
 
@@ -431,6 +445,20 @@ TrainWithCache(
                        input_features, num_train_workers, cache_metadata,
                        spe_config.load_balancer()));
 
+  // Warm-start the balancer with the cost model learned by the previous runs
+  // on the same dataset cache (if any). The cost model is updated at each
+  // checkpoint.
+  const auto cost_model_path =
+      file::JoinPath(work_directory, kFileNameLoadBalancerCostModel);
+  ASSIGN_OR_RETURN(const bool has_cost_model,
+                   file::FileExists(cost_model_path));
+  if (has_cost_model) {
+    distributed_decision_tree::proto::LoadBalancerCostModel cost_model;
+    RETURN_IF_ERROR(file::GetBinaryProto(cost_model_path, &cost_model,
+                                         file::Defaults()));
+    RETURN_IF_ERROR(load_balancer.WarmStart(cost_model));
+  }
+
   // Initializer the distribute manager.
   ASSIGN_OR_RETURN(auto distribute_manager,
                    InitializeDistributionManager(
@@ -711,6 +739,14 @@ absl::Status RunIteration(
       break;
     }
 
+    // Request for the workers to evaluate the splits. The answers are
+    // collected after the manager-side computations below i.e. the manager
+    // updates the trees and plans the split sharing while the workers
+    // evaluate the splits.
+    RETURN_IF_ERROR(EmitStartEvaluateSplits(splits_per_weak_models,
+                                            distribute_manager, rnd, monitoring,
+                                            load_balancer));
+
     // Update the tree structure and update the label statistics.
     for (int weak_model_idx = 0; weak_model_idx < weak_models.size();
          weak_model_idx++) {
@@ -721,16 +757,19 @@ absl::Status RunIteration(
               .status());
     }
 
-    // Request for the workers to evaluate the splits.
-    RETURN_IF_ERROR(EmitEvaluateSplits(splits_per_weak_models,
-                                       distribute_manager, rnd, monitoring,
-                                       load_balancer));
+    // Plan the sharing of the split evaluation results.
+    ASSIGN_OR_RETURN(
+        const auto share_plan,
+        BuildSplitSharingPlan(splits_per_weak_models, load_balancer));
+
+    RETURN_IF_ERROR(
+        EmitWaitEvaluateSplits(distribute_manager, monitoring, load_balancer));
 
     // Request for the workers to share the evaluation results,
     // update the tree structures, example->node mapping and label
     // statistics
-    RETURN_IF_ERROR(EmitShareSplits(splits_per_weak_models, distribute_manager,
-                                    monitoring, load_balancer));
+    RETURN_IF_ERROR(EmitShareSplits(share_plan, distribute_manager, monitoring,
+                                    load_balancer));
   }
 
   const bool is_last_iteration = iter_idx == spe_config.gbt().num_trees() - 1;
@@ -893,6 +932,12 @@ absl::Status CreateCheckpoint(
   RETURN_IF_ERROR(
       utils::AddSnapshot(SnapshotDirectory(work_directory), iter_idx));
 
+  // Save the load balancer cost model to warm-start the next runs on the
+  // same dataset cache.
+  RETURN_IF_ERROR(file::SetBinaryProto(
+      file::JoinPath(work_directory, kFileNameLoadBalancerCostModel),
+      load_balancer->ToCostModel(), file::Defaults()));
+
   LOG(INFO) << "Checkpoint created in " << absl::Now() - begin_create_checkpoint
             << " for iteration " << iter_idx;
   monitoring->EndStage(internal::Monitoring::kCreateCheckpoint);
@@ -977,6 +1022,21 @@ InitializeDistributionManager(
       /*parallel_execution_per_worker=*/10);
 }
 
+absl::Status MulticastProtoRequest(const proto::WorkerRequest& request,
+                                   const int num_workers,
+                                   distribute::AbstractManager* distribute) {
+  // Serialize the request only once and send the same buffer to all the
+  // workers. On large broadcasts (e.g. the selected splits sent to all the
+  // workers at each depth), the repeated proto serialization dominates the
+  // manager time.
+  const distribute::Blob serialized_request = request.SerializeAsString();
+  for (int worker_idx = 0; worker_idx < num_workers; worker_idx++) {
+    RETURN_IF_ERROR(
+        distribute->AsynchronousRequest(serialized_request, worker_idx));
+  }
+  return absl::OkStatus();
+}
+
 utils::StatusOr<decision_tree::proto::LabelStatistics> EmitGetLabelStatistics(
     distribute::AbstractManager* distribute, internal::Monitoring* monitoring,
     distributed_decision_tree::LoadBalancer* load_balancer) {
@@ -1007,12 +1067,8 @@ absl::Status EmitSetInitialPredictions(
   auto& request = *generic_request.mutable_set_initial_predictions();
   *request.mutable_label_statistics() = label_statistics;
 
-  // TODO: Implement multicast operations.
-  for (int worker_idx = 0; worker_idx < distribute->NumWorkers();
-       worker_idx++) {
-    RETURN_IF_ERROR(
-        distribute->AsynchronousProtoRequest(generic_request, worker_idx));
-  }
+  RETURN_IF_ERROR(MulticastProtoRequest(generic_request,
+                                        distribute->NumWorkers(), distribute));
 
   // TODO: No need for an answer.
   for (int reply_idx = 0; reply_idx < distribute->NumWorkers(); reply_idx++) {
@@ -1043,12 +1099,8 @@ EmitStartNewIter(const int iter_idx,
   request.set_iter_uid(utils::GenUniqueId());
   request.set_seed(seed);
 
-  // TODO: Implement multicast operations.
-  for (int worker_idx = 0; worker_idx < load_balancer->NumWorkers();
-       worker_idx++) {
-    RETURN_IF_ERROR(
-        distribute->AsynchronousProtoRequest(generic_request, worker_idx));
-  }
+  RETURN_IF_ERROR(MulticastProtoRequest(
+      generic_request, load_balancer->NumWorkers(), distribute));
 
   // TODO: No need for an answer.
   for (int reply_idx = 0; reply_idx < load_balancer->NumWorkers();
@@ -1196,7 +1248,7 @@ EmitFindSplits(
   return splits_per_weak_models;
 }
 
-absl::Status EmitEvaluateSplits(
+absl::Status EmitStartEvaluateSplits(
     const std::vector<distributed_decision_tree::SplitPerOpenNode>&
         splits_per_weak_models,
     distribute::AbstractManager* distribute, utils::RandomEngine* rnd,
@@ -1211,13 +1263,14 @@ absl::Status EmitEvaluateSplits(
         splits, request.add_split_per_weak_model());
   }
 
-  // TODO: Implement multicast operations.
-  for (int worker_idx = 0; worker_idx < load_balancer->NumWorkers();
-       worker_idx++) {
-    RETURN_IF_ERROR(
-        distribute->AsynchronousProtoRequest(generic_request, worker_idx));
-  }
+  RETURN_IF_ERROR(MulticastProtoRequest(
+      generic_request, load_balancer->NumWorkers(), distribute));
+  return absl::OkStatus();
+}
 
+absl::Status EmitWaitEvaluateSplits(
+    distribute::AbstractManager* distribute, internal::Monitoring* monitoring,
+    distributed_decision_tree::LoadBalancer* load_balancer) {
   for (int reply_idx = 0; reply_idx < load_balancer->NumWorkers();
        reply_idx++) {
     ASSIGN_OR_RETURN(
@@ -1237,13 +1290,11 @@ absl::Status EmitEvaluateSplits(
   return absl::OkStatus();
 }
 
-absl::Status EmitShareSplits(
+utils::StatusOr<distributed_decision_tree::proto::SplitSharingPlan>
+BuildSplitSharingPlan(
     const std::vector<distributed_decision_tree::SplitPerOpenNode>&
         splits_per_weak_models,
-    distribute::AbstractManager* distribute, internal::Monitoring* monitoring,
     distributed_decision_tree::LoadBalancer* load_balancer) {
-  monitoring->BeginStage(internal::Monitoring::kShareSplits);
-
   ASSIGN_OR_RETURN(const auto active_features,
                    ActiveFeatures(splits_per_weak_models));
 
@@ -1257,6 +1308,14 @@ absl::Status EmitShareSplits(
                    load_balancer->MakeSplitSharingPlan(active_feature_idxs));
 
   RETURN_IF_ERROR(SetSplitsInPlan(active_features, &plan));
+  return plan;
+}
+
+absl::Status EmitShareSplits(
+    const distributed_decision_tree::proto::SplitSharingPlan& plan,
+    distribute::AbstractManager* distribute, internal::Monitoring* monitoring,
+    distributed_decision_tree::LoadBalancer* load_balancer) {
+  monitoring->BeginStage(internal::Monitoring::kShareSplits);
 
   for (const auto& round : plan.rounds()) {
     // Send requests.
@@ -1311,24 +1370,38 @@ absl::Status EmitEndIter(int iter_idx, bool is_last_iteration,
   evaluator_request.set_synchronous_validation(is_last_iteration);
   for (const auto& weak_model : weak_models) {
     // Copy the new tree.
-    // TODO: Serialize the tree only one time instead of for each worker.
     EndIterTreeProtoWriter stream(evaluator_request.add_new_trees());
     RETURN_IF_ERROR(weak_model.tree_builder->tree().WriteNodes(&stream));
   }
 
-  // TODO: Implement multicast operations.
-  for (int worker_idx = 0; worker_idx < distribute->NumWorkers();
+  // The first worker is in charge of computing the training loss. Its request
+  // differs from the other trainer workers, which all receive the same
+  // serialized request.
+  if (training_evaluation.has_value()) {
+    trainer_request.set_compute_training_loss(true);
+  }
+  RETURN_IF_ERROR(distribute->AsynchronousProtoRequest(generic_trainer_request,
+                                                       /*worker_idx=*/0));
+  trainer_request.set_compute_training_loss(false);
+  const distribute::Blob serialized_trainer_request =
+      generic_trainer_request.SerializeAsString();
+  for (int worker_idx = 1; worker_idx < load_balancer->NumWorkers();
        worker_idx++) {
-    if (worker_idx < load_balancer->NumWorkers()) {
-      if (training_evaluation.has_value()) {
-        // The first worker is in charge of computing the training loss.
-        trainer_request.set_compute_training_loss(worker_idx == 0);
-      }
-      RETURN_IF_ERROR(distribute->AsynchronousProtoRequest(
-          generic_trainer_request, worker_idx));
-    } else {
-      RETURN_IF_ERROR(distribute->AsynchronousProtoRequest(
-          generic_evaluator_request, worker_idx));
+    RETURN_IF_ERROR(
+        distribute->AsynchronousRequest(serialized_trainer_request,
+                                        worker_idx));
+  }
+
+  // The evaluation workers all receive the same request. The trees are
+  // serialized only once.
+  if (distribute->NumWorkers() > load_balancer->NumWorkers()) {
+    const distribute::Blob serialized_evaluator_request =
+        generic_evaluator_request.SerializeAsString();
+    for (int worker_idx = load_balancer->NumWorkers();
+         worker_idx < distribute->NumWorkers(); worker_idx++) {
+      RETURN_IF_ERROR(
+          distribute->AsynchronousRequest(serialized_evaluator_request,
+                                          worker_idx));
     }
   }
 
@@ -1384,12 +1457,8 @@ absl::Status EmitRestoreCheckpoint(
   request.set_checkpoint_dir(file::JoinPath(work_directory, kFileNameCheckPoint,
                                             absl::StrCat(iter_idx)));
 
-  // TODO: Implement multicast operations.
-  for (int worker_idx = 0; worker_idx < distribute->NumWorkers();
-       worker_idx++) {
-    RETURN_IF_ERROR(
-        distribute->AsynchronousProtoRequest(generic_request, worker_idx));
-  }
+  RETURN_IF_ERROR(MulticastProtoRequest(generic_request,
+                                        distribute->NumWorkers(), distribute));
 
   // TODO: No need for an answer.
   for (int reply_idx = 0; reply_idx < distribute->NumWorkers(); reply_idx++) {
@@ -1545,12 +1614,8 @@ absl::Status EmitStartTraining(
   proto::WorkerRequest generic_request;
   generic_request.mutable_start_training();
 
-  // TODO: Implement multicast operations.
-  for (int worker_idx = 0; worker_idx < load_balancer->NumWorkers();
-       worker_idx++) {
-    RETURN_IF_ERROR(
-        distribute->AsynchronousProtoRequest(generic_request, worker_idx));
-  }
+  RETURN_IF_ERROR(MulticastProtoRequest(
+      generic_request, load_balancer->NumWorkers(), distribute));
 
   for (int reply_idx = 0; reply_idx < load_balancer->NumWorkers();
        reply_idx++) {
@@ -27,6 +27,12 @@
 // DistributedGradientBoostedTreesLearner only support trainig from a dataset
 // path (i.e. training on in-memory dataset is not allowed).
 //
+// If the deployment configuration does not specify a distribution strategy,
+// the training runs entirely in-process with a single worker. With
+// "dataset_reader_options.load_cache_in_memory=false", the worker streams the
+// feature columns from the dataset cache on disk i.e. the dataset size is
+// bounded by the disk, not the RAM, of the machine.
+//
 // At the start of the training, the dataset is divided by columns and shards
 // and then indexed.
 //
@@ -353,6 +359,12 @@ InitializeDistributionManager(
 // {stage_name} work. All these functions are blocking. See "worker.proto" for
 // the definition of the stages.
 
+// Sends the same request to the workers [0, num_workers). The request is
+// serialized only once i.e. a multicast operation.
+absl::Status MulticastProtoRequest(const proto::WorkerRequest& request,
+                                   int num_workers,
+                                   distribute::AbstractManager* distribute);
+
 utils::StatusOr<decision_tree::proto::LabelStatistics> EmitGetLabelStatistics(
     distribute::AbstractManager* distribute, internal::Monitoring* monitoring,
     distributed_decision_tree::LoadBalancer* load_balancer);
@@ -376,17 +388,35 @@ EmitFindSplits(
     internal::Monitoring* monitoring,
     distributed_decision_tree::LoadBalancer* load_balancer);
 
-// Returns the list of workers that owns the split evaluation data.
-absl::Status EmitEvaluateSplits(
+// Sends the split evaluation requests to the workers without waiting for the
+// answers. The manager can run local computation (e.g. planning the sharing of
+// the split evaluations) while the workers evaluate the splits. The answers
+// are collected with "EmitWaitEvaluateSplits".
+absl::Status EmitStartEvaluateSplits(
     const std::vector<distributed_decision_tree::SplitPerOpenNode>&
         splits_per_weak_models,
     distribute::AbstractManager* distribute, utils::RandomEngine* rnd,
     internal::Monitoring* monitoring,
     distributed_decision_tree::LoadBalancer* load_balancer);
 
-absl::Status EmitShareSplits(
+// Collects the split evaluation answers emitted with
+// "EmitStartEvaluateSplits".
+absl::Status EmitWaitEvaluateSplits(
+    distribute::AbstractManager* distribute, internal::Monitoring* monitoring,
+    distributed_decision_tree::LoadBalancer* load_balancer);
+
+// Plans the sharing of the split evaluation data in between the workers.
+utils::StatusOr<distributed_decision_tree::proto::SplitSharingPlan>
+BuildSplitSharingPlan(
     const std::vector<distributed_decision_tree::SplitPerOpenNode>&
         splits_per_weak_models,
+    distributed_decision_tree::LoadBalancer* load_balancer);
+
+// Executes a split sharing plan built with "BuildSplitSharingPlan": the
+// workers share the split evaluation results, update the tree structures,
+// example->node mapping and label statistics.
+absl::Status EmitShareSplits(
+    const distributed_decision_tree::proto::SplitSharingPlan& plan,
     distribute::AbstractManager* distribute, internal::Monitoring* monitoring,
     distributed_decision_tree::LoadBalancer* load_balancer);
 
@@ -98,6 +98,20 @@ TEST_F(DatasetAdult, Base_5workers) {
   EXPECT_NEAR(metric::LogLoss(evaluation_), 0.2765, 0.04);
 }
 
+// Train and test a model without a distribution strategy: the training runs
+// in-process with a single worker streaming the dataset cache from disk.
+TEST_F(DatasetAdult, InProcessOutOfCore) {
+  deployment_config_.clear_distribute();
+  auto* spe_config = train_config_.MutableExtension(
+      distributed_gradient_boosted_trees::proto::
+          distributed_gradient_boosted_trees_config);
+  spe_config->mutable_dataset_reader_options()->set_load_cache_in_memory(false);
+  TrainAndEvaluateModel();
+  // Note: This result does not take early stopping into account.
+  EXPECT_NEAR(metric::Accuracy(evaluation_), 0.8748, 0.01);
+  EXPECT_NEAR(metric::LogLoss(evaluation_), 0.2765, 0.04);
+}
+
 // Train and test a model on the adult dataset with workers continuously
 // failing and requiring checkpoint restoration.
 TEST_F(DatasetAdult, BaseWithFailure) {
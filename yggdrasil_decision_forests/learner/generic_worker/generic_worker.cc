@@ -15,6 +15,7 @@
 
 #include "yggdrasil_decision_forests/learner/generic_worker/generic_worker.h"
 
+#include "absl/memory/memory.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/weight.h"
 #include "yggdrasil_decision_forests/learner/abstract_learner.h"
@@ -124,28 +125,47 @@ absl::Status GenericWorker::Setup(Blob serialized_welcome) {
   return absl::OkStatus();
 }
 
-utils::StatusOr<Blob> GenericWorker::RunRequest(Blob serialized_request) {
-  ASSIGN_OR_RETURN(auto request,
-                   utils::ParseBinaryProto<proto::Request>(serialized_request));
-  proto::Result result;
+absl::Status GenericWorker::ProcessRequest(const proto::Request& request,
+                                           proto::Result* result) {
   if (request.has_request_id()) {
-    result.set_request_id(request.request_id());
+    result->set_request_id(request.request_id());
   }
   switch (request.type_case()) {
-    case proto::Request::kTrainModel:
+    case proto::Request::kTrainModel: {
+      utils::concurrency::MutexLock lock(&train_mutex_);
       RETURN_IF_ERROR(
-          TrainModel(request.train_model(), result.mutable_train_model()));
-      break;
-    case proto::Request::kEvaluateModel:
+          TrainModel(request.train_model(), result->mutable_train_model()));
+    } break;
+    case proto::Request::kEvaluateModel: {
+      utils::concurrency::MutexLock lock(&evaluate_mutex_);
       RETURN_IF_ERROR(EvaluateModel(request.evaluate_model(),
-                                    result.mutable_evaluate_model()));
-      break;
+                                    result->mutable_evaluate_model()));
+    } break;
     case proto::Request::TYPE_NOT_SET:
       return absl::InvalidArgumentError("Request without type");
   }
+  return absl::OkStatus();
+}
+
+utils::StatusOr<Blob> GenericWorker::RunRequest(Blob serialized_request) {
+  ASSIGN_OR_RETURN(auto request,
+                   utils::ParseBinaryProto<proto::Request>(serialized_request));
+  proto::Result result;
+  RETURN_IF_ERROR(ProcessRequest(request, &result));
   return result.SerializeAsString();
 }
 
+utils::StatusOr<std::unique_ptr<google::protobuf::Message>>
+GenericWorker::RunTypedRequest(const google::protobuf::Message& request) {
+  const auto* typed_request = dynamic_cast<const proto::Request*>(&request);
+  if (typed_request == nullptr) {
+    return absl::InvalidArgumentError("Unexpected request type");
+  }
+  auto result = absl::make_unique<proto::Result>();
+  RETURN_IF_ERROR(ProcessRequest(*typed_request, result.get()));
+  return result;
+}
+
 }  // namespace generic_worker
 }  // namespace model
 }  // namespace yggdrasil_decision_forests
@@ -24,6 +24,7 @@
 #include "yggdrasil_decision_forests/learner/generic_worker/generic_worker.pb.h"
 #include "yggdrasil_decision_forests/utils/distribute/core.h"
 #include "yggdrasil_decision_forests/utils/distribute/distribute.pb.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 namespace yggdrasil_decision_forests {
 namespace model {
@@ -37,12 +38,21 @@ class GenericWorker : public distribute::AbstractWorker {
   utils::StatusOr<distribute::Blob> RunRequest(
       distribute::Blob serialized_request) override;
 
+  // Zero-serialization path used when the manager runs in the same process
+  // (e.g. the multi-thread distribute implementation).
+  utils::StatusOr<std::unique_ptr<google::protobuf::Message>> RunTypedRequest(
+      const google::protobuf::Message& request) override;
+
   absl::Status Done() override {
     done_was_called_ = true;
     return absl::OkStatus();
   }
 
  private:
+  // Solves a request. Common logic of "RunRequest" and "RunTypedRequest".
+  absl::Status ProcessRequest(const proto::Request& request,
+                              proto::Result* result);
+
   absl::Status TrainModel(const proto::Request::TrainModel& request,
                           proto::Result::TrainModel* result);
 
@@ -51,6 +61,14 @@ class GenericWorker : public distribute::AbstractWorker {
 
   proto::Welcome welcome_;
 
+  // Serialize the execution of the requests of a same type. A worker
+  // receiving multiple requests in parallel (i.e. the manager is configured
+  // with "parallel_execution_per_worker" > 1) can overlap one training
+  // (generally CPU bound) with one evaluation (generally I/O bound), but
+  // never runs two trainings or two evaluations at the same time.
+  utils::concurrency::Mutex train_mutex_;
+  utils::concurrency::Mutex evaluate_mutex_;
+
   // Set to true when Done is called on the "GenericWorker".
   std::atomic<bool> done_was_called_ =  {false};
 };
@@ -15,6 +15,8 @@
 
 #include "yggdrasil_decision_forests/learner/generic_worker/generic_worker.h"
 
+#include <string>
+
 #include "gtest/gtest.h"
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/learner/generic_worker/generic_worker.pb.h"
@@ -31,62 +33,71 @@ namespace model {
 namespace generic_worker {
 namespace {
 
-// Create a single thread manager with 5 workers.
-std::unique_ptr<distribute::AbstractManager> CreateSingleThreadManager() {
+// Create a manager with "num_workers" workers, each running
+// "parallel_execution_per_worker" requests in parallel.
+std::unique_ptr<distribute::AbstractManager> CreateManager(
+    const int num_workers = 5, const int parallel_execution_per_worker = 1) {
   distribute::proto::Config config;
   config.set_implementation_key("MULTI_THREAD");
-  config.MutableExtension(distribute::proto::multi_thread)->set_num_workers(5);
+  config.MutableExtension(distribute::proto::multi_thread)
+      ->set_num_workers(num_workers);
   config.set_verbosity(2);
   proto::Welcome welcome;
   welcome.set_temporary_directory(test::TmpDirectory());
   return distribute::CreateManager(config,
                                    /*worker_name=*/GenericWorker::kWorkerKey,
-                                   /*welcome_blob=*/welcome.SerializeAsString())
+                                   /*welcome_blob=*/welcome.SerializeAsString(),
+                                   parallel_execution_per_worker)
       .value();
 }
 
-TEST(TrainAndEvaluateModel, Base) {
-  auto manager = CreateSingleThreadManager();
-
+// Request to train a random forest on the adult dataset.
+proto::Request BuildTrainRequest() {
   proto::Request train_request;
-  {
-    auto& train_model = *train_request.mutable_train_model();
-    *train_model.mutable_train_config() = PARSE_TEST_PROTO(
-        R"pb(
-          learner: "RANDOM_FOREST"
-          label: "income"
-          [yggdrasil_decision_forests.model.random_forest.proto
-               .random_forest_config] {
-            winner_take_all_inference: false
-            num_trees: 50
-          }
-        )pb");
-    train_model.set_dataset_path(absl::StrCat(
-        "csv:", file::JoinPath(
-                    test::DataRootDirectory(),
-                    "yggdrasil_decision_forests/test_data/dataset/"
-                    "adult_train.csv")));
-
-    dataset::CreateDataSpec(train_model.dataset_path(), false, {},
-                            train_model.mutable_dataspec());
-    train_model.set_model_base_path(
-        file::JoinPath(test::TmpDirectory(), "my_model"));
-  }
+  auto& train_model = *train_request.mutable_train_model();
+  *train_model.mutable_train_config() = PARSE_TEST_PROTO(
+      R"pb(
+        learner: "RANDOM_FOREST"
+        label: "income"
+        [yggdrasil_decision_forests.model.random_forest.proto
+             .random_forest_config] {
+          winner_take_all_inference: false
+          num_trees: 50
+        }
+      )pb");
+  train_model.set_dataset_path(absl::StrCat(
+      "csv:", file::JoinPath(test::DataRootDirectory(),
+                             "yggdrasil_decision_forests/test_data/dataset/"
+                             "adult_train.csv")));
 
-  auto train_result =
-      manager->BlockingProtoRequest<proto::Result>(train_request).value();
+  dataset::CreateDataSpec(train_model.dataset_path(), false, {},
+                          train_model.mutable_dataspec());
+  train_model.set_model_base_path(
+      file::JoinPath(test::TmpDirectory(), "my_model"));
+  return train_request;
+}
 
+// Request to evaluate the model at "model_path" on the adult test dataset.
+proto::Request BuildEvaluateRequest(const std::string& model_path) {
   proto::Request evaluate_request;
-  {
-    auto& evaluate_model = *evaluate_request.mutable_evaluate_model();
-    evaluate_model.set_model_path(train_result.train_model().model_path());
-    evaluate_model.set_dataset_path(absl::StrCat(
-        "csv:", file::JoinPath(
-                    test::DataRootDirectory(),
-                    "yggdrasil_decision_forests/test_data/dataset/"
-                    "adult_test.csv")));
-  }
+  auto& evaluate_model = *evaluate_request.mutable_evaluate_model();
+  evaluate_model.set_model_path(model_path);
+  evaluate_model.set_dataset_path(absl::StrCat(
+      "csv:", file::JoinPath(test::DataRootDirectory(),
+                             "yggdrasil_decision_forests/test_data/dataset/"
+                             "adult_test.csv")));
+  return evaluate_request;
+}
 
+TEST(TrainAndEvaluateModel, Base) {
+  auto manager = CreateManager();
+
+  const auto train_request = BuildTrainRequest();
+  auto train_result =
+      manager->BlockingProtoRequest<proto::Result>(train_request).value();
+
+  const auto evaluate_request =
+      BuildEvaluateRequest(train_result.train_model().model_path());
   auto evaluate_result =
       manager->BlockingProtoRequest<proto::Result>(evaluate_request).value();
 
@@ -100,6 +111,33 @@ TEST(TrainAndEvaluateModel, Base) {
   EXPECT_OK(manager->Done());
 }
 
+// A single worker running two requests in parallel: the evaluation of a first
+// model overlaps the training of a second model.
+TEST(TrainAndEvaluateModel, OverlappingTrainAndEvaluate) {
+  auto manager =
+      CreateManager(/*num_workers=*/1, /*parallel_execution_per_worker=*/2);
+
+  const auto train_request = BuildTrainRequest();
+  auto first_train_result =
+      manager->BlockingProtoRequest<proto::Result>(train_request).value();
+
+  CHECK_OK(manager->AsynchronousProtoRequest(train_request));
+  CHECK_OK(manager->AsynchronousProtoRequest(
+      BuildEvaluateRequest(first_train_result.train_model().model_path())));
+
+  for (int result_idx = 0; result_idx < 2; result_idx++) {
+    const auto result =
+        manager->NextAsynchronousProtoAnswer<proto::Result>().value();
+    if (result.has_evaluate_model()) {
+      EXPECT_GE(metric::Accuracy(result.evaluate_model().evaluation()), 0.86);
+    } else {
+      EXPECT_TRUE(result.has_train_model());
+    }
+  }
+
+  EXPECT_OK(manager->Done());
+}
+
 }  // namespace
 }  // namespace generic_worker
 }  // namespace model
@@ -22,6 +22,7 @@
 #include <memory>
 #include <numeric>
 #include <random>
+#include <regex>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
@@ -30,6 +31,7 @@
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
@@ -57,12 +59,15 @@
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
 #include "yggdrasil_decision_forests/utils/adaptive_work.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/csv.h"
 #include "yggdrasil_decision_forests/utils/feature_importance.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/hyper_parameters.h"
+#include "yggdrasil_decision_forests/utils/instrument.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/random.h"
+#include "yggdrasil_decision_forests/utils/sharded_io_blob_sequence.h"
 #include "yggdrasil_decision_forests/utils/snapshot.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 #include "yggdrasil_decision_forests/utils/usage.h"
@@ -134,6 +139,10 @@ constexpr char kBaseHessianColumnName[] = "__hessian__";
 // Filename of the file containing the early stopping state in a checkpoint.
 constexpr char kEarlyStoppingCheckpoint[] = "early_stopping.pb";
 
+// Directory, inside of the training cache, containing the delta files of the
+// incremental checkpoints. See "internal::CreateTrainingCheckpoint".
+constexpr char kCheckpointDeltaDirectory[] = "checkpoint_deltas";
+
 // Name of the gradient column in the gradient dataset.
 std::string GradientColumnName(const int grad_idx) {
   return absl::StrCat(kBaseGradientColumnName, grad_idx);
@@ -222,7 +231,7 @@ std::vector<std::string> SampleTrainingShards(
 absl::Status FinalizeModelWithValidationDataset(
     const internal::AllTrainingConfiguration& config,
     const internal::EarlyStopping& early_stopping,
-    const dataset::VerticalDataset& validation_dataset,
+    const dataset::VerticalDataset& validation_dataset, const int num_threads,
     GradientBoostedTreesModel* mdl) {
   std::vector<float> final_secondary_metrics;
   if (config.gbt_config->early_stopping() ==
@@ -268,8 +277,8 @@ absl::Status FinalizeModelWithValidationDataset(
 
   if (config.gbt_config->compute_permutation_variable_importance()) {
     LOG(INFO) << "Compute permutation variable importances";
-    RETURN_IF_ERROR(
-        utils::ComputePermutationFeatureImportance(validation_dataset, mdl));
+    RETURN_IF_ERROR(utils::ComputePermutationFeatureImportance(
+        validation_dataset, mdl, /*num_rounds=*/1, num_threads));
   }
 
   return absl::OkStatus();
@@ -336,6 +345,82 @@ decision_tree::InternalTrainConfig BuildWeakLearnerInternalConfig(
   return internal_config;
 }
 
+// Grows the trees of one boosting iteration i.e. one tree per gradient
+// dimension. With a single tree per iteration, the tree is grown with the
+// shared random generator "random". With several trees per iteration (e.g.
+// multi-class classification), the trees only depend on the gradients
+// computed at the start of the iteration: they are grown concurrently, each
+// with its own random generator seeded from "random" (so the result does not
+// depend on the scheduling), and the splitter thread budget of the
+// deployment is divided between the concurrent trees.
+absl::Status GrowTreesOfIteration(
+    const internal::AllTrainingConfiguration& config,
+    const model::proto::DeploymentConfig& deployment,
+    const dataset::VerticalDataset& gradient_dataset,
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const std::vector<float>& weights,
+    const std::vector<GradientData>& gradients,
+    const std::vector<float>& predictions,
+    const decision_tree::Preprocessing* preprocessing,
+    const absl::Time& begin_training, utils::RandomEngine* random,
+    std::vector<std::unique_ptr<decision_tree::DecisionTree>>* new_trees) {
+  const int num_trees = gradients.size();
+  const int num_threads = deployment.num_threads();
+  new_trees->clear();
+  new_trees->reserve(num_trees);
+  for (int grad_idx = 0; grad_idx < num_trees; grad_idx++) {
+    new_trees->push_back(absl::make_unique<decision_tree::DecisionTree>());
+  }
+
+  if (num_trees == 1 || num_threads <= 1) {
+    for (int grad_idx = 0; grad_idx < num_trees; grad_idx++) {
+      auto internal_config = BuildWeakLearnerInternalConfig(
+          config, num_threads, grad_idx, gradients, predictions,
+          begin_training);
+      internal_config.preprocessing = preprocessing;
+      RETURN_IF_ERROR(decision_tree::Train(
+          gradient_dataset, selected_examples, gradients[grad_idx].config,
+          gradients[grad_idx].config_link, config.gbt_config->decision_tree(),
+          deployment, weights, random, (*new_trees)[grad_idx].get(),
+          internal_config));
+    }
+    return absl::OkStatus();
+  }
+
+  // Seeds of the per-tree random generators, drawn in a deterministic order.
+  std::vector<utils::RandomEngine::result_type> seeds(num_trees);
+  for (auto& seed : seeds) {
+    seed = (*random)();
+  }
+  const int num_concurrent_trees = std::min(num_trees, num_threads);
+  const int num_threads_per_tree =
+      std::max(1, num_threads / num_concurrent_trees);
+  std::vector<absl::Status> statuses(num_trees);
+  {
+    utils::concurrency::ThreadPool pool("GrowIterationTrees",
+                                        num_concurrent_trees);
+    pool.StartWorkers();
+    for (int grad_idx = 0; grad_idx < num_trees; grad_idx++) {
+      pool.Schedule([&, grad_idx]() {
+        auto internal_config = BuildWeakLearnerInternalConfig(
+            config, num_threads_per_tree, grad_idx, gradients, predictions,
+            begin_training);
+        internal_config.preprocessing = preprocessing;
+        utils::RandomEngine tree_random(seeds[grad_idx]);
+        statuses[grad_idx] = decision_tree::Train(
+            gradient_dataset, selected_examples, gradients[grad_idx].config,
+            gradients[grad_idx].config_link,
+            config.gbt_config->decision_tree(), deployment, weights,
+            &tree_random, (*new_trees)[grad_idx].get(), internal_config);
+      });
+    }
+  }
+  for (const auto& status : statuses) {
+    RETURN_IF_ERROR(status);
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 GradientBoostedTreesLearner::GradientBoostedTreesLearner(
@@ -658,6 +743,15 @@ GradientBoostedTreesLearner::ShardedSamplingTrain(
   // Note: The shard loaded in multi-threaded by the vertical dataset IO lib.
   std::unique_ptr<utils::concurrency::Thread> thread_load_next_shards;
 
+  // Thread pool used to parallelize the gradient computation at each boosting
+  // iteration. Only created if multi-threading is enabled.
+  std::unique_ptr<utils::concurrency::ThreadPool> loss_thread_pool;
+  if (deployment_.num_threads() > 1) {
+    loss_thread_pool = absl::make_unique<utils::concurrency::ThreadPool>(
+        "gbt_loss", deployment_.num_threads());
+    loss_thread_pool->StartWorkers();
+  }
+
   // Begin time of the training, excluding the model preparation. Used to
   // compute the IO bottle neck.
   const auto begin_training_loop = absl::Now();
@@ -810,30 +904,18 @@ GradientBoostedTreesLearner::ShardedSamplingTrain(
     RETURN_IF_ERROR(config.loss->UpdateGradients(
         current_train_dataset->gradient_dataset,
         config.train_config_link.label(), current_train_dataset->predictions,
-        nullptr, &current_train_dataset->gradients, &random));
+        nullptr, &current_train_dataset->gradients, &random,
+        loss_thread_pool.get()));
 
     // Train a tree on the gradient.
     DCHECK_EQ(current_train_dataset->predictions_from_num_trees,
               mdl->NumTrees());
     std::vector<std::unique_ptr<decision_tree::DecisionTree>> new_trees;
-    new_trees.reserve(mdl->num_trees_per_iter());
-    for (int grad_idx = 0; grad_idx < mdl->num_trees_per_iter(); grad_idx++) {
-      auto tree = absl::make_unique<decision_tree::DecisionTree>();
-
-      const auto internal_config = BuildWeakLearnerInternalConfig(
-          config, deployment().num_threads(), grad_idx,
-          current_train_dataset->gradients, current_train_dataset->predictions,
-          begin_training);
-
-      RETURN_IF_ERROR(decision_tree::Train(
-          current_train_dataset->gradient_dataset, selected_examples,
-          current_train_dataset->gradients[grad_idx].config,
-          current_train_dataset->gradients[grad_idx].config_link,
-          config.gbt_config->decision_tree(), deployment(),
-          current_train_dataset->weights, &random, tree.get(),
-          internal_config));
-      new_trees.push_back(std::move(tree));
-    }
+    RETURN_IF_ERROR(GrowTreesOfIteration(
+        config, deployment(), current_train_dataset->gradient_dataset,
+        selected_examples, current_train_dataset->weights,
+        current_train_dataset->gradients, current_train_dataset->predictions,
+        /*preprocessing=*/nullptr, begin_training, &random, &new_trees));
 
     if (has_validation_dataset) {
       // Update the predictions on the validation dataset.
@@ -868,7 +950,7 @@ GradientBoostedTreesLearner::ShardedSamplingTrain(
           current_train_dataset->gradient_dataset,
           config.train_config_link.label(), current_train_dataset->predictions,
           current_train_dataset->weights, nullptr, &training_loss,
-          &train_secondary_metrics));
+          &train_secondary_metrics, loss_thread_pool.get()));
 
       auto* log_entry = mdl->training_logs_.mutable_entries()->Add();
       log_entry->set_number_of_trees(iter_idx + 1);
@@ -895,7 +977,8 @@ GradientBoostedTreesLearner::ShardedSamplingTrain(
         RETURN_IF_ERROR(config.loss->Loss(
             validation->gradient_dataset, config.train_config_link.label(),
             validation->predictions, validation->weights, nullptr,
-            &validation_loss, &validation_secondary_metrics));
+            &validation_loss, &validation_secondary_metrics,
+            loss_thread_pool.get()));
         log_entry->set_validation_loss(validation_loss);
         *log_entry->mutable_validation_secondary_metrics() = {
             validation_secondary_metrics.begin(),
@@ -962,7 +1045,8 @@ GradientBoostedTreesLearner::ShardedSamplingTrain(
 
   if (has_validation_dataset) {
     RETURN_IF_ERROR(FinalizeModelWithValidationDataset(
-        config, early_stopping, validation->dataset, mdl.get()));
+        config, early_stopping, validation->dataset,
+        deployment().num_threads(), mdl.get()));
   }
 
   RETURN_IF_ERROR(FinalizeModel(log_directory_, mdl.get()));
@@ -1089,6 +1173,16 @@ GradientBoostedTreesLearner::TrainWithStatus(
       &gradient_validation_dataset,
       /*gradients=*/nullptr, &validation_predictions));
 
+  // Report the resident memory once the gradient storage is allocated. Used
+  // for capacity planning.
+  utils::usage::OnTrainingPhaseMemory("gradient_boosted_trees.gradient_storage",
+                                      utils::instrument::PeakRSSBytes());
+
+  // Updates "validation_predictions" with the trees of the last iteration on
+  // a background thread, overlapping the update with the training loss
+  // computation and the start of the next iteration.
+  internal::BackgroundValidationUpdater validation_updater;
+
   // Training configuration for individual trees i.e. to predict the gradient.
   ConfigureTrainingConfigForGradients(
       config.train_config, config.train_config_link, SubTask(mdl->loss()),
@@ -1166,12 +1260,40 @@ GradientBoostedTreesLearner::TrainWithStatus(
         "Loss does not support hessian optimization");
   }
 
-  ASSIGN_OR_RETURN(
-      const auto preprocessing,
-      decision_tree::PreprocessTrainingDataset(
-          gradient_sub_train_dataset, config.train_config,
-          config.train_config_link, config.gbt_config->decision_tree(),
-          deployment_.num_threads()));
+  // Pre-sorted numerical feature index, shared by all the trees. If the user
+  // injected a pre-computed index (e.g. to share it among the trials of a
+  // hyper-parameter sweep), use it instead of re-computing it.
+  std::shared_ptr<const decision_tree::Preprocessing> preprocessing =
+      shared_preprocessing();
+  if (preprocessing != nullptr) {
+    if (preprocessing->num_examples() !=
+        static_cast<uint64_t>(gradient_sub_train_dataset.nrow())) {
+      return absl::InvalidArgumentError(
+          "The pre-computed preprocessing was computed on a dataset with a "
+          "different number of examples than the effective training dataset. "
+          "If the validation dataset is extracted from the training dataset "
+          "(i.e. \"validation_set_ratio\" > 0 and no validation dataset is "
+          "provided), the preprocessing cannot be shared.");
+    }
+  } else {
+    ASSIGN_OR_RETURN(
+        auto owned_preprocessing,
+        decision_tree::PreprocessTrainingDataset(
+            gradient_sub_train_dataset, config.train_config,
+            config.train_config_link, config.gbt_config->decision_tree(),
+            deployment_.num_threads()));
+    preprocessing = std::make_shared<const decision_tree::Preprocessing>(
+        std::move(owned_preprocessing));
+  }
+
+  // Thread pool used to parallelize the gradient computation at each boosting
+  // iteration. Only created if multi-threading is enabled.
+  std::unique_ptr<utils::concurrency::ThreadPool> loss_thread_pool;
+  if (deployment_.num_threads() > 1) {
+    loss_thread_pool = absl::make_unique<utils::concurrency::ThreadPool>(
+        "gbt_loss", deployment_.num_threads());
+    loss_thread_pool->StartWorkers();
+  }
 
   // Time of the next snapshot if training resume is enabled.
   auto next_snapshot =
@@ -1182,6 +1304,16 @@ GradientBoostedTreesLearner::TrainWithStatus(
   // Empty if resuming training is disabled.
   std::string snapshot_directory;
 
+  // Number of trees already persisted by checkpoints (full model saves and
+  // delta files), and number of trees in the last full model save. See
+  // "internal::CreateTrainingCheckpoint".
+  int num_persisted_trees = 0;
+  int num_full_save_trees = 0;
+
+  // Writes the periodic checkpoints in the background so the tree growth does
+  // not stall on the checkpoint writes.
+  internal::BackgroundCheckpointer checkpointer;
+
   // Try to resume training.
   int iter_idx = 0;
   if (deployment_.try_resume_training()) {
@@ -1197,19 +1329,14 @@ GradientBoostedTreesLearner::TrainWithStatus(
       // Load the snapshot.
       LOG(INFO) << "Resume the GBT training from iteration #"
                 << snapshot_idx_or.value();
-      const auto model_path =
-          file::JoinPath(deployment_.cache_path(),
-                         absl::StrCat("model_", snapshot_idx_or.value()));
-      // Load the model structure.
-      RETURN_IF_ERROR(
-          mdl->Load(model_path, /*io_options=*/{/*file_prefix=*/""}));
-      iter_idx = mdl->NumTrees() / mdl->num_trees_per_iter();
-
-      // Load the state of the early stopping state manager.
+      // Load the model structure and the state of the early stopping state
+      // manager.
       proto::EarlyStoppingSnapshot early_stopping_snapshot;
-      RETURN_IF_ERROR(file::GetBinaryProto(
-          file::JoinPath(model_path, kEarlyStoppingCheckpoint),
-          &early_stopping_snapshot, file::Defaults()));
+      RETURN_IF_ERROR(internal::RestoreTrainingCheckpoint(
+          snapshot_idx_or.value(), deployment_.cache_path(), mdl.get(),
+          &early_stopping_snapshot, &num_persisted_trees,
+          &num_full_save_trees));
+      iter_idx = mdl->NumTrees() / mdl->num_trees_per_iter();
       RETURN_IF_ERROR(early_stopping.Load(early_stopping_snapshot));
 
       // Recompute the prediction caches.
@@ -1233,6 +1360,72 @@ GradientBoostedTreesLearner::TrainWithStatus(
     }
   }
 
+  // Warm start: continue the boosting from a pre-trained model (unless a
+  // snapshot of an interrupted training was found above; the snapshot already
+  // contains the warm-start trees).
+  if (iter_idx == 0 && !warm_start_model_directory_.empty()) {
+    LOG(INFO) << "Warm-starting the GBT training from the model in "
+              << warm_start_model_directory_;
+    // Expected characteristics of the warm-start model.
+    const auto expected_task = mdl->task();
+    const auto expected_loss = mdl->loss();
+    const int expected_num_trees_per_iter = mdl->num_trees_per_iter();
+    const auto current_data_spec = mdl->data_spec();
+
+    RETURN_IF_ERROR(mdl->Load(warm_start_model_directory_,
+                              /*io_options=*/{/*file_prefix=*/""}));
+
+    if (mdl->task() != expected_task || mdl->loss() != expected_loss ||
+        mdl->num_trees_per_iter() != expected_num_trees_per_iter) {
+      return absl::InvalidArgumentError(
+          "The warm-start model is not compatible with the training "
+          "configuration: the task, the loss and the number of trees per "
+          "iteration should match.");
+    }
+    if (mdl->data_spec().columns_size() != current_data_spec.columns_size()) {
+      return absl::InvalidArgumentError(
+          "The warm-start model is not compatible with the training dataset: "
+          "different number of columns.");
+    }
+    for (int col_idx = 0; col_idx < current_data_spec.columns_size();
+         col_idx++) {
+      const auto& warm_column = mdl->data_spec().columns(col_idx);
+      const auto& column = current_data_spec.columns(col_idx);
+      if (warm_column.name() != column.name() ||
+          warm_column.type() != column.type()) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "The warm-start model is not compatible with the training "
+            "dataset: column \"",
+            column.name(), "\" differs."));
+      }
+    }
+    // The conditions of the warm-start model are interpreted with the dataspec
+    // of the new training dataset. See "set_warm_start_model_directory" for
+    // the requirements on the dataspec.
+    mdl->set_data_spec(current_data_spec);
+
+    iter_idx = mdl->NumTrees() / mdl->num_trees_per_iter();
+
+    // Recompute the prediction caches on the new training dataset.
+    const auto time_begin_recompute_accumulators = absl::Now();
+    mdl->set_output_logits(true);
+    ASSIGN_OR_RETURN(auto engine, mdl->BuildFastEngine());
+    mdl->set_output_logits(false);
+
+    RETURN_IF_ERROR(internal::ComputePredictions(
+        mdl.get(), engine.get(), {}, config, gradient_sub_train_dataset,
+        &sub_train_predictions));
+
+    if (has_validation_dataset) {
+      RETURN_IF_ERROR(internal::ComputePredictions(
+          mdl.get(), engine.get(), {}, config, gradient_validation_dataset,
+          &validation_predictions));
+    }
+    LOG(INFO) << "Re-compute the prediction accumulators in "
+              << absl::FormatDuration(absl::Now() -
+                                      time_begin_recompute_accumulators);
+  }
+
   // Train the trees one by one.
   std::vector<UnsignedExampleIdx> selected_examples;
 
@@ -1262,7 +1455,8 @@ GradientBoostedTreesLearner::TrainWithStatus(
     // Compute the gradient of the residual relative to the examples.
     RETURN_IF_ERROR(config.loss->UpdateGradients(
         gradient_sub_train_dataset, config.train_config_link.label(),
-        sub_train_predictions, train_ranking_index.get(), &gradients, &random));
+        sub_train_predictions, train_ranking_index.get(), &gradients, &random,
+        loss_thread_pool.get()));
 
     float subsample_factor = 1.f;
     // Select a random set of examples (without replacement).
@@ -1306,22 +1500,10 @@ GradientBoostedTreesLearner::TrainWithStatus(
 
     // Train a tree on the gradient.
     std::vector<std::unique_ptr<decision_tree::DecisionTree>> new_trees;
-    new_trees.reserve(gradients.size());
-    for (int grad_idx = 0; grad_idx < gradients.size(); grad_idx++) {
-      auto tree = absl::make_unique<decision_tree::DecisionTree>();
-
-      auto internal_config = BuildWeakLearnerInternalConfig(
-          config, deployment().num_threads(), grad_idx, gradients,
-          sub_train_predictions, begin_training);
-      internal_config.preprocessing = &preprocessing;
-
-      RETURN_IF_ERROR(decision_tree::Train(
-          gradient_sub_train_dataset, selected_examples,
-          gradients[grad_idx].config, gradients[grad_idx].config_link,
-          config.gbt_config->decision_tree(), deployment(), *tree_weights,
-          &random, tree.get(), internal_config));
-      new_trees.push_back(std::move(tree));
-    }
+    RETURN_IF_ERROR(GrowTreesOfIteration(
+        config, deployment(), gradient_sub_train_dataset, selected_examples,
+        *tree_weights, gradients, sub_train_predictions, preprocessing.get(),
+        begin_training, &random, &new_trees));
 
     // Note: Since the batch size is only impacting the training time (i.e.
     // not the update prediction time), and since the adaptive work manager
@@ -1357,11 +1539,12 @@ GradientBoostedTreesLearner::TrainWithStatus(
           &sub_train_predictions, &mean_abs_prediction));
 
       if (has_validation_dataset) {
-        // Update the predictions on the validation dataset.
-        RETURN_IF_ERROR(config.loss->UpdatePredictions(
-            RemoveUniquePtr(new_trees), gradient_validation_dataset,
-            &validation_predictions,
-            /*mean_abs_prediction=*/nullptr));
+        // Update the predictions on the validation dataset in the background.
+        // The new trees are about to be moved into the model, which does not
+        // invalidate them.
+        RETURN_IF_ERROR(validation_updater.Start(
+            *config.loss, RemoveUniquePtr(new_trees),
+            gradient_validation_dataset, &validation_predictions));
       }
     }
 
@@ -1377,7 +1560,7 @@ GradientBoostedTreesLearner::TrainWithStatus(
       RETURN_IF_ERROR(config.loss->Loss(
           gradient_sub_train_dataset, config.train_config_link.label(),
           sub_train_predictions, weights, train_ranking_index.get(),
-          &training_loss, &train_secondary_metrics));
+          &training_loss, &train_secondary_metrics, loss_thread_pool.get()));
 
       auto* log_entry = training_logs.mutable_entries()->Add();
       log_entry->set_number_of_trees(iter_idx + 1);
@@ -1404,13 +1587,16 @@ GradientBoostedTreesLearner::TrainWithStatus(
       }
 
       if (has_validation_dataset) {
+        // Wait for the predictions on the validation dataset to be
+        // up-to-date.
+        RETURN_IF_ERROR(validation_updater.Join());
         float validation_loss;
         std::vector<float> validation_secondary_metrics;
         RETURN_IF_ERROR(config.loss->Loss(
             gradient_validation_dataset, config.train_config_link.label(),
             validation_predictions, validation_weights,
             valid_ranking_index.get(), &validation_loss,
-            &validation_secondary_metrics));
+            &validation_secondary_metrics, loss_thread_pool.get()));
         log_entry->set_validation_loss(validation_loss);
         *log_entry->mutable_validation_secondary_metrics() = {
             validation_secondary_metrics.begin(),
@@ -1465,20 +1651,12 @@ GradientBoostedTreesLearner::TrainWithStatus(
     // Export a snapshot
     if (deployment_.try_resume_training() && next_snapshot < absl::Now()) {
       LOG(INFO) << "Create a snapshot of the model at iteration " << iter_idx;
-      const auto model_path = file::JoinPath(deployment_.cache_path(),
-                                             absl::StrCat("model_", iter_idx));
-
-      // Save the model structure.
-      RETURN_IF_ERROR(
-          mdl->Save(model_path, /*io_options=*/{/*file_prefix=*/""}));
 
-      // Save the early stopping manager state.
-      RETURN_IF_ERROR(file::SetBinaryProto(
-          file::JoinPath(model_path, kEarlyStoppingCheckpoint),
-          early_stopping.Save(), file::Defaults()));
-
-      // Record the snapshot.
-      RETURN_IF_ERROR(utils::AddSnapshot(snapshot_directory, iter_idx));
+      // Save, in the background, the trees created since the previous
+      // checkpoint, and occasionally the full model.
+      RETURN_IF_ERROR(checkpointer.MaybeCreateCheckpoint(
+          *mdl, early_stopping.Save(), iter_idx, deployment_.cache_path(),
+          snapshot_directory, &num_persisted_trees, &num_full_save_trees));
 
       next_snapshot =
           absl::Now() +
@@ -1489,30 +1667,26 @@ GradientBoostedTreesLearner::TrainWithStatus(
 
   // Create a final snapshot
   if (deployment_.try_resume_training()) {
+    // Wait for the pending background checkpoint (if any). Past this point,
+    // the model can be modified (e.g. truncated by the early stopping or
+    // scaled by Dart).
+    RETURN_IF_ERROR(checkpointer.Join());
     const auto last_snapshot = utils::GetGreatestSnapshot(snapshot_directory);
     if (!last_snapshot.ok() || last_snapshot.value() < iter_idx) {
       LOG(INFO) << "Create final snapshot of the model at iteration "
                 << iter_idx;
-      const auto model_path = file::JoinPath(deployment_.cache_path(),
-                                             absl::StrCat("model_", iter_idx));
-
-      // Save the model structure.
-      RETURN_IF_ERROR(
-          mdl->Save(model_path, /*io_options=*/{/*file_prefix=*/""}));
-
-      // Save the early stopping manager state.
-      RETURN_IF_ERROR(file::SetBinaryProto(
-          file::JoinPath(model_path, kEarlyStoppingCheckpoint),
-          early_stopping.Save(), file::Defaults()));
-
-      // Record the snapshot.
-      RETURN_IF_ERROR(utils::AddSnapshot(snapshot_directory, iter_idx));
+      RETURN_IF_ERROR(internal::CreateTrainingCheckpoint(
+          *mdl, early_stopping.Save(), iter_idx, deployment_.cache_path(),
+          snapshot_directory, &num_persisted_trees, &num_full_save_trees));
     }
   }
 
   if (has_validation_dataset) {
+    // Wait for the last background validation update (if any).
+    RETURN_IF_ERROR(validation_updater.Join());
     RETURN_IF_ERROR(FinalizeModelWithValidationDataset(
-        config, early_stopping, validation_dataset, mdl.get()));
+        config, early_stopping, validation_dataset, deployment().num_threads(),
+        mdl.get()));
   }
 
   if (dart_extraction) {
@@ -2374,6 +2548,7 @@ absl::Status ExtractValidationDataset(const VerticalDataset& dataset,
                                       VerticalDataset* train,
                                       VerticalDataset* validation,
                                       utils::RandomEngine* random) {
+  YDF_INSTRUMENT_MEMORY_PHASE("gradient_boosted_trees.extract_validation");
   if (validation_set_ratio < 0.f || validation_set_ratio > 1.f) {
     return absl::InvalidArgumentError(
         "The validation set ratio should be in [0,1].");
@@ -2466,6 +2641,7 @@ absl::Status CreateGradientDataset(const dataset::VerticalDataset& dataset,
                                    dataset::VerticalDataset* gradient_dataset,
                                    std::vector<GradientData>* gradients,
                                    std::vector<float>* predictions) {
+  YDF_INSTRUMENT_MEMORY_PHASE("gradient_boosted_trees.gradient_storage");
   const auto loss_shape = loss_impl.Shape();
   *gradient_dataset = dataset.ShallowNonOwningClone();
 
@@ -2585,6 +2761,10 @@ void SampleTrainingExamples(
   }
 
   selected_examples->clear();
+  // Pre-allocate the expected number of samples. The buffer is reused across
+  // the boosting iterations, so at most a few re-allocations happen during
+  // the whole training.
+  selected_examples->reserve(static_cast<size_t>(num_rows * sample));
   std::uniform_real_distribution<float> unif_dist_unit;
   for (UnsignedExampleIdx example_idx = 0; example_idx < num_rows;
        example_idx++) {
@@ -2625,7 +2805,11 @@ void SampleTrainingExamplesWithGoss(
   // Add examples with a large gradient to the set of selected examples.
   selected_examples->clear();
 
-  int cutoff = std::ceil(alpha * num_rows);
+  const auto cutoff = static_cast<UnsignedExampleIdx>(
+      std::ceil(static_cast<double>(alpha) * num_rows));
+  selected_examples->reserve(
+      cutoff + static_cast<UnsignedExampleIdx>(
+                   static_cast<double>(beta) * (num_rows - cutoff)));
   for (UnsignedExampleIdx idx = 0; idx < cutoff; idx++) {
     selected_examples->push_back(l1_norm[idx].first);
   }
@@ -2736,6 +2920,262 @@ absl::Status ExportTrainingLogs(const proto::TrainingLogs& training_logs,
   return absl::OkStatus();
 }
 
+absl::Status CreateTrainingCheckpoint(
+    const GradientBoostedTreesModel& mdl,
+    const proto::EarlyStoppingSnapshot& early_stopping, const int iter_idx,
+    const absl::string_view cache_path,
+    const absl::string_view snapshot_directory, int* num_persisted_trees,
+    int* num_full_save_trees) {
+  const auto snapshot =
+      BuildCheckpointSnapshot(mdl, early_stopping, iter_idx,
+                              num_persisted_trees, num_full_save_trees);
+  return WriteTrainingCheckpoint(snapshot, cache_path, snapshot_directory);
+}
+
+CheckpointSnapshot BuildCheckpointSnapshot(
+    const GradientBoostedTreesModel& mdl,
+    const proto::EarlyStoppingSnapshot& early_stopping, const int iter_idx,
+    int* num_persisted_trees, int* num_full_save_trees) {
+  CheckpointSnapshot snapshot;
+  const int num_trees = mdl.NumTrees();
+  snapshot.iter_idx = iter_idx;
+  snapshot.early_stopping = early_stopping;
+  // A full model save is only triggered ("compaction") when the delta files
+  // accumulated since the last full save contain more trees than the full
+  // save itself: the cost of the full saves is amortized over the training
+  // while the number of delta files to replay when resuming remains small.
+  snapshot.full_save =
+      *num_full_save_trees == 0 ||
+      num_trees - *num_full_save_trees > *num_full_save_trees;
+  snapshot.begin_tree_idx = snapshot.full_save ? 0 : *num_persisted_trees;
+  snapshot.trees.reserve(num_trees);
+  for (int tree_idx = 0; tree_idx < num_trees; tree_idx++) {
+    snapshot.trees.push_back(mdl.decision_trees()[tree_idx].get());
+  }
+  if (snapshot.full_save) {
+    snapshot.header = mdl.BuildHeader();
+    *num_full_save_trees = num_trees;
+  }
+  *num_persisted_trees = num_trees;
+  return snapshot;
+}
+
+absl::Status WriteTrainingCheckpoint(
+    const CheckpointSnapshot& snapshot, const absl::string_view cache_path,
+    const absl::string_view snapshot_directory) {
+  const int num_trees = snapshot.trees.size();
+  if (snapshot.full_save) {
+    // Save the full model.
+    const auto model_path =
+        file::JoinPath(cache_path, absl::StrCat("model_", snapshot.iter_idx));
+    RETURN_IF_ERROR(GradientBoostedTreesModel::SaveView(
+        snapshot.header, snapshot.trees, model_path,
+        /*io_options=*/{/*file_prefix=*/""}));
+    RETURN_IF_ERROR(file::SetBinaryProto(
+        file::JoinPath(model_path, kEarlyStoppingCheckpoint),
+        snapshot.early_stopping, file::Defaults()));
+  } else {
+    // Only save the trees created since the previous checkpoint.
+    const auto delta_directory =
+        file::JoinPath(cache_path, kCheckpointDeltaDirectory);
+    RETURN_IF_ERROR(
+        file::RecursivelyCreateDir(delta_directory, file::Defaults()));
+    utils::BlobSequenceShardedWriter<decision_tree::proto::Node> node_writer;
+    RETURN_IF_ERROR(node_writer.Open(
+        file::JoinPath(delta_directory,
+                       absl::StrCat("trees_", snapshot.begin_tree_idx, "_",
+                                    num_trees)),
+        /*num_records_by_shard=*/-1));
+    for (int tree_idx = snapshot.begin_tree_idx; tree_idx < num_trees;
+         tree_idx++) {
+      RETURN_IF_ERROR(snapshot.trees[tree_idx]->WriteNodes(&node_writer));
+    }
+    RETURN_IF_ERROR(node_writer.CloseWithStatus());
+
+    proto::IncrementalCheckpoint checkpoint;
+    checkpoint.set_num_trees(num_trees);
+    *checkpoint.mutable_early_stopping() = snapshot.early_stopping;
+    RETURN_IF_ERROR(file::SetBinaryProto(
+        file::JoinPath(delta_directory,
+                       absl::StrCat("checkpoint_", snapshot.iter_idx, ".pb")),
+        checkpoint, file::Defaults()));
+  }
+  // The snapshot record is written last: a checkpoint interrupted at any of
+  // the steps above is simply ignored when the training resumes.
+  return utils::AddSnapshot(snapshot_directory, snapshot.iter_idx);
+}
+
+BackgroundCheckpointer::~BackgroundCheckpointer() { Join().IgnoreError(); }
+
+absl::Status BackgroundCheckpointer::MaybeCreateCheckpoint(
+    const GradientBoostedTreesModel& mdl,
+    const proto::EarlyStoppingSnapshot& early_stopping, const int iter_idx,
+    const absl::string_view cache_path,
+    const absl::string_view snapshot_directory, int* num_persisted_trees,
+    int* num_full_save_trees) {
+  if (running_) {
+    // The previous checkpoint is still being written: skip this request. The
+    // trees created since "num_persisted_trees" will be covered by the next
+    // accepted request.
+    LOG(INFO) << "Skipping the checkpoint at iteration " << iter_idx
+              << ": the previous checkpoint is still being written.";
+    return absl::OkStatus();
+  }
+  // Collect the status of the finished checkpoint write (if any).
+  RETURN_IF_ERROR(Join());
+
+  auto snapshot =
+      BuildCheckpointSnapshot(mdl, early_stopping, iter_idx,
+                              num_persisted_trees, num_full_save_trees);
+  const std::string cache_path_copy(cache_path);
+  const std::string snapshot_directory_copy(snapshot_directory);
+  running_ = true;
+  worker_ = absl::make_unique<utils::concurrency::Thread>(
+      [this, snapshot, cache_path_copy, snapshot_directory_copy]() {
+        status_ = WriteTrainingCheckpoint(snapshot, cache_path_copy,
+                                          snapshot_directory_copy);
+        running_ = false;
+      });
+  return absl::OkStatus();
+}
+
+absl::Status BackgroundCheckpointer::Join() {
+  if (worker_) {
+    worker_->Join();
+    worker_.reset();
+  }
+  return status_;
+}
+
+BackgroundValidationUpdater::~BackgroundValidationUpdater() {
+  Join().IgnoreError();
+}
+
+absl::Status BackgroundValidationUpdater::Start(
+    const AbstractLoss& loss,
+    std::vector<const decision_tree::DecisionTree*> trees,
+    const dataset::VerticalDataset& validation_dataset,
+    std::vector<float>* validation_predictions) {
+  // Collect the status of the finished update (if any).
+  RETURN_IF_ERROR(Join());
+
+  worker_ = absl::make_unique<utils::concurrency::Thread>(
+      [this, &loss, trees, &validation_dataset, validation_predictions]() {
+        status_ =
+            loss.UpdatePredictions(trees, validation_dataset,
+                                   validation_predictions,
+                                   /*mean_abs_prediction=*/nullptr);
+      });
+  return absl::OkStatus();
+}
+
+absl::Status BackgroundValidationUpdater::Join() {
+  if (worker_) {
+    worker_->Join();
+    worker_.reset();
+  }
+  return status_;
+}
+
+absl::Status RestoreTrainingCheckpoint(
+    const int snapshot_idx, const absl::string_view cache_path,
+    GradientBoostedTreesModel* mdl,
+    proto::EarlyStoppingSnapshot* early_stopping, int* num_persisted_trees,
+    int* num_full_save_trees) {
+  // Find the most recent full model save at or before "snapshot_idx".
+  std::vector<std::string> full_save_paths;
+  RETURN_IF_ERROR(file::Match(file::JoinPath(cache_path, "model_*"),
+                              &full_save_paths, file::Defaults()));
+  int full_save_idx = -1;
+  const std::regex full_save_pattern(".*model_([0-9]+)");
+  for (const auto& path : full_save_paths) {
+    std::smatch match;
+    int index;
+    if (std::regex_match(path, match, full_save_pattern) &&
+        absl::SimpleAtoi(match[1].str(), &index) && index <= snapshot_idx) {
+      full_save_idx = std::max(full_save_idx, index);
+    }
+  }
+  if (full_save_idx == -1) {
+    return absl::NotFoundError(absl::StrCat(
+        "No model checkpoint found for the snapshot #", snapshot_idx));
+  }
+  const auto model_path =
+      file::JoinPath(cache_path, absl::StrCat("model_", full_save_idx));
+  RETURN_IF_ERROR(mdl->Load(model_path, /*io_options=*/{/*file_prefix=*/""}));
+  *num_full_save_trees = mdl->NumTrees();
+
+  if (full_save_idx == snapshot_idx) {
+    // The snapshot is a full model save.
+    RETURN_IF_ERROR(file::GetBinaryProto(
+        file::JoinPath(model_path, kEarlyStoppingCheckpoint), early_stopping,
+        file::Defaults()));
+    *num_persisted_trees = mdl->NumTrees();
+    return absl::OkStatus();
+  }
+
+  // The snapshot is a delta checkpoint: replay the trees created since the
+  // full save.
+  const auto delta_directory =
+      file::JoinPath(cache_path, kCheckpointDeltaDirectory);
+  proto::IncrementalCheckpoint checkpoint;
+  RETURN_IF_ERROR(file::GetBinaryProto(
+      file::JoinPath(delta_directory,
+                     absl::StrCat("checkpoint_", snapshot_idx, ".pb")),
+      &checkpoint, file::Defaults()));
+
+  // Tree index range [begin, end) covered by each delta file.
+  struct Delta {
+    int begin;
+    int end;
+    std::string path;
+  };
+  std::vector<std::string> delta_paths;
+  RETURN_IF_ERROR(file::Match(file::JoinPath(delta_directory, "trees_*"),
+                              &delta_paths, file::Defaults()));
+  std::vector<Delta> deltas;
+  const std::regex delta_pattern(".*trees_([0-9]+)_([0-9]+)");
+  for (const auto& path : delta_paths) {
+    std::smatch match;
+    Delta delta;
+    if (std::regex_match(path, match, delta_pattern) &&
+        absl::SimpleAtoi(match[1].str(), &delta.begin) &&
+        absl::SimpleAtoi(match[2].str(), &delta.end)) {
+      delta.path = path;
+      deltas.push_back(std::move(delta));
+    }
+  }
+  std::sort(deltas.begin(), deltas.end(),
+            [](const Delta& a, const Delta& b) { return a.begin < b.begin; });
+
+  for (const auto& delta : deltas) {
+    // Skip the delta files from before the full save as well as the delta
+    // files written after the snapshot record (e.g. by an interrupted
+    // checkpoint).
+    if (delta.begin != static_cast<int>(mdl->NumTrees()) ||
+        delta.end > checkpoint.num_trees()) {
+      continue;
+    }
+    utils::BlobSequenceShardedReader<decision_tree::proto::Node> node_reader;
+    RETURN_IF_ERROR(node_reader.Open(delta.path));
+    for (int tree_idx = delta.begin; tree_idx < delta.end; tree_idx++) {
+      auto tree = absl::make_unique<decision_tree::DecisionTree>();
+      RETURN_IF_ERROR(tree->ReadNodes(&node_reader));
+      tree->SetLeafIndices();
+      mdl->mutable_decision_trees()->push_back(std::move(tree));
+    }
+  }
+  if (static_cast<int>(mdl->NumTrees()) != checkpoint.num_trees()) {
+    return absl::InternalError(absl::StrCat(
+        "Incomplete checkpoint for the snapshot #", snapshot_idx,
+        ": expecting ", checkpoint.num_trees(), " trees, found ",
+        mdl->NumTrees()));
+  }
+  *early_stopping = checkpoint.early_stopping();
+  *num_persisted_trees = mdl->NumTrees();
+  return absl::OkStatus();
+}
+
 void InitializeModelWithTrainingConfig(
     const model::proto::TrainingConfig& training_config,
     const model::proto::TrainingConfigLinking& training_config_linking,
@@ -43,8 +43,11 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_LEARNER_GRADIENT_BOOSTED_TREES_H_
 #define YGGDRASIL_DECISION_FORESTS_LEARNER_GRADIENT_BOOSTED_TREES_H_
 
+#include <atomic>
 #include <memory>
 #include <random>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
@@ -61,11 +64,17 @@
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/hyper_parameters.h"
 #include "yggdrasil_decision_forests/utils/random.h"
 
 namespace yggdrasil_decision_forests {
 namespace model {
+
+namespace decision_tree {
+class Preprocessing;
+}
+
 namespace gradient_boosted_trees {
 
 namespace internal {
@@ -163,6 +172,48 @@ class GradientBoostedTreesLearner : public AbstractLearner {
     return capabilities;
   }
 
+  // Sets a pre-computed pre-sorted numerical feature index to use in place of
+  // the one computed at the start of training. The preprocessing is immutable
+  // and can be shared by multiple learners and trainings e.g. the trials of a
+  // hyper-parameter sweep on a fixed dataset.
+  //
+  // The preprocessing should be computed with
+  // "decision_tree::PreprocessTrainingDataset" on the same dataset (same
+  // examples, in the same order) the trees are trained on. If the validation
+  // dataset is extracted from the training dataset (i.e.
+  // "validation_set_ratio" > 0 and no validation dataset is provided by the
+  // caller), the trees are trained on a random subset of the training dataset
+  // and the preprocessing cannot be shared.
+  void set_shared_preprocessing(
+      std::shared_ptr<const decision_tree::Preprocessing> preprocessing) {
+    shared_preprocessing_ = std::move(preprocessing);
+  }
+
+  const std::shared_ptr<const decision_tree::Preprocessing>&
+  shared_preprocessing() const {
+    return shared_preprocessing_;
+  }
+
+  // Sets the directory of a trained GBT model from which to resume the
+  // boosting ("warm start") e.g. to continue the training of yesterday's model
+  // on today's dataset. The trees of the warm-start model count toward
+  // "num_trees", and the prediction caches are re-computed on the new training
+  // dataset before the boosting loop resumes.
+  //
+  // The warm-start model should have the same task, loss and number of trees
+  // per iteration as the training configuration, and the columns of the new
+  // training dataset should match the columns of the dataset the model was
+  // trained on (same names, types and, for categorical columns, consistent
+  // dictionaries; e.g. by creating the dataspec of the new dataset with the
+  // dataspec of the old one as a guide).
+  void set_warm_start_model_directory(std::string directory) {
+    warm_start_model_directory_ = std::move(directory);
+  }
+
+  const std::string& warm_start_model_directory() const {
+    return warm_start_model_directory_;
+  }
+
  private:
   // Generates, checks and groups all the configuration objects.
   absl::Status BuildAllTrainingConfiguration(
@@ -179,6 +230,14 @@ class GradientBoostedTreesLearner : public AbstractLearner {
       const absl::string_view typed_path,
       const dataset::proto::DataSpecification& data_spec,
       const absl::optional<std::string>& typed_valid_path) const;
+
+  // User-injected pre-sorted numerical feature index. If null, the index is
+  // computed at the start of training. See "set_shared_preprocessing".
+  std::shared_ptr<const decision_tree::Preprocessing> shared_preprocessing_;
+
+  // Directory of a trained model from which to resume the boosting. If empty,
+  // the training starts from scratch. See "set_warm_start_model_directory".
+  std::string warm_start_model_directory_;
 };
 
 REGISTER_AbstractLearner(GradientBoostedTreesLearner,
@@ -268,6 +327,141 @@ absl::Status SampleTrainingExamplesWithSelGB(
 absl::Status ExportTrainingLogs(const proto::TrainingLogs& training_logs,
                                 absl::string_view directory);
 
+// Creates a training checkpoint at the end of the iteration "iter_idx".
+//
+// Since boosting only appends trees, the full model is only re-saved when the
+// trees accumulated in delta files since the last full save outnumber the
+// trees of that full save ("compaction"). Otherwise, the checkpoint only
+// writes the trees created since the previous checkpoint into a small delta
+// file: the checkpoint cost is proportional to the training progress since
+// the last checkpoint instead of the size of the model.
+//
+// "num_persisted_trees" and "num_full_save_trees" are respectively the number
+// of trees already persisted (full save + delta files) and the number of
+// trees in the last full save. Both should be initialized to zero (or by
+// "RestoreTrainingCheckpoint") before the first call, and are updated by each
+// call.
+absl::Status CreateTrainingCheckpoint(
+    const GradientBoostedTreesModel& mdl,
+    const proto::EarlyStoppingSnapshot& early_stopping, int iter_idx,
+    absl::string_view cache_path, absl::string_view snapshot_directory,
+    int* num_persisted_trees, int* num_full_save_trees);
+
+// Immutable view of the model state covered by a checkpoint. The trees are
+// borrowed: the model must outlive the checkpoint write and the covered trees
+// must not be modified (boosting only appends trees during training, so the
+// view stays valid while new trees are grown).
+struct CheckpointSnapshot {
+  // If true, the checkpoint is a full model save. Otherwise, it is a delta
+  // file containing the trees in ["begin_tree_idx", "trees.size()").
+  bool full_save;
+  int iter_idx;
+  int begin_tree_idx;
+
+  // The first "trees.size()" trees of the model, in order.
+  std::vector<const decision_tree::DecisionTree*> trees;
+
+  // Header of the model (see "GradientBoostedTreesModel::BuildHeader"). Only
+  // set if "full_save" is true.
+  proto::Header header;
+
+  proto::EarlyStoppingSnapshot early_stopping;
+};
+
+// Captures the checkpoint view of the model and updates the persistence
+// counters (see "CreateTrainingCheckpoint"). Must be called from the training
+// thread.
+CheckpointSnapshot BuildCheckpointSnapshot(
+    const GradientBoostedTreesModel& mdl,
+    const proto::EarlyStoppingSnapshot& early_stopping, int iter_idx,
+    int* num_persisted_trees, int* num_full_save_trees);
+
+// Writes a checkpoint from a snapshot. Can run on any thread.
+absl::Status WriteTrainingCheckpoint(const CheckpointSnapshot& snapshot,
+                                     absl::string_view cache_path,
+                                     absl::string_view snapshot_directory);
+
+// Writes the training checkpoints on a background thread, so the tree growth
+// does not stall on the checkpoint writes (e.g. a multi-minute model upload
+// to a remote file system). At most one checkpoint is in flight: a request
+// arriving while the previous checkpoint is still being written is skipped,
+// and the trees it would have persisted are covered by the next accepted
+// request.
+class BackgroundCheckpointer {
+ public:
+  // Waits for the pending checkpoint write (its status is lost; call "Join"
+  // first to catch it).
+  ~BackgroundCheckpointer();
+
+  // Requests a checkpoint of the current model state and returns immediately.
+  // The returned status reports the failure of a *previous* background
+  // checkpoint write (if any); the failure of this request's write is
+  // reported by the next call or by "Join".
+  absl::Status MaybeCreateCheckpoint(
+      const GradientBoostedTreesModel& mdl,
+      const proto::EarlyStoppingSnapshot& early_stopping, int iter_idx,
+      absl::string_view cache_path, absl::string_view snapshot_directory,
+      int* num_persisted_trees, int* num_full_save_trees);
+
+  // Waits for the pending checkpoint write (if any) and returns its status.
+  absl::Status Join();
+
+ private:
+  // Background checkpoint write, if any.
+  std::unique_ptr<utils::concurrency::Thread> worker_;
+
+  // True while "worker_" is writing a checkpoint.
+  std::atomic<bool> running_{false};
+
+  // Status of the last background checkpoint write. Only accessed by the
+  // training thread while "running_" is false.
+  absl::Status status_;
+};
+
+// Applies the trees of the last boosting iteration to the cached validation
+// predictions on a background thread, overlapping the validation update with
+// the rest of the iteration (e.g. the training loss computation). The trees
+// are immutable once added to the model, so the update can run while the next
+// iteration starts. At most one update is in flight: "Start" waits for the
+// previous update.
+class BackgroundValidationUpdater {
+ public:
+  // Waits for the pending update (its status is lost; call "Join" first to
+  // catch it).
+  ~BackgroundValidationUpdater();
+
+  // Starts updating "validation_predictions" with "trees" in the background.
+  // The returned status reports the failure of the *previous* update (if
+  // any); the failure of this update is reported by the next call or by
+  // "Join". "loss", "trees", "validation_dataset" and
+  // "validation_predictions" must remain valid until the next "Join".
+  absl::Status Start(const AbstractLoss& loss,
+                     std::vector<const decision_tree::DecisionTree*> trees,
+                     const dataset::VerticalDataset& validation_dataset,
+                     std::vector<float>* validation_predictions);
+
+  // Waits for the pending update (if any) and returns its status.
+  absl::Status Join();
+
+ private:
+  // Background update, if any.
+  std::unique_ptr<utils::concurrency::Thread> worker_;
+
+  // Status of the last background update. Only accessed by the training
+  // thread after the worker joined.
+  absl::Status status_;
+};
+
+// Restores the model and the early stopping state from the checkpoint
+// recorded for the iteration "snapshot_idx": loads the most recent full model
+// save and replays the delta files written since. The inverse of
+// "CreateTrainingCheckpoint".
+absl::Status RestoreTrainingCheckpoint(
+    int snapshot_idx, absl::string_view cache_path,
+    GradientBoostedTreesModel* mdl,
+    proto::EarlyStoppingSnapshot* early_stopping, int* num_persisted_trees,
+    int* num_full_save_trees);
+
 void InitializeModelWithTrainingConfig(
     const model::proto::TrainingConfig& training_config,
     const model::proto::TrainingConfigLinking& training_config_linking,
@@ -41,8 +41,10 @@
 #include "yggdrasil_decision_forests/dataset/data_spec_inference.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/learner/abstract_learner.h"
 #include "yggdrasil_decision_forests/learner/abstract_learner.pb.h"
 #include "yggdrasil_decision_forests/learner/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/learner/decision_tree/training.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/gradient_boosted_trees.pb.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/loss/loss_library.h"
 #include "yggdrasil_decision_forests/learner/learner_library.h"
@@ -326,6 +328,100 @@ TEST(GradientBoostedTrees, SampleTrainingExamplesWithSelGB) {
   EXPECT_THAT(selected_examples, ElementsAre(3, 0, 5, 1, 4));
 }
 
+TEST(GradientBoostedTrees, SharedPreprocessing) {
+  const std::string ds_typed_path =
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), "adult.csv"));
+  dataset::proto::DataSpecification data_spec;
+  dataset::proto::DataSpecificationGuide guide;
+  dataset::CreateDataSpec(ds_typed_path, false, guide, &data_spec);
+  dataset::VerticalDataset dataset;
+  CHECK_OK(LoadVerticalDataset(ds_typed_path, data_spec, &dataset));
+
+  model::proto::TrainingConfig config;
+  config.set_learner(GradientBoostedTreesLearner::kRegisteredName);
+  config.set_task(model::proto::Task::CLASSIFICATION);
+  config.set_label("income");
+  auto* gbt_config = config.MutableExtension(
+      gradient_boosted_trees::proto::gradient_boosted_trees_config);
+  gbt_config->set_num_trees(3);
+  // The trees should be trained on all the examples so that the shared
+  // preprocessing can be computed on "dataset" directly.
+  gbt_config->set_validation_set_ratio(0.f);
+  gbt_config->mutable_decision_tree()->mutable_internal()->set_sorting_strategy(
+      model::decision_tree::proto::DecisionTreeTrainingConfig::Internal::
+          FORCE_PRESORTED);
+
+  model::proto::TrainingConfigLinking config_link;
+  CHECK_OK(
+      AbstractLearner::LinkTrainingConfig(config, data_spec, &config_link));
+  auto preprocessing = std::make_shared<const decision_tree::Preprocessing>(
+      decision_tree::PreprocessTrainingDataset(dataset, config, config_link,
+                                               gbt_config->decision_tree(),
+                                               /*num_threads=*/1)
+          .value());
+  EXPECT_EQ(preprocessing->num_examples(), dataset.nrow());
+
+  GradientBoostedTreesLearner learner(config);
+  learner.set_shared_preprocessing(preprocessing);
+  const auto model = learner.TrainWithStatus(dataset).value();
+  const auto* gbt_model =
+      dynamic_cast<const GradientBoostedTreesModel*>(model.get());
+  EXPECT_EQ(gbt_model->NumTrees(), 3);
+
+  // A preprocessing computed on a different number of examples is rejected.
+  auto invalid_preprocessing = std::make_shared<decision_tree::Preprocessing>();
+  invalid_preprocessing->set_num_examples(dataset.nrow() - 1);
+  learner.set_shared_preprocessing(std::move(invalid_preprocessing));
+  EXPECT_THAT(learner.TrainWithStatus(dataset).status().message(),
+              ::testing::HasSubstr("different number of examples"));
+}
+
+TEST(GradientBoostedTrees, WarmStart) {
+  const std::string ds_typed_path =
+      absl::StrCat("csv:", file::JoinPath(DatasetDir(), "adult.csv"));
+  dataset::proto::DataSpecification data_spec;
+  dataset::proto::DataSpecificationGuide guide;
+  dataset::CreateDataSpec(ds_typed_path, false, guide, &data_spec);
+  dataset::VerticalDataset dataset;
+  CHECK_OK(LoadVerticalDataset(ds_typed_path, data_spec, &dataset));
+
+  model::proto::TrainingConfig config;
+  config.set_learner(GradientBoostedTreesLearner::kRegisteredName);
+  config.set_task(model::proto::Task::CLASSIFICATION);
+  config.set_label("income");
+  auto* gbt_config = config.MutableExtension(
+      gradient_boosted_trees::proto::gradient_boosted_trees_config);
+  gbt_config->set_num_trees(3);
+  gbt_config->set_validation_set_ratio(0.f);
+
+  // Train and save a first model.
+  GradientBoostedTreesLearner learner(config);
+  const auto model = learner.TrainWithStatus(dataset).value();
+  EXPECT_EQ(dynamic_cast<const GradientBoostedTreesModel*>(model.get())
+                ->NumTrees(),
+            3);
+  const auto model_dir = file::JoinPath(test::TmpDirectory(), "warm_start");
+  CHECK_OK(model->Save(model_dir, {/*file_prefix=*/""}));
+
+  // Resume the boosting from the saved model with two extra trees.
+  gbt_config->set_num_trees(5);
+  GradientBoostedTreesLearner warm_learner(config);
+  warm_learner.set_warm_start_model_directory(model_dir);
+  const auto warm_model = warm_learner.TrainWithStatus(dataset).value();
+  EXPECT_EQ(dynamic_cast<const GradientBoostedTreesModel*>(warm_model.get())
+                ->NumTrees(),
+            5);
+
+  // A model trained with a different task / loss is rejected.
+  model::proto::TrainingConfig regression_config = config;
+  regression_config.set_task(model::proto::Task::REGRESSION);
+  regression_config.set_label("age");
+  GradientBoostedTreesLearner incompatible_learner(regression_config);
+  incompatible_learner.set_warm_start_model_directory(model_dir);
+  EXPECT_THAT(incompatible_learner.TrainWithStatus(dataset).status().message(),
+              ::testing::HasSubstr("not compatible"));
+}
+
 // Helper for the training and testing on two non-overlapping samples from the
 // adult dataset.
 class GradientBoostedTreesOnAdult : public utils::TrainAndTestTester {
@@ -72,8 +72,9 @@ struct FocalLossBasicData {
   float pt;     // Probability of "being right".
   // Log of prob of being right. Calculated directly from log odds.
   float log_pt;
-  float mispred;  // Probability of miss-prediction.
-  float at;       // Sample weight (alpha_t, depends on ground truth label)
+  float mispred;      // Probability of miss-prediction.
+  float pow_mispred;  // mispred^gamma, the focal modulating factor.
+  float at;           // Sample weight (alpha_t, depends on ground truth label)
 };
 
 struct FocalLossGradientData {
@@ -90,14 +91,23 @@ FocalLossBasicData CalculateFocalLossBasic(bool is_positive, float prediction,
                                            float gamma, float alpha) {
   const float label = is_positive ? 1.f : 0.f;
   const float y = label * 2 - 1;
-  const float prediction_proba = 1.f / (1.f + std::exp(-prediction));
+  // All the transcendentals are derived from lse = log(1 + exp(d)) (with d
+  // the prediction in log odds space), computed in the overflow-free form
+  // max(d, 0) + log1p(exp(-|d|)), so a single exp and a single log1p cover
+  // the probability, log(pt) and log(mispred) below.
+  const float exp_neg_abs = std::exp(-std::fabs(prediction));
+  const float lse = std::max(prediction, 0.f) + std::log1p(exp_neg_abs);
+  // 1/(1+exp(-|d|)) is the sigmoid of |d|; the sigmoid of d follows by
+  // symmetry.
+  const float sigmoid_abs = 1.f / (1.f + exp_neg_abs);
+  const float prediction_proba =
+      prediction >= 0 ? sigmoid_abs : 1.f - sigmoid_abs;
   DCheckIsFinite(prediction_proba);
   // Pt is probability of predicting the right label (1-p for negative labels).
   const float pt = prediction_proba * y + 1.f - label;
   // Note: It is better to calculate log(pt) this way, to avoid NaNs when
   // pt is very close to zero.
   // Why is calculation of log_pt correct?
-  // Let d denote "prediction' in log odds space.
   // If label = 0:
   //   log(pt) = log(1-p) = log(1-1/(1+exp(-d))) =
   //   = log([1 + exp(-d) - 1] / [1 + exp(-d)]) =
@@ -113,11 +123,17 @@ FocalLossBasicData CalculateFocalLossBasic(bool is_positive, float prediction,
   //   = -[log(exp(d) + 1) - log(exp(d))] =
   //   = -log(exp(d) + 1) + d =
   //   = label * d - log(1+ exp(d))          Q.E.D.
-  const float log_pt =
-      label * prediction - std::log(1.0f + std::exp(prediction));
+  const float log_pt = label * prediction - lse;
   const float mispred = 1.0f - pt;
+  // By the same derivation, log(mispred) = (1-label) * d - lse: mispred is p
+  // for negative labels and 1-p for positive ones. mispred^gamma is then a
+  // single exp instead of a std::pow, and when mispred underflows to 0 the
+  // -inf logarithm still exponentiates to the correct 0 (for gamma > 0).
+  const float log_mispred = (1.f - label) * prediction - lse;
+  const float pow_mispred =
+      gamma > 0 ? std::exp(gamma * log_mispred) : 1.f;
   const float at = is_positive ? alpha : (1.0f - alpha);
-  return (FocalLossBasicData){y, label, pt, log_pt, mispred, at};
+  return (FocalLossBasicData){y, label, pt, log_pt, mispred, pow_mispred, at};
 }
 
 // We have a separate function to only calculate what's necessary for gradient
@@ -129,7 +145,7 @@ FocalLossGradientData CalculateFocalLossGradient(bool is_positive,
       CalculateFocalLossBasic(is_positive, prediction, gamma, alpha);
   // We calculate and store the two terms of the first derivative separately
   // to be reused in the hessian (when needed)
-  const float term1 = basic.at * basic.y * std::pow(basic.mispred, gamma);
+  const float term1 = basic.at * basic.y * basic.pow_mispred;
   const float term2 = gamma * basic.pt * basic.log_pt - basic.mispred;
   const float gradient = -term1 * term2;
   return (FocalLossGradientData){basic, gradient, term1, term2};
@@ -141,9 +157,11 @@ float CalculateFocalLossHessian(FocalLossGradientData gradient_data,
   if (basic.mispred <= std::numeric_limits<float>::epsilon()) {
     return 0.0f;
   }
-  // Derivative of term1 (see term1 in CalculateFocalLossGradient)
+  // Derivative of term1 (see term1 in CalculateFocalLossGradient).
+  // mispred^(gamma-1) re-uses the mispred^gamma of the gradient; mispred is
+  // bounded away from zero by the check above.
   const float dterm1 =
-      -basic.at * basic.y * gamma * std::pow(basic.mispred, gamma - 1.0f);
+      -basic.at * basic.y * gamma * basic.pow_mispred / basic.mispred;
   // Derivative of term2 (see term2 in CalculateFocalLossGradient)
   const float dterm2 = gamma * basic.log_pt + gamma + 1.0f;
 
@@ -163,7 +181,6 @@ absl::Status BinaryFocalLoss::TemplatedUpdateGradients(
     utils::RandomEngine* random,
     utils::concurrency::ThreadPool* thread_pool) const {
   static_assert(std::is_integral<T>::value, "Integral required.");
-  // TODO: Implement thread_pool.
 
   if (gradients->size() != 1) {
     return absl::InternalError("Wrong gradient shape");
@@ -176,19 +193,14 @@ absl::Status BinaryFocalLoss::TemplatedUpdateGradients(
   }
   const size_t num_examples = labels.size();
 
-  if (thread_pool == nullptr) {
-    TemplatedUpdateGradientsImp(labels, predictions, 0, num_examples, gamma_,
-                                alpha_, &gradient_data, hessian_data);
-  } else {
-    decision_tree::ConcurrentForLoop(
-        thread_pool->num_threads(), thread_pool, num_examples,
-        [this, &labels, &predictions, &gradient_data, hessian_data](
-            size_t block_idx, size_t begin_idx, size_t end_idx) -> void {
-          TemplatedUpdateGradientsImp(labels, predictions, begin_idx, end_idx,
-                                      gamma_, alpha_, &gradient_data,
-                                      hessian_data);
-        });
-  }
+  utils::concurrency::ParallelFor(
+      0, num_examples, /*min_block_size=*/1024, thread_pool,
+      [this, &labels, &predictions, &gradient_data, hessian_data](
+          size_t begin_idx, size_t end_idx) -> void {
+        TemplatedUpdateGradientsImp(labels, predictions, begin_idx, end_idx,
+                                    gamma_, alpha_, &gradient_data,
+                                    hessian_data);
+      });
 
   return absl::OkStatus();
 }
@@ -359,13 +371,12 @@ void BinaryFocalLoss::TemplatedLossImp(
       if (pos_label == pos_prediction) {
         *count_correct_predictions += weight;
       }
-      *sum_loss -=
-          weight * basic.at * std::pow(basic.mispred, gamma) * basic.log_pt;
+      *sum_loss -= weight * basic.at * basic.pow_mispred * basic.log_pt;
     } else {
       if (pos_label == pos_prediction) {
         *count_correct_predictions += 1.;
       }
-      *sum_loss -= basic.at * std::pow(basic.mispred, gamma) * basic.log_pt;
+      *sum_loss -= basic.at * basic.pow_mispred * basic.log_pt;
       DCheckIsFinite(*sum_loss);
     }
     DCheckIsFinite(*sum_loss);
@@ -151,18 +151,13 @@ absl::Status BinomialLogLikelihoodLoss::TemplatedUpdateGradients(
   }
   const size_t num_examples = labels.size();
 
-  if (thread_pool == nullptr) {
-    TemplatedUpdateGradientsImp(labels, predictions, 0, num_examples,
-                                &gradient_data, hessian_data);
-  } else {
-    decision_tree::ConcurrentForLoop(
-        thread_pool->num_threads(), thread_pool, num_examples,
-        [&labels, &predictions, &gradient_data, hessian_data](
-            size_t block_idx, size_t begin_idx, size_t end_idx) -> void {
-          TemplatedUpdateGradientsImp(labels, predictions, begin_idx, end_idx,
-                                      &gradient_data, hessian_data);
-        });
-  }
+  utils::concurrency::ParallelFor(
+      0, num_examples, /*min_block_size=*/1024, thread_pool,
+      [&labels, &predictions, &gradient_data, hessian_data](
+          size_t begin_idx, size_t end_idx) -> void {
+        TemplatedUpdateGradientsImp(labels, predictions, begin_idx, end_idx,
+                                    &gradient_data, hessian_data);
+      });
 
   return absl::OkStatus();
 }
@@ -217,7 +217,8 @@ absl::Status CrossEntropyNDCGLoss::Loss(
   if (ranking_index == nullptr) {
     return absl::InternalError("Missing ranking index");
   }
-  *loss_value = -ranking_index->NDCG(predictions, weights, kNDCG5Truncation);
+  *loss_value =
+      -ranking_index->NDCG(predictions, weights, kNDCG5Truncation, thread_pool);
   return absl::OkStatus();
 }
 
@@ -30,7 +30,6 @@
 #include "yggdrasil_decision_forests/learner/abstract_learner.pb.h"
 #include "yggdrasil_decision_forests/learner/decision_tree/decision_tree.pb.h"
 #include "yggdrasil_decision_forests/learner/decision_tree/training.h"
-#include "yggdrasil_decision_forests/learner/decision_tree/utils.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/gradient_boosted_trees.pb.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/loss/loss_interface.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/loss/loss_utils.h"
@@ -95,8 +94,6 @@ absl::Status MeanSquaredErrorLoss::UpdateGradients(
     const RankingGroupsIndices* ranking_index, GradientDataRef* gradients,
     utils::RandomEngine* random,
     utils::concurrency::ThreadPool* thread_pool) const {
-  // TODO: Implement thread_pool.
-
   // Set the gradient to:
   //   label - prediction
   if (gradients->size() != 1) {
@@ -104,11 +101,18 @@ absl::Status MeanSquaredErrorLoss::UpdateGradients(
   }
   const auto num_examples = labels.size();
   std::vector<float>& gradient_data = *(*gradients)[0].gradient;
-  for (size_t example_idx = 0; example_idx < num_examples; example_idx++) {
-    const float label = labels[example_idx];
-    const float prediction = predictions[example_idx];
-    gradient_data[example_idx] = label - prediction;
-  }
+  const auto update_chunk = [&labels, &predictions, &gradient_data](
+                                const size_t begin_example_idx,
+                                const size_t end_example_idx) {
+    for (size_t example_idx = begin_example_idx; example_idx < end_example_idx;
+         example_idx++) {
+      const float label = labels[example_idx];
+      const float prediction = predictions[example_idx];
+      gradient_data[example_idx] = label - prediction;
+    }
+  };
+  utils::concurrency::ParallelFor(0, num_examples, /*min_block_size=*/1024,
+                                  thread_pool, update_chunk);
   return absl::OkStatus();
 }
 
@@ -159,14 +163,14 @@ absl::Status MeanSquaredErrorLoss::SetLeaf(
       train_dataset
           .ColumnWithCastWithStatus<dataset::VerticalDataset::NumericalColumn>(
               label_col_idx));
-  double sum_weighted_values = 0;
-  double sum_weights = 0;
-  for (const auto example_idx : selected_examples) {
-    const float label = labels->values()[example_idx];
-    const float prediction = predictions[example_idx];
-    sum_weighted_values += weights[example_idx] * (label - prediction);
-    sum_weights += weights[example_idx];
-  }
+  // Reuse the vectorized gradient/hessian reduction with the labels in the
+  // gradient slot and the predictions in the hessian slot:
+  //   sum(w * (l - p)) = sum(w * l) - sum(w * p).
+  const auto sums = SumGradientsAndHessians(selected_examples, weights,
+                                            labels->values(), predictions);
+  const double sum_weighted_values =
+      sums.sum_weighted_gradients - sums.sum_weighted_hessians;
+  double sum_weights = sums.sum_weights;
   if (sum_weights <= 0) {
     LOG(WARNING) << "Zero or negative weights in node";
     sum_weights = 1.0;
@@ -229,7 +233,8 @@ absl::Status MeanSquaredErrorLoss::Loss(
     secondary_metric->resize(2);
     (*secondary_metric)[0] = *loss_value;
     (*secondary_metric)[1] =
-        ranking_index->NDCG(predictions, weights, kNDCG5Truncation);
+        ranking_index->NDCG(predictions, weights, kNDCG5Truncation,
+                            thread_pool);
   } else {
     secondary_metric->resize(1);
     (*secondary_metric)[0] = *loss_value;
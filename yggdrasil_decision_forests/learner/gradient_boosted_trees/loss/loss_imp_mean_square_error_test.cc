@@ -19,6 +19,7 @@
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 #include "yggdrasil_decision_forests/utils/testing_macros.h"
 
@@ -99,6 +100,16 @@ TEST(MeanSquareErrorLossTest, UpdateGradients) {
   ASSERT_THAT(gradients, Not(IsEmpty()));
   EXPECT_THAT(gradients.front().gradient,
               ElementsAre(1.f - 2.5f, 2.f - 2.5f, 3.f - 2.5f, 4.f - 2.5f));
+
+  // The multi-threaded computation returns the same gradients.
+  utils::concurrency::ThreadPool thread_pool("", 4);
+  thread_pool.StartWorkers();
+  ASSERT_OK(loss_imp.UpdateGradients(gradient_dataset,
+                                     /* label_col_idx= */ 0, predictions,
+                                     /*ranking_index=*/nullptr, &gradients,
+                                     &random, &thread_pool));
+  EXPECT_THAT(gradients.front().gradient,
+              ElementsAre(1.f - 2.5f, 2.f - 2.5f, 3.f - 2.5f, 4.f - 2.5f));
 }
 
 TEST(MeanSquareErrorLossTest, SetLabelDistribution) {
@@ -15,6 +15,7 @@
 
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/loss/loss_imp_multinomial.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <limits>
@@ -81,45 +82,58 @@ absl::Status MultinomialLogLikelihoodLoss::TemplatedUpdateGradients(
     utils::RandomEngine* random,
     utils::concurrency::ThreadPool* thread_pool) const {
   static_assert(std::is_integral<T>::value, "Integral required.");
-  // TODO: Implement thread_pool.
 
   // Set the gradient to:
   //   label_i - pred_i
   // where "label_i" is in {0,1}.
-  absl::FixedArray<float> accumulator(gradients->size());
   const auto num_examples = labels.size();
   const auto use_hessian_gain = (*gradients)[0].hessian;
   if (gbt_config_.use_hessian_gain() && !use_hessian_gain) {
     return absl::InternalError("Hessian missing");
   }
-  for (size_t example_idx = 0; example_idx < num_examples; example_idx++) {
-    // Compute normalization term.
-    float sum_exp = 0;
-    for (int grad_idx = 0; grad_idx < gradients->size(); grad_idx++) {
-      float exp_val =
-          std::exp(predictions[grad_idx + example_idx * gradients->size()]);
-      accumulator[grad_idx] = exp_val;
-      sum_exp += exp_val;
-    }
-    const float normalization = 1.f / sum_exp;
-    // Update gradient.
-    const int label_cat = labels[example_idx];
-    for (int grad_idx = 0; grad_idx < gradients->size(); grad_idx++) {
-      const float label = (label_cat == (grad_idx + 1)) ? 1.f : 0.f;
-      DCheckIsFinite(label);
-      const float prediction = accumulator[grad_idx] * normalization;
-      DCheckIsFinite(prediction);
-      const float grad = label - prediction;
-      const float abs_grad = std::abs(grad);
-      DCheckIsFinite(grad);
-      (*(*gradients)[grad_idx].gradient)[example_idx] = grad;
-      if (use_hessian_gain) {
-        (*(*gradients)[grad_idx].hessian)[example_idx] =
-            abs_grad * (1 - abs_grad);
-        DCheckIsFinite(abs_grad * (1 - abs_grad));
+  const auto update_chunk = [&labels, &predictions, gradients,
+                             use_hessian_gain](
+                                const size_t begin_example_idx,
+                                const size_t end_example_idx) {
+    const int num_grads = gradients->size();
+    absl::FixedArray<float> accumulator(num_grads);
+    for (size_t example_idx = begin_example_idx;
+         example_idx < end_example_idx; example_idx++) {
+      // Softmax of the predictions of the example, with the classical
+      // max-subtraction for numerical stability. The predictions of an
+      // example are contiguous, and the simple passes below vectorize well.
+      const float* const preds = &predictions[example_idx * num_grads];
+      float max_pred = preds[0];
+      for (int grad_idx = 1; grad_idx < num_grads; grad_idx++) {
+        max_pred = std::max(max_pred, preds[grad_idx]);
+      }
+      float sum_exp = 0;
+      for (int grad_idx = 0; grad_idx < num_grads; grad_idx++) {
+        const float exp_val = std::exp(preds[grad_idx] - max_pred);
+        accumulator[grad_idx] = exp_val;
+        sum_exp += exp_val;
+      }
+      const float normalization = 1.f / sum_exp;
+      // Update gradient.
+      const int label_cat = labels[example_idx];
+      for (int grad_idx = 0; grad_idx < num_grads; grad_idx++) {
+        const float label = (label_cat == (grad_idx + 1)) ? 1.f : 0.f;
+        const float prediction = accumulator[grad_idx] * normalization;
+        DCheckIsFinite(prediction);
+        const float grad = label - prediction;
+        const float abs_grad = std::abs(grad);
+        DCheckIsFinite(grad);
+        (*(*gradients)[grad_idx].gradient)[example_idx] = grad;
+        if (use_hessian_gain) {
+          (*(*gradients)[grad_idx].hessian)[example_idx] =
+              abs_grad * (1 - abs_grad);
+          DCheckIsFinite(abs_grad * (1 - abs_grad));
+        }
       }
     }
-  }
+  };
+  utils::concurrency::ParallelFor(0, num_examples, /*min_block_size=*/1024,
+                                  thread_pool, update_chunk);
   return absl::OkStatus();
 }
 
@@ -186,18 +200,51 @@ absl::Status MultinomialLogLikelihoodLoss::SetLeaf(
               config_link.label()));
   const auto& grad = column->values();
 
+  // Vectorizable reduction: raw pointers and independent partial accumulators
+  // (see "SumGradientsAndHessians" in loss_utils.cc). The hessian
+  // "|g| * (1 - |g|)" is computed on the fly from the gradient.
+  const UnsignedExampleIdx* __restrict example_idxs = selected_examples.data();
+  const float* __restrict weight_values = weights.data();
+  const float* __restrict grad_values = grad.data();
+  const size_t num_examples = selected_examples.size();
+
+  constexpr size_t kNumLanes = 4;
+  double numerator_lanes[kNumLanes] = {0};
+  double denominator_lanes[kNumLanes] = {0};
+  double sum_weights_lanes[kNumLanes] = {0};
+
+  const size_t rounded_num_examples = num_examples - num_examples % kNumLanes;
+  for (size_t selected_idx = 0; selected_idx < rounded_num_examples;
+       selected_idx += kNumLanes) {
+    for (size_t lane = 0; lane < kNumLanes; lane++) {
+      const auto example_idx = example_idxs[selected_idx + lane];
+      const double weight = weight_values[example_idx];
+      const float abs_grad = std::abs(grad_values[example_idx]);
+      numerator_lanes[lane] += weight * grad_values[example_idx];
+      denominator_lanes[lane] += weight * abs_grad * (1 - abs_grad);
+      sum_weights_lanes[lane] += weight;
+    }
+  }
+  for (size_t selected_idx = rounded_num_examples; selected_idx < num_examples;
+       selected_idx++) {
+    const auto example_idx = example_idxs[selected_idx];
+    const double weight = weight_values[example_idx];
+    const float abs_grad = std::abs(grad_values[example_idx]);
+    numerator_lanes[0] += weight * grad_values[example_idx];
+    denominator_lanes[0] += weight * abs_grad * (1 - abs_grad);
+    sum_weights_lanes[0] += weight;
+  }
+
   double numerator = 0;
   double denominator = 0;
   double sum_weights = 0;
-  for (const auto example_idx : selected_examples) {
-    const float weight = weights[example_idx];
-    numerator += weight * grad[example_idx];
-    const float abs_grad = std::abs(grad[example_idx]);
-    denominator += weight * abs_grad * (1 - abs_grad);
-    sum_weights += weight;
-    DCheckIsFinite(numerator);
-    DCheckIsFinite(denominator);
+  for (size_t lane = 0; lane < kNumLanes; lane++) {
+    numerator += numerator_lanes[lane];
+    denominator += denominator_lanes[lane];
+    sum_weights += sum_weights_lanes[lane];
   }
+  DCheckIsFinite(numerator);
+  DCheckIsFinite(denominator);
 
   if (denominator <= kMinHessianForNewtonStep) {
     denominator = kMinHessianForNewtonStep;
@@ -257,27 +304,29 @@ absl::Status MultinomialLogLikelihoodLoss::TemplatedLoss(
     for (size_t example_idx = 0; example_idx < labels.size(); example_idx++) {
       const int label = labels[example_idx];
 
-      int predicted_class = -1;
-      float predicted_class_exp_value = 0;
-      float sum_exp = 0;
-      for (int grad_idx = 0; grad_idx < dimension_; grad_idx++) {
-        const float exp_val =
-            std::exp(predictions[grad_idx + example_idx * dimension_]);
-        sum_exp += exp_val;
-        DCheckIsFinite(sum_exp);
-        if (exp_val > predicted_class_exp_value) {
-          predicted_class_exp_value = exp_val;
+      // Maximum prediction i.e. the predicted class, and normalization term
+      // of the softmax with the classical max-subtraction for numerical
+      // stability.
+      const float* const preds = &predictions[example_idx * dimension_];
+      int predicted_class = 1;
+      float max_pred = preds[0];
+      for (int grad_idx = 1; grad_idx < dimension_; grad_idx++) {
+        if (preds[grad_idx] > max_pred) {
+          max_pred = preds[grad_idx];
           predicted_class = grad_idx + 1;
         }
       }
+      float sum_exp = 0;
+      for (int grad_idx = 0; grad_idx < dimension_; grad_idx++) {
+        sum_exp += std::exp(preds[grad_idx] - max_pred);
+      }
+      DCheckIsFinite(sum_exp);
       if (label == predicted_class) {
         count_correct_predictions += 1;
       }
       // Loss:
       //   - log(predict_proba[true_label])
-      const float tree_label_exp_value =
-          std::exp(predictions[(label - 1) + example_idx * dimension_]);
-      sum_loss -= std::log(tree_label_exp_value / sum_exp);
+      sum_loss -= preds[label - 1] - max_pred - std::log(sum_exp);
       DCheckIsFinite(sum_loss);
       DCheckIsFinite(sum_weights);
     }
@@ -288,27 +337,26 @@ absl::Status MultinomialLogLikelihoodLoss::TemplatedLoss(
       const float weight = weights[example_idx];
       sum_weights += weight;
 
-      int predicted_class = -1;
-      float predicted_class_exp_value = 0;
-      float sum_exp = 0;
-      for (int grad_idx = 0; grad_idx < dimension_; grad_idx++) {
-        const float exp_val =
-            std::exp(predictions[grad_idx + example_idx * dimension_]);
-        sum_exp += exp_val;
-        DCheckIsFinite(sum_exp);
-        if (exp_val > predicted_class_exp_value) {
-          predicted_class_exp_value = exp_val;
+      const float* const preds = &predictions[example_idx * dimension_];
+      int predicted_class = 1;
+      float max_pred = preds[0];
+      for (int grad_idx = 1; grad_idx < dimension_; grad_idx++) {
+        if (preds[grad_idx] > max_pred) {
+          max_pred = preds[grad_idx];
           predicted_class = grad_idx + 1;
         }
       }
+      float sum_exp = 0;
+      for (int grad_idx = 0; grad_idx < dimension_; grad_idx++) {
+        sum_exp += std::exp(preds[grad_idx] - max_pred);
+      }
+      DCheckIsFinite(sum_exp);
       if (label == predicted_class) {
         count_correct_predictions += weight;
       }
       // Loss:
       //   - log(predict_proba[true_label])
-      const float tree_label_exp_value =
-          std::exp(predictions[(label - 1) + example_idx * dimension_]);
-      sum_loss -= weight * std::log(tree_label_exp_value / sum_exp);
+      sum_loss -= weight * (preds[label - 1] - max_pred - std::log(sum_exp));
       DCheckIsFinite(sum_loss);
       DCheckIsFinite(sum_weights);
     }
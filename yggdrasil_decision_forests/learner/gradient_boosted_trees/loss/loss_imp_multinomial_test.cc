@@ -19,6 +19,7 @@
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 #include "yggdrasil_decision_forests/utils/testing_macros.h"
 
@@ -103,6 +104,19 @@ TEST(MultinomialLogLikelihoodLossTest, UpdateGradients) {
   EXPECT_NEAR(gradients.front().gradient[3], 2.f / 3.f, kTestPrecision);
   EXPECT_NEAR(gradients.front().gradient[4], -1.f / 3.f, kTestPrecision);
   EXPECT_NEAR(gradients.front().gradient[5], -1.f / 3.f, kTestPrecision);
+
+  // The multi-threaded computation returns the same gradients.
+  utils::concurrency::ThreadPool thread_pool("", 4);
+  thread_pool.StartWorkers();
+  ASSERT_OK(loss_imp.UpdateGradients(
+      gradient_dataset, /* label_col_idx= */ 1, predictions,
+      /*ranking_index=*/nullptr, &gradients, &random, &thread_pool));
+  EXPECT_NEAR(gradients.front().gradient[0], 2.f / 3.f, kTestPrecision);
+  EXPECT_NEAR(gradients.front().gradient[1], -1.f / 3.f, kTestPrecision);
+  EXPECT_NEAR(gradients.front().gradient[2], -1.f / 3.f, kTestPrecision);
+  EXPECT_NEAR(gradients.front().gradient[3], 2.f / 3.f, kTestPrecision);
+  EXPECT_NEAR(gradients.front().gradient[4], -1.f / 3.f, kTestPrecision);
+  EXPECT_NEAR(gradients.front().gradient[5], -1.f / 3.f, kTestPrecision);
 }
 
 TEST(MultinomialLogLikelihoodLossTest, SetLabelDistribution) {
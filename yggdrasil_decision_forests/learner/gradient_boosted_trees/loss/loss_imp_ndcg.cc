@@ -240,7 +240,8 @@ absl::Status NDCGLoss::Loss(const std::vector<float>& labels,
     return absl::InternalError("Missing ranking index");
   }
 
-  const auto ndcg = ranking_index->NDCG(predictions, weights, kNDCG5Truncation);
+  const auto ndcg =
+      ranking_index->NDCG(predictions, weights, kNDCG5Truncation, thread_pool);
 
   // The loss is -1 * the ndcg.
   *loss_value = -ndcg;
@@ -269,16 +270,12 @@ absl::Status SetLeafNDCG(const dataset::VerticalDataset& train_dataset,
   const auto& gradient_data = gradients.front().gradient;
   const auto& second_order_derivative_data = *(gradients.front().hessian);
 
-  double sum_weighted_gradient = 0;
-  double sum_weighted_second_order_derivative = 0;
-  double sum_weights = 0;
-  for (const auto example_idx : selected_examples) {
-    const float weight = weights[example_idx];
-    sum_weighted_gradient += weight * gradient_data[example_idx];
-    sum_weighted_second_order_derivative +=
-        weight * second_order_derivative_data[example_idx];
-    sum_weights += weight;
-  }
+  const auto sums = SumGradientsAndHessians(selected_examples, weights,
+                                            gradient_data,
+                                            second_order_derivative_data);
+  double sum_weighted_gradient = sums.sum_weighted_gradients;
+  double sum_weighted_second_order_derivative = sums.sum_weighted_hessians;
+  const double sum_weights = sums.sum_weights;
   DCheckIsFinite(sum_weighted_gradient);
   DCheckIsFinite(sum_weighted_second_order_derivative);
 
@@ -21,6 +21,7 @@
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/loss/loss_imp_cross_entropy_ndcg.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/loss/loss_interface.h"
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 #include "yggdrasil_decision_forests/utils/testing_macros.h"
 
@@ -95,6 +96,13 @@ TEST(NDCGLossTest, PerfectPrediction) {
   // effect).
   double prefect_prediction_again = index.NDCG({10, 11, 12, 13}, weights, 5);
   EXPECT_NEAR(prefect_prediction_again, 1., kTestPrecision);
+
+  // The multi-threaded computation is equivalent.
+  utils::concurrency::ThreadPool thread_pool("", 4);
+  thread_pool.StartWorkers();
+  double threaded_prediction =
+      index.NDCG({10, 11, 12, 13}, weights, 5, &thread_pool);
+  EXPECT_NEAR(threaded_prediction, 1., kTestPrecision);
 }
 
 TEST(NDCGLossTest, PerfectlyWrongPrediction) {
@@ -27,6 +27,7 @@
 #include "absl/status/status.h"
 #include "absl/strings/substitute.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
+#include "yggdrasil_decision_forests/learner/decision_tree/utils.h"
 #include "yggdrasil_decision_forests/learner/gradient_boosted_trees/loss/loss_utils.h"
 #include "yggdrasil_decision_forests/metric/ranking_ndcg.h"
 #include "yggdrasil_decision_forests/metric/ranking_utils.h"
@@ -41,7 +42,8 @@ absl::Status AbstractLoss::UpdateGradients(
     const dataset::VerticalDataset& dataset, int label_col_idx,
     const std::vector<float>& predictions,
     const RankingGroupsIndices* ranking_index,
-    std::vector<GradientData>* gradients, utils::RandomEngine* random) const {
+    std::vector<GradientData>* gradients, utils::RandomEngine* random,
+    utils::concurrency::ThreadPool* thread_pool) const {
   GradientDataRef compact_gradient(gradients->size());
   for (int i = 0; i < gradients->size(); i++) {
     compact_gradient[i] = {&(*gradients)[i].gradient, (*gradients)[i].hessian};
@@ -52,7 +54,8 @@ absl::Status AbstractLoss::UpdateGradients(
           label_col_idx);
   if (categorical_labels) {
     return UpdateGradients(categorical_labels->values(), predictions,
-                           ranking_index, &compact_gradient, random, nullptr);
+                           ranking_index, &compact_gradient, random,
+                           thread_pool);
   }
 
   const auto* numerical_labels =
@@ -60,7 +63,8 @@ absl::Status AbstractLoss::UpdateGradients(
           label_col_idx);
   if (numerical_labels) {
     return UpdateGradients(numerical_labels->values(), predictions,
-                           ranking_index, &compact_gradient, random, nullptr);
+                           ranking_index, &compact_gradient, random,
+                           thread_pool);
   }
 
   return absl::InternalError(
@@ -166,38 +170,70 @@ void RankingGroupsIndices::Initialize(const dataset::VerticalDataset& dataset,
             << " examples.";
 }
 
-double RankingGroupsIndices::NDCG(const std::vector<float>& predictions,
-                                  const std::vector<float>& weights,
-                                  const int truncation) const {
+double RankingGroupsIndices::NDCG(
+    const std::vector<float>& predictions, const std::vector<float>& weights,
+    const int truncation, utils::concurrency::ThreadPool* thread_pool) const {
   DCHECK_EQ(predictions.size(), num_items_);
   DCHECK_EQ(weights.size(), num_items_);
 
-  metric::NDCGCalculator ndcg_calculator(truncation);
-  std::vector<metric::RankingLabelAndPrediction> pred_and_label_relevance;
+  // Accumulates the weighted NDCG and the weight of the groups in
+  // [begin_group_idx, end_group_idx).
+  const auto sum_chunk = [this, &predictions, &weights, truncation](
+                             const size_t begin_group_idx,
+                             const size_t end_group_idx,
+                             double* sum_weighted_ndcg, double* sum_weights) {
+    metric::NDCGCalculator ndcg_calculator(truncation);
+    std::vector<metric::RankingLabelAndPrediction> pred_and_label_relevance;
 
-  double sum_weighted_ndcg = 0;
-  double sum_weights = 0;
+    if (weights.empty()) {
+      for (size_t group_idx = begin_group_idx; group_idx < end_group_idx;
+           group_idx++) {
+        const auto& group = groups_[group_idx];
+        DCHECK(!group.items.empty());
+        ExtractPredAndLabelRelevance(group.items, predictions,
+                                     &pred_and_label_relevance);
+
+        *sum_weighted_ndcg += ndcg_calculator.NDCG(pred_and_label_relevance);
+      }
+      *sum_weights += end_group_idx - begin_group_idx;
+    } else {
+      for (size_t group_idx = begin_group_idx; group_idx < end_group_idx;
+           group_idx++) {
+        const auto& group = groups_[group_idx];
+        DCHECK(!group.items.empty());
+        const float weight = weights[group.items.front().example_idx];
 
-  if (weights.empty()) {
-    for (auto& group : groups_) {
-      DCHECK(!group.items.empty());
-      ExtractPredAndLabelRelevance(group.items, predictions,
-                                   &pred_and_label_relevance);
+        ExtractPredAndLabelRelevance(group.items, predictions,
+                                     &pred_and_label_relevance);
 
-      sum_weighted_ndcg += ndcg_calculator.NDCG(pred_and_label_relevance);
+        *sum_weighted_ndcg +=
+            weight * ndcg_calculator.NDCG(pred_and_label_relevance);
+        *sum_weights += weight;
+      }
     }
-    sum_weights += groups_.size();
-  } else {
-    for (auto& group : groups_) {
-      DCHECK(!group.items.empty());
-      const float weight = weights[group.items.front().example_idx];
+  };
 
-      ExtractPredAndLabelRelevance(group.items, predictions,
-                                   &pred_and_label_relevance);
+  double sum_weighted_ndcg = 0;
+  double sum_weights = 0;
 
-      sum_weighted_ndcg +=
-          weight * ndcg_calculator.NDCG(pred_and_label_relevance);
-      sum_weights += weight;
+  if (thread_pool == nullptr) {
+    sum_chunk(0, groups_.size(), &sum_weighted_ndcg, &sum_weights);
+  } else {
+    // The per-block partial sums are reduced in block order so that the
+    // result does not depend on the number of threads.
+    const size_t num_blocks = thread_pool->num_threads();
+    std::vector<double> block_sum_weighted_ndcg(num_blocks, 0.);
+    std::vector<double> block_sum_weights(num_blocks, 0.);
+    decision_tree::ConcurrentForLoop(
+        num_blocks, thread_pool, groups_.size(),
+        [&sum_chunk, &block_sum_weighted_ndcg, &block_sum_weights](
+            size_t block_idx, size_t begin_idx, size_t end_idx) -> void {
+          sum_chunk(begin_idx, end_idx, &block_sum_weighted_ndcg[block_idx],
+                    &block_sum_weights[block_idx]);
+        });
+    for (size_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+      sum_weighted_ndcg += block_sum_weighted_ndcg[block_idx];
+      sum_weights += block_sum_weights[block_idx];
     }
   }
 
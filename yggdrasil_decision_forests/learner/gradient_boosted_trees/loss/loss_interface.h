@@ -125,8 +125,12 @@ class RankingGroupsIndices {
   void Initialize(const dataset::VerticalDataset& dataset, int label_col_idx,
                   int group_col_idx);
 
+  // Computes the mean NDCG of the groups. If "thread_pool" is non-null, the
+  // groups are processed in parallel with deterministic per-block
+  // accumulation i.e. the result does not depend on the number of threads.
   double NDCG(const std::vector<float>& predictions,
-              const std::vector<float>& weights, int truncation) const;
+              const std::vector<float>& weights, int truncation,
+              utils::concurrency::ThreadPool* thread_pool = nullptr) const;
 
   const std::vector<Group>& groups() const { return groups_; }
 
@@ -229,12 +233,12 @@ class AbstractLoss {
   // This method calls the UpdateGradients defined above depending on the type
   // of the label column in the VerticalDataset (currently, only support float
   // (Numerical) and int32 (Categorical)).
-  absl::Status UpdateGradients(const dataset::VerticalDataset& dataset,
-                               int label_col_idx,
-                               const std::vector<float>& predictions,
-                               const RankingGroupsIndices* ranking_index,
-                               std::vector<GradientData>* gradients,
-                               utils::RandomEngine* random) const;
+  absl::Status UpdateGradients(
+      const dataset::VerticalDataset& dataset, int label_col_idx,
+      const std::vector<float>& predictions,
+      const RankingGroupsIndices* ranking_index,
+      std::vector<GradientData>* gradients, utils::RandomEngine* random,
+      utils::concurrency::ThreadPool* thread_pool = nullptr) const;
 
   // Creates a function able to set the value of a leaf.
   //
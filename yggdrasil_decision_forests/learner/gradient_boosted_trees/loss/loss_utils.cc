@@ -29,6 +29,52 @@ namespace yggdrasil_decision_forests {
 namespace model {
 namespace gradient_boosted_trees {
 
+GradientHessianSums SumGradientsAndHessians(
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const std::vector<float>& weights, const std::vector<float>& gradients,
+    const std::vector<float>& hessians) {
+  const UnsignedExampleIdx* __restrict example_idxs = selected_examples.data();
+  const float* __restrict weight_values = weights.data();
+  const float* __restrict gradient_values = gradients.data();
+  const float* __restrict hessian_values = hessians.data();
+  const size_t num_examples = selected_examples.size();
+
+  // Number of independent partial accumulators. Four double lanes fit a
+  // 256-bit SIMD register.
+  constexpr size_t kNumLanes = 4;
+  double sum_gradients[kNumLanes] = {0};
+  double sum_hessians[kNumLanes] = {0};
+  double sum_weights[kNumLanes] = {0};
+
+  const size_t rounded_num_examples = num_examples - num_examples % kNumLanes;
+  for (size_t selected_idx = 0; selected_idx < rounded_num_examples;
+       selected_idx += kNumLanes) {
+    for (size_t lane = 0; lane < kNumLanes; lane++) {
+      const auto example_idx = example_idxs[selected_idx + lane];
+      const double weight = weight_values[example_idx];
+      sum_gradients[lane] += weight * gradient_values[example_idx];
+      sum_hessians[lane] += weight * hessian_values[example_idx];
+      sum_weights[lane] += weight;
+    }
+  }
+  for (size_t selected_idx = rounded_num_examples;
+       selected_idx < num_examples; selected_idx++) {
+    const auto example_idx = example_idxs[selected_idx];
+    const double weight = weight_values[example_idx];
+    sum_gradients[0] += weight * gradient_values[example_idx];
+    sum_hessians[0] += weight * hessian_values[example_idx];
+    sum_weights[0] += weight;
+  }
+
+  GradientHessianSums sums;
+  for (size_t lane = 0; lane < kNumLanes; lane++) {
+    sums.sum_weighted_gradients += sum_gradients[lane];
+    sums.sum_weighted_hessians += sum_hessians[lane];
+    sums.sum_weights += sum_weights[lane];
+  }
+  return sums;
+}
+
 absl::Status SetLeafValueWithNewtonRaphsonStep(
     const proto::GradientBoostedTreesTrainingConfig& gbt_config_,
     const decision_tree::proto::LabelStatistics& label_statistics,
@@ -56,6 +56,22 @@ void DCheckIsFinite(T v) {
   DCHECK(!std::isnan(v) && !std::isinf(v));
 }
 
+// Sums, over the examples of a leaf, of the weighted gradients and hessians.
+struct GradientHessianSums {
+  double sum_weighted_gradients = 0;
+  double sum_weighted_hessians = 0;
+  double sum_weights = 0;
+};
+
+// Accumulates the weighted gradients and hessians of "selected_examples" read
+// from dense per-example buffers. The reduction is split into independent
+// partial accumulators so the compiler can vectorize the gather-and-accumulate
+// loop (a single accumulator creates a serial dependency between iterations).
+GradientHessianSums SumGradientsAndHessians(
+    const std::vector<UnsignedExampleIdx>& selected_examples,
+    const std::vector<float>& weights, const std::vector<float>& gradients,
+    const std::vector<float>& hessians);
+
 // Set a leaf's value using one stop of the Newton–Raphson method.
 // The label statistics should contain gradients + hessian values.
 absl::Status SetLeafValueWithNewtonRaphsonStep(
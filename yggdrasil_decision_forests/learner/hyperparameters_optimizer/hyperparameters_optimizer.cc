@@ -15,20 +15,33 @@
 
 #include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/hyperparameters_optimizer.h"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "yggdrasil_decision_forests/learner/abstract_learner.h"
 #include "yggdrasil_decision_forests/learner/abstract_learner.pb.h"
+#include "yggdrasil_decision_forests/learner/decision_tree/generic_parameters.h"
+#include "yggdrasil_decision_forests/learner/decision_tree/training.h"
+#include "yggdrasil_decision_forests/learner/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/hyperparameters_optimizer.pb.h"
 #include "yggdrasil_decision_forests/learner/learner_library.h"
 #include "yggdrasil_decision_forests/metric/metric.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
 #include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/random.h"
+#include "yggdrasil_decision_forests/utils/snapshot.h"
 #include "yggdrasil_decision_forests/utils/usage.h"
 
 namespace yggdrasil_decision_forests {
@@ -59,6 +72,108 @@ absl::Status SetTrainConfigDefaultValues(
   return absl::OkStatus();
 }
 
+// Name of the sub-directory of the deployment cache path containing the
+// persistent cache of evaluated trials.
+constexpr char kTrialCacheDirectoryName[] = "trial_cache";
+
+// Canonical string representation of a set of hyperparameters. Two sets of
+// hyperparameters with the same fields, possibly in different orders, have
+// the same canonical representation.
+std::string CanonicalHyperParameters(
+    const model::proto::GenericHyperParameters& params) {
+  std::vector<std::string> fields;
+  fields.reserve(params.fields_size());
+  for (const auto& field : params.fields()) {
+    fields.push_back(field.ShortDebugString());
+  }
+  std::sort(fields.begin(), fields.end());
+  return absl::StrJoin(fields, ";");
+}
+
+// Filename of the "record_idx"-th record of the persistent trial cache.
+std::string TrialCacheRecordFilename(const int record_idx) {
+  return absl::StrCat("trial_", record_idx, ".pb");
+}
+
+// Loads the persistent trial cache: canonical hyperparameters -> score.
+// "num_records" is set to the number of records in the cache.
+absl::Status LoadTrialCache(const std::string& directory,
+                            absl::flat_hash_map<std::string, double>* cache,
+                            int* num_records) {
+  *num_records = 0;
+  const auto last_record_idx = utils::GetGreatestSnapshot(directory);
+  if (!last_record_idx.ok()) {
+    // No trial was recorded yet.
+    return absl::OkStatus();
+  }
+  for (int record_idx = 0; record_idx <= last_record_idx.value();
+       record_idx++) {
+    model::proto::HyperparametersOptimizerLogs::Step record;
+    RETURN_IF_ERROR(file::GetBinaryProto(
+        file::JoinPath(directory, TrialCacheRecordFilename(record_idx)),
+        &record, file::Defaults()));
+    (*cache)[CanonicalHyperParameters(record.hyperparameters())] =
+        record.score();
+  }
+  *num_records = last_record_idx.value() + 1;
+  return absl::OkStatus();
+}
+
+// Appends an evaluated trial to the persistent trial cache.
+absl::Status SaveTrialCacheRecord(
+    const std::string& directory, const int record_idx,
+    const model::proto::GenericHyperParameters& params, const double score) {
+  model::proto::HyperparametersOptimizerLogs::Step record;
+  *record.mutable_hyperparameters() = params;
+  record.set_score(score);
+  RETURN_IF_ERROR(file::RecursivelyCreateDir(directory, file::Defaults()));
+  RETURN_IF_ERROR(file::SetBinaryProto(
+      file::JoinPath(directory, TrialCacheRecordFilename(record_idx)), record,
+      file::Defaults()));
+  // The snapshot record makes the trial visible to resumed studies. A trial
+  // interrupted between the two writes is simply re-evaluated.
+  return utils::AddSnapshot(directory, record_idx);
+}
+
+// Extracts a random sample (without replacement) of approximately "fraction"
+// of the rows of "dataset". Used by the fidelity ladder to materialize the
+// training dataset of a rung; the sample is shared, read-only, by all the
+// trials of the rung.
+utils::StatusOr<dataset::VerticalDataset> SampleDataset(
+    const dataset::VerticalDataset& dataset, const double fraction,
+    utils::RandomEngine* random) {
+  std::uniform_real_distribution<double> unif_dist_01;
+  std::vector<row_t> examples;
+  examples.reserve(static_cast<size_t>(dataset.nrow() * fraction) + 1);
+  for (row_t example_idx = 0; example_idx < dataset.nrow(); example_idx++) {
+    if (unif_dist_01(*random) < fraction) {
+      examples.push_back(example_idx);
+    }
+  }
+  if (examples.empty()) {
+    return absl::InvalidArgumentError(
+        "The fidelity ladder sampled an empty training dataset. Either "
+        "increase the number of training examples, or increase "
+        "\"fidelity_ladder.base_fraction\".");
+  }
+  return dataset.Extract(examples);
+}
+
+// Tests if the search space contains a field called "name", possibly as a
+// conditional child field.
+bool SearchSpaceContainsField(
+    const google::protobuf::RepeatedPtrField<
+        model::proto::HyperParameterSpace::Field>& fields,
+    const absl::string_view name) {
+  for (const auto& field : fields) {
+    if (field.name() == name ||
+        SearchSpaceContainsField(field.children(), name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 }  // namespace
 
 HyperParameterOptimizerLearner::HyperParameterOptimizerLearner(
@@ -416,6 +531,51 @@ HyperParameterOptimizerLearner::HyperParameterOptimizerLearner::
   return base_learner;
 }
 
+utils::StatusOr<internal::SharedTrialContext>
+HyperParameterOptimizerLearner::BuildSharedTrialContext(
+    const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
+    const model::proto::TrainingConfigLinking& config_link,
+    const dataset::VerticalDataset& train_dataset,
+    const bool has_valid_dataset) const {
+  internal::SharedTrialContext context;
+
+  // Currently, only the gradient boosted trees learner consumes a shared
+  // pre-sorted feature index.
+  ASSIGN_OR_RETURN(const auto base_learner,
+                   BuildBaseLearner(spe_config, /*for_tuning=*/true));
+  const auto* gbt_learner = dynamic_cast<
+      const gradient_boosted_trees::GradientBoostedTreesLearner*>(
+      base_learner.get());
+  if (gbt_learner == nullptr) {
+    return context;
+  }
+
+  const auto& gbt_config = gbt_learner->training_config().GetExtension(
+      gradient_boosted_trees::proto::gradient_boosted_trees_config);
+
+  // If the trials extract their own validation dataset, the trees are trained
+  // on a random subset of "train_dataset" and the index cannot be shared.
+  if (!has_valid_dataset && gbt_config.validation_set_ratio() > 0) {
+    return context;
+  }
+
+  // If the search space controls how the index is computed, each trial has to
+  // compute its own index.
+  if (SearchSpaceContainsField(spe_config.search_space().fields(),
+                               decision_tree::kHParamSortingStrategy)) {
+    return context;
+  }
+
+  ASSIGN_OR_RETURN(
+      auto preprocessing,
+      decision_tree::PreprocessTrainingDataset(
+          train_dataset, gbt_learner->training_config(), config_link,
+          gbt_config.decision_tree(), deployment().num_threads()));
+  context.preprocessing = std::make_shared<const decision_tree::Preprocessing>(
+      std::move(preprocessing));
+  return context;
+}
+
 utils::StatusOr<model::proto::HyperParameterSpace>
 HyperParameterOptimizerLearner::BuildSearchSpace(
     const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
@@ -444,6 +604,12 @@ HyperParameterOptimizerLearner::SearchBestHyperparameterInProcess(
         valid_dataset,
     std::unique_ptr<AbstractModel>* best_model,
     model::proto::HyperparametersOptimizerLogs* logs) const {
+  if (spe_config.has_fidelity_ladder()) {
+    return SearchBestHyperparameterWithFidelityLadder(
+        spe_config, config_link, search_space_spec, search_space, train_dataset,
+        valid_dataset, best_model, logs);
+  }
+
   const auto begin_optimization = absl::Now();
 
   // Initialize the hyperparameter logs.
@@ -456,6 +622,64 @@ HyperParameterOptimizerLearner::SearchBestHyperparameterInProcess(
                                        spe_config.optimizer().optimizer_key(),
                                        spe_config.optimizer(), search_space));
 
+  // Pre-computations shared, read-only, by all the concurrent trials.
+  ASSIGN_OR_RETURN(
+      const auto shared_context,
+      BuildSharedTrialContext(spe_config, config_link, train_dataset,
+                              valid_dataset.has_value()));
+
+  // Persistent cache of the evaluated trials. If the tuning is interrupted
+  // and restarted with the same "cache_path", the scores of the already
+  // evaluated trials are re-used without re-training.
+  absl::flat_hash_map<std::string, double> trial_cache;
+  std::string trial_cache_directory;
+  int num_trial_cache_records = 0;
+  if (deployment().try_resume_training()) {
+    if (deployment().cache_path().empty()) {
+      return absl::InvalidArgumentError(
+          "\"try_resume_training=True\" requires a \"cache_path\" in the "
+          "deployment configuration.");
+    }
+    if (!spe_config.retrain_final_model()) {
+      return absl::InvalidArgumentError(
+          "\"try_resume_training=True\" requires "
+          "\"retrain_final_model=True\": the model of a trial served from the "
+          "trial cache is not kept in memory.");
+    }
+    trial_cache_directory =
+        file::JoinPath(deployment().cache_path(), kTrialCacheDirectoryName);
+    RETURN_IF_ERROR(LoadTrialCache(trial_cache_directory, &trial_cache,
+                                   &num_trial_cache_records));
+    if (!trial_cache.empty()) {
+      LOG(INFO) << "Resume the hyper-parameter tuning with "
+                << trial_cache.size() << " cached trial(s)";
+    }
+  }
+
+  // "num_threads" is a thread budget shared by all the concurrently
+  // evaluated trials: each trial trains with its own pool of threads.
+  // Without the split below, "num_threads" concurrent trials each training
+  // with its own "num_threads" threads would create a quadratic number of
+  // threads and the context switches would erase the benefit of the
+  // parallelism. Trial-level parallelism scales better than the parallelism
+  // inside of a single training, so the budget goes first to the trials
+  // (bounded by the number of expected trials) and the remainder to the
+  // training threads of each trial. If the user specifies the number of
+  // training threads with "base_learner_deployment", it is respected and
+  // only the number of concurrent trials is derived from the budget.
+  const int num_threads = std::max(1, deployment().num_threads());
+  int num_parallel_trials =
+      std::min(num_threads, std::max(1, optimizer->NumExpectedRounds()));
+  int num_threads_per_trial;
+  if (spe_config.base_learner_deployment().has_num_threads()) {
+    num_threads_per_trial =
+        std::max(1, spe_config.base_learner_deployment().num_threads());
+    num_parallel_trials = std::max(
+        1, std::min(num_parallel_trials, num_threads / num_threads_per_trial));
+  } else {
+    num_threads_per_trial = std::max(1, num_threads / num_parallel_trials);
+  }
+
   // The "async_evaluator" evaluates candidates in parallel using
   // multi-threading.
   struct Output {
@@ -466,19 +690,22 @@ HyperParameterOptimizerLearner::SearchBestHyperparameterInProcess(
   utils::concurrency::StreamProcessor<model::proto::GenericHyperParameters,
                                       utils::StatusOr<Output>>
       async_evaluator(
-          "evaluator", deployment().num_threads(),
+          "evaluator", num_parallel_trials,
           [&](const model::proto::GenericHyperParameters& candidate)
               -> utils::StatusOr<Output> {
             std::unique_ptr<AbstractModel> model;
             ASSIGN_OR_RETURN(
                 const auto score,
                 EvaluateCandidateLocally(candidate, spe_config, config_link,
-                                         train_dataset, valid_dataset, &model));
+                                         train_dataset, valid_dataset,
+                                         shared_context, num_threads_per_trial,
+                                         &model));
             return Output{score, candidate, std::move(model)};
           });
 
-  LOG(INFO) << "Start local tuner with " << deployment().num_threads()
-            << " thread(s)";
+  LOG(INFO) << "Start local tuner with " << num_parallel_trials
+            << " parallel trial(s), each trained with "
+            << num_threads_per_trial << " thread(s)";
   async_evaluator.StartWorkers();
 
   // Number of candidate being evaluated.
@@ -523,6 +750,33 @@ HyperParameterOptimizerLearner::SearchBestHyperparameterInProcess(
         break;
       } else if (optimizer_status ==
                  NextCandidateStatus::kNewCandidateAvailable) {
+        // Serve the candidate from the trial cache if it was already
+        // evaluated e.g. in an interrupted run of the same study.
+        const auto it_cache =
+            trial_cache.find(CanonicalHyperParameters(candidate));
+        if (it_cache != trial_cache.end()) {
+          RETURN_IF_ERROR(
+              optimizer->ConsumeEvaluation(candidate, it_cache->second));
+
+          auto& log_entry = *logs->add_steps();
+          log_entry.set_evaluation_time(
+              absl::ToDoubleSeconds(absl::Now() - begin_optimization));
+          *log_entry.mutable_hyperparameters() = candidate;
+          log_entry.set_score(it_cache->second);
+
+          if (std::isnan(logging_best_score) ||
+              it_cache->second > logging_best_score) {
+            logging_best_score = it_cache->second;
+          }
+          LOG(INFO) << "[" << round_idx + 1 << "/"
+                    << optimizer->NumExpectedRounds()
+                    << "] Score: " << it_cache->second << " / "
+                    << logging_best_score << " HParams: "
+                    << candidate.ShortDebugString() << " (from cache)";
+          round_idx++;
+          continue;
+        }
+
         // Start evaluating this new candidate.
         pending_evaluation++;
         async_evaluator.Submit(candidate);
@@ -548,6 +802,17 @@ HyperParameterOptimizerLearner::SearchBestHyperparameterInProcess(
     RETURN_IF_ERROR(
         optimizer->ConsumeEvaluation(output.candidate, output.score));
 
+    // Persist the evaluated trial.
+    if (!trial_cache_directory.empty() &&
+        trial_cache
+            .insert({CanonicalHyperParameters(output.candidate), output.score})
+            .second) {
+      RETURN_IF_ERROR(SaveTrialCacheRecord(trial_cache_directory,
+                                           num_trial_cache_records,
+                                           output.candidate, output.score));
+      num_trial_cache_records++;
+    }
+
     // Record the hyperparameter + evaluation.
     auto& log_entry = *logs->add_steps();
     log_entry.set_evaluation_time(
@@ -585,6 +850,212 @@ HyperParameterOptimizerLearner::SearchBestHyperparameterInProcess(
   return best_params;
 }
 
+utils::StatusOr<model::proto::GenericHyperParameters>
+HyperParameterOptimizerLearner::SearchBestHyperparameterWithFidelityLadder(
+    const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
+    const model::proto::TrainingConfigLinking& config_link,
+    const model::proto::GenericHyperParameterSpecification& search_space_spec,
+    const model::proto::HyperParameterSpace& search_space,
+    const dataset::VerticalDataset& train_dataset,
+    absl::optional<std::reference_wrapper<const dataset::VerticalDataset>>
+        valid_dataset,
+    std::unique_ptr<AbstractModel>* best_model,
+    model::proto::HyperparametersOptimizerLogs* logs) const {
+  const auto begin_optimization = absl::Now();
+
+  const auto& ladder = spe_config.fidelity_ladder();
+  if (ladder.base_fraction() <= 0 || ladder.base_fraction() > 1) {
+    return absl::InvalidArgumentError(
+        "\"fidelity_ladder.base_fraction\" should be in (0,1].");
+  }
+  if (ladder.growth_factor() <= 1) {
+    return absl::InvalidArgumentError(
+        "\"fidelity_ladder.growth_factor\" should be greater than 1.");
+  }
+  if (ladder.promotion_fraction() <= 0 || ladder.promotion_fraction() > 1) {
+    return absl::InvalidArgumentError(
+        "\"fidelity_ladder.promotion_fraction\" should be in (0,1].");
+  }
+  if (deployment().try_resume_training()) {
+    return absl::InvalidArgumentError(
+        "\"fidelity_ladder\" is not compatible with "
+        "\"try_resume_training\": the trial cache does not record the "
+        "fidelity of a score.");
+  }
+
+  // Training dataset fractions of the rungs. The last rung always uses the
+  // full training dataset.
+  std::vector<double> fractions;
+  for (double fraction = ladder.base_fraction(); fraction < 1.;
+       fraction *= ladder.growth_factor()) {
+    fractions.push_back(fraction);
+  }
+  fractions.push_back(1.);
+
+  utils::RandomEngine random(training_config().random_seed());
+
+  // The configuration of a rung is the tuner configuration without the
+  // ladder: the first rung runs the regular optimizer-driven search (on the
+  // sample), and the next rungs only re-evaluate promoted candidates.
+  auto rung_spe_config = spe_config;
+  rung_spe_config.clear_fidelity_ladder();
+
+  // Rank all the candidates on the first rung.
+  ASSIGN_OR_RETURN(const auto first_rung_dataset,
+                   SampleDataset(train_dataset, fractions.front(), &random));
+  LOG(INFO) << "Fidelity ladder: rank the candidates on "
+            << first_rung_dataset.nrow() << " / " << train_dataset.nrow()
+            << " example(s)";
+  std::unique_ptr<AbstractModel> low_fidelity_model;
+  RETURN_IF_ERROR(SearchBestHyperparameterInProcess(
+                      rung_spe_config, config_link, search_space_spec,
+                      search_space, first_rung_dataset, valid_dataset,
+                      &low_fidelity_model, logs)
+                      .status());
+
+  // Candidates of the current rung with their scores at the current fidelity.
+  std::vector<std::pair<double, model::proto::GenericHyperParameters>> ranked;
+  ranked.reserve(logs->steps_size());
+  for (const auto& step : logs->steps()) {
+    ranked.push_back({step.score(), step.hyperparameters()});
+  }
+  if (ranked.empty()) {
+    return absl::InternalError("No candidate was evaluated on the first rung");
+  }
+
+  const int num_rungs = static_cast<int>(fractions.size());
+  for (int rung_idx = 1; rung_idx < num_rungs; rung_idx++) {
+    // Promote the top candidates to the next rung.
+    std::sort(ranked.begin(), ranked.end(),
+              [](const auto& a, const auto& b) { return a.first > b.first; });
+    const int num_promoted = std::max<int>(
+        1, std::lround(ladder.promotion_fraction() * ranked.size()));
+    ranked.resize(std::min<size_t>(num_promoted, ranked.size()));
+
+    std::vector<model::proto::GenericHyperParameters> candidates;
+    candidates.reserve(ranked.size());
+    for (const auto& item : ranked) {
+      candidates.push_back(item.second);
+    }
+
+    const bool last_rung = rung_idx == num_rungs - 1;
+    dataset::VerticalDataset rung_sample;
+    if (!last_rung) {
+      ASSIGN_OR_RETURN(rung_sample, SampleDataset(
+                                        train_dataset, fractions[rung_idx],
+                                        &random));
+    }
+    const dataset::VerticalDataset& rung_dataset =
+        last_rung ? train_dataset : rung_sample;
+    LOG(INFO) << "Fidelity ladder: re-evaluate " << candidates.size()
+              << " candidate(s) on " << rung_dataset.nrow() << " / "
+              << train_dataset.nrow() << " example(s)";
+
+    ASSIGN_OR_RETURN(
+        const auto scores,
+        EvaluateCandidatesLocally(candidates, rung_spe_config, config_link,
+                                  rung_dataset, valid_dataset,
+                                  last_rung ? best_model : nullptr));
+
+    for (int candidate_idx = 0; candidate_idx < candidates.size();
+         candidate_idx++) {
+      ranked[candidate_idx] = {scores[candidate_idx],
+                               candidates[candidate_idx]};
+
+      // Record the re-evaluation.
+      auto& log_entry = *logs->add_steps();
+      log_entry.set_evaluation_time(
+          absl::ToDoubleSeconds(absl::Now() - begin_optimization));
+      *log_entry.mutable_hyperparameters() = candidates[candidate_idx];
+      log_entry.set_score(scores[candidate_idx]);
+    }
+  }
+
+  // Best candidate of the last rung i.e. trained on the full dataset.
+  const auto best_it = std::max_element(
+      ranked.begin(), ranked.end(),
+      [](const auto& a, const auto& b) { return a.first < b.first; });
+  logs->set_best_score(best_it->first);
+  *logs->mutable_best_hyperparameters() = best_it->second;
+  return best_it->second;
+}
+
+utils::StatusOr<std::vector<double>>
+HyperParameterOptimizerLearner::EvaluateCandidatesLocally(
+    const std::vector<model::proto::GenericHyperParameters>& candidates,
+    const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
+    const model::proto::TrainingConfigLinking& config_link,
+    const dataset::VerticalDataset& train_dataset,
+    absl::optional<std::reference_wrapper<const dataset::VerticalDataset>>
+        valid_dataset,
+    std::unique_ptr<AbstractModel>* best_model) const {
+  // Pre-computations shared, read-only, by all the trials of the rung.
+  ASSIGN_OR_RETURN(
+      const auto shared_context,
+      BuildSharedTrialContext(spe_config, config_link, train_dataset,
+                              valid_dataset.has_value()));
+
+  // Same thread budget sharing as the optimizer-driven search.
+  const int num_threads = std::max(1, deployment().num_threads());
+  int num_parallel_trials = std::min<int>(
+      num_threads, std::max<int>(1, static_cast<int>(candidates.size())));
+  int num_threads_per_trial;
+  if (spe_config.base_learner_deployment().has_num_threads()) {
+    num_threads_per_trial =
+        std::max(1, spe_config.base_learner_deployment().num_threads());
+    num_parallel_trials = std::max(
+        1, std::min(num_parallel_trials, num_threads / num_threads_per_trial));
+  } else {
+    num_threads_per_trial = std::max(1, num_threads / num_parallel_trials);
+  }
+
+  struct Output {
+    int candidate_idx;
+    double score;
+    std::unique_ptr<AbstractModel> model;
+  };
+  utils::concurrency::StreamProcessor<int, utils::StatusOr<Output>>
+      async_evaluator("rung_evaluator", num_parallel_trials,
+                      [&](const int candidate_idx) -> utils::StatusOr<Output> {
+                        std::unique_ptr<AbstractModel> model;
+                        ASSIGN_OR_RETURN(
+                            const auto score,
+                            EvaluateCandidateLocally(
+                                candidates[candidate_idx], spe_config,
+                                config_link, train_dataset, valid_dataset,
+                                shared_context, num_threads_per_trial, &model));
+                        return Output{candidate_idx, score, std::move(model)};
+                      });
+  async_evaluator.StartWorkers();
+  for (int candidate_idx = 0; candidate_idx < candidates.size();
+       candidate_idx++) {
+    async_evaluator.Submit(candidate_idx);
+  }
+  async_evaluator.CloseSubmits();
+
+  std::vector<double> scores(candidates.size());
+  double best_score = std::numeric_limits<double>::quiet_NaN();
+  while (true) {
+    auto maybe_output = async_evaluator.GetResult();
+    if (!maybe_output.has_value()) {
+      break;
+    }
+    if (!maybe_output.value().ok()) {
+      return maybe_output.value().status();
+    }
+    auto& output = maybe_output.value().value();
+    scores[output.candidate_idx] = output.score;
+    if (std::isnan(best_score) || output.score > best_score) {
+      best_score = output.score;
+      if (best_model != nullptr) {
+        *best_model = std::move(output.model);
+      }
+    }
+  }
+  async_evaluator.JoinAllAndStopThreads();
+  return scores;
+}
+
 utils::StatusOr<model::proto::GenericHyperParameters>
 HyperParameterOptimizerLearner::SearchBestHyperparameterDistributed(
     const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
@@ -758,11 +1229,30 @@ HyperParameterOptimizerLearner::EvaluateCandidateLocally(
     const dataset::VerticalDataset& train_dataset,
     absl::optional<std::reference_wrapper<const dataset::VerticalDataset>>
         valid_dataset,
-    std::unique_ptr<AbstractModel>* model) const {
+    const internal::SharedTrialContext& shared_context,
+    const int num_train_threads, std::unique_ptr<AbstractModel>* model) const {
   ASSIGN_OR_RETURN(const auto base_learner, BuildBaseLearner(spe_config, true));
   RETURN_IF_ERROR(base_learner->SetHyperParameters(candidate));
+  base_learner->mutable_deployment()->set_num_threads(num_train_threads);
   base_learner->set_stop_training_trigger(stop_training_trigger_);
 
+  if (shared_context.preprocessing != nullptr) {
+    auto* gbt_learner =
+        dynamic_cast<gradient_boosted_trees::GradientBoostedTreesLearner*>(
+            base_learner.get());
+    if (gbt_learner != nullptr) {
+      const auto& gbt_config = gbt_learner->training_config().GetExtension(
+          gradient_boosted_trees::proto::gradient_boosted_trees_config);
+      // The index can only be shared if the trial trains on the entire
+      // training dataset. The candidate can change the validation set ratio
+      // set when the context was built.
+      if (valid_dataset.has_value() ||
+          gbt_config.validation_set_ratio() == 0) {
+        gbt_learner->set_shared_preprocessing(shared_context.preprocessing);
+      }
+    }
+  }
+
   metric::proto::EvaluationResults evaluation;
   switch (spe_config.evaluation().source_case()) {
     case proto::Evaluation::SourceCase::SOURCE_NOT_SET:
@@ -22,6 +22,7 @@
 #define YGGDRASIL_DECISION_FORESTS_LEARNER_HYPERPARAMETERS_OPTIMIZER_H_
 
 #include <memory>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
@@ -38,8 +39,29 @@
 
 namespace yggdrasil_decision_forests {
 namespace model {
+
+namespace decision_tree {
+class Preprocessing;
+}
+
 namespace hyperparameters_optimizer_v2 {
 
+namespace internal {
+
+// Pre-computations shared, read-only, by all the concurrent in-process
+// trials. Everything that only depends on the training dataset is computed
+// once and pinned in this context so that the memory usage of the tuning is
+// O(dataset) instead of O(dataset x concurrent trials).
+struct SharedTrialContext {
+  // Pre-sorted numerical feature index consumed by the gradient boosted trees
+  // base learner. Null if no index can be shared e.g. the base learner is not
+  // a decision forest, or each trial extracts its own validation dataset from
+  // the training dataset.
+  std::shared_ptr<const decision_tree::Preprocessing> preprocessing;
+};
+
+}  // namespace internal
+
 class HyperParameterOptimizerLearner : public AbstractLearner {
  public:
   explicit HyperParameterOptimizerLearner(
@@ -70,6 +92,7 @@ class HyperParameterOptimizerLearner : public AbstractLearner {
   model::proto::LearnerCapabilities Capabilities() const override {
     model::proto::LearnerCapabilities capabilities;
     capabilities.set_support_max_training_duration(true);
+    capabilities.set_support_validation_dataset(true);
     return capabilities;
   }
 
@@ -98,8 +121,18 @@ class HyperParameterOptimizerLearner : public AbstractLearner {
       const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
       const bool for_tuning) const;
 
+  // Assembles the pre-computations shared by all the in-process trials. The
+  // context can be empty e.g. if the base learner does not support shared
+  // pre-computations.
+  utils::StatusOr<internal::SharedTrialContext> BuildSharedTrialContext(
+      const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
+      const model::proto::TrainingConfigLinking& config_link,
+      const dataset::VerticalDataset& train_dataset,
+      bool has_valid_dataset) const;
+
   // Searches for the best hyperparameter in process from a dataset loaded in
-  // memory. The dataset object is shared among the trials.
+  // memory. The dataset object and the shared trial context (e.g. the
+  // pre-sorted feature index) are shared among the trials.
   utils::StatusOr<model::proto::GenericHyperParameters>
   SearchBestHyperparameterInProcess(
       const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
@@ -112,6 +145,38 @@ class HyperParameterOptimizerLearner : public AbstractLearner {
       std::unique_ptr<AbstractModel>* best_model,
       model::proto::HyperparametersOptimizerLogs* logs) const;
 
+  // Searches for the best hyperparameter with the multi-fidelity data ladder
+  // (see "FidelityLadder" in the proto): the optimizer-driven search ranks
+  // all the candidates on a small random sample of "train_dataset", and only
+  // the top candidates of a rung are promoted to (and re-trained on)
+  // increasingly large samples, the last rung being the full training
+  // dataset. Only the training examples are sampled: trials always evaluate
+  // on the full "valid_dataset" (if any).
+  utils::StatusOr<model::proto::GenericHyperParameters>
+  SearchBestHyperparameterWithFidelityLadder(
+      const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
+      const model::proto::TrainingConfigLinking& config_link,
+      const model::proto::GenericHyperParameterSpecification& search_space_spec,
+      const model::proto::HyperParameterSpace& search_space,
+      const dataset::VerticalDataset& train_dataset,
+      absl::optional<std::reference_wrapper<const dataset::VerticalDataset>>
+          valid_dataset,
+      std::unique_ptr<AbstractModel>* best_model,
+      model::proto::HyperparametersOptimizerLogs* logs) const;
+
+  // Evaluates a fixed list of candidates, in parallel, on "train_dataset".
+  // Returns one score per candidate, in the candidate order. If "best_model"
+  // is non-null, it is set to the model of the best scoring candidate. Used
+  // by the fidelity ladder to re-evaluate the promoted candidates on a rung.
+  utils::StatusOr<std::vector<double>> EvaluateCandidatesLocally(
+      const std::vector<model::proto::GenericHyperParameters>& candidates,
+      const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
+      const model::proto::TrainingConfigLinking& config_link,
+      const dataset::VerticalDataset& train_dataset,
+      absl::optional<std::reference_wrapper<const dataset::VerticalDataset>>
+          valid_dataset,
+      std::unique_ptr<AbstractModel>* best_model) const;
+
   // Searches for the best hyperparameter using distributed training from a disk
   // dataset.
   utils::StatusOr<model::proto::GenericHyperParameters>
@@ -134,7 +199,9 @@ class HyperParameterOptimizerLearner : public AbstractLearner {
       const metric::proto::MetricAccessor& metric_accessor) const;
 
   // Evaluates the quality of a candidate locally i.e. train and evaluate the
-  // model locally.
+  // model locally. "num_train_threads" is the number of training threads of
+  // this trial; the thread budget of the tuner (i.e.
+  // "deployment().num_threads()") is shared by all the concurrent trials.
   utils::StatusOr<double> EvaluateCandidateLocally(
       const model::proto::GenericHyperParameters& candidate,
       const proto::HyperParametersOptimizerLearnerTrainingConfig& spe_config,
@@ -142,7 +209,8 @@ class HyperParameterOptimizerLearner : public AbstractLearner {
       const dataset::VerticalDataset& train_dataset,
       absl::optional<std::reference_wrapper<const dataset::VerticalDataset>>
           valid_dataset,
-      std::unique_ptr<AbstractModel>* model) const;
+      const internal::SharedTrialContext& shared_context,
+      int num_train_threads, std::unique_ptr<AbstractModel>* model) const;
 
   // Creates an initialized distribute manager with "GENERIC_WORKER" workers.
   utils::StatusOr<std::unique_ptr<distribute::AbstractManager>>
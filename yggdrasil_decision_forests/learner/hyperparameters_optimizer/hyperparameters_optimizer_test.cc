@@ -153,6 +153,63 @@ TEST_F(OnAdult, RandomTuner_MemoryDataset_LocalTraining) {
   EXPECT_EQ(model_->hyperparameter_optimizer_logs()->steps_size(), 25);
 }
 
+// With an explicit validation dataset, the trials train on the entire
+// training dataset and share a single pre-sorted feature index.
+TEST_F(OnAdult, RandomTuner_MemoryDataset_LocalTraining_ValidationDataset) {
+  pass_validation_dataset_ = true;
+  SetLocalTraining();
+  TrainAndEvaluateModel();
+  EXPECT_GE(metric::Accuracy(evaluation_), 0.86);
+  EXPECT_LT(metric::LogLoss(evaluation_), 0.32);
+  EXPECT_EQ(model_->hyperparameter_optimizer_logs()->steps_size(), 25);
+}
+
+// With "try_resume_training", the evaluated trials are persisted in the cache
+// path. The second study re-uses the cached scores without re-training.
+TEST_F(OnAdult, RandomTuner_MemoryDataset_LocalTraining_Resume) {
+  deployment_config_.set_try_resume_training(true);
+  SetLocalTraining();
+  TrainAndEvaluateModel();
+  EXPECT_GE(metric::Accuracy(evaluation_), 0.87);
+  EXPECT_EQ(model_->hyperparameter_optimizer_logs()->steps_size(), 25);
+
+  TrainAndEvaluateModel();
+  EXPECT_GE(metric::Accuracy(evaluation_), 0.87);
+  EXPECT_EQ(model_->hyperparameter_optimizer_logs()->steps_size(), 25);
+}
+
+// With the fidelity ladder, the 25 candidates are ranked on a 20% sample,
+// the top 25% are re-evaluated on a 80% sample, and the remaining finalists
+// are trained on the full training dataset.
+TEST_F(OnAdult, RandomTuner_MemoryDataset_LocalTraining_FidelityLadder) {
+  auto* spe_config = train_config_.MutableExtension(
+      hyperparameters_optimizer_v2::proto::hyperparameters_optimizer_config);
+  auto* ladder = spe_config->mutable_fidelity_ladder();
+  ladder->set_base_fraction(0.2);
+  ladder->set_growth_factor(4);
+  ladder->set_promotion_fraction(0.25);
+
+  SetLocalTraining();
+  TrainAndEvaluateModel();
+  EXPECT_GE(metric::Accuracy(evaluation_), 0.86);
+  // 25 trials on the first rung, 6 promoted to the second rung, 2 finalists.
+  EXPECT_EQ(model_->hyperparameter_optimizer_logs()->steps_size(), 25 + 6 + 2);
+}
+
+// Without the final re-training, the returned model is the best model of the
+// last rung i.e. the best finalist trained on the full training dataset.
+TEST_F(OnAdult, RandomTuner_MemoryDataset_FidelityLadder_NoRetrain) {
+  auto* spe_config = train_config_.MutableExtension(
+      hyperparameters_optimizer_v2::proto::hyperparameters_optimizer_config);
+  spe_config->set_retrain_final_model(false);
+  spe_config->mutable_fidelity_ladder()->set_base_fraction(0.2);
+
+  SetLocalTraining();
+  TrainAndEvaluateModel();
+  EXPECT_GE(metric::Accuracy(evaluation_), 0.86);
+  EXPECT_EQ(model_->hyperparameter_optimizer_logs()->steps_size(), 25 + 6 + 2);
+}
+
 TEST_F(OnAdult, RandomTuner_FileDataset_LocalTraining) {
   pass_training_dataset_as_path_ = true;
   SetLocalTraining();
@@ -35,46 +35,6 @@ RandomOptimizer::RandomOptimizer(const proto::Optimizer& config,
 
 int RandomOptimizer::NumExpectedRounds() { return config_.num_trials(); }
 
-absl::Status RandomOptimizer::BuildRandomSet(
-    const model::proto::HyperParameterSpace::Field& field,
-    model::proto::GenericHyperParameters* candidate) {
-  // Create the field.
-  auto* field_value = candidate->add_fields();
-  field_value->set_name(field.name());
-  auto& value = *field_value->mutable_value();
-
-  // Select a random value.
-  switch (field.Type_case()) {
-    case model::proto::HyperParameterSpace::Field::TypeCase::
-        kDiscreteCandidates: {
-      std::vector<float> sampling_weight{
-          field.discrete_candidates().weights().begin(),
-          field.discrete_candidates().weights().end()};
-      ASSIGN_OR_RETURN(const auto selected_value_idx,
-                       internal::Sample(sampling_weight, &rnd_));
-      value = field.discrete_candidates().possible_values(selected_value_idx);
-    } break;
-    default:
-      return absl::InvalidArgumentError("Type of search space not supported");
-  }
-
-  // Call the children matching this parent value.
-  for (const auto& child : field.children()) {
-    bool match_child = false;
-    for (const auto& match_value :
-         child.parent_discrete_values().possible_values()) {
-      if (match_value.DebugString() == value.DebugString()) {
-        match_child = true;
-        break;
-      }
-    }
-    if (match_child) {
-      RETURN_IF_ERROR(BuildRandomSet(child, candidate));
-    }
-  }
-  return absl::OkStatus();
-}
-
 utils::StatusOr<NextCandidateStatus> RandomOptimizer::NextCandidate(
     model::proto::GenericHyperParameters* candidate) {
   RETURN_IF_ERROR(constructor_status_);
@@ -93,7 +53,7 @@ utils::StatusOr<NextCandidateStatus> RandomOptimizer::NextCandidate(
     candidate->Clear();
 
     for (const auto& field : space_.fields()) {
-      RETURN_IF_ERROR(BuildRandomSet(field, candidate));
+      RETURN_IF_ERROR(internal::BuildRandomSet(field, &rnd_, candidate));
     }
 
     if (already_proposed_candidates_.find(candidate->ShortDebugString()) ==
@@ -212,6 +172,47 @@ utils::StatusOr<double> UpdateWeights(
   return field_weight;
 }
 
+absl::Status BuildRandomSet(
+    const model::proto::HyperParameterSpace::Field& field,
+    utils::RandomEngine* random,
+    model::proto::GenericHyperParameters* candidate) {
+  // Create the field.
+  auto* field_value = candidate->add_fields();
+  field_value->set_name(field.name());
+  auto& value = *field_value->mutable_value();
+
+  // Select a random value.
+  switch (field.Type_case()) {
+    case model::proto::HyperParameterSpace::Field::TypeCase::
+        kDiscreteCandidates: {
+      std::vector<float> sampling_weight{
+          field.discrete_candidates().weights().begin(),
+          field.discrete_candidates().weights().end()};
+      ASSIGN_OR_RETURN(const auto selected_value_idx,
+                       Sample(sampling_weight, random));
+      value = field.discrete_candidates().possible_values(selected_value_idx);
+    } break;
+    default:
+      return absl::InvalidArgumentError("Type of search space not supported");
+  }
+
+  // Call the children matching this parent value.
+  for (const auto& child : field.children()) {
+    bool match_child = false;
+    for (const auto& match_value :
+         child.parent_discrete_values().possible_values()) {
+      if (match_value.DebugString() == value.DebugString()) {
+        match_child = true;
+        break;
+      }
+    }
+    if (match_child) {
+      RETURN_IF_ERROR(BuildRandomSet(child, random, candidate));
+    }
+  }
+  return absl::OkStatus();
+}
+
 utils::StatusOr<size_t> Sample(std::vector<float>& weights,
                                utils::RandomEngine* random) {
   const double sum = std::accumulate(weights.begin(), weights.end(), 0.0);
@@ -47,11 +47,6 @@ class RandomOptimizer : public OptimizerInterface {
   int NumExpectedRounds() override;
 
  private:
-  // Build recursively a set of random hyper-parameter values.
-  absl::Status BuildRandomSet(
-      const model::proto::HyperParameterSpace::Field& field,
-      model::proto::GenericHyperParameters* candidate);
-
   // Configuration of the optimizer.
   proto::RandomOptimizerConfig config_;
 
@@ -102,6 +97,14 @@ utils::StatusOr<double> UpdateWeights(
 utils::StatusOr<size_t> Sample(std::vector<float>& weights,
                                utils::RandomEngine* random);
 
+// Builds recursively a set of random hyper-parameter values: appends to
+// "candidate" a random value for "field" and for the matching children of
+// "field". Expects the sampling weights computed by "UpdateWeights".
+absl::Status BuildRandomSet(
+    const model::proto::HyperParameterSpace::Field& field,
+    utils::RandomEngine* random,
+    model::proto::GenericHyperParameters* candidate);
+
 }  // namespace internal
 
 }  // namespace hyperparameters_optimizer_v2
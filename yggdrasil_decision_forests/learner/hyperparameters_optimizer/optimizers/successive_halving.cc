@@ -0,0 +1,239 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/optimizers/successive_halving.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/optimizers/random.h"
+#include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/optimizers/successive_halving.pb.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace model {
+namespace hyperparameters_optimizer_v2 {
+
+constexpr char SuccessiveHalvingOptimizer::kRegisteredName[];
+
+SuccessiveHalvingOptimizer::SuccessiveHalvingOptimizer(
+    const proto::Optimizer& config,
+    const model::proto::HyperParameterSpace& space)
+    : OptimizerInterface(config, space), space_(space) {
+  config_ = config.GetExtension(proto::successive_halving);
+  constructor_status_ = [&]() -> absl::Status {
+    if (config_.reduction_factor() < 2) {
+      return absl::InvalidArgumentError(
+          "\"reduction_factor\" should be greater or equal to 2");
+    }
+    if (config_.minimum_resource() < 1) {
+      return absl::InvalidArgumentError(
+          "\"minimum_resource\" should be greater or equal to 1");
+    }
+    if (config_.maximum_resource() < config_.minimum_resource()) {
+      return absl::InvalidArgumentError(
+          "\"maximum_resource\" should be greater or equal to "
+          "\"minimum_resource\"");
+    }
+    for (const auto& field : space_.fields()) {
+      if (field.name() == config_.resource_field()) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "The resource field \"", config_.resource_field(),
+            "\" is controlled by the optimizer and should not be part of the "
+            "search space"));
+      }
+    }
+    return internal::UpdateWeights(&space_);
+  }();
+
+  if (constructor_status_.ok()) {
+    num_rungs_ = 1;
+    int64_t resource = config_.minimum_resource();
+    while (resource < config_.maximum_resource()) {
+      resource *= config_.reduction_factor();
+      num_rungs_++;
+    }
+    rungs_.resize(num_rungs_);
+  }
+}
+
+int SuccessiveHalvingOptimizer::NumExpectedRounds() {
+  int num_rounds = 0;
+  int64_t rung_trials = config_.num_first_rung_trials();
+  for (int rung_idx = 0; rung_idx < num_rungs_ && rung_trials > 0; rung_idx++) {
+    num_rounds += rung_trials;
+    rung_trials /= config_.reduction_factor();
+  }
+  return num_rounds;
+}
+
+int SuccessiveHalvingOptimizer::RungResource(const int rung_idx) const {
+  int64_t resource = config_.minimum_resource();
+  for (int i = 0; i < rung_idx; i++) {
+    resource *= config_.reduction_factor();
+  }
+  return std::min<int64_t>(resource, config_.maximum_resource());
+}
+
+model::proto::GenericHyperParameters
+SuccessiveHalvingOptimizer::BuildTrialParameters(
+    const model::proto::GenericHyperParameters& base_params,
+    const int rung_idx) const {
+  model::proto::GenericHyperParameters params = base_params;
+  auto* resource_field = params.add_fields();
+  resource_field->set_name(config_.resource_field());
+  resource_field->mutable_value()->set_integer(RungResource(rung_idx));
+  return params;
+}
+
+int SuccessiveHalvingOptimizer::PromotableTrial(const int rung_idx) const {
+  const auto& rung = rungs_[rung_idx];
+
+  int num_evaluated = 0;
+  for (const auto& trial : rung) {
+    if (trial.evaluated && !std::isnan(trial.score)) {
+      num_evaluated++;
+    }
+  }
+  const int num_promotable = num_evaluated / config_.reduction_factor();
+  if (num_promotable == 0) {
+    return -1;
+  }
+
+  int best_trial_idx = -1;
+  for (int trial_idx = 0; trial_idx < rung.size(); trial_idx++) {
+    const auto& trial = rung[trial_idx];
+    if (!trial.evaluated || trial.promoted || std::isnan(trial.score)) {
+      continue;
+    }
+    // Rank of the trial among the evaluated trials of the rung.
+    int rank = 0;
+    for (const auto& other : rung) {
+      if (other.evaluated && !std::isnan(other.score) &&
+          other.score > trial.score) {
+        rank++;
+      }
+    }
+    if (rank >= num_promotable) {
+      continue;
+    }
+    if (best_trial_idx == -1 || trial.score > rung[best_trial_idx].score) {
+      best_trial_idx = trial_idx;
+    }
+  }
+  return best_trial_idx;
+}
+
+utils::StatusOr<NextCandidateStatus> SuccessiveHalvingOptimizer::NextCandidate(
+    model::proto::GenericHyperParameters* candidate) {
+  RETURN_IF_ERROR(constructor_status_);
+
+  // Promote, in priority, the trials closest to the final resource.
+  for (int rung_idx = num_rungs_ - 2; rung_idx >= 0; rung_idx--) {
+    const int trial_idx = PromotableTrial(rung_idx);
+    if (trial_idx == -1) {
+      continue;
+    }
+    auto& promoted_trial = rungs_[rung_idx][trial_idx];
+    promoted_trial.promoted = true;
+
+    Trial new_trial;
+    new_trial.base_params = promoted_trial.base_params;
+    rungs_[rung_idx + 1].push_back(std::move(new_trial));
+
+    *candidate = BuildTrialParameters(
+        rungs_[rung_idx + 1].back().base_params, rung_idx + 1);
+    running_trials_[candidate->ShortDebugString()] = std::make_pair(
+        rung_idx + 1, static_cast<int>(rungs_[rung_idx + 1].size()) - 1);
+    return NextCandidateStatus::kNewCandidateAvailable;
+  }
+
+  // Start a new trial at the first rung.
+  if (!first_rung_exhausted_ &&
+      num_started_first_rung_trials_ < config_.num_first_rung_trials()) {
+    model::proto::GenericHyperParameters base_params;
+    int tries_left = num_tries_per_candidates_;
+    while (true) {
+      base_params.Clear();
+      for (const auto& field : space_.fields()) {
+        RETURN_IF_ERROR(internal::BuildRandomSet(field, &rnd_, &base_params));
+      }
+      if (already_proposed_candidates_.insert(base_params.ShortDebugString())
+              .second) {
+        break;
+      }
+      if (--tries_left == 0) {
+        first_rung_exhausted_ = true;
+        break;
+      }
+    }
+    if (!first_rung_exhausted_) {
+      num_started_first_rung_trials_++;
+
+      Trial new_trial;
+      new_trial.base_params = base_params;
+      rungs_.front().push_back(std::move(new_trial));
+
+      *candidate = BuildTrialParameters(base_params, 0);
+      running_trials_[candidate->ShortDebugString()] = std::make_pair(
+          0, static_cast<int>(rungs_.front().size()) - 1);
+      return NextCandidateStatus::kNewCandidateAvailable;
+    }
+  }
+
+  if (!running_trials_.empty()) {
+    // Pending evaluations can unlock promotions.
+    return NextCandidateStatus::kWaitForEvaluation;
+  }
+  return NextCandidateStatus::kExplorationIsDone;
+}
+
+absl::Status SuccessiveHalvingOptimizer::ConsumeEvaluation(
+    const model::proto::GenericHyperParameters& candidate, const double score) {
+  RETURN_IF_ERROR(constructor_status_);
+  const auto it_running = running_trials_.find(candidate.ShortDebugString());
+  if (it_running == running_trials_.end()) {
+    return absl::InvalidArgumentError(
+        "The evaluated candidate was not generated by \"NextCandidate\"");
+  }
+  auto& trial = rungs_[it_running->second.first][it_running->second.second];
+  running_trials_.erase(it_running);
+  trial.evaluated = true;
+  if (std::isnan(score)) {
+    // Unfeasible trial.
+    return absl::OkStatus();
+  }
+  if (!std::isfinite(score)) {
+    return absl::InvalidArgumentError("Non finite score");
+  }
+  trial.score = score;
+  if (std::isnan(best_score_) || score > best_score_) {
+    best_score_ = score;
+    best_params_ = candidate;
+  }
+  return absl::OkStatus();
+}
+
+std::pair<model::proto::GenericHyperParameters, double>
+SuccessiveHalvingOptimizer::BestParameters() {
+  return std::make_pair(best_params_, best_score_);
+}
+
+}  // namespace hyperparameters_optimizer_v2
+}  // namespace model
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef YGGDRASIL_DECISION_FORESTS_LEARNER_HYPERPARAMETER_OPTIMIZER_SUCCESSIVE_HALVING_H_
+#define YGGDRASIL_DECISION_FORESTS_LEARNER_HYPERPARAMETER_OPTIMIZER_SUCCESSIVE_HALVING_H_
+
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/node_hash_map.h"
+#include "absl/container/node_hash_set.h"
+#include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/optimizer_interface.h"
+#include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/optimizers/successive_halving.pb.h"
+#include "yggdrasil_decision_forests/utils/random.h"
+
+namespace yggdrasil_decision_forests {
+namespace model {
+namespace hyperparameters_optimizer_v2 {
+
+// Asynchronous successive halving (ASHA).
+//
+// Random candidates are first trained with a small resource budget (the
+// "resource_field" hyperparameter e.g. "num_trees" is set by the optimizer).
+// When a trial completes, the candidates ranked in the top
+// "1/reduction_factor" of their rung are re-trained with
+// "reduction_factor" times more resource. Losing candidates are never trained
+// with a large budget, which multiplies the effective search throughput.
+// Promotions are asynchronous: a candidate can be promoted while other trials
+// of its rung are still running.
+//
+// See "A System for Massively Parallel Hyperparameter Tuning" (Li et al.,
+// 2020) for a description and an analysis of the algorithm.
+class SuccessiveHalvingOptimizer : public OptimizerInterface {
+ public:
+  // Unique identifier of the optimizer algorithm.
+  static constexpr char kRegisteredName[] = "SUCCESSIVE_HALVING";
+
+  SuccessiveHalvingOptimizer(const proto::Optimizer& config,
+                             const model::proto::HyperParameterSpace& space);
+
+  utils::StatusOr<NextCandidateStatus> NextCandidate(
+      model::proto::GenericHyperParameters* candidate) override;
+
+  absl::Status ConsumeEvaluation(
+      const model::proto::GenericHyperParameters& candidate,
+      const double score) override;
+
+  std::pair<model::proto::GenericHyperParameters, double> BestParameters()
+      override;
+
+  int NumExpectedRounds() override;
+
+ private:
+  // A candidate trained (or being trained) with the resource of one rung.
+  struct Trial {
+    model::proto::GenericHyperParameters base_params;
+    double score = std::numeric_limits<double>::quiet_NaN();
+    bool evaluated = false;
+    bool promoted = false;
+  };
+
+  // Resource allocated to the trials of the "rung_idx"-th rung.
+  int RungResource(int rung_idx) const;
+
+  // Assembles the hyperparameters of a trial: the base parameters and the
+  // resource field of the rung.
+  model::proto::GenericHyperParameters BuildTrialParameters(
+      const model::proto::GenericHyperParameters& base_params,
+      int rung_idx) const;
+
+  // Index, in "rungs_[rung_idx]", of the best evaluated trial ranked in the
+  // top "1/reduction_factor" of the rung and not yet promoted. -1 if no such
+  // trial exists.
+  int PromotableTrial(int rung_idx) const;
+
+  // Configuration of the optimizer.
+  proto::SuccessiveHalvingOptimizerConfig config_;
+
+  // Search space.
+  model::proto::HyperParameterSpace space_;
+
+  // Number of rungs i.e. number of resource levels.
+  int num_rungs_ = 0;
+
+  // "rungs_[i]" are the trials started with the "i"-th resource level.
+  std::vector<std::vector<Trial>> rungs_;
+
+  // Trials currently being evaluated, indexed by the serialized candidate and
+  // mapped to the (rung, trial) coordinates.
+  absl::node_hash_map<std::string, std::pair<int, int>> running_trials_;
+
+  // Number of trials started at the first rung.
+  int num_started_first_rung_trials_ = 0;
+
+  // True when no new unique first rung candidate could be generated.
+  bool first_rung_exhausted_ = false;
+
+  // Best hyper-parameter found so far.
+  model::proto::GenericHyperParameters best_params_;
+
+  // Score of the best hyper-parameter found so far.
+  double best_score_ = std::numeric_limits<double>::quiet_NaN();
+
+  // Random generator.
+  utils::RandomEngine rnd_;
+
+  // Set of already generated first rung candidates (to avoid duplicates).
+  // Note: We use the string representation of the proto as a unique identifier.
+  absl::node_hash_set<std::string> already_proposed_candidates_;
+
+  // Number of tries to generate a unique new candidate. If no new candidate
+  // could be generated, the first rung is considered exhausted.
+  const int num_tries_per_candidates_ = 512;
+
+  absl::Status constructor_status_;
+};
+
+REGISTER_AbstractHyperParametersOptimizer(
+    SuccessiveHalvingOptimizer, SuccessiveHalvingOptimizer::kRegisteredName);
+
+}  // namespace hyperparameters_optimizer_v2
+}  // namespace model
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_LEARNER_HYPERPARAMETER_OPTIMIZER_SUCCESSIVE_HALVING_H_
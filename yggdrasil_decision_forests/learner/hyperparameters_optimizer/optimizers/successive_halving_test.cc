@@ -0,0 +1,143 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/optimizers/successive_halving.h"
+
+#include <limits>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/hyperparameters_optimizer.pb.h"
+#include "yggdrasil_decision_forests/learner/hyperparameters_optimizer/optimizer_interface.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+
+namespace yggdrasil_decision_forests {
+namespace model {
+namespace hyperparameters_optimizer_v2 {
+namespace {
+
+// Value of the field "field_name" in "params". Fails if the field is missing.
+int GetIntegerField(const model::proto::GenericHyperParameters& params,
+                    const std::string& field_name) {
+  for (const auto& field : params.fields()) {
+    if (field.name() == field_name) {
+      return field.value().integer();
+    }
+  }
+  LOG(FATAL) << "Missing field " << field_name;
+  return -1;
+}
+
+TEST(SuccessiveHalving, Base) {
+  model::proto::HyperParameterSpace search_space = PARSE_TEST_PROTO(R"pb(
+    fields {
+      name: "a"
+      discrete_candidates {
+        possible_values { integer: 1 }
+        possible_values { integer: 2 }
+        possible_values { integer: 3 }
+        possible_values { integer: 4 }
+        possible_values { integer: 5 }
+        possible_values { integer: 6 }
+        possible_values { integer: 7 }
+        possible_values { integer: 8 }
+        possible_values { integer: 9 }
+        possible_values { integer: 10 }
+        possible_values { integer: 11 }
+        possible_values { integer: 12 }
+        possible_values { integer: 13 }
+        possible_values { integer: 14 }
+        possible_values { integer: 15 }
+        possible_values { integer: 16 }
+      }
+    }
+  )pb");
+
+  proto::Optimizer optimizer_config;
+  auto& spe_config =
+      *optimizer_config.MutableExtension(proto::successive_halving);
+  spe_config.set_num_first_rung_trials(8);
+  spe_config.set_resource_field("num_trees");
+  spe_config.set_minimum_resource(10);
+  spe_config.set_maximum_resource(40);
+  spe_config.set_reduction_factor(2);
+
+  SuccessiveHalvingOptimizer optimizer(optimizer_config, search_space);
+  EXPECT_EQ(optimizer.NumExpectedRounds(), 8 + 4 + 2);
+
+  int trial_idx = 0;
+  while (true) {
+    model::proto::GenericHyperParameters candidate;
+    auto status = optimizer.NextCandidate(&candidate).value();
+    if (status == NextCandidateStatus::kExplorationIsDone) {
+      // No more parameters to evaluate.
+      break;
+    } else if (status == NextCandidateStatus::kWaitForEvaluation) {
+      LOG(FATAL) << "Should not append. As no evaluation pending.";
+    }
+
+    LOG(INFO) << "candidate: " << candidate.ShortDebugString();
+
+    // The score increases with both the quality of the candidate and the
+    // allocated resource.
+    const double evaluation = GetIntegerField(candidate, "a") +
+                              0.01 * GetIntegerField(candidate, "num_trees");
+    CHECK_OK(optimizer.ConsumeEvaluation(candidate, evaluation));
+    trial_idx++;
+  }
+
+  // 8 trials at the first rung, plus the promotions. At least 1/2 of the
+  // trials of a rung are promoted. Early asynchronous promotions can promote
+  // a few more.
+  EXPECT_GE(trial_idx, 8 + 4 + 2);
+  EXPECT_LE(trial_idx, 8 + 8 + 8);
+
+  model::proto::GenericHyperParameters best_params;
+  double best_score;
+  std::tie(best_params, best_score) = optimizer.BestParameters();
+
+  // The best candidate was trained with the final resource.
+  EXPECT_EQ(GetIntegerField(best_params, "num_trees"), 40);
+  EXPECT_NEAR(best_score, GetIntegerField(best_params, "a") + 0.4, 0.0001);
+
+  LOG(INFO) << "trial_idx: " << trial_idx << " score: " << best_score
+            << " params: " << best_params.DebugString();
+}
+
+TEST(SuccessiveHalving, InvalidConfiguration) {
+  model::proto::HyperParameterSpace search_space = PARSE_TEST_PROTO(R"pb(
+    fields {
+      name: "num_trees"
+      discrete_candidates {
+        possible_values { integer: 1 }
+        possible_values { integer: 2 }
+      }
+    }
+  )pb");
+
+  // The resource field cannot be part of the search space.
+  proto::Optimizer optimizer_config;
+  optimizer_config.MutableExtension(proto::successive_halving)
+      ->set_resource_field("num_trees");
+  SuccessiveHalvingOptimizer optimizer(optimizer_config, search_space);
+  model::proto::GenericHyperParameters candidate;
+  EXPECT_FALSE(optimizer.NextCandidate(&candidate).ok());
+}
+
+}  // namespace
+}  // namespace hyperparameters_optimizer_v2
+}  // namespace model
+}  // namespace yggdrasil_decision_forests
@@ -419,10 +419,11 @@ RandomForestLearner::TrainWithStatus(
   // all the examples have the same weight.
   //
   // Currently, this feature is supported for:
-  // - Classification without oblique splits (default) and with local
-  //   imputation policy (default) to handle missing values.
+  // - Classification and regression without oblique splits (default) and with
+  //   local imputation policy (default) to handle missing values.
   bool use_optimized_unit_weights = false;
-  if (training_config().task() == model::proto::Task::CLASSIFICATION &&
+  if ((training_config().task() == model::proto::Task::CLASSIFICATION ||
+       training_config().task() == model::proto::Task::REGRESSION) &&
       rf_config.decision_tree().split_axis_case() !=
           decision_tree::proto::DecisionTreeTrainingConfig::
               kSparseObliqueSplit) {
@@ -459,11 +460,13 @@ RandomForestLearner::TrainWithStatus(
   }
 
   // OOB (out-of-bag) predictions.
-  utils::concurrency::Mutex
-      oob_metrics_mutex;  // Protects all the "oob_*" fields.
+  // Protects the "oob_*" fields, except "oob_predictions" which is sharded
+  // (see "oob_shard_mutexes").
+  utils::concurrency::Mutex oob_metrics_mutex;
 
   // Prediction accumulator for each example in the training dataset
-  // (oob_predictions.size()==training_dataset.nrow()).
+  // (oob_predictions.size()==training_dataset.nrow()). Protected by
+  // "oob_shard_mutexes".
   std::vector<internal::PredictionAccumulator> oob_predictions;
 
   // Time of the last display of OOB metrics in the console. Expressed in
@@ -492,6 +495,12 @@ RandomForestLearner::TrainWithStatus(
       rf_config.compute_oob_variable_importances() &&
       rf_config.bootstrap_training_dataset();
 
+  // Mutexes protecting "oob_predictions" by shards of examples. Several trees
+  // can accumulate their OOB predictions at the same time: they only serialize
+  // on the shards they are both updating.
+  internal::ExampleShardedMutexes oob_shard_mutexes(
+      train_dataset.nrow(), std::max(1, deployment().num_threads() * 4));
+
   if (compute_oob_performances) {
     internal::InitializeOOBPredictionAccumulators(
         train_dataset.nrow(), config_with_default, config_link,
@@ -530,6 +539,19 @@ RandomForestLearner::TrainWithStatus(
         kAdaptativeWarmUpSeconds, rf_config.min_adapted_subsample());
   }
 
+  // Wall-clock budget for the OOB variable importances: a random subset of
+  // the (tree, feature) permutation passes is skipped to fit in the budget.
+  std::unique_ptr<utils::DeadlineAwareWork> vi_budget_manager;
+  if (compute_oob_variable_importances &&
+      rf_config.maximum_oob_variable_importances_duration_seconds() > 0) {
+    vi_budget_manager = absl::make_unique<utils::DeadlineAwareWork>(
+        rf_config.num_trees() * config_link.features_size() *
+            rf_config.num_oob_variable_importances_permutations(),
+        rf_config.maximum_oob_variable_importances_duration_seconds() *
+            deployment().num_threads(),
+        kAdaptativeWarmUpSeconds, /*min_factor=*/0.);
+  }
+
   // Various fields modified by the various training workers.
   struct {
     // Number of nodes in the "completed" trees.
@@ -558,6 +580,16 @@ RandomForestLearner::TrainWithStatus(
         mdl->AbstractAttributesSizeInBytes();
   }
 
+  // Reusable buffers for the example sampling. A tree-training job takes a
+  // buffer from the list (or creates an empty one) and returns it when done:
+  // the number of allocated buffers is bounded by the number of threads
+  // instead of the number of trees, and the buffer capacities are reused
+  // across trees.
+  struct {
+    std::vector<std::vector<UnsignedExampleIdx>> buffers GUARDED_BY(mutex);
+    utils::concurrency::Mutex mutex;
+  } sampling_buffers;
+
   // Note: "num_trained_trees" is defined outside of the following brackets so
   // to make use it is not released before "pool".
   std::atomic<int> num_trained_trees{0};
@@ -627,6 +659,13 @@ RandomForestLearner::TrainWithStatus(
         // Examples selected for the training.
         // Note: This in the inverse of the Out-of-bag (OOB) set.
         std::vector<UnsignedExampleIdx> selected_examples;
+        {
+          utils::concurrency::MutexLock lock(&sampling_buffers.mutex);
+          if (!sampling_buffers.buffers.empty()) {
+            selected_examples = std::move(sampling_buffers.buffers.back());
+            sampling_buffers.buffers.pop_back();
+          }
+        }
         auto& decision_tree = (*mdl->mutable_decision_trees())[tree_idx];
         if (rf_config.bootstrap_training_dataset()) {
           if (!rf_config.sampling_with_replacement() &&
@@ -736,12 +775,15 @@ RandomForestLearner::TrainWithStatus(
 
         // OOB Metrics.
         if (compute_oob_performances) {
-          utils::concurrency::MutexLock lock(&oob_metrics_mutex);
-          // Update the prediction accumulator.
+          // Update the prediction accumulators. Only the shard of examples
+          // being updated is locked: the accumulation passes of the different
+          // trees run in parallel.
           internal::UpdateOOBPredictionsWithNewTree(
               train_dataset, config_with_default, selected_examples,
               rf_config.winner_take_all_inference(), *decision_tree, {},
-              &random, &oob_predictions);
+              &random, &oob_predictions, &oob_shard_mutexes);
+
+          utils::concurrency::MutexLock lock(&oob_metrics_mutex);
 
           // Evaluate the accumulated predictions.
           // Compute OOB if one of the condition is true:
@@ -762,6 +804,8 @@ RandomForestLearner::TrainWithStatus(
             last_oob_computation_num_trees = current_num_trained_trees;
             proto::OutOfBagTrainingEvaluations evaluation;
             evaluation.set_number_of_trees(current_num_trained_trees);
+            // Pause the accumulator updates while reading them.
+            const auto shard_locks = oob_shard_mutexes.LockAll();
             auto evaluation_or = internal::EvaluateOOBPredictions(
                 train_dataset, mdl->task(), mdl->label_col_idx(),
                 mdl->uplift_treatment_col_idx(), mdl->weights(),
@@ -797,18 +841,51 @@ RandomForestLearner::TrainWithStatus(
           }
 
           // Variable importance.
+          //
+          // The features are processed in parallel: each feature only
+          // touches its own prediction accumulator.
           if (compute_oob_variable_importances) {
+            utils::concurrency::ThreadPool vi_pool(
+                "oob_variable_importances",
+                std::max(1, std::min<int>(config_link.features_size(),
+                                          deployment().num_threads())));
+            vi_pool.StartWorkers();
             for (const int feature_idx : config_link.features()) {
-              for (int permutation_idx = 0;
-                   permutation_idx <
-                   rf_config.num_oob_variable_importances_permutations();
-                   permutation_idx++) {
-                internal::UpdateOOBPredictionsWithNewTree(
-                    train_dataset, config_with_default, selected_examples,
-                    rf_config.winner_take_all_inference(), *decision_tree,
-                    feature_idx, &random,
-                    &oob_predictions_per_input_features[feature_idx]);
-              }
+              vi_pool.Schedule([&train_dataset, &config_with_default,
+                                &selected_examples, &rf_config, &decision_tree,
+                                &oob_predictions_per_input_features,
+                                &vi_budget_manager, feature_idx,
+                                seed{random()}]() {
+                utils::RandomEngine rnd(seed);
+                for (int permutation_idx = 0;
+                     permutation_idx <
+                     rf_config.num_oob_variable_importances_permutations();
+                     permutation_idx++) {
+                  if (vi_budget_manager != nullptr) {
+                    // Skips a random subset of the permutation passes to fit
+                    // in the budget.
+                    const double factor =
+                        vi_budget_manager->NextApproximationFactor();
+                    if (std::uniform_real_distribution<double>()(rnd) >=
+                        factor) {
+                      vi_budget_manager->ReportTaskDone(
+                          /*approximation_factor=*/0., /*duration_seconds=*/0.);
+                      continue;
+                    }
+                  }
+                  const auto begin_pass = absl::Now();
+                  internal::UpdateOOBPredictionsWithNewTree(
+                      train_dataset, config_with_default, selected_examples,
+                      rf_config.winner_take_all_inference(), *decision_tree,
+                      feature_idx, &rnd,
+                      &oob_predictions_per_input_features[feature_idx]);
+                  if (vi_budget_manager != nullptr) {
+                    vi_budget_manager->ReportTaskDone(
+                        /*approximation_factor=*/1.,
+                        absl::ToDoubleSeconds(absl::Now() - begin_pass));
+                  }
+                }
+              });
             }
           }
         } else {
@@ -817,6 +894,12 @@ RandomForestLearner::TrainWithStatus(
                     << rf_config.num_trees() << " (tree index:" << tree_idx
                     << ") done");
         }
+
+        // Return the sampling buffer for reuse by the next trees.
+        {
+          utils::concurrency::MutexLock lock(&sampling_buffers.mutex);
+          sampling_buffers.buffers.push_back(std::move(selected_examples));
+        }
       });
     }
   }
@@ -880,9 +963,16 @@ RandomForestLearner::TrainWithStatus(
   }
 
   if (compute_oob_variable_importances) {
+    if (vi_budget_manager != nullptr) {
+      LOG(INFO) << "OOB variable importances computed on "
+                << vi_budget_manager->AchievedFraction() * 100.
+                << "% of the (tree, feature) permutation passes to satisfy "
+                   "the \"maximum_oob_variable_importances_duration_seconds\" "
+                   "budget.";
+    }
     RETURN_IF_ERROR(ComputeVariableImportancesFromAccumulatedPredictions(
         oob_predictions, oob_predictions_per_input_features, train_dataset,
-        mdl.get()));
+        mdl.get(), deployment().num_threads()));
   }
 
   utils::usage::OnTrainingEnd(train_dataset.data_spec(), config_with_default,
@@ -945,6 +1035,23 @@ void InitializeOOBPredictionAccumulators(
   }
 }
 
+ExampleShardedMutexes::ExampleShardedMutexes(
+    const UnsignedExampleIdx num_examples, const int num_shards)
+    : shard_size_(std::max(UnsignedExampleIdx{1},
+                           (num_examples + num_shards - 1) / num_shards)),
+      mutexes_(num_shards) {}
+
+std::vector<std::unique_ptr<utils::concurrency::MutexLock>>
+ExampleShardedMutexes::LockAll() {
+  std::vector<std::unique_ptr<utils::concurrency::MutexLock>> locks;
+  locks.reserve(mutexes_.size());
+  for (auto& mutex : mutexes_) {
+    locks.push_back(
+        absl::make_unique<utils::concurrency::MutexLock>(&mutex));
+  }
+  return locks;
+}
+
 void UpdateOOBPredictionsWithNewTree(
     const dataset::VerticalDataset& train_dataset,
     const model::proto::TrainingConfig& config,
@@ -952,7 +1059,8 @@ void UpdateOOBPredictionsWithNewTree(
     const bool winner_take_all_inference,
     const decision_tree::DecisionTree& new_decision_tree,
     const absl::optional<int> shuffled_attribute_idx, utils::RandomEngine* rnd,
-    std::vector<PredictionAccumulator>* oob_predictions) {
+    std::vector<PredictionAccumulator>* oob_predictions,
+    ExampleShardedMutexes* sharded_mutexes) {
   // "next_non_oob_example_idx" is the index in "sorted_non_oob_example_indices"
   // of the example, with the smallest index which is greater or equal to the
   // index of the example being iterator on in the following "for loop".
@@ -961,6 +1069,10 @@ void UpdateOOBPredictionsWithNewTree(
   std::uniform_int_distribution<UnsignedExampleIdx> row_distribution(
       0, train_dataset.nrow() - 1);
 
+  // Shard of "sharded_mutexes" currently locked, or -1.
+  int locked_shard_idx = -1;
+  absl::optional<utils::concurrency::MutexLock> shard_lock;
+
   for (UnsignedExampleIdx example_idx = 0; example_idx < train_dataset.nrow();
        example_idx++) {
     // Skip the example_idx in "sorted_non_oob_example_indices".
@@ -975,6 +1087,17 @@ void UpdateOOBPredictionsWithNewTree(
       continue;
     }
 
+    // Lock the shard of the example. The shards are visited in increasing
+    // order while holding at most one mutex at a time: no deadlock.
+    if (sharded_mutexes != nullptr) {
+      const int shard_idx = example_idx / sharded_mutexes->shard_size();
+      if (shard_idx != locked_shard_idx) {
+        shard_lock.reset();
+        shard_lock.emplace(sharded_mutexes->mutex(shard_idx));
+        locked_shard_idx = shard_idx;
+      }
+    }
+
     // Apply the decision tree.
     const decision_tree::proto::Node* leaf;
     if (shuffled_attribute_idx.has_value()) {
@@ -1106,7 +1229,8 @@ absl::Status ComputeVariableImportancesFromAccumulatedPredictions(
     const std::vector<internal::PredictionAccumulator>& oob_predictions,
     const std::vector<std::vector<internal::PredictionAccumulator>>&
         oob_predictions_per_input_features,
-    const dataset::VerticalDataset& dataset, RandomForestModel* model) {
+    const dataset::VerticalDataset& dataset, RandomForestModel* model,
+    const int num_threads) {
   // Note: "for_permutation_importance=true" allows to compute AUC, PR-AUC and
   // other expensive evaluation metrics.
   ASSIGN_OR_RETURN(
@@ -1131,7 +1255,8 @@ absl::Status ComputeVariableImportancesFromAccumulatedPredictions(
   };
 
   return utils::ComputePermutationFeatureImportance(
-      base_evaluation, permutation_evaluation, model);
+      base_evaluation, permutation_evaluation, model, /*num_rounds=*/1,
+      num_threads);
 }
 
 void InitializeModelWithTrainingConfig(
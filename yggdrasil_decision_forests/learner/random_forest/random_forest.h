@@ -42,6 +42,7 @@
 #include "yggdrasil_decision_forests/utils/distribution.h"
 #include "yggdrasil_decision_forests/utils/hyper_parameters.h"
 #include "yggdrasil_decision_forests/utils/random.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 namespace yggdrasil_decision_forests {
 namespace model {
@@ -136,6 +137,32 @@ void InitializeOOBPredictionAccumulators(
     const dataset::proto::DataSpecification& data_spec,
     std::vector<PredictionAccumulator>* predictions);
 
+// Mutexes protecting contiguous ranges ("shards") of example indices. Used to
+// accumulate the OOB predictions of several trees in parallel: two trees only
+// serialize when they update the accumulators of the same shard of examples.
+class ExampleShardedMutexes {
+ public:
+  ExampleShardedMutexes(UnsignedExampleIdx num_examples, int num_shards);
+
+  // Number of examples protected by each mutex.
+  UnsignedExampleIdx shard_size() const { return shard_size_; }
+
+  // Mutex protecting the examples
+  // [shard_idx*shard_size(), (shard_idx+1)*shard_size()).
+  utils::concurrency::Mutex* mutex(int shard_idx) {
+    return &mutexes_[shard_idx];
+  }
+
+  // Locks all the shards, in order, e.g. to read all the accumulators
+  // consistently. The shards are released when the returned locks are
+  // destroyed.
+  std::vector<std::unique_ptr<utils::concurrency::MutexLock>> LockAll();
+
+ private:
+  UnsignedExampleIdx shard_size_;
+  std::vector<utils::concurrency::Mutex> mutexes_;
+};
+
 // Add the predictions of a decision tree to a set of predictor accumulators.
 // The tree is applied only on the example indices NOT contained in
 // "sorted_non_oob_example_indices".
@@ -143,6 +170,11 @@ void InitializeOOBPredictionAccumulators(
 // If "shuffled_attribute_idx" is set, the decision tree will be applied while
 // simulating the random shuffling of the value of the attribute
 // "shuffled_attribute_idx.value()" using "rnd" as source of randomness.
+//
+// If "sharded_mutexes" is set, the accumulator of an example is only modified
+// while holding the mutex of its shard: several trees can accumulate their
+// predictions concurrently. If null, the caller is in charge of the
+// synchronization.
 void UpdateOOBPredictionsWithNewTree(
     const dataset::VerticalDataset& train_dataset,
     const model::proto::TrainingConfig& config,
@@ -150,7 +182,8 @@ void UpdateOOBPredictionsWithNewTree(
     const bool winner_take_all_inference,
     const decision_tree::DecisionTree& new_decision_tree,
     const absl::optional<int> shuffled_attribute_idx, utils::RandomEngine* rnd,
-    std::vector<PredictionAccumulator>* oob_predictions);
+    std::vector<PredictionAccumulator>* oob_predictions,
+    ExampleShardedMutexes* sharded_mutexes = nullptr);
 
 // Evaluates the OOB predictions. Examples without any tree predictions are
 // skipped.
@@ -163,11 +196,13 @@ utils::StatusOr<metric::proto::EvaluationResults> EvaluateOOBPredictions(
     bool for_permutation_importance = false);
 
 // Update the variable importance of the model with set of oob predictions.
+// The features are scored with "num_threads" threads.
 absl::Status ComputeVariableImportancesFromAccumulatedPredictions(
     const std::vector<internal::PredictionAccumulator>& oob_predictions,
     const std::vector<std::vector<internal::PredictionAccumulator>>&
         oob_predictions_per_input_features,
-    const dataset::VerticalDataset& dataset, RandomForestModel* model);
+    const dataset::VerticalDataset& dataset, RandomForestModel* model,
+    int num_threads = 1);
 
 // Selects the examples to train one tree. Selects "num_samples" integers in [0,
 // num_examples[ with replacement.
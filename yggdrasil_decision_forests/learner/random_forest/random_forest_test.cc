@@ -749,6 +749,56 @@ TEST(RandomForest, OOBPredictions) {
             "accuracy:0.5 logloss:18.0218");
 }
 
+// Same accumulation as "OOBPredictions", but protected by sharded mutexes:
+// the accumulated predictions are identical.
+TEST(RandomForest, OOBPredictionsSharded) {
+  const model::proto::TrainingConfig config = PARSE_TEST_PROTO(R"pb(
+    task: CLASSIFICATION
+  )pb");
+  const model::proto::TrainingConfigLinking config_link = PARSE_TEST_PROTO(R"pb(
+    label: 1
+    num_label_classes: 3
+  )pb");
+
+  utils::RandomEngine rnd;
+  RandomForestModel model;
+  dataset::VerticalDataset dataset;
+  BuildToyModelAndToyDataset(model::proto::Task::CLASSIFICATION, &model,
+                             &dataset);
+
+  std::vector<internal::PredictionAccumulator> predictions;
+  internal::InitializeOOBPredictionAccumulators(
+      dataset.nrow(), config, config_link, dataset.data_spec(), &predictions);
+
+  // More shards than examples: the last shards are empty.
+  internal::ExampleShardedMutexes sharded_mutexes(dataset.nrow(),
+                                                  /*num_shards=*/8);
+
+  std::vector<UnsignedExampleIdx> sorted_non_oob_example_indices = {1};
+  internal::UpdateOOBPredictionsWithNewTree(
+      dataset, config, sorted_non_oob_example_indices, true,
+      *model.decision_trees()[0].get(), {}, &rnd, &predictions,
+      &sharded_mutexes);
+  internal::UpdateOOBPredictionsWithNewTree(
+      dataset, config, sorted_non_oob_example_indices, true,
+      *model.decision_trees()[1].get(), {}, &rnd, &predictions,
+      &sharded_mutexes);
+
+  EXPECT_EQ(predictions[0].num_trees, 2);
+  EXPECT_EQ(predictions[0].classification.TopClass(), 1);
+  EXPECT_EQ(predictions[1].num_trees, 0);
+  EXPECT_EQ(predictions[2].num_trees, 2);
+  EXPECT_EQ(predictions[2].classification.TopClass(), 0);
+
+  const auto locks = sharded_mutexes.LockAll();
+  const auto evaluation =
+      internal::EvaluateOOBPredictions(dataset, config.task(),
+                                       config_link.label(), -1, {}, predictions)
+          .value();
+  EXPECT_EQ(internal::EvaluationSnippet(evaluation),
+            "accuracy:0.5 logloss:18.0218");
+}
+
 TEST(RandomForest, ComputeVariableImportancesFromAccumulatedPredictions) {
   const model::proto::TrainingConfig config = PARSE_TEST_PROTO(R"pb(
     task: CLASSIFICATION
@@ -1,5 +1,6 @@
 # Third party libraries
 load("//third_party/gtest:workspace.bzl", gtest = "deps")
+load("//third_party/benchmark:workspace.bzl", benchmark = "deps")
 load("//third_party/absl:workspace.bzl", absl = "deps")
 load("//third_party/protobuf:workspace.bzl", protobuf = "deps")
 load("//third_party/zlib:workspace.bzl", zlib = "deps")
@@ -8,11 +9,15 @@ load("//third_party/farmhash:workspace.bzl", farmhash = "deps")
 load("//third_party/boost:workspace.bzl", boost = "deps")
 load("//third_party/grpc:workspace.bzl", grpc = "deps")
 load("//third_party/rapidjson:workspace.bzl", rapidjson = "deps")
+load("//third_party/arrow:workspace.bzl", arrow = "deps")
 
 def load_dependencies(repo_name = "", exclude_repo = []):
     if "gtest" not in exclude_repo:
         gtest()
 
+    if "benchmark" not in exclude_repo:
+        benchmark()
+
     if "absl" not in exclude_repo:
         absl()
 
@@ -36,3 +41,6 @@ def load_dependencies(repo_name = "", exclude_repo = []):
 
     if "rapidjson" not in exclude_repo:
         rapidjson(prefix = repo_name)
+
+    if "arrow" not in exclude_repo:
+        arrow(prefix = repo_name)
@@ -32,6 +32,66 @@ namespace yggdrasil_decision_forests {
 namespace metric {
 using ::yggdrasil_decision_forests::model::proto::CLASSIFICATION;
 
+namespace {
+
+// Implementation of "OneSidedMcNemarTest" on the columnar representation of
+// the sampled predictions. Packing the predictions once lets the callers run
+// the test at many thresholds without re-walking the prediction protos.
+utils::StatusOr<float> OneSidedMcNemarTestOnPackedPredictions(
+    const PackedPredictions& packed1, const PackedPredictions& packed2,
+    const int roc_idx, const float threshold1, const float threshold2) {
+  STATUS_CHECK_EQ(packed1.num_examples(), packed2.num_examples());
+  if (packed1.num_examples() == 0) {
+    return 1.0;
+  }
+  STATUS_CHECK_LT(roc_idx, packed1.num_classes);
+  STATUS_CHECK_LT(roc_idx, packed2.num_classes);
+
+  // Compute n12 and n21.
+  double n12 = 0.0;
+  double n21 = 0.0;
+  for (size_t i = 0; i < packed1.num_examples(); ++i) {
+    const int ground_truth = packed1.classification_ground_truths[i];
+    STATUS_CHECK_EQ(ground_truth, packed2.classification_ground_truths[i]);
+    STATUS_CHECK_GT(packed1.classification_distribution_sums[i], 0);
+    STATUS_CHECK_GT(packed2.classification_distribution_sums[i], 0);
+
+    const float prediction1 =
+        packed1
+            .classification_probabilities[i * packed1.num_classes + roc_idx];
+    const float prediction2 =
+        packed2
+            .classification_probabilities[i * packed2.num_classes + roc_idx];
+
+    const bool correct1 =
+        (prediction1 >= threshold1) == (ground_truth == roc_idx);
+    const bool correct2 =
+        (prediction2 >= threshold2) == (ground_truth == roc_idx);
+
+    // The metric is not perfectly designed to take weights as input. If the
+    // weights are imbalanced (for e.g if the weights are much larger than 1),
+    // then this test does not work correctly. However, if enough samples are
+    // collected, and the weights are not very imbalanced, this test works fine
+    // (although a bit optimistically).
+    if (correct1 && !correct2) {
+      n12 += packed1.weights[i];
+    }
+    if (!correct1 && correct2) {
+      n21 += packed1.weights[i];
+    }
+  }
+  if (n12 + n21 == 0.0) {
+    return 1.0;
+  }
+
+  const boost::math::binomial_distribution<double> distribution(n12 + n21, 0.5);
+  const float pvalue = 1 - boost::math::cdf(distribution, n12);
+
+  return static_cast<float>(pvalue);
+}
+
+}  // namespace
+
 dataset::proto::DataSpecification CreateDataSpecForComparisonTable(
     const proto::EvaluationOptions& option,
     const proto::EvaluationResults& example_of_evaluation) {
@@ -173,6 +233,12 @@ utils::StatusOr<std::vector<std::pair<std::string, float>>> OneSidedMcNemarTest(
     return labels_and_p_values;
   }
 
+  // Pack the predictions once: the tests below only differ by the thresholds.
+  ASSIGN_OR_RETURN(const PackedPredictions packed1,
+                   PackPredictions(eval_results1));
+  ASSIGN_OR_RETURN(const PackedPredictions packed2,
+                   PackPredictions(eval_results2));
+
   // For each roc value.
   for (int roc_idx = 0; roc_idx < eval_results1.classification().rocs_size();
        ++roc_idx) {
@@ -189,10 +255,10 @@ utils::StatusOr<std::vector<std::pair<std::string, float>>> OneSidedMcNemarTest(
         absl::StrCat(dataset::CategoricalIdxToRepresentation(
                          eval_results1.label_column(), roc_idx),
                      "_vs_the_others", "@MaxAccuracy");
-    ASSIGN_OR_RETURN(
-        const float pvalue,
-        OneSidedMcNemarTest(eval_results1, eval_results2, roc_idx,
-                            max_accuracy_threshold1, max_accuracy_threshold2));
+    ASSIGN_OR_RETURN(const float pvalue,
+                     OneSidedMcNemarTestOnPackedPredictions(
+                         packed1, packed2, roc_idx, max_accuracy_threshold1,
+                         max_accuracy_threshold2));
     labels_and_p_values.push_back(std::make_pair(label, pvalue));
 
     for (const auto& x_at_y_accessor : XAtYMetricsAccessors()) {
@@ -205,11 +271,11 @@ utils::StatusOr<std::vector<std::pair<std::string, float>>> OneSidedMcNemarTest(
                              eval_results1.label_column(), roc_idx),
                          "_vs_the_others@", x_at_y_accessor.y_name, "=",
                          x_at_ys[x_at_y_idx].y_metric_constraint());
-        ASSIGN_OR_RETURN(
-            const float xy_pvalue,
-            OneSidedMcNemarTest(eval_results1, eval_results2, roc_idx,
-                                x_at_ys[x_at_y_idx].threshold(),
-                                x_at_ys2[x_at_y_idx].threshold()));
+        ASSIGN_OR_RETURN(const float xy_pvalue,
+                         OneSidedMcNemarTestOnPackedPredictions(
+                             packed1, packed2, roc_idx,
+                             x_at_ys[x_at_y_idx].threshold(),
+                             x_at_ys2[x_at_y_idx].threshold()));
         labels_and_p_values.push_back(std::make_pair(xy_label, xy_pvalue));
       }
     }
@@ -223,90 +289,33 @@ utils::StatusOr<float> OneSidedMcNemarTest(
     const proto::EvaluationResults& eval_results1,
     const proto::EvaluationResults& eval_results2, const int roc_idx,
     const float threshold1, const float threshold2) {
-  // Compute n12 and n21.
-  double n12 = 0.0;
-  double n21 = 0.0;
-  for (size_t i = 0; i < eval_results1.sampled_predictions_size(); ++i) {
-    const int ground_truth =
-        eval_results1.sampled_predictions(i).classification().ground_truth();
-    STATUS_CHECK_EQ(
-        ground_truth,
-        eval_results2.sampled_predictions(i).classification().ground_truth());
-    STATUS_CHECK_GT(eval_results1.sampled_predictions(i)
-                        .classification()
-                        .distribution()
-                        .sum(),
-                    0);
-    STATUS_CHECK_GT(eval_results2.sampled_predictions(i)
-                        .classification()
-                        .distribution()
-                        .sum(),
-                    0);
-
-    const float prediction1 = eval_results1.sampled_predictions(i)
-                                  .classification()
-                                  .distribution()
-                                  .counts(roc_idx) /
-                              eval_results1.sampled_predictions(i)
-                                  .classification()
-                                  .distribution()
-                                  .sum();
-    const float prediction2 = eval_results2.sampled_predictions(i)
-                                  .classification()
-                                  .distribution()
-                                  .counts(roc_idx) /
-                              eval_results2.sampled_predictions(i)
-                                  .classification()
-                                  .distribution()
-                                  .sum();
-
-    const bool correct1 =
-        (prediction1 >= threshold1) == (ground_truth == roc_idx);
-    const bool correct2 =
-        (prediction2 >= threshold2) == (ground_truth == roc_idx);
-
-    // The metric is not perfectly designed to take weights as input. If the
-    // weights are imbalanced (for e.g if the weights are much larger than 1),
-    // then this test does not work correctly. However, if enough samples are
-    // collected, and the weights are not very imbalanced, this test works fine
-    // (although a bit optimistically).
-    if (correct1 && !correct2) {
-      n12 += eval_results1.sampled_predictions(i).weight();
-    }
-    if (!correct1 && correct2) {
-      n21 += eval_results1.sampled_predictions(i).weight();
-    }
-  }
-  if (n12 + n21 == 0.0) {
-    return 1.0;
-  }
-
-  const boost::math::binomial_distribution<double> distribution(n12 + n21, 0.5);
-  const float pvalue = 1 - boost::math::cdf(distribution, n12);
-
-  return static_cast<float>(pvalue);
+  ASSIGN_OR_RETURN(const PackedPredictions packed1,
+                   PackPredictions(eval_results1));
+  ASSIGN_OR_RETURN(const PackedPredictions packed2,
+                   PackPredictions(eval_results2));
+  return OneSidedMcNemarTestOnPackedPredictions(packed1, packed2, roc_idx,
+                                                threshold1, threshold2);
 }
 
 utils::StatusOr<float> PairwiseRegressiveResidualTest(
     const proto::EvaluationResults& eval_baseline,
     const proto::EvaluationResults& eval_candidate) {
-  STATUS_CHECK_EQ(eval_baseline.sampled_predictions_size(),
-                  eval_candidate.sampled_predictions_size());
-  const auto num_examples = eval_baseline.sampled_predictions_size();
+  ASSIGN_OR_RETURN(const PackedPredictions packed_baseline,
+                   PackPredictions(eval_baseline));
+  ASSIGN_OR_RETURN(const PackedPredictions packed_candidate,
+                   PackPredictions(eval_candidate));
+  STATUS_CHECK_EQ(packed_baseline.num_examples(),
+                  packed_candidate.num_examples());
+  const auto num_examples = packed_baseline.num_examples();
 
   std::vector<float> sample;
   sample.reserve(num_examples);
 
-  for (size_t i = 0; i < eval_baseline.sampled_predictions_size(); ++i) {
-    const float label =
-        eval_baseline.sampled_predictions(i).regression().ground_truth();
-    STATUS_CHECK_EQ(
-        label,
-        eval_candidate.sampled_predictions(i).regression().ground_truth());
-    const float pred_1 =
-        eval_baseline.sampled_predictions(i).regression().value();
-    const float pred_2 =
-        eval_candidate.sampled_predictions(i).regression().value();
+  for (size_t i = 0; i < num_examples; ++i) {
+    const float label = packed_baseline.regression_ground_truths[i];
+    STATUS_CHECK_EQ(label, packed_candidate.regression_ground_truths[i]);
+    const float pred_1 = packed_baseline.regression_predictions[i];
+    const float pred_2 = packed_candidate.regression_predictions[i];
     const float residual_1 = std::abs(label - pred_1);
     const float residual_2 = std::abs(label - pred_2);
     sample.push_back(residual_1 - residual_2);
@@ -318,8 +327,12 @@ utils::StatusOr<float> PairwiseRegressiveResidualTest(
 utils::StatusOr<float> PairwiseRankingNDCG5Test(
     const proto::EvaluationResults& eval_baseline,
     const proto::EvaluationResults& eval_candidate) {
-  STATUS_CHECK_EQ(eval_baseline.sampled_predictions_size(),
-                  eval_candidate.sampled_predictions_size());
+  ASSIGN_OR_RETURN(const PackedPredictions packed_baseline,
+                   PackPredictions(eval_baseline));
+  ASSIGN_OR_RETURN(const PackedPredictions packed_candidate,
+                   PackPredictions(eval_candidate));
+  STATUS_CHECK_EQ(packed_baseline.num_examples(),
+                  packed_candidate.num_examples());
 
   NDCGCalculator ndcg_calculator(5);
   struct Group {
@@ -328,20 +341,14 @@ utils::StatusOr<float> PairwiseRankingNDCG5Test(
   absl::flat_hash_map<uint64_t, Group> groups;
 
   // Group examples.
-  for (size_t i = 0; i < eval_baseline.sampled_predictions_size(); ++i) {
-    const auto label =
-        eval_baseline.sampled_predictions(i).ranking().ground_truth_relevance();
-    STATUS_CHECK_EQ(label, eval_candidate.sampled_predictions(i)
-                               .ranking()
-                               .ground_truth_relevance());
-    const auto pred_1 =
-        eval_baseline.sampled_predictions(i).ranking().relevance();
-    const auto pred_2 =
-        eval_candidate.sampled_predictions(i).ranking().relevance();
-    const auto group_id =
-        eval_baseline.sampled_predictions(i).ranking().group_id();
-    STATUS_CHECK_EQ(group_id,
-                    eval_candidate.sampled_predictions(i).ranking().group_id());
+  for (size_t i = 0; i < packed_baseline.num_examples(); ++i) {
+    const float label = packed_baseline.ranking_ground_truth_relevances[i];
+    STATUS_CHECK_EQ(label,
+                    packed_candidate.ranking_ground_truth_relevances[i]);
+    const float pred_1 = packed_baseline.ranking_predicted_relevances[i];
+    const float pred_2 = packed_candidate.ranking_predicted_relevances[i];
+    const auto group_id = packed_baseline.ranking_group_ids[i];
+    STATUS_CHECK_EQ(group_id, packed_candidate.ranking_group_ids[i]);
     auto& group = groups[group_id];
     group.model_1.push_back({/*.prediction =*/pred_1, /*.label =*/label});
     group.model_2.push_back({/*.prediction =*/pred_2, /*.label =*/label});
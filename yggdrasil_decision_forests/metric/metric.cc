@@ -15,18 +15,24 @@
 
 #include "yggdrasil_decision_forests/metric/metric.h"
 
+#include <atomic>
+#include <cmath>
 #include <functional>
 #include <limits>
 #include <random>
+#include <thread>
 #include <vector>
 
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "boost/math/distributions/binomial.hpp"
 #include "boost/math/distributions/chi_squared.hpp"
 #include "boost/math/distributions/students_t.hpp"
@@ -35,7 +41,9 @@
 #include "yggdrasil_decision_forests/metric/ranking_mrr.h"
 #include "yggdrasil_decision_forests/metric/ranking_ndcg.h"
 #include "yggdrasil_decision_forests/metric/uplift.h"
+#include "yggdrasil_decision_forests/utils/adaptive_work.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/distribution.h"
 #include "yggdrasil_decision_forests/utils/distribution.pb.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
@@ -43,6 +51,7 @@
 #include "yggdrasil_decision_forests/utils/protobuf.h"
 #include "yggdrasil_decision_forests/utils/random.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 namespace yggdrasil_decision_forests {
 namespace metric {
@@ -271,6 +280,94 @@ absl::Status FinalizeRankingMetricsFromSampledPredictions(
   NDCGCalculator ndcg_computer(option.ranking().ndcg_truncation());
   MRRCalculator mrr_computer(option.ranking().mrr_truncation());
 
+  // The groups are independent: they are processed in parallel blocks and the
+  // block statistics are aggregated sequentially afterward.
+  std::vector<Item*> group_items;
+  group_items.reserve(grouped_examples.size());
+  for (auto& group : grouped_examples) {
+    group_items.push_back(&group.second);
+  }
+  const int64_t num_groups = group_items.size();
+
+  struct BlockStatistics {
+    double sum_weighted_ndcg = 0;
+    double sum_default_weighted_ndcg = 0;
+    double sum_weighted_mrr = 0;
+    double sum_weighted_precision_at_1 = 0;
+    double sum_weights = 0;
+    size_t min_num_items_in_group = std::numeric_limits<size_t>::max();
+    size_t max_num_items_in_group = std::numeric_limits<size_t>::min();
+  };
+
+  // NDCGs and weights of each group. Used for the computation of confidence
+  // intervals using bootstrapping.
+  std::vector<std::pair<float, float>> individual_ndcgs(num_groups),
+      individual_mrrs(num_groups);
+
+  // Minimum number of groups in a block to amortize the cost of a thread.
+  constexpr int64_t kMinGroupsPerBlock = 100;
+  const int num_blocks = std::max<int64_t>(
+      1, std::min<int64_t>(
+             std::max<unsigned int>(1, std::thread::hardware_concurrency()),
+             (num_groups + kMinGroupsPerBlock - 1) / kMinGroupsPerBlock));
+  std::vector<BlockStatistics> block_statistics(num_blocks);
+  {
+    utils::concurrency::ThreadPool pool("RankingEvaluation", num_blocks);
+    pool.StartWorkers();
+    for (int block_idx = 0; block_idx < num_blocks; block_idx++) {
+      const int64_t begin_group_idx = block_idx * num_groups / num_blocks;
+      const int64_t end_group_idx = (block_idx + 1) * num_groups / num_blocks;
+      pool.Schedule([&group_items, &individual_ndcgs, &individual_mrrs,
+                     &ndcg_computer, &mrr_computer, &block_statistics,
+                     begin_group_idx, end_group_idx, block_idx]() {
+        auto& block = block_statistics[block_idx];
+        for (int64_t group_idx = begin_group_idx; group_idx < end_group_idx;
+             group_idx++) {
+          auto& item = *group_items[group_idx];
+
+          // Sort the group by decreasing label value.
+          std::sort(item.pred_and_label_relevance.begin(),
+                    item.pred_and_label_relevance.end(),
+                    [](const RankingLabelAndPrediction& a,
+                       const RankingLabelAndPrediction& b) {
+                      return a.label > b.label;
+                    });
+
+          // NDCG
+          const auto weighted_ndcg =
+              item.weight * ndcg_computer.NDCG(item.pred_and_label_relevance);
+          individual_ndcgs[group_idx] = {weighted_ndcg, item.weight};
+
+          block.sum_weighted_ndcg += weighted_ndcg;
+          block.sum_default_weighted_ndcg +=
+              item.weight *
+              ndcg_computer.DefaultNDCG(item.pred_and_label_relevance);
+
+          // MRR
+          const auto weighted_mrr =
+              item.weight * mrr_computer.MRR(item.pred_and_label_relevance);
+          individual_mrrs[group_idx] = {weighted_mrr, item.weight};
+
+          block.sum_weighted_mrr += weighted_mrr;
+
+          // Precision @ 1
+          const auto precision_at_1 =
+              GreatestPredictionIndex(item.pred_and_label_relevance) == 0;
+          block.sum_weighted_precision_at_1 += item.weight * precision_at_1;
+
+          block.sum_weights += item.weight;
+          block.min_num_items_in_group =
+              std::min(block.min_num_items_in_group,
+                       item.pred_and_label_relevance.size());
+          block.max_num_items_in_group =
+              std::max(block.max_num_items_in_group,
+                       item.pred_and_label_relevance.size());
+        }
+      });
+    }
+  }
+
+  // Aggregate the block statistics.
   double sum_weighted_ndcg = 0;
   double sum_weights = 0;
   double sum_default_weighted_ndcg = 0;
@@ -278,53 +375,19 @@ absl::Status FinalizeRankingMetricsFromSampledPredictions(
   double sum_weighted_mrr = 0;
   double sum_weighted_precision_at_1 = 0;
 
-  // NDCGs and weights of each group. Used for the computation of confidence
-  // intervals using bootstrapping.
-  std::vector<std::pair<float, float>> individual_ndcgs, individual_mrrs;
-  individual_ndcgs.reserve(grouped_examples.size());
-  individual_mrrs.reserve(grouped_examples.size());
-
   size_t min_num_items_in_group = std::numeric_limits<size_t>::max();
   size_t max_num_items_in_group = std::numeric_limits<size_t>::min();
 
-  // Sort the prediction in each group.
-  for (auto& group : grouped_examples) {
-    // Sort the groups by decreasing label value.
-    std::sort(
-        group.second.pred_and_label_relevance.begin(),
-        group.second.pred_and_label_relevance.end(),
-        [](const RankingLabelAndPrediction& a,
-           const RankingLabelAndPrediction& b) { return a.label > b.label; });
-
-    // NDCG
-    const auto weighted_ndcg =
-        group.second.weight *
-        ndcg_computer.NDCG(group.second.pred_and_label_relevance);
-    individual_ndcgs.emplace_back(weighted_ndcg, group.second.weight);
-
-    sum_weighted_ndcg += weighted_ndcg;
-    sum_default_weighted_ndcg +=
-        group.second.weight *
-        ndcg_computer.DefaultNDCG(group.second.pred_and_label_relevance);
-
-    // MRR
-    const auto weighted_mrr =
-        group.second.weight *
-        mrr_computer.MRR(group.second.pred_and_label_relevance);
-    individual_mrrs.emplace_back(weighted_mrr, group.second.weight);
-
-    sum_weighted_mrr += weighted_mrr;
-
-    // Precision @ 1
-    const auto precision_at_1 =
-        GreatestPredictionIndex(group.second.pred_and_label_relevance) == 0;
-    sum_weighted_precision_at_1 += group.second.weight * precision_at_1;
-
-    sum_weights += group.second.weight;
-    min_num_items_in_group = std::min(
-        min_num_items_in_group, group.second.pred_and_label_relevance.size());
-    max_num_items_in_group = std::max(
-        max_num_items_in_group, group.second.pred_and_label_relevance.size());
+  for (const auto& block : block_statistics) {
+    sum_weighted_ndcg += block.sum_weighted_ndcg;
+    sum_default_weighted_ndcg += block.sum_default_weighted_ndcg;
+    sum_weighted_mrr += block.sum_weighted_mrr;
+    sum_weighted_precision_at_1 += block.sum_weighted_precision_at_1;
+    sum_weights += block.sum_weights;
+    min_num_items_in_group =
+        std::min(min_num_items_in_group, block.min_num_items_in_group);
+    max_num_items_in_group =
+        std::max(max_num_items_in_group, block.max_num_items_in_group);
   }
 
   ranking.mutable_ndcg()->set_value(sum_weighted_ndcg / sum_weights);
@@ -367,6 +430,32 @@ void MergeEvaluationClassification(
     proto::EvaluationResults::Classification* dst) {
   utils::AddToConfusionMatrixProto(src.confusion(), dst->mutable_confusion());
   dst->set_sum_log_loss(dst->sum_log_loss() + src.sum_log_loss());
+  // The streaming AUC score histograms are merged bin by bin.
+  for (int label_value = 0; label_value < src.streaming_auc_accumulators_size();
+       label_value++) {
+    const auto& src_accumulator = src.streaming_auc_accumulators(label_value);
+    while (dst->streaming_auc_accumulators_size() <= label_value) {
+      auto* new_accumulator = dst->add_streaming_auc_accumulators();
+      new_accumulator->mutable_positive()->Resize(
+          src_accumulator.positive_size(), 0);
+      new_accumulator->mutable_negative()->Resize(
+          src_accumulator.negative_size(), 0);
+    }
+    auto* dst_accumulator = dst->mutable_streaming_auc_accumulators(label_value);
+    DCHECK_EQ(dst_accumulator->positive_size(),
+              src_accumulator.positive_size());
+    for (int bin_idx = 0; bin_idx < src_accumulator.positive_size();
+         bin_idx++) {
+      dst_accumulator->set_positive(
+          bin_idx,
+          dst_accumulator->positive(bin_idx) +
+              src_accumulator.positive(bin_idx));
+      dst_accumulator->set_negative(
+          bin_idx,
+          dst_accumulator->negative(bin_idx) +
+              src_accumulator.negative(bin_idx));
+    }
+  }
 }
 
 void MergeEvaluationRegression(const proto::EvaluationResults::Regression& src,
@@ -374,6 +463,27 @@ void MergeEvaluationRegression(const proto::EvaluationResults::Regression& src,
   dst->set_sum_square_error(dst->sum_square_error() + src.sum_square_error());
   dst->set_sum_label(dst->sum_label() + src.sum_label());
   dst->set_sum_square_label(dst->sum_square_label() + src.sum_square_label());
+  // The streaming bootstrap accumulators are merged replicate by replicate.
+  if (src.streaming_bootstrap_sum_square_error_size() > 0) {
+    auto* dst_sum_square_errors =
+        dst->mutable_streaming_bootstrap_sum_square_error();
+    auto* dst_sum_weights = dst->mutable_streaming_bootstrap_sum_weights();
+    if (dst_sum_square_errors->empty()) {
+      dst_sum_square_errors->Resize(
+          src.streaming_bootstrap_sum_square_error_size(), 0);
+      dst_sum_weights->Resize(src.streaming_bootstrap_sum_weights_size(), 0);
+    }
+    DCHECK_EQ(dst_sum_square_errors->size(),
+              src.streaming_bootstrap_sum_square_error_size());
+    for (int sample_idx = 0;
+         sample_idx < src.streaming_bootstrap_sum_square_error_size();
+         sample_idx++) {
+      (*dst_sum_square_errors)[sample_idx] +=
+          src.streaming_bootstrap_sum_square_error(sample_idx);
+      (*dst_sum_weights)[sample_idx] +=
+          src.streaming_bootstrap_sum_weights(sample_idx);
+    }
+  }
 }
 
 void MergeEvaluationRanking(const proto::EvaluationResults::Ranking& src,
@@ -598,6 +708,9 @@ absl::Status UpdateRMSEConfidenceIntervalUsingBootstrapping(
   std::vector<float> rmse_samples(option.bootstrapping_samples());
   const auto num_preds = eval->sampled_predictions_size();
   STATUS_CHECK_GT(num_preds, 0);
+  // Columnar copy of the predictions: the bootstrap rounds below scan flat
+  // arrays instead of re-walking the prediction protos.
+  ASSIGN_OR_RETURN(const PackedPredictions packed, PackPredictions(*eval));
   // Random generator for the selection of predictions.
   utils::RandomEngine rnd;
   std::uniform_int_distribution<int64_t> prediction_idx_dist(0, num_preds - 1);
@@ -608,11 +721,12 @@ absl::Status UpdateRMSEConfidenceIntervalUsingBootstrapping(
     double sum_weights = 0;
     for (int64_t item_idx = 0; item_idx < num_preds; item_idx++) {
       const int64_t selected_prediction_idx = prediction_idx_dist(rnd);
-      const auto& pred = eval->sampled_predictions(selected_prediction_idx);
       const float residual =
-          pred.regression().value() - pred.regression().ground_truth();
-      sum_square_error += residual * residual * pred.weight();
-      sum_weights += pred.weight();
+          packed.regression_predictions[selected_prediction_idx] -
+          packed.regression_ground_truths[selected_prediction_idx];
+      const float weight = packed.weights[selected_prediction_idx];
+      sum_square_error += residual * residual * weight;
+      sum_weights += weight;
     }
     double rmse = 0;
     if (sum_weights > 0) {
@@ -635,53 +749,289 @@ absl::Status UpdateRMSEConfidenceIntervalUsingBootstrapping(
   return absl::OkStatus();
 }
 
-absl::Status ComputeRocConfidenceIntervalsUsingBootstrapping(
+void UpdateStreamingAucAccumulators(
     const proto::EvaluationOptions& option,
-    const std::vector<BinaryPrediction>& sorted_predictions, proto::Roc* roc) {
-  const auto num_preds = sorted_predictions.size();
-  // Working buffer containing the number of time each prediction is selected.
-  std::vector<int> selected_count(sorted_predictions.size());
-  // Working buffer used to store temporarily the roc curves.
-  google::protobuf::RepeatedPtrField<proto::Roc::Point> temporary_roc;
-  // Random generator for the selection of predictions.
-  utils::RandomEngine rnd;
-  std::uniform_int_distribution<int64_t> prediction_idx_dist(
-      0, sorted_predictions.size() - 1);
-  // The samples.
-  std::vector<proto::Roc> samples(option.bootstrapping_samples());
+    const model::proto::Prediction& pred,
+    proto::EvaluationResults::Classification* eval_cls) {
+  const auto& pred_cls = pred.classification();
+  if (!pred_cls.has_distribution()) {
+    return;
+  }
+  const int num_label_values = pred_cls.distribution().counts_size();
+  const int num_bins = option.classification().streaming_auc_num_bins();
+  while (eval_cls->streaming_auc_accumulators_size() < num_label_values) {
+    auto* accumulator = eval_cls->add_streaming_auc_accumulators();
+    accumulator->mutable_positive()->Resize(num_bins, 0);
+    accumulator->mutable_negative()->Resize(num_bins, 0);
+  }
+  const float sum = pred_cls.distribution().sum();
+  for (int label_value = 0; label_value < num_label_values; label_value++) {
+    // The predicted probability for label=true, in [0, 1].
+    float predict_true = 0.0;
+    if (sum > 0) {
+      predict_true = pred_cls.distribution().counts(label_value) / sum;
+    }
+    const int bin_idx = std::max(
+        0, std::min(num_bins - 1, static_cast<int>(predict_true * num_bins)));
+    auto* accumulator = eval_cls->mutable_streaming_auc_accumulators(
+        label_value);
+    auto* bank = (pred_cls.ground_truth() == label_value)
+                     ? accumulator->mutable_positive()
+                     : accumulator->mutable_negative();
+    bank->Set(bin_idx, bank->Get(bin_idx) + pred.weight());
+  }
+}
+
+double ApproximateAucFromStreamingAccumulator(
+    const proto::EvaluationResults::Classification::StreamingAucAccumulator&
+        accumulator) {
+  // Probability that a random positive example has a higher score than a
+  // random negative example, counting ties (i.e. examples in the same bin)
+  // for one half.
+  double sum_positive = 0;
+  double sum_negative = 0;
+  double auc = 0;
+  for (int bin_idx = 0; bin_idx < accumulator.positive_size(); bin_idx++) {
+    const double positive = accumulator.positive(bin_idx);
+    const double negative = accumulator.negative(bin_idx);
+    auc += positive * (sum_negative + negative / 2);
+    sum_positive += positive;
+    sum_negative += negative;
+  }
+  if (sum_positive == 0 || sum_negative == 0) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  return auc / (sum_positive * sum_negative);
+}
 
-  // Bootstrapping.
+void UpdateStreamingBootstrapAccumulators(
+    const proto::EvaluationOptions& option,
+    const model::proto::Prediction& pred, utils::RandomEngine* rnd,
+    proto::EvaluationResults* eval) {
+  auto* eval_reg = eval->mutable_regression();
+  auto* sum_square_errors =
+      eval_reg->mutable_streaming_bootstrap_sum_square_error();
+  auto* sum_weights = eval_reg->mutable_streaming_bootstrap_sum_weights();
+  if (sum_square_errors->size() != option.bootstrapping_samples()) {
+    sum_square_errors->Resize(option.bootstrapping_samples(), 0);
+    sum_weights->Resize(option.bootstrapping_samples(), 0);
+  }
+  const float residual =
+      pred.regression().value() - pred.regression().ground_truth();
+  const double weighted_square_error = residual * residual * pred.weight();
+  // Selecting each prediction Poisson(1) times in each bootstrap replicate
+  // approximates resampling "num_predictions" predictions with replacement.
+  std::poisson_distribution<int> selection_count_dist(1.0);
   for (int64_t sample_idx = 0; sample_idx < option.bootstrapping_samples();
        sample_idx++) {
-    auto& sample_roc = samples[sample_idx];
-
-    // Create a bootstrap of predictions.
-    std::fill(selected_count.begin(), selected_count.end(), 0);
-    // "sampled_sum_positive_label" can be different than "sum_positive_label"
-    // because all the examples don't have the same weights.
-    double sampled_sum_positive_label = 0;
-    double sampled_sum_negative_label = 0;
-    for (int64_t item_idx = 0; item_idx < num_preds; item_idx++) {
-      const int64_t selected_prediction_idx = prediction_idx_dist(rnd);
-      selected_count[selected_prediction_idx]++;
-      sorted_predictions[selected_prediction_idx].label
-          ? (sampled_sum_positive_label +=
-             sorted_predictions[selected_prediction_idx].weight)
-          : (sampled_sum_negative_label +=
-             sorted_predictions[selected_prediction_idx].weight);
+    const int selection_count = selection_count_dist(*rnd);
+    if (selection_count == 0) {
+      continue;
     }
+    (*sum_square_errors)[sample_idx] +=
+        selection_count * weighted_square_error;
+    (*sum_weights)[sample_idx] += selection_count * pred.weight();
+  }
+}
 
-    // Compute the ROC
-    temporary_roc.Clear();
-    RETURN_IF_ERROR(BuildROCCurveFromSortedPredictions(
-        sorted_predictions, selected_count, sampled_sum_positive_label,
-        sampled_sum_negative_label, &temporary_roc));
+absl::Status UpdateRMSEConfidenceIntervalUsingStreamingBootstrap(
+    const proto::EvaluationOptions& option, proto::EvaluationResults* eval) {
+  auto* eval_reg = eval->mutable_regression();
+  STATUS_CHECK_EQ(eval_reg->streaming_bootstrap_sum_square_error_size(),
+                  option.bootstrapping_samples());
+  // Bootstrap samples of RMSEes.
+  std::vector<float> rmse_samples(option.bootstrapping_samples());
+  for (int64_t sample_idx = 0; sample_idx < option.bootstrapping_samples();
+       sample_idx++) {
+    const double sum_weights =
+        eval_reg->streaming_bootstrap_sum_weights(sample_idx);
+    double rmse = 0;
+    if (sum_weights > 0) {
+      rmse = std::sqrt(
+          eval_reg->streaming_bootstrap_sum_square_error(sample_idx) /
+          sum_weights);
+    }
+    rmse_samples[sample_idx] = rmse;
+  }
+  eval_reg->clear_streaming_bootstrap_sum_square_error();
+  eval_reg->clear_streaming_bootstrap_sum_weights();
+  // Estimate confidence intervals using samples.
+  std::sort(rmse_samples.begin(), rmse_samples.end());
+  const auto quantile_1_idx =
+      std::min(static_cast<size_t>(0.025f * rmse_samples.size()),
+               rmse_samples.size() - 1);
+  const auto quantile_2_idx =
+      std::min(static_cast<size_t>(0.975f * rmse_samples.size()),
+               rmse_samples.size() - 1);
+  eval_reg->set_bootstrap_rmse_lower_bounds_95p(rmse_samples[quantile_1_idx]);
+  eval_reg->set_bootstrap_rmse_upper_bounds_95p(rmse_samples[quantile_2_idx]);
+  return absl::OkStatus();
+}
+
+namespace {
+
+// Computes one bootstrap replicate of the ROC metrics. "selected_count" and
+// "temporary_roc" are working buffers.
+absl::Status ComputeRocBootstrapReplicate(
+    const proto::EvaluationOptions& option,
+    const std::vector<BinaryPrediction>& sorted_predictions,
+    utils::RandomEngine* rnd, std::vector<int>* selected_count,
+    google::protobuf::RepeatedPtrField<proto::Roc::Point>* temporary_roc,
+    proto::Roc* sample_roc) {
+  const int64_t num_preds = sorted_predictions.size();
+  std::uniform_int_distribution<int64_t> prediction_idx_dist(0, num_preds - 1);
 
-    // Evaluate metrics on the bootstrap.
-    sample_roc.set_auc(computeAUC(temporary_roc));
-    sample_roc.set_pr_auc(computePrAuc(temporary_roc));
-    sample_roc.set_ap(computeAP(temporary_roc));
-    ComputeXAtYMetrics(option, temporary_roc, &sample_roc);
+  // Create a bootstrap of predictions.
+  std::fill(selected_count->begin(), selected_count->end(), 0);
+  // "sampled_sum_positive_label" can be different than "sum_positive_label"
+  // because all the examples don't have the same weights.
+  double sampled_sum_positive_label = 0;
+  double sampled_sum_negative_label = 0;
+  for (int64_t item_idx = 0; item_idx < num_preds; item_idx++) {
+    const int64_t selected_prediction_idx = prediction_idx_dist(*rnd);
+    (*selected_count)[selected_prediction_idx]++;
+    sorted_predictions[selected_prediction_idx].label
+        ? (sampled_sum_positive_label +=
+           sorted_predictions[selected_prediction_idx].weight)
+        : (sampled_sum_negative_label +=
+           sorted_predictions[selected_prediction_idx].weight);
+  }
+
+  // Compute the ROC
+  temporary_roc->Clear();
+  RETURN_IF_ERROR(BuildROCCurveFromSortedPredictions(
+      sorted_predictions, *selected_count, sampled_sum_positive_label,
+      sampled_sum_negative_label, temporary_roc));
+
+  // Evaluate metrics on the bootstrap.
+  sample_roc->set_auc(computeAUC(*temporary_roc));
+  sample_roc->set_pr_auc(computePrAuc(*temporary_roc));
+  sample_roc->set_ap(computeAP(*temporary_roc));
+  ComputeXAtYMetrics(option, *temporary_roc, sample_roc);
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status ComputeRocConfidenceIntervalsUsingBootstrapping(
+    const proto::EvaluationOptions& option,
+    const std::vector<BinaryPrediction>& sorted_predictions, proto::Roc* roc) {
+  const int64_t num_replicates = option.bootstrapping_samples();
+  const int num_threads = std::max(
+      1, static_cast<int>(std::min<int64_t>(option.num_threads(),
+                                            num_replicates)));
+  // The samples.
+  std::vector<proto::Roc> samples;
+  samples.reserve(num_replicates);
+
+  // Optional wall-clock budget for the bootstrapping. The time of the
+  // replicates is measured, and the replicates that do not fit in the budget
+  // are not computed: the confidence intervals are then estimated on the
+  // computed replicates. The budget is a wall-clock time while the work
+  // manager counts the compute time of all the workers, hence the scaling by
+  // "num_threads".
+  std::unique_ptr<utils::DeadlineAwareWork> budget_manager;
+  if (option.maximum_bootstrapping_duration_seconds() > 0) {
+    budget_manager = absl::make_unique<utils::DeadlineAwareWork>(
+        num_replicates,
+        option.maximum_bootstrapping_duration_seconds() * num_threads,
+        /*warming_up_seconds=*/
+        option.maximum_bootstrapping_duration_seconds() * num_threads * 0.05,
+        /*min_factor=*/0.);
+  }
+
+  if (num_threads > 1) {
+    // Each replicate is computed with its own random stream, so the result
+    // does not depend on the number of threads or on the scheduling.
+    std::vector<proto::Roc> replicates(num_replicates);
+    std::vector<char> computed(num_replicates, 0);
+    std::atomic<int64_t> next_replicate_idx{0};
+    utils::concurrency::Mutex status_mutex;
+    absl::Status worker_status;
+    {
+      utils::concurrency::ThreadPool pool("RocBootstrap", num_threads);
+      pool.StartWorkers();
+      for (int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+        pool.Schedule([&]() {
+          // Working buffers of the thread.
+          std::vector<int> selected_count(sorted_predictions.size());
+          google::protobuf::RepeatedPtrField<proto::Roc::Point> temporary_roc;
+          while (true) {
+            const int64_t sample_idx = next_replicate_idx++;
+            if (sample_idx >= num_replicates) {
+              break;
+            }
+            if (budget_manager) {
+              // Number of full replicates that fit in the remaining budget.
+              const double num_remaining_replicates =
+                  budget_manager->NextApproximationFactor() *
+                  (num_replicates - sample_idx);
+              if (num_remaining_replicates < 1.) {
+                break;
+              }
+            }
+            const absl::Time begin_replicate = absl::Now();
+            utils::RandomEngine rnd(0xCAFE + sample_idx);
+            const auto status = ComputeRocBootstrapReplicate(
+                option, sorted_predictions, &rnd, &selected_count,
+                &temporary_roc, &replicates[sample_idx]);
+            if (!status.ok()) {
+              utils::concurrency::MutexLock lock(&status_mutex);
+              worker_status.Update(status);
+              break;
+            }
+            computed[sample_idx] = 1;
+            if (budget_manager) {
+              budget_manager->ReportTaskDone(
+                  1., absl::ToDoubleSeconds(absl::Now() - begin_replicate));
+            }
+          }
+        });
+      }
+    }
+    RETURN_IF_ERROR(worker_status);
+    for (int64_t sample_idx = 0; sample_idx < num_replicates; sample_idx++) {
+      if (computed[sample_idx]) {
+        samples.push_back(std::move(replicates[sample_idx]));
+      }
+    }
+  } else {
+    // Working buffer containing the number of time each prediction is
+    // selected.
+    std::vector<int> selected_count(sorted_predictions.size());
+    // Working buffer used to store temporarily the roc curves.
+    google::protobuf::RepeatedPtrField<proto::Roc::Point> temporary_roc;
+    // Random generator for the selection of predictions.
+    utils::RandomEngine rnd;
+
+    for (int64_t sample_idx = 0; sample_idx < num_replicates; sample_idx++) {
+      if (budget_manager) {
+        // Number of full replicates that fit in the remaining budget.
+        const double num_remaining_replicates =
+            budget_manager->NextApproximationFactor() *
+            (num_replicates - sample_idx);
+        if (num_remaining_replicates < 1.) {
+          break;
+        }
+      }
+      const absl::Time begin_replicate = absl::Now();
+      samples.emplace_back();
+      RETURN_IF_ERROR(ComputeRocBootstrapReplicate(
+          option, sorted_predictions, &rnd, &selected_count, &temporary_roc,
+          &samples.back()));
+      if (budget_manager) {
+        budget_manager->ReportTaskDone(
+            1., absl::ToDoubleSeconds(absl::Now() - begin_replicate));
+      }
+    }
+  }
+  if (budget_manager &&
+      static_cast<int64_t>(samples.size()) < option.bootstrapping_samples()) {
+    LOG(INFO) << "Computed " << samples.size() << " of "
+              << option.bootstrapping_samples()
+              << " bootstrap replicates within the "
+              << option.maximum_bootstrapping_duration_seconds()
+              << " seconds budget.";
   }
 
   // Estimate confidence intervals using samples.
@@ -868,6 +1218,10 @@ absl::Status AddPrediction(const proto::EvaluationOptions& option,
         eval_cls->set_sum_log_loss(eval_cls->sum_log_loss() +
                                    logloss * pred.weight());
       }
+      // Streaming approximate AUC.
+      if (option.classification().streaming_auc()) {
+        internal::UpdateStreamingAucAccumulators(option, pred, eval_cls);
+      }
       // ROC requires prediction sampling.
       need_prediction_sampling |= option.classification().roc_enable();
     } break;
@@ -886,6 +1240,12 @@ absl::Status AddPrediction(const proto::EvaluationOptions& option,
       eval_reg->set_sum_square_label(
           eval_reg->sum_square_label() +
           pred_reg.ground_truth() * pred_reg.ground_truth() * pred.weight());
+      // With the streaming bootstrap, the prediction updates the accumulators
+      // and does not need to be retained.
+      if (option.streaming_bootstrap() && option.bootstrapping_samples() > 0) {
+        internal::UpdateStreamingBootstrapAccumulators(option, pred, rnd, eval);
+        need_prediction_sampling = false;
+      }
       // Calibration plots require prediction sampling.
       need_prediction_sampling |= option.regression().enable_regression_plots();
     } break;
@@ -932,16 +1292,36 @@ absl::Status FinalizeEvaluation(const proto::EvaluationOptions& option,
           RETURN_IF_ERROR(
               BuildROCCurve(option, label_column, *eval, label_value, roc));
         }
+      } else if (option.classification().streaming_auc()) {
+        // Approximate AUCs from the streaming score histograms.
+        for (int label_value = 0; label_value < num_classes; label_value++) {
+          auto* roc = eval_cls->mutable_rocs()->Add();
+          if (label_value >= eval_cls->streaming_auc_accumulators_size()) {
+            continue;
+          }
+          const double auc = internal::ApproximateAucFromStreamingAccumulator(
+              eval_cls->streaming_auc_accumulators(label_value));
+          if (!std::isnan(auc)) {
+            roc->set_auc(auc);
+          }
+        }
       }
+      eval_cls->clear_streaming_auc_accumulators();
     } break;
     case model::proto::Task::REGRESSION: {
       // Performs bootstrapping.
       if (option.bootstrapping_samples() > 0) {
         LOG(INFO) << "Computing rmse intervals of evaluation metrics with "
                      "bootstrapping.";
-        RETURN_IF_ERROR(
-            internal::UpdateRMSEConfidenceIntervalUsingBootstrapping(option,
-                                                                     eval));
+        if (option.streaming_bootstrap()) {
+          RETURN_IF_ERROR(
+              internal::UpdateRMSEConfidenceIntervalUsingStreamingBootstrap(
+                  option, eval));
+        } else {
+          RETURN_IF_ERROR(
+              internal::UpdateRMSEConfidenceIntervalUsingBootstrapping(option,
+                                                                       eval));
+        }
       }
     } break;
     case model::proto::Task::RANKING:
@@ -1047,11 +1427,10 @@ float DefaultAccuracy(const proto::EvaluationResults& eval) {
   if (eval.count_predictions() == 0) {
     return std::numeric_limits<float>::quiet_NaN();
   }
-  const auto& confusion = eval.classification().confusion();
+  const auto row_sums =
+      utils::ConfusionMatrixProtoRowSums(eval.classification().confusion());
   double top_row_sum = 0;
-  for (int row = 0; row < confusion.nrow(); row++) {
-    const double sum_col =
-        utils::ConfusionMatrixProtoSumColumns(confusion, row);
+  for (const double sum_col : row_sums) {
     if (sum_col > top_row_sum) {
       top_row_sum = sum_col;
     }
@@ -1064,10 +1443,9 @@ float DefaultLogLoss(const proto::EvaluationResults& eval) {
     return std::numeric_limits<float>::quiet_NaN();
   }
   const auto& confusion = eval.classification().confusion();
+  const auto row_sums = utils::ConfusionMatrixProtoRowSums(confusion);
   double log_loss = 0.0;
-  for (int row = 0; row < confusion.nrow(); row++) {
-    const double sum_col =
-        utils::ConfusionMatrixProtoSumColumns(confusion, row);
+  for (const double sum_col : row_sums) {
     double ratio = sum_col / confusion.sum();
     if (ratio == 0) {
       ratio = std::numeric_limits<double>::epsilon();
@@ -1163,6 +1541,68 @@ void ComputeXAtYMetrics(
   }
 }
 
+namespace {
+
+// Sorts the predictions by increasing score. Large sets of predictions are
+// sorted in chunks by multiple threads, and the sorted chunks are merged
+// pairwise.
+void SortBinaryPredictions(std::vector<BinaryPrediction>* predictions) {
+  const auto comparator = [](const BinaryPrediction& a,
+                             const BinaryPrediction& b) {
+    return a.predict_true < b.predict_true;
+  };
+  // Minimum number of predictions in each sorted chunk. Small sets of
+  // predictions are not worth the thread synchronization overhead.
+  constexpr size_t kMinPredictionsPerChunk = 100000;
+  const size_t num_chunks = std::min<size_t>(
+      (predictions->size() + kMinPredictionsPerChunk - 1) /
+          kMinPredictionsPerChunk,
+      std::max<unsigned int>(1, std::thread::hardware_concurrency()));
+  if (num_chunks <= 1) {
+    std::sort(predictions->begin(), predictions->end(), comparator);
+    return;
+  }
+
+  std::vector<size_t> boundaries(num_chunks + 1);
+  for (size_t chunk_idx = 0; chunk_idx <= num_chunks; chunk_idx++) {
+    boundaries[chunk_idx] = predictions->size() * chunk_idx / num_chunks;
+  }
+
+  {
+    utils::concurrency::ThreadPool pool("sort_predictions", num_chunks);
+    pool.StartWorkers();
+    for (size_t chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
+      pool.Schedule([predictions, &boundaries, &comparator, chunk_idx]() {
+        std::sort(predictions->begin() + boundaries[chunk_idx],
+                  predictions->begin() + boundaries[chunk_idx + 1],
+                  comparator);
+      });
+    }
+  }
+
+  // Merge the sorted chunks pairwise. The merges of each round run in
+  // parallel.
+  for (size_t step = 1; step < num_chunks; step *= 2) {
+    utils::concurrency::ThreadPool pool("merge_predictions",
+                                        (num_chunks + 2 * step - 1) /
+                                            (2 * step));
+    pool.StartWorkers();
+    for (size_t chunk_idx = 0; chunk_idx + step < num_chunks;
+         chunk_idx += 2 * step) {
+      const size_t begin = boundaries[chunk_idx];
+      const size_t middle = boundaries[chunk_idx + step];
+      const size_t end = boundaries[std::min(chunk_idx + 2 * step, num_chunks)];
+      pool.Schedule([predictions, &comparator, begin, middle, end]() {
+        std::inplace_merge(predictions->begin() + begin,
+                           predictions->begin() + middle,
+                           predictions->begin() + end, comparator);
+      });
+    }
+  }
+}
+
+}  // namespace
+
 absl::Status BuildROCCurve(const proto::EvaluationOptions& option,
                            const dataset::proto::Column& label_column,
                            const proto::EvaluationResults& eval,
@@ -1198,10 +1638,7 @@ absl::Status BuildROCCurve(const proto::EvaluationOptions& option,
                     "curve skipped.";
     return absl::OkStatus();
   }
-  std::sort(sorted_predictions.begin(), sorted_predictions.end(),
-            [](const BinaryPrediction& a, const BinaryPrediction& b) {
-              return a.predict_true < b.predict_true;
-            });
+  SortBinaryPredictions(&sorted_predictions);
 
   RETURN_IF_ERROR(BuildROCCurveFromSortedPredictions(
       sorted_predictions, std::vector<int>(), sum_positive_label,
@@ -1237,6 +1674,75 @@ absl::Status BuildROCCurve(const proto::EvaluationOptions& option,
   return absl::OkStatus();
 }
 
+utils::StatusOr<PackedPredictions> PackPredictions(
+    const proto::EvaluationResults& eval) {
+  PackedPredictions packed;
+  const int num_examples = eval.sampled_predictions_size();
+  if (num_examples == 0) {
+    return packed;
+  }
+  packed.weights.reserve(num_examples);
+
+  switch (eval.sampled_predictions(0).type_case()) {
+    case model::proto::Prediction::kClassification:
+      packed.classification_ground_truths.reserve(num_examples);
+      packed.classification_distribution_sums.reserve(num_examples);
+      for (const auto& pred : eval.sampled_predictions()) {
+        const auto& pred_cls = pred.classification();
+        if (packed.num_classes == 0) {
+          packed.num_classes = pred_cls.distribution().counts_size();
+          packed.classification_probabilities.reserve(
+              static_cast<size_t>(num_examples) * packed.num_classes);
+        }
+        STATUS_CHECK_EQ(pred_cls.distribution().counts_size(),
+                        packed.num_classes);
+        packed.weights.push_back(pred.weight());
+        packed.classification_ground_truths.push_back(pred_cls.ground_truth());
+        const float sum = pred_cls.distribution().sum();
+        packed.classification_distribution_sums.push_back(sum);
+        for (int class_idx = 0; class_idx < packed.num_classes; class_idx++) {
+          float probability = 0.f;
+          if (sum > 0) {
+            probability = pred_cls.distribution().counts(class_idx) / sum;
+          }
+          packed.classification_probabilities.push_back(probability);
+        }
+      }
+      break;
+
+    case model::proto::Prediction::kRegression:
+      packed.regression_ground_truths.reserve(num_examples);
+      packed.regression_predictions.reserve(num_examples);
+      for (const auto& pred : eval.sampled_predictions()) {
+        packed.weights.push_back(pred.weight());
+        packed.regression_ground_truths.push_back(
+            pred.regression().ground_truth());
+        packed.regression_predictions.push_back(pred.regression().value());
+      }
+      break;
+
+    case model::proto::Prediction::kRanking:
+      packed.ranking_ground_truth_relevances.reserve(num_examples);
+      packed.ranking_predicted_relevances.reserve(num_examples);
+      packed.ranking_group_ids.reserve(num_examples);
+      for (const auto& pred : eval.sampled_predictions()) {
+        packed.weights.push_back(pred.weight());
+        packed.ranking_ground_truth_relevances.push_back(
+            pred.ranking().ground_truth_relevance());
+        packed.ranking_predicted_relevances.push_back(
+            pred.ranking().relevance());
+        packed.ranking_group_ids.push_back(pred.ranking().group_id());
+      }
+      break;
+
+    default:
+      return absl::InvalidArgumentError(
+          "The sampled predictions are not classification, regression or "
+          "ranking predictions.");
+  }
+  return packed;
+}
+
 absl::Status MergeEvaluation(const proto::EvaluationOptions& option,
                              const proto::EvaluationResults& src,
                              proto::EvaluationResults* dst) {
@@ -18,6 +18,7 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_METRIC_METRIC_H_
 #define YGGDRASIL_DECISION_FORESTS_METRIC_METRIC_H_
 
+#include <cstdint>
 #include <functional>
 #include <random>
 #include <string>
@@ -206,6 +207,44 @@ struct BinaryPrediction {
   float weight;
 };
 
+// Columnar representation of the sampled predictions of an evaluation: each
+// prediction field is unpacked in its own array, indexed by example. The
+// bootstrapping and model comparison tests visit the predictions many times;
+// scanning these parallel arrays is significantly more compact and faster
+// than re-walking the "sampled_predictions" protos at each round. Only the
+// columns matching the type of the predictions are populated.
+struct PackedPredictions {
+  // Weight of each example.
+  std::vector<float> weights;
+
+  // Classification only. "classification_probabilities" contains the
+  // predicted probability of each class, indexed by
+  // "example_idx * num_classes + class_idx". If the prediction distribution
+  // of an example is empty, its probabilities and its
+  // "classification_distribution_sums" entry are zero.
+  std::vector<int> classification_ground_truths;
+  std::vector<float> classification_probabilities;
+  std::vector<float> classification_distribution_sums;
+  int num_classes = 0;
+
+  // Regression only.
+  std::vector<float> regression_ground_truths;
+  std::vector<float> regression_predictions;
+
+  // Ranking only.
+  std::vector<float> ranking_ground_truth_relevances;
+  std::vector<float> ranking_predicted_relevances;
+  std::vector<uint64_t> ranking_group_ids;
+
+  size_t num_examples() const { return weights.size(); }
+};
+
+// Unpacks the sampled predictions of "eval" into a columnar representation.
+// Fails if the sampled predictions are not classification, regression or
+// ranking predictions.
+utils::StatusOr<PackedPredictions> PackPredictions(
+    const proto::EvaluationResults& eval);
+
 // Create a string "[Metric] ([label value] vs the other)". For example: "AUC
 // (Class1 vs the others)".
 std::string GetPerClassComparisonMetricLabel(
@@ -313,6 +352,35 @@ std::pair<double, double> GetQuantiles(
 absl::Status UpdateRMSEConfidenceIntervalUsingBootstrapping(
     const proto::EvaluationOptions& option, proto::EvaluationResults* eval);
 
+// Updates the streaming approximate AUC score histograms (see
+// "EvaluationOptions.Classification.streaming_auc") with one classification
+// prediction.
+void UpdateStreamingAucAccumulators(
+    const proto::EvaluationOptions& option,
+    const model::proto::Prediction& pred,
+    proto::EvaluationResults::Classification* eval_cls);
+
+// Approximate AUC from a streaming score histogram: probability for a random
+// positive example to have a higher score than a random negative example,
+// with bin-level ties counting for one half. Returns NaN if the positive or
+// negative examples are missing.
+double ApproximateAucFromStreamingAccumulator(
+    const proto::EvaluationResults::Classification::StreamingAucAccumulator&
+        accumulator);
+
+// Updates the streaming Poisson bootstrap accumulators (see
+// "EvaluationOptions.streaming_bootstrap") with one regression prediction.
+void UpdateStreamingBootstrapAccumulators(
+    const proto::EvaluationOptions& option,
+    const model::proto::Prediction& pred, utils::RandomEngine* rnd,
+    proto::EvaluationResults* eval);
+
+// Same as "UpdateRMSEConfidenceIntervalUsingBootstrapping", but using the
+// streaming Poisson bootstrap accumulators instead of the sampled
+// predictions. Clears the accumulators.
+absl::Status UpdateRMSEConfidenceIntervalUsingStreamingBootstrap(
+    const proto::EvaluationOptions& option, proto::EvaluationResults* eval);
+
 // ROC metrics from a ROC point.
 double RocSum(const proto::Roc::Point& point);
 double RocFPR(const proto::Roc::Point& point);
@@ -250,6 +250,46 @@ TEST(Metric, EvaluationOfRegression) {
   LOG(INFO) << "Report :\n " << report;
 }
 
+TEST(Metric, PackPredictions) {
+  proto::EvaluationResults eval;
+
+  auto& pred_1 = *eval.mutable_sampled_predictions()->Add();
+  pred_1.set_weight(2.f);
+  pred_1.mutable_classification()->set_ground_truth(1);
+  auto& dist_1 = *pred_1.mutable_classification()->mutable_distribution();
+  dist_1.add_counts(1);
+  dist_1.add_counts(3);
+  dist_1.set_sum(4);
+
+  auto& pred_2 = *eval.mutable_sampled_predictions()->Add();
+  pred_2.set_weight(1.f);
+  pred_2.mutable_classification()->set_ground_truth(0);
+  auto& dist_2 = *pred_2.mutable_classification()->mutable_distribution();
+  dist_2.add_counts(1);
+  dist_2.add_counts(1);
+  dist_2.set_sum(2);
+
+  const auto packed = PackPredictions(eval).value();
+  EXPECT_EQ(packed.num_examples(), 2);
+  EXPECT_EQ(packed.num_classes, 2);
+  EXPECT_THAT(packed.weights, ElementsAre(2.f, 1.f));
+  EXPECT_THAT(packed.classification_ground_truths, ElementsAre(1, 0));
+  EXPECT_THAT(packed.classification_probabilities,
+              ElementsAre(0.25f, 0.75f, 0.5f, 0.5f));
+  EXPECT_THAT(packed.classification_distribution_sums, ElementsAre(4.f, 2.f));
+
+  proto::EvaluationResults eval_reg;
+  auto& pred_reg = *eval_reg.mutable_sampled_predictions()->Add();
+  pred_reg.set_weight(1.f);
+  pred_reg.mutable_regression()->set_value(0.5f);
+  pred_reg.mutable_regression()->set_ground_truth(1.f);
+
+  const auto packed_reg = PackPredictions(eval_reg).value();
+  EXPECT_EQ(packed_reg.num_examples(), 1);
+  EXPECT_THAT(packed_reg.regression_predictions, ElementsAre(0.5f));
+  EXPECT_THAT(packed_reg.regression_ground_truths, ElementsAre(1.f));
+}
+
 TEST(Metric, ComputeRoc) {
   // Create a fake column specification.
   dataset::proto::Column label_column;
@@ -587,6 +627,25 @@ TEST(Metric, AccuracyConfidenceInterval) {
   EXPECT_NEAR(ci.second, 0.805, 0.01);
 }
 
+TEST(Metric, MetricsOnSparseConfusionMatrix) {
+  // Above "kSparseConfusionMatrixMinNumRows" classes, the confusion matrix is
+  // accumulated in the sparse representation.
+  proto::EvaluationResults eval;
+  eval.set_task(model::proto::Task::CLASSIFICATION);
+  const int32_t num_classes = utils::kSparseConfusionMatrixMinNumRows;
+  auto& confusion = *eval.mutable_classification()->mutable_confusion();
+  utils::InitializeConfusionMatrixProto(num_classes, num_classes, &confusion);
+  EXPECT_TRUE(confusion.sparse());
+  utils::AddToConfusionMatrixProto(0, 0, 6, &confusion);
+  utils::AddToConfusionMatrixProto(1, 0, 2, &confusion);
+  utils::AddToConfusionMatrixProto(1, 1, 2, &confusion);
+  eval.set_count_predictions(10);
+  eval.set_count_predictions_no_weight(10);
+
+  EXPECT_NEAR(Accuracy(eval), 0.8, 0.0001);
+  EXPECT_NEAR(DefaultAccuracy(eval), 0.6, 0.0001);
+}
+
 TEST(Metric, AUCConfidenceInterval) {
   const proto::Roc roc = PARSE_TEST_PROTO(
       R"pb(
@@ -637,6 +696,69 @@ TEST(Metric, GetQuantiles) {
   EXPECT_NEAR(quantiles.second, 0.975f, 0.01);
 }
 
+TEST(Metric, StreamingAuc) {
+  // Compare the streaming approximate AUC with the exact AUC on random
+  // predictions.
+  dataset::proto::Column label_column;
+  label_column.set_type(dataset::proto::ColumnType::CATEGORICAL);
+  label_column.set_name("label");
+  label_column.mutable_categorical()->set_number_of_unique_values(3);
+  label_column.mutable_categorical()->set_most_frequent_value(1);
+
+  const proto::EvaluationOptions exact_options = PARSE_TEST_PROTO(
+      R"pb(
+        task: CLASSIFICATION
+        bootstrapping_samples: 0
+      )pb");
+  const proto::EvaluationOptions streaming_options = PARSE_TEST_PROTO(
+      R"pb(
+        task: CLASSIFICATION
+        bootstrapping_samples: 0
+        classification { roc_enable: false streaming_auc: true }
+      )pb");
+
+  utils::RandomEngine rnd;
+  std::uniform_real_distribution<float> dist_score(0, 1);
+  std::uniform_real_distribution<float> dist_label(0, 1);
+
+  proto::EvaluationResults exact_eval;
+  proto::EvaluationResults streaming_eval;
+  CHECK_OK(InitializeEvaluation(exact_options, label_column, &exact_eval));
+  CHECK_OK(
+      InitializeEvaluation(streaming_options, label_column, &streaming_eval));
+
+  const int num_predictions = 2000;
+  for (int pred_idx = 0; pred_idx < num_predictions; pred_idx++) {
+    const float score = dist_score(rnd);
+    model::proto::Prediction pred;
+    auto* pred_cls = pred.mutable_classification();
+    auto* pred_proba = pred_cls->mutable_distribution();
+    pred_proba->mutable_counts()->Resize(3, 0);
+    pred_proba->set_counts(1, 1 - score);
+    pred_proba->set_counts(2, score);
+    pred_proba->set_sum(1);
+    pred_cls->set_value((score > 0.5f) ? 2 : 1);
+    pred_cls->set_ground_truth((dist_label(rnd) < score) ? 2 : 1);
+    CHECK_OK(AddPrediction(exact_options, pred, &rnd, &exact_eval));
+    CHECK_OK(AddPrediction(streaming_options, pred, &rnd, &streaming_eval));
+  }
+  CHECK_OK(FinalizeEvaluation(exact_options, label_column, &exact_eval));
+  CHECK_OK(
+      FinalizeEvaluation(streaming_options, label_column, &streaming_eval));
+
+  // The streaming evaluation does not retain the predictions, and its
+  // accumulators are cleared during the finalization.
+  EXPECT_EQ(streaming_eval.sampled_predictions_size(), 0);
+  EXPECT_EQ(streaming_eval.classification().streaming_auc_accumulators_size(),
+            0);
+
+  ASSERT_EQ(streaming_eval.classification().rocs_size(), 3);
+  for (const int label_value : {1, 2}) {
+    EXPECT_NEAR(streaming_eval.classification().rocs(label_value).auc(),
+                exact_eval.classification().rocs(label_value).auc(), 0.001);
+  }
+}
+
 TEST(Metric, ComputeRocConfidenceIntervalsUsingBootstrapping) {
   const proto::EvaluationOptions options = PARSE_TEST_PROTO(
       R"pb(
@@ -676,6 +798,28 @@ TEST(Metric, ComputeRocConfidenceIntervalsUsingBootstrapping) {
       1.00, 0.02);
 }
 
+TEST(Metric, ComputeRocConfidenceIntervalsUsingBootstrappingMultiThreaded) {
+  const proto::EvaluationOptions options = PARSE_TEST_PROTO(
+      R"pb(
+        task: CLASSIFICATION
+        classification { precision_at_recall: 0.50 recall_at_precision: 0.50 }
+        num_threads: 4
+      )pb");
+  const std::vector<BinaryPrediction> sorted_predictions = {
+      {0.0, false, 1}, {0.1, false, 1}, {0.2, false, 1}, {0.3, true, 1},
+      {0.4, false, 1}, {0.5, false, 1}, {0.6, true, 1},  {0.7, true, 1},
+      {0.8, false, 1}, {0.9, true, 1},  {1.0, true, 1}};
+  proto::Roc roc;
+  CHECK_OK(internal::ComputeRocConfidenceIntervalsUsingBootstrapping(
+      options, sorted_predictions, &roc));
+
+  EXPECT_NEAR(roc.bootstrap_lower_bounds_95p().auc(), 0.50, 0.10);
+  EXPECT_NEAR(roc.bootstrap_upper_bounds_95p().auc(), 1.0, 0.01);
+
+  EXPECT_NEAR(roc.bootstrap_lower_bounds_95p().pr_auc(), 0.30, 0.10);
+  EXPECT_NEAR(roc.bootstrap_upper_bounds_95p().pr_auc(), 1.00, 0.01);
+}
+
 TEST(Metric, ExtractFlatMetricsRegression) {
   proto::EvaluationResults evaluation;
   evaluation.set_task(model::proto::Task::REGRESSION);
@@ -711,6 +855,12 @@ TEST(Metric, RMSEConfidenceIntervals) {
       R"pb(
         task: REGRESSION
       )pb");
+  const proto::EvaluationOptions streaming_options = PARSE_TEST_PROTO(
+      R"pb(
+        task: REGRESSION
+        streaming_bootstrap: true
+        regression { enable_regression_plots: false }
+      )pb");
   utils::RandomEngine rnd;
   std::normal_distribution<float> dist_residual;
   std::uniform_real_distribution<float> dist_label(0, 10);
@@ -723,11 +873,15 @@ TEST(Metric, RMSEConfidenceIntervals) {
   label_column.set_type(dataset::proto::ColumnType::NUMERICAL);
 
   int count_in_confidence_interval_boot = 0;
+  int count_in_confidence_interval_streaming = 0;
   int count_in_confidence_interval_closed = 0;
   for (int run = 0; run < num_runs; run++) {
     // Simulate a dataset evaluation.
     proto::EvaluationResults eval;
+    proto::EvaluationResults streaming_eval;
     CHECK_OK(InitializeEvaluation(options, label_column, &eval));
+    CHECK_OK(InitializeEvaluation(streaming_options, label_column,
+                                  &streaming_eval));
     for (int pred_idx = 0; pred_idx < num_predictions; pred_idx++) {
       model::proto::Prediction pred;
       const float label = dist_label(rnd);
@@ -735,8 +889,11 @@ TEST(Metric, RMSEConfidenceIntervals) {
       pred.mutable_regression()->set_ground_truth(label + residual);
       pred.mutable_regression()->set_value(label);
       CHECK_OK(AddPrediction(options, pred, &rnd, &eval));
+      CHECK_OK(AddPrediction(streaming_options, pred, &rnd, &streaming_eval));
     }
     CHECK_OK(FinalizeEvaluation(options, label_column, &eval));
+    CHECK_OK(
+        FinalizeEvaluation(streaming_options, label_column, &streaming_eval));
     // Check validity of confidence intervals.
     const bool in_confidence_interval_boot =
         (real_rmse >= eval.regression().bootstrap_rmse_lower_bounds_95p()) &&
@@ -745,6 +902,17 @@ TEST(Metric, RMSEConfidenceIntervals) {
       count_in_confidence_interval_boot++;
     }
 
+    // The streaming bootstrap does not retain the predictions.
+    EXPECT_EQ(streaming_eval.sampled_predictions_size(), 0);
+    const bool in_confidence_interval_streaming =
+        (real_rmse >=
+         streaming_eval.regression().bootstrap_rmse_lower_bounds_95p()) &&
+        (real_rmse <=
+         streaming_eval.regression().bootstrap_rmse_upper_bounds_95p());
+    if (in_confidence_interval_streaming) {
+      count_in_confidence_interval_streaming++;
+    }
+
     const auto closed_form_ci = RMSEConfidenceInterval(eval);
     const bool in_confidence_interval_closed =
         (real_rmse >= closed_form_ci.first) &&
@@ -756,6 +924,9 @@ TEST(Metric, RMSEConfidenceIntervals) {
   // ~95% of the CI should be valid.
   EXPECT_NEAR(static_cast<double>(count_in_confidence_interval_boot) / num_runs,
               0.95, 0.03);
+  EXPECT_NEAR(
+      static_cast<double>(count_in_confidence_interval_streaming) / num_runs,
+      0.95, 0.03);
   EXPECT_NEAR(
       static_cast<double>(count_in_confidence_interval_closed) / num_runs, 0.95,
       0.03);
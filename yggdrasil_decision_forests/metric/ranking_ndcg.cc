@@ -58,6 +58,31 @@ double NDCGCalculator::NDCG(
   std::sort(mutable_group.begin(), mutable_group.end(),
             OrderDecreasingPrediction);
 
+  // Detect ties in the predictions impacting the truncated DCG. A tie matters
+  // if it starts before the truncation.
+  bool has_ties = false;
+  const int max_tie_rank =
+      std::min(static_cast<int>(group.size()), max_rank + 1);
+  for (int rank = 1; rank < max_tie_rank; rank++) {
+    if (mutable_group[rank].prediction == mutable_group[rank - 1].prediction) {
+      has_ties = true;
+      break;
+    }
+  }
+
+  if (!has_ties) {
+    // Fast path: simple accumulation that the compiler can vectorize.
+    double dcg = 0.;
+    for (int rank = 0; rank < max_rank; rank++) {
+      dcg += (std::exp2(static_cast<double>(mutable_group[rank].label)) - 1.) *
+             inv_log_rank_[rank];
+    }
+    if (idcg == 0) {
+      return 0.;
+    }
+    return dcg / idcg;
+  }
+
   float last_value = -1.f;
   double sum_gains = 0.;
   int num_gains = 0;
@@ -79,7 +104,7 @@ double NDCGCalculator::NDCG(
     }
     last_value = value;
 
-    sum_gains += std::pow(2, mutable_group[rank].label) - 1;
+    sum_gains += std::exp2(static_cast<double>(mutable_group[rank].label)) - 1;
     num_gains++;
 
     if (inside_truncation) {
@@ -113,7 +138,7 @@ double NDCGCalculator::DefaultNDCG(
 
   double mean_gain = 0;
   for (const auto& example : group) {
-    mean_gain += (std::pow(2, example.label) - 1);
+    mean_gain += (std::exp2(static_cast<double>(example.label)) - 1);
   }
   mean_gain /= group.size();
 
@@ -397,11 +397,19 @@ absl::Status AppendTextReportClassification(
   absl::StrAppend(report, "\n");
 
   if (eval.classification().has_confusion()) {
-    absl::StrAppend(report, "Confusion Table:\n");
-    utils::IntegersConfusionMatrixDouble confusion;
-    confusion.Load(eval.classification().confusion());
-    RETURN_IF_ERROR(confusion.AppendTextReport(eval.label_column(), report));
-    absl::StrAppend(report, "\n");
+    if (eval.classification().confusion().sparse()) {
+      // The table of a matrix with enough classes to be stored sparsely would
+      // not be readable (and loading it densely can take gigabytes).
+      absl::SubstituteAndAppend(
+          report, "Confusion Table: not printed ($0 classes)\n\n",
+          eval.classification().confusion().nrow());
+    } else {
+      absl::StrAppend(report, "Confusion Table:\n");
+      utils::IntegersConfusionMatrixDouble confusion;
+      confusion.Load(eval.classification().confusion());
+      RETURN_IF_ERROR(confusion.AppendTextReport(eval.label_column(), report));
+      absl::StrAppend(report, "\n");
+    }
   }
 
   // Print a description of a X@Y metric. For example:
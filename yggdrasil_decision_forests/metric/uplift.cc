@@ -15,7 +15,13 @@
 
 #include "yggdrasil_decision_forests/metric/uplift.h"
 
+#include <algorithm>
+#include <array>
+#include <thread>
+
 #include "absl/strings/substitute.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
@@ -39,6 +45,59 @@ utils::StatusOr<float> GetOutcome(const model::proto::Prediction& prediction) {
   }
 }
 
+// Sorts the examples by decreasing predicted uplift. Large sets of examples
+// are sorted in chunks by multiple threads, and the sorted chunks are merged
+// pairwise (same scheme as "SortBinaryPredictions" in metric.cc).
+void SortExamplesByDecreasingUplift(
+    std::vector<internal::Example>* examples) {
+  const auto comparator = std::greater<internal::Example>();
+  // Minimum number of examples in each sorted chunk. Small sets of examples
+  // are not worth the thread synchronization overhead.
+  constexpr size_t kMinExamplesPerChunk = 100000;
+  const size_t num_chunks = std::min<size_t>(
+      (examples->size() + kMinExamplesPerChunk - 1) / kMinExamplesPerChunk,
+      std::max<unsigned int>(1, std::thread::hardware_concurrency()));
+  if (num_chunks <= 1) {
+    std::sort(examples->begin(), examples->end(), comparator);
+    return;
+  }
+
+  std::vector<size_t> boundaries(num_chunks + 1);
+  for (size_t chunk_idx = 0; chunk_idx <= num_chunks; chunk_idx++) {
+    boundaries[chunk_idx] = examples->size() * chunk_idx / num_chunks;
+  }
+
+  {
+    utils::concurrency::ThreadPool pool("sort_uplift", num_chunks);
+    pool.StartWorkers();
+    for (size_t chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
+      pool.Schedule([examples, &boundaries, &comparator, chunk_idx]() {
+        std::sort(examples->begin() + boundaries[chunk_idx],
+                  examples->begin() + boundaries[chunk_idx + 1], comparator);
+      });
+    }
+  }
+
+  // Merge the sorted chunks pairwise. The merges of each round run in
+  // parallel.
+  for (size_t step = 1; step < num_chunks; step *= 2) {
+    utils::concurrency::ThreadPool pool(
+        "merge_uplift", (num_chunks + 2 * step - 1) / (2 * step));
+    pool.StartWorkers();
+    for (size_t chunk_idx = 0; chunk_idx + step < num_chunks;
+         chunk_idx += 2 * step) {
+      const size_t begin = boundaries[chunk_idx];
+      const size_t middle = boundaries[chunk_idx + step];
+      const size_t end = boundaries[std::min(chunk_idx + 2 * step, num_chunks)];
+      pool.Schedule([examples, &comparator, begin, middle, end]() {
+        std::inplace_merge(examples->begin() + begin,
+                           examples->begin() + middle,
+                           examples->begin() + end, comparator);
+      });
+    }
+  }
+}
+
 }  // namespace
 
 absl::Status InitializeCategoricalUpliftEvaluation(
@@ -139,8 +198,16 @@ absl::Status FinalizeUpliftMetricsFromSampledPredictions(
     }
   }
 
-  // Sort the effect/outcome/treatment values by increasing effect.
-  std::sort(examples.begin(), examples.end(), std::greater<>());
+  const int auuc_num_bins = option.uplift().auuc_num_bins();
+  if (auuc_num_bins > 0) {
+    // Approximate mode: the examples are aggregated into bins instead of
+    // being individually sorted.
+    examples = internal::GroupExamplesByPredictedUplift(
+        examples, auuc_num_bins, /*positive_treatment=*/1);
+  } else {
+    // Sort the effect/outcome/treatment values by decreasing effect.
+    SortExamplesByDecreasingUplift(&examples);
+  }
 
   const auto auuc_result = internal::ComputeAuuc(examples, /*treatment=*/1);
   const auto qini = auuc_result.auc - auuc_result.max_uplift_curve / 2;
@@ -159,58 +226,217 @@ AreaUnderCurve ComputeAuuc(const std::vector<Example>& sorted_items,
     return AreaUnderCurve{0, 0};
   }
 
-  // Count the number of examples in control and treatment.
-  double sum_treatments = 0;
-  double sum_controls = 0;
+  // The examples are swept in blocks: each block accumulates its sums of
+  // weights and outcomes in parallel, a sequential scan of the per-block sums
+  // gives each block the accumulated sums of the blocks before it, and each
+  // block then computes its contribution to the area in parallel. The block
+  // size is fixed (instead of derived from the number of threads) so the
+  // result does not depend on the number of threads.
+  constexpr size_t kBlockSize = 1 << 20;
+  const size_t num_examples = sorted_items.size();
+  const size_t num_blocks = (num_examples + kBlockSize - 1) / kBlockSize;
 
-  double sum_weights = 0;
-  for (const auto& example : sorted_items) {
-    if (example.treatment == positive_treatment) {
-      sum_treatments += example.weight;
-    } else {
-      sum_controls += example.weight;
+  // Block boundaries, aligned on the groups of tied predictions: the
+  // trapezoids of the curve end at the tie groups, so a block starting at a
+  // tie boundary can compute its trapezoids from the accumulated sums alone.
+  std::vector<size_t> boundaries(num_blocks + 1);
+  boundaries[0] = 0;
+  for (size_t block_idx = 1; block_idx < num_blocks; block_idx++) {
+    size_t boundary = std::max(boundaries[block_idx - 1],
+                               std::min(block_idx * kBlockSize, num_examples));
+    while (boundary < num_examples &&
+           sorted_items[boundary].predicted_uplift ==
+               sorted_items[boundary - 1].predicted_uplift) {
+      boundary++;
     }
-    sum_weights += example.weight;
+    boundaries[block_idx] = boundary;
   }
+  boundaries[num_blocks] = num_examples;
 
-  double auuc = 0;
-  double acc_sum_treatment_outcomes = 0;
-  double acc_sum_control_outcomes = 0;
-  double acc_sum_weights = 0;
+  // Sums of weights and weighted outcomes of a block, split by treatment arm.
+  struct BlockSums {
+    double treatment_weights = 0;
+    double control_weights = 0;
+    double treatment_outcomes = 0;
+    double control_outcomes = 0;
+    double weights = 0;
+  };
+  std::vector<BlockSums> block_sums(num_blocks);
+  const auto compute_block_sums = [&](const size_t block_idx) {
+    auto& sums = block_sums[block_idx];
+    for (size_t example_idx = boundaries[block_idx];
+         example_idx < boundaries[block_idx + 1]; example_idx++) {
+      const auto& example = sorted_items[example_idx];
+      if (example.treatment == positive_treatment) {
+        sums.treatment_weights += example.weight;
+        sums.treatment_outcomes += example.weight * example.outcome;
+      } else {
+        sums.control_weights += example.weight;
+        sums.control_outcomes += example.weight * example.outcome;
+      }
+      sums.weights += example.weight;
+    }
+  };
 
-  double last_net_lift = 0;
-  double last_acc_sum_weights = 0;
+  const size_t num_threads = std::min<size_t>(
+      num_blocks,
+      std::max<unsigned int>(1, std::thread::hardware_concurrency()));
+  if (num_blocks > 1) {
+    utils::concurrency::ThreadPool pool("auuc_sums", num_threads);
+    pool.StartWorkers();
+    for (size_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+      pool.Schedule(
+          [&compute_block_sums, block_idx]() { compute_block_sums(block_idx); });
+    }
+  } else {
+    compute_block_sums(0);
+  }
 
-  for (size_t example_idx = 0; example_idx < sorted_items.size();
-       example_idx++) {
-    const auto& example = sorted_items[example_idx];
+  // Exclusive prefix sums of the per-block sums, and totals.
+  std::vector<BlockSums> prefix_sums(num_blocks);
+  BlockSums totals;
+  for (size_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+    prefix_sums[block_idx] = totals;
+    const auto& sums = block_sums[block_idx];
+    totals.treatment_weights += sums.treatment_weights;
+    totals.control_weights += sums.control_weights;
+    totals.treatment_outcomes += sums.treatment_outcomes;
+    totals.control_outcomes += sums.control_outcomes;
+    totals.weights += sums.weights;
+  }
+  const double sum_treatments = totals.treatment_weights;
+  const double sum_controls = totals.control_weights;
+  const double sum_weights = totals.weights;
 
-    if (example.treatment == positive_treatment) {
-      acc_sum_treatment_outcomes += example.weight * example.outcome;
-    } else {
-      acc_sum_control_outcomes += example.weight * example.outcome;
+  std::vector<double> block_auuc(num_blocks, 0.);
+  const auto compute_block_auuc = [&](const size_t block_idx) {
+    const auto& prefix = prefix_sums[block_idx];
+    double acc_sum_treatment_outcomes = prefix.treatment_outcomes;
+    double acc_sum_control_outcomes = prefix.control_outcomes;
+    double acc_sum_weights = prefix.weights;
+
+    // Value of the curve at the end of the previous block. Valid because the
+    // block boundaries are aligned on the tie groups.
+    double last_net_lift = 0;
+    if (boundaries[block_idx] > 0) {
+      last_net_lift = prefix.treatment_outcomes / sum_treatments -
+                      prefix.control_outcomes / sum_controls;
     }
-    acc_sum_weights += example.weight;
-
-    // Making sure tied predictions are grouped together.
-    if (example_idx + 1 == sorted_items.size() ||
-        example.predicted_uplift !=
-            sorted_items[example_idx + 1].predicted_uplift) {
-      // Following the notation in section 7.2 of "Optimal personalized
-      // treatment learning models with insurance applications" by "Leo
-      // Guelman".
-      const double r_treatment = acc_sum_treatment_outcomes / sum_treatments;
-      const double r_control = acc_sum_control_outcomes / sum_controls;
-      const double net_lift = r_treatment - r_control;
-      auuc += (acc_sum_weights - last_acc_sum_weights) / sum_weights *
-              (net_lift + last_net_lift) / 2;
-
-      last_net_lift = net_lift;
-      last_acc_sum_weights = acc_sum_weights;
+    double last_acc_sum_weights = acc_sum_weights;
+
+    double auuc = 0;
+    for (size_t example_idx = boundaries[block_idx];
+         example_idx < boundaries[block_idx + 1]; example_idx++) {
+      const auto& example = sorted_items[example_idx];
+
+      if (example.treatment == positive_treatment) {
+        acc_sum_treatment_outcomes += example.weight * example.outcome;
+      } else {
+        acc_sum_control_outcomes += example.weight * example.outcome;
+      }
+      acc_sum_weights += example.weight;
+
+      // Making sure tied predictions are grouped together.
+      if (example_idx + 1 == num_examples ||
+          example.predicted_uplift !=
+              sorted_items[example_idx + 1].predicted_uplift) {
+        // Following the notation in section 7.2 of "Optimal personalized
+        // treatment learning models with insurance applications" by "Leo
+        // Guelman".
+        const double r_treatment = acc_sum_treatment_outcomes / sum_treatments;
+        const double r_control = acc_sum_control_outcomes / sum_controls;
+        const double net_lift = r_treatment - r_control;
+        auuc += (acc_sum_weights - last_acc_sum_weights) / sum_weights *
+                (net_lift + last_net_lift) / 2;
+
+        last_net_lift = net_lift;
+        last_acc_sum_weights = acc_sum_weights;
+      }
+    }
+    block_auuc[block_idx] = auuc;
+  };
+
+  if (num_blocks > 1) {
+    utils::concurrency::ThreadPool pool("auuc_sweep", num_threads);
+    pool.StartWorkers();
+    for (size_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+      pool.Schedule(
+          [&compute_block_auuc, block_idx]() { compute_block_auuc(block_idx); });
+    }
+  } else {
+    compute_block_auuc(0);
+  }
+
+  // The per-block contributions are summed in block order so the result does
+  // not depend on the scheduling.
+  double auuc = 0;
+  for (const double block_value : block_auuc) {
+    auuc += block_value;
+  }
+  const double max_uplift_curve = totals.treatment_outcomes / sum_treatments -
+                                  totals.control_outcomes / sum_controls;
+  return {auuc, max_uplift_curve};
+}
+
+std::vector<Example> GroupExamplesByPredictedUplift(
+    const std::vector<Example>& examples, const int num_bins,
+    const int positive_treatment) {
+  DCHECK_GT(num_bins, 0);
+  if (examples.empty()) {
+    return {};
+  }
+
+  float min_uplift = examples.front().predicted_uplift;
+  float max_uplift = min_uplift;
+  for (const auto& example : examples) {
+    min_uplift = std::min(min_uplift, example.predicted_uplift);
+    max_uplift = std::max(max_uplift, example.predicted_uplift);
+  }
+
+  // Accumulated weight and weighted outcome of each bin and treatment arm.
+  struct Accumulator {
+    double sum_weights = 0;
+    double sum_weighted_outcomes = 0;
+  };
+  const int effective_num_bins = (max_uplift > min_uplift) ? num_bins : 1;
+  std::vector<std::array<Accumulator, 2>> bins(effective_num_bins);
+  for (const auto& example : examples) {
+    int bin_idx = 0;
+    if (effective_num_bins > 1) {
+      bin_idx = static_cast<int>((example.predicted_uplift - min_uplift) /
+                                 (max_uplift - min_uplift) *
+                                 effective_num_bins);
+      bin_idx = std::min(bin_idx, effective_num_bins - 1);
     }
+    auto& acc = bins[bin_idx][example.treatment == positive_treatment];
+    acc.sum_weights += example.weight;
+    acc.sum_weighted_outcomes += example.weight * example.outcome;
   }
 
-  return {auuc, last_net_lift};
+  // Emit one pseudo-example per non-empty bin and treatment arm, by
+  // decreasing predicted uplift. The treatment value of the control arm only
+  // needs to differ from "positive_treatment".
+  const int control_treatment = (positive_treatment == 0) ? 1 : 0;
+  std::vector<Example> binned_examples;
+  binned_examples.reserve(2 * effective_num_bins);
+  for (int bin_idx = effective_num_bins - 1; bin_idx >= 0; bin_idx--) {
+    const float bin_uplift = min_uplift + (max_uplift - min_uplift) *
+                                              (bin_idx + 0.5f) /
+                                              effective_num_bins;
+    for (const int arm : {1, 0}) {
+      const auto& acc = bins[bin_idx][arm];
+      if (acc.sum_weights == 0) {
+        continue;
+      }
+      binned_examples.push_back(Example{
+          /*predicted_uplift=*/bin_uplift,
+          /*outcome=*/
+          static_cast<float>(acc.sum_weighted_outcomes / acc.sum_weights),
+          /*weight=*/static_cast<float>(acc.sum_weights),
+          /*treatment=*/(arm == 1) ? positive_treatment : control_treatment});
+    }
+  }
+  return binned_examples;
 }
 
 }  // namespace internal
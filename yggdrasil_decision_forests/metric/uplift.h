@@ -69,9 +69,23 @@ struct AreaUnderCurve {
   double max_uplift_curve;
 };
 
+// Computes the AUUC (area under the cumulative uplift curve) of examples
+// sorted by decreasing predicted uplift. Large sets of examples are swept in
+// parallel blocks; the result does not depend on the number of threads.
 AreaUnderCurve ComputeAuuc(const std::vector<Example>& sorted_items,
                            int positive_treatment);
 
+// Aggregates the examples into "num_bins" bins of equal width over the range
+// of the predicted uplifts. Each bin and treatment arm is reduced to a single
+// pseudo-example with the accumulated weight and the weighted mean outcome:
+// the cumulative uplift curve of the pseudo-examples is the curve of the
+// original examples with the predictions quantized to the bins. Returns the
+// pseudo-examples sorted by decreasing predicted uplift, ready for
+// "ComputeAuuc".
+std::vector<Example> GroupExamplesByPredictedUplift(
+    const std::vector<Example>& examples, int num_bins,
+    int positive_treatment);
+
 }  // namespace internal
 
 }  // namespace uplift
@@ -15,6 +15,10 @@
 
 #include "yggdrasil_decision_forests/metric/uplift.h"
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/substitute.h"
@@ -139,6 +143,36 @@ TEST(Uplift, DuplicateEffectValues) {
   EXPECT_NEAR(Qini(evaluation), -0.25, 0.0001);
 }
 
+TEST(Uplift, BinnedAuucApproximation) {
+  const std::vector<uplift::internal::Example> examples = {
+      {0.9f, 1.f, 1.f, 1}, {0.8f, 1.f, 1.f, 0}, {0.5f, 0.f, 1.f, 1},
+      {0.4f, 1.f, 1.f, 0}, {0.1f, 0.f, 1.f, 1}, {0.05f, 0.f, 1.f, 0}};
+
+  auto sorted_examples = examples;
+  std::sort(sorted_examples.begin(), sorted_examples.end(), std::greater<>());
+  const auto exact =
+      uplift::internal::ComputeAuuc(sorted_examples, /*positive_treatment=*/1);
+
+  // With enough bins to separate all the distinct predictions, the binned
+  // curve matches the exact curve.
+  const auto binned_examples = uplift::internal::GroupExamplesByPredictedUplift(
+      examples, /*num_bins=*/1000, /*positive_treatment=*/1);
+  const auto approximate =
+      uplift::internal::ComputeAuuc(binned_examples, /*positive_treatment=*/1);
+  EXPECT_NEAR(approximate.auc, exact.auc, 0.0001);
+  EXPECT_NEAR(approximate.max_uplift_curve, exact.max_uplift_curve, 0.0001);
+
+  // A single bin collapses the curve to one segment: the area is half of the
+  // maximum of the curve.
+  const auto one_bin_examples =
+      uplift::internal::GroupExamplesByPredictedUplift(
+          examples, /*num_bins=*/1, /*positive_treatment=*/1);
+  const auto one_bin =
+      uplift::internal::ComputeAuuc(one_bin_examples, /*positive_treatment=*/1);
+  EXPECT_NEAR(one_bin.auc, exact.max_uplift_curve / 2, 0.0001);
+  EXPECT_NEAR(one_bin.max_uplift_curve, exact.max_uplift_curve, 0.0001);
+}
+
 }  // namespace
 }  // namespace metric
 }  // namespace yggdrasil_decision_forests
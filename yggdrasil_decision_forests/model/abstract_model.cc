@@ -33,9 +33,12 @@
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
+#include "yggdrasil_decision_forests/dataset/example_reader.h"
 #include "yggdrasil_decision_forests/dataset/formats.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
@@ -50,10 +53,12 @@
 #include "yggdrasil_decision_forests/model/prediction.pb.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
 #include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/serving/numa_replicated_engine.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
 #include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/distribution.h"
 #include "yggdrasil_decision_forests/utils/distribution.pb.h"
+#include "yggdrasil_decision_forests/utils/instrument.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/random.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
@@ -314,30 +319,32 @@ absl::Status AbstractModel::AppendEvaluationWithEngine(
     const dataset::VerticalDataset& dataset,
     const metric::proto::EvaluationOptions& option,
     const dataset::proto::LinkedWeightDefinition& weight_links,
-    const serving::FastEngine& engine, utils::RandomEngine* rnd,
+    const serving::FastEngine& engine, const int64_t begin_example_idx,
+    const int64_t end_example_idx, utils::RandomEngine* rnd,
     std::vector<model::proto::Prediction>* predictions,
     metric::proto::EvaluationResults* eval) const {
   const auto& engine_features = engine.features();
   const int num_prediction_dimensions = engine.NumPredictionDimension();
 
   // Evaluate using the semi-fast generic engine.
-  const int64_t total_num_examples = dataset.nrow();
-  const int64_t batch_size =
-      std::min(static_cast<int64_t>(100), total_num_examples);
+  const int64_t num_examples = end_example_idx - begin_example_idx;
+  if (num_examples == 0) {
+    return absl::OkStatus();
+  }
+  const int64_t batch_size = std::min(static_cast<int64_t>(100), num_examples);
 
   auto batch_of_examples = engine.AllocateExamples(batch_size);
-  const int64_t num_batches =
-      (total_num_examples + batch_size - 1) / batch_size;
+  const int64_t num_batches = (num_examples + batch_size - 1) / batch_size;
 
   std::vector<float> batch_of_predictions;
   proto::Prediction prediction;
   for (int64_t batch_idx = 0; batch_idx < num_batches; batch_idx++) {
-    const int64_t begin_example_idx = batch_idx * batch_size;
-    const int64_t end_example_idx =
-        std::min(begin_example_idx + batch_size, total_num_examples);
-    const int effective_batch_size = end_example_idx - begin_example_idx;
+    const int64_t begin_batch_idx = begin_example_idx + batch_idx * batch_size;
+    const int64_t end_batch_idx =
+        std::min(begin_batch_idx + batch_size, end_example_idx);
+    const int effective_batch_size = end_batch_idx - begin_batch_idx;
     RETURN_IF_ERROR(CopyVerticalDatasetToAbstractExampleSet(
-        dataset, begin_example_idx, end_example_idx, engine_features,
+        dataset, begin_batch_idx, end_batch_idx, engine_features,
         batch_of_examples.get()));
     engine.Predict(*batch_of_examples, effective_batch_size,
                    &batch_of_predictions);
@@ -346,12 +353,12 @@ absl::Status AbstractModel::AppendEvaluationWithEngine(
       FloatToProtoPrediction(batch_of_predictions, sub_example_idx, task(),
                              num_prediction_dimensions, &prediction);
       RETURN_IF_ERROR(SetGroundTruth(
-          dataset, begin_example_idx + sub_example_idx, &prediction));
+          dataset, begin_batch_idx + sub_example_idx, &prediction));
       if (option.has_weights()) {
         ASSIGN_OR_RETURN(
             const float weight,
             dataset::GetWeightWithStatus(
-                dataset, begin_example_idx + sub_example_idx, weight_links));
+                dataset, begin_batch_idx + sub_example_idx, weight_links));
         prediction.set_weight(weight);
       }
       RETURN_IF_ERROR(metric::AddPrediction(option, prediction, rnd, eval));
@@ -376,9 +383,63 @@ absl::Status AbstractModel::AppendEvaluation(
 
   auto engine_or_status = BuildFastEngine();
   if (engine_or_status.ok()) {
-    RETURN_IF_ERROR(AppendEvaluationWithEngine(dataset, option, weight_links,
-                                               *engine_or_status.value(), rnd,
-                                               predictions, eval));
+    const auto engine = std::move(engine_or_status.value());
+    const int64_t total_num_examples = dataset.nrow();
+
+    // Number of examples evaluated by each thread. Small datasets are not
+    // worth the thread synchronization overhead.
+    constexpr int64_t kMinExamplesPerBlock = 10000;
+    const int num_blocks = std::min<int64_t>(
+        (total_num_examples + kMinExamplesPerBlock - 1) / kMinExamplesPerBlock,
+        20);
+
+    if (num_blocks <= 1) {
+      RETURN_IF_ERROR(AppendEvaluationWithEngine(
+          dataset, option, weight_links, *engine, 0, total_num_examples, rnd,
+          predictions, eval));
+    } else {
+      // Evaluate blocks of contiguous examples in separate threads, and merge
+      // the per-block evaluations in order.
+      const int64_t block_size =
+          (total_num_examples + num_blocks - 1) / num_blocks;
+      std::vector<metric::proto::EvaluationResults> block_evaluations(
+          num_blocks);
+      std::vector<std::vector<model::proto::Prediction>> block_predictions(
+          predictions ? num_blocks : 0);
+      std::vector<absl::Status> block_statuses(num_blocks);
+      {
+        utils::concurrency::ThreadPool thread_pool("evaluation", num_blocks);
+        thread_pool.StartWorkers();
+        for (int block_idx = 0; block_idx < num_blocks; block_idx++) {
+          thread_pool.Schedule([&, block_idx, sub_rnd_seed = (*rnd)()]() {
+            const int64_t begin_example_idx = block_idx * block_size;
+            const int64_t end_example_idx =
+                std::min(begin_example_idx + block_size, total_num_examples);
+            utils::RandomEngine sub_rnd(sub_rnd_seed);
+            auto& block_evaluation = block_evaluations[block_idx];
+            block_statuses[block_idx] = [&]() -> absl::Status {
+              RETURN_IF_ERROR(metric::InitializeEvaluation(
+                  option, LabelColumnSpec(), &block_evaluation));
+              return AppendEvaluationWithEngine(
+                  dataset, option, weight_links, *engine, begin_example_idx,
+                  end_example_idx, &sub_rnd,
+                  predictions ? &block_predictions[block_idx] : nullptr,
+                  &block_evaluation);
+            }();
+          });
+        }
+      }
+      for (int block_idx = 0; block_idx < num_blocks; block_idx++) {
+        RETURN_IF_ERROR(block_statuses[block_idx]);
+        RETURN_IF_ERROR(metric::MergeEvaluation(
+            option, block_evaluations[block_idx], eval));
+        if (predictions) {
+          predictions->insert(predictions->end(),
+                              block_predictions[block_idx].begin(),
+                              block_predictions[block_idx].end());
+        }
+      }
+    }
   } else {
     // Evaluate using the (slow) generic inference.
 
@@ -416,6 +477,24 @@ absl::Status AbstractModel::AppendEvaluation(
         option.weights(), data_spec_, &weight_links));
   }
 
+  // Only load the columns used by the model and the evaluation: the input
+  // features, the label, and the optional grouping, treatment and weight
+  // columns.
+  dataset::LoadConfig load_config;
+  load_config.load_columns = input_features_;
+  if (label_col_idx_ >= 0) {
+    load_config.load_columns->push_back(label_col_idx_);
+  }
+  if (ranking_group_col_idx_ >= 0) {
+    load_config.load_columns->push_back(ranking_group_col_idx_);
+  }
+  if (uplift_treatment_col_idx_ >= 0) {
+    load_config.load_columns->push_back(uplift_treatment_col_idx_);
+  }
+  if (option.has_weights()) {
+    load_config.load_columns->push_back(weight_links.attribute_idx());
+  }
+
   auto engine_or_status = BuildFastEngine();
   if (engine_or_status.ok()) {
     const auto engine = std::move(engine_or_status.value());
@@ -431,23 +510,50 @@ absl::Status AbstractModel::AppendEvaluation(
     int num_evaluated_shards = 0;
     absl::Status worker_status;
 
+    // Number of examples of a shard loaded in memory at any time by each
+    // evaluation thread. The examples are streamed: a batch is evaluated,
+    // accumulated in the (small) per-shard evaluation and discarded before the
+    // next batch is read, so the evaluation memory is bounded by the batch
+    // size and does not depend on the size of the shards.
+    constexpr int64_t kNumStreamedExamples = 10000;
+
     const auto process_shard = [&option, eval, &mutex, &prefix, &engine,
                                 &weight_links, &num_evaluated_shards, &shards,
-                                this](absl::string_view shard,
-                                      int sub_rnd_seed) -> absl::Status {
+                                &load_config, this](
+                                   absl::string_view shard,
+                                   int sub_rnd_seed) -> absl::Status {
       utils::RandomEngine sub_rnd(sub_rnd_seed);
 
-      dataset::VerticalDataset dataset;
-      RETURN_IF_ERROR(dataset::LoadVerticalDataset(
-          absl::StrCat(prefix, ":", shard), data_spec_, &dataset));
-
       metric::proto::EvaluationResults sub_evaluation;
       RETURN_IF_ERROR(metric::InitializeEvaluation(option, LabelColumnSpec(),
                                                    &sub_evaluation));
 
-      RETURN_IF_ERROR(AppendEvaluationWithEngine(dataset, option, weight_links,
-                                                 *engine, &sub_rnd, nullptr,
-                                                 &sub_evaluation));
+      ASSIGN_OR_RETURN(
+          const auto reader,
+          dataset::CreateExampleReader(absl::StrCat(prefix, ":", shard),
+                                       data_spec_, /*required_columns=*/{},
+                                       load_config.load_columns));
+      dataset::proto::Example example;
+      bool end_of_shard = false;
+      while (!end_of_shard) {
+        // Read a batch of examples.
+        dataset::VerticalDataset batch;
+        batch.set_data_spec(data_spec_);
+        RETURN_IF_ERROR(batch.CreateColumnsFromDataspec());
+        while (batch.nrow() < kNumStreamedExamples) {
+          ASSIGN_OR_RETURN(const bool has_value, reader->Next(&example));
+          if (!has_value) {
+            end_of_shard = true;
+            break;
+          }
+          RETURN_IF_ERROR(batch.AppendExampleWithStatus(
+              example, load_config.load_columns));
+        }
+
+        RETURN_IF_ERROR(AppendEvaluationWithEngine(
+            batch, option, weight_links, *engine, 0, batch.nrow(), &sub_rnd,
+            nullptr, &sub_evaluation));
+      }
 
       utils::concurrency::MutexLock lock(&mutex);
       RETURN_IF_ERROR(metric::MergeEvaluation(option, sub_evaluation, eval));
@@ -486,8 +592,10 @@ absl::Status AbstractModel::AppendEvaluation(
     LOG(WARNING)
         << "Evaluation with the slow generic engine without distribution";
     dataset::VerticalDataset dataset;
-    RETURN_IF_ERROR(
-        dataset::LoadVerticalDataset(typed_path, data_spec_, &dataset));
+    RETURN_IF_ERROR(dataset::LoadVerticalDataset(typed_path, data_spec_,
+                                                 &dataset,
+                                                 /*required_columns=*/{},
+                                                 load_config));
     RETURN_IF_ERROR(AppendEvaluation(dataset, option, rnd, eval));
     return absl::OkStatus();
   }
@@ -1243,8 +1351,49 @@ AbstractModel::ListCompatibleFastEngines() const {
   return compatible_engines;
 }
 
+namespace {
+
+// Average duration of a "Predict" call of an engine on a small batch of
+// synthetic examples (all the feature values are set to "missing" i.e.
+// replaced by their default). Used to compare the speed of the engines of a
+// model on the serving hardware. See "SetFastEngineCalibration".
+absl::Duration BenchmarkFastEngine(const serving::FastEngine& engine) {
+  // Size of the synthetic batch.
+  constexpr int kNumExamples = 256;
+  // Untimed runs warming the instruction and data caches.
+  constexpr int kNumWarmupRuns = 2;
+  // Timed runs.
+  constexpr int kNumRuns = 10;
+
+  const auto examples = engine.AllocateExamples(kNumExamples);
+  examples->FillMissing(engine.features());
+  std::vector<float> predictions;
+  for (int run_idx = 0; run_idx < kNumWarmupRuns; run_idx++) {
+    engine.Predict(*examples, kNumExamples, &predictions);
+  }
+  const auto begin = absl::Now();
+  for (int run_idx = 0; run_idx < kNumRuns; run_idx++) {
+    engine.Predict(*examples, kNumExamples, &predictions);
+  }
+  return (absl::Now() - begin) / kNumRuns;
+}
+
+}  // namespace
+
 utils::StatusOr<std::unique_ptr<serving::FastEngine>>
 AbstractModel::BuildFastEngine() const {
+  if (!numa_replicate_fast_engine_) {
+    return BuildSingleFastEngine();
+  }
+  // Build one engine replica per NUMA node. On single-node hosts, a single
+  // engine is built and returned directly.
+  return serving::NumaReplicatedEngine::Create(
+      [this]() { return BuildSingleFastEngine(); });
+}
+
+utils::StatusOr<std::unique_ptr<serving::FastEngine>>
+AbstractModel::BuildSingleFastEngine() const {
+  YDF_INSTRUMENT_SPAN("model.build_fast_engine");
   if (!allow_fast_engine_) {
     return absl::NotFoundError("allow_fast_engine is set to false.");
   }
@@ -1271,6 +1420,48 @@ AbstractModel::BuildFastEngine() const {
     return absl::NotFoundError(no_compatible_engine_message);
   }
 
+  if (calibrate_fast_engine_ && compatible_engines.size() > 1) {
+    // Select the engine measured as the fastest on this machine.
+
+    // Re-use the winner of a previous calibration of this model object.
+    if (!calibrated_fast_engine_name_.empty()) {
+      for (auto& compatible_engine : compatible_engines) {
+        if (compatible_engine->name() == calibrated_fast_engine_name_) {
+          return compatible_engine->CreateEngine(this);
+        }
+      }
+    }
+
+    std::unique_ptr<serving::FastEngine> fastest_engine;
+    std::string fastest_engine_name;
+    absl::Duration fastest_duration = absl::InfiniteDuration();
+    for (auto& compatible_engine : compatible_engines) {
+      auto candidate_or = compatible_engine->CreateEngine(this);
+      if (!candidate_or.ok()) {
+        LOG(WARNING) << "The engine \"" << compatible_engine->name()
+                     << "\" is compatible but could not be created: "
+                     << candidate_or.status().message();
+        continue;
+      }
+      const auto duration = BenchmarkFastEngine(*candidate_or.value());
+      LOG_INFO_EVERY_N_SEC(10, _ << "Engine \"" << compatible_engine->name()
+                                 << "\" benchmarked: " << duration);
+      if (duration < fastest_duration) {
+        fastest_duration = duration;
+        fastest_engine = std::move(candidate_or.value());
+        fastest_engine_name = compatible_engine->name();
+      }
+    }
+    if (fastest_engine == nullptr) {
+      return absl::NotFoundError(no_compatible_engine_message);
+    }
+    calibrated_fast_engine_name_ = fastest_engine_name;
+    LOG_INFO_EVERY_N_SEC(
+        10, _ << "Engine \"" << fastest_engine_name
+              << "\" selected by calibration (" << fastest_duration << ")");
+    return fastest_engine;
+  }
+
   // Select the best engine.
   std::vector<std::unique_ptr<FastEngineFactory>> best_engines;
   for (auto& compatible_engine : compatible_engines) {
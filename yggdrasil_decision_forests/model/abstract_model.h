@@ -106,6 +106,30 @@ class AbstractModel {
     allow_fast_engine_ = allow_fast_engine;
   }
 
+  // If set to "True", "BuildFastEngine" selects among the compatible engines
+  // by building each candidate and timing it on a small batch of synthetic
+  // examples, instead of relying on the static "IsBetterThan" ordering
+  // declared by the engines. Useful when the declared ordering does not hold
+  // on the serving hardware (e.g. vectorized engines on machines without the
+  // corresponding instruction set, or unusual model shapes). The name of the
+  // measured winner is remembered by the model object, so the benchmark only
+  // runs on the first "BuildFastEngine" call. The cached result is not
+  // synchronized: if several threads may call "BuildFastEngine" concurrently,
+  // call it once beforehand.
+  void SetFastEngineCalibration(const bool calibrate_fast_engine) {
+    calibrate_fast_engine_ = calibrate_fast_engine;
+  }
+
+  // If set to "True", "BuildFastEngine" builds one replica of the engine per
+  // NUMA node of the host and routes each "Predict" call to the replica local
+  // to the calling thread, avoiding cross-socket memory accesses on
+  // multi-socket serving hosts (at the cost of one copy of the compiled model
+  // per node). No effect on single-node hosts or on platforms where the NUMA
+  // topology is not available. See "serving/numa_replicated_engine.h".
+  void SetFastEngineNumaReplication(const bool numa_replicate_fast_engine) {
+    numa_replicate_fast_engine_ = numa_replicate_fast_engine;
+  }
+
   // Check that the model is valid. The inference on a non-valid model is non
   // defined.
   //
@@ -241,8 +265,10 @@ class AbstractModel {
       std::vector<model::proto::Prediction>* predictions = nullptr) const;
 
   // Similar as "AppendEvaluation" above. But operate on dataset stored on disk.
-  // This method is preferable when the number of examples is large since they
-  // do not have to be all loaded in memory as the same time.
+  // This method is preferable when the number of examples is large: if the
+  // model has a fast engine, the shards are evaluated in parallel and the
+  // examples of each shard are streamed by batches, so the evaluation memory
+  // does not depend on the size of the dataset.
   absl::Status AppendEvaluation(const absl::string_view typed_path,
                                 const metric::proto::EvaluationOptions& option,
                                 utils::RandomEngine* rnd,
@@ -416,14 +442,22 @@ class AbstractModel {
  protected:
   explicit AbstractModel(const absl::string_view name) : name_(name) {}
 
+  // Evaluates the examples in [begin_example_idx, end_example_idx) with a
+  // fast engine and appends the result to "eval".
   absl::Status AppendEvaluationWithEngine(
       const dataset::VerticalDataset& dataset,
       const metric::proto::EvaluationOptions& option,
       const dataset::proto::LinkedWeightDefinition& weight_links,
-      const serving::FastEngine& engine, utils::RandomEngine* rnd,
+      const serving::FastEngine& engine, int64_t begin_example_idx,
+      int64_t end_example_idx, utils::RandomEngine* rnd,
       std::vector<model::proto::Prediction>* predictions,
       metric::proto::EvaluationResults* eval) const;
 
+  // Builds a single (non NUMA-replicated) inference engine. Implements the
+  // engine selection logic of "BuildFastEngine".
+  utils::StatusOr<std::unique_ptr<serving::FastEngine>> BuildSingleFastEngine()
+      const;
+
   // Prints informations about the hyper-parameter optimizer logs.
   void AppendHyperparameterOptimizerLogs(std::string* description) const;
 
@@ -465,6 +499,18 @@ class AbstractModel {
   // Allow for fast engine to run.
   bool allow_fast_engine_ = true;
 
+  // If true, "BuildFastEngine" selects the engine by micro-benchmark. See
+  // "SetFastEngineCalibration".
+  bool calibrate_fast_engine_ = false;
+
+  // Name of the engine selected by the calibration benchmark. Empty if the
+  // benchmark did not run yet. Only used if "calibrate_fast_engine_" is true.
+  mutable std::string calibrated_fast_engine_name_;
+
+  // If true, "BuildFastEngine" replicates the engine on each NUMA node. See
+  // "SetFastEngineNumaReplication".
+  bool numa_replicate_fast_engine_ = false;
+
   // If true, the output of a task=CLASSIFICATION model is a probability and can
   // be used accordingly (e.g. averaged, clamped to [0,1]). If false, the output
   // of the task=CLASSIFICATION model might not be a probability.
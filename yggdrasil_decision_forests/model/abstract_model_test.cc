@@ -413,6 +413,32 @@ TEST(Evaluate, FromVerticalDataset) {
   EXPECT_NEAR(metric::Accuracy(evaluation), 0.8723513, 0.000001);
 }
 
+TEST(Evaluate, FromVerticalDatasetParallel) {
+  std::unique_ptr<model::AbstractModel> model;
+  EXPECT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", "adult_binary_class_gbdt"),
+      &model));
+
+  dataset::VerticalDataset dataset;
+  EXPECT_OK(LoadVerticalDataset(
+      absl::StrCat("csv:",
+                   file::JoinPath(TestDataDir(), "dataset", "adult_test.csv")),
+      model->data_spec(), &dataset));
+
+  // Duplicate the examples to cross the parallel evaluation threshold. The
+  // accuracy is not impacted by the duplication.
+  dataset::VerticalDataset large_dataset;
+  large_dataset.set_data_spec(model->data_spec());
+  EXPECT_OK(large_dataset.CreateColumnsFromDataspec());
+  EXPECT_OK(large_dataset.Append(dataset));
+  EXPECT_OK(large_dataset.Append(dataset));
+
+  utils::RandomEngine rnd;
+  const auto evaluation = model->Evaluate(large_dataset, {}, &rnd);
+  EXPECT_EQ(evaluation.count_predictions_no_weight(), 2 * dataset.nrow());
+  EXPECT_NEAR(metric::Accuracy(evaluation), 0.8723513, 0.000001);
+}
+
 TEST(Evaluate, FromDisk) {
   std::unique_ptr<model::AbstractModel> model;
   EXPECT_OK(model::LoadModel(
@@ -427,6 +453,35 @@ TEST(Evaluate, FromDisk) {
   EXPECT_NEAR(metric::Accuracy(evaluation), 0.8723513, 0.000001);
 }
 
+TEST(Evaluate, FromDiskStreamed) {
+  std::unique_ptr<model::AbstractModel> model;
+  EXPECT_OK(model::LoadModel(
+      file::JoinPath(TestDataDir(), "model", "adult_binary_class_gbdt"),
+      &model));
+
+  dataset::VerticalDataset dataset;
+  EXPECT_OK(LoadVerticalDataset(
+      absl::StrCat("csv:",
+                   file::JoinPath(TestDataDir(), "dataset", "adult_test.csv")),
+      model->data_spec(), &dataset));
+
+  // Duplicate the examples so that the on-disk evaluation streams the shard
+  // in multiple batches. The accuracy is not impacted by the duplication.
+  dataset::VerticalDataset large_dataset;
+  large_dataset.set_data_spec(model->data_spec());
+  EXPECT_OK(large_dataset.CreateColumnsFromDataspec());
+  EXPECT_OK(large_dataset.Append(dataset));
+  EXPECT_OK(large_dataset.Append(dataset));
+  const auto large_dataset_path = absl::StrCat(
+      "csv:", file::JoinPath(test::TmpDirectory(), "large_adult_test.csv"));
+  EXPECT_OK(SaveVerticalDataset(large_dataset, large_dataset_path));
+
+  utils::RandomEngine rnd;
+  const auto evaluation = model->Evaluate(large_dataset_path, {}, &rnd);
+  EXPECT_EQ(evaluation.count_predictions_no_weight(), 2 * dataset.nrow());
+  EXPECT_NEAR(metric::Accuracy(evaluation), 0.8723513, 0.000001);
+}
+
 TEST(Model, AbstractAttributesSizeInBytes) {
   FakeModelWithEngine model;
   // The model size is compiler+arch dependent.
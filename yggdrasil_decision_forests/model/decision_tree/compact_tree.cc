@@ -0,0 +1,191 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/model/decision_tree/compact_tree.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+
+namespace yggdrasil_decision_forests {
+namespace model {
+namespace decision_tree {
+
+CompactTree CompactTree::FromTree(const DecisionTree& tree) {
+  CompactTree compact;
+  const int64_t num_nodes = tree.NumNodes();
+  compact.positive_child_.reserve(num_nodes);
+  compact.attribute_.reserve(num_nodes);
+  compact.condition_type_.reserve(num_nodes);
+  compact.output_case_.reserve(num_nodes);
+  compact.na_value_.reserve(num_nodes);
+  compact.value_.reserve(num_nodes);
+  compact.split_score_.reserve(num_nodes);
+  compact.num_pos_examples_.reserve(num_nodes);
+  compact.AddNode(tree.root());
+  return compact;
+}
+
+void CompactTree::AddNode(const NodeWithChildren& node) {
+  const int node_idx = positive_child_.size();
+  const auto& node_proto = node.node();
+
+  positive_child_.push_back(0);
+  attribute_.push_back(-1);
+  condition_type_.push_back(proto::Condition::TYPE_NOT_SET);
+  output_case_.push_back(proto::Node::OUTPUT_NOT_SET);
+  na_value_.push_back(false);
+  value_.push_back(0.f);
+  split_score_.push_back(0.f);
+  num_pos_examples_.push_back(
+      node_proto.num_pos_training_examples_without_weight());
+
+  if (node.IsLeaf()) {
+    output_case_[node_idx] = node_proto.output_case();
+    switch (node_proto.output_case()) {
+      case proto::Node::kClassifier:
+        value_[node_idx] = node_proto.classifier().top_value();
+        break;
+      case proto::Node::kRegressor:
+        value_[node_idx] = node_proto.regressor().top_value();
+        break;
+      default:
+        detailed_leaves_[node_idx] = node_proto;
+        break;
+    }
+    return;
+  }
+
+  const auto& condition = node_proto.condition();
+  attribute_[node_idx] = condition.attribute();
+  condition_type_[node_idx] = condition.condition().type_case();
+  na_value_[node_idx] = condition.na_value();
+  split_score_[node_idx] = condition.split_score();
+  if (condition.condition().type_case() == proto::Condition::kHigherCondition) {
+    value_[node_idx] = condition.condition().higher_condition().threshold();
+  } else {
+    detailed_conditions_[node_idx] = condition;
+  }
+
+  // The negative child directly follows its parent in the arrays.
+  AddNode(*node.neg_child());
+  positive_child_[node_idx] = positive_child_.size();
+  AddNode(*node.pos_child());
+}
+
+std::unique_ptr<DecisionTree> CompactTree::ToTree() const {
+  auto tree = absl::make_unique<DecisionTree>();
+  if (num_nodes() == 0) {
+    return tree;
+  }
+  tree->CreateRoot();
+  SetNode(/*node_idx=*/0, tree->mutable_root());
+  tree->SetLeafIndices();
+  return tree;
+}
+
+void CompactTree::SetNode(const int node_idx, NodeWithChildren* node) const {
+  auto* node_proto = node->mutable_node();
+
+  if (IsLeaf(node_idx)) {
+    const auto* detailed = detailed_leaf(node_idx);
+    if (detailed != nullptr) {
+      *node_proto = *detailed;
+      return;
+    }
+    switch (output_case(node_idx)) {
+      case proto::Node::kClassifier:
+        node_proto->mutable_classifier()->set_top_value(
+            static_cast<int32_t>(value_[node_idx]));
+        break;
+      case proto::Node::kRegressor:
+        node_proto->mutable_regressor()->set_top_value(value_[node_idx]);
+        break;
+      default:
+        break;
+    }
+    node_proto->set_num_pos_training_examples_without_weight(
+        num_pos_examples_[node_idx]);
+    return;
+  }
+
+  auto* condition = node_proto->mutable_condition();
+  const auto* detailed = detailed_condition(node_idx);
+  if (detailed != nullptr) {
+    *condition = *detailed;
+  } else {
+    condition->set_attribute(attribute_[node_idx]);
+    condition->set_na_value(na_value_[node_idx]);
+    condition->set_split_score(split_score_[node_idx]);
+    condition->mutable_condition()->mutable_higher_condition()->set_threshold(
+        value_[node_idx]);
+  }
+  node_proto->set_num_pos_training_examples_without_weight(
+      num_pos_examples_[node_idx]);
+
+  node->CreateChildren();
+  SetNode(negative_child(node_idx), node->mutable_neg_child());
+  SetNode(positive_child(node_idx), node->mutable_pos_child());
+}
+
+void CompactTree::IterateOnNodes(
+    const std::function<void(int node_idx, int depth)>& callback) const {
+  if (num_nodes() == 0) {
+    return;
+  }
+  // Pairs of node index and depth of the nodes left to visit.
+  std::vector<std::pair<int, int>> stack;
+  stack.emplace_back(0, 0);
+  while (!stack.empty()) {
+    const auto item = stack.back();
+    stack.pop_back();
+    callback(item.first, item.second);
+    if (!IsLeaf(item.first)) {
+      stack.emplace_back(positive_child(item.first), item.second + 1);
+      stack.emplace_back(negative_child(item.first), item.second + 1);
+    }
+  }
+}
+
+size_t CompactTree::EstimateSizeInByte() const {
+  size_t size = sizeof(CompactTree) +
+                positive_child_.capacity() * sizeof(int32_t) +
+                attribute_.capacity() * sizeof(int32_t) +
+                condition_type_.capacity() * sizeof(uint8_t) +
+                output_case_.capacity() * sizeof(uint8_t) +
+                na_value_.capacity() / 8 +
+                value_.capacity() * sizeof(float) +
+                split_score_.capacity() * sizeof(float) +
+                num_pos_examples_.capacity() * sizeof(int64_t);
+  for (const auto& condition : detailed_conditions_) {
+    size += sizeof(condition) + condition.second.SpaceUsedLong();
+  }
+  for (const auto& leaf : detailed_leaves_) {
+    size += sizeof(leaf) + leaf.second.SpaceUsedLong();
+  }
+  return size;
+}
+
+}  // namespace decision_tree
+}  // namespace model
+}  // namespace yggdrasil_decision_forests
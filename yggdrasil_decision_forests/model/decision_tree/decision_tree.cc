@@ -199,6 +199,25 @@ void AddMininumDepthPerPath(const NodeWithChildren& node, const int depth,
 
 }  // namespace
 
+namespace internal {
+
+void NodeDeleter::operator()(NodeWithChildren* node) const {
+  // Nodes allocated by a "NodeArena" are released with the arena.
+  if (owned) {
+    delete node;
+  }
+}
+
+// Allocates a node from the arena (if any) or from the heap.
+NodeUniquePtr MakeNode(NodeArena* arena) {
+  if (arena != nullptr) {
+    return NodeUniquePtr(arena->AllocateNode(), NodeDeleter{/*owned=*/false});
+  }
+  return NodeUniquePtr(new NodeWithChildren());
+}
+
+}  // namespace internal
+
 std::vector<int32_t> ExactElementsFromContainsCondition(
     int vocab_size, const proto::Condition& condition) {
   switch (condition.type_case()) {
@@ -425,9 +444,9 @@ absl::Status DecisionTree::Validate(
   return absl::OkStatus();
 }
 
-void DecisionTree::CreateRoot() {
+void DecisionTree::CreateRoot(NodeArena* arena) {
   DCHECK(!root_);
-  root_ = absl::make_unique<NodeWithChildren>();
+  root_ = internal::MakeNode(arena);
 }
 
 absl::Status DecisionTree::WriteNodes(
@@ -441,8 +460,9 @@ absl::Status DecisionTree::WriteNodes(
 
 absl::Status DecisionTree::ReadNodes(
     utils::ProtoReaderInterface<proto::Node>* reader) {
-  CreateRoot();
-  return root_->ReadNodes(reader);
+  owned_arena_ = absl::make_unique<NodeArena>();
+  CreateRoot(owned_arena_.get());
+  return root_->ReadNodes(reader, owned_arena_.get());
 }
 
 absl::Status NodeWithChildren::WriteNodes(
@@ -456,22 +476,22 @@ absl::Status NodeWithChildren::WriteNodes(
 }
 
 absl::Status NodeWithChildren::ReadNodes(
-    utils::ProtoReaderInterface<proto::Node>* reader) {
+    utils::ProtoReaderInterface<proto::Node>* reader, NodeArena* arena) {
   ASSIGN_OR_RETURN(bool did_read, reader->Next(&node_));
   if (!did_read) {
     return absl::InvalidArgumentError("Unexpected EOF");
   }
   if (node_.has_condition()) {
-    CreateChildren();
-    RETURN_IF_ERROR(children_[0]->ReadNodes(reader));
-    RETURN_IF_ERROR(children_[1]->ReadNodes(reader));
+    CreateChildren(arena);
+    RETURN_IF_ERROR(children_[0]->ReadNodes(reader, arena));
+    RETURN_IF_ERROR(children_[1]->ReadNodes(reader, arena));
   }
   return absl::OkStatus();
 }
 
-void NodeWithChildren::CreateChildren() {
-  children_[0] = absl::make_unique<NodeWithChildren>();
-  children_[1] = absl::make_unique<NodeWithChildren>();
+void NodeWithChildren::CreateChildren(NodeArena* arena) {
+  children_[0] = internal::MakeNode(arena);
+  children_[1] = internal::MakeNode(arena);
 }
 
 void NodeWithChildren::ClearLabelDistributionDetails() {
@@ -521,6 +541,14 @@ void NodeWithChildren::TurnIntoLeaf() {
   children_[1].reset();
 }
 
+void NodeWithChildren::ReplaceByNegativeChild() {
+  DCHECK(!IsLeaf());
+  NodeUniquePtr child = std::move(children_[0]);
+  node_ = std::move(*child->mutable_node());
+  children_[0] = std::move(child->children_[0]);
+  children_[1] = std::move(child->children_[1]);
+}
+
 bool EvalConditionFromColumn(
     const proto::NodeCondition& condition,
     const dataset::VerticalDataset::AbstractColumn* column_data,
@@ -17,8 +17,10 @@
 
 #include <stddef.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -29,7 +31,9 @@
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree_io_interface.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/protobuf.h"
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
@@ -45,14 +49,31 @@ absl::Status SaveTreesToDisk(
     absl::string_view directory, absl::string_view basename,
     const std::vector<std::unique_ptr<DecisionTree>>& trees,
     absl::string_view format, int* num_shards) {
+  std::vector<const DecisionTree*> tree_ptrs;
+  tree_ptrs.reserve(trees.size());
+  for (const auto& tree : trees) {
+    tree_ptrs.push_back(tree.get());
+  }
+  return SaveTreesToDisk(directory, basename, tree_ptrs, format, num_shards);
+}
+
+absl::Status SaveTreesToDisk(absl::string_view directory,
+                             absl::string_view basename,
+                             const std::vector<const DecisionTree*>& trees,
+                             absl::string_view format, int* num_shards) {
   ASSIGN_OR_RETURN(const auto format_impl, GetFormatImplementation(format));
 
+  size_t size_in_bytes = 0;
+  int64_t num_nodes = 0;
+  for (const auto* tree : trees) {
+    size_in_bytes += tree->EstimateSizeInByte();
+    num_nodes += tree->NumNodes();
+  }
+
   // FutureWork(gbm): The current function is fully sequential. If speed
   // becomes an issue, make it so that the shards are written in parallel.
-  *num_shards =
-      std::max<int>(1, (EstimateSizeInByte(trees) + kMaxShardSizeInByte - 1) /
-                           kMaxShardSizeInByte);
-  const int64_t num_nodes = NumberOfNodes(trees);
+  *num_shards = std::max<int>(
+      1, (size_in_bytes + kMaxShardSizeInByte - 1) / kMaxShardSizeInByte);
   const int num_nodes_per_shard =
       std::max<int>(1, (num_nodes + *num_shards - 1) / *num_shards);
   auto node_writer = format_impl->CreateWriter();
@@ -67,17 +88,110 @@ absl::Status SaveTreesToDisk(
   return absl::OkStatus();
 }
 
+namespace {
+
+// Reader over the nodes of a set of shards already parsed in memory. The
+// consumed shards are released as the reading progresses.
+class ParsedNodeReader : public utils::ProtoReaderInterface<proto::Node> {
+ public:
+  explicit ParsedNodeReader(std::vector<std::vector<proto::Node>>* nodes)
+      : nodes_(nodes) {}
+
+  utils::StatusOr<bool> Next(proto::Node* value) override {
+    while (shard_idx_ < nodes_->size() &&
+           node_idx_ >= (*nodes_)[shard_idx_].size()) {
+      // Release the consumed shard.
+      std::vector<proto::Node>().swap((*nodes_)[shard_idx_]);
+      shard_idx_++;
+      node_idx_ = 0;
+    }
+    if (shard_idx_ == nodes_->size()) {
+      return false;
+    }
+    *value = std::move((*nodes_)[shard_idx_][node_idx_]);
+    node_idx_++;
+    return true;
+  }
+
+ private:
+  std::vector<std::vector<proto::Node>>* nodes_;
+  size_t shard_idx_ = 0;
+  size_t node_idx_ = 0;
+};
+
+}  // namespace
+
 absl::Status LoadTreesFromDisk(
     absl::string_view directory, absl::string_view basename, int num_shards,
     int num_trees, absl::string_view format,
     std::vector<std::unique_ptr<DecisionTree>>* trees) {
   ASSIGN_OR_RETURN(const auto format_impl, GetFormatImplementation(format));
-  auto node_reader = format_impl->CreateReader();
-  RETURN_IF_ERROR(node_reader->Open(file::GenerateShardedFileSpec(
-      file::JoinPath(directory, basename), num_shards)));
+  const auto sharded_path =
+      file::GenerateShardedFileSpec(file::JoinPath(directory, basename),
+                                    num_shards);
+
+  std::vector<std::string> shard_paths;
+  RETURN_IF_ERROR(utils::ExpandInputShards(sharded_path, &shard_paths));
+  const int num_reading_threads = std::min<int>(
+      shard_paths.size(),
+      std::max<unsigned int>(1, std::thread::hardware_concurrency()));
+
+  if (num_reading_threads <= 1) {
+    // Sequential reading.
+    auto node_reader = format_impl->CreateReader();
+    RETURN_IF_ERROR(node_reader->Open(sharded_path));
+    for (int64_t tree_idx = 0; tree_idx < num_trees; tree_idx++) {
+      auto decision_tree = absl::make_unique<decision_tree::DecisionTree>();
+      RETURN_IF_ERROR(decision_tree->ReadNodes(node_reader.get()));
+      decision_tree->SetLeafIndices();
+      trees->push_back(std::move(decision_tree));
+    }
+    return absl::OkStatus();
+  }
+
+  // Read and parse the nodes with one worker per shard. The trees cannot be
+  // assembled independently per shard as a tree can span two shards.
+  std::vector<std::vector<proto::Node>> nodes_per_shard(shard_paths.size());
+  std::vector<absl::Status> shard_statuses(shard_paths.size());
+  {
+    utils::concurrency::ThreadPool pool("LoadTreesFromDisk",
+                                        num_reading_threads);
+    pool.StartWorkers();
+    for (size_t shard_idx = 0; shard_idx < shard_paths.size(); shard_idx++) {
+      pool.Schedule([&format_impl, &shard_paths, &nodes_per_shard,
+                     &shard_statuses, shard_idx]() {
+        auto& nodes = nodes_per_shard[shard_idx];
+        auto& status = shard_statuses[shard_idx];
+        auto node_reader = format_impl->CreateReader();
+        status = node_reader->Open(
+            std::vector<std::string>{shard_paths[shard_idx]});
+        if (!status.ok()) {
+          return;
+        }
+        proto::Node node;
+        while (true) {
+          const auto has_node = node_reader->Next(&node);
+          if (!has_node.ok()) {
+            status = has_node.status();
+            return;
+          }
+          if (!has_node.value()) {
+            break;
+          }
+          nodes.push_back(std::move(node));
+        }
+      });
+    }
+  }
+  for (const auto& shard_status : shard_statuses) {
+    RETURN_IF_ERROR(shard_status);
+  }
+
+  // Assemble the trees, in order, from the parsed nodes.
+  ParsedNodeReader node_reader(&nodes_per_shard);
   for (int64_t tree_idx = 0; tree_idx < num_trees; tree_idx++) {
     auto decision_tree = absl::make_unique<decision_tree::DecisionTree>();
-    RETURN_IF_ERROR(decision_tree->ReadNodes(node_reader.get()));
+    RETURN_IF_ERROR(decision_tree->ReadNodes(&node_reader));
     decision_tree->SetLeafIndices();
     trees->push_back(std::move(decision_tree));
   }
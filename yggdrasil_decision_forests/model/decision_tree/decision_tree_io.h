@@ -45,6 +45,14 @@ absl::Status SaveTreesToDisk(
     const std::vector<std::unique_ptr<DecisionTree>>& trees,
     absl::string_view format, int* num_shards);
 
+// Variant of "SaveTreesToDisk" on borrowed trees. Used to serialize a stable
+// view of a forest from a background thread while the training appends new
+// trees.
+absl::Status SaveTreesToDisk(absl::string_view directory,
+                             absl::string_view basename,
+                             const std::vector<const DecisionTree*>& trees,
+                             absl::string_view format, int* num_shards);
+
 absl::Status LoadTreesFromDisk(
     absl::string_view directory, absl::string_view basename, int num_shards,
     int num_trees, absl::string_view format,
@@ -41,6 +41,28 @@ class BlobSequenceFormat : public AbstractFormat {
 };
 REGISTER_AbstractFormat(BlobSequenceFormat, "BLOB_SEQUENCE");
 
+// Same container as "BLOB_SEQUENCE", with the blocks of node protos
+// compressed (deflate). Reading is transparent: the reader of the plain
+// format decompresses the blocks automatically.
+class BlobSequenceGZipFormat : public AbstractFormat {
+ public:
+  ~BlobSequenceGZipFormat() override = default;
+
+  std::unique_ptr<utils::ShardedReader<proto::Node>> CreateReader()
+      const override {
+    return absl::make_unique<utils::BlobSequenceShardedReader<proto::Node>>();
+  };
+
+  std::unique_ptr<utils::ShardedWriter<proto::Node>> CreateWriter()
+      const override {
+    utils::blob_sequence::WriterOptions options;
+    options.compression = true;
+    return absl::make_unique<utils::BlobSequenceShardedWriter<proto::Node>>(
+        options);
+  };
+};
+REGISTER_AbstractFormat(BlobSequenceGZipFormat, "BLOB_SEQUENCE_GZIP");
+
 }  // namespace decision_tree
 }  // namespace model
 }  // namespace yggdrasil_decision_forests
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -27,7 +28,9 @@
 #include "yggdrasil_decision_forests/dataset/example.pb.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
+#include "yggdrasil_decision_forests/model/decision_tree/compact_tree.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/model/decision_tree/pruning.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/test.h"
@@ -112,6 +115,117 @@ TEST(DecisionTree, GetLeafAndGetPath) {
            &tree.root().pos_child()->node());
 }
 
+TEST(DecisionTree, CompactTreeRoundTrip) {
+  // Build the tree:
+  //   "a">=1
+  //     ├─(neg)─ leaf r=5
+  //     └─(pos)─ "b" in {1,2}
+  //                ├─(neg)─ leaf r=6
+  //                └─(pos)─ leaf r=7
+  DecisionTree tree;
+  tree.CreateRoot();
+  auto* root = tree.mutable_root();
+  root->CreateChildren();
+  root->mutable_node()->mutable_condition()->set_attribute(0);
+  root->mutable_node()->mutable_condition()->set_split_score(0.5f);
+  root->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(1);
+  root->mutable_neg_child()->mutable_node()->mutable_regressor()->set_top_value(
+      5);
+  root->mutable_neg_child()
+      ->mutable_node()
+      ->set_num_pos_training_examples_without_weight(10);
+  auto* pos = root->mutable_pos_child();
+  pos->CreateChildren();
+  pos->mutable_node()->mutable_condition()->set_attribute(1);
+  auto* contains = pos->mutable_node()
+                       ->mutable_condition()
+                       ->mutable_condition()
+                       ->mutable_contains_condition();
+  contains->add_elements(1);
+  contains->add_elements(2);
+  pos->mutable_neg_child()->mutable_node()->mutable_regressor()->set_top_value(
+      6);
+  pos->mutable_pos_child()->mutable_node()->mutable_regressor()->set_top_value(
+      7);
+  tree.SetLeafIndices();
+
+  const auto compact = CompactTree::FromTree(tree);
+  EXPECT_EQ(compact.num_nodes(), 5);
+  EXPECT_GT(compact.EstimateSizeInByte(), 0);
+
+  // Root: inlined "higher" condition.
+  EXPECT_FALSE(compact.IsLeaf(0));
+  EXPECT_EQ(compact.attribute(0), 0);
+  EXPECT_EQ(compact.condition_type(0), proto::Condition::kHigherCondition);
+  EXPECT_EQ(compact.threshold(0), 1.f);
+  EXPECT_EQ(compact.split_score(0), 0.5f);
+  EXPECT_EQ(compact.detailed_condition(0), nullptr);
+
+  // Negative child of the root: regressor leaf.
+  const int neg_idx = compact.negative_child(0);
+  EXPECT_TRUE(compact.IsLeaf(neg_idx));
+  EXPECT_EQ(compact.output_case(neg_idx), proto::Node::kRegressor);
+  EXPECT_EQ(compact.leaf_value(neg_idx), 5.f);
+  EXPECT_EQ(compact.num_pos_training_examples_without_weight(neg_idx), 10);
+  EXPECT_EQ(compact.detailed_leaf(neg_idx), nullptr);
+
+  // Positive child of the root: condition kept in the detailed side table.
+  const int pos_idx = compact.positive_child(0);
+  EXPECT_FALSE(compact.IsLeaf(pos_idx));
+  EXPECT_EQ(compact.attribute(pos_idx), 1);
+  EXPECT_EQ(compact.condition_type(pos_idx),
+            proto::Condition::kContainsCondition);
+  ASSERT_NE(compact.detailed_condition(pos_idx), nullptr);
+  EXPECT_EQ(
+      compact.detailed_condition(pos_idx)->condition().contains_condition()
+          .elements_size(),
+      2);
+  EXPECT_EQ(
+      compact.leaf_value(compact.negative_child(pos_idx)), 6.f);
+  EXPECT_EQ(
+      compact.leaf_value(compact.positive_child(pos_idx)), 7.f);
+
+  // All the nodes are visited once with the right depth.
+  int num_visited_nodes = 0;
+  int num_visited_leaves = 0;
+  compact.IterateOnNodes([&](const int node_idx, const int depth) {
+    num_visited_nodes++;
+    if (compact.IsLeaf(node_idx)) {
+      num_visited_leaves++;
+      EXPECT_EQ(depth, node_idx == neg_idx ? 1 : 2);
+    }
+  });
+  EXPECT_EQ(num_visited_nodes, 5);
+  EXPECT_EQ(num_visited_leaves, 3);
+
+  // Round trip back to a proto-based tree.
+  const auto restored = compact.ToTree();
+  EXPECT_EQ(restored->NumNodes(), 5);
+  EXPECT_EQ(restored->root()
+                .node()
+                .condition()
+                .condition()
+                .higher_condition()
+                .threshold(),
+            1.f);
+  EXPECT_EQ(restored->root().neg_child()->node().regressor().top_value(), 5.f);
+  EXPECT_EQ(restored->root()
+                .pos_child()
+                ->node()
+                .condition()
+                .condition()
+                .contains_condition()
+                .elements_size(),
+            2);
+  EXPECT_EQ(
+      restored->root().pos_child()->pos_child()->node().regressor().top_value(),
+      7.f);
+}
+
 class EvalConditions : public ::testing::Test {
  protected:
   void SetUp() override {
@@ -449,6 +563,21 @@ TEST(DecisionTree, CountFeatureUsage) {
   EXPECT_EQ(feature_usage[2], 1);
 }
 
+TEST(DecisionTree, NodeArena) {
+  NodeArena arena;
+  DecisionTree tree;
+  tree.CreateRoot(&arena);
+  tree.mutable_root()->CreateChildren(&arena);
+  tree.mutable_root()->mutable_pos_child()->CreateChildren(&arena);
+  EXPECT_EQ(tree.NumNodes(), 5);
+  EXPECT_EQ(arena.num_allocated_nodes(), 5);
+
+  // Discarded nodes are only reclaimed with the arena.
+  tree.mutable_root()->mutable_pos_child()->TurnIntoLeaf();
+  EXPECT_EQ(tree.NumNodes(), 3);
+  EXPECT_EQ(arena.num_allocated_nodes(), 5);
+}
+
 TEST(DecisionTree, DoSortedRangesIntersect) {
   std::vector<int> a;
   std::vector<int> b;
@@ -487,6 +616,125 @@ TEST(DecisionTree, DoSortedRangesIntersect) {
   EXPECT_FALSE(intersect());
 }
 
+// Builds the sub-tree:
+//   "attribute">=threshold
+//     ├─(neg)─ leaf r=neg_value
+//     └─(pos)─ leaf r=pos_value
+void BuildRegressionSplit(NodeWithChildren* node, const int attribute,
+                          const float threshold, const float neg_value,
+                          const float pos_value) {
+  node->CreateChildren();
+  node->mutable_node()->mutable_condition()->set_attribute(attribute);
+  node->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(threshold);
+  node->mutable_neg_child()->mutable_node()->mutable_regressor()->set_top_value(
+      neg_value);
+  node->mutable_pos_child()->mutable_node()->mutable_regressor()->set_top_value(
+      pos_value);
+}
+
+TEST(Pruning, MergeIdenticalSubtrees) {
+  // The two branches of the root are identical.
+  DecisionTree tree;
+  tree.CreateRoot();
+  auto* root = tree.mutable_root();
+  root->CreateChildren();
+  root->mutable_node()->mutable_condition()->set_attribute(0);
+  root->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(1);
+  BuildRegressionSplit(root->mutable_neg_child(), 1, 2.f, 5.f, 6.f);
+  BuildRegressionSplit(root->mutable_pos_child(), 1, 2.f, 5.f, 6.f);
+  EXPECT_EQ(tree.NumNodes(), 7);
+
+  EXPECT_EQ(MergeIdenticalSubtrees(&tree), 4);
+  EXPECT_EQ(tree.NumNodes(), 3);
+  EXPECT_EQ(tree.mutable_root()->node().condition().attribute(), 1);
+  EXPECT_EQ(tree.mutable_root()->neg_child()->node().regressor().top_value(),
+            5.f);
+
+  // The remaining branches differ.
+  EXPECT_EQ(MergeIdenticalSubtrees(&tree), 0);
+  EXPECT_EQ(tree.NumNodes(), 3);
+}
+
+TEST(Pruning, CollapseNearEqualRegressionLeaves) {
+  DecisionTree tree;
+  tree.CreateRoot();
+  BuildRegressionSplit(tree.mutable_root(), 0, 1.f, 1.f, 1.05f);
+  tree.mutable_root()
+      ->mutable_neg_child()
+      ->mutable_node()
+      ->mutable_regressor()
+      ->mutable_distribution()
+      ->set_count(1);
+  tree.mutable_root()
+      ->mutable_pos_child()
+      ->mutable_node()
+      ->mutable_regressor()
+      ->mutable_distribution()
+      ->set_count(3);
+
+  // The leaf values differ by more than the margin.
+  EXPECT_EQ(CollapseNearEqualRegressionLeaves(&tree, 0.01f).value(), 0);
+  EXPECT_EQ(tree.NumNodes(), 3);
+
+  // The leaves are merged into their weighted mean.
+  EXPECT_EQ(CollapseNearEqualRegressionLeaves(&tree, 0.1f).value(), 2);
+  EXPECT_EQ(tree.NumNodes(), 1);
+  EXPECT_TRUE(tree.root().IsLeaf());
+  EXPECT_NEAR(tree.root().node().regressor().top_value(),
+              (1.f * 1 + 1.05f * 3) / 4, 0.0001f);
+}
+
+TEST(Pruning, CollapseNearEqualRegressionLeavesNonRegression) {
+  DecisionTree tree;
+  tree.CreateRoot();
+  tree.mutable_root()->mutable_node()->mutable_classifier()->set_top_value(1);
+  EXPECT_FALSE(CollapseNearEqualRegressionLeaves(&tree, 0.1f).ok());
+}
+
+TEST(Pruning, RemoveSmallOutputTreeGroups) {
+  const auto build_stump = [](const float value) {
+    auto tree = absl::make_unique<DecisionTree>();
+    tree->CreateRoot();
+    tree->mutable_root()->mutable_node()->mutable_regressor()->set_top_value(
+        value);
+    return tree;
+  };
+
+  DecisionForest trees;
+  trees.push_back(build_stump(0.5f));
+  trees.push_back(build_stump(0.01f));
+  trees.push_back(build_stump(-0.2f));
+
+  EXPECT_EQ(
+      RemoveSmallOutputTreeGroups(&trees, /*group_size=*/1, /*min_abs_output=*/0.1f)
+          .value(),
+      1);
+  ASSERT_EQ(trees.size(), 2);
+  EXPECT_EQ(trees[0]->root().node().regressor().top_value(), 0.5f);
+  EXPECT_EQ(trees[1]->root().node().regressor().top_value(), -0.2f);
+
+  // The tree with the largest output is always kept.
+  EXPECT_EQ(RemoveSmallOutputTreeGroups(&trees, /*group_size=*/1,
+                                        /*min_abs_output=*/10.f)
+                .value(),
+            1);
+  ASSERT_EQ(trees.size(), 1);
+  EXPECT_EQ(trees[0]->root().node().regressor().top_value(), 0.5f);
+
+  // Number of trees not a multiple of the group size.
+  EXPECT_FALSE(RemoveSmallOutputTreeGroups(&trees, /*group_size=*/2,
+                                           /*min_abs_output=*/0.1f)
+                   .ok());
+}
+
 }  // namespace
 }  // namespace decision_tree
 }  // namespace model
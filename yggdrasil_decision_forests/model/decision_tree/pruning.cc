@@ -0,0 +1,245 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/model/decision_tree/pruning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace model {
+namespace decision_tree {
+namespace {
+
+// Tests if two leaves have the same prediction.
+bool SameLeafPrediction(const proto::Node& a, const proto::Node& b) {
+  if (a.output_case() != b.output_case()) {
+    return false;
+  }
+  switch (a.output_case()) {
+    case proto::Node::OutputCase::kRegressor:
+      // Only the top value is used for the prediction.
+      return a.regressor().top_value() == b.regressor().top_value();
+    case proto::Node::OutputCase::kClassifier:
+      // The full distribution can be used for the prediction (e.g.
+      // winner_take_all_inference=false).
+      return a.classifier().SerializeAsString() ==
+             b.classifier().SerializeAsString();
+    case proto::Node::OutputCase::kUplift:
+      return a.uplift().SerializeAsString() == b.uplift().SerializeAsString();
+    default:
+      return false;
+  }
+}
+
+// Tests if two conditions route the examples identically.
+bool SameCondition(const proto::NodeCondition& a,
+                   const proto::NodeCondition& b) {
+  return a.attribute() == b.attribute() && a.na_value() == b.na_value() &&
+         a.condition().SerializeAsString() == b.condition().SerializeAsString();
+}
+
+// Tests if two sub-trees have the same structure, conditions and leaf
+// predictions.
+bool SameSubtree(const NodeWithChildren& a, const NodeWithChildren& b) {
+  if (a.IsLeaf() != b.IsLeaf()) {
+    return false;
+  }
+  if (a.IsLeaf()) {
+    return SameLeafPrediction(a.node(), b.node());
+  }
+  return SameCondition(a.node().condition(), b.node().condition()) &&
+         SameSubtree(*a.neg_child(), *b.neg_child()) &&
+         SameSubtree(*a.pos_child(), *b.pos_child());
+}
+
+int64_t MergeIdenticalSubtreesInNode(NodeWithChildren* node) {
+  if (node->IsLeaf()) {
+    return 0;
+  }
+  int64_t num_removed_nodes =
+      MergeIdenticalSubtreesInNode(node->mutable_neg_child()) +
+      MergeIdenticalSubtreesInNode(node->mutable_pos_child());
+  if (SameSubtree(*node->neg_child(), *node->pos_child())) {
+    // The condition node and the positive branch are removed.
+    num_removed_nodes += 1 + node->pos_child()->NumNodes();
+    node->ReplaceByNegativeChild();
+  }
+  return num_removed_nodes;
+}
+
+// Range and weighted mean of the regression leaf values of a sub-tree, before
+// any collapse.
+struct LeafValueStats {
+  float min_value;
+  float max_value;
+  double sum_weighted_values;
+  double sum_weights;
+};
+
+// Collapses the sub-trees of "node" whose original leaf values span at most
+// "margin", and returns the leaf value statistics of "node".
+utils::StatusOr<LeafValueStats> CollapseNearEqualRegressionLeavesInNode(
+    NodeWithChildren* node, const float margin, int64_t* num_removed_nodes) {
+  if (node->IsLeaf()) {
+    if (node->node().output_case() != proto::Node::OutputCase::kRegressor) {
+      return absl::InvalidArgumentError(
+          "Leaf collapsing requires regression leaves e.g. a GBT or a "
+          "regression model.");
+    }
+    const float value = node->node().regressor().top_value();
+    double weight = node->node().regressor().distribution().count();
+    if (weight <= 0) {
+      // The leaf does not record its number of training examples.
+      weight = 1.;
+    }
+    return LeafValueStats{value, value, value * weight, weight};
+  }
+  ASSIGN_OR_RETURN(const auto neg_stats,
+                   CollapseNearEqualRegressionLeavesInNode(
+                       node->mutable_neg_child(), margin, num_removed_nodes));
+  ASSIGN_OR_RETURN(const auto pos_stats,
+                   CollapseNearEqualRegressionLeavesInNode(
+                       node->mutable_pos_child(), margin, num_removed_nodes));
+  const LeafValueStats stats{
+      std::min(neg_stats.min_value, pos_stats.min_value),
+      std::max(neg_stats.max_value, pos_stats.max_value),
+      neg_stats.sum_weighted_values + pos_stats.sum_weighted_values,
+      neg_stats.sum_weights + pos_stats.sum_weights};
+  if (stats.max_value - stats.min_value <= margin) {
+    *num_removed_nodes += node->NumNodes() - 1;
+    node->TurnIntoLeaf();
+    auto* regressor = node->mutable_node()->mutable_regressor();
+    regressor->Clear();
+    regressor->set_top_value(stats.sum_weighted_values / stats.sum_weights);
+    regressor->mutable_distribution()->set_sum(stats.sum_weighted_values);
+    regressor->mutable_distribution()->set_count(stats.sum_weights);
+  }
+  return stats;
+}
+
+// Maximum absolute regression leaf value of a tree.
+utils::StatusOr<float> MaxAbsLeafValue(const DecisionTree& tree) {
+  float max_abs_value = 0;
+  bool invalid_leaf = false;
+  tree.IterateOnNodes(
+      [&max_abs_value, &invalid_leaf](const NodeWithChildren& node, int depth) {
+        if (!node.IsLeaf()) {
+          return;
+        }
+        if (node.node().output_case() != proto::Node::OutputCase::kRegressor) {
+          invalid_leaf = true;
+          return;
+        }
+        max_abs_value = std::max(max_abs_value,
+                                 std::abs(node.node().regressor().top_value()));
+      });
+  if (invalid_leaf) {
+    return absl::InvalidArgumentError(
+        "Tree pruning by output requires regression leaves e.g. a GBT "
+        "model.");
+  }
+  return max_abs_value;
+}
+
+}  // namespace
+
+int64_t MergeIdenticalSubtrees(DecisionTree* tree) {
+  return MergeIdenticalSubtreesInNode(tree->mutable_root());
+}
+
+int64_t MergeIdenticalSubtrees(DecisionForest* trees) {
+  int64_t num_removed_nodes = 0;
+  for (auto& tree : *trees) {
+    num_removed_nodes += MergeIdenticalSubtrees(tree.get());
+  }
+  return num_removed_nodes;
+}
+
+utils::StatusOr<int64_t> CollapseNearEqualRegressionLeaves(DecisionTree* tree,
+                                                           const float margin) {
+  int64_t num_removed_nodes = 0;
+  RETURN_IF_ERROR(CollapseNearEqualRegressionLeavesInNode(
+                      tree->mutable_root(), margin, &num_removed_nodes)
+                      .status());
+  return num_removed_nodes;
+}
+
+utils::StatusOr<int64_t> CollapseNearEqualRegressionLeaves(
+    DecisionForest* trees, const float margin) {
+  int64_t num_removed_nodes = 0;
+  for (auto& tree : *trees) {
+    ASSIGN_OR_RETURN(const int64_t num_removed_nodes_in_tree,
+                     CollapseNearEqualRegressionLeaves(tree.get(), margin));
+    num_removed_nodes += num_removed_nodes_in_tree;
+  }
+  return num_removed_nodes;
+}
+
+utils::StatusOr<int64_t> RemoveSmallOutputTreeGroups(
+    DecisionForest* trees, const int group_size, const float min_abs_output) {
+  if (group_size <= 0) {
+    return absl::InvalidArgumentError("The group size should be positive.");
+  }
+  if (trees->size() % group_size != 0) {
+    return absl::InvalidArgumentError(
+        "The number of trees is not a multiple of the group size.");
+  }
+  const int num_groups = trees->size() / group_size;
+
+  // Maximum absolute leaf value of each group.
+  std::vector<float> group_outputs(num_groups, 0.f);
+  int best_group_idx = 0;
+  for (int group_idx = 0; group_idx < num_groups; group_idx++) {
+    for (int sub_idx = 0; sub_idx < group_size; sub_idx++) {
+      ASSIGN_OR_RETURN(
+          const float tree_output,
+          MaxAbsLeafValue(*(*trees)[group_idx * group_size + sub_idx]));
+      group_outputs[group_idx] =
+          std::max(group_outputs[group_idx], tree_output);
+    }
+    if (group_outputs[group_idx] > group_outputs[best_group_idx]) {
+      best_group_idx = group_idx;
+    }
+  }
+
+  DecisionForest kept_trees;
+  for (int group_idx = 0; group_idx < num_groups; group_idx++) {
+    // The group with the largest output is always kept: a forest model should
+    // contain at least one tree.
+    if (group_idx != best_group_idx &&
+        group_outputs[group_idx] < min_abs_output) {
+      continue;
+    }
+    for (int sub_idx = 0; sub_idx < group_size; sub_idx++) {
+      kept_trees.push_back(
+          std::move((*trees)[group_idx * group_size + sub_idx]));
+    }
+  }
+  const int64_t num_removed_trees = trees->size() - kept_trees.size();
+  *trees = std::move(kept_trees);
+  return num_removed_trees;
+}
+
+}  // namespace decision_tree
+}  // namespace model
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Post-training pruning of decision trees.
+//
+// These transformations shrink an already trained model without retraining.
+// They either keep the model predictions exactly (e.g.
+// "MergeIdenticalSubtrees") or bound the change of the predictions (e.g.
+// "CollapseNearEqualRegressionLeaves"). Evaluate the pruned model on a
+// validation dataset to measure the actual quality impact (see the
+// "edit_model" CLI tool).
+
+#ifndef YGGDRASIL_DECISION_FORESTS_MODEL_DECISION_TREE_PRUNING_H_
+#define YGGDRASIL_DECISION_FORESTS_MODEL_DECISION_TREE_PRUNING_H_
+
+#include <stdint.h>
+
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+
+namespace yggdrasil_decision_forests {
+namespace model {
+namespace decision_tree {
+
+// Removes the conditions whose two branches are structurally identical (same
+// conditions and same leaf predictions): such conditions do not change the
+// predictions of the tree. Applied bottom-up, duplicate bottom fragments of
+// the tree collapse recursively. Returns the number of removed nodes.
+int64_t MergeIdenticalSubtrees(DecisionTree* tree);
+int64_t MergeIdenticalSubtrees(DecisionForest* trees);
+
+// Replaces the sub-trees whose regression leaf values all lie within "margin"
+// of each other by a single leaf. The value of the new leaf is the mean of
+// the collapsed leaf values, weighted by the number of training examples in
+// each leaf: the prediction of the tree changes by at most "margin" per
+// example. "margin=0" only collapses sub-trees with exactly equal leaves.
+// Fails if the tree does not have regression leaves (e.g. a classification
+// Random Forest). Returns the number of removed nodes.
+utils::StatusOr<int64_t> CollapseNearEqualRegressionLeaves(DecisionTree* tree,
+                                                           float margin);
+utils::StatusOr<int64_t> CollapseNearEqualRegressionLeaves(
+    DecisionForest* trees, float margin);
+
+// Removes the groups of "group_size" consecutive trees whose regression leaf
+// values are all in [-min_abs_output, min_abs_output]. For a gradient boosted
+// trees model, a group is a boosting iteration (i.e.
+// group_size=num_trees_per_iter): removing a group changes each output
+// dimension by at most "min_abs_output". At least one group is always kept.
+// Returns the number of removed trees.
+utils::StatusOr<int64_t> RemoveSmallOutputTreeGroups(DecisionForest* trees,
+                                                     int group_size,
+                                                     float min_abs_output);
+
+}  // namespace decision_tree
+}  // namespace model
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_MODEL_DECISION_TREE_PRUNING_H_
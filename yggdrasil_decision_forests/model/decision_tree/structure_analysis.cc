@@ -19,72 +19,71 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/model/decision_tree/compact_tree.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.pb.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/histogram.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 
 namespace yggdrasil_decision_forests {
 namespace model {
 namespace decision_tree {
+namespace {
 
-ForestStructureStatistics ComputeForestStructureStatistics(
-    const dataset::proto::DataSpecification& data_spec,
-    const std::vector<std::unique_ptr<decision_tree::DecisionTree>>&
-        decision_trees) {
-  ForestStructureStatistics statistics;
-
-  // List of max depths that we care about. "-1" means no max depth.
-  const auto candidate_max_depth = {-1, 0, 1, 2, 3, 5};
-
-  // Allocates the counters.
-  for (const int max_depth : candidate_max_depth) {
-    statistics.condition_attribute_sliced_by_max_depth.push_back(std::make_pair(
-        max_depth, std::vector<int>(data_spec.columns_size(), 0)));
-    statistics.condition_type_sliced_by_max_depth.push_back(std::make_pair(
-        max_depth, std::vector<int>(decision_tree::kNumConditionTypes + 1, 0)));
-  }
-
-  statistics.num_trees = decision_trees.size();
-
-  // Fills the histograms and counters.
+// Statistics of a block of trees. The trees are independent, so each worker
+// thread accumulates the statistics of a block of trees in its own
+// "BlockStatistics" and the blocks are merged afterwards.
+struct BlockStatistics {
+  int64_t total_num_nodes = 0;
+  std::vector<std::pair<int, std::vector<int>>>
+      condition_attribute_sliced_by_max_depth;
+  std::vector<std::pair<int, std::vector<int>>>
+      condition_type_sliced_by_max_depth;
   std::vector<int> number_of_nodes_per_tree_values;
   std::vector<int> leaf_depths_values;
   std::vector<int> num_training_examples_by_leaf_values;
+};
 
-  for (auto& tree : decision_trees) {
-    const auto num_nodes = tree->NumNodes();
-    statistics.total_num_nodes += num_nodes;
-    number_of_nodes_per_tree_values.push_back(num_nodes);
+// Accumulates the statistics of the trees in [begin_tree_idx, end_tree_idx).
+// The counters of "block" should already be allocated.
+void ScanTreeBlock(const std::vector<CompactTree>& decision_trees,
+                   const size_t begin_tree_idx, const size_t end_tree_idx,
+                   BlockStatistics* block) {
+  for (size_t tree_idx = begin_tree_idx; tree_idx < end_tree_idx; tree_idx++) {
+    const auto& tree = decision_trees[tree_idx];
+    const auto num_nodes = tree.num_nodes();
+    block->total_num_nodes += num_nodes;
+    block->number_of_nodes_per_tree_values.push_back(num_nodes);
 
-    tree->IterateOnNodes([&](const decision_tree::NodeWithChildren& node,
-                             const int depth) {
-      if (!node.IsLeaf()) {
+    tree.IterateOnNodes([&](const int node_idx, const int depth) {
+      if (!tree.IsLeaf(node_idx)) {
         for (auto& attribute_and_max_depth :
-             statistics.condition_attribute_sliced_by_max_depth) {
+             block->condition_attribute_sliced_by_max_depth) {
           if (attribute_and_max_depth.first != -1 &&
               depth > attribute_and_max_depth.first) {
             continue;
           }
-          const int attribute_idx = node.node().condition().attribute();
+          const int attribute_idx = tree.attribute(node_idx);
           DCHECK_GE(attribute_idx, 0);
           DCHECK_LT(attribute_idx, attribute_and_max_depth.second.size());
-          attribute_and_max_depth.second[node.node().condition().attribute()]++;
+          attribute_and_max_depth.second[attribute_idx]++;
         }
 
         for (auto& condition_type_and_max_depth :
-             statistics.condition_type_sliced_by_max_depth) {
+             block->condition_type_sliced_by_max_depth) {
           if (condition_type_and_max_depth.first != -1 &&
               depth > condition_type_and_max_depth.first) {
             continue;
           }
           const int condition_type_idx =
-              static_cast<int>(node.node().condition().condition().type_case());
+              static_cast<int>(tree.condition_type(node_idx));
           DCHECK_GE(condition_type_idx, 0);
           DCHECK_LT(condition_type_idx,
                     condition_type_and_max_depth.second.size());
@@ -92,12 +91,121 @@ ForestStructureStatistics ComputeForestStructureStatistics(
         }
 
       } else {
-        leaf_depths_values.push_back(depth);
-        num_training_examples_by_leaf_values.push_back(
-            node.node().num_pos_training_examples_without_weight());
+        block->leaf_depths_values.push_back(depth);
+        block->num_training_examples_by_leaf_values.push_back(
+            tree.num_pos_training_examples_without_weight(node_idx));
       }
     });
   }
+}
+
+// Adds the per-attribute / per-condition-type counts of "src" into "dst".
+void MergeSlicedCounts(
+    const std::vector<std::pair<int, std::vector<int>>>& src,
+    std::vector<std::pair<int, std::vector<int>>>* dst) {
+  for (size_t slice_idx = 0; slice_idx < src.size(); slice_idx++) {
+    auto& dst_counts = (*dst)[slice_idx].second;
+    const auto& src_counts = src[slice_idx].second;
+    for (size_t count_idx = 0; count_idx < src_counts.size(); count_idx++) {
+      dst_counts[count_idx] += src_counts[count_idx];
+    }
+  }
+}
+
+}  // namespace
+
+ForestStructureStatistics ComputeForestStructureStatistics(
+    const dataset::proto::DataSpecification& data_spec,
+    const std::vector<std::unique_ptr<decision_tree::DecisionTree>>&
+        decision_trees) {
+  // The analysis only needs the fields retained by the compact
+  // representation.
+  std::vector<CompactTree> compact_trees(decision_trees.size());
+  {
+    utils::concurrency::ThreadPool pool(
+        "CompactForest",
+        std::max<unsigned int>(1, std::thread::hardware_concurrency()));
+    pool.StartWorkers();
+    for (size_t tree_idx = 0; tree_idx < decision_trees.size(); tree_idx++) {
+      pool.Schedule([&decision_trees, &compact_trees, tree_idx]() {
+        compact_trees[tree_idx] =
+            CompactTree::FromTree(*decision_trees[tree_idx]);
+      });
+    }
+  }
+  return ComputeForestStructureStatistics(data_spec, compact_trees);
+}
+
+ForestStructureStatistics ComputeForestStructureStatistics(
+    const dataset::proto::DataSpecification& data_spec,
+    const std::vector<CompactTree>& decision_trees) {
+  ForestStructureStatistics statistics;
+
+  // List of max depths that we care about. "-1" means no max depth.
+  const auto candidate_max_depth = {-1, 0, 1, 2, 3, 5};
+
+  // Allocates the counters.
+  for (const int max_depth : candidate_max_depth) {
+    statistics.condition_attribute_sliced_by_max_depth.push_back(std::make_pair(
+        max_depth, std::vector<int>(data_spec.columns_size(), 0)));
+    statistics.condition_type_sliced_by_max_depth.push_back(std::make_pair(
+        max_depth, std::vector<int>(decision_tree::kNumConditionTypes + 1, 0)));
+  }
+
+  statistics.num_trees = decision_trees.size();
+
+  // Fills the histograms and counters. Each worker thread scans a block of
+  // trees into its own "BlockStatistics".
+  const int num_threads = std::max<int>(
+      1, std::min<size_t>(decision_trees.size(),
+                          std::thread::hardware_concurrency()));
+  std::vector<BlockStatistics> blocks(num_threads);
+  for (auto& block : blocks) {
+    block.condition_attribute_sliced_by_max_depth =
+        statistics.condition_attribute_sliced_by_max_depth;
+    block.condition_type_sliced_by_max_depth =
+        statistics.condition_type_sliced_by_max_depth;
+  }
+  {
+    utils::concurrency::ThreadPool pool("ForestStats", num_threads);
+    pool.StartWorkers();
+    for (int thread_idx = 0; thread_idx < num_threads; thread_idx++) {
+      const size_t begin_tree_idx =
+          decision_trees.size() * thread_idx / num_threads;
+      const size_t end_tree_idx =
+          decision_trees.size() * (thread_idx + 1) / num_threads;
+      pool.Schedule([&decision_trees, &blocks, thread_idx, begin_tree_idx,
+                     end_tree_idx]() {
+        ScanTreeBlock(decision_trees, begin_tree_idx, end_tree_idx,
+                      &blocks[thread_idx]);
+      });
+    }
+  }
+
+  // Merges the per-thread statistics. The blocks are merged in order of tree
+  // index, so the result does not depend on the number of threads.
+  std::vector<int> number_of_nodes_per_tree_values;
+  std::vector<int> leaf_depths_values;
+  std::vector<int> num_training_examples_by_leaf_values;
+  for (const auto& block : blocks) {
+    statistics.total_num_nodes += block.total_num_nodes;
+    MergeSlicedCounts(block.condition_attribute_sliced_by_max_depth,
+                      &statistics.condition_attribute_sliced_by_max_depth);
+    MergeSlicedCounts(block.condition_type_sliced_by_max_depth,
+                      &statistics.condition_type_sliced_by_max_depth);
+    number_of_nodes_per_tree_values.insert(
+        number_of_nodes_per_tree_values.end(),
+        block.number_of_nodes_per_tree_values.begin(),
+        block.number_of_nodes_per_tree_values.end());
+    leaf_depths_values.insert(leaf_depths_values.end(),
+                              block.leaf_depths_values.begin(),
+                              block.leaf_depths_values.end());
+    num_training_examples_by_leaf_values.insert(
+        num_training_examples_by_leaf_values.end(),
+        block.num_training_examples_by_leaf_values.begin(),
+        block.num_training_examples_by_leaf_values.end());
+  }
+
   statistics.number_of_nodes_per_tree =
       yggdrasil_decision_forests::utils::histogram::Histogram<int>::MakeUniform(
           number_of_nodes_per_tree_values, 20);
@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
+#include "yggdrasil_decision_forests/model/decision_tree/compact_tree.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/utils/histogram.h"
 
@@ -70,6 +71,11 @@ ForestStructureStatistics ComputeForestStructureStatistics(
     const std::vector<std::unique_ptr<decision_tree::DecisionTree>>&
         decision_trees);
 
+// Same as above, on the compact tree representation.
+ForestStructureStatistics ComputeForestStructureStatistics(
+    const dataset::proto::DataSpecification& data_spec,
+    const std::vector<CompactTree>& decision_trees);
+
 // Append statistics in a text human readable form.
 void StrAppendForestStructureStatistics(
     const ForestStructureStatistics& statistics,
@@ -69,13 +69,40 @@ constexpr char kHeaderBaseFilename[] = "gradient_boosted_trees_header.pb";
 
 absl::Status GradientBoostedTreesModel::Save(
     absl::string_view directory, const ModelIOOptions& io_options) const {
+  std::vector<const decision_tree::DecisionTree*> trees;
+  trees.reserve(decision_trees_.size());
+  for (const auto& tree : decision_trees_) {
+    trees.push_back(tree.get());
+  }
+  return SaveView(BuildHeader(), trees, directory, io_options);
+}
+
+proto::Header GradientBoostedTreesModel::BuildHeader() const {
+  proto::Header header;
+  if (node_format_.has_value()) {
+    header.set_node_format(node_format_.value());
+  }
+  header.set_loss(loss_);
+  header.set_num_trees_per_iter(num_trees_per_iter_);
+  header.set_validation_loss(validation_loss_);
+  header.set_output_logits(output_logits_);
+  *header.mutable_initial_predictions() = google::protobuf::RepeatedField<float>(
+      initial_predictions_.begin(), initial_predictions_.end());
+  *header.mutable_training_logs() = training_logs_;
+  return header;
+}
+
+absl::Status GradientBoostedTreesModel::SaveView(
+    proto::Header header,
+    const std::vector<const decision_tree::DecisionTree*>& trees,
+    const absl::string_view directory, const ModelIOOptions& io_options) {
   RETURN_IF_ERROR(file::RecursivelyCreateDir(directory, file::Defaults()));
   RETURN_IF_ERROR(ValidateModelIOOptions(io_options));
 
   // Format used to store the nodes.
   std::string format;
-  if (node_format_.has_value()) {
-    format = node_format_.value();
+  if (header.has_node_format()) {
+    format = header.node_format();
   } else {
     ASSIGN_OR_RETURN(format, decision_tree::RecommendedSerializationFormat());
   }
@@ -84,18 +111,10 @@ absl::Status GradientBoostedTreesModel::Save(
   std::string node_base_filename =
       absl::StrCat(io_options.file_prefix.value(), kNodeBaseFilename);
   RETURN_IF_ERROR(decision_tree::SaveTreesToDisk(
-      directory, node_base_filename, decision_trees_, format, &num_shards));
-  proto::Header header;
+      directory, node_base_filename, trees, format, &num_shards));
   header.set_node_format(format);
   header.set_num_node_shards(num_shards);
-  header.set_num_trees(decision_trees_.size());
-  header.set_loss(loss_);
-  header.set_num_trees_per_iter(num_trees_per_iter_);
-  header.set_validation_loss(validation_loss_);
-  header.set_output_logits(output_logits_);
-  *header.mutable_initial_predictions() = google::protobuf::RepeatedField<float>(
-      initial_predictions_.begin(), initial_predictions_.end());
-  *header.mutable_training_logs() = training_logs_;
+  header.set_num_trees(trees.size());
   std::string header_filename =
       absl::StrCat(io_options.file_prefix.value(), kHeaderBaseFilename);
   RETURN_IF_ERROR(file::SetBinaryProto(
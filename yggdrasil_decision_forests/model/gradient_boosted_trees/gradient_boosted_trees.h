@@ -61,6 +61,21 @@ class GradientBoostedTreesModel : public AbstractModel,
   absl::Status Load(absl::string_view directory,
                     const ModelIOOptions& io_options) override;
 
+  // Header of the model as serialized by "Save", with the node storage
+  // information ("num_node_shards", "num_trees", and possibly "node_format")
+  // left to be filled by "SaveView".
+  proto::Header BuildHeader() const;
+
+  // Saves a model composed of "header" (see "BuildHeader") and the borrowed
+  // "trees". Equivalent to calling "Save" on a model in that state. Allows
+  // checkpointing a stable view of a model being trained: boosting only
+  // appends trees, so a header copy and the pointers to the already grown
+  // trees form an immutable snapshot while the training continues.
+  static absl::Status SaveView(
+      proto::Header header,
+      const std::vector<const decision_tree::DecisionTree*>& trees,
+      absl::string_view directory, const ModelIOOptions& io_options);
+
   absl::Status Validate() const override;
 
   // Computes the indices of the active leaves.
@@ -15,6 +15,7 @@
 
 #include "yggdrasil_decision_forests/model/model_engine_wrapper.h"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
@@ -31,27 +32,75 @@ namespace yggdrasil_decision_forests {
 namespace model {
 
 constexpr char EngineWrapperModel::kRegisteredName[];
+constexpr int EngineWrapperModel::kPredictionBatchSize;
 
 void EngineWrapperModel::Predict(const dataset::VerticalDataset& dataset,
                                  dataset::VerticalDataset::row_t row_idx,
                                  model::proto::Prediction* prediction) const {
-  const auto fast_example = engine_->AllocateExamples(1);
-  CHECK_OK(CopyVerticalDatasetToAbstractExampleSet(
-      dataset, row_idx, row_idx + 1, engine_->features(), fast_example.get()));
-  std::vector<float> fast_predictions;
-  engine_->Predict(*fast_example, 1, &fast_predictions);
-  FloatToProtoPrediction(fast_predictions, 0, task_,
-                         engine_->NumPredictionDimension(), prediction);
+  utils::concurrency::MutexLock lock(&cache_mutex_);
+
+  const bool same_dataset =
+      &dataset == cache_dataset_ && dataset.nrow() == cache_dataset_nrow_;
+
+  // Serves the prediction from the cached batch.
+  if (same_dataset && row_idx >= cache_begin_row_idx_ &&
+      row_idx < cache_end_row_idx_) {
+    FloatToProtoPrediction(cache_predictions_, row_idx - cache_begin_row_idx_,
+                           task_, num_prediction_dimensions_, prediction);
+    cache_last_row_idx_ = row_idx;
+    return;
+  }
+
+  if (!batch_examples_) {
+    batch_examples_ = engine_->AllocateExamples(kPredictionBatchSize);
+  }
+
+  // During a sequential scan, converts and predicts the next
+  // "kPredictionBatchSize" rows in a single engine call. Otherwise, only the
+  // requested row is predicted.
+  const bool sequential = same_dataset && row_idx == cache_last_row_idx_ + 1;
+  const dataset::VerticalDataset::row_t end_row_idx =
+      sequential ? std::min<dataset::VerticalDataset::row_t>(
+                       row_idx + kPredictionBatchSize, dataset.nrow())
+                 : row_idx + 1;
+  const int num_examples = end_row_idx - row_idx;
+  // Clearing avoids the growth of the internal buffers (e.g. categorical-set
+  // items) of the reused example set.
+  batch_examples_->Clear();
+  CHECK_OK(CopyVerticalDatasetToAbstractExampleSet(dataset, row_idx,
+                                                   end_row_idx,
+                                                   engine_->features(),
+                                                   batch_examples_.get()));
+  engine_->Predict(*batch_examples_, num_examples, &cache_predictions_);
+
+  cache_dataset_ = &dataset;
+  cache_dataset_nrow_ = dataset.nrow();
+  cache_begin_row_idx_ = row_idx;
+  cache_end_row_idx_ = end_row_idx;
+  cache_last_row_idx_ = row_idx;
+
+  FloatToProtoPrediction(cache_predictions_, 0, task_,
+                         num_prediction_dimensions_, prediction);
 }
 
 void EngineWrapperModel::Predict(const dataset::proto::Example& example,
                                  model::proto::Prediction* prediction) const {
-  const auto fast_example = engine_->AllocateExamples(1);
-  CHECK_OK(fast_example->FromProtoExample(example, 0, engine_->features()));
-  std::vector<float> fast_predictions;
-  engine_->Predict(*fast_example, 1, &fast_predictions);
-  FloatToProtoPrediction(fast_predictions, 0, task_,
-                         engine_->NumPredictionDimension(), prediction);
+  utils::concurrency::MutexLock lock(&cache_mutex_);
+  if (!batch_examples_) {
+    batch_examples_ = engine_->AllocateExamples(kPredictionBatchSize);
+  }
+  // The cached row range is invalidated as "cache_predictions_" is
+  // overwritten.
+  cache_dataset_ = nullptr;
+  cache_begin_row_idx_ = 0;
+  cache_end_row_idx_ = 0;
+  cache_last_row_idx_ = -1;
+
+  batch_examples_->Clear();
+  CHECK_OK(batch_examples_->FromProtoExample(example, 0, engine_->features()));
+  engine_->Predict(*batch_examples_, 1, &cache_predictions_);
+  FloatToProtoPrediction(cache_predictions_, 0, task_,
+                         num_prediction_dimensions_, prediction);
 }
 
 }  // namespace model
@@ -16,9 +16,10 @@
 // Wraps an inference engine (i.e. a model compiled and optimized for fast
 // inference) into a model.
 //
-// Note: This solution is significantly slower than using the fast engine
-// directly as it computes expensive example format conversion and does not use
-// batched predictions.
+// Note: This solution is slower than using the fast engine directly as it
+// computes expensive example format conversion. Sequential scans over a
+// dataset (e.g. evaluation, variable importances) are however converted and
+// predicted in batches internally, which recovers most of the engine speed.
 //
 // The wrapper does not model serialization functions.
 #ifndef YGGDRASIL_DECISION_FORESTS_MODEL_MODEL_ENGINE_WRAPPER_H_
@@ -35,6 +36,7 @@
 #include "yggdrasil_decision_forests/model/abstract_model.h"
 #include "yggdrasil_decision_forests/model/prediction.pb.h"
 #include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 namespace yggdrasil_decision_forests {
 namespace model {
@@ -76,8 +78,36 @@ class EngineWrapperModel : public AbstractModel {
                model::proto::Prediction* prediction) const override;
 
  private:
+  // Number of examples converted and predicted together during a sequential
+  // scan over a dataset.
+  static constexpr int kPredictionBatchSize = 256;
+
   std::unique_ptr<serving::FastEngine> engine_;
   int num_prediction_dimensions_;
+
+  // Batched prediction cache. When "Predict" is called on consecutive rows of
+  // the same dataset, the following "kPredictionBatchSize" rows are converted
+  // in "batch_examples_" (allocated once and reused) and predicted in a
+  // single engine call. The predictions are served from
+  // "cache_predictions_" until the scan leaves the cached row range. Assumes
+  // the dataset is not modified between the calls.
+  mutable utils::concurrency::Mutex cache_mutex_;
+  mutable std::unique_ptr<serving::AbstractExampleSet> batch_examples_
+      GUARDED_BY(cache_mutex_);
+  mutable std::vector<float> cache_predictions_ GUARDED_BY(cache_mutex_);
+  // Dataset (and its number of rows) the cache was computed on.
+  mutable const dataset::VerticalDataset* cache_dataset_
+      GUARDED_BY(cache_mutex_) = nullptr;
+  mutable dataset::VerticalDataset::row_t cache_dataset_nrow_
+      GUARDED_BY(cache_mutex_) = 0;
+  // Cached row range [begin, end).
+  mutable dataset::VerticalDataset::row_t cache_begin_row_idx_
+      GUARDED_BY(cache_mutex_) = 0;
+  mutable dataset::VerticalDataset::row_t cache_end_row_idx_
+      GUARDED_BY(cache_mutex_) = 0;
+  // Last predicted row, used to detect sequential scans.
+  mutable dataset::VerticalDataset::row_t cache_last_row_idx_
+      GUARDED_BY(cache_mutex_) = -1;
 };
 
 }  // namespace model
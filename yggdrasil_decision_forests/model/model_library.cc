@@ -29,7 +29,9 @@
 #include "yggdrasil_decision_forests/model/abstract_model.h"
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 namespace yggdrasil_decision_forests {
 namespace model {
@@ -107,6 +109,68 @@ absl::Status LoadModel(absl::string_view directory,
   return model->get()->Validate();
 }
 
+absl::Status LazyLoadedModel::EnsureLoaded() const {
+  utils::concurrency::MutexLock lock(&mutex_);
+  if (loaded_model_ != nullptr) {
+    return absl::OkStatus();
+  }
+  return LoadModel(directory_, &loaded_model_, io_options_);
+}
+
+utils::StatusOr<const AbstractModel*> LazyLoadedModel::LoadedModel() const {
+  RETURN_IF_ERROR(EnsureLoaded());
+  return loaded_model_or_die();
+}
+
+const AbstractModel* LazyLoadedModel::loaded_model_or_die() const {
+  // Once loaded, "loaded_model_" is never modified: the pointer can be used
+  // after the lock is released.
+  utils::concurrency::MutexLock lock(&mutex_);
+  CHECK(loaded_model_ != nullptr);
+  return loaded_model_.get();
+}
+
+absl::Status LazyLoadedModel::Save(absl::string_view directory,
+                                   const ModelIOOptions& io_options) const {
+  RETURN_IF_ERROR(EnsureLoaded());
+  return loaded_model_or_die()->Save(directory, io_options);
+}
+
+void LazyLoadedModel::Predict(const dataset::VerticalDataset& dataset,
+                              dataset::VerticalDataset::row_t row_idx,
+                              model::proto::Prediction* prediction) const {
+  CHECK_OK(EnsureLoaded());
+  loaded_model_or_die()->Predict(dataset, row_idx, prediction);
+}
+
+void LazyLoadedModel::Predict(const dataset::proto::Example& example,
+                              model::proto::Prediction* prediction) const {
+  CHECK_OK(EnsureLoaded());
+  loaded_model_or_die()->Predict(example, prediction);
+}
+
+absl::Status LoadModelLazily(absl::string_view directory,
+                             std::unique_ptr<LazyLoadedModel>* model,
+                             ModelIOOptions io_options) {
+  proto::AbstractModel header;
+
+  if (!io_options.file_prefix) {
+    ASSIGN_OR_RETURN(io_options.file_prefix, DetectFilePrefix(directory));
+  }
+  RETURN_IF_ERROR(file::GetBinaryProto(
+      file::JoinPath(directory, absl::StrCat(io_options.file_prefix.value(),
+                                             kModelHeaderFileName)),
+      &header, file::Defaults()));
+  *model =
+      std::make_unique<LazyLoadedModel>(header.name(), directory, io_options);
+  AbstractModel::ImportProto(header, model->get());
+  RETURN_IF_ERROR(file::GetBinaryProto(
+      file::JoinPath(directory, absl::StrCat(io_options.file_prefix.value(),
+                                             kModelDataSpecFileName)),
+      model->get()->mutable_data_spec(), file::Defaults()));
+  return model->get()->Validate();
+}
+
 utils::StatusOr<bool> ModelExists(absl::string_view directory,
                                   const ModelIOOptions& io_options) {
   if (io_options.file_prefix) {
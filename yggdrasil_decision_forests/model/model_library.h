@@ -25,6 +25,7 @@
 #include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 namespace yggdrasil_decision_forests {
 namespace model {
@@ -49,6 +50,68 @@ absl::Status LoadModel(absl::string_view directory,
                        std::unique_ptr<AbstractModel>* model,
                        ModelIOOptions io_options = {});
 
+// Model returned by "LoadModelLazily". The metadata (header and dataspec) is
+// loaded eagerly; the model structure is loaded on the first call that needs
+// it. See "LoadModelLazily".
+class LazyLoadedModel : public AbstractModel {
+ public:
+  LazyLoadedModel(const absl::string_view model_name,
+                  const absl::string_view directory,
+                  const ModelIOOptions& io_options)
+      : AbstractModel(model_name),
+        directory_(directory),
+        io_options_(io_options) {}
+
+  // Loads the underlying model if it is not loaded already. Called
+  // automatically by the methods that need the model structure (e.g.
+  // "Predict"). Thread-safe.
+  absl::Status EnsureLoaded() const;
+
+  // Underlying fully-loaded model. Triggers the loading.
+  utils::StatusOr<const AbstractModel*> LoadedModel() const;
+
+  absl::Status Save(absl::string_view directory,
+                    const ModelIOOptions& io_options) const override;
+
+  absl::Status Load(absl::string_view directory,
+                    const ModelIOOptions& io_options) override {
+    return absl::InvalidArgumentError(
+        "A lazily loaded model cannot be re-loaded. Use \"LoadModelLazily\" "
+        "instead.");
+  }
+
+  void Predict(const dataset::VerticalDataset& dataset,
+               dataset::VerticalDataset::row_t row_idx,
+               model::proto::Prediction* prediction) const override;
+
+  void Predict(const dataset::proto::Example& example,
+               model::proto::Prediction* prediction) const override;
+
+ private:
+  // Underlying model, without the mutex acquisition of "LoadedModel". Fails
+  // if the model is not loaded already.
+  const AbstractModel* loaded_model_or_die() const;
+
+  // Location of the model, used for the deferred load.
+  std::string directory_;
+  ModelIOOptions io_options_;
+
+  // Underlying model. Null until the first deferred load.
+  mutable utils::concurrency::Mutex mutex_;
+  mutable std::unique_ptr<AbstractModel> loaded_model_ GUARDED_BY(mutex_);
+};
+
+// Loads a model lazily: only the model header and the dataspec are read
+// immediately; the model structure (e.g. the tree shards, generally almost all
+// of the model size) is only read on the first prediction or on
+// "LazyLoadedModel::EnsureLoaded". The metadata accessors (task, label, input
+// features, dataspec) are available immediately, which makes this function
+// suited to scan the metadata of many models (e.g. a model registry) or to
+// select among models at serving startup without paying for the full loads.
+absl::Status LoadModelLazily(absl::string_view directory,
+                             std::unique_ptr<LazyLoadedModel>* model,
+                             ModelIOOptions io_options = {});
+
 // Checks if a model exist i.e. if the "done" file (see kModelDoneFileName) is
 // present.
 utils::StatusOr<bool> ModelExists(absl::string_view directory,
@@ -21,6 +21,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 
@@ -28,6 +29,11 @@ namespace yggdrasil_decision_forests {
 namespace model {
 namespace {
 
+std::string TestDataDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data");
+}
+
 TEST(ModelLibrary, CreateAllModels) {
   for (const auto& model_name : AllRegisteredModels()) {
     std::unique_ptr<AbstractModel> mdl;
@@ -35,6 +41,31 @@ TEST(ModelLibrary, CreateAllModels) {
   }
 }
 
+TEST(ModelLibrary, LoadModelLazily) {
+  const auto model_dir =
+      file::JoinPath(TestDataDir(), "model", "adult_binary_class_gbdt");
+
+  std::unique_ptr<AbstractModel> reference_model;
+  ASSERT_OK(LoadModel(model_dir, &reference_model));
+
+  std::unique_ptr<LazyLoadedModel> lazy_model;
+  ASSERT_OK(LoadModelLazily(model_dir, &lazy_model));
+
+  // The metadata is available without loading the model structure.
+  EXPECT_EQ(lazy_model->name(), reference_model->name());
+  EXPECT_EQ(lazy_model->task(), reference_model->task());
+  EXPECT_EQ(lazy_model->label(), reference_model->label());
+  EXPECT_EQ(lazy_model->input_features(), reference_model->input_features());
+  EXPECT_EQ(lazy_model->data_spec().DebugString(),
+            reference_model->data_spec().DebugString());
+
+  // Force the deferred load and check the underlying model.
+  ASSERT_OK(lazy_model->EnsureLoaded());
+  const auto loaded_model_or = lazy_model->LoadedModel();
+  ASSERT_OK(loaded_model_or.status());
+  EXPECT_EQ(loaded_model_or.value()->name(), reference_model->name());
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace yggdrasil_decision_forests
@@ -272,6 +272,54 @@ void RandomForestModel::AddTree(
   decision_trees_.push_back(std::move(decision_tree));
 }
 
+absl::Status RandomForestModel::ReorderTreesByDecisiveness() {
+  if (task() != model::proto::Task::CLASSIFICATION) {
+    return absl::InvalidArgumentError(
+        "Tree reordering by decisiveness only supports classification "
+        "models.");
+  }
+  // Decisiveness of a tree: mean, weighted by the number of training examples
+  // in the leaf, of the fraction of those examples of the leaf's majority
+  // class. A pure-leaf tree scores 1.
+  const auto decisiveness =
+      [](const decision_tree::DecisionTree& tree) -> double {
+    double weighted_confidence = 0;
+    double total_weight = 0;
+    tree.IterateOnNodes([&](const decision_tree::NodeWithChildren& node,
+                            const int depth) {
+      if (!node.IsLeaf() || !node.node().has_classifier()) {
+        return;
+      }
+      const auto& distribution = node.node().classifier().distribution();
+      double top_count = 0;
+      for (const auto count : distribution.counts()) {
+        top_count = std::max(top_count, count);
+      }
+      weighted_confidence += top_count;
+      total_weight += distribution.sum();
+    });
+    if (total_weight == 0) {
+      return 0;
+    }
+    return weighted_confidence / total_weight;
+  };
+
+  std::vector<std::pair<double, std::unique_ptr<decision_tree::DecisionTree>>>
+      scored_trees;
+  scored_trees.reserve(decision_trees_.size());
+  for (auto& tree : decision_trees_) {
+    scored_trees.emplace_back(decisiveness(*tree), std::move(tree));
+  }
+  // Stable: trees with equal scores keep their training order.
+  std::stable_sort(
+      scored_trees.begin(), scored_trees.end(),
+      [](const auto& a, const auto& b) { return a.first > b.first; });
+  for (size_t tree_idx = 0; tree_idx < decision_trees_.size(); tree_idx++) {
+    decision_trees_[tree_idx] = std::move(scored_trees[tree_idx].second);
+  }
+  return absl::OkStatus();
+}
+
 void RandomForestModel::CountFeatureUsage(
     std::unordered_map<int32_t, int64_t>* feature_usage) const {
   for (const auto& tree : decision_trees_) {
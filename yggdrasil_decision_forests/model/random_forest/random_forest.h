@@ -109,6 +109,14 @@ class RandomForestModel : public AbstractModel, public DecisionForestInterface {
   // Add a new tree to the model.
   void AddTree(std::unique_ptr<decision_tree::DecisionTree> decision_tree);
 
+  // Reorders the trees by decreasing decisiveness: the example-weighted mean,
+  // over the leaves of a tree, of the fraction of training examples of the
+  // leaf's majority class. Does not change the model predictions (the forest
+  // vote is order invariant), but lets the early-exit serving engines (see
+  // "PredictEarlyExit" in serving/decision_forest) settle the vote with fewer
+  // trees. Only for classification models.
+  absl::Status ReorderTreesByDecisiveness();
+
   // Estimates the memory usage of the model in RAM. The serialized or the
   // compiled version of the model can be much smaller.
   absl::optional<size_t> ModelSizeInBytes() const override;
@@ -194,6 +194,43 @@ TEST(DecisionTree, CallOnAllLeafs) {
   EXPECT_EQ(num_calls, 2);
 }
 
+TEST(DecisionTree, ReorderTreesByDecisiveness) {
+  RandomForestModel model;
+  dataset::VerticalDataset dataset;
+  BuildToyModelAndToyDataset(model::proto::Task::CLASSIFICATION, &model,
+                             &dataset);
+
+  // Sets the leaf distributions of a tree with "top_count" examples (out of
+  // 10) of the majority class in each leaf.
+  const auto set_leaf_distributions = [&model](const int tree_idx,
+                                               const double top_count) {
+    auto* root = (*model.mutable_decision_trees())[tree_idx]->mutable_root();
+    for (auto* leaf : {root->mutable_pos_child(), root->mutable_neg_child()}) {
+      auto* distribution =
+          leaf->mutable_node()->mutable_classifier()->mutable_distribution();
+      distribution->clear_counts();
+      distribution->add_counts(0);
+      distribution->add_counts(10 - top_count);
+      distribution->add_counts(top_count);
+      distribution->set_sum(10);
+    }
+  };
+  set_leaf_distributions(/*tree_idx=*/0, /*top_count=*/6);
+  set_leaf_distributions(/*tree_idx=*/1, /*top_count=*/9);
+
+  const auto* most_decisive_tree = model.decision_trees()[1].get();
+  EXPECT_OK(model.ReorderTreesByDecisiveness());
+  EXPECT_EQ(model.decision_trees().size(), 2);
+  EXPECT_EQ(model.decision_trees()[0].get(), most_decisive_tree);
+
+  // Only classification models are supported.
+  RandomForestModel regressive_model;
+  BuildToyModelAndToyDataset(model::proto::Task::REGRESSION, &regressive_model,
+                             &dataset);
+  EXPECT_THAT(regressive_model.ReorderTreesByDecisiveness(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(DecisionTree, PredictClassification) {
   RandomForestModel model;
   dataset::VerticalDataset dataset;
@@ -16,12 +16,15 @@
 #include <emscripten/bind.h>
 #include <emscripten/emscripten.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
 #include <string>
 
+#include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
 #include "yggdrasil_decision_forests/serving/fast_engine.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
@@ -153,8 +156,36 @@ class Model {
   int num_examples_ = -1;
 };
 
-// Loads a model from a path.
-std::shared_ptr<Model> LoadModel(std::string path) {
+// Keeps only the first trees of a decision forest model. For a gradient
+// boosted trees model, the cut is rounded down to a complete boosting
+// iteration: the truncated model is exactly the model that training would
+// have produced with fewer iterations. For a random forest, the first trees
+// form a valid, smaller (and noisier) forest. Other model types are left
+// unchanged.
+void TruncateModel(ydf::model::AbstractModel* model, const int max_num_trees) {
+  auto* gbt_model = dynamic_cast<
+      ydf::model::gradient_boosted_trees::GradientBoostedTreesModel*>(model);
+  if (gbt_model != nullptr) {
+    const int trees_per_iter = std::max(1, gbt_model->num_trees_per_iter());
+    const int num_kept_trees = std::max(
+        trees_per_iter, max_num_trees - max_num_trees % trees_per_iter);
+    if (num_kept_trees < gbt_model->num_trees()) {
+      gbt_model->mutable_decision_trees()->resize(num_kept_trees);
+    }
+    return;
+  }
+  auto* rf_model =
+      dynamic_cast<ydf::model::random_forest::RandomForestModel*>(model);
+  if (rf_model != nullptr && max_num_trees < rf_model->num_trees()) {
+    rf_model->mutable_decision_trees()->resize(max_num_trees);
+  }
+}
+
+// Loads a model from a path. If "max_num_trees" is >0 and the model is a
+// decision forest, only the first trees are kept (see "TruncateModel"). Used
+// by the progressive loading of "loadModelFromUrl": a small engine built from
+// the first trees serves early predictions while the full model compiles.
+std::shared_ptr<Model> LoadModel(std::string path, int max_num_trees) {
   // Load model.
   std::unique_ptr<ydf::model::AbstractModel> ydf_model;
   auto status = ydf::model::LoadModel(path, &ydf_model);
@@ -163,6 +194,10 @@ std::shared_ptr<Model> LoadModel(std::string path) {
     return {};
   }
 
+  if (max_num_trees > 0) {
+    TruncateModel(ydf_model.get(), max_num_trees);
+  }
+
   // Compile model.
   auto engine_or = ydf_model->BuildFastEngine();
   if (!engine_or.ok()) {
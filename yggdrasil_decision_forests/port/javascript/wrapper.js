@@ -204,10 +204,30 @@ class Model {
  *        model = loadedModel;
  *    }
  *
+ * If "options.earlyNumTrees" is set, the model is loaded progressively: a
+ * small engine built from the first "earlyNumTrees" trees is returned as soon
+ * as possible and serves the first predictions, while the full model compiles
+ * in the background and is swapped in transparently. For a gradient boosted
+ * trees model, the truncated engine behaves like the same model trained with
+ * fewer boosting iterations: the early predictions are meaningful, only less
+ * refined. "options.onFullModel", if set, is called once the full model is
+ * being served.
+ *
+ * Usage example:
+ *
+ *    ydf.loadModelFromUrl("model.zip", {earlyNumTrees: 30})
+ *        .then((loadedModel) => {
+ *        model = loadedModel;  // Served from the first 30 trees.
+ *    }
+ *
  * @param {string} url Url to a model.
+ * @param {{earlyNumTrees: (number|undefined),
+ *     onFullModel: (function()|undefined)}=} options Progressive loading
+ *     options.
  * @return {!Promise<!Model>} The loaded model.
  */
-Module['loadModelFromUrl'] = async function loadModelFromUrl(url) {
+Module['loadModelFromUrl'] = async function loadModelFromUrl(url, options) {
+  options = options || {};
   // Download model
   const serializedModel = await fetch(url).then((r) => r.blob());
 
@@ -233,17 +253,53 @@ Module['loadModelFromUrl'] = async function loadModelFromUrl(url) {
 
   await Promise.all(promiseUncompressed);
 
-  // Load model in Yggdrasil.
-  const modelWasm = Module.InternalLoadModel(modelPath);
-
   // Delete the model on disk.
-  for (const filename of Module.FS.readdir(modelPath)) {
-    if (filename === '.' || filename === '..') {
-      continue;
+  const deleteModelFiles = () => {
+    for (const filename of Module.FS.readdir(modelPath)) {
+      if (filename === '.' || filename === '..') {
+        continue;
+      }
+      Module.FS.unlink(modelPath + '/' + filename);
     }
-    Module.FS.unlink(modelPath + '/' + filename);
+    Module.FS.rmdir(modelPath);
+  };
+
+  if (options.earlyNumTrees !== undefined && options.earlyNumTrees > 0) {
+    // Progressive loading: serve the first predictions from an engine built
+    // on the first "earlyNumTrees" trees, and compile the full model on a
+    // following tick of the event loop.
+    const earlyModelWasm =
+        Module.InternalLoadModel(modelPath, options.earlyNumTrees);
+    if (earlyModelWasm == null) {
+      deleteModelFiles();
+      throw Error('Cannot parse model');
+    }
+    const model = new Model(earlyModelWasm);
+    setTimeout(() => {
+      const fullModelWasm = Module.InternalLoadModel(modelPath, -1);
+      deleteModelFiles();
+      if (fullModelWasm == null) {
+        // Keep serving the truncated model.
+        return;
+      }
+      if (model.internalModel === null) {
+        // The model was unloaded while the full model was compiling.
+        fullModelWasm.delete();
+        return;
+      }
+      const earlyInternalModel = model.internalModel;
+      model.internalModel = fullModelWasm;
+      earlyInternalModel.delete();
+      if (options.onFullModel !== undefined) {
+        options.onFullModel();
+      }
+    }, 0);
+    return model;
   }
-  Module.FS.rmdir(modelPath);
+
+  // Load model in Yggdrasil.
+  const modelWasm = Module.InternalLoadModel(modelPath, -1);
+  deleteModelFiles();
 
   if (modelWasm == null) {
     throw Error('Cannot parse model');
@@ -251,3 +307,163 @@ Module['loadModelFromUrl'] = async function loadModelFromUrl(url) {
 
   return new Model(modelWasm);
 };
+
+/**
+ * A model replicated over a pool of Web Workers.
+ *
+ * Each worker hosts a full copy of the library and of the model, and runs in
+ * its own thread. "predict" splits the examples in one contiguous shard per
+ * worker, runs the shards in parallel and concatenates the predictions in
+ * example order. Scoring large batches does not block the main thread and
+ * speeds-up with the number of available cores.
+ */
+class WorkerPoolModel {
+  /**
+   * Creates a worker pool model. Use "loadModelFromUrlInWorkers" instead of
+   * calling this constructor directly.
+   * @param {!Array<!Worker>} workers Workers, each hosting a loaded model.
+   */
+  constructor(workers) {
+    /** @private {!Array<{worker: !Worker, pending: !Array<!Object>}>} */
+    this.workers = workers.map((worker) => {
+      const entry = {worker: worker, pending: []};
+      worker.onmessage = (event) => {
+        const callbacks = entry.pending.shift();
+        if (event.data.type === 'predictions') {
+          callbacks.resolve(event.data.predictions);
+        } else {
+          callbacks.reject(Error(event.data.message));
+        }
+      };
+      return entry;
+    });
+  }
+
+  /**
+   * Applies the model on a list of examples and returns the predictions.
+   * Same arguments and results as "Model.predict", but asynchronous and
+   * executed by the workers.
+   * @param {!Examples} examples A list of examples.
+   * @return {!Promise<!Array<number>>} The predictions of the model.
+   */
+  predict(examples) {
+    let numExamples = undefined;
+    for (const values of Object.values(examples)) {
+      numExamples = values.length;
+      break;
+    }
+    if (numExamples === undefined) {
+      throw Error('not features');
+    }
+
+    const promises = [];
+    let beginIdx = 0;
+    for (const [workerIdx, entry] of this.workers.entries()) {
+      const endIdx =
+          Math.floor((numExamples * (workerIdx + 1)) / this.workers.length);
+      if (endIdx === beginIdx) {
+        continue;
+      }
+      const shard = {};
+      for (const [name, values] of Object.entries(examples)) {
+        shard[name] = values.slice(beginIdx, endIdx);
+      }
+      promises.push(new Promise((resolve, reject) => {
+        entry.pending.push({resolve: resolve, reject: reject});
+        entry.worker.postMessage(shard);
+      }));
+      beginIdx = endIdx;
+    }
+
+    return Promise.all(promises).then(
+        (shardPredictions) => [].concat(...shardPredictions));
+  }
+
+  /**
+   * Unloads the model and terminates the workers.
+   */
+  unload() {
+    for (const entry of this.workers) {
+      entry.worker.terminate();
+    }
+    this.workers = [];
+  }
+}
+
+/**
+ * Loads a model from a URL in a pool of Web Workers.
+ *
+ * Usage example:
+ *
+ *    let model = null;
+ *    ydf.loadModelFromUrlInWorkers("model.zip", {
+ *        numWorkers: navigator.hardwareConcurrency,
+ *        libraryUrl: "ydf/inference.js",
+ *        jsZipUrl: "jszip.min.js",
+ *    }).then((loadedModel) => {
+ *        model = loadedModel;
+ *    });
+ *
+ *    model.predict(examples).then((predictions) => { ... });
+ *
+ * @param {string} url Url to a model.
+ * @param {{numWorkers: number, libraryUrl: string, jsZipUrl: string}} options
+ *     Number of workers, url to this library (e.g. "inference.js" or
+ *     "inference_simd.js") and url to the JSZip library.
+ * @return {!Promise<!WorkerPoolModel>} The loaded model.
+ */
+Module['loadModelFromUrlInWorkers'] = function loadModelFromUrlInWorkers(
+    url, options) {
+  // The workers are created from a blob url: relative urls are resolved
+  // against the document before being passed to the workers.
+  const modelUrl = new URL(url, self.location.href).href;
+  const libraryUrl = new URL(options.libraryUrl, self.location.href).href;
+  const jsZipUrl = new URL(options.jsZipUrl, self.location.href).href;
+
+  const workerScript = `
+    importScripts('${jsZipUrl}');
+    importScripts('${libraryUrl}');
+    let model = null;
+    YggdrasilDecisionForests({
+      locateFile: (filename) => new URL(filename, '${libraryUrl}').href,
+    }).then((module) => module.loadModelFromUrl('${modelUrl}'))
+      .then((loadedModel) => {
+        model = loadedModel;
+        postMessage({type: 'ready'});
+      }, (error) => {
+        postMessage({type: 'error', message: String(error)});
+      });
+    onmessage = (event) => {
+      try {
+        postMessage({type: 'predictions',
+                     predictions: model.predict(event.data)});
+      } catch (error) {
+        postMessage({type: 'error', message: String(error)});
+      }
+    };`;
+  const workerScriptUrl = URL.createObjectURL(
+      new Blob([workerScript], {type: 'application/javascript'}));
+
+  const workers = [];
+  const readyPromises = [];
+  for (let workerIdx = 0; workerIdx < options.numWorkers; workerIdx++) {
+    const worker = new Worker(workerScriptUrl);
+    readyPromises.push(new Promise((resolve, reject) => {
+      worker.onerror = (error) => reject(error);
+      worker.onmessage = (event) => {
+        if (event.data.type === 'ready') {
+          resolve();
+        } else {
+          reject(Error(event.data.message));
+        }
+      };
+    }));
+    workers.push(worker);
+  }
+
+  return Promise.all(readyPromises).then(() => {
+    URL.revokeObjectURL(workerScriptUrl);
+    // The "WorkerPoolModel" constructor replaces the "onmessage" handlers.
+    return new WorkerPoolModel(workers);
+  });
+};
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/c_api.h"
+
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+
+namespace serving = yggdrasil_decision_forests::serving;
+namespace model = yggdrasil_decision_forests::model;
+
+struct YDF_Engine {
+  std::unique_ptr<serving::FastEngine> engine;
+};
+
+struct YDF_ExampleSet {
+  // Non-owned. The engine the examples were allocated for.
+  const YDF_Engine* engine;
+  std::unique_ptr<serving::AbstractExampleSet> examples;
+  // Current number of examples (following the last allocation or resize).
+  int num_examples;
+  // Prediction buffer re-used across "YDF_Predict" calls.
+  std::vector<float> prediction_scratch;
+};
+
+namespace {
+
+// Message of the last failure in the calling thread.
+thread_local std::string last_error_message = "No error";
+
+int Fail(std::string message) {
+  last_error_message = std::move(message);
+  return -1;
+}
+
+int Fail(const absl::Status& status) {
+  return Fail(std::string(status.message()));
+}
+
+// Checks that a column buffer matches the current size of the example set.
+int CheckColumnSize(const YDF_ExampleSet* examples, const int num_examples) {
+  if (num_examples != examples->num_examples) {
+    return Fail(absl::StrCat("The column contains ", num_examples,
+                             " values while the example set contains ",
+                             examples->num_examples, " examples"));
+  }
+  return 0;
+}
+
+}  // namespace
+
+const char* YDF_LastErrorMessage(void) { return last_error_message.c_str(); }
+
+int YDF_CreateEngine(const char* model_directory, YDF_Engine** engine) {
+  std::unique_ptr<model::AbstractModel> abstract_model;
+  const auto load_status =
+      model::LoadModel(model_directory, &abstract_model);
+  if (!load_status.ok()) {
+    return Fail(load_status);
+  }
+  auto engine_or = abstract_model->BuildFastEngine();
+  if (!engine_or.ok()) {
+    return Fail(engine_or.status());
+  }
+  *engine = new YDF_Engine{std::move(engine_or).value()};
+  return 0;
+}
+
+void YDF_DestroyEngine(YDF_Engine* engine) { delete engine; }
+
+int YDF_NumPredictionDimension(const YDF_Engine* engine) {
+  return engine->engine->NumPredictionDimension();
+}
+
+int YDF_GetNumericalFeatureId(const YDF_Engine* engine, const char* name) {
+  const auto id_or = engine->engine->features().GetNumericalFeatureId(name);
+  if (!id_or.ok()) {
+    return Fail(id_or.status());
+  }
+  return id_or.value().index;
+}
+
+int YDF_GetBooleanFeatureId(const YDF_Engine* engine, const char* name) {
+  const auto id_or = engine->engine->features().GetBooleanFeatureId(name);
+  if (!id_or.ok()) {
+    return Fail(id_or.status());
+  }
+  return id_or.value().index;
+}
+
+int YDF_GetCategoricalFeatureId(const YDF_Engine* engine, const char* name) {
+  const auto id_or = engine->engine->features().GetCategoricalFeatureId(name);
+  if (!id_or.ok()) {
+    return Fail(id_or.status());
+  }
+  return id_or.value().index;
+}
+
+int YDF_AllocateExamples(const YDF_Engine* engine, const int max_num_examples,
+                         YDF_ExampleSet** examples) {
+  if (max_num_examples <= 0) {
+    return Fail("\"max_num_examples\" should be positive");
+  }
+  auto example_set = engine->engine->AllocateExamples(max_num_examples);
+  *examples =
+      new YDF_ExampleSet{engine, std::move(example_set), max_num_examples};
+  return 0;
+}
+
+void YDF_DestroyExamples(YDF_ExampleSet* examples) { delete examples; }
+
+int YDF_Resize(YDF_ExampleSet* examples, const int num_examples) {
+  if (num_examples <= 0) {
+    return Fail("\"num_examples\" should be positive");
+  }
+  examples->examples->Resize(num_examples,
+                             examples->engine->engine->features());
+  examples->num_examples = num_examples;
+  return 0;
+}
+
+int YDF_FillMissing(YDF_ExampleSet* examples) {
+  examples->examples->FillMissing(examples->engine->engine->features());
+  return 0;
+}
+
+int YDF_SetNumericalColumn(YDF_ExampleSet* examples, const int feature_id,
+                           const float* values, const int num_examples) {
+  if (CheckColumnSize(examples, num_examples) != 0) {
+    return -1;
+  }
+  const auto& features = examples->engine->engine->features();
+  const serving::FeaturesDefinition::NumericalFeatureId id{feature_id};
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    const float value = values[example_idx];
+    if (std::isnan(value)) {
+      examples->examples->SetMissingNumerical(example_idx, id, features);
+    } else {
+      examples->examples->SetNumerical(example_idx, id, value, features);
+    }
+  }
+  return 0;
+}
+
+int YDF_SetBooleanColumn(YDF_ExampleSet* examples, const int feature_id,
+                         const uint8_t* values, const int num_examples) {
+  if (CheckColumnSize(examples, num_examples) != 0) {
+    return -1;
+  }
+  const auto& features = examples->engine->engine->features();
+  const serving::FeaturesDefinition::BooleanFeatureId id{feature_id};
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    const uint8_t value = values[example_idx];
+    if (value > 1) {
+      examples->examples->SetMissingBoolean(example_idx, id, features);
+    } else {
+      examples->examples->SetBoolean(example_idx, id, value != 0, features);
+    }
+  }
+  return 0;
+}
+
+int YDF_SetCategoricalColumn(YDF_ExampleSet* examples, const int feature_id,
+                             const int32_t* values, const int num_examples) {
+  if (CheckColumnSize(examples, num_examples) != 0) {
+    return -1;
+  }
+  const auto& features = examples->engine->engine->features();
+  const serving::FeaturesDefinition::CategoricalFeatureId id{feature_id};
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    const int32_t value = values[example_idx];
+    if (value < 0) {
+      examples->examples->SetMissingCategorical(example_idx, id, features);
+    } else {
+      examples->examples->SetCategorical(example_idx, id, value, features);
+    }
+  }
+  return 0;
+}
+
+int YDF_Predict(YDF_ExampleSet* examples, const int num_examples,
+                float* predictions) {
+  if (num_examples <= 0 || num_examples > examples->num_examples) {
+    return Fail(absl::StrCat("Cannot predict on ", num_examples,
+                             " examples: the example set contains ",
+                             examples->num_examples, " examples"));
+  }
+  const auto& engine = *examples->engine->engine;
+  engine.Predict(*examples->examples, num_examples,
+                 &examples->prediction_scratch);
+  std::memcpy(predictions, examples->prediction_scratch.data(),
+              examples->prediction_scratch.size() * sizeof(float));
+  return 0;
+}
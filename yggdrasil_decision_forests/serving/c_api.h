@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// C ABI over the fast inference engines ("serving/fast_engine.h"), for
+// embedding the engines in non-C++ hosts (Go, Rust, Python, ...) without
+// going through protos.
+//
+// Feature values are passed as caller-owned column buffers: one call per
+// feature and batch, reading the buffer in place and writing the values
+// directly in the engine's example layout. No intermediate representation is
+// built and the FFI boundary is crossed once per column, not once per value.
+//
+// All the handles are opaque. Unless documented otherwise, the functions
+// return 0 on success and -1 on failure; on failure,
+// "YDF_LastErrorMessage()" returns a human readable message.
+//
+// Usage example (error handling omitted):
+//
+//   YDF_Engine* engine;
+//   YDF_CreateEngine("/path/to/model", &engine);
+//   const int feature_age = YDF_GetNumericalFeatureId(engine, "age");
+//
+//   YDF_ExampleSet* examples;
+//   YDF_AllocateExamples(engine, /*max_num_examples=*/1024, &examples);
+//
+//   // For each batch; "ages" is a caller-owned float buffer.
+//   YDF_Resize(examples, num_examples);
+//   YDF_FillMissing(examples);
+//   YDF_SetNumericalColumn(examples, feature_age, ages, num_examples);
+//   YDF_Predict(examples, num_examples, predictions);
+//
+//   YDF_DestroyExamples(examples);
+//   YDF_DestroyEngine(engine);
+//
+// Thread safety: an engine can be shared by multiple threads. An example set
+// (and the functions taking one) must be used by one thread at a time; create
+// one example set per serving thread.
+
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_C_API_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_C_API_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// A loaded model compiled into its fastest compatible inference engine.
+typedef struct YDF_Engine YDF_Engine;
+
+// A re-usable pool of examples, laid out as expected by one engine.
+typedef struct YDF_ExampleSet YDF_ExampleSet;
+
+// Message of the last failure in the calling thread. The pointer is valid
+// until the next failing call in the same thread. Never null.
+const char* YDF_LastErrorMessage(void);
+
+// Loads the model saved in the directory "model_directory" and compiles it
+// into an inference engine. On success, sets "*engine" to a new handle to
+// release with "YDF_DestroyEngine".
+int YDF_CreateEngine(const char* model_directory, YDF_Engine** engine);
+
+// Releases an engine. Example sets allocated from the engine must be
+// destroyed first. No-op if "engine" is null.
+void YDF_DestroyEngine(YDF_Engine* engine);
+
+// Number of dimensions of the predictions: 1 for regression, ranking and
+// binary classification; the number of classes for multi-class
+// classification.
+int YDF_NumPredictionDimension(const YDF_Engine* engine);
+
+// Resolves an input feature of the model by name. Returns the non-negative
+// feature id to use in the "YDF_Set*Column" functions, or -1 if the feature
+// does not exist, is not used by the model, or does not have the requested
+// type.
+int YDF_GetNumericalFeatureId(const YDF_Engine* engine, const char* name);
+int YDF_GetBooleanFeatureId(const YDF_Engine* engine, const char* name);
+int YDF_GetCategoricalFeatureId(const YDF_Engine* engine, const char* name);
+
+// Allocates a pool of "max_num_examples" examples. On success, sets
+// "*examples" to a new handle to release with "YDF_DestroyExamples". The
+// engine must outlive the example set.
+//
+// After the allocation (and after each "YDF_Resize"), the feature values are
+// undefined: set every feature column, or call "YDF_FillMissing" first and
+// set the available columns.
+int YDF_AllocateExamples(const YDF_Engine* engine, int max_num_examples,
+                         YDF_ExampleSet** examples);
+
+// Releases an example set. No-op if "examples" is null.
+void YDF_DestroyExamples(YDF_ExampleSet* examples);
+
+// Changes the number of examples in the set. Re-uses the underlying buffers:
+// resizing within the largest size seen so far does not allocate. The
+// existing feature values are invalidated.
+int YDF_Resize(YDF_ExampleSet* examples, int num_examples);
+
+// Sets all the feature values of all the examples to "missing".
+int YDF_FillMissing(YDF_ExampleSet* examples);
+
+// Sets the values of one feature for all the examples from a caller-owned
+// buffer of "num_examples" elements (which should match the current size of
+// the example set). The buffer is only read during the call.
+//
+// Missing values are encoded in-band: NaN for numerical features, negative
+// values for categorical features and any value other than 0 (false) and 1
+// (true) for boolean features. Categorical values are dictionary indices
+// (matching the model's dataspec) in [0, number_of_unique_values).
+int YDF_SetNumericalColumn(YDF_ExampleSet* examples, int feature_id,
+                           const float* values, int num_examples);
+int YDF_SetBooleanColumn(YDF_ExampleSet* examples, int feature_id,
+                         const uint8_t* values, int num_examples);
+int YDF_SetCategoricalColumn(YDF_ExampleSet* examples, int feature_id,
+                             const int32_t* values, int num_examples);
+
+// Applies the model on the first "num_examples" examples of the set.
+// "predictions" is a caller-owned buffer of "num_examples *
+// YDF_NumPredictionDimension(engine)" floats.
+int YDF_Predict(YDF_ExampleSet* examples, int num_examples,
+                float* predictions);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_C_API_H_
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/c_api.h"
+
+#include <cmath>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "yggdrasil_decision_forests/model/abstract_model.h"
+#include "yggdrasil_decision_forests/model/model_library.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+
+namespace yggdrasil_decision_forests {
+namespace {
+
+std::string ModelDir() {
+  return file::JoinPath(test::DataRootDirectory(),
+                        "yggdrasil_decision_forests/test_data/model",
+                        "adult_binary_class_gbdt");
+}
+
+TEST(CApi, PredictWithColumnBuffers) {
+  YDF_Engine* engine = nullptr;
+  ASSERT_EQ(YDF_CreateEngine(ModelDir().c_str(), &engine), 0)
+      << YDF_LastErrorMessage();
+  EXPECT_EQ(YDF_NumPredictionDimension(engine), 1);
+
+  const int feature_age = YDF_GetNumericalFeatureId(engine, "age");
+  ASSERT_GE(feature_age, 0) << YDF_LastErrorMessage();
+  const int feature_workclass =
+      YDF_GetCategoricalFeatureId(engine, "workclass");
+  ASSERT_GE(feature_workclass, 0) << YDF_LastErrorMessage();
+
+  // Unknown and mistyped features are rejected.
+  EXPECT_EQ(YDF_GetNumericalFeatureId(engine, "does_not_exist"), -1);
+  EXPECT_EQ(YDF_GetNumericalFeatureId(engine, "workclass"), -1);
+
+  YDF_ExampleSet* examples = nullptr;
+  ASSERT_EQ(YDF_AllocateExamples(engine, /*max_num_examples=*/4, &examples),
+            0)
+      << YDF_LastErrorMessage();
+
+  const std::vector<float> ages = {28.f, 77.f, std::nanf("")};
+  const std::vector<int32_t> workclasses = {1, 2, -1};
+  ASSERT_EQ(YDF_Resize(examples, 3), 0);
+  ASSERT_EQ(YDF_FillMissing(examples), 0);
+  ASSERT_EQ(YDF_SetNumericalColumn(examples, feature_age, ages.data(), 3), 0)
+      << YDF_LastErrorMessage();
+  ASSERT_EQ(YDF_SetCategoricalColumn(examples, feature_workclass,
+                                     workclasses.data(), 3),
+            0)
+      << YDF_LastErrorMessage();
+
+  // A column buffer should match the example set size.
+  EXPECT_EQ(YDF_SetNumericalColumn(examples, feature_age, ages.data(), 2),
+            -1);
+  EXPECT_THAT(YDF_LastErrorMessage(), testing::HasSubstr("3 examples"));
+
+  std::vector<float> predictions(3);
+  ASSERT_EQ(YDF_Predict(examples, 3, predictions.data()), 0)
+      << YDF_LastErrorMessage();
+
+  // Compare with the predictions of the C++ API on the same examples.
+  std::unique_ptr<model::AbstractModel> model;
+  ASSERT_OK(model::LoadModel(ModelDir(), &model));
+  const auto cc_engine = model->BuildFastEngine().value();
+  auto cc_examples = cc_engine->AllocateExamples(3);
+  const auto& features = cc_engine->features();
+  cc_examples->FillMissing(features);
+  const auto cc_age = features.GetNumericalFeatureId("age").value();
+  const auto cc_workclass =
+      features.GetCategoricalFeatureId("workclass").value();
+  cc_examples->SetNumerical(0, cc_age, 28.f, features);
+  cc_examples->SetNumerical(1, cc_age, 77.f, features);
+  cc_examples->SetMissingNumerical(2, cc_age, features);
+  cc_examples->SetCategorical(0, cc_workclass, 1, features);
+  cc_examples->SetCategorical(1, cc_workclass, 2, features);
+  cc_examples->SetMissingCategorical(2, cc_workclass, features);
+  std::vector<float> cc_predictions;
+  cc_engine->Predict(*cc_examples, 3, &cc_predictions);
+
+  ASSERT_EQ(cc_predictions.size(), 3);
+  for (int example_idx = 0; example_idx < 3; example_idx++) {
+    EXPECT_NEAR(predictions[example_idx], cc_predictions[example_idx], 1e-6f);
+  }
+
+  // Re-use the example set for a smaller batch.
+  ASSERT_EQ(YDF_Resize(examples, 1), 0);
+  ASSERT_EQ(YDF_FillMissing(examples), 0);
+  ASSERT_EQ(YDF_SetNumericalColumn(examples, feature_age, ages.data(), 1), 0);
+  ASSERT_EQ(YDF_Predict(examples, 1, predictions.data()), 0)
+      << YDF_LastErrorMessage();
+
+  YDF_DestroyExamples(examples);
+  YDF_DestroyEngine(engine);
+}
+
+TEST(CApi, CreateEngineWithInvalidPath) {
+  YDF_Engine* engine = nullptr;
+  EXPECT_EQ(YDF_CreateEngine("/does/not/exist", &engine), -1);
+  EXPECT_STRNE(YDF_LastErrorMessage(), "");
+}
+
+}  // namespace
+}  // namespace yggdrasil_decision_forests
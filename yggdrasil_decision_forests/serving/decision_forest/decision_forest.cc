@@ -15,11 +15,24 @@
 
 #include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"
 
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <thread>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "absl/base/config.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/utils/bitmap.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 #include "yggdrasil_decision_forests/utils/usage.h"
@@ -38,6 +51,22 @@ using ConditionType = model::decision_tree::proto::Condition::TypeCase;
 
 namespace {
 
+// Numerical threshold tested by a node, expressed as a float. Returns an
+// error for non-numerical conditions.
+utils::StatusOr<float> NumericalConditionThreshold(
+    const NodeWithChildren& src_node) {
+  const auto& condition = src_node.node().condition().condition();
+  if (condition.has_higher_condition()) {
+    return condition.higher_condition().threshold();
+  } else if (condition.has_true_value_condition()) {
+    return 0.5f;
+  }
+  return absl::InvalidArgumentError(
+      "Unexpected non-numerical conditions. This inference engine optimized "
+      "for speed only supports numerical conditions. Try another inference "
+      "engine in .../decision_forest.h.");
+}
+
 // Set the value of a non-leaf node only supporting numerical conditions.
 template <typename GenericModel, typename SpecializedModel>
 absl::Status SetNonLeafNode(const GenericModel& src_model,
@@ -57,22 +86,8 @@ absl::Status SetNonLeafNode(const GenericModel& src_model,
   dst_node->feature_idx =
       static_cast<typename SpecializedModel::NodeType::FeatureIdx>(
           feature.internal_idx);
-  if (src_node.node().condition().condition().has_higher_condition()) {
-    dst_node->threshold =
-        src_node.node().condition().condition().higher_condition().threshold();
-    return absl::OkStatus();
-  } else if (src_node.node()
-                 .condition()
-                 .condition()
-                 .has_true_value_condition()) {
-    dst_node->threshold = 0.5f;
-    return absl::OkStatus();
-  } else {
-    return absl::InvalidArgumentError(
-        "Unexpected non-numerical conditions. This inference engine optimized "
-        "for speed only supports numerical conditions. Try another inference "
-        "engine in .../decision_forest.h.");
-  }
+  ASSIGN_OR_RETURN(dst_node->threshold,
+                   NumericalConditionThreshold(src_node));
   return absl::OkStatus();
 }
 
@@ -159,6 +174,44 @@ absl::Status SetNonLeafNode(
   return absl::OkStatus();
 }
 
+// Set the value of a non-leaf node with a uint8 quantized numerical condition.
+// The quantization tables ("bin_boundaries") should already be initialized
+// (see "BuildQuantizationBoundaries").
+template <typename GenericModel, typename SpecializedModel>
+absl::Status SetNonLeafNode(
+    const GenericModel& src_model, const NodeWithChildren& src_node,
+    const int spec_feature_idx, SpecializedModel* dst_model,
+    QuantizedOneDimensionOutputNumericalFeatureNode* dst_node) {
+  static_assert(
+      std::is_same<typename SpecializedModel::NodeType,
+                   QuantizedOneDimensionOutputNumericalFeatureNode>::value,
+      "Non supported node type.");
+
+  ASSIGN_OR_RETURN(const auto feature,
+                   FindFeatureDef(dst_model->features().fixed_length_features(),
+                                  spec_feature_idx));
+
+  dst_node->right_idx = 0;
+  dst_node->feature_idx =
+      static_cast<typename SpecializedModel::NodeType::FeatureIdx>(
+          feature.internal_idx);
+
+  ASSIGN_OR_RETURN(const float threshold,
+                   NumericalConditionThreshold(src_node));
+
+  // Replace the float threshold with its rank in the quantization table: "x >=
+  // threshold" iif. "quantized(x) >= rank(threshold) + 1".
+  const auto& boundaries = dst_model->bin_boundaries[feature.internal_idx];
+  const auto it =
+      std::lower_bound(boundaries.begin(), boundaries.end(), threshold);
+  if (it == boundaries.end() || *it != threshold) {
+    return absl::InternalError(
+        "A threshold of the model is missing from the quantization table.");
+  }
+  dst_node->threshold = static_cast<uint8_t>(it - boundaries.begin() + 1);
+  return absl::OkStatus();
+}
+
 // Creates a "contains" condition in the given non-leaf node.
 // Contains conditions are used for categorical and categorical-set features.
 template <typename SpecializedModel>
@@ -169,24 +222,39 @@ absl::Status SetContainsCondition(
   using GenericNode = typename SpecializedModel::NodeType;
 
   const bool is_categorical_set = (type == dataset::proto::CATEGORICAL_SET);
-  if ((mask.size() >= sizeof(uint32_t) * 8) || is_categorical_set) {
-    dst_node->type =
-        is_categorical_set
-            ? GenericNode::Type::kCategoricalSetContainsBufferOffset
-            : GenericNode::Type::kCategoricalContainsBufferOffset;
-
-    if (dst_model->categorical_mask_buffer.size() >=
+  if (is_categorical_set) {
+    dst_node->type = GenericNode::Type::kCategoricalSetContainsBufferOffset;
+
+    // The mask is compiled into a fixed bitset of 64-bit words evaluated with
+    // word indexing + AND (see "kCategoricalSetContainsBufferOffset" in
+    // "EvalCondition"). Bit "value+1" represents "value"; bit 0 stores the
+    // evaluation for the missing value (-1).
+    const size_t num_words = (mask.size() + 1 + 63) / 64;
+    if (dst_model->categorical_set_bitset_buffer.size() + num_words >
         std::numeric_limits<uint32_t>::max()) {
       return absl::InvalidArgumentError("Too much categorical conditions.");
     }
-    if (is_categorical_set) {
-      // For categorical-set the value "-1" represent the missing value.
-      // This value is stored such that
-      // "categorical_mask_buffer[categorical_contains_buffer_offset+value]"
-      // evaluates correctly. Categorical value uses another mechanism.
-      dst_model->categorical_mask_buffer.push_back(missing_eval_value);
+    dst_node->categorical_contains_buffer_offset =
+        dst_model->categorical_set_bitset_buffer.size();
+    dst_model->categorical_set_bitset_buffer.resize(
+        dst_model->categorical_set_bitset_buffer.size() + num_words, 0);
+    uint64_t* const words = dst_model->categorical_set_bitset_buffer.data() +
+                            dst_node->categorical_contains_buffer_offset;
+    if (missing_eval_value) {
+      words[0] |= uint64_t{1};
+    }
+    for (size_t value = 0; value < mask.size(); value++) {
+      if (mask[value]) {
+        words[(value + 1) / 64] |= uint64_t{1} << ((value + 1) % 64);
+      }
     }
+  } else if (mask.size() >= sizeof(uint32_t) * 8) {
+    dst_node->type = GenericNode::Type::kCategoricalContainsBufferOffset;
 
+    if (dst_model->categorical_mask_buffer.size() >=
+        std::numeric_limits<uint32_t>::max()) {
+      return absl::InvalidArgumentError("Too much categorical conditions.");
+    }
     dst_node->categorical_contains_buffer_offset =
         dst_model->categorical_mask_buffer.size();
     dst_model->categorical_mask_buffer.insert(
@@ -370,20 +438,10 @@ using SetLeafFunctor = std::function<absl::Status(
     SpecializedModel* dst_model,
     typename SpecializedModel::NodeType* dst_node)>;
 
-// Set the leaf of a binary classification Random Forest.
-template <typename SpecializedModel>
-absl::Status SetLeafNodeRandomForestBinaryClassification(
-    const RandomForestModel& src_model, const NodeWithChildren& src_node,
-    SpecializedModel* dst_model,
-    typename SpecializedModel::NodeType* dst_node) {
-  using Node = typename SpecializedModel::NodeType;
-  static_assert(
-      std::is_same<
-          Node, OneDimensionOutputNumericalAndCategoricalFeatureNode>::value ||
-          std::is_same<Node, OneDimensionOutputNumericalFeatureNode>::value ||
-          std::is_same<Node, GenericNode<uint16_t>>::value ||
-          std::is_same<Node, GenericNode<uint32_t>>::value,
-      "Non supported node type.");
+// Value (probability of the positive class, already normalized by the number
+// of trees) of a binary classification Random Forest leaf.
+utils::StatusOr<float> RandomForestBinaryClassificationLeafValue(
+    const RandomForestModel& src_model, const NodeWithChildren& src_node) {
   if (src_model.winner_take_all_inference()) {
     const int32_t vote = src_node.node().classifier().top_value();
     if (vote == dataset::kOutOfDictionaryItemIndex) {
@@ -401,10 +459,7 @@ absl::Status SetLeafNodeRandomForestBinaryClassification(
           "The model is not a binary classifier. Try another inference engine "
           "in .../decision_forest.h.");
     }
-    *dst_node = Node::Leaf(
-        /*.right_idx =*/0,
-        /*.feature_idx =*/0,
-        /*.label =*/((vote == 2) ? (1.0f / src_model.NumTrees()) : 0.0f));
+    return (vote == 2) ? (1.0f / src_model.NumTrees()) : 0.0f;
   } else {
     const auto& distribution = src_node.node().classifier().distribution();
     if (distribution.counts_size() != 3) {
@@ -414,13 +469,32 @@ absl::Status SetLeafNodeRandomForestBinaryClassification(
           "yggdrasil_decision_forests/serving/decision_forest/"
           "decision_forest.h).");
     }
-    *dst_node = Node::Leaf(
-        /*.right_idx =*/0,
-        /*.feature_idx =*/0,
-        /*.label =*/
-        static_cast<float>(distribution.counts(2) /
-                           (distribution.sum() * src_model.NumTrees())));
+    return static_cast<float>(distribution.counts(2) /
+                              (distribution.sum() * src_model.NumTrees()));
   }
+}
+
+// Set the leaf of a binary classification Random Forest.
+template <typename SpecializedModel>
+absl::Status SetLeafNodeRandomForestBinaryClassification(
+    const RandomForestModel& src_model, const NodeWithChildren& src_node,
+    SpecializedModel* dst_model,
+    typename SpecializedModel::NodeType* dst_node) {
+  using Node = typename SpecializedModel::NodeType;
+  static_assert(
+      std::is_same<
+          Node, OneDimensionOutputNumericalAndCategoricalFeatureNode>::value ||
+          std::is_same<Node, OneDimensionOutputNumericalFeatureNode>::value ||
+          std::is_same<Node, GenericNode<uint16_t>>::value ||
+          std::is_same<Node, GenericNode<uint32_t>>::value,
+      "Non supported node type.");
+  ASSIGN_OR_RETURN(
+      const float value,
+      RandomForestBinaryClassificationLeafValue(src_model, src_node));
+  *dst_node = Node::Leaf(
+      /*.right_idx =*/0,
+      /*.feature_idx =*/0,
+      /*.label =*/value);
   return absl::OkStatus();
 }
 
@@ -433,15 +507,6 @@ absl::Status SetLeafNodeRandomForestMulticlassClassification(
   static_assert(std::is_same<Node, GenericNode<uint16_t>>::value ||
                     std::is_same<Node, GenericNode<uint32_t>>::value,
                 "Non supported node type.");
-  const auto begin_label_index = dst_model->label_buffer.size();
-  dst_model->label_buffer.resize(
-      dst_model->label_buffer.size() + dst_model->num_classes, 0.f);
-  *dst_node = Node::LeafMulticlassClassification(
-      /*.right_idx =*/0,
-      /*.feature_idx =*/0,
-      /*.type = */ Node::Type::kLeaf,
-      /*.label_buffer_offset = */ static_cast<uint32_t>(begin_label_index));
-
   if (src_model.winner_take_all_inference()) {
     const int32_t vote = src_node.node().classifier().top_value();
     if (vote == dataset::kOutOfDictionaryItemIndex) {
@@ -454,9 +519,25 @@ absl::Status SetLeafNodeRandomForestMulticlassClassification(
           "\"is_already_integerized=true\" and providing label with "
           "\"OOB\"(=0) values during training.");
     }
-    dst_model->label_buffer[begin_label_index + vote - 1] =
-        1.f / src_model.NumTrees();
+    // Each leaf votes for a single class: store the vote as a one-hot
+    // (class, value) pair instead of a dense "num_classes" value vector.
+    const auto leaf_idx = dst_model->one_hot_label_classes.size();
+    *dst_node = Node::LeafMulticlassClassification(
+        /*.right_idx =*/0,
+        /*.feature_idx =*/0,
+        /*.type = */ Node::Type::kLeaf,
+        /*.label_buffer_offset = */ static_cast<uint32_t>(leaf_idx));
+    dst_model->one_hot_label_classes.push_back(vote - 1);
+    dst_model->one_hot_label_values.push_back(1.f / src_model.NumTrees());
   } else {
+    const auto begin_label_index = dst_model->label_buffer.size();
+    dst_model->label_buffer.resize(
+        dst_model->label_buffer.size() + dst_model->num_classes, 0.f);
+    *dst_node = Node::LeafMulticlassClassification(
+        /*.right_idx =*/0,
+        /*.feature_idx =*/0,
+        /*.type = */ Node::Type::kLeaf,
+        /*.label_buffer_offset = */ static_cast<uint32_t>(begin_label_index));
     const auto& distribution = src_node.node().classifier().distribution();
     for (int class_idx = 0; class_idx < dst_model->num_classes; class_idx++) {
       dst_model->label_buffer[begin_label_index + class_idx] =
@@ -572,9 +653,33 @@ absl::Status SetLeafGradientBoostedTreesRanking(
   return SetRegressiveLeaf(src_model, src_node, 1.f, dst_node);
 }
 
+// Number of top tree levels clustered at the front of each tree's node block.
+// Nodes of the first "kHotNodeLayoutDepth" levels are visited by (almost)
+// every example, so packing them together reduces the number of cache lines
+// and TLB entries touched per traversal. Deeper, rarely-visited subtrees are
+// laid out in plain depth-first order after the hot block.
+constexpr int kHotNodeLayoutDepth = 4;
+
+// Positive subtree whose emission has been postponed by the cache-optimized
+// node layout. The "right_idx" of the parent node is patched when the subtree
+// is finally emitted. See "ConvertGenericNodeToFlatNode".
+struct DeferredSubtree {
+  const NodeWithChildren* node;
+  size_t parent_idx;
+  int depth;
+};
+
 // Recursively explore the children of a node and output the result in the flat
 // node array "specialized_node_array".
 //
+// The negative child of a node is required (by the traversal code) to
+// immediately follow its parent, so the chain of negative descendants is
+// always contiguous. The positive subtrees of nodes shallower than
+// "kHotNodeLayoutDepth" are not emitted in-place: they are appended to
+// "deferred_subtrees" and emitted in FIFO order by the caller, which clusters
+// the top levels of the tree at the front of its node block (level-major).
+// Deeper positive subtrees are emitted in-place i.e. in depth-first order.
+//
 // Arguments:
 //   node: Input node to convert.
 //   spec_feature_idx_to_node_feature_idx: Mapping between the index of the
@@ -582,12 +687,16 @@ absl::Status SetLeafGradientBoostedTreesRanking(
 //   set_leaf and set_non_leaf: Respectively set the content of the leaf and
 //      non-leaf nodes.
 //   specialized_node_array: Output flat node array.
+//   depth: Depth of "node" in its tree.
+//   deferred_subtrees: Positive subtrees to emit later. Drained by
+//     "CreateFlatModelNodes".
 template <typename GenericModel, typename SpecializedModel>
 absl::Status ConvertGenericNodeToFlatNode(
     const GenericModel& src_model, const NodeWithChildren& node,
     const SetLeafFunctor<GenericModel, SpecializedModel> set_node,
     SpecializedModel* dst_model,
-    std::vector<typename SpecializedModel::NodeType>* specialized_node_array) {
+    std::vector<typename SpecializedModel::NodeType>* specialized_node_array,
+    const int depth, std::deque<DeferredSubtree>* deferred_subtrees) {
   if (node.IsLeaf()) {
     // Create a leaf.
     typename SpecializedModel::NodeType dst_node;
@@ -603,9 +712,16 @@ absl::Status ConvertGenericNodeToFlatNode(
     specialized_node_array->push_back(non_leaf_node);
 
     // Create its children.
-    RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(src_model, *node.neg_child(),
-                                                 set_node, dst_model,
-                                                 specialized_node_array));
+    RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(
+        src_model, *node.neg_child(), set_node, dst_model,
+        specialized_node_array, depth + 1, deferred_subtrees));
+    if (depth < kHotNodeLayoutDepth) {
+      // Keep the hot top levels together; the positive subtree is emitted
+      // after all the pending shallow subtrees.
+      deferred_subtrees->push_back(
+          {node.pos_child(), new_node_idx, depth + 1});
+      return absl::OkStatus();
+    }
     const int node_offset = specialized_node_array->size() - new_node_idx;
     if (node_offset >=
         std::numeric_limits<
@@ -614,28 +730,298 @@ absl::Status ConvertGenericNodeToFlatNode(
           "Tree with too many nodes for this optimized model format.");
     }
     (*specialized_node_array)[new_node_idx].right_idx = node_offset;
-    RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(src_model, *node.pos_child(),
-                                                 set_node, dst_model,
-                                                 specialized_node_array));
+    RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(
+        src_model, *node.pos_child(), set_node, dst_model,
+        specialized_node_array, depth + 1, deferred_subtrees));
+  }
+  return absl::OkStatus();
+}
+
+// Assigns, in "leaf_idxs", the index of every leaf reachable from the node
+// "node_idx" following the depth first exploration of the tree (negative
+// child first), starting at "next_leaf_idx". Returns the next available leaf
+// index. The flat nodes encode the same tree structure as the source tree
+// (the negative child follows its parent, the positive child is at
+// "right_idx"), so this numbering matches "DecisionTree::SetLeafIndices" even
+// when the physical node order was changed by the cache-optimized layout.
+template <typename Node>
+int32_t IndexTreeLeaves(const std::vector<Node>& nodes, const size_t node_idx,
+                        int32_t next_leaf_idx,
+                        std::vector<int32_t>* leaf_idxs) {
+  const auto& node = nodes[node_idx];
+  if (!node.right_idx) {
+    (*leaf_idxs)[node_idx] = next_leaf_idx;
+    return next_leaf_idx + 1;
+  }
+  next_leaf_idx =
+      IndexTreeLeaves(nodes, node_idx + 1, next_leaf_idx, leaf_idxs);
+  return IndexTreeLeaves(nodes, node_idx + node.right_idx, next_leaf_idx,
+                         leaf_idxs);
+}
+
+// Appends the flattened trees "[begin_tree_idx, end_tree_idx)" of "src_model"
+// to "dst_model".
+template <typename GenericModel, typename SpecializedModel>
+absl::Status ConvertTreeRange(
+    const GenericModel& src_model,
+    const SetLeafFunctor<GenericModel, SpecializedModel>& set_node,
+    const int begin_tree_idx, const int end_tree_idx,
+    SpecializedModel* dst_model) {
+  std::deque<DeferredSubtree> deferred_subtrees;
+  for (int tree_idx = begin_tree_idx; tree_idx < end_tree_idx; tree_idx++) {
+    const auto& tree = src_model.decision_trees()[tree_idx];
+    dst_model->max_depth = std::max(dst_model->max_depth, tree->MaximumDepth());
+    dst_model->root_offsets.push_back(dst_model->nodes.size());
+    RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(
+        src_model, tree->root(), set_node, dst_model, &dst_model->nodes,
+        /*depth=*/0, &deferred_subtrees));
+    // Emit the deferred positive subtrees in FIFO order: all the subtrees
+    // hanging below level k are emitted before any subtree hanging below
+    // level k+1.
+    while (!deferred_subtrees.empty()) {
+      const DeferredSubtree deferred = deferred_subtrees.front();
+      deferred_subtrees.pop_front();
+      const int node_offset =
+          static_cast<int>(dst_model->nodes.size() - deferred.parent_idx);
+      if (node_offset >=
+          std::numeric_limits<
+              typename SpecializedModel::NodeType::NodeOffset>::max()) {
+        return absl::InvalidArgumentError(
+            "Tree with too many nodes for this optimized model format.");
+      }
+      dst_model->nodes[deferred.parent_idx].right_idx = node_offset;
+      RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(
+          src_model, *deferred.node, set_node, dst_model, &dst_model->nodes,
+          deferred.depth, &deferred_subtrees));
+    }
+  }
+  return absl::OkStatus();
+}
+
+// Offsets to add to the buffer references of the nodes of a model shard when
+// the shard is appended to the merged model (see "MergeShardModel"). The
+// "right_idx" of a node is relative to the node itself and does not change.
+struct ShardMergeOffsets {
+  // Shift of the "label_buffer_offset" of the leaves. Zero for models whose
+  // leaves store their output value inline (single dimensional output).
+  uint32_t leaf = 0;
+  uint32_t categorical_mask = 0;
+  uint32_t categorical_set_bitset = 0;
+  uint32_t oblique = 0;
+};
+
+// Shifts the buffer references of a node by the given offsets. The simple
+// node types store everything inline and reference no buffer.
+inline void ShiftNodeOffsets(const ShardMergeOffsets& offsets,
+                             OneDimensionOutputNumericalFeatureNode* node) {}
+
+inline void ShiftNodeOffsets(
+    const ShardMergeOffsets& offsets,
+    OneDimensionOutputNumericalAndCategoricalFeatureNode* node) {}
+
+template <typename NodeOffsetRep>
+void ShiftNodeOffsets(const ShardMergeOffsets& offsets,
+                      GenericNode<NodeOffsetRep>* node) {
+  using Type = typename GenericNode<NodeOffsetRep>::Type;
+  switch (node->type) {
+    case Type::kLeaf:
+      // "offsets.leaf" is non-zero only if the leaves reference the label
+      // buffers; single dimensional leaves store a float in the union.
+      if (offsets.leaf != 0) {
+        node->label_buffer_offset += offsets.leaf;
+      }
+      break;
+    case Type::kCategoricalContainsBufferOffset:
+      node->categorical_contains_buffer_offset += offsets.categorical_mask;
+      break;
+    case Type::kCategoricalSetContainsBufferOffset:
+      node->categorical_contains_buffer_offset +=
+          offsets.categorical_set_bitset;
+      break;
+    case Type::kNumericalObliqueProjectionIsHigher:
+      node->oblique_projection_offset += offsets.oblique;
+      break;
+    default:
+      // Inline conditions ("kNumericalIsHigher", "kCategoricalContainsMask").
+      break;
   }
+}
+
+// Clears the nodes and buffers of a shard model created as a copy of the
+// destination model. The feature definition and the model constants (e.g.
+// "num_classes", "bin_boundaries") are kept: the conversion functions read
+// them through the shard.
+template <typename Node, typename Value>
+void ClearShardModel(FlatNodeModel<Node, Value>* shard) {
+  shard->nodes.clear();
+  shard->root_offsets.clear();
+  shard->leaf_idxs.clear();
+  shard->label_buffer.clear();
+  shard->one_hot_label_classes.clear();
+  shard->one_hot_label_values.clear();
+  shard->categorical_mask_buffer.clear();
+  shard->categorical_set_bitset_buffer.clear();
+  shard->oblique_weights.clear();
+  shard->oblique_internal_feature_idxs.clear();
+  shard->max_depth = -1;
+}
+
+inline void ClearShardModel(QuantizedNumericalFlatModel* shard) {
+  shard->nodes.clear();
+  shard->root_offsets.clear();
+  shard->leaf_idxs.clear();
+  shard->leaf_values.clear();
+  shard->max_depth = -1;
+}
+
+// Appends the nodes and buffers of a shard to "dst_model". The shard was
+// built against empty buffers: the buffer references of its nodes are shifted
+// by the sizes of the already-merged buffers. Merging the shards in tree
+// order produces the same model as the sequential conversion.
+template <typename Node, typename Value>
+absl::Status MergeShardModel(FlatNodeModel<Node, Value>* shard,
+                             FlatNodeModel<Node, Value>* dst_model) {
+  ShardMergeOffsets offsets;
+  if (!shard->label_buffer.empty()) {
+    offsets.leaf = static_cast<uint32_t>(dst_model->label_buffer.size());
+  } else if (!shard->one_hot_label_classes.empty()) {
+    offsets.leaf =
+        static_cast<uint32_t>(dst_model->one_hot_label_classes.size());
+  }
+  offsets.categorical_mask =
+      static_cast<uint32_t>(dst_model->categorical_mask_buffer.size());
+  offsets.categorical_set_bitset =
+      static_cast<uint32_t>(dst_model->categorical_set_bitset_buffer.size());
+  offsets.oblique = static_cast<uint32_t>(dst_model->oblique_weights.size());
+
+  // The conversion checks the buffer sizes of each shard individually:
+  // re-check the merged sizes.
+  if (dst_model->categorical_mask_buffer.size() +
+              shard->categorical_mask_buffer.size() >
+          std::numeric_limits<uint32_t>::max() ||
+      dst_model->categorical_set_bitset_buffer.size() +
+              shard->categorical_set_bitset_buffer.size() >
+          std::numeric_limits<uint32_t>::max()) {
+    return absl::InvalidArgumentError("Too much categorical conditions.");
+  }
+
+  const size_t base_node_idx = dst_model->nodes.size();
+  for (const auto root_offset : shard->root_offsets) {
+    dst_model->root_offsets.push_back(base_node_idx + root_offset);
+  }
+  for (auto& node : shard->nodes) {
+    ShiftNodeOffsets(offsets, &node);
+  }
+  dst_model->nodes.insert(dst_model->nodes.end(), shard->nodes.begin(),
+                          shard->nodes.end());
+  dst_model->label_buffer.insert(dst_model->label_buffer.end(),
+                                 shard->label_buffer.begin(),
+                                 shard->label_buffer.end());
+  dst_model->one_hot_label_classes.insert(
+      dst_model->one_hot_label_classes.end(),
+      shard->one_hot_label_classes.begin(),
+      shard->one_hot_label_classes.end());
+  dst_model->one_hot_label_values.insert(dst_model->one_hot_label_values.end(),
+                                         shard->one_hot_label_values.begin(),
+                                         shard->one_hot_label_values.end());
+  dst_model->categorical_mask_buffer.insert(
+      dst_model->categorical_mask_buffer.end(),
+      shard->categorical_mask_buffer.begin(),
+      shard->categorical_mask_buffer.end());
+  dst_model->categorical_set_bitset_buffer.insert(
+      dst_model->categorical_set_bitset_buffer.end(),
+      shard->categorical_set_bitset_buffer.begin(),
+      shard->categorical_set_bitset_buffer.end());
+  dst_model->oblique_weights.insert(dst_model->oblique_weights.end(),
+                                    shard->oblique_weights.begin(),
+                                    shard->oblique_weights.end());
+  dst_model->oblique_internal_feature_idxs.insert(
+      dst_model->oblique_internal_feature_idxs.end(),
+      shard->oblique_internal_feature_idxs.begin(),
+      shard->oblique_internal_feature_idxs.end());
+  dst_model->max_depth = std::max(dst_model->max_depth, shard->max_depth);
   return absl::OkStatus();
 }
 
+// The quantized models de-duplicate the leaf values with a cache shared over
+// all the trees (see "SetQuantizedLeaf") and are converted sequentially.
+inline absl::Status MergeShardModel(QuantizedNumericalFlatModel* shard,
+                                    QuantizedNumericalFlatModel* dst_model) {
+  return absl::InternalError(
+      "The quantized models do not support the parallel conversion.");
+}
+
+// Number of trees converted by each parallel task, and minimum number of
+// trees for the conversion to be parallelized. Small models convert in
+// milliseconds: the parallelism only matters for large ensembles (e.g.
+// hot-swapping a 10k-tree model in a server).
+constexpr int kTreesPerBuildChunk = 128;
+constexpr int kMinTreesForParallelBuild = 4 * kTreesPerBuildChunk;
+
 // Creates the nodes of a flat model.
+//
+// If "allow_parallel_build" is true and the model is large, chunks of trees
+// are converted in parallel, each into its own shard model, and the shards
+// are then concatenated in tree order with "MergeShardModel". The result is
+// identical to the sequential conversion. "allow_parallel_build" requires
+// "set_node" to be thread-safe.
 template <typename GenericModel, typename SpecializedModel>
 absl::Status CreateFlatModelNodes(
     const GenericModel& src_model,
     SetLeafFunctor<GenericModel, SpecializedModel> set_node,
-    SpecializedModel* dst_model) {
+    SpecializedModel* dst_model, const bool allow_parallel_build) {
   dst_model->nodes.clear();
   dst_model->nodes.reserve(src_model.NumNodes());
   dst_model->root_offsets.clear();
   dst_model->root_offsets.reserve(src_model.NumTrees());
-  for (const auto& tree : src_model.decision_trees()) {
-    dst_model->root_offsets.push_back(dst_model->nodes.size());
-    RETURN_IF_ERROR(ConvertGenericNodeToFlatNode(
-        src_model, tree->root(), set_node, dst_model, &dst_model->nodes));
+  dst_model->max_depth = -1;
+
+  const int num_trees = src_model.NumTrees();
+  const int num_chunks =
+      (num_trees + kTreesPerBuildChunk - 1) / kTreesPerBuildChunk;
+  const int num_threads =
+      std::min<int>(std::thread::hardware_concurrency(), num_chunks);
+
+  if (!allow_parallel_build || num_trees < kMinTreesForParallelBuild ||
+      num_threads <= 1) {
+    RETURN_IF_ERROR(
+        ConvertTreeRange(src_model, set_node, 0, num_trees, dst_model));
+  } else {
+    // Each shard starts as a copy of the (still empty) destination model so
+    // the workers see the feature definition and the model constants through
+    // the same interface as the sequential conversion.
+    std::vector<SpecializedModel> shards(num_chunks, *dst_model);
+    std::vector<absl::Status> statuses(num_chunks);
+    {
+      utils::concurrency::ThreadPool pool("FlatModelBuild", num_threads);
+      pool.StartWorkers();
+      for (int chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
+        pool.Schedule([&src_model, &set_node, &shards, &statuses, num_trees,
+                       chunk_idx]() {
+          auto& shard = shards[chunk_idx];
+          ClearShardModel(&shard);
+          const int begin_tree_idx = chunk_idx * kTreesPerBuildChunk;
+          const int end_tree_idx =
+              std::min(num_trees, begin_tree_idx + kTreesPerBuildChunk);
+          statuses[chunk_idx] = ConvertTreeRange(
+              src_model, set_node, begin_tree_idx, end_tree_idx, &shard);
+        });
+      }
+      // The pool destructor waits for all the conversions.
+    }
+    for (int chunk_idx = 0; chunk_idx < num_chunks; chunk_idx++) {
+      RETURN_IF_ERROR(statuses[chunk_idx]);
+      RETURN_IF_ERROR(MergeShardModel(&shards[chunk_idx], dst_model));
+    }
+  }
+
+  // Record the leaf indices used by "GetLeaves".
+  dst_model->leaf_idxs.assign(dst_model->nodes.size(), -1);
+  for (const auto root_offset : dst_model->root_offsets) {
+    IndexTreeLeaves(dst_model->nodes, root_offset, /*next_leaf_idx=*/0,
+                    &dst_model->leaf_idxs);
   }
+
   LOG(INFO) << "Model loaded with " << dst_model->root_offsets.size()
             << " root(s), " << dst_model->nodes.size() << " node(s), and "
             << dst_model->features().input_features().size()
@@ -661,27 +1047,135 @@ float ActivationAddInitialPrediction(const SpecializedModel& model,
   return value + model.initial_predictions;
 }
 
-// Final function applied by a Gradient Boosted Trees with
-// MULTINOMIAL_LOG_LIKELIHOOD loss function. I.e. this is a softmax function.
 template <typename SpecializedModel>
-void ActivationGradientBoostedTreesMultinomialLogLikelihood(
-    const SpecializedModel& model, float* const values, const int num_values) {
-  float* cache = static_cast<float*>(alloca(sizeof(float) * num_values));
-  float sum = 0;
-  for (int i = 0; i < num_values; i++) {
-    const float value = std::exp(values[i]);
-    cache[i] = value;
-    sum += value;
+void ActivationMultiDimIdentity(const SpecializedModel& model,
+                                float* const values, const int num_values) {}
+
+#ifdef __AVX2__
+
+// Tests at runtime if the CPU supports AVX2 instructions. Same logic as
+// "DetectCpuInstructionSet" in quick_scorer_extended.cc, but cached in a free
+// function since the flat models do not carry instruction set flags.
+bool CpuSupportsAvx2() {
+#if ABSL_HAVE_BUILTIN(__builtin_cpu_supports)
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+#else
+  // We cannot detect if the CPU supports AVX2 instructions. If it does not,
+  // a fatal error will be raised.
+  return true;
+#endif
+}
+
+// Approximation of "std::exp" on 8 floats at once using the classical
+// decomposition exp(x) = 2^n . exp(r), with n integer and r in
+// [-ln(2)/2, ln(2)/2], and a degree 5 polynomial for exp(r). The relative
+// error is below 3e-7 i.e. about one float32 ulp, and orders of magnitude
+// below the precision expected from the engines. The input is clamped to the
+// range where the float32 result neither overflows nor underflows.
+inline __m256 ExpApprox(const __m256 input) {
+  __m256 x = _mm256_min_ps(input, _mm256_set1_ps(88.3762626647949f));
+  x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+
+  // n = round(x / ln(2)).
+  const __m256 n = _mm256_floor_ps(
+      _mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                    _mm256_set1_ps(0.5f)));
+
+  // r = x - n . ln(2), with ln(2) split in two terms for precision.
+  __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375f)));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4f)));
+
+  // Polynomial approximation of exp(r).
+  __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.3981999507e-3f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(8.3334519073e-3f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(4.1665795894e-2f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(1.6666665459e-1f));
+  p = _mm256_add_ps(_mm256_mul_ps(p, r), _mm256_set1_ps(5.0000001201e-1f));
+  const __m256 r2 = _mm256_mul_ps(r, r);
+  p = _mm256_add_ps(_mm256_mul_ps(p, r2),
+                    _mm256_add_ps(r, _mm256_set1_ps(1.f)));
+
+  // exp(x) = 2^n . exp(r).
+  const __m256i two_pow_n = _mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(p, _mm256_castsi256_ps(two_pow_n));
+}
+
+#endif  // __AVX2__
+
+// Applies "ActivationGradientBoostedTreesBinomialLogLikelihood" on all the
+// predictions of a batch at once, 8 predictions per iteration on AVX2 CPUs.
+// Separating the tree accumulation from the activation makes the "std::exp"
+// calls vectorizable.
+template <typename SpecializedModel>
+void BatchActivationBinomialLogLikelihood(const SpecializedModel& model,
+                                          std::vector<float>* predictions) {
+  float* const values = predictions->data();
+  const size_t num_values = predictions->size();
+  size_t value_idx = 0;
+#ifdef __AVX2__
+  if (CpuSupportsAvx2()) {
+    const __m256 initial_predictions =
+        _mm256_set1_ps(model.initial_predictions);
+    const __m256 zeros = _mm256_setzero_ps();
+    const __m256 ones = _mm256_set1_ps(1.f);
+    for (; value_idx + 8 <= num_values; value_idx += 8) {
+      const __m256 value = _mm256_add_ps(_mm256_loadu_ps(values + value_idx),
+                                         initial_predictions);
+      const __m256 exp_minus_value = ExpApprox(_mm256_sub_ps(zeros, value));
+      __m256 result = _mm256_div_ps(ones, _mm256_add_ps(ones, exp_minus_value));
+      // Same clamping as the scalar activation.
+      result = _mm256_min_ps(_mm256_max_ps(result, zeros), ones);
+      _mm256_storeu_ps(values + value_idx, result);
+    }
   }
-  const float noramlize = 1.f / sum;
-  for (int i = 0; i < num_values; i++) {
-    values[i] = cache[i] * noramlize;
+#endif  // __AVX2__
+  for (; value_idx < num_values; value_idx++) {
+    values[value_idx] = ActivationGradientBoostedTreesBinomialLogLikelihood(
+        model, values[value_idx]);
   }
 }
 
+// Final function applied by a Gradient Boosted Trees with
+// MULTINOMIAL_LOG_LIKELIHOOD loss function i.e. a softmax over each group of
+// "model.num_classes" consecutive predictions. The exponentiation runs
+// vectorized over the whole batch; the per-example normalization is scalar.
 template <typename SpecializedModel>
-void ActivationMultiDimIdentity(const SpecializedModel& model,
-                                float* const values, const int num_values) {}
+void BatchActivationMultinomialLogLikelihood(const SpecializedModel& model,
+                                             const int num_examples,
+                                             std::vector<float>* predictions) {
+  float* const values = predictions->data();
+  const size_t num_values = predictions->size();
+
+  // Exponentiate all the values.
+  size_t value_idx = 0;
+#ifdef __AVX2__
+  if (CpuSupportsAvx2()) {
+    for (; value_idx + 8 <= num_values; value_idx += 8) {
+      _mm256_storeu_ps(values + value_idx,
+                       ExpApprox(_mm256_loadu_ps(values + value_idx)));
+    }
+  }
+#endif  // __AVX2__
+  for (; value_idx < num_values; value_idx++) {
+    values[value_idx] = std::exp(values[value_idx]);
+  }
+
+  // Normalize each example.
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    float* const cur_values = values + example_idx * model.num_classes;
+    float sum = 0;
+    for (int class_idx = 0; class_idx < model.num_classes; class_idx++) {
+      sum += cur_values[class_idx];
+    }
+    const float normalize = 1.f / sum;
+    for (int class_idx = 0; class_idx < model.num_classes; class_idx++) {
+      cur_values[class_idx] *= normalize;
+    }
+  }
+}
 
 // Templated version of "GenericToSpecializedModel".
 template <typename GenericModel, typename SpecializedModel>
@@ -696,7 +1190,10 @@ absl::Status GenericToSpecializedModelHelper(
 
   RETURN_IF_ERROR(InitializeFlatNodeModel(src_model, dst_model));
 
-  return CreateFlatModelNodes(src_model, set_node, dst_model);
+  // The leaf setters of the non-quantized models are stateless: the
+  // conversion can run in parallel.
+  return CreateFlatModelNodes(src_model, set_node, dst_model,
+                              /*allow_parallel_build=*/true);
 }
 
 // A more automatized version of "GenericToSpecializedModelHelper".
@@ -708,6 +1205,129 @@ absl::Status GenericToSpecializedModelHelper2(SetLeaf set_leaf,
       src, SetLeafFunctor<GenericModel, SpecializedModel>(set_leaf), dst);
 }
 
+// Stores "value" in the leaf value buffer of a quantized model and references
+// it from "dst_node". Equal leaf values share a single buffer entry.
+template <typename SpecializedModel>
+absl::Status SetQuantizedLeaf(
+    const float value, absl::flat_hash_map<float, uint16_t>* leaf_value_cache,
+    SpecializedModel* dst_model,
+    QuantizedOneDimensionOutputNumericalFeatureNode* dst_node) {
+  auto it = leaf_value_cache->find(value);
+  if (it == leaf_value_cache->end()) {
+    if (dst_model->leaf_values.size() >
+        std::numeric_limits<uint16_t>::max()) {
+      return absl::InvalidArgumentError(
+          "Too many unique leaf values for the quantized inference engine "
+          "(max 65536). Try another inference engine in "
+          ".../decision_forest.h.");
+    }
+    it = leaf_value_cache
+             ->insert({value,
+                       static_cast<uint16_t>(dst_model->leaf_values.size())})
+             .first;
+    dst_model->leaf_values.push_back(value);
+  }
+  dst_node->right_idx = 0;
+  dst_node->set_leaf_value_idx(it->second);
+  return absl::OkStatus();
+}
+
+// Collects the thresholds tested by a tree into "thresholds" (indexed by
+// internal feature idx).
+template <typename SpecializedModel>
+absl::Status CollectQuantizationThresholds(
+    const NodeWithChildren& node, const SpecializedModel& dst_model,
+    std::vector<std::vector<float>>* thresholds) {
+  if (node.IsLeaf()) {
+    return absl::OkStatus();
+  }
+  ASSIGN_OR_RETURN(const auto feature,
+                   FindFeatureDef(dst_model.features().fixed_length_features(),
+                                  node.node().condition().attribute()));
+  ASSIGN_OR_RETURN(const float threshold, NumericalConditionThreshold(node));
+  (*thresholds)[feature.internal_idx].push_back(threshold);
+  RETURN_IF_ERROR(
+      CollectQuantizationThresholds(*node.neg_child(), dst_model, thresholds));
+  return CollectQuantizationThresholds(*node.pos_child(), dst_model,
+                                       thresholds);
+}
+
+// Builds the per-feature quantization tables ("bin_boundaries") of a quantized
+// model: the sorted unique thresholds tested by the model on each feature.
+template <typename GenericModel, typename SpecializedModel>
+absl::Status BuildQuantizationBoundaries(const GenericModel& src_model,
+                                         SpecializedModel* dst_model) {
+  const int num_features =
+      dst_model->features().fixed_length_features().size();
+  std::vector<std::vector<float>> thresholds(num_features);
+  for (const auto& tree : src_model.decision_trees()) {
+    RETURN_IF_ERROR(CollectQuantizationThresholds(tree->root(), *dst_model,
+                                                  &thresholds));
+  }
+  dst_model->bin_boundaries.assign(num_features, {});
+  for (int feature_idx = 0; feature_idx < num_features; feature_idx++) {
+    auto& feature_thresholds = thresholds[feature_idx];
+    std::sort(feature_thresholds.begin(), feature_thresholds.end());
+    feature_thresholds.erase(std::unique(feature_thresholds.begin(),
+                                         feature_thresholds.end()),
+                             feature_thresholds.end());
+    if (feature_thresholds.size() >
+        std::numeric_limits<uint8_t>::max()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "The model tests ", feature_thresholds.size(),
+          " unique thresholds on one of its features. The quantized inference "
+          "engine supports at most 255 unique thresholds per feature. Try "
+          "another inference engine in .../decision_forest.h."));
+    }
+    dst_model->bin_boundaries[feature_idx] = std::move(feature_thresholds);
+  }
+  return absl::OkStatus();
+}
+
+// "GenericToSpecializedModelHelper" equivalent for quantized models: also
+// builds the quantization tables (before the node conversion, which needs
+// them) and de-duplicates the leaf values.
+template <typename SetLeaf, typename GenericModel, typename SpecializedModel>
+absl::Status QuantizedGenericToSpecializedModelHelper(SetLeaf set_leaf,
+                                                      const GenericModel& src,
+                                                      SpecializedModel* dst) {
+  if (src.task() != SpecializedModel::kTask) {
+    return absl::InvalidArgumentError("Wrong model class.");
+  }
+  src.metadata().Export(&dst->metadata);
+
+  RETURN_IF_ERROR(InitializeFlatNodeModel(src, dst));
+
+  if (dst->features().fixed_length_features().size() >
+      std::numeric_limits<
+          typename SpecializedModel::NodeType::FeatureIdx>::max() +
+          1) {
+    return absl::InvalidArgumentError(
+        "Too many input features for the quantized inference engine (max "
+        "256). Try another inference engine in .../decision_forest.h.");
+  }
+
+  RETURN_IF_ERROR(BuildQuantizationBoundaries(src, dst));
+
+  dst->leaf_values.clear();
+  auto leaf_value_cache =
+      std::make_shared<absl::flat_hash_map<float, uint16_t>>();
+  auto caching_set_leaf =
+      [set_leaf, leaf_value_cache](
+          const GenericModel& src_model, const NodeWithChildren& src_node,
+          SpecializedModel* dst_model,
+          typename SpecializedModel::NodeType* dst_node) -> absl::Status {
+    ASSIGN_OR_RETURN(const float value, set_leaf(src_model, src_node));
+    return SetQuantizedLeaf(value, leaf_value_cache.get(), dst_model,
+                            dst_node);
+  };
+  // "caching_set_leaf" mutates the shared leaf value cache: the conversion
+  // must run sequentially.
+  return CreateFlatModelNodes(
+      src, SetLeafFunctor<GenericModel, SpecializedModel>(caching_set_leaf),
+      dst, /*allow_parallel_build=*/false);
+}
+
 // Checks that a model is a binary classifier.
 template <typename GenericModel>
 absl::Status CheckBinaryClassification(const GenericModel& src) {
@@ -889,6 +1509,67 @@ absl::Status GenericToSpecializedModel(
   return absl::OkStatus();
 }
 
+absl::Status GenericToSpecializedModel(
+    const RandomForestModel& src,
+    QuantizedRandomForestBinaryClassificationNumericalOnly* dst) {
+  return QuantizedGenericToSpecializedModelHelper(
+      [](const RandomForestModel& src_model, const NodeWithChildren& src_node)
+          -> utils::StatusOr<float> {
+        return RandomForestBinaryClassificationLeafValue(src_model, src_node);
+      },
+      src, dst);
+}
+
+absl::Status GenericToSpecializedModel(
+    const RandomForestModel& src,
+    QuantizedRandomForestRegressionNumericalOnly* dst) {
+  return QuantizedGenericToSpecializedModelHelper(
+      [](const RandomForestModel& src_model, const NodeWithChildren& src_node)
+          -> utils::StatusOr<float> {
+        return src_node.node().regressor().top_value() / src_model.NumTrees();
+      },
+      src, dst);
+}
+
+absl::Status GenericToSpecializedModel(
+    const GradientBoostedTreesModel& src,
+    QuantizedGradientBoostedTreesBinaryClassificationNumericalOnly* dst) {
+  if (src.loss() != Loss::BINOMIAL_LOG_LIKELIHOOD ||
+      src.initial_predictions().size() != 1) {
+    return absl::InvalidArgumentError(
+        "The GBT is not trained for binary classification.");
+  }
+
+  RETURN_IF_ERROR(QuantizedGenericToSpecializedModelHelper(
+      [](const GradientBoostedTreesModel& src_model,
+         const NodeWithChildren& src_node) -> utils::StatusOr<float> {
+        return src_node.node().regressor().top_value();
+      },
+      src, dst));
+
+  dst->initial_predictions = src.initial_predictions()[0];
+  return absl::OkStatus();
+}
+
+absl::Status GenericToSpecializedModel(
+    const GradientBoostedTreesModel& src,
+    QuantizedGradientBoostedTreesRegressionNumericalOnly* dst) {
+  if (src.loss() != Loss::SQUARED_ERROR ||
+      src.initial_predictions().size() != 1) {
+    return absl::InvalidArgumentError("The GBT is not trained for regression.");
+  }
+
+  RETURN_IF_ERROR(QuantizedGenericToSpecializedModelHelper(
+      [](const GradientBoostedTreesModel& src_model,
+         const NodeWithChildren& src_node) -> utils::StatusOr<float> {
+        return src_node.node().regressor().top_value();
+      },
+      src, dst));
+
+  dst->initial_predictions = src.initial_predictions()[0];
+  return absl::OkStatus();
+}
+
 template <>
 absl::Status GenericToSpecializedModel(const RandomForestModel& src,
                                        RandomForestBinaryClassification* dst) {
@@ -1305,15 +1986,19 @@ inline bool EvalCondition(const typename Model::NodeType* node,
     }
 
     case GenericNode::Type::kCategoricalSetContainsBufferOffset: {
+      const uint64_t* const words =
+          model.categorical_set_bitset_buffer.data() +
+          node->categorical_contains_buffer_offset;
       const auto& range_values =
           examples.InternalCategoricalSetBeginAndEnds()
               [node->feature_idx * examples.NumberOfExamples() + example_idx];
       for (int value_idx = range_values.begin; value_idx < range_values.end;
            value_idx++) {
-        const auto attribute_value =
-            examples.InternalCategoricalItemBuffer()[value_idx];
-        if (model.categorical_mask_buffer
-                [node->categorical_contains_buffer_offset + attribute_value]) {
+        // Bit "value+1" represents "value"; the missing value (-1) maps to
+        // bit 0.
+        const uint32_t bit =
+            examples.InternalCategoricalItemBuffer()[value_idx] + 1;
+        if (words[bit >> 6] & (uint64_t{1} << (bit & 63))) {
           return true;
         }
       }
@@ -1370,25 +2055,256 @@ inline void PredictHelper(
   }
 }
 
-template <typename Model,
-          float (*FinalTransform)(const Model&, const float) /*= Idendity*/>
-inline void PredictHelper(const Model& model,
-                          const typename Model::ExampleSet& examples,
-                          int num_examples, std::vector<float>* predictions) {
+// Number of trees accumulated between two early-exit checks in
+// "PredictHelperEarlyExit". Large enough to amortize the check, small enough
+// to exit soon after the vote is settled.
+constexpr int kEarlyExitCheckInterval = 32;
+
+// Inference of a binary classification random forest with early exit (see
+// "PredictEarlyExit" in the header). Each leaf holds the tree's vote for the
+// positive class, already normalized by the number of trees (i.e. a value in
+// [0, 1/num_trees]), so after "tree_idx" trees the remaining trees can add at
+// most "(num_trees - tree_idx) / num_trees" to the accumulator. As soon as
+// this slack cannot move the accumulator to the other side of 0.5, the
+// remaining trees are skipped and the partial vote average is re-scaled to
+// the full forest (which preserves the side of 0.5).
+template <typename Model>
+inline void PredictHelperEarlyExit(
+    const Model& model, const std::vector<typename Model::ValueType>& examples,
+    int num_examples, std::vector<float>* predictions) {
   utils::usage::OnInference(num_examples, model.metadata);
+  const int num_features = model.features().fixed_length_features().size();
+  const int num_trees = model.root_offsets.size();
   predictions->resize(num_examples);
   for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
     float output = 0.f;
-    for (const auto root_node_idx : model.root_offsets) {
-      const auto* node = &model.nodes[root_node_idx];
-      while (node->right_idx) {
-        node += EvalCondition(node, examples, example_idx, model)
-                    ? node->right_idx
-                    : 1;
-      }
-      output += node->label;
-    }
-    (*predictions)[example_idx] = FinalTransform(model, output);
+    if (num_features > 0) {
+      const auto* sample = &examples[example_idx * num_features];
+      int tree_idx = 0;
+      while (tree_idx < num_trees) {
+        const int check_point =
+            std::min(num_trees, tree_idx + kEarlyExitCheckInterval);
+        for (; tree_idx < check_point; tree_idx++) {
+          const auto* node = &model.nodes[model.root_offsets[tree_idx]];
+          while (node->right_idx) {
+            node += EvalCondition(node, sample) ? node->right_idx : 1;
+          }
+          output += node->label;
+        }
+        if (tree_idx == num_trees) {
+          break;
+        }
+        const float max_remaining =
+            static_cast<float>(num_trees - tree_idx) / num_trees;
+        if (output > 0.5f || output + max_remaining < 0.5f) {
+          output *= static_cast<float>(num_trees) / tree_idx;
+          break;
+        }
+      }
+    }
+    (*predictions)[example_idx] = utils::clamp(output, 0.f, 1.f);
+  }
+}
+
+// Walks exactly "Depth" levels of a numerical-only tree and returns the
+// reached leaf. Leaves have "right_idx == 0" and "feature_idx == 0", so once a
+// leaf is reached the walk stays on it (both the positive and the negative
+// offsets are 0) and the feature read stays in bounds. The fixed trip count
+// lets the compiler fully unroll the loop, and the offset selection compiles
+// to conditional moves i.e. there is no branch on the test outcome.
+template <int Depth>
+inline const OneDimensionOutputNumericalFeatureNode* WalkTreeFixedDepth(
+    const OneDimensionOutputNumericalFeatureNode* node, const float* sample) {
+  using NodeOffset = OneDimensionOutputNumericalFeatureNode::NodeOffset;
+#pragma clang loop unroll(full)
+  for (int level = 0; level < Depth; level++) {
+    const bool higher = sample[node->feature_idx] >= node->threshold;
+    node += higher ? node->right_idx
+                   : static_cast<NodeOffset>(node->right_idx != 0);
+  }
+  return node;
+}
+
+// Inference of a numerical-only decision forest whose trees all have a depth
+// of at most "Depth". Equivalent to "PredictHelper", but every tree is walked
+// with the branch-free fixed-depth traversal above.
+template <typename Model, int Depth,
+          float (*FinalTransform)(const Model&, const float) = Idendity<Model>>
+inline void PredictHelperFixedDepth(
+    const Model& model, const std::vector<typename Model::ValueType>& examples,
+    int num_examples, std::vector<float>* predictions) {
+  static_assert(
+      std::is_same<typename Model::NodeType,
+                   OneDimensionOutputNumericalFeatureNode>::value,
+      "The fixed-depth traversal only supports numerical-only nodes.");
+  utils::usage::OnInference(num_examples, model.metadata);
+  const int num_features = model.features().fixed_length_features().size();
+  predictions->resize(num_examples);
+  for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
+    float output = 0.f;
+    if (num_features > 0) {
+      const auto* sample = &examples[example_idx * num_features];
+      for (const auto root_node_idx : model.root_offsets) {
+        output +=
+            WalkTreeFixedDepth<Depth>(&model.nodes[root_node_idx], sample)
+                ->label;
+      }
+    }
+    (*predictions)[example_idx] = FinalTransform(model, output);
+  }
+}
+
+// Inference of a numerical-only decision forest. Dispatches to the
+// fixed-depth traversal matching the maximum tree depth of the model, or to
+// the generic traversal loop for models deeper than 8 (past this depth, the
+// unrolled walk evaluates too many dead levels on the short paths and the
+// generic loop wins) and for models compiled before "max_depth" was recorded.
+template <typename Model,
+          float (*FinalTransform)(const Model&, const float) = Idendity<Model>>
+inline void PredictHelperNumericalOnly(
+    const Model& model, const std::vector<typename Model::ValueType>& examples,
+    int num_examples, std::vector<float>* predictions) {
+  switch (model.max_depth) {
+    case 1:
+      return PredictHelperFixedDepth<Model, 1, FinalTransform>(
+          model, examples, num_examples, predictions);
+    case 2:
+      return PredictHelperFixedDepth<Model, 2, FinalTransform>(
+          model, examples, num_examples, predictions);
+    case 3:
+      return PredictHelperFixedDepth<Model, 3, FinalTransform>(
+          model, examples, num_examples, predictions);
+    case 4:
+      return PredictHelperFixedDepth<Model, 4, FinalTransform>(
+          model, examples, num_examples, predictions);
+    case 5:
+      return PredictHelperFixedDepth<Model, 5, FinalTransform>(
+          model, examples, num_examples, predictions);
+    case 6:
+      return PredictHelperFixedDepth<Model, 6, FinalTransform>(
+          model, examples, num_examples, predictions);
+    case 7:
+      return PredictHelperFixedDepth<Model, 7, FinalTransform>(
+          model, examples, num_examples, predictions);
+    case 8:
+      return PredictHelperFixedDepth<Model, 8, FinalTransform>(
+          model, examples, num_examples, predictions);
+    default:
+      return PredictHelper<Model, FinalTransform>(model, examples, num_examples,
+                                                  predictions);
+  }
+}
+
+// Number of examples advanced in lockstep through each tree by
+// "PredictHelper". Walking one example at a time is a single dependent
+// pointer chase: on trees larger than the cache, every node access is a full
+// memory stall. With a block of independent walks in flight and a prefetch
+// issued as soon as the next node of a walk is known, the memory accesses of
+// the block overlap. 16 is large enough to cover the latency of a memory
+// access and small enough for the block state to stay in registers / L1.
+constexpr int kNumInterleavedExamples = 16;
+
+template <typename Model,
+          float (*FinalTransform)(const Model&, const float) /*= Idendity*/>
+inline void PredictHelper(const Model& model,
+                          const typename Model::ExampleSet& examples,
+                          int num_examples, std::vector<float>* predictions) {
+  utils::usage::OnInference(num_examples, model.metadata);
+  predictions->resize(num_examples);
+  // The active node of each example of the current block. "nullptr" once the
+  // example reached a leaf of the current tree.
+  const typename Model::NodeType* nodes[kNumInterleavedExamples];
+  float outputs[kNumInterleavedExamples];
+  for (int block_begin = 0; block_begin < num_examples;
+       block_begin += kNumInterleavedExamples) {
+    const int block_size =
+        std::min(kNumInterleavedExamples, num_examples - block_begin);
+    std::fill(outputs, outputs + block_size, 0.f);
+    for (const auto root_node_idx : model.root_offsets) {
+      for (int i = 0; i < block_size; i++) {
+        nodes[i] = &model.nodes[root_node_idx];
+      }
+      int num_active = block_size;
+      while (num_active > 0) {
+        for (int i = 0; i < block_size; i++) {
+          const auto* node = nodes[i];
+          if (node == nullptr) {
+            continue;
+          }
+          if (node->right_idx == 0) {
+            outputs[i] += node->label;
+            nodes[i] = nullptr;
+            num_active--;
+            continue;
+          }
+          node += EvalCondition(node, examples, block_begin + i, model)
+                      ? node->right_idx
+                      : 1;
+          PREFETCH(node);
+          nodes[i] = node;
+        }
+      }
+    }
+    for (int i = 0; i < block_size; i++) {
+      (*predictions)[block_begin + i] = FinalTransform(model, outputs[i]);
+    }
+  }
+}
+
+// Adds the value vector of the leaf "node" of a multi-dimensional-output
+// model to the dense per-class accumulator "dst" (of "model.num_classes"
+// values). Handles the three leaf-value representations (see
+// "FlatNodeModel::label_buffer").
+template <typename Model, typename Node>
+inline void AccumulateMultiDimLeaf(const Model& model, const Node* node,
+                                   float* const dst) {
+  const uint32_t offset = node->label_buffer_offset;
+  if (!model.one_hot_label_classes.empty()) {
+    // One-hot leaves: a single non-zero value per leaf, and "offset" numbers
+    // the leaves.
+    dst[model.one_hot_label_classes[offset]] +=
+        model.one_hot_label_values[offset];
+  } else if (!model.quantized_label_buffer.empty()) {
+    // Quantized leaves: the int8 codes are converted and scaled directly in
+    // the accumulation loop (a single fma per class once vectorized); the
+    // float leaf values are never materialized.
+    const float scale = model.label_buffer_scales[offset / model.num_classes];
+    const int8_t* const codes = &model.quantized_label_buffer[offset];
+    for (int class_idx = 0; class_idx < model.num_classes; class_idx++) {
+      dst[class_idx] += scale * codes[class_idx];
+    }
+  } else {
+    for (int class_idx = 0; class_idx < model.num_classes; class_idx++) {
+      dst[class_idx] += model.label_buffer[offset + class_idx];
+    }
+  }
+}
+
+// Writes the "k" highest values of "values" (of size "num_values") and their
+// indices in decreasing value order. Ties are broken in favor of the
+// smallest index. "k" should be in [1, num_values].
+inline void SelectTopK(const float* const values, const int num_values,
+                       const int k, int32_t* const top_classes,
+                       float* const top_scores) {
+  for (int i = 0; i < k; i++) {
+    top_classes[i] = -1;
+    top_scores[i] = -std::numeric_limits<float>::infinity();
+  }
+  for (int value_idx = 0; value_idx < num_values; value_idx++) {
+    const float value = values[value_idx];
+    // Most of the values don't make it into the top-k: a single comparison
+    // against the current k-th best.
+    if (value <= top_scores[k - 1]) {
+      continue;
+    }
+    int insert_idx = k - 1;
+    while (insert_idx > 0 && top_scores[insert_idx - 1] < value) {
+      top_scores[insert_idx] = top_scores[insert_idx - 1];
+      top_classes[insert_idx] = top_classes[insert_idx - 1];
+      insert_idx--;
+    }
+    top_scores[insert_idx] = value;
+    top_classes[insert_idx] = value_idx;
   }
 }
 
@@ -1408,10 +2324,7 @@ inline void PredictHelperMultiDimensionTrees(
                     ? node->right_idx
                     : 1;
       }
-      for (int class_idx = 0; class_idx < model.num_classes; class_idx++) {
-        cur_predictions[class_idx] +=
-            model.label_buffer[node->label_buffer_offset + class_idx];
-      }
+      AccumulateMultiDimLeaf(model, node, cur_predictions);
     }
     for (int class_idx = 0; class_idx < model.num_classes; class_idx++) {
       cur_predictions[class_idx] =
@@ -1445,6 +2358,67 @@ inline void PredictHelperMultiDimensionFromSingleDimensionTrees(
   }
 }
 
+// Top-k version of "PredictHelperMultiDimensionTrees": the per-class scores
+// are accumulated into a dense per-example buffer (re-used across examples,
+// and never returned), and only the "k" best classes are selected and
+// exported. The final activation is skipped (see "PredictTopK").
+template <typename Model>
+inline void PredictHelperTopKMultiDimensionTrees(
+    const Model& model, const typename Model::ExampleSet& examples,
+    const int num_examples, int k, std::vector<int32_t>* classes,
+    std::vector<float>* scores) {
+  utils::usage::OnInference(num_examples, model.metadata);
+  k = std::min(k, model.num_classes);
+  classes->resize(num_examples * k);
+  scores->resize(num_examples * k);
+  std::vector<float> accumulator(model.num_classes);
+  for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
+    std::fill(accumulator.begin(), accumulator.end(), 0.f);
+    for (const auto root_node_idx : model.root_offsets) {
+      const auto* node = &model.nodes[root_node_idx];
+      while (node->right_idx) {
+        node += EvalCondition(node, examples, example_idx, model)
+                    ? node->right_idx
+                    : 1;
+      }
+      AccumulateMultiDimLeaf(model, node, accumulator.data());
+    }
+    SelectTopK(accumulator.data(), model.num_classes, k,
+               &(*classes)[example_idx * k], &(*scores)[example_idx * k]);
+  }
+}
+
+// Top-k version of "PredictHelperMultiDimensionFromSingleDimensionTrees".
+// The exported scores are the raw per-class accumulations (e.g. logits for a
+// gradient boosted trees model): the softmax normalization over all the
+// classes is skipped.
+template <typename Model>
+inline void PredictHelperTopKMultiDimensionFromSingleDimensionTrees(
+    const Model& model, const typename Model::ExampleSet& examples,
+    const int num_examples, int k, std::vector<int32_t>* classes,
+    std::vector<float>* scores) {
+  k = std::min(k, model.num_classes);
+  classes->resize(num_examples * k);
+  scores->resize(num_examples * k);
+  std::vector<float> accumulator(model.num_classes);
+  for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
+    std::fill(accumulator.begin(), accumulator.end(), 0.f);
+    int class_idx = 0;
+    for (const auto root_node_idx : model.root_offsets) {
+      const auto* node = &model.nodes[root_node_idx];
+      while (node->right_idx) {
+        node += EvalCondition(node, examples, example_idx, model)
+                    ? node->right_idx
+                    : 1;
+      }
+      accumulator[class_idx] += node->label;
+      class_idx = (class_idx + 1) % model.num_classes;
+    }
+    SelectTopK(accumulator.data(), model.num_classes, k,
+               &(*classes)[example_idx * k], &(*scores)[example_idx * k]);
+  }
+}
+
 // See the documentation of "PredictOptimizedV1".
 template <typename Model,
           float (*FinalTransform)(const Model&, const float) = Idendity<Model>,
@@ -1543,8 +2517,9 @@ inline void PredictHelperOptimizedV1(
 void Predict(const RandomForestBinaryClassificationNumericalFeatures& model,
              const std::vector<float>& examples, int num_examples,
              std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type, Clamp01>(
-      model, examples, num_examples, predictions);
+  PredictHelperNumericalOnly<std::remove_reference<decltype(model)>::type,
+                             Clamp01>(model, examples, num_examples,
+                                      predictions);
 }
 
 void Predict(
@@ -1556,12 +2531,28 @@ void Predict(
       model, examples, num_examples, predictions);
 }
 
+void PredictEarlyExit(
+    const RandomForestBinaryClassificationNumericalFeatures& model,
+    const std::vector<float>& examples, int num_examples,
+    std::vector<float>* predictions) {
+  PredictHelperEarlyExit(model, examples, num_examples, predictions);
+}
+
+void PredictEarlyExit(
+    const RandomForestBinaryClassificationNumericalAndCategoricalFeatures&
+        model,
+    const std::vector<NumericalOrCategoricalValue>& examples, int num_examples,
+    std::vector<float>* predictions) {
+  PredictHelperEarlyExit(model, examples, num_examples, predictions);
+}
+
 void Predict(const GradientBoostedTreesBinaryClassificationNumericalOnly& model,
              const std::vector<float>& examples, int num_examples,
              std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                ActivationGradientBoostedTreesBinomialLogLikelihood>(
-      model, examples, num_examples, predictions);
+  PredictHelperNumericalOnly<std::remove_reference<decltype(model)>::type,
+                             Idendity>(model, examples, num_examples,
+                                       predictions);
+  BatchActivationBinomialLogLikelihood(model, predictions);
 }
 
 void Predict(
@@ -1569,16 +2560,17 @@ void Predict(
         model,
     const std::vector<NumericalOrCategoricalValue>& examples, int num_examples,
     std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                ActivationGradientBoostedTreesBinomialLogLikelihood>(
+  PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
       model, examples, num_examples, predictions);
+  BatchActivationBinomialLogLikelihood(model, predictions);
 }
 
 void Predict(const RandomForestRegressionNumericalOnly& model,
              const std::vector<float>& examples, int num_examples,
              std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
-      model, examples, num_examples, predictions);
+  PredictHelperNumericalOnly<std::remove_reference<decltype(model)>::type,
+                             Idendity>(model, examples, num_examples,
+                                       predictions);
 }
 
 void Predict(const RandomForestRegressionNumericalAndCategorical& model,
@@ -1591,9 +2583,9 @@ void Predict(const RandomForestRegressionNumericalAndCategorical& model,
 void Predict(const GradientBoostedTreesRegressionNumericalOnly& model,
              const std::vector<float>& examples, int num_examples,
              std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                ActivationAddInitialPrediction>(model, examples, num_examples,
-                                                predictions);
+  PredictHelperNumericalOnly<std::remove_reference<decltype(model)>::type,
+                             ActivationAddInitialPrediction>(
+      model, examples, num_examples, predictions);
 }
 
 void Predict(const GradientBoostedTreesRegressionNumericalAndCategorical& model,
@@ -1607,9 +2599,9 @@ void Predict(const GradientBoostedTreesRegressionNumericalAndCategorical& model,
 void Predict(const GradientBoostedTreesRankingNumericalOnly& model,
              const std::vector<float>& examples, int num_examples,
              std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                ActivationAddInitialPrediction>(model, examples, num_examples,
-                                                predictions);
+  PredictHelperNumericalOnly<std::remove_reference<decltype(model)>::type,
+                             ActivationAddInitialPrediction>(
+      model, examples, num_examples, predictions);
 }
 
 void Predict(const GradientBoostedTreesRankingNumericalAndCategorical& model,
@@ -1620,6 +2612,89 @@ void Predict(const GradientBoostedTreesRankingNumericalAndCategorical& model,
                                                 predictions);
 }
 
+void QuantizeExamples(const QuantizedNumericalFlatModel& model,
+                      const std::vector<float>& examples,
+                      const int num_examples,
+                      std::vector<uint8_t>* quantized_examples) {
+  const int num_features = model.features().fixed_length_features().size();
+  quantized_examples->resize(static_cast<size_t>(num_examples) * num_features);
+  for (int feature_idx = 0; feature_idx < num_features; feature_idx++) {
+    const auto& boundaries = model.bin_boundaries[feature_idx];
+    for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+      const size_t value_idx =
+          static_cast<size_t>(example_idx) * num_features + feature_idx;
+      // Number of boundaries lower or equal to the feature value.
+      (*quantized_examples)[value_idx] = static_cast<uint8_t>(
+          std::upper_bound(boundaries.begin(), boundaries.end(),
+                           examples[value_idx]) -
+          boundaries.begin());
+    }
+  }
+}
+
+// Basic inference of a quantized decision forest. The examples are quantized
+// once, and the tree traversals only compare uint8 bin indices.
+template <typename Model,
+          float (*FinalTransform)(const Model&, const float) = Idendity<Model>>
+inline void PredictQuantizedHelper(const Model& model,
+                                   const std::vector<float>& examples,
+                                   int num_examples,
+                                   std::vector<float>* predictions) {
+  utils::usage::OnInference(num_examples, model.metadata);
+  const int num_features = model.features().fixed_length_features().size();
+  std::vector<uint8_t> quantized_examples;
+  QuantizeExamples(model, examples, num_examples, &quantized_examples);
+  predictions->resize(num_examples);
+  for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
+    float output = 0.f;
+    if (num_features > 0) {
+      const auto* sample = &quantized_examples[example_idx * num_features];
+      for (const auto root_node_idx : model.root_offsets) {
+        const auto* node = &model.nodes[root_node_idx];
+        while (node->right_idx) {
+          node += (sample[node->feature_idx] >= node->threshold)
+                      ? node->right_idx
+                      : 1;
+        }
+        output += model.leaf_values[node->leaf_value_idx()];
+      }
+    }
+    (*predictions)[example_idx] = FinalTransform(model, output);
+  }
+}
+
+void Predict(
+    const QuantizedRandomForestBinaryClassificationNumericalOnly& model,
+    const std::vector<float>& examples, int num_examples,
+    std::vector<float>* predictions) {
+  PredictQuantizedHelper<std::remove_reference<decltype(model)>::type, Clamp01>(
+      model, examples, num_examples, predictions);
+}
+
+void Predict(const QuantizedRandomForestRegressionNumericalOnly& model,
+             const std::vector<float>& examples, int num_examples,
+             std::vector<float>* predictions) {
+  PredictQuantizedHelper<std::remove_reference<decltype(model)>::type,
+                         Idendity>(model, examples, num_examples, predictions);
+}
+
+void Predict(
+    const QuantizedGradientBoostedTreesBinaryClassificationNumericalOnly& model,
+    const std::vector<float>& examples, int num_examples,
+    std::vector<float>* predictions) {
+  PredictQuantizedHelper<std::remove_reference<decltype(model)>::type,
+                         Idendity>(model, examples, num_examples, predictions);
+  BatchActivationBinomialLogLikelihood(model, predictions);
+}
+
+void Predict(const QuantizedGradientBoostedTreesRegressionNumericalOnly& model,
+             const std::vector<float>& examples, int num_examples,
+             std::vector<float>* predictions) {
+  PredictQuantizedHelper<std::remove_reference<decltype(model)>::type,
+                         ActivationAddInitialPrediction>(
+      model, examples, num_examples, predictions);
+}
+
 void PredictOptimizedV1(
     const RandomForestBinaryClassificationNumericalFeatures& model,
     const std::vector<float>& examples, int num_examples,
@@ -1816,9 +2891,9 @@ void Predict(
     const typename GradientBoostedTreesBinaryClassification::ExampleSet&
         examples,
     int num_examples, std::vector<float>* predictions) {
-  PredictHelper<std::remove_reference<decltype(model)>::type,
-                ActivationGradientBoostedTreesBinomialLogLikelihood>(
+  PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
       model, examples, num_examples, predictions);
+  BatchActivationBinomialLogLikelihood(model, predictions);
 }
 
 template <>
@@ -1827,13 +2902,10 @@ void Predict(
     const typename GenericGradientBoostedTreesBinaryClassification<
         uint32_t>::ExampleSet& examples,
     int num_examples, std::vector<float>* predictions) {
-  if (model.output_logits) {
-    PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
-        model, examples, num_examples, predictions);
-  } else {
-    PredictHelper<std::remove_reference<decltype(model)>::type,
-                  ActivationGradientBoostedTreesBinomialLogLikelihood>(
-        model, examples, num_examples, predictions);
+  PredictHelper<std::remove_reference<decltype(model)>::type, Idendity>(
+      model, examples, num_examples, predictions);
+  if (!model.output_logits) {
+    BatchActivationBinomialLogLikelihood(model, predictions);
   }
 }
 
@@ -1843,15 +2915,11 @@ void Predict(
     const typename GradientBoostedTreesMulticlassClassification::ExampleSet&
         examples,
     int num_examples, std::vector<float>* predictions) {
-  if (model.output_logits) {
-    PredictHelperMultiDimensionFromSingleDimensionTrees<
-        std::remove_reference<decltype(model)>::type,
-        ActivationMultiDimIdentity>(model, examples, num_examples, predictions);
-  } else {
-    PredictHelperMultiDimensionFromSingleDimensionTrees<
-        std::remove_reference<decltype(model)>::type,
-        ActivationGradientBoostedTreesMultinomialLogLikelihood>(
-        model, examples, num_examples, predictions);
+  PredictHelperMultiDimensionFromSingleDimensionTrees<
+      std::remove_reference<decltype(model)>::type, ActivationMultiDimIdentity>(
+      model, examples, num_examples, predictions);
+  if (!model.output_logits) {
+    BatchActivationMultinomialLogLikelihood(model, num_examples, predictions);
   }
 }
 
@@ -1874,6 +2942,264 @@ void Predict(const GradientBoostedTreesRanking& model,
                                                 predictions);
 }
 
+template <>
+void PredictTopK(
+    const RandomForestMulticlassClassification& model,
+    const typename RandomForestMulticlassClassification::ExampleSet& examples,
+    int num_examples, int k, std::vector<int32_t>* classes,
+    std::vector<float>* scores) {
+  PredictHelperTopKMultiDimensionTrees(model, examples, num_examples, k,
+                                       classes, scores);
+}
+
+template <>
+void PredictTopK(
+    const GenericRandomForestMulticlassClassification<uint32_t>& model,
+    const typename GenericRandomForestMulticlassClassification<
+        uint32_t>::ExampleSet& examples,
+    int num_examples, int k, std::vector<int32_t>* classes,
+    std::vector<float>* scores) {
+  PredictHelperTopKMultiDimensionTrees(model, examples, num_examples, k,
+                                       classes, scores);
+}
+
+template <>
+void PredictTopK(
+    const GradientBoostedTreesMulticlassClassification& model,
+    const typename GradientBoostedTreesMulticlassClassification::ExampleSet&
+        examples,
+    int num_examples, int k, std::vector<int32_t>* classes,
+    std::vector<float>* scores) {
+  PredictHelperTopKMultiDimensionFromSingleDimensionTrees(
+      model, examples, num_examples, k, classes, scores);
+}
+
+template <typename Model>
+absl::Status GetLeaves(const Model& model,
+                       const typename Model::ExampleSet& examples,
+                       int num_examples, absl::Span<int32_t> leaves) {
+  const size_t num_trees = model.root_offsets.size();
+  if (leaves.size() != static_cast<size_t>(num_examples) * num_trees) {
+    return absl::InvalidArgumentError(
+        "The \"leaves\" destination should contain exactly num_examples x "
+        "num_trees elements.");
+  }
+  if (model.leaf_idxs.size() != model.nodes.size()) {
+    return absl::InternalError(
+        "The model was compiled without leaf indices.");
+  }
+  for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
+    int32_t* example_leaves = leaves.data() + example_idx * num_trees;
+    for (size_t tree_idx = 0; tree_idx < num_trees; ++tree_idx) {
+      const auto* node = &model.nodes[model.root_offsets[tree_idx]];
+      while (node->right_idx) {
+        node += EvalCondition(node, examples, example_idx, model)
+                    ? node->right_idx
+                    : 1;
+      }
+      example_leaves[tree_idx] = model.leaf_idxs[node - model.nodes.data()];
+    }
+  }
+  return absl::OkStatus();
+}
+
+template absl::Status GetLeaves(
+    const RandomForestBinaryClassification& model,
+    const typename RandomForestBinaryClassification::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const RandomForestMulticlassClassification& model,
+    const typename RandomForestMulticlassClassification::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const RandomForestRegression& model,
+    const typename RandomForestRegression::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const RandomForestCategoricalUplift& model,
+    const typename RandomForestCategoricalUplift::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const RandomForestNumericalUplift& model,
+    const typename RandomForestNumericalUplift::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GenericRandomForestBinaryClassification<uint32_t>& model,
+    const typename GenericRandomForestBinaryClassification<
+        uint32_t>::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GenericRandomForestMulticlassClassification<uint32_t>& model,
+    const typename GenericRandomForestMulticlassClassification<
+        uint32_t>::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GenericRandomForestRegression<uint32_t>& model,
+    const typename GenericRandomForestRegression<uint32_t>::ExampleSet&
+        examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GenericRandomForestCategoricalUplift<uint32_t>& model,
+    const typename GenericRandomForestCategoricalUplift<uint32_t>::ExampleSet&
+        examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GenericRandomForestNumericalUplift<uint32_t>& model,
+    const typename GenericRandomForestNumericalUplift<uint32_t>::ExampleSet&
+        examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GradientBoostedTreesBinaryClassification& model,
+    const typename GradientBoostedTreesBinaryClassification::ExampleSet&
+        examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GenericGradientBoostedTreesBinaryClassification<uint32_t>& model,
+    const typename GenericGradientBoostedTreesBinaryClassification<
+        uint32_t>::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GradientBoostedTreesMulticlassClassification& model,
+    const typename GradientBoostedTreesMulticlassClassification::ExampleSet&
+        examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GradientBoostedTreesRegression& model,
+    const typename GradientBoostedTreesRegression::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+template absl::Status GetLeaves(
+    const GradientBoostedTreesRanking& model,
+    const typename GradientBoostedTreesRanking::ExampleSet& examples,
+    int num_examples, absl::Span<int32_t> leaves);
+
+absl::Status CheckSameInputFeatures(
+    const FeaturesDefinitionNumericalOrCategoricalFlat& a,
+    const FeaturesDefinitionNumericalOrCategoricalFlat& b) {
+  const auto features_a = a.input_features();
+  const auto features_b = b.input_features();
+  bool same = features_a.size() == features_b.size();
+  for (size_t feature_idx = 0; same && feature_idx < features_a.size();
+       ++feature_idx) {
+    same = features_a[feature_idx].spec_idx ==
+               features_b[feature_idx].spec_idx &&
+           features_a[feature_idx].internal_idx ==
+               features_b[feature_idx].internal_idx &&
+           features_a[feature_idx].type == features_b[feature_idx].type;
+  }
+  if (!same) {
+    return absl::InvalidArgumentError(
+        "The co-scored models do not consume the same input features.");
+  }
+  return absl::OkStatus();
+}
+
+// Traversal shared by the "MultiScorer::Predict" specializations.
+template <typename Model,
+          float (*FinalTransform)(const Model&, const float)>
+absl::Status MultiScorerPredictHelper(
+    const std::vector<Model>& models,
+    const typename Model::ExampleSet& examples, int num_examples,
+    std::vector<float>* predictions) {
+  if (models.empty()) {
+    return absl::InvalidArgumentError(
+        "The multi-scorer does not contain any model.");
+  }
+  for (const auto& model : models) {
+    utils::usage::OnInference(num_examples, model.metadata);
+  }
+  const int num_models = models.size();
+  size_t max_num_trees = 0;
+  for (const auto& model : models) {
+    max_num_trees = std::max(max_num_trees, model.root_offsets.size());
+  }
+  predictions->assign(static_cast<size_t>(num_examples) * num_models, 0.f);
+  float* cur_predictions = predictions->data();
+  for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
+    // Interleave the tree traversals of the different models so the feature
+    // values of the example are re-used while hot in cache.
+    for (size_t tree_idx = 0; tree_idx < max_num_trees; ++tree_idx) {
+      for (int model_idx = 0; model_idx < num_models; ++model_idx) {
+        const auto& model = models[model_idx];
+        if (tree_idx >= model.root_offsets.size()) {
+          continue;
+        }
+        const auto* node = &model.nodes[model.root_offsets[tree_idx]];
+        while (node->right_idx) {
+          node += EvalCondition(node, examples, example_idx, model)
+                      ? node->right_idx
+                      : 1;
+        }
+        cur_predictions[model_idx] += node->label;
+      }
+    }
+    for (int model_idx = 0; model_idx < num_models; ++model_idx) {
+      cur_predictions[model_idx] =
+          FinalTransform(models[model_idx], cur_predictions[model_idx]);
+    }
+    cur_predictions += num_models;
+  }
+  return absl::OkStatus();
+}
+
+template <>
+absl::Status MultiScorer<RandomForestBinaryClassification>::Predict(
+    const typename RandomForestBinaryClassification::ExampleSet& examples,
+    int num_examples, std::vector<float>* predictions) const {
+  return MultiScorerPredictHelper<RandomForestBinaryClassification, Clamp01>(
+      models_, examples, num_examples, predictions);
+}
+
+template <>
+absl::Status MultiScorer<RandomForestRegression>::Predict(
+    const typename RandomForestRegression::ExampleSet& examples,
+    int num_examples, std::vector<float>* predictions) const {
+  return MultiScorerPredictHelper<RandomForestRegression, Idendity>(
+      models_, examples, num_examples, predictions);
+}
+
+template <>
+absl::Status MultiScorer<GradientBoostedTreesBinaryClassification>::Predict(
+    const typename GradientBoostedTreesBinaryClassification::ExampleSet&
+        examples,
+    int num_examples, std::vector<float>* predictions) const {
+  return MultiScorerPredictHelper<
+      GradientBoostedTreesBinaryClassification,
+      ActivationGradientBoostedTreesBinomialLogLikelihood>(
+      models_, examples, num_examples, predictions);
+}
+
+template <>
+absl::Status MultiScorer<GradientBoostedTreesRegression>::Predict(
+    const typename GradientBoostedTreesRegression::ExampleSet& examples,
+    int num_examples, std::vector<float>* predictions) const {
+  return MultiScorerPredictHelper<GradientBoostedTreesRegression,
+                                  ActivationAddInitialPrediction>(
+      models_, examples, num_examples, predictions);
+}
+
+template <>
+absl::Status MultiScorer<GradientBoostedTreesRanking>::Predict(
+    const typename GradientBoostedTreesRanking::ExampleSet& examples,
+    int num_examples, std::vector<float>* predictions) const {
+  return MultiScorerPredictHelper<GradientBoostedTreesRanking,
+                                  ActivationAddInitialPrediction>(
+      models_, examples, num_examples, predictions);
+}
+
 }  // namespace decision_forest
 }  // namespace serving
 }  // namespace yggdrasil_decision_forests
@@ -47,7 +47,11 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_H_
 #define YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_H_
 
+#include <algorithm>
+#include <cmath>
+
 #include "absl/status/status.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
 #include "yggdrasil_decision_forests/serving/decision_forest/utils.h"
@@ -119,6 +123,35 @@ struct OneDimensionOutputNumericalAndCategoricalFeatureNode {
   }
 };
 
+// Node for numerical input features quantized to uint8 bins at engine
+// compilation time. The condition is "quantized_attribute >= threshold" where
+// both sides are bin indices. Four bytes per node i.e. half the size of
+// "OneDimensionOutputNumericalFeatureNode". The output values of the leaves
+// are stored in the "leaf_values" buffer of the model and referenced by a
+// 16 bits index packed in the "feature_idx" and "threshold" fields.
+struct QuantizedOneDimensionOutputNumericalFeatureNode {
+  using NodeOffset = uint16_t;
+  using FeatureIdx = uint8_t;
+
+  NodeOffset right_idx;    // Offset to the positive child node. 0 if is leaf.
+  FeatureIdx feature_idx;  // Tested attribute idx (if this is not a leaf).
+  uint8_t threshold;       // Quantized test threshold (if this is not a leaf).
+
+  // Index in "leaf_values" of the output value (if this is a leaf).
+  uint16_t leaf_value_idx() const {
+    return static_cast<uint16_t>(feature_idx) |
+           (static_cast<uint16_t>(threshold) << 8);
+  }
+
+  void set_leaf_value_idx(const uint16_t leaf_value_idx) {
+    feature_idx = static_cast<FeatureIdx>(leaf_value_idx & 0xFF);
+    threshold = static_cast<uint8_t>(leaf_value_idx >> 8);
+  }
+};
+
+static_assert(sizeof(QuantizedOneDimensionOutputNumericalFeatureNode) == 4,
+              "Unexpected padding in the quantized node.");
+
 // Generic node that support all types of features and all output size.
 // This structure is more generic but less efficient than other node versions.
 template <typename NodeOffsetRep>
@@ -172,7 +205,10 @@ struct GenericNode {
     uint32_t categorical_contains_mask;
 
     // Categorical condition as "categorical_mask_buffer[offset+attribute]",
-    // where "categorical_contains_mask" is a bitmap.
+    // where "categorical_contains_mask" is a bitmap. For categorical-set
+    // conditions ("kCategoricalSetContainsBufferOffset"), this is instead the
+    // offset of the first 64-bit word of the condition bitset in
+    // "categorical_set_bitset_buffer".
     uint32_t categorical_contains_buffer_offset;
 
     // Offset to the first projection in
@@ -235,20 +271,59 @@ struct FlatNodeModel {
   // The indices (in "nodes") of the root nodes.
   std::vector<int32_t> root_offsets;
 
+  // Index of the leaf represented by each node, aligned with "nodes". -1 for
+  // the non-leaf nodes. Leaves are numbered per tree following the depth first
+  // exploration of the source tree (negative child first), i.e. the same
+  // numbering as "DecisionTree::SetLeafIndices". Used by "GetLeaves".
+  std::vector<int32_t> leaf_idxs;
+
   FeaturesDefinition internal_features;
 
   // Buffer of label values. Used for multi-dimensional output trees.
   // See the description of "label_buffer_offset".
   std::vector<float> label_buffer;
 
+  // Optional compressed representations of the multi-dimensional leaf
+  // values. At most one of them is populated, and "label_buffer" is then
+  // empty.
+  //
+  // One-hot representation: the value vector of each leaf contains a single
+  // non-zero, stored as a (class, value) pair. "label_buffer_offset" then
+  // numbers the leaves (instead of indexing "label_buffer") and indexes both
+  // vectors. Built automatically for winner-take-all Random Forests, where
+  // each leaf votes for a single class. Loss-less, and accumulated in O(1)
+  // per leaf instead of O(num classes).
+  std::vector<uint32_t> one_hot_label_classes;
+  std::vector<float> one_hot_label_values;
+
+  // Quantized representation: the value of the class "class_idx" of a leaf
+  // is "quantized_label_buffer[label_buffer_offset + class_idx] *
+  // label_buffer_scales[label_buffer_offset / num_classes]". Built by
+  // "QuantizeLeafValues". Lossy.
+  std::vector<int8_t> quantized_label_buffer;
+  std::vector<float> label_buffer_scales;
+
   // Buffer of categorical mask to use for categorical condition.
   std::vector<bool> categorical_mask_buffer;
 
+  // Buffer of bitsets, packed in 64-bit words, for categorical-set
+  // conditions. The mask of a condition is compiled into
+  // "ceil((vocab_size+1)/64)" consecutive words starting at the node's
+  // "categorical_contains_buffer_offset". Bit "value+1" is set iif the
+  // condition contains "value"; bit 0 stores the evaluation for the missing
+  // value (-1).
+  std::vector<uint64_t> categorical_set_bitset_buffer;
+
   // Buffer for oblique projection splits. See "GenericNode" for the
   // documentation about these fields.
   std::vector<float> oblique_weights;
   std::vector<typename Node::FeatureIdx> oblique_internal_feature_idxs;
 
+  // Maximum depth over all the trees. A tree reduced to its root has depth 0.
+  // -1 if the model is empty or the depth is unknown. Shallow numerical-only
+  // models are served with a fixed-depth traversal selected from this value.
+  int32_t max_depth = -1;
+
   model::proto::Metadata metadata;
 };
 
@@ -349,6 +424,87 @@ struct GradientBoostedTreesRankingNumericalAndCategorical
   float initial_predictions = 0.f;
 };
 
+// A decision forest with numerical-only input features quantized to at most
+// 256 bins per feature at engine compilation time.
+//
+// The quantization is loss-less: for each feature, the bins are delimited by
+// the unique thresholds effectively tested by the model, so the quantized
+// model returns exactly the same predictions as the non-quantized one. The
+// nodes are 4 bytes (instead of 8 for "OneDimensionOutputNumericalFeatureNode"
+// and 12 for "GenericNode"), so much more of the model fits in cache.
+//
+// Constraints: at most 256 input features, at most 255 unique thresholds per
+// feature, and at most 65536 unique leaf values.
+struct QuantizedNumericalFlatModel {
+  using NodeType = QuantizedOneDimensionOutputNumericalFeatureNode;
+  using ValueType = float;
+  using FeaturesDefinition = FeaturesDefinitionNumericalOrCategoricalFlat;
+
+  const FeaturesDefinition& features() const { return internal_features; }
+
+  FeaturesDefinition* mutable_features() { return &internal_features; }
+
+  // The list of nodes in the model.
+  std::vector<NodeType> nodes;
+  // The indices (in "nodes") of the root nodes.
+  std::vector<int32_t> root_offsets;
+
+  // Index of the leaf represented by each node, aligned with "nodes". See
+  // "FlatNodeModel::leaf_idxs".
+  std::vector<int32_t> leaf_idxs;
+
+  // Output values of the leaves. Indexed by "leaf_value_idx()".
+  std::vector<float> leaf_values;
+
+  // Sorted unique thresholds of each feature, indexed by the internal feature
+  // index. The quantized value of "x" for the feature "f" is the number of
+  // values in "bin_boundaries[f]" that are lower or equal to "x".
+  std::vector<std::vector<float>> bin_boundaries;
+
+  // Maximum depth over all the trees. A tree reduced to its root has depth 0.
+  // -1 if the model is empty. See "FlatNodeModel::max_depth".
+  int32_t max_depth = -1;
+
+  FeaturesDefinition internal_features;
+
+  model::proto::Metadata metadata;
+};
+
+// Quantized Random Forest model for binary classification with numerical input
+// features.
+struct QuantizedRandomForestBinaryClassificationNumericalOnly
+    : QuantizedNumericalFlatModel {
+  static constexpr model::proto::Task kTask =
+      model::proto::Task::CLASSIFICATION;
+};
+
+// Quantized Random Forest model for regression with numerical input features.
+struct QuantizedRandomForestRegressionNumericalOnly
+    : QuantizedNumericalFlatModel {
+  static constexpr model::proto::Task kTask = model::proto::Task::REGRESSION;
+};
+
+// Quantized Gradient Boosted Trees model for binary classification with
+// numerical input features.
+struct QuantizedGradientBoostedTreesBinaryClassificationNumericalOnly
+    : QuantizedNumericalFlatModel {
+  static constexpr model::proto::Task kTask =
+      model::proto::Task::CLASSIFICATION;
+  // Output of the model before any tree is applied, and before the final
+  // activation function.
+  float initial_predictions = 0.f;
+};
+
+// Quantized Gradient Boosted Trees model for regression with numerical input
+// features.
+struct QuantizedGradientBoostedTreesRegressionNumericalOnly
+    : QuantizedNumericalFlatModel {
+  static constexpr model::proto::Task kTask = model::proto::Task::REGRESSION;
+  // Output of the model before any tree is applied, and before the final
+  // activation function.
+  float initial_predictions = 0.f;
+};
+
 // Models using the ExampleSet API.
 // "NodeIndex" is the precision required to store a node offset in a
 // single tree. This offset is bounded by the number of nodes in a tree (and
@@ -463,6 +619,111 @@ template <typename Model>
 void Predict(const Model& model, const typename Model::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions);
 
+// Applies the model on a set of examples and stores, for each example and each
+// tree, the index of the active leaf (following the leaf numbering of
+// "leaf_idxs"). "leaves" should contain exactly "num_examples x num_trees"
+// elements, stored example-major tree-minor. See "FastEngine::GetLeaves".
+template <typename Model>
+absl::Status GetLeaves(const Model& model,
+                       const typename Model::ExampleSet& examples,
+                       int num_examples, absl::Span<int32_t> leaves);
+
+// Applies a multi-dimensional-output model (e.g. multi-class classification)
+// on a set of examples and returns, for each example, the "k" highest
+// scoring classes in decreasing score order, without materializing the dense
+// per-class output.
+//
+// After the call, "classes" and "scores" contain "num_examples x k" values,
+// stored example-major. "k" is capped to the number of classes.
+//
+// The scores are the raw class accumulations (e.g. vote ratios for a Random
+// Forest, logits for a GBT). The final activation (e.g. softmax) is monotone
+// per class and therefore does not change the ranking; skipping it (and the
+// dense output) dominates the saving when the number of classes is large and
+// the caller only consumes the top classes.
+template <typename Model>
+void PredictTopK(const Model& model, const typename Model::ExampleSet& examples,
+                 int num_examples, int k, std::vector<int32_t>* classes,
+                 std::vector<float>* scores);
+
+// Checks that two feature definitions consume exactly the same input features,
+// mapped to the same internal indices.
+absl::Status CheckSameInputFeatures(
+    const FeaturesDefinitionNumericalOrCategoricalFlat& a,
+    const FeaturesDefinitionNumericalOrCategoricalFlat& b);
+
+// Scores several models sharing the same input features in a single pass over
+// a batch of examples.
+//
+// During the inference, the tree traversals of the different models are
+// interleaved: for each example, the i-th tree of every model is visited
+// before the (i+1)-th tree of any model. The feature values of the example are
+// therefore re-used while hot in cache, which is faster than calling "Predict"
+// once per model (e.g. when scoring several variations of a model during an
+// A/B test).
+//
+// All the models should consume exactly the same input features (e.g. models
+// trained on the same dataset with the same features).
+//
+// Usage example:
+//
+//   MultiScorer<GradientBoostedTreesRegression> scorer;
+//   CHECK_OK(scorer.AddModel(model_a));
+//   CHECK_OK(scorer.AddModel(model_b));
+//   MultiScorer<GradientBoostedTreesRegression>::ExampleSet examples(
+//     5, scorer.models().front());
+//   ... set the feature values using "scorer.features()" ...
+//   std::vector<float> predictions;
+//   CHECK_OK(scorer.Predict(examples, 5, &predictions));
+//
+template <typename Model>
+class MultiScorer {
+ public:
+  using ExampleSet = typename Model::ExampleSet;
+
+  // Compiles "src" and adds it to the set of co-scored models. Returns an
+  // error if "src" is not compatible with this engine, or if it does not
+  // consume the same input features as the previously added models.
+  template <typename SourceModel>
+  absl::Status AddModel(const SourceModel& src) {
+    Model dst;
+    const auto convert_status = GenericToSpecializedModel(src, &dst);
+    if (!convert_status.ok()) {
+      return convert_status;
+    }
+    if (!models_.empty()) {
+      const auto feature_status = CheckSameInputFeatures(
+          models_.front().features(), dst.features());
+      if (!feature_status.ok()) {
+        return feature_status;
+      }
+    }
+    models_.push_back(std::move(dst));
+    return absl::OkStatus();
+  }
+
+  // Number of co-scored models.
+  int num_models() const { return models_.size(); }
+
+  // Compiled models.
+  const std::vector<Model>& models() const { return models_; }
+
+  // Feature definition shared by all the models. Should only be called after
+  // at least one model was added.
+  const typename Model::FeaturesDefinition& features() const {
+    return models_.front().features();
+  }
+
+  // Applies all the models on a set of examples. After the call, "predictions"
+  // contains "num_examples x num_models()" values, stored example-major
+  // model-minor.
+  absl::Status Predict(const ExampleSet& examples, int num_examples,
+                       std::vector<float>* predictions) const;
+
+ private:
+  std::vector<Model> models_;
+};
+
 // Converts a generic model into a specialized model.
 //
 // Returns an error if the model is not compatible.
@@ -511,6 +772,22 @@ absl::Status GenericToSpecializedModel(
     const model::gradient_boosted_trees::GradientBoostedTreesModel& src,
     GradientBoostedTreesRankingNumericalAndCategorical* dst);
 
+absl::Status GenericToSpecializedModel(
+    const model::random_forest::RandomForestModel& src,
+    QuantizedRandomForestBinaryClassificationNumericalOnly* dst);
+
+absl::Status GenericToSpecializedModel(
+    const model::random_forest::RandomForestModel& src,
+    QuantizedRandomForestRegressionNumericalOnly* dst);
+
+absl::Status GenericToSpecializedModel(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& src,
+    QuantizedGradientBoostedTreesBinaryClassificationNumericalOnly* dst);
+
+absl::Status GenericToSpecializedModel(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& src,
+    QuantizedGradientBoostedTreesRegressionNumericalOnly* dst);
+
 // Generates the predictions of a model on a batch of examples.
 //
 // Args:
@@ -554,6 +831,27 @@ void Predict(
     const std::vector<NumericalOrCategoricalValue>& examples, int num_examples,
     std::vector<float>* predictions);
 
+// Early-exit variants of "Predict" for binary classification random forests:
+// the trees are accumulated in order and, every few trees, the accumulation
+// stops if the remaining trees cannot move the prediction to the other side
+// of the 0.5 decision threshold. The decision (predicted probability compared
+// to 0.5) is guaranteed to be the same as with "Predict", but the returned
+// probability is the vote average of the evaluated trees only, so it can
+// differ from the full-forest probability. Most effective when the trees are
+// ordered from most to least decisive (see
+// "RandomForestModel::ReorderTreesByDecisiveness" and the
+// --reorder_trees_by_decisiveness flag of cli/edit_model).
+void PredictEarlyExit(
+    const RandomForestBinaryClassificationNumericalFeatures& model,
+    const std::vector<float>& examples, int num_examples,
+    std::vector<float>* predictions);
+
+void PredictEarlyExit(
+    const RandomForestBinaryClassificationNumericalAndCategoricalFeatures&
+        model,
+    const std::vector<NumericalOrCategoricalValue>& examples, int num_examples,
+    std::vector<float>* predictions);
+
 void Predict(const GradientBoostedTreesBinaryClassificationNumericalOnly& model,
              const std::vector<float>& examples, int num_examples,
              std::vector<float>* predictions);
@@ -588,6 +886,34 @@ void Predict(const GradientBoostedTreesRankingNumericalAndCategorical& model,
              const std::vector<NumericalOrCategoricalValue>& examples,
              int num_examples, std::vector<float>* predictions);
 
+// The "Predict" functions of the quantized models quantize the input examples
+// (with "QuantizeExamples") and then run the trees on uint8 bin indices. The
+// predictions are bit-exact with the non-quantized engines.
+
+void Predict(const QuantizedRandomForestBinaryClassificationNumericalOnly&
+                 model,
+             const std::vector<float>& examples, int num_examples,
+             std::vector<float>* predictions);
+
+void Predict(const QuantizedRandomForestRegressionNumericalOnly& model,
+             const std::vector<float>& examples, int num_examples,
+             std::vector<float>* predictions);
+
+void Predict(
+    const QuantizedGradientBoostedTreesBinaryClassificationNumericalOnly& model,
+    const std::vector<float>& examples, int num_examples,
+    std::vector<float>* predictions);
+
+void Predict(const QuantizedGradientBoostedTreesRegressionNumericalOnly& model,
+             const std::vector<float>& examples, int num_examples,
+             std::vector<float>* predictions);
+
+// Quantizes a batch of example-major examples into per-feature bin indices.
+// "quantized_examples" has the same example-major layout as "examples".
+void QuantizeExamples(const QuantizedNumericalFlatModel& model,
+                      const std::vector<float>& examples, int num_examples,
+                      std::vector<uint8_t>* quantized_examples);
+
 template <typename Model>
 void PredictWithExampleSet(const Model& model,
                            const typename Model::ExampleSet& examples,
@@ -596,6 +922,46 @@ void PredictWithExampleSet(const Model& model,
           predictions);
 }
 
+// Quantizes the multi-dimensional leaf values of a compiled model (e.g. a
+// multi-class classification or categorical uplift Random Forest) to int8
+// codes with a per-leaf scale, dividing the leaf-value memory by ~4.
+//
+// The quantization is lossy: each leaf value is rounded to the nearest
+// multiple of "max abs value of the leaf / 127" i.e. the per-tree
+// contribution to a prediction changes by at most ~0.4% of the leaf's
+// largest value. Does nothing if the leaf values are already compressed
+// (e.g. the one-hot representation of winner-take-all Random Forests, which
+// is loss-less and more compact).
+template <typename Model>
+void QuantizeLeafValues(Model* model) {
+  if (model->label_buffer.empty() || model->num_classes <= 0) {
+    return;
+  }
+  const int num_classes = model->num_classes;
+  const size_t num_leaves = model->label_buffer.size() / num_classes;
+  model->quantized_label_buffer.resize(model->label_buffer.size());
+  model->label_buffer_scales.resize(num_leaves);
+  for (size_t leaf_idx = 0; leaf_idx < num_leaves; leaf_idx++) {
+    const float* const values = &model->label_buffer[leaf_idx * num_classes];
+    float max_abs_value = 0.f;
+    for (int class_idx = 0; class_idx < num_classes; class_idx++) {
+      max_abs_value = std::max(max_abs_value, std::abs(values[class_idx]));
+    }
+    const float scale = max_abs_value / 127.f;
+    model->label_buffer_scales[leaf_idx] = scale;
+    int8_t* const codes =
+        &model->quantized_label_buffer[leaf_idx * num_classes];
+    for (int class_idx = 0; class_idx < num_classes; class_idx++) {
+      codes[class_idx] =
+          (scale > 0)
+              ? static_cast<int8_t>(std::lround(values[class_idx] / scale))
+              : 0;
+    }
+  }
+  model->label_buffer.clear();
+  model->label_buffer.shrink_to_fit();
+}
+
 // Note: Requires for the number of trees to be a multiple of 8.
 void PredictOptimizedV1(
     const RandomForestBinaryClassificationNumericalFeatures& model,
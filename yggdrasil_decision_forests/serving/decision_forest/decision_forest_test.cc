@@ -16,8 +16,10 @@
 #include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"
 
 #include <algorithm>
+#include <cmath>
 #include <map>
 #include <memory>
+#include <numeric>
 #include <utility>
 
 #include "gmock/gmock.h"
@@ -28,6 +30,7 @@
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset_io.h"
@@ -38,6 +41,7 @@
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
 #include "yggdrasil_decision_forests/model/model_library.h"
 #include "yggdrasil_decision_forests/model/prediction.pb.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
 #include "yggdrasil_decision_forests/serving/decision_forest/quick_scorer_extended.h"
 #include "yggdrasil_decision_forests/utils/csv.h"
 #include "yggdrasil_decision_forests/utils/distribution.pb.h"
@@ -202,6 +206,365 @@ TEST(SpecializedRandomForestTest,
   EXPECT_THAT(predictions, ElementsAre(1.f, 0.f));
 }
 
+TEST(SpecializedRandomForestTest, FixedDepthTraversalUnbalancedTree) {
+  // Unbalanced tree: the negative child of the root is a leaf (depth 1) while
+  // the positive subtree has depth 2. The fixed-depth traversal walks
+  // "max_depth" levels on every path and should stay on the early leaf.
+  model::random_forest::RandomForestModel rf_model;
+  auto tree = absl::make_unique<model::decision_tree::DecisionTree>();
+  tree->CreateRoot();
+  tree->mutable_root()->CreateChildren();
+  tree->mutable_root()->mutable_node()->mutable_condition()->set_attribute(0);
+  tree->mutable_root()
+      ->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(2.f);
+  tree->mutable_root()
+      ->mutable_neg_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(2);
+  auto* pos_child = tree->mutable_root()->mutable_pos_child();
+  pos_child->CreateChildren();
+  pos_child->mutable_node()->mutable_condition()->set_attribute(0);
+  pos_child->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(4.f);
+  pos_child->mutable_neg_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(2);
+  pos_child->mutable_pos_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(1);
+  rf_model.AddTree(std::move(tree));
+  rf_model.set_task(model::proto::Task::CLASSIFICATION);
+  rf_model.set_label_col_idx(1);
+  rf_model.mutable_input_features()->push_back(0);
+
+  auto* col_0 = rf_model.mutable_data_spec()->add_columns();
+  col_0->set_name("f");
+  col_0->set_type(dataset::proto::ColumnType::NUMERICAL);
+
+  auto* label = rf_model.mutable_data_spec()->add_columns();
+  label->set_name("label");
+  label->set_type(dataset::proto::ColumnType::CATEGORICAL);
+  label->mutable_categorical()->set_number_of_unique_values(3);
+
+  RandomForestBinaryClassificationNumericalFeatures flat_model;
+  CHECK_OK(GenericToSpecializedModel(rf_model, &flat_model));
+  EXPECT_EQ(flat_model.max_depth, 2);
+
+  const std::vector<float> flat_examples = {1.f, 3.f, 5.f};
+  std::vector<float> predictions;
+  Predict(flat_model, flat_examples, 3, &predictions);
+
+  EXPECT_THAT(predictions, ElementsAre(1.f, 1.f, 0.f));
+}
+
+TEST(SpecializedRandomForestTest,
+     QuantizedBinaryClassificationNumericalOnly) {
+  model::random_forest::RandomForestModel rf_model;
+  auto tree = absl::make_unique<model::decision_tree::DecisionTree>();
+  tree->CreateRoot();
+  tree->mutable_root()->CreateChildren();
+  tree->mutable_root()->mutable_node()->mutable_condition()->set_attribute(1);
+  tree->mutable_root()
+      ->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(2.f);
+  tree->mutable_root()
+      ->mutable_pos_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(1);
+  tree->mutable_root()
+      ->mutable_neg_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(2);
+  rf_model.AddTree(std::move(tree));
+  rf_model.set_task(model::proto::Task::CLASSIFICATION);
+  rf_model.set_label_col_idx(3);
+  rf_model.mutable_input_features()->push_back(1);
+
+  auto* col_0 = rf_model.mutable_data_spec()->add_columns();
+  col_0->set_name("col_0");
+  col_0->set_type(dataset::proto::ColumnType::NUMERICAL);
+  col_0->mutable_numerical()->set_mean(3.f);
+
+  auto* col_1 = rf_model.mutable_data_spec()->add_columns();
+  col_1->set_name("col_1");
+  col_1->set_type(dataset::proto::ColumnType::NUMERICAL);
+  col_1->mutable_numerical()->set_mean(4.f);
+
+  auto* label = rf_model.mutable_data_spec()->add_columns();
+  label->set_name("label");
+  label->set_type(dataset::proto::ColumnType::CATEGORICAL);
+  label->mutable_categorical()->set_number_of_unique_values(3);
+
+  QuantizedRandomForestBinaryClassificationNumericalOnly quantized_model;
+  CHECK_OK(GenericToSpecializedModel(rf_model, &quantized_model));
+
+  EXPECT_EQ(quantized_model.nodes.size(), 3);
+  EXPECT_THAT(quantized_model.bin_boundaries,
+              ElementsAre(ElementsAre(2.f)));
+  EXPECT_THAT(quantized_model.leaf_values, ElementsAre(1.f, 0.f));
+
+  // The single boundary (threshold 2.f) splits the values in two bins.
+  std::vector<uint8_t> quantized_examples;
+  QuantizeExamples(quantized_model, {1.f, 2.f, 3.f}, 3, &quantized_examples);
+  EXPECT_THAT(quantized_examples, ElementsAre(0, 1, 1));
+
+  std::vector<float> predictions;
+  Predict(quantized_model, {1.f, 3.f}, 2, &predictions);
+  EXPECT_THAT(predictions, ElementsAre(1.f, 0.f));
+}
+
+TEST(SpecializedRandomForestTest, GetLeaves) {
+  // A single tree with three leaves:
+  //   "col_1">=2
+  //     ├─(neg)─ leaf #0
+  //     └─(pos)─ "col_1">=3
+  //                ├─(neg)─ leaf #1
+  //                └─(pos)─ leaf #2
+  model::random_forest::RandomForestModel rf_model;
+  auto tree = absl::make_unique<model::decision_tree::DecisionTree>();
+  tree->CreateRoot();
+  tree->mutable_root()->CreateChildren();
+  tree->mutable_root()->mutable_node()->mutable_condition()->set_attribute(1);
+  tree->mutable_root()
+      ->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(2.f);
+  tree->mutable_root()
+      ->mutable_neg_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(2);
+  auto* pos_child = tree->mutable_root()->mutable_pos_child();
+  pos_child->CreateChildren();
+  pos_child->mutable_node()->mutable_condition()->set_attribute(1);
+  pos_child->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(3.f);
+  pos_child->mutable_neg_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(1);
+  pos_child->mutable_pos_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(2);
+  rf_model.AddTree(std::move(tree));
+  rf_model.set_task(model::proto::Task::CLASSIFICATION);
+  rf_model.set_label_col_idx(3);
+  rf_model.mutable_input_features()->push_back(1);
+
+  auto* col_0 = rf_model.mutable_data_spec()->add_columns();
+  col_0->set_name("col_0");
+  col_0->set_type(dataset::proto::ColumnType::NUMERICAL);
+  col_0->mutable_numerical()->set_mean(3.f);
+
+  auto* col_1 = rf_model.mutable_data_spec()->add_columns();
+  col_1->set_name("col_1");
+  col_1->set_type(dataset::proto::ColumnType::NUMERICAL);
+  col_1->mutable_numerical()->set_mean(4.f);
+
+  auto* label = rf_model.mutable_data_spec()->add_columns();
+  label->set_name("label");
+  label->set_type(dataset::proto::ColumnType::CATEGORICAL);
+  label->mutable_categorical()->set_number_of_unique_values(3);
+
+  RandomForestBinaryClassification engine_model;
+  CHECK_OK(GenericToSpecializedModel(rf_model, &engine_model));
+
+  // Layout: root, leaf #0, "col_1">=3, leaf #1, leaf #2. The leaves are
+  // numbered following the depth first exploration of the source tree.
+  EXPECT_THAT(engine_model.leaf_idxs, ElementsAre(-1, 0, -1, 1, 2));
+
+  RandomForestBinaryClassification::ExampleSet examples(3, engine_model);
+  examples.FillMissing(engine_model);
+  const auto feature =
+      RandomForestBinaryClassification::ExampleSet::GetNumericalFeatureId(
+          "col_1", engine_model)
+          .value();
+  examples.SetNumerical(0, feature, 1.f, engine_model);
+  examples.SetNumerical(1, feature, 2.5f, engine_model);
+  examples.SetNumerical(2, feature, 4.f, engine_model);
+
+  std::vector<int32_t> leaves(3);
+  CHECK_OK(GetLeaves(engine_model, examples, 3, absl::MakeSpan(leaves)));
+  EXPECT_THAT(leaves, ElementsAre(0, 1, 2));
+
+  // Wrongly sized destination.
+  EXPECT_FALSE(
+      GetLeaves(engine_model, examples, 3, absl::MakeSpan(leaves).subspan(1))
+          .ok());
+}
+
+TEST(SpecializedRandomForestTest, CategoricalSetContainsBitset) {
+  // A single stump testing "tags intersects {5, 66}" over a vocabulary of 70
+  // items i.e. a condition bitset of two 64-bit words.
+  model::random_forest::RandomForestModel rf_model;
+  auto tree = absl::make_unique<model::decision_tree::DecisionTree>();
+  tree->CreateRoot();
+  tree->mutable_root()->CreateChildren();
+  tree->mutable_root()->mutable_node()->mutable_condition()->set_attribute(1);
+  tree->mutable_root()->mutable_node()->mutable_condition()->set_na_value(true);
+  auto* contains = tree->mutable_root()
+                       ->mutable_node()
+                       ->mutable_condition()
+                       ->mutable_condition()
+                       ->mutable_contains_condition();
+  contains->add_elements(5);
+  contains->add_elements(66);
+  tree->mutable_root()
+      ->mutable_neg_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(1);
+  tree->mutable_root()
+      ->mutable_pos_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(2);
+  rf_model.AddTree(std::move(tree));
+  rf_model.set_task(model::proto::Task::CLASSIFICATION);
+  rf_model.set_label_col_idx(2);
+  rf_model.mutable_input_features()->push_back(1);
+
+  auto* col_0 = rf_model.mutable_data_spec()->add_columns();
+  col_0->set_name("col_0");
+  col_0->set_type(dataset::proto::ColumnType::NUMERICAL);
+  col_0->mutable_numerical()->set_mean(3.f);
+
+  auto* tags = rf_model.mutable_data_spec()->add_columns();
+  tags->set_name("tags");
+  tags->set_type(dataset::proto::ColumnType::CATEGORICAL_SET);
+  tags->mutable_categorical()->set_number_of_unique_values(70);
+
+  auto* label = rf_model.mutable_data_spec()->add_columns();
+  label->set_name("label");
+  label->set_type(dataset::proto::ColumnType::CATEGORICAL);
+  label->mutable_categorical()->set_number_of_unique_values(3);
+
+  RandomForestBinaryClassification engine_model;
+  CHECK_OK(GenericToSpecializedModel(rf_model, &engine_model));
+
+  // Bit "value+1" represents "value"; bit 0 is the missing value evaluation
+  // ("na_value" is true).
+  EXPECT_THAT(engine_model.categorical_set_bitset_buffer,
+              ElementsAre((uint64_t{1} << 6) | 1, uint64_t{1} << 3));
+
+  RandomForestBinaryClassification::ExampleSet examples(5, engine_model);
+  examples.FillMissing(engine_model);
+  const auto feature =
+      RandomForestBinaryClassification::ExampleSet::GetCategoricalSetFeatureId(
+          "tags", engine_model)
+          .value();
+  examples.SetCategoricalSet(0, feature, std::vector<int>{5}, engine_model);
+  examples.SetCategoricalSet(1, feature, std::vector<int>{7, 66},
+                             engine_model);
+  examples.SetCategoricalSet(2, feature, std::vector<int>{7, 9}, engine_model);
+  examples.SetCategoricalSet(3, feature, std::vector<int>{}, engine_model);
+  examples.SetMissingCategoricalSet(4, feature, engine_model);
+
+  std::vector<float> predictions;
+  Predict(engine_model, examples, 5, &predictions);
+  EXPECT_THAT(predictions, ElementsAre(1.f, 1.f, 0.f, 0.f, 1.f));
+}
+
+TEST(MultiScorer, TwoRandomForestRegressions) {
+  // Builds a Random Forest with a single stump testing "col_1 >= threshold".
+  const auto build_model = [](const float threshold, const float neg_value,
+                              const float pos_value, const int attribute) {
+    model::random_forest::RandomForestModel rf_model;
+    auto tree = absl::make_unique<model::decision_tree::DecisionTree>();
+    tree->CreateRoot();
+    tree->mutable_root()->CreateChildren();
+    tree->mutable_root()->mutable_node()->mutable_condition()->set_attribute(
+        attribute);
+    tree->mutable_root()
+        ->mutable_node()
+        ->mutable_condition()
+        ->mutable_condition()
+        ->mutable_higher_condition()
+        ->set_threshold(threshold);
+    tree->mutable_root()
+        ->mutable_neg_child()
+        ->mutable_node()
+        ->mutable_regressor()
+        ->set_top_value(neg_value);
+    tree->mutable_root()
+        ->mutable_pos_child()
+        ->mutable_node()
+        ->mutable_regressor()
+        ->set_top_value(pos_value);
+    rf_model.AddTree(std::move(tree));
+    rf_model.set_task(model::proto::Task::REGRESSION);
+    rf_model.set_label_col_idx(2);
+    rf_model.mutable_input_features()->push_back(attribute);
+
+    auto* col_0 = rf_model.mutable_data_spec()->add_columns();
+    col_0->set_name("col_0");
+    col_0->set_type(dataset::proto::ColumnType::NUMERICAL);
+    col_0->mutable_numerical()->set_mean(3.f);
+
+    auto* col_1 = rf_model.mutable_data_spec()->add_columns();
+    col_1->set_name("col_1");
+    col_1->set_type(dataset::proto::ColumnType::NUMERICAL);
+    col_1->mutable_numerical()->set_mean(4.f);
+
+    auto* label = rf_model.mutable_data_spec()->add_columns();
+    label->set_name("label");
+    label->set_type(dataset::proto::ColumnType::NUMERICAL);
+    label->mutable_numerical()->set_mean(0.f);
+
+    return rf_model;
+  };
+
+  MultiScorer<RandomForestRegression> scorer;
+  CHECK_OK(scorer.AddModel(
+      build_model(/*threshold=*/2.f, /*neg_value=*/1.f, /*pos_value=*/2.f,
+                  /*attribute=*/1)));
+  CHECK_OK(scorer.AddModel(
+      build_model(/*threshold=*/3.f, /*neg_value=*/10.f, /*pos_value=*/20.f,
+                  /*attribute=*/1)));
+  EXPECT_EQ(scorer.num_models(), 2);
+
+  // A model consuming a different input feature is rejected.
+  EXPECT_FALSE(scorer
+                   .AddModel(build_model(/*threshold=*/2.f, /*neg_value=*/1.f,
+                                         /*pos_value=*/2.f, /*attribute=*/0))
+                   .ok());
+
+  MultiScorer<RandomForestRegression>::ExampleSet examples(
+      2, scorer.models().front());
+  examples.FillMissing(scorer.models().front());
+  const auto feature =
+      MultiScorer<RandomForestRegression>::ExampleSet::GetNumericalFeatureId(
+          "col_1", scorer.models().front())
+          .value();
+  examples.SetNumerical(0, feature, 1.f, scorer.models().front());
+  examples.SetNumerical(1, feature, 4.f, scorer.models().front());
+
+  std::vector<float> predictions;
+  CHECK_OK(scorer.Predict(examples, 2, &predictions));
+  EXPECT_THAT(predictions, ElementsAre(1.f, 10.f, 2.f, 20.f));
+}
+
 struct AllCompatibleEnginesTestParams {
   const std::string model;
   const std::string dataset;
@@ -310,6 +673,38 @@ TEST(AdultBinaryClassRF, ManualNum) {
       dataset, *model, engine);
 }
 
+TEST(AdultBinaryClassRF, PredictEarlyExit) {
+  const auto model = LoadModel("adult_binary_class_rf_only_num");
+  const auto dataset = LoadDataset(model->data_spec(), "adult_test.csv", "csv");
+
+  auto* rf_model = dynamic_cast<RandomForestModel*>(model.get());
+  // Reordering the trees does not change the predictions.
+  CHECK_OK(rf_model->ReorderTreesByDecisiveness());
+
+  RandomForestBinaryClassificationNumericalFeatures engine;
+  CHECK_OK(GenericToSpecializedModel(*rf_model, &engine));
+  utils::ExpectEqualPredictionsOldTemplate<decltype(engine), Predict>(
+      dataset, *model, engine);
+
+  // The early-exit predictions are on the same side of the decision
+  // threshold as the exact predictions.
+  const int num_examples = dataset.nrow();
+  std::vector<float> examples;
+  CHECK_OK(LoadFlatBatchFromDataset(
+      dataset, 0, num_examples,
+      FeatureNames(engine.features().fixed_length_features()),
+      engine.features().fixed_length_na_replacement_values(), &examples));
+  std::vector<float> exact_predictions;
+  std::vector<float> early_exit_predictions;
+  Predict(engine, examples, num_examples, &exact_predictions);
+  PredictEarlyExit(engine, examples, num_examples, &early_exit_predictions);
+  ASSERT_EQ(early_exit_predictions.size(), exact_predictions.size());
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    EXPECT_EQ(exact_predictions[example_idx] > 0.5f,
+              early_exit_predictions[example_idx] > 0.5f);
+  }
+}
+
 TEST(IrisMulticlassClassGBDT, ManualGeneric) {
   const auto model = LoadModel("iris_multi_class_gbdt");
   const auto dataset = LoadDataset(model->data_spec(), "iris.csv", "csv");
@@ -334,6 +729,122 @@ TEST(IrisMulticlassClassRF, ManualGeneric) {
       dataset, *model, engine);
 }
 
+TEST(IrisMulticlassClassRF, OneHotLeafValues) {
+  const auto model = LoadModel("iris_multi_class_rf");
+  auto* rf_model = dynamic_cast<RandomForestModel*>(model.get());
+  ASSERT_TRUE(rf_model->winner_take_all_inference());
+
+  RandomForestMulticlassClassification engine;
+  CHECK_OK(GenericToSpecializedModel(*rf_model, &engine));
+
+  // The winner-take-all votes are stored one-hot instead of as dense
+  // "num_classes" value vectors.
+  EXPECT_TRUE(engine.label_buffer.empty());
+  EXPECT_FALSE(engine.one_hot_label_classes.empty());
+  EXPECT_EQ(engine.one_hot_label_classes.size(),
+            engine.one_hot_label_values.size());
+}
+
+TEST(IrisMulticlassClassRF, QuantizedLeafValues) {
+  const auto model = LoadModel("iris_multi_class_rf");
+  const auto dataset = LoadDataset(model->data_spec(), "iris.csv", "csv");
+  auto* rf_model = dynamic_cast<RandomForestModel*>(model.get());
+  // Use the dense distribution leaves (the winner-take-all votes are already
+  // compressed one-hot).
+  rf_model->set_winner_take_all_inference(false);
+
+  RandomForestMulticlassClassification engine;
+  CHECK_OK(GenericToSpecializedModel(*rf_model, &engine));
+  ASSERT_FALSE(engine.label_buffer.empty());
+
+  const auto examples = VerticalDatasetToExampleSet(dataset, engine).value();
+  std::vector<float> predictions;
+  Predict(engine, examples, dataset.nrow(), &predictions);
+
+  const auto dense_size = engine.label_buffer.size();
+  QuantizeLeafValues(&engine);
+  EXPECT_TRUE(engine.label_buffer.empty());
+  EXPECT_EQ(engine.quantized_label_buffer.size(), dense_size);
+  EXPECT_EQ(engine.label_buffer_scales.size(),
+            dense_size / engine.num_classes);
+
+  std::vector<float> quantized_predictions;
+  Predict(engine, examples, dataset.nrow(), &quantized_predictions);
+
+  ASSERT_EQ(quantized_predictions.size(), predictions.size());
+  for (size_t prediction_idx = 0; prediction_idx < predictions.size();
+       prediction_idx++) {
+    EXPECT_NEAR(quantized_predictions[prediction_idx],
+                predictions[prediction_idx], 0.005f);
+  }
+}
+
+TEST(IrisMulticlassClassRF, PredictTopK) {
+  const auto model = LoadModel("iris_multi_class_rf");
+  const auto dataset = LoadDataset(model->data_spec(), "iris.csv", "csv");
+  auto* rf_model = dynamic_cast<RandomForestModel*>(model.get());
+
+  RandomForestMulticlassClassification engine;
+  CHECK_OK(GenericToSpecializedModel(*rf_model, &engine));
+
+  const auto examples = VerticalDatasetToExampleSet(dataset, engine).value();
+  std::vector<float> predictions;
+  Predict(engine, examples, dataset.nrow(), &predictions);
+
+  const int k = 2;
+  std::vector<int32_t> top_classes;
+  std::vector<float> top_scores;
+  PredictTopK(engine, examples, dataset.nrow(), k, &top_classes, &top_scores);
+  ASSERT_EQ(top_classes.size(), dataset.nrow() * k);
+  ASSERT_EQ(top_scores.size(), dataset.nrow() * k);
+
+  for (int example_idx = 0; example_idx < dataset.nrow(); example_idx++) {
+    // Stable arg-sort of the dense prediction. The "Clamp01" activation is a
+    // no-op on the vote ratios, so the dense scores are directly comparable.
+    const float* dense = &predictions[example_idx * engine.num_classes];
+    std::vector<int32_t> expected_order(engine.num_classes);
+    std::iota(expected_order.begin(), expected_order.end(), 0);
+    std::stable_sort(expected_order.begin(), expected_order.end(),
+                     [&](const int32_t a, const int32_t b) {
+                       return dense[a] > dense[b];
+                     });
+    for (int top_idx = 0; top_idx < k; top_idx++) {
+      EXPECT_EQ(top_classes[example_idx * k + top_idx],
+                expected_order[top_idx]);
+      EXPECT_EQ(top_scores[example_idx * k + top_idx],
+                dense[expected_order[top_idx]]);
+    }
+  }
+}
+
+TEST(IrisMulticlassClassGBDT, PredictTopK) {
+  const auto model = LoadModel("iris_multi_class_gbdt");
+  const auto dataset = LoadDataset(model->data_spec(), "iris.csv", "csv");
+  auto* gbt_model = dynamic_cast<GradientBoostedTreesModel*>(model.get());
+
+  GradientBoostedTreesMulticlassClassification engine;
+  CHECK_OK(GenericToSpecializedModel(*gbt_model, &engine));
+
+  const auto examples = VerticalDatasetToExampleSet(dataset, engine).value();
+  std::vector<float> predictions;
+  Predict(engine, examples, dataset.nrow(), &predictions);
+
+  std::vector<int32_t> top_classes;
+  std::vector<float> top_scores;
+  PredictTopK(engine, examples, dataset.nrow(), /*k=*/1, &top_classes,
+              &top_scores);
+  ASSERT_EQ(top_classes.size(), dataset.nrow());
+
+  // The softmax is strictly increasing per class: the top class of the raw
+  // logits matches the top class of the dense probabilities.
+  for (int example_idx = 0; example_idx < dataset.nrow(); example_idx++) {
+    const float* dense = &predictions[example_idx * engine.num_classes];
+    const int32_t expected_class =
+        std::max_element(dense, dense + engine.num_classes) - dense;
+    EXPECT_EQ(top_classes[example_idx], expected_class);
+  }
+}
+
 TEST(SimPTECategoricalupliftRF, ManualGeneric) {
   const auto model = LoadModel("sim_pte_categorical_uplift_rf");
   const auto dataset =
@@ -393,6 +904,74 @@ TEST(SpecializedGradientBoostedTreesTest, MoreThan65kNodesPerTrees) {
   EXPECT_OK(model.BuildFastEngine());
 }
 
+TEST(SpecializedGradientBoostedTreesTest, BatchedBinomialActivation) {
+  // A single stump "f">=1 with leaf values -2 and +3, and an initial
+  // prediction of 0.5. The predictions should match the exact sigmoid of the
+  // accumulated values, whether the activation runs vectorized or not.
+  model::gradient_boosted_trees::GradientBoostedTreesModel model;
+
+  auto tree = absl::make_unique<model::decision_tree::DecisionTree>();
+  tree->CreateRoot();
+  tree->mutable_root()->CreateChildren();
+  tree->mutable_root()->mutable_node()->mutable_condition()->set_attribute(0);
+  tree->mutable_root()
+      ->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(1.f);
+  tree->mutable_root()
+      ->mutable_neg_child()
+      ->mutable_node()
+      ->mutable_regressor()
+      ->set_top_value(-2.f);
+  tree->mutable_root()
+      ->mutable_pos_child()
+      ->mutable_node()
+      ->mutable_regressor()
+      ->set_top_value(3.f);
+  model.mutable_decision_trees()->push_back(std::move(tree));
+
+  model.set_task(model::proto::Task::CLASSIFICATION);
+  model.set_label_col_idx(1);
+  model.set_loss(
+      model::gradient_boosted_trees::proto::Loss::BINOMIAL_LOG_LIKELIHOOD);
+  model.set_initial_predictions({0.5f});
+  model.mutable_input_features()->push_back(0);
+
+  auto* feature = model.mutable_data_spec()->add_columns();
+  feature->set_name("f");
+  feature->set_type(dataset::proto::ColumnType::NUMERICAL);
+  feature->mutable_numerical()->set_mean(0.f);
+
+  auto* label = model.mutable_data_spec()->add_columns();
+  label->set_name("l");
+  label->set_type(dataset::proto::ColumnType::CATEGORICAL);
+  label->mutable_categorical()->set_number_of_unique_values(3);
+
+  GradientBoostedTreesBinaryClassificationNumericalOnly engine;
+  CHECK_OK(GenericToSpecializedModel(model, &engine));
+
+  // 19 examples alternating between the two leaves, to exercise both full
+  // SIMD registers and the scalar tail of the batched activation.
+  const int num_examples = 19;
+  std::vector<float> examples(num_examples);
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    examples[example_idx] = (example_idx % 2) ? 2.f : 0.f;
+  }
+
+  std::vector<float> predictions;
+  Predict(engine, examples, num_examples, &predictions);
+
+  ASSERT_EQ(predictions.size(), num_examples);
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    const float accumulator = ((example_idx % 2) ? 3.f : -2.f) + 0.5f;
+    const float expected = 1.f / (1.f + std::exp(-accumulator));
+    EXPECT_NEAR(predictions[example_idx], expected, 1e-6f)
+        << "example #" << example_idx;
+  }
+}
+
 }  // namespace
 }  // namespace decision_forest
 }  // namespace serving
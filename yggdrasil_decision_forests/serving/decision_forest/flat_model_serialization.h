@@ -0,0 +1,373 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Serialization of the compiled (specialized) decision forest models.
+//
+// Compiling a generic model into a specialized model (see
+// "GenericToSpecializedModel") iterates over all the nodes of all the trees
+// and can take tens of seconds for large models. Serializing the compiled
+// model instead makes it possible to compile once offline and to restore the
+// engine at process startup with a few bulk copies: deserialization only
+// copies the node array and re-indexes the feature definitions, it does not
+// look at the individual nodes.
+//
+// Usage example:
+//
+//   GradientBoostedTreesRegression specialized_model;
+//   CHECK_OK(GenericToSpecializedModel(generic_model, &specialized_model));
+//   std::string serialized;
+//   CHECK_OK(SerializeFlatModel(specialized_model, &serialized));
+//   ... store "serialized", restart the process, load "serialized" ...
+//   GradientBoostedTreesRegression restored_model;
+//   CHECK_OK(DeserializeFlatModel(serialized, &restored_model));
+//
+// The format is not stable across library versions, compilers or
+// architectures (the node arrays are stored in their in-memory
+// representation): a serialized model should be consumed by the same binary
+// (or at least, the same toolchain) that produced it. Mismatches are detected
+// with a version and node-size check.
+
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_FLAT_MODEL_SERIALIZATION_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_FLAT_MODEL_SERIALIZATION_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "absl/meta/type_traits.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+
+// Serializes a compiled flat-node model (any of the specialized model structs
+// of decision_forest.h) into a byte string.
+template <typename Model>
+absl::Status SerializeFlatModel(const Model& model, std::string* serialized);
+
+// Restores a compiled flat-node model serialized with "SerializeFlatModel".
+// "Model" should be the same type as the serialized model.
+template <typename Model>
+absl::Status DeserializeFlatModel(absl::string_view serialized, Model* model);
+
+namespace serialization_internal {
+
+constexpr uint32_t kMagic = 0x59444645;  // "YDFE"
+constexpr uint32_t kVersion = 2;
+// Version history:
+//   1: Initial version.
+//   2: Adds the compressed leaf-value buffers (one-hot and int8 quantized).
+
+template <typename T>
+void AppendPod(const T& value, std::string* out) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Non supported value type.");
+  out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+absl::Status ReadPod(absl::string_view* in, T* value) {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Non supported value type.");
+  if (in->size() < sizeof(T)) {
+    return absl::InvalidArgumentError("Truncated serialized model.");
+  }
+  std::memcpy(value, in->data(), sizeof(T));
+  in->remove_prefix(sizeof(T));
+  return absl::OkStatus();
+}
+
+template <typename T>
+void AppendPodVector(const std::vector<T>& values, std::string* out) {
+  AppendPod<uint64_t>(values.size(), out);
+  out->append(reinterpret_cast<const char*>(values.data()),
+              values.size() * sizeof(T));
+}
+
+template <typename T>
+absl::Status ReadPodVector(absl::string_view* in, std::vector<T>* values) {
+  uint64_t size;
+  RETURN_IF_ERROR(ReadPod(in, &size));
+  if (size > in->size() || in->size() < size * sizeof(T)) {
+    return absl::InvalidArgumentError("Truncated serialized model.");
+  }
+  values->resize(size);
+  std::memcpy(values->data(), in->data(), size * sizeof(T));
+  in->remove_prefix(size * sizeof(T));
+  return absl::OkStatus();
+}
+
+inline void AppendBoolVector(const std::vector<bool>& values,
+                             std::string* out) {
+  AppendPod<uint64_t>(values.size(), out);
+  for (const bool value : values) {
+    out->push_back(value ? 1 : 0);
+  }
+}
+
+inline absl::Status ReadBoolVector(absl::string_view* in,
+                                   std::vector<bool>* values) {
+  uint64_t size;
+  RETURN_IF_ERROR(ReadPod(in, &size));
+  if (in->size() < size) {
+    return absl::InvalidArgumentError("Truncated serialized model.");
+  }
+  values->assign(size, false);
+  for (uint64_t value_idx = 0; value_idx < size; value_idx++) {
+    (*values)[value_idx] = (*in)[value_idx] != 0;
+  }
+  in->remove_prefix(size);
+  return absl::OkStatus();
+}
+
+inline void AppendBytes(absl::string_view bytes, std::string* out) {
+  AppendPod<uint64_t>(bytes.size(), out);
+  out->append(bytes.data(), bytes.size());
+}
+
+inline absl::Status ReadBytes(absl::string_view* in, std::string* bytes) {
+  uint64_t size;
+  RETURN_IF_ERROR(ReadPod(in, &size));
+  if (in->size() < size) {
+    return absl::InvalidArgumentError("Truncated serialized model.");
+  }
+  bytes->assign(in->data(), size);
+  in->remove_prefix(size);
+  return absl::OkStatus();
+}
+
+// Serialization of the scalar model fields, overloaded by field type.
+
+inline void AppendField(const float value, std::string* out) {
+  AppendPod(value, out);
+}
+
+inline void AppendField(const int value, std::string* out) {
+  AppendPod(value, out);
+}
+
+inline void AppendField(const bool value, std::string* out) {
+  AppendPod(value, out);
+}
+
+inline void AppendField(const std::vector<float>& values, std::string* out) {
+  AppendPodVector(values, out);
+}
+
+inline absl::Status ReadField(absl::string_view* in, float* value) {
+  return ReadPod(in, value);
+}
+
+inline absl::Status ReadField(absl::string_view* in, int* value) {
+  return ReadPod(in, value);
+}
+
+inline absl::Status ReadField(absl::string_view* in, bool* value) {
+  return ReadPod(in, value);
+}
+
+inline absl::Status ReadField(absl::string_view* in,
+                              std::vector<float>* values) {
+  return ReadPodVector(in, values);
+}
+
+// Codecs for the fields only present on some of the specialized model structs
+// ("initial_predictions", "num_classes" and "output_logits"). The generic
+// version is a no-op for models without the field. Since serialization and
+// deserialization are instantiated for the same model type, the presence of
+// the fields in the byte string is deterministic and no marker is needed.
+
+template <typename Model, typename = void>
+struct InitialPredictionsCodec {
+  static void Append(const Model& model, std::string* out) {}
+  static absl::Status Read(absl::string_view* in, Model* model) {
+    return absl::OkStatus();
+  }
+};
+
+template <typename Model>
+struct InitialPredictionsCodec<
+    Model, absl::void_t<decltype(std::declval<Model&>().initial_predictions)>> {
+  static void Append(const Model& model, std::string* out) {
+    AppendField(model.initial_predictions, out);
+  }
+  static absl::Status Read(absl::string_view* in, Model* model) {
+    return ReadField(in, &model->initial_predictions);
+  }
+};
+
+template <typename Model, typename = void>
+struct NumClassesCodec {
+  static void Append(const Model& model, std::string* out) {}
+  static absl::Status Read(absl::string_view* in, Model* model) {
+    return absl::OkStatus();
+  }
+};
+
+template <typename Model>
+struct NumClassesCodec<
+    Model, absl::void_t<decltype(std::declval<Model&>().num_classes)>> {
+  static void Append(const Model& model, std::string* out) {
+    AppendField(model.num_classes, out);
+  }
+  static absl::Status Read(absl::string_view* in, Model* model) {
+    return ReadField(in, &model->num_classes);
+  }
+};
+
+template <typename Model, typename = void>
+struct OutputLogitsCodec {
+  static void Append(const Model& model, std::string* out) {}
+  static absl::Status Read(absl::string_view* in, Model* model) {
+    return absl::OkStatus();
+  }
+};
+
+template <typename Model>
+struct OutputLogitsCodec<
+    Model, absl::void_t<decltype(std::declval<Model&>().output_logits)>> {
+  static void Append(const Model& model, std::string* out) {
+    AppendField(model.output_logits, out);
+  }
+  static absl::Status Read(absl::string_view* in, Model* model) {
+    return ReadField(in, &model->output_logits);
+  }
+};
+
+}  // namespace serialization_internal
+
+template <typename Model>
+absl::Status SerializeFlatModel(const Model& model, std::string* serialized) {
+  namespace si = serialization_internal;
+  static_assert(
+      std::is_trivially_copyable<typename Model::NodeType>::value,
+      "The nodes should be trivially copyable.");
+
+  serialized->clear();
+  si::AppendPod(si::kMagic, serialized);
+  si::AppendPod(si::kVersion, serialized);
+  si::AppendPod<int32_t>(static_cast<int32_t>(Model::kTask), serialized);
+  si::AppendPod<uint32_t>(sizeof(typename Model::NodeType), serialized);
+
+  // Feature definitions: the dataspec and the input feature column indices
+  // are enough to re-run the (cheap) feature initialization.
+  si::AppendBytes(model.features().data_spec().SerializeAsString(), serialized);
+  std::vector<int32_t> input_feature_idxs;
+  for (const auto& feature : model.features().input_features()) {
+    input_feature_idxs.push_back(feature.spec_idx);
+  }
+  si::AppendPodVector(input_feature_idxs, serialized);
+
+  si::AppendPodVector(model.nodes, serialized);
+  si::AppendPodVector(model.root_offsets, serialized);
+  si::AppendPodVector(model.leaf_idxs, serialized);
+  si::AppendPodVector(model.label_buffer, serialized);
+  si::AppendPodVector(model.one_hot_label_classes, serialized);
+  si::AppendPodVector(model.one_hot_label_values, serialized);
+  si::AppendPodVector(model.quantized_label_buffer, serialized);
+  si::AppendPodVector(model.label_buffer_scales, serialized);
+  si::AppendBoolVector(model.categorical_mask_buffer, serialized);
+  si::AppendPodVector(model.categorical_set_bitset_buffer, serialized);
+  si::AppendPodVector(model.oblique_weights, serialized);
+  si::AppendPodVector(model.oblique_internal_feature_idxs, serialized);
+  si::AppendPod(model.max_depth, serialized);
+  si::AppendBytes(model.metadata.SerializeAsString(), serialized);
+
+  si::InitialPredictionsCodec<Model>::Append(model, serialized);
+  si::NumClassesCodec<Model>::Append(model, serialized);
+  si::OutputLogitsCodec<Model>::Append(model, serialized);
+  return absl::OkStatus();
+}
+
+template <typename Model>
+absl::Status DeserializeFlatModel(const absl::string_view serialized,
+                                  Model* model) {
+  namespace si = serialization_internal;
+  absl::string_view in = serialized;
+
+  uint32_t magic, version, node_size;
+  int32_t task;
+  RETURN_IF_ERROR(si::ReadPod(&in, &magic));
+  RETURN_IF_ERROR(si::ReadPod(&in, &version));
+  RETURN_IF_ERROR(si::ReadPod(&in, &task));
+  RETURN_IF_ERROR(si::ReadPod(&in, &node_size));
+  if (magic != si::kMagic || version != si::kVersion) {
+    return absl::InvalidArgumentError(
+        "The data is not a serialized compiled model, or was serialized with "
+        "an incompatible version of the library.");
+  }
+  if (task != static_cast<int32_t>(Model::kTask) ||
+      node_size != sizeof(typename Model::NodeType)) {
+    return absl::InvalidArgumentError(
+        "The serialized model is of a different type than the destination "
+        "model.");
+  }
+
+  std::string data_spec_bytes;
+  RETURN_IF_ERROR(si::ReadBytes(&in, &data_spec_bytes));
+  dataset::proto::DataSpecification data_spec;
+  if (!data_spec.ParseFromString(data_spec_bytes)) {
+    return absl::InvalidArgumentError("Invalid serialized dataspec.");
+  }
+  std::vector<int32_t> input_feature_idxs;
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &input_feature_idxs));
+  const std::vector<int> input_features(input_feature_idxs.begin(),
+                                        input_feature_idxs.end());
+  RETURN_IF_ERROR(model->mutable_features()->Initialize(input_features,
+                                                        data_spec));
+
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &model->nodes));
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &model->root_offsets));
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &model->leaf_idxs));
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &model->label_buffer));
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &model->one_hot_label_classes));
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &model->one_hot_label_values));
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &model->quantized_label_buffer));
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &model->label_buffer_scales));
+  RETURN_IF_ERROR(si::ReadBoolVector(&in, &model->categorical_mask_buffer));
+  RETURN_IF_ERROR(
+      si::ReadPodVector(&in, &model->categorical_set_bitset_buffer));
+  RETURN_IF_ERROR(si::ReadPodVector(&in, &model->oblique_weights));
+  RETURN_IF_ERROR(
+      si::ReadPodVector(&in, &model->oblique_internal_feature_idxs));
+  RETURN_IF_ERROR(si::ReadPod(&in, &model->max_depth));
+  std::string metadata_bytes;
+  RETURN_IF_ERROR(si::ReadBytes(&in, &metadata_bytes));
+  if (!model->metadata.ParseFromString(metadata_bytes)) {
+    return absl::InvalidArgumentError("Invalid serialized metadata.");
+  }
+
+  RETURN_IF_ERROR(si::InitialPredictionsCodec<Model>::Read(&in, model));
+  RETURN_IF_ERROR(si::NumClassesCodec<Model>::Read(&in, model));
+  RETURN_IF_ERROR(si::OutputLogitsCodec<Model>::Read(&in, model));
+
+  if (!in.empty()) {
+    return absl::InvalidArgumentError(
+        "Unexpected trailing data in the serialized model.");
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_DECISION_FOREST_FLAT_MODEL_SERIALIZATION_H_
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/decision_forest/flat_model_serialization.h"
+
+#include <memory>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
+#include "yggdrasil_decision_forests/serving/decision_forest/decision_forest.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace decision_forest {
+namespace {
+
+using model::random_forest::RandomForestModel;
+using testing::ElementsAre;
+
+// A Random Forest with a single stump testing "col_1 >= 2".
+RandomForestModel BuildToyModel() {
+  RandomForestModel rf_model;
+  auto tree = absl::make_unique<model::decision_tree::DecisionTree>();
+  tree->CreateRoot();
+  tree->mutable_root()->CreateChildren();
+  tree->mutable_root()->mutable_node()->mutable_condition()->set_attribute(1);
+  tree->mutable_root()
+      ->mutable_node()
+      ->mutable_condition()
+      ->mutable_condition()
+      ->mutable_higher_condition()
+      ->set_threshold(2.f);
+  tree->mutable_root()
+      ->mutable_pos_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(1);
+  tree->mutable_root()
+      ->mutable_neg_child()
+      ->mutable_node()
+      ->mutable_classifier()
+      ->set_top_value(2);
+  rf_model.AddTree(std::move(tree));
+  rf_model.set_task(model::proto::Task::CLASSIFICATION);
+  rf_model.set_label_col_idx(3);
+  rf_model.mutable_input_features()->push_back(1);
+
+  auto* col_0 = rf_model.mutable_data_spec()->add_columns();
+  col_0->set_name("col_0");
+  col_0->set_type(dataset::proto::ColumnType::NUMERICAL);
+  col_0->mutable_numerical()->set_mean(3.f);
+
+  auto* col_1 = rf_model.mutable_data_spec()->add_columns();
+  col_1->set_name("col_1");
+  col_1->set_type(dataset::proto::ColumnType::NUMERICAL);
+  col_1->mutable_numerical()->set_mean(4.f);
+
+  auto* label = rf_model.mutable_data_spec()->add_columns();
+  label->set_name("label");
+  label->set_type(dataset::proto::ColumnType::CATEGORICAL);
+  label->mutable_categorical()->set_number_of_unique_values(3);
+
+  return rf_model;
+}
+
+TEST(FlatModelSerialization, RandomForestRoundTrip) {
+  const auto rf_model = BuildToyModel();
+  RandomForestBinaryClassificationNumericalFeatures flat_model;
+  CHECK_OK(GenericToSpecializedModel(rf_model, &flat_model));
+
+  std::string serialized;
+  CHECK_OK(SerializeFlatModel(flat_model, &serialized));
+
+  RandomForestBinaryClassificationNumericalFeatures restored_model;
+  CHECK_OK(DeserializeFlatModel(serialized, &restored_model));
+
+  EXPECT_THAT(restored_model.root_offsets, ElementsAre(0));
+  ASSERT_EQ(restored_model.nodes.size(), flat_model.nodes.size());
+  for (int node_idx = 0; node_idx < flat_model.nodes.size(); node_idx++) {
+    EXPECT_EQ(restored_model.nodes[node_idx].right_idx,
+              flat_model.nodes[node_idx].right_idx);
+    EXPECT_EQ(restored_model.nodes[node_idx].feature_idx,
+              flat_model.nodes[node_idx].feature_idx);
+    EXPECT_EQ(restored_model.nodes[node_idx].label,
+              flat_model.nodes[node_idx].label);
+  }
+  EXPECT_THAT(FeatureNames(restored_model.features().fixed_length_features()),
+              ElementsAre("col_1"));
+
+  const std::vector<float> examples = {1.f, 3.f};
+  std::vector<float> predictions, restored_predictions;
+  Predict(flat_model, examples, 2, &predictions);
+  Predict(restored_model, examples, 2, &restored_predictions);
+  EXPECT_EQ(predictions, restored_predictions);
+}
+
+TEST(FlatModelSerialization, GradientBoostedTreesExtraFields) {
+  // Serialization of "initial_predictions" is exercised without building a
+  // full GBT model: the field codecs only look at the struct.
+  GradientBoostedTreesRegressionNumericalOnly flat_model;
+  flat_model.initial_predictions = 42.f;
+
+  dataset::proto::DataSpecification data_spec = PARSE_TEST_PROTO(
+      R"pb(
+        columns {
+          type: NUMERICAL
+          name: "test"
+          numerical { mean: 1.0 }
+        }
+      )pb");
+  EXPECT_OK(flat_model.mutable_features()->Initialize({0}, data_spec));
+
+  std::string serialized;
+  CHECK_OK(SerializeFlatModel(flat_model, &serialized));
+
+  GradientBoostedTreesRegressionNumericalOnly restored_model;
+  CHECK_OK(DeserializeFlatModel(serialized, &restored_model));
+  EXPECT_EQ(restored_model.initial_predictions, 42.f);
+}
+
+TEST(FlatModelSerialization, DetectsCorruption) {
+  const auto rf_model = BuildToyModel();
+  RandomForestBinaryClassificationNumericalFeatures flat_model;
+  CHECK_OK(GenericToSpecializedModel(rf_model, &flat_model));
+
+  std::string serialized;
+  CHECK_OK(SerializeFlatModel(flat_model, &serialized));
+
+  // Truncation.
+  RandomForestBinaryClassificationNumericalFeatures restored_model;
+  EXPECT_FALSE(
+      DeserializeFlatModel(
+          absl::string_view(serialized).substr(0, serialized.size() / 2),
+          &restored_model)
+          .ok());
+
+  // Wrong destination model type.
+  GradientBoostedTreesRegressionNumericalOnly wrong_model;
+  EXPECT_FALSE(DeserializeFlatModel(serialized, &wrong_model).ok());
+}
+
+}  // namespace
+}  // namespace decision_forest
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
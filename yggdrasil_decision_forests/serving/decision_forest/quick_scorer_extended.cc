@@ -17,19 +17,38 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <thread>
+
 #include "absl/status/status.h"
 
 #ifdef __AVX2__
 #include <immintrin.h>
 #endif
 
+// The 512-bit inference path requires the F and VL AVX-512 subsets on top of
+// the AVX2 path (the non-SIMD sections of the batch loop are shared).
+#if defined(__AVX2__) && defined(__AVX512F__) && defined(__AVX512VL__)
+#define YDF_INTERNAL_QUICK_SCORER_AVX512
+#endif
+
+// On AArch64, NEON is part of the base instruction set: the 128-bit path is
+// always compiled-in and does not need a runtime dispatch.
+#if !defined(__AVX2__) && defined(__aarch64__)
+#include <arm_neon.h>
+#define YDF_INTERNAL_QUICK_SCORER_NEON
+#endif
+
 #include "absl/base/config.h"
 #include "absl/numeric/bits.h"
+#include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.pb.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
 #include "yggdrasil_decision_forests/utils/bitmap.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/usage.h"
 
 namespace yggdrasil_decision_forests {
@@ -101,7 +120,7 @@ absl::Status InitializeAccumulator(
             accumulator->categorical_contains_conditions[feature.spec_idx];
         feature_acc.internal_feature_idx = feature.internal_idx;
         feature_acc.items.assign(
-            src.NumTrees() *
+            dst.num_trees *
                 feature_spec.categorical().number_of_unique_values(),
             ~internal::QuickScorerExtendedModel::kZeroLeafMask);
       } break;
@@ -195,12 +214,12 @@ absl::Status FinalizeModel(
 
 // Adds the content of a node (and its children i.e. recursive visit) to the
 // quick scorer tree structure.
-template <typename AbstractModel>
+template <typename AbstractModel, typename SetLeafFn>
 absl::Status FillQuickScorerNode(
     const AbstractModel& src,
     const internal::QuickScorerExtendedModel::TreeIdx tree_idx,
-    const NodeWithChildren& src_node, internal::QuickScorerExtendedModel* dst,
-    int* leaf_idx, int* non_leaf_idx,
+    const NodeWithChildren& src_node, const SetLeafFn& set_leaf,
+    internal::QuickScorerExtendedModel* dst, int* leaf_idx, int* non_leaf_idx,
     internal::QuickScorerExtendedModel::BuildingAccumulator* accumulator) {
   if (src_node.IsLeaf()) {
     // Store the lead value.
@@ -215,7 +234,7 @@ absl::Status FillQuickScorerNode(
     if (leaf_value_idx >= dst->leaf_values.size()) {
       return absl::InternalError("Leaf value idx too large");
     }
-    dst->leaf_values[leaf_value_idx] = src_node.node().regressor().top_value();
+    RETURN_IF_ERROR(set_leaf(src_node, &dst->leaf_values[leaf_value_idx]));
     (*leaf_idx)++;
   } else {
     // Index of the first leaf in the negative branch.
@@ -223,7 +242,7 @@ absl::Status FillQuickScorerNode(
 
     // Parse the negative branch.
     RETURN_IF_ERROR(FillQuickScorerNode(src, tree_idx, *src_node.neg_child(),
-                                        dst, leaf_idx, non_leaf_idx,
+                                        set_leaf, dst, leaf_idx, non_leaf_idx,
                                         accumulator));
 
     // Index of the feature used by the node.
@@ -315,6 +334,29 @@ absl::Status FillQuickScorerNode(
       }
     };
 
+    auto set_oblique = [&]() -> absl::Status {
+      const auto& oblique = condition.oblique_condition();
+      if (oblique.weights_size() != oblique.attributes_size()) {
+        return absl::InvalidArgumentError("Invalid oblique condition");
+      }
+      const int begin_projection = dst->oblique_weights.size();
+      for (int projection_idx = 0; projection_idx < oblique.weights_size();
+           projection_idx++) {
+        ASSIGN_OR_RETURN(
+            const auto sub_feature,
+            FindFeatureDef(dst->features().fixed_length_features(),
+                           oblique.attributes(projection_idx)));
+        dst->oblique_weights.push_back(oblique.weights(projection_idx));
+        dst->oblique_internal_feature_idxs.push_back(sub_feature.internal_idx);
+      }
+      dst->oblique_conditions.push_back(
+          {/*.begin_projection =*/begin_projection,
+           /*.end_projection =*/static_cast<int>(dst->oblique_weights.size()),
+           /*.threshold =*/oblique.threshold(), /*.tree_idx =*/tree_idx,
+           /*.leaf_mask =*/mask});
+      return absl::OkStatus();
+    };
+
     auto set_categoricalset_bitmap_contains = [&]() {
       if (na_value) {
         internal::AndMaskMap(
@@ -374,6 +416,18 @@ absl::Status FillQuickScorerNode(
         }
         break;
 
+      case Condition::TypeCase::kObliqueCondition:
+        RETURN_IF_ERROR(set_oblique());
+        break;
+
+      case Condition::TypeCase::kNaCondition:
+        // The engine requires the missing values to be replaced by global
+        // imputation before inference (see
+        // "IsMissingValueConditionResultFollowGlobalImputation"). After the
+        // replacement, no value is missing: the condition is always false and
+        // its mask is never applied.
+        break;
+
       default:
         return absl::InvalidArgumentError("Unsupported condition type.");
     }
@@ -381,33 +435,34 @@ absl::Status FillQuickScorerNode(
     ++(*non_leaf_idx);
 
     RETURN_IF_ERROR(FillQuickScorerNode(src, tree_idx, *src_node.pos_child(),
-                                        dst, leaf_idx, non_leaf_idx,
+                                        set_leaf, dst, leaf_idx, non_leaf_idx,
                                         accumulator));
   }
   return absl::OkStatus();
 }
 
-// Adds the content of the tree structures to the quick scorer structure.
-template <typename AbstractModel>
+// Adds the content of the tree structures in "[begin_tree, end_tree)" to the
+// quick scorer structure. "set_leaf" extracts the value of a leaf node; it
+// depends both on the model class (e.g. GBT vs RF) and on the task.
+template <typename AbstractModel, typename SetLeafFn>
 absl::Status FillQuickScorer(
-    const AbstractModel& src, internal::QuickScorerExtendedModel* dst,
+    const AbstractModel& src, const SetLeafFn& set_leaf, const int begin_tree,
+    const int end_tree, internal::QuickScorerExtendedModel* dst,
     internal::QuickScorerExtendedModel::BuildingAccumulator* accumulator) {
-  RETURN_IF_ERROR(InitializeAccumulator(src, *dst, accumulator));
-
-  dst->initial_prediction = src.initial_predictions()[0];
-  dst->output_logits = src.output_logits();
-  dst->num_trees = src.NumTrees();
+  dst->num_trees = end_tree - begin_tree;
   if (dst->num_trees > internal::QuickScorerExtendedModel::kMaxTrees) {
     return absl::InvalidArgumentError(
         absl::Substitute("The model contains trees with more than $0 trees",
                          internal::QuickScorerExtendedModel::kMaxTrees));
   }
 
+  RETURN_IF_ERROR(InitializeAccumulator(src, *dst, accumulator));
+
   // Get the maximum number of leafs per trees.
   dst->max_num_leafs_per_tree = 0;
   int num_leafs = 0;
-  for (const auto& src_tree : src.decision_trees()) {
-    const auto num_leafs_in_tree = src_tree->NumLeafs();
+  for (int tree_idx = begin_tree; tree_idx < end_tree; ++tree_idx) {
+    const auto num_leafs_in_tree = src.decision_trees()[tree_idx]->NumLeafs();
     num_leafs += num_leafs_in_tree;
     if (num_leafs_in_tree > dst->max_num_leafs_per_tree) {
       dst->max_num_leafs_per_tree = num_leafs_in_tree;
@@ -423,19 +478,32 @@ absl::Status FillQuickScorer(
 
   dst->leaf_values.assign(dst->max_num_leafs_per_tree * dst->num_trees, 0.f);
 
-  for (internal::QuickScorerExtendedModel::TreeIdx tree_idx = 0;
-       tree_idx < src.decision_trees().size(); ++tree_idx) {
+  for (int tree_idx = begin_tree; tree_idx < end_tree; ++tree_idx) {
     const auto& src_tree = src.decision_trees()[tree_idx];
     int leaf_idx = 0;
     int non_leaf_idx = 0;
-    RETURN_IF_ERROR(FillQuickScorerNode(src, tree_idx, src_tree->root(), dst,
-                                        &leaf_idx, &non_leaf_idx, accumulator));
+    RETURN_IF_ERROR(FillQuickScorerNode(
+        src,
+        static_cast<internal::QuickScorerExtendedModel::TreeIdx>(tree_idx -
+                                                                 begin_tree),
+        src_tree->root(), set_leaf, dst, &leaf_idx, &non_leaf_idx,
+        accumulator));
   }
 
   RETURN_IF_ERROR(FinalizeModel(*accumulator, dst));
   return absl::OkStatus();
 }
 
+// Adds all the tree structures of the model to the quick scorer structure.
+template <typename AbstractModel, typename SetLeafFn>
+absl::Status FillQuickScorer(
+    const AbstractModel& src, const SetLeafFn& set_leaf,
+    internal::QuickScorerExtendedModel* dst,
+    internal::QuickScorerExtendedModel::BuildingAccumulator* accumulator) {
+  return FillQuickScorer(src, set_leaf, /*begin_tree=*/0,
+                         /*end_tree=*/src.NumTrees(), dst, accumulator);
+}
+
 // Tree inference without SIMD i.e. one example at a time.
 // This method is used for the examples outside of the SIMD batch.
 //
@@ -444,10 +512,10 @@ absl::Status FillQuickScorer(
 template <typename Model, float (*Activation)(float)>
 void PredictQuickScorerSequential(
     const Model& model,
-    const std::vector<NumericalOrCategoricalValue>& fixed_length_features,
-    const std::vector<Rangei32>& categorical_set_begins_and_ends,
-    const std::vector<int32_t>& categorical_item_buffer,
-    const int begin_example_idx, const int end_example_idx,
+    const NumericalOrCategoricalValue* fixed_length_features,
+    const Rangei32* categorical_set_begins_and_ends,
+    const int32_t* categorical_item_buffer, const int begin_example_idx,
+    const int end_example_idx,
     const int major_feature_offset, std::vector<float>* predictions,
     internal::QuickScorerExtendedModel::LeafMask* active_leaf_buffer) {
   const size_t active_leaf_buffer_size = model.num_trees * sizeof(LeafMask);
@@ -511,6 +579,24 @@ void PredictQuickScorerSequential(
       }
     }
 
+    // Oblique conditions.
+    for (const auto& oblique_condition : model.oblique_conditions) {
+      float sum = 0.f;
+      for (int projection_idx = oblique_condition.begin_projection;
+           projection_idx < oblique_condition.end_projection;
+           projection_idx++) {
+        sum += model.oblique_weights[projection_idx] *
+               fixed_length_features
+                   [index(model.oblique_internal_feature_idxs[projection_idx],
+                          example_idx)]
+                       .numerical_value;
+      }
+      if (sum >= oblique_condition.threshold) {
+        active_leaf_buffer[oblique_condition.tree_idx] &=
+            oblique_condition.leaf_mask;
+      }
+    }
+
     // Get the active leaf.
     auto* leaf_reader = model.leaf_values.data();
     float output = model.initial_prediction;
@@ -541,9 +627,9 @@ void PredictQuickScorerSequential(
 template <typename Model, float (*Activation)(float) = ActivationIdentity>
 void PredictQuickScorerMajorFeatureOffset(
     const Model& model,
-    const std::vector<NumericalOrCategoricalValue>& fixed_length_features,
-    const std::vector<Rangei32>& categorical_set_begins_and_ends,
-    const std::vector<int32_t>& categorical_item_buffer, const int num_examples,
+    const NumericalOrCategoricalValue* fixed_length_features,
+    const Rangei32* categorical_set_begins_and_ends,
+    const int32_t* categorical_item_buffer, const int num_examples,
     const int major_feature_offset, std::vector<float>* predictions) {
   utils::usage::OnInference(num_examples, model.metadata);
   predictions->resize(num_examples);
@@ -554,8 +640,16 @@ void PredictQuickScorerMajorFeatureOffset(
   // "PredictQuickScorerSequential".
   constexpr int kNumParallelExamples = 4;
 
+#ifdef YDF_INTERNAL_QUICK_SCORER_AVX512
+  // The AVX-512 path processes 8 examples at a time (512 bits / 64-bit leaf
+  // mask). The active leaf buffer is sized for the largest batch.
+  constexpr int kNumParallelExamplesAvx512 = 8;
+  const size_t active_leaf_buffer_size =
+      model.num_trees * kNumParallelExamplesAvx512 * sizeof(LeafMask);
+#else
   const size_t active_leaf_buffer_size =
       model.num_trees * kNumParallelExamples * sizeof(LeafMask);
+#endif
   const size_t alignment = 32 * 8;
 
   // Make sure the allocated chunk of memory is a multiple of "alignment".
@@ -603,14 +697,161 @@ void PredictQuickScorerMajorFeatureOffset(
 
   int example_idx = 0;
 
+#ifdef YDF_INTERNAL_QUICK_SCORER_AVX512
+  if (model.cpu_supports_avx512) {
+    auto* sample_reader = fixed_length_features;
+    auto* prediction_reader = predictions->data();
+
+    // First run on sub-batches of kNumParallelExamplesAvx512 at a time. The
+    // remaining will be processed by the AVX2 and sequential paths below.
+    int num_remaining_iters = num_examples / kNumParallelExamplesAvx512;
+    while (num_remaining_iters--) {
+      // Reset active node buffer.
+      std::memset(active_leaf_buffer, 0xFF, active_leaf_buffer_size);
+
+      // Is higher conditions.
+      for (const auto& is_higher_condition : model.is_higher_conditions) {
+        const float* begin_example =
+            &sample_reader[0].numerical_value +
+            is_higher_condition.internal_feature_idx * major_feature_offset;
+
+        const auto feature_values = _mm256_loadu_ps(begin_example);
+        for (const auto& item : is_higher_condition.items) {
+          const auto threshold = _mm256_set1_ps(item.threshold);
+
+          // One comparison bit per example.
+          const __mmask8 comparison =
+              _mm256_cmp_ps_mask(feature_values, threshold, _CMP_GE_OQ);
+          if (comparison) {
+            // The mask attached to the condition i.e. the mask to apply on the
+            // active node bitmap iif. the condition is true.
+            const auto mask = _mm512_set1_epi64(item.leaf_mask);
+            auto* active_si512 = reinterpret_cast<__m512i*>(
+                &active_leaf_buffer[item.tree_idx *
+                                    kNumParallelExamplesAvx512]);
+            const auto active = _mm512_load_si512(active_si512);
+
+            // AND the condition mask on the active leafs of the examples for
+            // which the condition is true; other examples are left unchanged.
+            const auto new_active =
+                _mm512_mask_and_epi64(active, comparison, active, mask);
+            _mm512_store_si512(active_si512, new_active);
+          } else {
+            break;
+          }
+        }
+      }
+
+      // Dense contains conditions.
+      for (int sub_example_idx = 0;
+           sub_example_idx < kNumParallelExamplesAvx512; ++sub_example_idx) {
+        for (const auto& contains_condition :
+             model.categorical_contains_conditions) {
+          const auto feature_value =
+              sample_reader[contains_condition.internal_feature_idx *
+                                major_feature_offset +
+                            sub_example_idx]
+                  .categorical_value;
+          const auto* leaf_mask_stream =
+              &contains_condition.items[model.num_trees * feature_value];
+          for (int tree_idx = 0; tree_idx < model.num_trees; ++tree_idx) {
+            active_leaf_buffer[tree_idx * kNumParallelExamplesAvx512 +
+                               sub_example_idx] &= *(leaf_mask_stream++);
+          }
+        }
+      }
+
+      // Sparse contains conditions.
+      for (int sub_example_idx = 0;
+           sub_example_idx < kNumParallelExamplesAvx512; ++sub_example_idx) {
+        for (const auto& contains_condition :
+             model.categoricalset_contains_conditions) {
+          const auto& range_values = categorical_set_begins_and_ends
+              [contains_condition.internal_feature_idx * major_feature_offset +
+               sub_example_idx + example_idx];
+          for (int value_idx = range_values.begin; value_idx < range_values.end;
+               value_idx++) {
+            const auto value = categorical_item_buffer[value_idx] + 1;
+            const auto& range_masks =
+                contains_condition.value_to_mask_range[value];
+            for (int mask_idx = range_masks.first;
+                 mask_idx < range_masks.second; mask_idx++) {
+              const auto& mask = contains_condition.mask_buffer[mask_idx];
+              active_leaf_buffer[mask.first * kNumParallelExamplesAvx512 +
+                                 sub_example_idx] &= mask.second;
+            }
+          }
+        }
+      }
+
+      // Oblique conditions (evaluated one example at a time).
+      for (int sub_example_idx = 0;
+           sub_example_idx < kNumParallelExamplesAvx512; ++sub_example_idx) {
+        for (const auto& oblique_condition : model.oblique_conditions) {
+          float sum = 0.f;
+          for (int projection_idx = oblique_condition.begin_projection;
+               projection_idx < oblique_condition.end_projection;
+               projection_idx++) {
+            sum += model.oblique_weights[projection_idx] *
+                   sample_reader
+                       [model.oblique_internal_feature_idxs[projection_idx] *
+                            major_feature_offset +
+                        sub_example_idx]
+                           .numerical_value;
+          }
+          if (sum >= oblique_condition.threshold) {
+            active_leaf_buffer[oblique_condition.tree_idx *
+                                   kNumParallelExamplesAvx512 +
+                               sub_example_idx] &= oblique_condition.leaf_mask;
+          }
+        }
+      }
+
+#pragma loop unroll(full)
+      for (int sub_example_idx = 0;
+           sub_example_idx < kNumParallelExamplesAvx512; ++sub_example_idx) {
+        prediction_reader[sub_example_idx] = model.initial_prediction;
+      }
+
+      auto* leaf_reader = model.leaf_values.data();
+      for (int tree_idx = 0; tree_idx < model.num_trees; ++tree_idx) {
+#pragma loop unroll(full)
+        for (int sub_example_idx = 0;
+             sub_example_idx < kNumParallelExamplesAvx512; ++sub_example_idx) {
+          const auto shift_mask =
+              active_leaf_buffer[tree_idx * kNumParallelExamplesAvx512 +
+                                 sub_example_idx];
+          const auto node_idx = FindLSBSetNonZero64(shift_mask);
+          prediction_reader[sub_example_idx] += leaf_reader[node_idx];
+        }
+        leaf_reader += model.max_num_leafs_per_tree;
+      }
+
+// Note: The compiler should be able to remove the following loop when
+// Activation == Identity. Tested with gcc9 and clang9.
+#pragma loop unroll(full)
+      for (int sub_example_idx = 0;
+           sub_example_idx < kNumParallelExamplesAvx512; ++sub_example_idx) {
+        prediction_reader[sub_example_idx] =
+            Activation(prediction_reader[sub_example_idx]);
+      }
+
+      sample_reader += kNumParallelExamplesAvx512;
+      prediction_reader += kNumParallelExamplesAvx512;
+      example_idx += kNumParallelExamplesAvx512;
+    }
+  }
+#endif
+
 #ifdef __AVX2__
   if (model.cpu_supports_avx2) {
-    auto* sample_reader = fixed_length_features.data();
-    auto* prediction_reader = predictions->data();
+    auto* sample_reader = fixed_length_features + example_idx;
+    auto* prediction_reader = predictions->data() + example_idx;
 
     // First run on sub-batches of kNumParallelExamples at a time. The
     // remaining will be done sequentially below.
-    int num_remaining_iters = num_examples / kNumParallelExamples;
+    int num_remaining_iters =
+        (num_examples - example_idx) / kNumParallelExamples;
     while (num_remaining_iters--) {
       // Reset active node buffer.
       std::memset(active_leaf_buffer, 0xFF, active_leaf_buffer_size);
@@ -694,6 +935,183 @@ void PredictQuickScorerMajorFeatureOffset(
         }
       }
 
+      // Oblique conditions (evaluated one example at a time).
+      for (int sub_example_idx = 0; sub_example_idx < kNumParallelExamples;
+           ++sub_example_idx) {
+        for (const auto& oblique_condition : model.oblique_conditions) {
+          float sum = 0.f;
+          for (int projection_idx = oblique_condition.begin_projection;
+               projection_idx < oblique_condition.end_projection;
+               projection_idx++) {
+            sum += model.oblique_weights[projection_idx] *
+                   sample_reader
+                       [model.oblique_internal_feature_idxs[projection_idx] *
+                            major_feature_offset +
+                        sub_example_idx]
+                           .numerical_value;
+          }
+          if (sum >= oblique_condition.threshold) {
+            active_leaf_buffer[oblique_condition.tree_idx *
+                                   kNumParallelExamples +
+                               sub_example_idx] &= oblique_condition.leaf_mask;
+          }
+        }
+      }
+
+#pragma loop unroll(full)
+      for (int sub_example_idx = 0; sub_example_idx < kNumParallelExamples;
+           ++sub_example_idx) {
+        prediction_reader[sub_example_idx] = model.initial_prediction;
+      }
+
+      auto* leaf_reader = model.leaf_values.data();
+      for (int tree_idx = 0; tree_idx < model.num_trees; ++tree_idx) {
+#pragma loop unroll(full)
+        for (int sub_example_idx = 0; sub_example_idx < kNumParallelExamples;
+             ++sub_example_idx) {
+          const auto shift_mask =
+              active_leaf_buffer[tree_idx * kNumParallelExamples +
+                                 sub_example_idx];
+          const auto node_idx = FindLSBSetNonZero64(shift_mask);
+          prediction_reader[sub_example_idx] += leaf_reader[node_idx];
+        }
+        leaf_reader += model.max_num_leafs_per_tree;
+      }
+
+// Note: The compiler should be able to remove the following loop when
+// Activation == Identity. Tested with gcc9 and clang9.
+#pragma loop unroll(full)
+      for (int sub_example_idx = 0; sub_example_idx < kNumParallelExamples;
+           ++sub_example_idx) {
+        prediction_reader[sub_example_idx] =
+            Activation(prediction_reader[sub_example_idx]);
+      }
+
+      sample_reader += kNumParallelExamples;
+      prediction_reader += kNumParallelExamples;
+      example_idx += kNumParallelExamples;
+    }
+  }
+#endif
+
+#ifdef YDF_INTERNAL_QUICK_SCORER_NEON
+  {
+    auto* sample_reader = fixed_length_features;
+    auto* prediction_reader = predictions->data();
+
+    // First run on sub-batches of kNumParallelExamples at a time. The
+    // remaining will be done sequentially below.
+    int num_remaining_iters = num_examples / kNumParallelExamples;
+    while (num_remaining_iters--) {
+      // Reset active node buffer.
+      std::memset(active_leaf_buffer, 0xFF, active_leaf_buffer_size);
+
+      // Is higher conditions.
+      for (const auto& is_higher_condition : model.is_higher_conditions) {
+        const float* begin_example =
+            &sample_reader[0].numerical_value +
+            is_higher_condition.internal_feature_idx * major_feature_offset;
+
+        const float32x4_t feature_values = vld1q_f32(begin_example);
+        for (const auto& item : is_higher_condition.items) {
+          const float32x4_t threshold = vdupq_n_f32(item.threshold);
+
+          // Note: "comparison" is either 0x00000000 or 0xFFFFFFFF depending on
+          // the node condition value.
+          const uint32x4_t comparison = vcgeq_f32(feature_values, threshold);
+          if (vmaxvq_u32(comparison) != 0) {
+            // The mask attached to the condition i.e. the mask to apply on the
+            // active node bitmap iif. the condition is true.
+            const uint64x2_t mask = vdupq_n_u64(item.leaf_mask);
+            auto* active_u64 =
+                &active_leaf_buffer[item.tree_idx * kNumParallelExamples];
+
+            // Expand the comparison to 8 bytes per example.
+            const uint64x2_t comparison_lo =
+                vreinterpretq_u64_u32(vzip1q_u32(comparison, comparison));
+            const uint64x2_t comparison_hi =
+                vreinterpretq_u64_u32(vzip2q_u32(comparison, comparison));
+
+            uint64x2_t active_lo = vld1q_u64(active_u64);
+            uint64x2_t active_hi = vld1q_u64(active_u64 + 2);
+            // new_active = active & not (comparison & not mask)
+            // i.e. AND the mask on the examples for which the condition is
+            // true; other examples are left unchanged.
+            active_lo = vbicq_u64(active_lo, vbicq_u64(comparison_lo, mask));
+            active_hi = vbicq_u64(active_hi, vbicq_u64(comparison_hi, mask));
+            vst1q_u64(active_u64, active_lo);
+            vst1q_u64(active_u64 + 2, active_hi);
+          } else {
+            break;
+          }
+        }
+      }
+
+      // Dense contains conditions.
+      for (int sub_example_idx = 0; sub_example_idx < kNumParallelExamples;
+           ++sub_example_idx) {
+        for (const auto& contains_condition :
+             model.categorical_contains_conditions) {
+          const auto feature_value =
+              sample_reader[contains_condition.internal_feature_idx *
+                                major_feature_offset +
+                            sub_example_idx]
+                  .categorical_value;
+          const auto* leaf_mask_stream =
+              &contains_condition.items[model.num_trees * feature_value];
+          for (int tree_idx = 0; tree_idx < model.num_trees; ++tree_idx) {
+            active_leaf_buffer[tree_idx * kNumParallelExamples +
+                               sub_example_idx] &= *(leaf_mask_stream++);
+          }
+        }
+      }
+
+      // Sparse contains conditions.
+      for (int sub_example_idx = 0; sub_example_idx < kNumParallelExamples;
+           ++sub_example_idx) {
+        for (const auto& contains_condition :
+             model.categoricalset_contains_conditions) {
+          const auto& range_values = categorical_set_begins_and_ends
+              [contains_condition.internal_feature_idx * major_feature_offset +
+               sub_example_idx + example_idx];
+          for (int value_idx = range_values.begin; value_idx < range_values.end;
+               value_idx++) {
+            const auto value = categorical_item_buffer[value_idx] + 1;
+            const auto& range_masks =
+                contains_condition.value_to_mask_range[value];
+            for (int mask_idx = range_masks.first;
+                 mask_idx < range_masks.second; mask_idx++) {
+              const auto& mask = contains_condition.mask_buffer[mask_idx];
+              active_leaf_buffer[mask.first * kNumParallelExamples +
+                                 sub_example_idx] &= mask.second;
+            }
+          }
+        }
+      }
+
+      // Oblique conditions (evaluated one example at a time).
+      for (int sub_example_idx = 0; sub_example_idx < kNumParallelExamples;
+           ++sub_example_idx) {
+        for (const auto& oblique_condition : model.oblique_conditions) {
+          float sum = 0.f;
+          for (int projection_idx = oblique_condition.begin_projection;
+               projection_idx < oblique_condition.end_projection;
+               projection_idx++) {
+            sum += model.oblique_weights[projection_idx] *
+                   sample_reader
+                       [model.oblique_internal_feature_idxs[projection_idx] *
+                            major_feature_offset +
+                        sub_example_idx]
+                           .numerical_value;
+          }
+          if (sum >= oblique_condition.threshold) {
+            active_leaf_buffer[oblique_condition.tree_idx *
+                                   kNumParallelExamples +
+                               sub_example_idx] &= oblique_condition.leaf_mask;
+          }
+        }
+      }
+
 #pragma loop unroll(full)
       for (int sub_example_idx = 0; sub_example_idx < kNumParallelExamples;
            ++sub_example_idx) {
@@ -749,8 +1167,44 @@ void PredictQuickScorer(
     const Model& model,
     const std::vector<NumericalOrCategoricalValue>& examples, int num_examples,
     std::vector<float>* predictions) {
-  PredictQuickScorerMajorFeatureOffset(model, examples, {}, {}, num_examples,
-                                       num_examples, predictions);
+  PredictQuickScorerMajorFeatureOffset(model, examples.data(), nullptr,
+                                       nullptr, num_examples, num_examples,
+                                       predictions);
+}
+
+template <typename Model, float (*Activation)(float) = ActivationIdentity>
+void PredictQuickScorerColumnMajorInternal(
+    const Model& model, const NumericalOrCategoricalValue* examples,
+    const int num_examples, const int major_feature_offset,
+    std::vector<float>* predictions) {
+  PredictQuickScorerMajorFeatureOffset<Model, Activation>(
+      model, examples, nullptr, nullptr, num_examples, major_feature_offset,
+      predictions);
+}
+
+template <typename Model>
+void PredictQuickScorerColumnMajor(
+    const Model& model, const NumericalOrCategoricalValue* examples,
+    const int num_examples, const int major_feature_offset,
+    std::vector<float>* predictions) {
+  PredictQuickScorerColumnMajorInternal(model, examples, num_examples,
+                                        major_feature_offset, predictions);
+}
+
+template <>
+void PredictQuickScorerColumnMajor(
+    const GradientBoostedTreesBinaryClassificationQuickScorerExtended& model,
+    const NumericalOrCategoricalValue* examples, const int num_examples,
+    const int major_feature_offset, std::vector<float>* predictions) {
+  if (model.output_logits) {
+    PredictQuickScorerColumnMajorInternal(model, examples, num_examples,
+                                          major_feature_offset, predictions);
+  } else {
+    PredictQuickScorerColumnMajorInternal<
+        GradientBoostedTreesBinaryClassificationQuickScorerExtended,
+        ActivationBinomialLogLikelihood>(
+        model, examples, num_examples, major_feature_offset, predictions);
+  }
 }
 
 // Version of Predict compatible with the ExampleSet signature.
@@ -758,9 +1212,9 @@ template <typename Model>
 void Predict(const Model& model, const typename Model::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions) {
   PredictQuickScorerMajorFeatureOffset(
-      model, examples.InternalCategoricalAndNumericalValues(),
-      examples.InternalCategoricalSetBeginAndEnds(),
-      examples.InternalCategoricalItemBuffer(), num_examples,
+      model, examples.InternalCategoricalAndNumericalValues().data(),
+      examples.InternalCategoricalSetBeginAndEnds().data(),
+      examples.InternalCategoricalItemBuffer().data(), num_examples,
       examples.NumberOfExamples(), predictions);
 }
 
@@ -770,6 +1224,29 @@ PredictQuickScorer<GradientBoostedTreesRegressionQuickScorerExtended>(
     const std::vector<NumericalOrCategoricalValue>& examples,
     const int num_examples, std::vector<float>* predictions);
 
+template void PredictQuickScorer<RandomForestRegressionQuickScorerExtended>(
+    const RandomForestRegressionQuickScorerExtended& model,
+    const std::vector<NumericalOrCategoricalValue>& examples,
+    const int num_examples, std::vector<float>* predictions);
+
+template void
+PredictQuickScorerColumnMajor<GradientBoostedTreesRegressionQuickScorerExtended>(
+    const GradientBoostedTreesRegressionQuickScorerExtended& model,
+    const NumericalOrCategoricalValue* examples, const int num_examples,
+    const int major_feature_offset, std::vector<float>* predictions);
+
+template void
+PredictQuickScorerColumnMajor<GradientBoostedTreesRankingQuickScorerExtended>(
+    const GradientBoostedTreesRankingQuickScorerExtended& model,
+    const NumericalOrCategoricalValue* examples, const int num_examples,
+    const int major_feature_offset, std::vector<float>* predictions);
+
+template void
+PredictQuickScorerColumnMajor<RandomForestRegressionQuickScorerExtended>(
+    const RandomForestRegressionQuickScorerExtended& model,
+    const NumericalOrCategoricalValue* examples, const int num_examples,
+    const int major_feature_offset, std::vector<float>* predictions);
+
 template void Predict<GradientBoostedTreesRegressionQuickScorerExtended>(
     const GradientBoostedTreesRegressionQuickScorerExtended& model,
     const GradientBoostedTreesRegressionQuickScorerExtended::ExampleSet&
@@ -781,6 +1258,19 @@ template void Predict<GradientBoostedTreesRankingQuickScorerExtended>(
     const GradientBoostedTreesRankingQuickScorerExtended::ExampleSet& examples,
     const int num_examples, std::vector<float>* predictions);
 
+// Note: The leaf values of the Random Forest models are already normalized
+// probabilities (resp. averaged values); no activation function is needed.
+template void Predict<RandomForestBinaryClassificationQuickScorerExtended>(
+    const RandomForestBinaryClassificationQuickScorerExtended& model,
+    const RandomForestBinaryClassificationQuickScorerExtended::ExampleSet&
+        examples,
+    const int num_examples, std::vector<float>* predictions);
+
+template void Predict<RandomForestRegressionQuickScorerExtended>(
+    const RandomForestRegressionQuickScorerExtended& model,
+    const RandomForestRegressionQuickScorerExtended::ExampleSet& examples,
+    const int num_examples, std::vector<float>* predictions);
+
 template <>
 void Predict(
     const GradientBoostedTreesBinaryClassificationQuickScorerExtended& model,
@@ -790,24 +1280,35 @@ void Predict(
   if (model.output_logits) {
     PredictQuickScorerMajorFeatureOffset<
         GradientBoostedTreesBinaryClassificationQuickScorerExtended>(
-        model, examples.InternalCategoricalAndNumericalValues(),
-        examples.InternalCategoricalSetBeginAndEnds(),
-        examples.InternalCategoricalItemBuffer(), num_examples,
+        model, examples.InternalCategoricalAndNumericalValues().data(),
+        examples.InternalCategoricalSetBeginAndEnds().data(),
+        examples.InternalCategoricalItemBuffer().data(), num_examples,
         examples.NumberOfExamples(), predictions);
   } else {
     PredictQuickScorerMajorFeatureOffset<
         GradientBoostedTreesBinaryClassificationQuickScorerExtended,
         ActivationBinomialLogLikelihood>(
-        model, examples.InternalCategoricalAndNumericalValues(),
-        examples.InternalCategoricalSetBeginAndEnds(),
-        examples.InternalCategoricalItemBuffer(), num_examples,
+        model, examples.InternalCategoricalAndNumericalValues().data(),
+        examples.InternalCategoricalSetBeginAndEnds().data(),
+        examples.InternalCategoricalItemBuffer().data(), num_examples,
         examples.NumberOfExamples(), predictions);
   }
 }
 
-template <typename AbstractModel, typename CompiledModel>
-absl::Status BaseGenericToSpecializedModel(const AbstractModel& src,
-                                           CompiledModel* dst) {
+// Detects at runtime the SIMD instruction sets usable by the compiled model.
+template <typename CompiledModel>
+void DetectCpuInstructionSet(CompiledModel* dst) {
+#ifdef YDF_INTERNAL_QUICK_SCORER_AVX512
+#if ABSL_HAVE_BUILTIN(__builtin_cpu_supports)
+  dst->cpu_supports_avx512 = __builtin_cpu_supports("avx512f") &&
+                             __builtin_cpu_supports("avx512vl");
+#else
+  // We cannot detect if the CPU supports AVX-512 instructions. If it does
+  // not, a fatal error will be raised.
+  dst->cpu_supports_avx512 = true;
+#endif
+#endif
+
 #ifdef __AVX2__
 #if ABSL_HAVE_BUILTIN(__builtin_cpu_supports)
   dst->cpu_supports_avx2 = __builtin_cpu_supports("avx2");
@@ -823,6 +1324,143 @@ absl::Status BaseGenericToSpecializedModel(const AbstractModel& src,
                  "supports it. Enable it for faster model inference.");
   }
 #endif
+}
+
+// Applies, shard after shard, the quick scorer algorithm and sums the shard
+// outputs. The activation function (if any) is applied once on the final sum.
+template <typename SubModel, float (*Activation)(float) = ActivationIdentity>
+void PredictShardedQuickScorer(
+    const ShardedQuickScorerModel<SubModel>& model,
+    const typename ShardedQuickScorerModel<SubModel>::ExampleSet& examples,
+    const int num_examples, std::vector<float>* predictions) {
+  predictions->assign(num_examples, 0.f);
+  std::vector<float> shard_predictions;
+  for (const auto& shard : model.shards) {
+    PredictQuickScorerMajorFeatureOffset<SubModel>(
+        shard, examples.InternalCategoricalAndNumericalValues().data(),
+        examples.InternalCategoricalSetBeginAndEnds().data(),
+        examples.InternalCategoricalItemBuffer().data(), num_examples,
+        examples.NumberOfExamples(), &shard_predictions);
+    for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
+      (*predictions)[example_idx] += shard_predictions[example_idx];
+    }
+  }
+  for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
+    (*predictions)[example_idx] = Activation((*predictions)[example_idx]);
+  }
+}
+
+template <>
+void Predict(
+    const ShardedGradientBoostedTreesRegressionQuickScorerExtended& model,
+    const ShardedGradientBoostedTreesRegressionQuickScorerExtended::ExampleSet&
+        examples,
+    const int num_examples, std::vector<float>* predictions) {
+  PredictShardedQuickScorer<GradientBoostedTreesRegressionQuickScorerExtended>(
+      model, examples, num_examples, predictions);
+}
+
+template <>
+void Predict(
+    const ShardedGradientBoostedTreesRankingQuickScorerExtended& model,
+    const ShardedGradientBoostedTreesRankingQuickScorerExtended::ExampleSet&
+        examples,
+    const int num_examples, std::vector<float>* predictions) {
+  PredictShardedQuickScorer<GradientBoostedTreesRankingQuickScorerExtended>(
+      model, examples, num_examples, predictions);
+}
+
+template <>
+void Predict(
+    const ShardedGradientBoostedTreesBinaryClassificationQuickScorerExtended&
+        model,
+    const ShardedGradientBoostedTreesBinaryClassificationQuickScorerExtended::
+        ExampleSet& examples,
+    const int num_examples, std::vector<float>* predictions) {
+  if (model.output_logits) {
+    PredictShardedQuickScorer<
+        GradientBoostedTreesBinaryClassificationQuickScorerExtended>(
+        model, examples, num_examples, predictions);
+  } else {
+    PredictShardedQuickScorer<
+        GradientBoostedTreesBinaryClassificationQuickScorerExtended,
+        ActivationBinomialLogLikelihood>(model, examples, num_examples,
+                                         predictions);
+  }
+}
+
+// Applies the two-stage cascade: all the examples are scored by the first
+// stage, and the examples whose score falls in the uncertainty band
+// "[lower_threshold, upper_threshold]" are re-scored, one example at a time,
+// by the second stage.
+template <typename SubModel, float (*Activation)(float) = ActivationIdentity>
+void PredictCascadeQuickScorer(
+    const CascadeQuickScorerModel<SubModel>& model,
+    const typename CascadeQuickScorerModel<SubModel>::ExampleSet& examples,
+    const int num_examples, std::vector<float>* predictions) {
+  const auto* fixed_length_features =
+      examples.InternalCategoricalAndNumericalValues().data();
+  const auto* categorical_set_begins_and_ends =
+      examples.InternalCategoricalSetBeginAndEnds().data();
+  const auto* categorical_item_buffer =
+      examples.InternalCategoricalItemBuffer().data();
+  const int major_feature_offset = examples.NumberOfExamples();
+
+  PredictQuickScorerMajorFeatureOffset<SubModel, Activation>(
+      model.stage_1, fixed_length_features, categorical_set_begins_and_ends,
+      categorical_item_buffer, num_examples, major_feature_offset,
+      predictions);
+
+  // Re-score the uncertain examples with the second stage. The second stage
+  // is expected to see a small fraction of the examples: the examples are
+  // scored individually with the sequential (non-SIMD) engine.
+  std::vector<LeafMask> active_leaf_buffer(model.stage_2.num_trees);
+  for (int example_idx = 0; example_idx < num_examples; ++example_idx) {
+    const float stage_1_score = (*predictions)[example_idx];
+    if (stage_1_score < model.lower_threshold ||
+        stage_1_score > model.upper_threshold) {
+      continue;
+    }
+    PredictQuickScorerSequential<SubModel, Activation>(
+        model.stage_2, fixed_length_features, categorical_set_begins_and_ends,
+        categorical_item_buffer, example_idx, example_idx + 1,
+        major_feature_offset, predictions, active_leaf_buffer.data());
+  }
+}
+
+template <>
+void Predict(
+    const CascadeGradientBoostedTreesRegressionQuickScorerExtended& model,
+    const CascadeGradientBoostedTreesRegressionQuickScorerExtended::ExampleSet&
+        examples,
+    const int num_examples, std::vector<float>* predictions) {
+  PredictCascadeQuickScorer<GradientBoostedTreesRegressionQuickScorerExtended>(
+      model, examples, num_examples, predictions);
+}
+
+template <>
+void Predict(
+    const CascadeGradientBoostedTreesBinaryClassificationQuickScorerExtended&
+        model,
+    const CascadeGradientBoostedTreesBinaryClassificationQuickScorerExtended::
+        ExampleSet& examples,
+    const int num_examples, std::vector<float>* predictions) {
+  if (model.output_logits) {
+    PredictCascadeQuickScorer<
+        GradientBoostedTreesBinaryClassificationQuickScorerExtended>(
+        model, examples, num_examples, predictions);
+  } else {
+    PredictCascadeQuickScorer<
+        GradientBoostedTreesBinaryClassificationQuickScorerExtended,
+        ActivationBinomialLogLikelihood>(model, examples, num_examples,
+                                         predictions);
+  }
+}
+
+template <typename AbstractModel, typename CompiledModel>
+absl::Status BaseGenericToSpecializedModel(const AbstractModel& src,
+                                           CompiledModel* dst) {
+  DetectCpuInstructionSet(dst);
 
   if (src.task() != CompiledModel::kTask) {
     return absl::InvalidArgumentError("Wrong model class.");
@@ -839,8 +1477,18 @@ absl::Status BaseGenericToSpecializedModel(const AbstractModel& src,
   RETURN_IF_ERROR(
       dst->mutable_features()->Initialize(all_input_features, src.data_spec()));
 
+  dst->initial_prediction = src.initial_predictions()[0];
+  dst->output_logits = src.output_logits();
+
+  // GBT trees output partial regressive scores summed by the engine.
+  const auto set_leaf = [](const NodeWithChildren& src_node,
+                           float* value) -> absl::Status {
+    *value = src_node.node().regressor().top_value();
+    return absl::OkStatus();
+  };
+
   // Compile the model.
-  RETURN_IF_ERROR(FillQuickScorer(src, dst, &accumulator));
+  RETURN_IF_ERROR(FillQuickScorer(src, set_leaf, dst, &accumulator));
 
   return absl::OkStatus();
 }
@@ -882,6 +1530,305 @@ absl::Status GenericToSpecializedModel(
   return BaseGenericToSpecializedModel(src, dst);
 }
 
+// Common part of the compilation of a GBT model into a sharded quick scorer
+// model: compiles each group of "kMaxTreesPerShard" trees into its own quick
+// scorer sub-model. The initial prediction of the model is stored in the first
+// shard (the shard outputs are summed at inference time).
+template <typename AbstractModel, typename SubModel>
+absl::Status ShardedGenericToSpecializedModel(
+    const AbstractModel& src, ShardedQuickScorerModel<SubModel>* dst) {
+  if (src.task() != SubModel::kTask) {
+    return absl::InvalidArgumentError("Wrong model class.");
+  }
+
+  src.metadata().Export(&dst->metadata);
+
+  // List the model input features.
+  std::vector<int> all_input_features;
+  RETURN_IF_ERROR(GetInputFeatures(src, &all_input_features, nullptr));
+
+  RETURN_IF_ERROR(
+      dst->mutable_features()->Initialize(all_input_features, src.data_spec()));
+
+  dst->output_logits = src.output_logits();
+
+  const auto set_leaf = [](const NodeWithChildren& src_node,
+                           float* value) -> absl::Status {
+    *value = src_node.node().regressor().top_value();
+    return absl::OkStatus();
+  };
+
+  const int num_trees = src.NumTrees();
+  constexpr int kMaxTreesPerShard =
+      ShardedQuickScorerModel<SubModel>::kMaxTreesPerShard;
+  const int num_shards =
+      (num_trees + kMaxTreesPerShard - 1) / kMaxTreesPerShard;
+  dst->shards.resize(num_shards);
+
+  // The shards are independent (own tree range, own accumulator): they are
+  // compiled in parallel.
+  const int num_threads =
+      std::min<int>(std::thread::hardware_concurrency(), num_shards);
+  std::vector<absl::Status> statuses(num_shards);
+  {
+    utils::concurrency::ThreadPool pool("QuickScorerBuild",
+                                        std::max(num_threads, 1));
+    pool.StartWorkers();
+    for (int shard_idx = 0; shard_idx < num_shards; ++shard_idx) {
+      pool.Schedule([&src, &set_leaf, &all_input_features, &statuses, dst,
+                     num_trees, shard_idx]() {
+        auto& shard = dst->shards[shard_idx];
+        DetectCpuInstructionSet(&shard);
+        statuses[shard_idx] = [&]() -> absl::Status {
+          RETURN_IF_ERROR(shard.mutable_features()->Initialize(
+              all_input_features, src.data_spec()));
+          shard.initial_prediction =
+              (shard_idx == 0) ? src.initial_predictions()[0] : 0.f;
+          shard.output_logits = src.output_logits();
+
+          typename SubModel::BuildingAccumulator accumulator;
+          const int begin_tree = shard_idx * kMaxTreesPerShard;
+          const int end_tree =
+              std::min(num_trees, begin_tree + kMaxTreesPerShard);
+          return FillQuickScorer(src, set_leaf, begin_tree, end_tree, &shard,
+                                 &accumulator);
+        }();
+      });
+    }
+    // The pool destructor waits for all the compilations.
+  }
+  for (const auto& status : statuses) {
+    RETURN_IF_ERROR(status);
+  }
+
+  return absl::OkStatus();
+}
+
+template <>
+absl::Status GenericToSpecializedModel(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& src,
+    ShardedGradientBoostedTreesRegressionQuickScorerExtended* dst) {
+  if (src.loss() != Loss::SQUARED_ERROR) {
+    return absl::InvalidArgumentError(
+        "The GBDT is not trained for regression with squared error loss.");
+  }
+  return ShardedGenericToSpecializedModel(src, dst);
+}
+
+template <>
+absl::Status GenericToSpecializedModel(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& src,
+    ShardedGradientBoostedTreesRankingQuickScorerExtended* dst) {
+  if (src.loss() != Loss::LAMBDA_MART_NDCG5 &&
+      src.loss() != Loss::XE_NDCG_MART) {
+    return absl::InvalidArgumentError(
+        "The GBDT is not trained for ranking with ranking loss.");
+  }
+  return ShardedGenericToSpecializedModel(src, dst);
+}
+
+template <>
+absl::Status GenericToSpecializedModel(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& src,
+    ShardedGradientBoostedTreesBinaryClassificationQuickScorerExtended* dst) {
+  if ((src.loss() != Loss::BINOMIAL_LOG_LIKELIHOOD &&
+       src.loss() != Loss::BINARY_FOCAL_LOSS) ||
+      src.initial_predictions().size() != 1) {
+    return absl::InvalidArgumentError(
+        "The GBDT is not trained for binary classification with binomial log "
+        "likelihood or binary focal loss.");
+  }
+  return ShardedGenericToSpecializedModel(src, dst);
+}
+
+// Common part of the compilation of a pair of GBT models into a two-stage
+// cascade: each stage is compiled into its own quick scorer sub-model, with
+// both sub-models sharing the same feature layout (the union of the input
+// features of the two stages) so a single example set feeds both stages.
+template <typename AbstractModel, typename SubModel>
+absl::Status BaseCascadeGenericToSpecializedModel(
+    const AbstractModel& src_stage_1, const AbstractModel& src_stage_2,
+    const float lower_threshold, const float upper_threshold,
+    CascadeQuickScorerModel<SubModel>* dst) {
+  if (src_stage_1.task() != SubModel::kTask ||
+      src_stage_2.task() != SubModel::kTask) {
+    return absl::InvalidArgumentError("Wrong model class.");
+  }
+  if (lower_threshold > upper_threshold) {
+    return absl::InvalidArgumentError(
+        "The lower threshold is greater than the upper threshold.");
+  }
+  if (src_stage_1.output_logits() != src_stage_2.output_logits()) {
+    return absl::InvalidArgumentError(
+        "The two stages disagree on \"output_logits\".");
+  }
+
+  src_stage_2.metadata().Export(&dst->metadata);
+  dst->lower_threshold = lower_threshold;
+  dst->upper_threshold = upper_threshold;
+  dst->output_logits = src_stage_1.output_logits();
+
+  // Union of the input features of the two stages.
+  std::vector<int> all_input_features;
+  RETURN_IF_ERROR(GetInputFeatures(src_stage_1, &all_input_features, nullptr));
+  std::vector<int> stage_2_features;
+  RETURN_IF_ERROR(GetInputFeatures(src_stage_2, &stage_2_features, nullptr));
+  all_input_features.insert(all_input_features.end(),
+                            stage_2_features.begin(), stage_2_features.end());
+  std::sort(all_input_features.begin(), all_input_features.end());
+  all_input_features.erase(
+      std::unique(all_input_features.begin(), all_input_features.end()),
+      all_input_features.end());
+
+  RETURN_IF_ERROR(dst->mutable_features()->Initialize(
+      all_input_features, src_stage_2.data_spec()));
+
+  const auto set_leaf = [](const NodeWithChildren& src_node,
+                           float* value) -> absl::Status {
+    *value = src_node.node().regressor().top_value();
+    return absl::OkStatus();
+  };
+
+  // Compile a stage over the union of the input features: the features unused
+  // by the stage simply have no condition attached to them.
+  const auto compile_stage = [&](const AbstractModel& src,
+                                 SubModel* stage) -> absl::Status {
+    DetectCpuInstructionSet(stage);
+    RETURN_IF_ERROR(stage->mutable_features()->Initialize(
+        all_input_features, src_stage_2.data_spec()));
+    stage->initial_prediction = src.initial_predictions()[0];
+    stage->output_logits = src.output_logits();
+    typename SubModel::BuildingAccumulator accumulator;
+    return FillQuickScorer(src, set_leaf, stage, &accumulator);
+  };
+
+  RETURN_IF_ERROR(compile_stage(src_stage_1, &dst->stage_1));
+  RETURN_IF_ERROR(compile_stage(src_stage_2, &dst->stage_2));
+
+  return absl::OkStatus();
+}
+
+template <>
+absl::Status GenericToSpecializedCascadeModel(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& stage_1,
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& stage_2,
+    const float lower_threshold, const float upper_threshold,
+    CascadeGradientBoostedTreesRegressionQuickScorerExtended* dst) {
+  if (stage_1.loss() != Loss::SQUARED_ERROR ||
+      stage_2.loss() != Loss::SQUARED_ERROR) {
+    return absl::InvalidArgumentError(
+        "The GBDT is not trained for regression with squared error loss.");
+  }
+  return BaseCascadeGenericToSpecializedModel(
+      stage_1, stage_2, lower_threshold, upper_threshold, dst);
+}
+
+template <>
+absl::Status GenericToSpecializedCascadeModel(
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& stage_1,
+    const model::gradient_boosted_trees::GradientBoostedTreesModel& stage_2,
+    const float lower_threshold, const float upper_threshold,
+    CascadeGradientBoostedTreesBinaryClassificationQuickScorerExtended* dst) {
+  for (const auto* stage : {&stage_1, &stage_2}) {
+    if ((stage->loss() != Loss::BINOMIAL_LOG_LIKELIHOOD &&
+         stage->loss() != Loss::BINARY_FOCAL_LOSS) ||
+        stage->initial_predictions().size() != 1) {
+      return absl::InvalidArgumentError(
+          "The GBDT is not trained for binary classification with binomial "
+          "log likelihood or binary focal loss.");
+    }
+  }
+  return BaseCascadeGenericToSpecializedModel(
+      stage_1, stage_2, lower_threshold, upper_threshold, dst);
+}
+
+// Common part of the compilation of a Random Forest model into a quick scorer
+// model. The tree votes are averaged by folding the 1/num_trees normalization
+// into the leaf values (like the other optimized RF engines), so the engine's
+// plain sum of leaf values directly produces the model output.
+template <typename CompiledModel, typename SetLeafFn>
+absl::Status BaseRandomForestToSpecializedModel(
+    const model::random_forest::RandomForestModel& src, CompiledModel* dst,
+    const SetLeafFn& set_leaf) {
+  DetectCpuInstructionSet(dst);
+
+  if (src.task() != CompiledModel::kTask) {
+    return absl::InvalidArgumentError("Wrong model class.");
+  }
+
+  src.metadata().Export(&dst->metadata);
+
+  typename CompiledModel::BuildingAccumulator accumulator;
+
+  // List the model input features.
+  std::vector<int> all_input_features;
+  RETURN_IF_ERROR(GetInputFeatures(src, &all_input_features, nullptr));
+
+  RETURN_IF_ERROR(
+      dst->mutable_features()->Initialize(all_input_features, src.data_spec()));
+
+  // Compile the model.
+  RETURN_IF_ERROR(FillQuickScorer(src, set_leaf, dst, &accumulator));
+
+  return absl::OkStatus();
+}
+
+template <>
+absl::Status GenericToSpecializedModel(
+    const model::random_forest::RandomForestModel& src,
+    RandomForestBinaryClassificationQuickScorerExtended* dst) {
+  if (src.label_col_spec().categorical().number_of_unique_values() != 3) {
+    return absl::InvalidArgumentError(
+        "The Random Forest is not a binary classifier.");
+  }
+  const float num_trees = src.NumTrees();
+  const bool winner_take_all = src.winner_take_all_inference();
+  const auto set_leaf = [num_trees, winner_take_all](
+                            const NodeWithChildren& src_node,
+                            float* value) -> absl::Status {
+    if (winner_take_all) {
+      const int32_t vote = src_node.node().classifier().top_value();
+      if (vote == dataset::kOutOfDictionaryItemIndex) {
+        return absl::InvalidArgumentError(
+            "This inference engine optimized for speed only supports model "
+            "outputting out-of-bag values. This can be caused by two errors: "
+            "1) Have rare label values (by default <10 on the entire training "
+            "dataset) and not setting \"min_vocab_frequency\" appropriately. "
+            "2) Having \"is_already_integerized=true\" and providing label "
+            "with \"OOB\"(=0) values during training.");
+      }
+      if (vote > 2) {
+        return absl::InvalidArgumentError(
+            "The model is not a binary classifier.");
+      }
+      *value = (vote == 2) ? (1.f / num_trees) : 0.f;
+    } else {
+      const auto& distribution = src_node.node().classifier().distribution();
+      if (distribution.counts_size() != 3) {
+        return absl::InvalidArgumentError(
+            "The model is not a binary classifier.");
+      }
+      *value = static_cast<float>(distribution.counts(2) /
+                                  (distribution.sum() * num_trees));
+    }
+    return absl::OkStatus();
+  };
+  return BaseRandomForestToSpecializedModel(src, dst, set_leaf);
+}
+
+template <>
+absl::Status GenericToSpecializedModel(
+    const model::random_forest::RandomForestModel& src,
+    RandomForestRegressionQuickScorerExtended* dst) {
+  const float num_trees = src.NumTrees();
+  const auto set_leaf = [num_trees](const NodeWithChildren& src_node,
+                                    float* value) -> absl::Status {
+    *value = src_node.node().regressor().top_value() / num_trees;
+    return absl::OkStatus();
+  };
+  return BaseRandomForestToSpecializedModel(src, dst, set_leaf);
+}
+
 template <typename CompiledModel>
 absl::Status CreateEmptyModel(const std::vector<int>& input_features,
                               const DataSpecification& dataspec,
@@ -1050,6 +1997,19 @@ std::string DescribeQuickScorer(const Model& model, const bool detailed) {
   }
   absl::StrAppend(&structure, "\n");
 
+  // Oblique conditions.
+  absl::SubstituteAndAppend(&structure, "Conditions [oblique] ($0):\n",
+                            model.oblique_conditions.size());
+  if (detailed) {
+    for (const auto& item : model.oblique_conditions) {
+      absl::SubstituteAndAppend(&structure,
+                                "\t\ttree:$0 thre:$1 num_projections:$2\n",
+                                item.tree_idx, item.threshold,
+                                item.end_projection - item.begin_projection);
+    }
+  }
+  absl::StrAppend(&structure, "\n");
+
   return structure;
 }
 
@@ -33,6 +33,10 @@
 //
 // Important: This library works faster if AVX2 is enabled at computation:
 //   Add "--copt=-mavx2" to the build call.
+//   On AVX-512 capable fleets (e.g. Ice Lake, Sapphire Rapids), also add
+//   "--copt=-mavx512f --copt=-mavx512vl" to enable the 512-bit path which
+//   processes twice as many examples per SIMD batch. The instruction set is
+//   re-checked at runtime, so such a binary still runs on AVX2-only CPUs.
 //   Add "requirements = {constraints = cpu_features.require(['avx2'])}" to your
 //     borgcfg.
 //   Add a "tricorder > builder > copt: '-mavx2'", in your METADATA for your
@@ -49,6 +53,10 @@
 //   - Maximum of 128 nodes per trees (e.g. max depth = 6).
 //   - Maximum of 65k unique input features.
 //   - Support categorical and numerical features.
+//   - Sparse oblique and "is NA" conditions are supported: oblique nodes are
+//     evaluated one example at a time outside of the SIMD path, and "is NA"
+//     conditions are always false once the missing values have been replaced
+//     by global imputation (a requirement of this engine).
 //
 // Unlike the other simpleML optimized inference engine, categorical are not
 // restricted to have a maximum of 32 unique values.
@@ -163,6 +171,13 @@ struct QuickScorerExtendedModel {
   bool cpu_supports_avx2 = true;
 #endif
 
+#if defined(__AVX2__) && defined(__AVX512F__) && defined(__AVX512VL__)
+  // This flag is set during the compilation of the model and indicates if the
+  // CPU supports the AVX-512 instructions (F and VL subsets) used by the
+  // 512-bit inference path.
+  bool cpu_supports_avx512 = true;
+#endif
+
   // Data for "IsHigher" conditions i.e. condition of the form "feature >= t".
   struct IsHigherConditionItem {
     float threshold;
@@ -203,9 +218,32 @@ struct QuickScorerExtendedModel {
     std::vector<std::pair<TreeIdx, LeafMask>> mask_buffer;
   };
 
+  // Data for sparse oblique conditions i.e. conditions of the form
+  // "\sum_i weights[i] * feature_i >= threshold". Oblique nodes are expected
+  // to be rare in a model; they are evaluated one example at a time (no SIMD)
+  // and AND their mask on the active leaf bitmap like the other conditions, so
+  // a few oblique nodes do not demote the rest of the model to a slower
+  // engine.
+  struct ObliqueConditionItem {
+    // Range of the projection in "oblique_weights" and
+    // "oblique_internal_feature_idxs".
+    int begin_projection;
+    int end_projection;
+
+    float threshold;
+    TreeIdx tree_idx;
+    LeafMask leaf_mask;
+  };
+
   std::vector<IsHigherConditions> is_higher_conditions;
   std::vector<ContainsConditions> categorical_contains_conditions;
   std::vector<SparseContainsConditions> categoricalset_contains_conditions;
+  std::vector<ObliqueConditionItem> oblique_conditions;
+
+  // Weights and internal feature indices of the oblique projections, indexed
+  // by the ranges in "oblique_conditions".
+  std::vector<float> oblique_weights;
+  std::vector<int> oblique_internal_feature_idxs;
 
   // Structure used during the compilation of the model and discarded at the
   // end.
@@ -266,6 +304,129 @@ struct GradientBoostedTreesRankingQuickScorerExtended
   static constexpr model::proto::Task kTask = model::proto::Task::RANKING;
 };
 
+// Specialization of quick scorer for Random Forest binary classification
+// model. The 1/num_trees vote normalization is folded into the leaf values at
+// compilation time, so the engine outputs probabilities directly (without
+// activation function).
+struct RandomForestBinaryClassificationQuickScorerExtended
+    : internal::QuickScorerExtendedModel {
+  static constexpr model::proto::Task kTask =
+      model::proto::Task::CLASSIFICATION;
+};
+
+// Specialization of quick scorer for Random Forest regression model. Like for
+// binary classification, the leaf values are pre-divided by the number of
+// trees.
+struct RandomForestRegressionQuickScorerExtended
+    : internal::QuickScorerExtendedModel {
+  static constexpr model::proto::Task kTask = model::proto::Task::REGRESSION;
+};
+
+// Quick scorer model sharded over the trees: the ensemble is split into
+// sub-models of at most "kMaxTreesPerShard" trees each, scored back-to-back
+// and summed. Sharding keeps the per-shard active-leaf working set within the
+// stack budget (and the L1 cache) for arbitrarily large ensembles, where the
+// flat quick scorer has to fall back to a heap allocated buffer.
+//
+// Note: The "kMaxLeafs" leaves-per-tree limit is inherent to the 64-bit leaf
+// mask representation and also applies to each shard.
+template <typename SubModel>
+struct ShardedQuickScorerModel {
+  using ExampleSet =
+      ExampleSetNumericalOrCategoricalFlat<ShardedQuickScorerModel<SubModel>,
+                                           ExampleFormat::FORMAT_FEATURE_MAJOR>;
+  using ValueType = NumericalOrCategoricalValue;
+
+  static constexpr model::proto::Task kTask = SubModel::kTask;
+
+  // Maximum number of trees in each shard. With the largest SIMD batch (8
+  // examples), "256 trees * 8 examples * 8 bytes = 16kB" i.e. the maximum
+  // stack usage of the flat quick scorer.
+  static constexpr int kMaxTreesPerShard = 256;
+
+  const typename ExampleSet::FeaturesDefinition& features() const {
+    return intern_features;
+  }
+
+  typename ExampleSet::FeaturesDefinition* mutable_features() {
+    return &intern_features;
+  }
+
+  typename ExampleSet::FeaturesDefinition intern_features;
+
+  // Quick scorer sub-models. All the shards share the same feature definition
+  // as the sharded model, so example sets can be fed to every shard unchanged.
+  // The initial prediction of the model is stored in the first shard.
+  std::vector<SubModel> shards;
+
+  // If true, do not apply the activation function of the model (if any).
+  bool output_logits = false;
+
+  model::proto::Metadata metadata;
+};
+
+using ShardedGradientBoostedTreesRegressionQuickScorerExtended =
+    ShardedQuickScorerModel<GradientBoostedTreesRegressionQuickScorerExtended>;
+using ShardedGradientBoostedTreesBinaryClassificationQuickScorerExtended =
+    ShardedQuickScorerModel<
+        GradientBoostedTreesBinaryClassificationQuickScorerExtended>;
+using ShardedGradientBoostedTreesRankingQuickScorerExtended =
+    ShardedQuickScorerModel<GradientBoostedTreesRankingQuickScorerExtended>;
+
+// Two-stage cascade of quick scorer models. All the examples are scored by
+// the (typically small) first stage; only the examples whose first stage
+// score falls in the uncertainty band "[lower_threshold, upper_threshold]"
+// (inclusive bounds) are re-scored by the (typically large) second stage.
+// When most of the examples are resolved by the first stage, the cascade is
+// close to the first stage in latency and close to the second stage in
+// quality.
+//
+// The two stages and the cascade share the same feature definition (the
+// union of the input features of the two stages), so a single example set is
+// fed to both stages without copies.
+//
+// The thresholds are expressed in the output space of the engine i.e. after
+// the activation function (e.g. probabilities for binary classification), or
+// in logits if "output_logits" is set.
+template <typename SubModel>
+struct CascadeQuickScorerModel {
+  using ExampleSet =
+      ExampleSetNumericalOrCategoricalFlat<CascadeQuickScorerModel<SubModel>,
+                                           ExampleFormat::FORMAT_FEATURE_MAJOR>;
+  using ValueType = NumericalOrCategoricalValue;
+
+  static constexpr model::proto::Task kTask = SubModel::kTask;
+
+  const typename ExampleSet::FeaturesDefinition& features() const {
+    return intern_features;
+  }
+
+  typename ExampleSet::FeaturesDefinition* mutable_features() {
+    return &intern_features;
+  }
+
+  typename ExampleSet::FeaturesDefinition intern_features;
+
+  // Quick scorer sub-models of the two stages.
+  SubModel stage_1;
+  SubModel stage_2;
+
+  // Uncertainty band of the first stage scores (inclusive bounds).
+  float lower_threshold = 0.f;
+  float upper_threshold = 0.f;
+
+  // If true, do not apply the activation function of the model (if any).
+  bool output_logits = false;
+
+  model::proto::Metadata metadata;
+};
+
+using CascadeGradientBoostedTreesRegressionQuickScorerExtended =
+    CascadeQuickScorerModel<GradientBoostedTreesRegressionQuickScorerExtended>;
+using CascadeGradientBoostedTreesBinaryClassificationQuickScorerExtended =
+    CascadeQuickScorerModel<
+        GradientBoostedTreesBinaryClassificationQuickScorerExtended>;
+
 // Computes the model's prediction on a batch of examples.
 //
 // This method is thread safe.
@@ -293,6 +454,24 @@ template <typename Model>
 void Predict(const Model& model, const typename Model::ExampleSet& examples,
              int num_examples, std::vector<float>* predictions);
 
+// Version of PredictQuickScorer reading the features directly from a
+// caller-owned column-major buffer, without copying them into an ExampleSet.
+//
+// "examples" contains the fixed-length features of the model in the same
+// feature-major layout as "ExampleSet": the j-th feature (ordered as
+// "model.features().fixed_length_features()") of the i-th example is
+// "examples[i + j * major_feature_offset]". "major_feature_offset" is
+// typically the number of examples in the buffer. As the buffers are expected
+// to be fully managed by the caller, missing values must already be replaced
+// (see "fixed_length_na_replacement_values()").
+//
+// Only available for models without categorical-set features.
+template <typename Model>
+void PredictQuickScorerColumnMajor(const Model& model,
+                                   const NumericalOrCategoricalValue* examples,
+                                   int num_examples, int major_feature_offset,
+                                   std::vector<float>* predictions);
+
 // Converts a generic GradientBoostedTreesModel with regression loss into a
 // quick scorer compatible model.
 //
@@ -307,6 +486,16 @@ template <typename AbstractModel, typename CompiledModel>
 absl::Status GenericToSpecializedModel(const AbstractModel& src,
                                        CompiledModel* dst);
 
+// Compiles a pair of generic models into a two-stage cascade (see
+// "CascadeQuickScorerModel"). The two models must be trained for the same
+// task, with the same loss, on the same dataspec.
+template <typename AbstractModel, typename CompiledModel>
+absl::Status GenericToSpecializedCascadeModel(const AbstractModel& stage_1,
+                                              const AbstractModel& stage_2,
+                                              float lower_threshold,
+                                              float upper_threshold,
+                                              CompiledModel* dst);
+
 // Creates an empty model that returns a constant value (e.g. 0 for regression)
 // but which consumes (and ignores) the input features specified at
 // construction.
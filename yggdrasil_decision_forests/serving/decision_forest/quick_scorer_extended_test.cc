@@ -17,6 +17,7 @@
 #include "gtest/gtest.h"
 #include "yggdrasil_decision_forests/model/decision_tree/decision_tree.h"
 #include "yggdrasil_decision_forests/model/gradient_boosted_trees/gradient_boosted_trees.h"
+#include "yggdrasil_decision_forests/model/random_forest/random_forest.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 
 #include "yggdrasil_decision_forests/serving/decision_forest/quick_scorer_extended.h"
@@ -245,6 +246,47 @@ TEST(QuickScorer, Compilation) {
                           1 + 1 + 10 + 300 + 20000));
 }
 
+TEST(QuickScorer, ColumnMajorBuffer) {
+  GradientBoostedTreesModel model;
+  dataset::VerticalDataset dataset;
+  BuildToyModelAndToyDataset(model::proto::Task::REGRESSION,
+                             /*use_cateset_feature=*/false, &model, &dataset);
+  GradientBoostedTreesRegressionQuickScorerExtended quick_scorer_model;
+  CHECK_OK(GenericToSpecializedModel(model, &quick_scorer_model));
+
+  // Caller-owned buffer in the same feature-major layout as the "Compilation"
+  // test, scored without an ExampleSet copy.
+  using V = NumericalOrCategoricalValue;
+  const std::vector<V> examples = {
+      // Feature 1
+      V::Numerical(0.5f),
+      V::Numerical(1.0f),
+      V::Numerical(1.5f),
+      V::Numerical(2.5f),
+      V::Numerical(3.5f),
+      // Feature 2
+      V::Categorical(0),
+      V::Categorical(1),
+      V::Categorical(2),
+      V::Categorical(0),
+      V::Categorical(1),
+      // Feature 3
+      V::Numerical(0.00f),
+      V::Numerical(0.05f),
+      V::Numerical(0.10f),
+      V::Numerical(0.20f),
+      V::Numerical(0.30f),
+  };
+  std::vector<float> predictions;
+  PredictQuickScorerColumnMajor(quick_scorer_model, examples.data(), 5,
+                                /*major_feature_offset=*/5, &predictions);
+
+  EXPECT_THAT(predictions,
+              ElementsAre(1 + 4 + 40 + 400 + 10000, 1 + 3 + 20 + 300 + 10000,
+                          1 + 3 + 20 + 400 + 20000, 1 + 2 + 30 + 400 + 20000,
+                          1 + 1 + 10 + 300 + 20000));
+}
+
 TEST(QuickScorer, ExampleSet) {
   GradientBoostedTreesModel model;
   dataset::VerticalDataset dataset;
@@ -314,6 +356,259 @@ TEST(QuickScorer, ExampleSet) {
                                        1 + 1 + 10 + 300 + 2000 + 20000));
 }
 
+TEST(QuickScorer, RandomForestRegression) {
+  model::random_forest::RandomForestModel model;
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "l" }
+    columns { type: NUMERICAL name: "a" }
+  )pb");
+  model.set_task(model::proto::Task::REGRESSION);
+  model.set_label_col_idx(0);
+  model.set_data_spec(dataspec);
+
+  const auto add_stump = [&model](const float threshold, const float neg_value,
+                                  const float pos_value) {
+    auto tree = absl::make_unique<DecisionTree>();
+    tree->CreateRoot();
+    auto* root = tree->mutable_root();
+    root->CreateChildren();
+    auto* condition = root->mutable_node()->mutable_condition();
+    condition->set_attribute(1);
+    condition->mutable_condition()->mutable_higher_condition()->set_threshold(
+        threshold);
+    root->mutable_neg_child()->mutable_node()->mutable_regressor()->set_top_value(
+        neg_value);
+    root->mutable_pos_child()->mutable_node()->mutable_regressor()->set_top_value(
+        pos_value);
+    model.mutable_decision_trees()->push_back(std::move(tree));
+  };
+  add_stump(/*threshold=*/2.0f, /*neg_value=*/1.f, /*pos_value=*/3.f);
+  add_stump(/*threshold=*/1.0f, /*neg_value=*/2.f, /*pos_value=*/6.f);
+
+  RandomForestRegressionQuickScorerExtended quick_scorer_model;
+  CHECK_OK(GenericToSpecializedModel(model, &quick_scorer_model));
+
+  const auto model_description = DescribeQuickScorer(quick_scorer_model);
+  LOG(INFO) << "Model:\n" << model_description;
+
+  // The predictions are the average of the tree values.
+  using V = NumericalOrCategoricalValue;
+  std::vector<V> examples = {
+      V::Numerical(0.5f),
+      V::Numerical(1.5f),
+      V::Numerical(2.5f),
+  };
+  std::vector<float> predictions;
+  PredictQuickScorer(quick_scorer_model, examples, 3, &predictions);
+  EXPECT_THAT(predictions,
+              ElementsAre((1 + 2) / 2.f, (1 + 6) / 2.f, (3 + 6) / 2.f));
+}
+
+TEST(QuickScorer, ObliqueCondition) {
+  GradientBoostedTreesModel model;
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "l" }
+    columns { type: NUMERICAL name: "a" }
+    columns { type: NUMERICAL name: "b" }
+  )pb");
+  model.set_task(model::proto::Task::REGRESSION);
+  model.set_label_col_idx(0);
+  model.set_data_spec(dataspec);
+  model.set_loss(Loss::SQUARED_ERROR);
+  model.mutable_initial_predictions()->push_back(0.f);
+
+  // Axis-aligned stump "a>=2".
+  {
+    auto tree = absl::make_unique<DecisionTree>();
+    tree->CreateRoot();
+    auto* root = tree->mutable_root();
+    root->CreateChildren();
+    auto* condition = root->mutable_node()->mutable_condition();
+    condition->set_attribute(1);
+    condition->mutable_condition()->mutable_higher_condition()->set_threshold(
+        2.0f);
+    root->mutable_neg_child()
+        ->mutable_node()
+        ->mutable_regressor()
+        ->set_top_value(1.f);
+    root->mutable_pos_child()
+        ->mutable_node()
+        ->mutable_regressor()
+        ->set_top_value(2.f);
+    model.mutable_decision_trees()->push_back(std::move(tree));
+  }
+
+  // Oblique stump "a-0.5*b>=1".
+  {
+    auto tree = absl::make_unique<DecisionTree>();
+    tree->CreateRoot();
+    auto* root = tree->mutable_root();
+    root->CreateChildren();
+    auto* condition = root->mutable_node()->mutable_condition();
+    condition->set_attribute(1);
+    auto* oblique = condition->mutable_condition()->mutable_oblique_condition();
+    oblique->add_attributes(1);
+    oblique->add_weights(1.f);
+    oblique->add_attributes(2);
+    oblique->add_weights(-0.5f);
+    oblique->set_threshold(1.f);
+    root->mutable_neg_child()
+        ->mutable_node()
+        ->mutable_regressor()
+        ->set_top_value(10.f);
+    root->mutable_pos_child()
+        ->mutable_node()
+        ->mutable_regressor()
+        ->set_top_value(20.f);
+    model.mutable_decision_trees()->push_back(std::move(tree));
+  }
+
+  GradientBoostedTreesRegressionQuickScorerExtended quick_scorer_model;
+  CHECK_OK(GenericToSpecializedModel(model, &quick_scorer_model));
+
+  const auto model_description = DescribeQuickScorer(quick_scorer_model);
+  LOG(INFO) << "Model:\n" << model_description;
+
+  // Examples in FORMAT_FEATURE_MAJOR, see decision_forest.h.
+  using V = NumericalOrCategoricalValue;
+  std::vector<V> examples = {
+      // Feature "a"
+      V::Numerical(0.5f),
+      V::Numerical(3.0f),
+      V::Numerical(2.0f),
+      // Feature "b"
+      V::Numerical(0.0f),
+      V::Numerical(0.0f),
+      V::Numerical(4.0f),
+  };
+  std::vector<float> predictions;
+  PredictQuickScorer(quick_scorer_model, examples, 3, &predictions);
+
+  // Projection values: 0.5, 3.0 and 0.0.
+  EXPECT_THAT(predictions, ElementsAre(1 + 10, 2 + 20, 2 + 10));
+}
+
+TEST(QuickScorer, ShardedMatchesFlat) {
+  const int duplicate_factor = 100;  // i.e. 400 trees i.e. 2 shards.
+
+  GradientBoostedTreesModel model;
+  dataset::VerticalDataset dataset;
+  BuildToyModelAndToyDataset(model::proto::Task::REGRESSION,
+                             /*use_cateset_feature=*/false, &model, &dataset,
+                             duplicate_factor);
+
+  GradientBoostedTreesRegressionQuickScorerExtended flat_model;
+  CHECK_OK(GenericToSpecializedModel(model, &flat_model));
+
+  ShardedGradientBoostedTreesRegressionQuickScorerExtended sharded_model;
+  CHECK_OK(GenericToSpecializedModel(model, &sharded_model));
+  EXPECT_EQ(sharded_model.shards.size(), 2);
+
+  const int num_examples = 5;
+  GradientBoostedTreesRegressionQuickScorerExtended::ExampleSet flat_examples(
+      num_examples, flat_model);
+  flat_examples.FillMissing(flat_model);
+  ShardedGradientBoostedTreesRegressionQuickScorerExtended::ExampleSet
+      sharded_examples(num_examples, sharded_model);
+  sharded_examples.FillMissing(sharded_model);
+
+  const auto flat_feature =
+      decltype(flat_examples)::GetNumericalFeatureId("b", flat_model).value();
+  const auto sharded_feature =
+      decltype(sharded_examples)::GetNumericalFeatureId("b", sharded_model)
+          .value();
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    flat_examples.SetNumerical(example_idx, flat_feature, example_idx * 0.8f,
+                               flat_model);
+    sharded_examples.SetNumerical(example_idx, sharded_feature,
+                                  example_idx * 0.8f, sharded_model);
+  }
+
+  std::vector<float> flat_predictions;
+  Predict(flat_model, flat_examples, num_examples, &flat_predictions);
+  std::vector<float> sharded_predictions;
+  Predict(sharded_model, sharded_examples, num_examples, &sharded_predictions);
+
+  // The toy leaf values are small integers: the shard-wise summation is exact
+  // and should match the flat engine bit-for-bit.
+  EXPECT_EQ(flat_predictions, sharded_predictions);
+}
+
+TEST(QuickScorer, CascadeEarlyExit) {
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "l" }
+    columns { type: NUMERICAL name: "a" }
+    columns { type: NUMERICAL name: "b" }
+  )pb");
+
+  // Builds a regressive GBT stump "attribute>=threshold" with leaf values
+  // "neg_value" / "pos_value".
+  const auto build_stump = [&](const int attribute, const float threshold,
+                               const float neg_value, const float pos_value,
+                               GradientBoostedTreesModel* model) {
+    model->set_task(model::proto::Task::REGRESSION);
+    model->set_label_col_idx(0);
+    model->set_data_spec(dataspec);
+    model->set_loss(Loss::SQUARED_ERROR);
+    model->mutable_initial_predictions()->push_back(0.f);
+    auto tree = absl::make_unique<DecisionTree>();
+    tree->CreateRoot();
+    auto* root = tree->mutable_root();
+    root->CreateChildren();
+    auto* condition = root->mutable_node()->mutable_condition();
+    condition->set_attribute(attribute);
+    condition->mutable_condition()->mutable_higher_condition()->set_threshold(
+        threshold);
+    root->mutable_neg_child()
+        ->mutable_node()
+        ->mutable_regressor()
+        ->set_top_value(neg_value);
+    root->mutable_pos_child()
+        ->mutable_node()
+        ->mutable_regressor()
+        ->set_top_value(pos_value);
+    model->mutable_decision_trees()->push_back(std::move(tree));
+  };
+
+  // Stage 1 only uses "a", stage 2 only uses "b": the cascade is compiled over
+  // the union of the two feature sets.
+  GradientBoostedTreesModel stage_1;
+  build_stump(/*attribute=*/1, /*threshold=*/2.f, /*neg_value=*/0.f,
+              /*pos_value=*/1.f, &stage_1);
+  GradientBoostedTreesModel stage_2;
+  build_stump(/*attribute=*/2, /*threshold=*/1.f, /*neg_value=*/10.f,
+              /*pos_value=*/20.f, &stage_2);
+
+  CascadeGradientBoostedTreesRegressionQuickScorerExtended cascade_model;
+  CHECK_OK(GenericToSpecializedCascadeModel(stage_1, stage_2,
+                                            /*lower_threshold=*/0.5f,
+                                            /*upper_threshold=*/1.5f,
+                                            &cascade_model));
+
+  const int num_examples = 3;
+  decltype(cascade_model)::ExampleSet examples(num_examples, cascade_model);
+  examples.FillMissing(cascade_model);
+
+  const auto feature_a =
+      decltype(examples)::GetNumericalFeatureId("a", cascade_model).value();
+  const auto feature_b =
+      decltype(examples)::GetNumericalFeatureId("b", cascade_model).value();
+  examples.SetNumerical(0, feature_a, 1.f, cascade_model);
+  examples.SetNumerical(0, feature_b, 5.f, cascade_model);
+  examples.SetNumerical(1, feature_a, 3.f, cascade_model);
+  examples.SetNumerical(1, feature_b, 0.f, cascade_model);
+  examples.SetNumerical(2, feature_a, 3.f, cascade_model);
+  examples.SetNumerical(2, feature_b, 2.f, cascade_model);
+
+  std::vector<float> predictions;
+  Predict(cascade_model, examples, num_examples, &predictions);
+
+  // Example 0 scores 0 in stage 1 (outside of the [0.5, 1.5] band) and exits
+  // early. Examples 1 and 2 score 1 (inside of the band) and are re-scored by
+  // stage 2.
+  EXPECT_THAT(predictions, ElementsAre(0.f, 10.f, 20.f));
+}
+
 TEST(QuickScorer, ExceedStackBuffer) {
   const int duplicate_factor = 200;
 
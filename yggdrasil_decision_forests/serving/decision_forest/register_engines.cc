@@ -139,6 +139,8 @@ bool AllConditionsCompatibleQuickScorerExtendedModels(
       case model::decision_tree::proto::Condition::kTrueValueCondition:
       case model::decision_tree::proto::Condition::kContainsCondition:
       case model::decision_tree::proto::Condition::kContainsBitmapCondition:
+      case model::decision_tree::proto::Condition::kObliqueCondition:
+      case model::decision_tree::proto::Condition::kNaCondition:
         return true;
       default:
         return false;
@@ -353,6 +355,121 @@ REGISTER_FastEngineFactory(
     GradientBoostedTreesQuickScorerFastEngineFactory,
     serving::gradient_boosted_trees::kQuickScorerExtended);
 
+class GradientBoostedTreesShardedQuickScorerFastEngineFactory
+    : public FastEngineFactory {
+ public:
+  using SourceModel = gradient_boosted_trees::GradientBoostedTreesModel;
+
+  std::string name() const override {
+    return serving::gradient_boosted_trees::kQuickScorerExtendedSharded;
+  }
+
+  bool IsCompatible(const AbstractModel* const model) const override {
+    auto* gbt_model = dynamic_cast<const SourceModel*>(model);
+    if (gbt_model == nullptr) {
+      return false;
+    }
+
+    if (!gbt_model->IsMissingValueConditionResultFollowGlobalImputation()) {
+      return false;
+    }
+
+    // Small ensembles are better served by the flat quick scorer: its
+    // active-leaf buffer already fits in the stack budget.
+    if (gbt_model->NumTrees() <=
+        serving::decision_forest::
+            ShardedGradientBoostedTreesRegressionQuickScorerExtended::
+                kMaxTreesPerShard) {
+      return false;
+    }
+
+    for (const auto& src_tree : gbt_model->decision_trees()) {
+      if (src_tree->NumLeafs() > serving::decision_forest::internal::
+                                     QuickScorerExtendedModel::kMaxLeafs) {
+        return false;
+      }
+    }
+
+    if (!AllConditionsCompatibleQuickScorerExtendedModels(
+            gbt_model->decision_trees())) {
+      return false;
+    }
+
+    switch (gbt_model->task()) {
+      case proto::CLASSIFICATION:
+        return gbt_model->label_col_spec()
+                   .categorical()
+                   .number_of_unique_values() == 3;
+      case proto::REGRESSION:
+      case proto::RANKING:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  std::vector<std::string> IsBetterThan() const override {
+    return {serving::gradient_boosted_trees::kGeneric,
+            serving::gradient_boosted_trees::kOptPred,
+            serving::gradient_boosted_trees::kQuickScorerExtended};
+  }
+
+  utils::StatusOr<std::unique_ptr<serving::FastEngine>> CreateEngine(
+      const AbstractModel* const model) const override {
+    auto* gbt_model = dynamic_cast<const SourceModel*>(model);
+    if (!gbt_model) {
+      return absl::InvalidArgumentError("The model is not a GBDT.");
+    }
+
+    if (!gbt_model->IsMissingValueConditionResultFollowGlobalImputation()) {
+      return NoGlobalImputationError(
+          "GradientBoostedTreesShardedQuickScorerFastEngineFactory");
+    }
+
+    switch (gbt_model->task()) {
+      case proto::CLASSIFICATION:
+        if (gbt_model->label_col_spec()
+                .categorical()
+                .number_of_unique_values() == 3) {
+          // Binary classification.
+          auto engine = absl::make_unique<serving::ExampleSetModelWrapper<
+              serving::decision_forest::
+                  ShardedGradientBoostedTreesBinaryClassificationQuickScorerExtended,
+              serving::decision_forest::Predict>>();
+          RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
+          return engine;
+        } else {
+          return absl::InvalidArgumentError("Non supported GBDT model");
+        }
+
+      case proto::REGRESSION: {
+        auto engine = absl::make_unique<serving::ExampleSetModelWrapper<
+            serving::decision_forest::
+                ShardedGradientBoostedTreesRegressionQuickScorerExtended,
+            serving::decision_forest::Predict>>();
+        RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
+        return engine;
+      }
+
+      case proto::RANKING: {
+        auto engine = absl::make_unique<serving::ExampleSetModelWrapper<
+            serving::decision_forest::
+                ShardedGradientBoostedTreesRankingQuickScorerExtended,
+            serving::decision_forest::Predict>>();
+        RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*gbt_model));
+        return engine;
+      }
+
+      default:
+        return absl::InvalidArgumentError("Non supported GBDT model");
+    }
+  }
+};
+
+REGISTER_FastEngineFactory(
+    GradientBoostedTreesShardedQuickScorerFastEngineFactory,
+    serving::gradient_boosted_trees::kQuickScorerExtendedSharded);
+
 class GradientBoostedTreesOptPredFastEngineFactory : public FastEngineFactory {
  public:
   using SourceModel = gradient_boosted_trees::GradientBoostedTreesModel;
@@ -673,5 +790,103 @@ class RandomForestOptPredFastEngineFactory : public model::FastEngineFactory {
 REGISTER_FastEngineFactory(RandomForestOptPredFastEngineFactory,
                            serving::random_forest::kOptPred);
 
+class RandomForestQuickScorerFastEngineFactory
+    : public model::FastEngineFactory {
+ public:
+  using SourceModel = random_forest::RandomForestModel;
+
+  std::string name() const override {
+    return serving::random_forest::kQuickScorerExtended;
+  }
+
+  bool IsCompatible(const AbstractModel* const model) const override {
+    auto* rf_model = dynamic_cast<const SourceModel*>(model);
+    if (rf_model == nullptr) {
+      return false;
+    }
+
+    if (!rf_model->IsMissingValueConditionResultFollowGlobalImputation()) {
+      return false;
+    }
+
+    if (rf_model->NumTrees() > serving::decision_forest::internal::
+                                   QuickScorerExtendedModel::kMaxTrees) {
+      return false;
+    }
+
+    for (const auto& src_tree : rf_model->decision_trees()) {
+      if (src_tree->NumLeafs() > serving::decision_forest::internal::
+                                     QuickScorerExtendedModel::kMaxLeafs) {
+        return false;
+      }
+    }
+
+    if (!AllConditionsCompatibleQuickScorerExtendedModels(
+            rf_model->decision_trees())) {
+      return false;
+    }
+
+    switch (rf_model->task()) {
+      case proto::CLASSIFICATION:
+        return rf_model->label_col_spec()
+                   .categorical()
+                   .number_of_unique_values() == 3;
+      case proto::REGRESSION:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  std::vector<std::string> IsBetterThan() const override {
+    return {serving::random_forest::kGeneric,
+            serving::random_forest::kOptPred};
+  }
+
+  utils::StatusOr<std::unique_ptr<serving::FastEngine>> CreateEngine(
+      const AbstractModel* const model) const override {
+    auto* rf_model = dynamic_cast<const SourceModel*>(model);
+    if (!rf_model) {
+      return absl::InvalidArgumentError("The model is not a RF.");
+    }
+
+    if (!rf_model->IsMissingValueConditionResultFollowGlobalImputation()) {
+      return NoGlobalImputationError(
+          "RandomForestQuickScorerFastEngineFactory");
+    }
+
+    switch (rf_model->task()) {
+      case proto::CLASSIFICATION: {
+        if (rf_model->label_col_spec()
+                .categorical()
+                .number_of_unique_values() != 3) {
+          return absl::InvalidArgumentError("Non supported RF model");
+        }
+        // Binary classification.
+        auto engine = absl::make_unique<serving::ExampleSetModelWrapper<
+            serving::decision_forest::
+                RandomForestBinaryClassificationQuickScorerExtended,
+            serving::decision_forest::Predict>>();
+        RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
+        return engine;
+      }
+
+      case proto::REGRESSION: {
+        auto engine = absl::make_unique<serving::ExampleSetModelWrapper<
+            serving::decision_forest::RandomForestRegressionQuickScorerExtended,
+            serving::decision_forest::Predict>>();
+        RETURN_IF_ERROR(engine->LoadModel<SourceModel>(*rf_model));
+        return engine;
+      }
+
+      default:
+        return absl::InvalidArgumentError("Non supported RF model");
+    }
+  }
+};
+
+REGISTER_FastEngineFactory(RandomForestQuickScorerFastEngineFactory,
+                           serving::random_forest::kQuickScorerExtended);
+
 }  // namespace model
 }  // namespace yggdrasil_decision_forests
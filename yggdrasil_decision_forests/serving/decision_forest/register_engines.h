@@ -28,12 +28,15 @@ namespace gradient_boosted_trees {
 constexpr char kGeneric[] = "GradientBoostedTreesGeneric";
 constexpr char kQuickScorerExtended[] =
     "GradientBoostedTreesQuickScorerExtended";
+constexpr char kQuickScorerExtendedSharded[] =
+    "GradientBoostedTreesQuickScorerExtendedSharded";
 constexpr char kOptPred[] = "GradientBoostedTreesOptPred";
 }  // namespace gradient_boosted_trees
 
 namespace random_forest {
 constexpr char kGeneric[] = "RandomForestGeneric";
 constexpr char kOptPred[] = "RandomForestOptPred";
+constexpr char kQuickScorerExtended[] = "RandomForestQuickScorerExtended";
 }  // namespace random_forest
 
 }  // namespace serving
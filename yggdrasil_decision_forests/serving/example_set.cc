@@ -135,6 +135,28 @@ absl::Status FeaturesDefinitionNumericalOrCategoricalFlat::Initialize(
     feature_def_cache_[feature_def.name] = &feature_def;
   }
 
+  // Vocabulary index of the categorical string input features.
+  categorical_vocabs_.clear();
+  categorical_vocabs_.resize(data_spec_.columns_size());
+  const auto index_vocabulary = [&](const int spec_idx) {
+    const auto& col_spec = data_spec_.columns(spec_idx);
+    if (!dataset::IsCategorical(col_spec.type()) ||
+        col_spec.categorical().is_already_integerized()) {
+      return;
+    }
+    auto& vocab = categorical_vocabs_[spec_idx];
+    vocab.reserve(col_spec.categorical().items_size());
+    for (const auto& item : col_spec.categorical().items()) {
+      vocab[item.first] = item.second.index();
+    }
+  };
+  for (const auto& feature_def : fixed_length_features()) {
+    index_vocabulary(feature_def.spec_idx);
+  }
+  for (const auto& feature_def : categorical_set_features()) {
+    index_vocabulary(feature_def.spec_idx);
+  }
+
   return absl::OkStatus();
 }
 
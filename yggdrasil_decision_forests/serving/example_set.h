@@ -373,6 +373,16 @@ class FeaturesDefinitionNumericalOrCategoricalFlat {
   // Specification of the features.
   const DataSpecification& data_spec() const { return data_spec_; }
 
+  // Vocabulary index (value string to integer value) of a categorical input
+  // column, indexed by dataspec column index. Built by "Initialize":
+  // resolving a string value is one hash and one open-addressed probe,
+  // without going through the proto item map of the dataspec. Empty for
+  // non-categorical and already-integerized columns.
+  const absl::flat_hash_map<std::string, int32_t>& categorical_vocabulary(
+      const int spec_idx) const {
+    return categorical_vocabs_[spec_idx];
+  }
+
   // Representation of missing values for fixed length features.
   const std::vector<NumericalOrCategoricalValue>&
   fixed_length_na_replacement_values() const {
@@ -416,6 +426,10 @@ class FeaturesDefinitionNumericalOrCategoricalFlat {
   // List of "unstacked" features (similar to "unstackeds" in the dataspec).
   std::vector<UnstackedFeature> unstacked_features_;
 
+  // Vocabulary index of the categorical string input features. See
+  // "categorical_vocabulary".
+  std::vector<absl::flat_hash_map<std::string, int32_t>> categorical_vocabs_;
+
   // Index  "original name" to its index in "unstacked_features_".
   absl::flat_hash_map<std::string, int> indexed_unstacked_features_;
 };
@@ -505,6 +519,14 @@ class AbstractExampleSet {
                             const FeaturesDefinition& features,
                             AbstractExampleSet* dst) const = 0;
 
+  // Copies the examples [begin, end) of "this" into "dst" starting at the
+  // example "dst_begin". Unlike "Copy", "dst" is not cleared: the caller
+  // should call "dst->Clear()" once before assembling a batch from several
+  // sources.
+  virtual absl::Status CopyTo(int64_t begin, int64_t end, int64_t dst_begin,
+                              const FeaturesDefinition& features,
+                              AbstractExampleSet* dst) const = 0;
+
   virtual absl::Status FromProtoExample(const dataset::proto::Example& src,
                                         const int example_idx,
                                         const FeaturesDefinition& features) = 0;
@@ -513,6 +535,14 @@ class AbstractExampleSet {
       const int example_idx, const FeaturesDefinition& features) const = 0;
 
   virtual void Clear() = 0;
+
+  // Changes the number of examples in the example set. The existing feature
+  // values are invalidated (like after "Clear"), but the underlying buffers
+  // are re-used: resizing an example set to at most its past maximum size
+  // does not allocate. This allows steady-state serving code to allocate an
+  // example set once and re-use it across batches of varying sizes without
+  // touching the heap.
+  virtual void Resize(int num_examples, const FeaturesDefinition& features) = 0;
 };
 
 // ExampleSet implementation where attribute (feature) values are stored either
@@ -610,6 +640,23 @@ class ExampleSetNumericalOrCategoricalFlat : public AbstractExampleSet {
     categorical_item_buffer_.clear();
   }
 
+  // Changes the number of examples. The feature values become undefined but
+  // the buffer capacities are preserved: no allocation happens unless
+  // "num_examples" exceeds the largest size this example set ever had.
+  void Resize(const int num_examples,
+              const FeaturesDefinition& features) override {
+    num_examples_ = num_examples;
+    fixed_length_features_.resize(num_examples *
+                                  features.fixed_length_features().size());
+    categorical_set_begins_and_ends_.resize(
+        num_examples * features.categorical_set_features().size());
+    categorical_item_buffer_.clear();
+  }
+
+  void Resize(const int num_examples, const Model& model) {
+    Resize(num_examples, model.features());
+  }
+
   // Set the value of a numerical feature.
   void SetNumerical(const int example_idx, const NumericalFeatureId feature_id,
                     const float value,
@@ -708,10 +755,22 @@ class ExampleSetNumericalOrCategoricalFlat : public AbstractExampleSet {
         << "\" should be passed as an integer";
 #endif
 
+    const int spec_idx =
+        features.fixed_length_features()[feature_id.index].spec_idx;
+    const auto& vocab = features.categorical_vocabulary(spec_idx);
+    if (!vocab.empty()) {
+      const auto it = vocab.find(value);
+      SetCategorical(example_idx, feature_id,
+                     (it != vocab.end())
+                         ? it->second
+                         : dataset::kOutOfDictionaryItemIndex,
+                     features);
+      return;
+    }
+    // Already-integerized columns and empty vocabularies go through the
+    // generic conversion.
     const auto int_value = dataset::CategoricalStringToValueWithStatus(
-        value,
-        features.data_spec().columns(
-            features.fixed_length_features()[feature_id.index].spec_idx));
+        value, features.data_spec().columns(spec_idx));
     if (int_value.ok()) {
       SetCategorical(example_idx, feature_id, int_value.value(), features);
     }
@@ -772,14 +831,25 @@ class ExampleSetNumericalOrCategoricalFlat : public AbstractExampleSet {
     auto& dst_range = categorical_set_begins_and_ends_[CategoricalSetIndex(
         example_idx, feature_id.index, features)];
     dst_range.begin = categorical_item_buffer_.size();
-    for (const auto& value : values) {
-      auto value_idx_or = dataset::CategoricalStringToValueWithStatus(
-          value,
-          features.data_spec().columns(
-              features.categorical_set_features()[feature_id.index].spec_idx));
-
-      if (value_idx_or.ok()) {
-        categorical_item_buffer_.push_back(value_idx_or.value());
+    const int spec_idx =
+        features.categorical_set_features()[feature_id.index].spec_idx;
+    const auto& vocab = features.categorical_vocabulary(spec_idx);
+    if (!vocab.empty()) {
+      for (const auto& value : values) {
+        const auto it = vocab.find(value);
+        categorical_item_buffer_.push_back(
+            (it != vocab.end()) ? it->second
+                                : dataset::kOutOfDictionaryItemIndex);
+      }
+    } else {
+      // Already-integerized columns and empty vocabularies go through the
+      // generic conversion.
+      for (const auto& value : values) {
+        auto value_idx_or = dataset::CategoricalStringToValueWithStatus(
+            value, features.data_spec().columns(spec_idx));
+        if (value_idx_or.ok()) {
+          categorical_item_buffer_.push_back(value_idx_or.value());
+        }
       }
     }
     dst_range.end = categorical_item_buffer_.size();
@@ -927,6 +997,25 @@ class ExampleSetNumericalOrCategoricalFlat : public AbstractExampleSet {
     return Copy(begin, end, features, casted_dst);
   }
 
+  // See the documentation of "AbstractExampleSet::CopyTo".
+  absl::Status CopyTo(
+      int64_t begin, int64_t end, int64_t dst_begin,
+      const FeaturesDefinition& features,
+      ExampleSetNumericalOrCategoricalFlat<Model, format>* dst) const;
+
+  absl::Status CopyTo(int64_t begin, int64_t end, int64_t dst_begin,
+                      const FeaturesDefinition& features,
+                      AbstractExampleSet* dst) const override {
+    auto* casted_dst =
+        dynamic_cast<ExampleSetNumericalOrCategoricalFlat<Model, format>*>(dst);
+    if (casted_dst == nullptr) {
+      return absl::InvalidArgumentError(
+          "Cannot copy an ExampleSet to another ExampleSet of a different "
+          "type.");
+    }
+    return CopyTo(begin, end, dst_begin, features, casted_dst);
+  }
+
   // Number of examples in the example set.
   int NumberOfExamples() const { return num_examples_; }
 
@@ -1062,14 +1151,30 @@ void ExampleSetNumericalOrCategoricalFlat<Model, format>::FillMissing(
     const FeaturesDefinition& features) {
   Clear();
 
+  // The missing values form, for each example, the same template row: the
+  // buffer is reset with contiguous block copies / fills instead of
+  // element-wise indexed writes.
+  const auto& na_values = features.fixed_length_na_replacement_values();
   const auto num_fixed_features = features.fixed_length_features().size();
-  for (int fixed_feature_idx = 0; fixed_feature_idx < num_fixed_features;
-       fixed_feature_idx++) {
+  if constexpr (format == ExampleFormat::FORMAT_EXAMPLE_MAJOR) {
+    // Each example is a copy of the template row.
     for (int example_idx = 0; example_idx < num_examples_; example_idx++) {
-      fixed_length_features_[FixedLengthIndex(example_idx, fixed_feature_idx,
-                                              features)] =
-          features.fixed_length_na_replacement_values()[fixed_feature_idx];
+      std::copy(na_values.begin(), na_values.end(),
+                fixed_length_features_.begin() +
+                    example_idx * num_fixed_features);
+    }
+  } else if constexpr (format == ExampleFormat::FORMAT_FEATURE_MAJOR) {
+    // All the examples of a feature block share the feature's missing value.
+    for (int fixed_feature_idx = 0; fixed_feature_idx < num_fixed_features;
+         fixed_feature_idx++) {
+      const auto it_feature =
+          fixed_length_features_.begin() +
+          fixed_feature_idx * static_cast<size_t>(num_examples_);
+      std::fill(it_feature, it_feature + num_examples_,
+                na_values[fixed_feature_idx]);
     }
+  } else {
+    static_assert(!std::is_same<Model, Model>::value, "Unsupported format.");
   }
 
   // Add the value kMissingCategoricalSetValue (-1) as the first element
@@ -1088,20 +1193,33 @@ absl::Status ExampleSetNumericalOrCategoricalFlat<Model, format>::Copy(
         "The destination does not contain enough examples.");
   }
   dst->Clear();
+  return CopyTo(begin, end, /*dst_begin=*/0, features, dst);
+}
+
+template <typename Model, ExampleFormat format>
+absl::Status ExampleSetNumericalOrCategoricalFlat<Model, format>::CopyTo(
+    int64_t begin, int64_t end, int64_t dst_begin,
+    const FeaturesDefinition& features,
+    ExampleSetNumericalOrCategoricalFlat<Model, format>* dst) const {
+  if (dst->NumberOfExamples() < dst_begin + end - begin) {
+    return absl::OutOfRangeError(
+        "The destination does not contain enough examples.");
+  }
 
   // Copy of the fixed-length features.
   if constexpr (format == ExampleFormat::FORMAT_EXAMPLE_MAJOR) {
     const auto num_features = features.fixed_length_features().size();
     std::copy(fixed_length_features_.begin() + begin * num_features,
               fixed_length_features_.begin() + end * num_features,
-              dst->fixed_length_features_.begin());
+              dst->fixed_length_features_.begin() + dst_begin * num_features);
   } else if constexpr (format == ExampleFormat::FORMAT_FEATURE_MAJOR) {
     for (const auto& feature : features.fixed_length_features()) {
       const auto it_src_feature = fixed_length_features_.begin() +
                                   feature.internal_idx * NumberOfExamples();
       std::copy(it_src_feature + begin, it_src_feature + end,
                 dst->fixed_length_features_.begin() +
-                    feature.internal_idx * dst->NumberOfExamples());
+                    feature.internal_idx * dst->NumberOfExamples() +
+                    dst_begin);
     }
   } else {
     static_assert(!std::is_same<Model, Model>::value, "Unsupported format.");
@@ -1115,7 +1233,8 @@ absl::Status ExampleSetNumericalOrCategoricalFlat<Model, format>::Copy(
                                            feature.internal_idx *
                                                NumberOfExamples()];
       dst->SetCategoricalSet(
-          example_idx - begin, CategoricalSetFeatureId{feature.internal_idx},
+          example_idx - begin + dst_begin,
+          CategoricalSetFeatureId{feature.internal_idx},
           categorical_item_buffer_.begin() + src_range.begin,
           categorical_item_buffer_.begin() + src_range.end, features);
     }
@@ -20,6 +20,7 @@
 #define YGGDRASIL_DECISION_FORESTS_SERVING_EXAMPLE_SET_MODEL_WRAPPER_H_
 
 #include "absl/status/status.h"
+#include "absl/types/span.h"
 #include "yggdrasil_decision_forests/model/abstract_model.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
 #include "yggdrasil_decision_forests/serving/fast_engine.h"
@@ -27,6 +28,32 @@
 namespace yggdrasil_decision_forests {
 namespace serving {
 
+namespace internal {
+
+template <class...>
+using void_t = void;
+
+// Calls the free "GetLeaves" function defined alongside the model type if the
+// model stores leaf indices (i.e. has a "leaf_idxs" field), and returns an
+// UnimplementedError otherwise.
+template <class T, class = void_t<>>
+struct call_get_leaves {
+  absl::Status operator()(const T& m, const typename T::ExampleSet& examples,
+                          int num_examples, absl::Span<int32_t> leaves) {
+    return absl::UnimplementedError("GetLeaves not implemented");
+  }
+};
+
+template <class T>
+struct call_get_leaves<T, void_t<decltype(T::leaf_idxs)>> {
+  absl::Status operator()(const T& m, const typename T::ExampleSet& examples,
+                          int num_examples, absl::Span<int32_t> leaves) {
+    return GetLeaves(m, examples, num_examples, leaves);
+  }
+};
+
+}  // namespace internal
+
 // Utility class to wrap a fast ExampleSet model into a FastGenericEngine.
 template <typename Model,
           void (*PredictCall)(const Model&, const typename Model::ExampleSet&,
@@ -51,6 +78,14 @@ class ExampleSetModelWrapper : public FastEngine {
     PredictCall(model_, casted_examples, num_examples, predictions);
   }
 
+  absl::Status GetLeaves(const AbstractExampleSet& examples, int num_examples,
+                         absl::Span<int32_t> leaves) const override {
+    const auto& casted_examples =
+        dynamic_cast<const typename Model::ExampleSet&>(examples);
+    return internal::call_get_leaves<Model>()(model_, casted_examples,
+                                              num_examples, leaves);
+  }
+
   template <class...>
   using void_t = void;
 
@@ -207,6 +207,28 @@ struct ToyModel : EmptyModel {
   }
 };
 
+// Example-major sibling of "ToyModel" ("EmptyModel" is feature-major), to
+// exercise the FORMAT_EXAMPLE_MAJOR code paths.
+struct ExampleMajorToyModel {
+  using ExampleSet = ExampleSetNumericalOrCategoricalFlat<
+      ExampleMajorToyModel, ExampleFormat::FORMAT_EXAMPLE_MAJOR>;
+
+  ExampleMajorToyModel() {
+    CHECK_OK(intern_features.Initialize({0, 1, 2, 3, 4, 6, 8, 9, 12, 13, 14},
+                                        ToyDataSpec()));
+  }
+
+  const ExampleSet::FeaturesDefinition& features() const {
+    return intern_features;
+  }
+
+  ExampleSet::FeaturesDefinition* mutable_features() {
+    return &intern_features;
+  }
+
+  ExampleSet::FeaturesDefinition intern_features;
+};
+
 void SetToyValues(const ToyModel& model, ToyModel::ExampleSet* example_set,
                   const bool apply_fill_missing = true,
                   const bool apply_set_missing = true,
@@ -298,6 +320,57 @@ TEST(ExampleSet, GetValue) {
   EXPECT_EQ(example_set.GetBoolean(1, feature_j, model), true);
 }
 
+TEST(ExampleSet, CategoricalVocabularyIndex) {
+  ToyModel model;
+
+  // The vocabularies of the string categorical columns are indexed; the
+  // already-integerized and non-categorical columns are not.
+  EXPECT_EQ(model.features().categorical_vocabulary(/*spec_idx=*/2).size(), 3);
+  EXPECT_EQ(model.features().categorical_vocabulary(/*spec_idx=*/4).size(), 3);
+  EXPECT_TRUE(model.features().categorical_vocabulary(/*spec_idx=*/1).empty());
+  EXPECT_TRUE(model.features().categorical_vocabulary(/*spec_idx=*/0).empty());
+
+  ToyModel::ExampleSet example_set(1, model);
+  const auto feature_c =
+      ToyModel::ExampleSet::GetCategoricalFeatureId("c", model).value();
+
+  example_set.SetCategorical(0, feature_c, "z_c", model);
+  EXPECT_EQ(example_set.GetCategoricalInt(0, feature_c, model), 2);
+
+  // Out-of-vocabulary values map to the out-of-dictionary item.
+  example_set.SetCategorical(0, feature_c, "unknown value", model);
+  EXPECT_EQ(example_set.GetCategoricalInt(0, feature_c, model),
+            dataset::kOutOfDictionaryItemIndex);
+}
+
+TEST(ExampleSet, ResizeReusesBuffers) {
+  ToyModel model;
+  ToyModel::ExampleSet example_set(5, model);
+  SetToyValues(model, &example_set);
+  EXPECT_EQ(example_set.NumberOfExamples(), 5);
+
+  const auto* fixed_length_data =
+      example_set.InternalCategoricalAndNumericalValues().data();
+
+  // Shrinking and growing back to the original size do not re-allocate.
+  example_set.Resize(2, model);
+  EXPECT_EQ(example_set.NumberOfExamples(), 2);
+  example_set.FillMissing(model);
+  EXPECT_EQ(example_set.InternalCategoricalAndNumericalValues().data(),
+            fixed_length_data);
+
+  example_set.Resize(5, model);
+  EXPECT_EQ(example_set.NumberOfExamples(), 5);
+  EXPECT_EQ(example_set.InternalCategoricalAndNumericalValues().data(),
+            fixed_length_data);
+
+  // The example set is still fully usable after the resizes.
+  SetToyValues(model, &example_set);
+  const auto feature_a =
+      ToyModel::ExampleSet::GetNumericalFeatureId("a", model).value();
+  EXPECT_NEAR(example_set.GetNumerical(1, feature_a, model), 1.0f, 0.0001);
+}
+
 TEST(ExampleSet, HasFeature) {
   ToyModel model;
   ToyModel::ExampleSet example_set(5, model);
@@ -357,6 +430,31 @@ TEST(ExampleSet, ExtractProtoExampleMissing) {
               EqualsProto(expected_example));
 }
 
+TEST(ExampleSet, FillMissingExampleMajor) {
+  ExampleMajorToyModel model;
+  ExampleMajorToyModel::ExampleSet example_set(3, model);
+
+  const auto feature_a =
+      ExampleMajorToyModel::ExampleSet::GetNumericalFeatureId("a", model)
+          .value();
+  const auto feature_b =
+      ExampleMajorToyModel::ExampleSet::GetCategoricalFeatureId("b", model)
+          .value();
+
+  // Overridden by "FillMissing".
+  example_set.SetNumerical(1, feature_a, 1000.f, model);
+
+  example_set.FillMissing(model);
+  for (int example_idx = 0; example_idx < 3; example_idx++) {
+    // The missing value replacements from the dataspec: the mean (-1) for the
+    // numerical feature and the most frequent value (0) for the categorical
+    // feature.
+    EXPECT_NEAR(example_set.GetNumerical(example_idx, feature_a, model), -1.f,
+                0.0001);
+    EXPECT_EQ(example_set.GetCategoricalInt(example_idx, feature_b, model), 0);
+  }
+}
+
 TEST(ExampleSet, ExtractProtoExampleMissingManually) {
   ToyModel model;
   ToyModel::ExampleSet example_set(5, model);
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+
+#include <algorithm>
+
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+absl::Status FastEngine::PredictParallel(
+    const AbstractExampleSet& examples, const int num_examples,
+    utils::concurrency::ThreadPool* thread_pool,
+    std::vector<float>* predictions) const {
+  const int num_prediction_dimensions = NumPredictionDimension();
+  predictions->resize(static_cast<size_t>(num_examples) *
+                      num_prediction_dimensions);
+
+  // Not worth threading.
+  if (thread_pool == nullptr || thread_pool->num_threads() <= 1 ||
+      num_examples <= kParallelPredictionChunkSize) {
+    Predict(examples, num_examples, predictions);
+    return absl::OkStatus();
+  }
+
+  const int num_chunks =
+      (num_examples + kParallelPredictionChunkSize - 1) /
+      kParallelPredictionChunkSize;
+  const int num_workers = std::min(thread_pool->num_threads(), num_chunks);
+
+  utils::concurrency::Mutex mutex;
+  absl::Status worker_status;
+  utils::concurrency::BlockingCounter done_workers(num_workers);
+
+  for (int worker_idx = 0; worker_idx < num_workers; ++worker_idx) {
+    thread_pool->Schedule([&, worker_idx]() {
+      // Per-worker scratch, re-used from chunk to chunk.
+      auto chunk_examples = AllocateExamples(kParallelPredictionChunkSize);
+      std::vector<float> chunk_predictions;
+
+      for (int chunk_idx = worker_idx; chunk_idx < num_chunks;
+           chunk_idx += num_workers) {
+        const int begin_example_idx = chunk_idx * kParallelPredictionChunkSize;
+        const int end_example_idx = std::min(
+            num_examples, begin_example_idx + kParallelPredictionChunkSize);
+        const int chunk_num_examples = end_example_idx - begin_example_idx;
+
+        const auto copy_status = examples.Copy(
+            begin_example_idx, end_example_idx, features(),
+            chunk_examples.get());
+        if (!copy_status.ok()) {
+          utils::concurrency::MutexLock lock(&mutex);
+          worker_status.Update(copy_status);
+          break;
+        }
+
+        Predict(*chunk_examples, chunk_num_examples, &chunk_predictions);
+        std::copy(chunk_predictions.begin(),
+                  chunk_predictions.begin() +
+                      static_cast<size_t>(chunk_num_examples) *
+                          num_prediction_dimensions,
+                  predictions->begin() +
+                      static_cast<size_t>(begin_example_idx) *
+                          num_prediction_dimensions);
+      }
+      done_workers.DecrementCount();
+    });
+  }
+
+  done_workers.Wait();
+  utils::concurrency::MutexLock lock(&mutex);
+  return worker_status;
+}
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
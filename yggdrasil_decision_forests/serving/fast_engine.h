@@ -32,6 +32,7 @@
 #define YGGDRASIL_DECISION_FORESTS_SERVING_FAST_ENGINE_H_
 
 #include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 
 namespace yggdrasil_decision_forests {
 namespace serving {
@@ -70,6 +71,11 @@ class FastEngine {
   //   SetNumerical("b", 1.f)
   //   Predict
   //
+  // In steady-state serving, allocating a new example set for every batch
+  // puts pressure on the allocator. Instead, allocate the example set once
+  // (e.g. at the maximum batch size) and re-use it across batches with
+  // "AbstractExampleSet::Resize", which preserves the buffer capacities and
+  // does not allocate.
   virtual std::unique_ptr<AbstractExampleSet> AllocateExamples(
       int num_examples) const = 0;
 
@@ -91,6 +97,26 @@ class FastEngine {
     return absl::UnimplementedError("GetLeaves not implemented");
   }
 
+  // Applies the model on a set of examples, sharding the batch over the
+  // threads of "thread_pool" (whose workers should already be started).
+  //
+  // The batch is cut into chunks of "kParallelPredictionChunkSize" examples.
+  // Each worker copies its chunks into a single per-worker example set scratch
+  // (re-used from chunk to chunk) and runs the regular "Predict" on it, so the
+  // engine implementations do not need to be aware of the threading.
+  //
+  // Like "Predict", this method is thread safe: the thread pool is the only
+  // mutated shared state.
+  absl::Status PredictParallel(const AbstractExampleSet& examples,
+                               int num_examples,
+                               utils::concurrency::ThreadPool* thread_pool,
+                               std::vector<float>* predictions) const;
+
+  // Number of examples processed together by each worker of
+  // "PredictParallel". Large enough to amortize the scheduling and example
+  // copy, small enough for the chunk to stay cache resident.
+  static constexpr int kParallelPredictionChunkSize = 512;
+
   // Number of dimensions of the output predictions.
   // 1 for regression, ranking and binary classification with compact format.
   // number of classes for classification.
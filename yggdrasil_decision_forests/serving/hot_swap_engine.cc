@@ -0,0 +1,83 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/hot_swap_engine.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+HotSwapEngine::HotSwapEngine(std::unique_ptr<FastEngine> engine)
+    : engine_(std::move(engine)) {}
+
+HotSwapEngine::~HotSwapEngine() {
+  WaitForPendingUpdate().IgnoreError();
+}
+
+std::shared_ptr<const FastEngine> HotSwapEngine::engine() const {
+  return std::atomic_load(&engine_);
+}
+
+void HotSwapEngine::Swap(std::unique_ptr<FastEngine> engine) {
+  // The previous version is released here (or by the last serving thread
+  // still holding a snapshot of it) and destroyed by the releasing thread.
+  std::atomic_store(&engine_,
+                    std::shared_ptr<const FastEngine>(std::move(engine)));
+}
+
+absl::Status HotSwapEngine::Update(const EngineBuilder& build_engine) {
+  ASSIGN_OR_RETURN(auto new_engine, build_engine());
+  Swap(std::move(new_engine));
+  return absl::OkStatus();
+}
+
+void HotSwapEngine::UpdateInBackground(EngineBuilder build_engine) {
+  // At most one background update at a time: a new update waits for the
+  // previous one so the engine versions are published in submission order.
+  WaitForPendingUpdate().IgnoreError();
+
+  utils::concurrency::MutexLock lock(&mutex_);
+  update_thread_ = absl::make_unique<utils::concurrency::Thread>(
+      [this, build_engine = std::move(build_engine)]() {
+        const absl::Status status = Update(build_engine);
+        utils::concurrency::MutexLock lock(&mutex_);
+        pending_update_status_ = status;
+      });
+}
+
+absl::Status HotSwapEngine::WaitForPendingUpdate() {
+  std::unique_ptr<utils::concurrency::Thread> update_thread;
+  {
+    utils::concurrency::MutexLock lock(&mutex_);
+    update_thread = std::move(update_thread_);
+  }
+  if (!update_thread) {
+    return absl::OkStatus();
+  }
+  update_thread->Join();
+  utils::concurrency::MutexLock lock(&mutex_);
+  absl::Status status = std::move(pending_update_status_);
+  pending_update_status_ = absl::OkStatus();
+  return status;
+}
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Lock-free hot-swap of a FastEngine for serving.
+//
+// Services that reload their model periodically often guard the engine with a
+// reader-writer lock; the write lock then stalls all the serving threads for
+// the duration of the swap. The HotSwapEngine instead publishes the engine
+// through an atomic shared pointer (RCU style): serving threads take a
+// snapshot with a single atomic reference-count increment and never block on
+// an update. The retired engine is destroyed when the last snapshot referring
+// to it is released, so in-flight batches finish on the version they started
+// with.
+//
+// The HotSwapEngine is a holder, not an engine: a serving thread should take
+// one snapshot per batch and use it for both "AllocateExamples" and
+// "Predict", since examples allocated by one engine version cannot be scored
+// by another.
+//
+// Usage example:
+//
+//   HotSwapEngine holder(model->BuildFastEngine().value());
+//
+//   // Serving thread, for each batch:
+//   const auto engine = holder.engine();
+//   auto examples = engine->AllocateExamples(batch_size);
+//   ... set the feature values ...
+//   engine->Predict(*examples, batch_size, &predictions);
+//
+//   // Model rollout:
+//   holder.UpdateInBackground(
+//       [new_model]() { return new_model->BuildFastEngine(); });
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_HOT_SWAP_ENGINE_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_HOT_SWAP_ENGINE_H_
+
+#include <functional>
+#include <memory>
+
+#include "absl/status/status.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+class HotSwapEngine {
+ public:
+  // Builds a new engine version, e.g. with "AbstractModel::BuildFastEngine".
+  using EngineBuilder =
+      std::function<utils::StatusOr<std::unique_ptr<FastEngine>>()>;
+
+  // Creates an empty holder. "engine()" returns nullptr until the first
+  // engine is published.
+  HotSwapEngine() = default;
+
+  // Creates a holder serving "engine".
+  explicit HotSwapEngine(std::unique_ptr<FastEngine> engine);
+
+  // Waits for a pending background update.
+  ~HotSwapEngine();
+
+  HotSwapEngine(const HotSwapEngine&) = delete;
+  HotSwapEngine& operator=(const HotSwapEngine&) = delete;
+
+  // Snapshot of the current engine. Never blocks on an update. The snapshot
+  // remains valid (and keeps the engine version alive) for as long as the
+  // caller holds it; nullptr if no engine has been published yet.
+  std::shared_ptr<const FastEngine> engine() const;
+
+  // Publishes "engine" as the new current version. The previous version is
+  // destroyed when its last snapshot is released.
+  void Swap(std::unique_ptr<FastEngine> engine);
+
+  // Builds an engine with "build_engine" and publishes it. Blocks the calling
+  // thread during the build; the serving threads are not blocked. If the
+  // build fails, the current engine is left in place and the error is
+  // returned.
+  absl::Status Update(const EngineBuilder& build_engine);
+
+  // Like "Update", but the build runs on a background thread and the call
+  // returns immediately. If an earlier background update is still running,
+  // waits for it first. The status of the update is reported by the next
+  // "WaitForPendingUpdate" call.
+  void UpdateInBackground(EngineBuilder build_engine);
+
+  // Waits for the pending background update (if any) and returns its status.
+  // OkStatus if there is no pending update.
+  absl::Status WaitForPendingUpdate();
+
+ private:
+  // Current engine version. Accessed with std::atomic_{load,store}.
+  std::shared_ptr<const FastEngine> engine_;
+
+  utils::concurrency::Mutex mutex_;
+  std::unique_ptr<utils::concurrency::Thread> update_thread_
+      GUARDED_BY(mutex_);
+  absl::Status pending_update_status_ GUARDED_BY(mutex_);
+};
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_HOT_SWAP_ENGINE_H_
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/hot_swap_engine.h"
+
+#include <memory>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace {
+
+// Minimal engine tracking its own destruction.
+class FakeEngine : public FastEngine {
+ public:
+  explicit FakeEngine(bool* destroyed) : destroyed_(destroyed) {}
+
+  ~FakeEngine() override { *destroyed_ = true; }
+
+  std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      const int num_examples) const override {
+    return nullptr;
+  }
+
+  void Predict(const AbstractExampleSet& examples, const int num_examples,
+               std::vector<float>* predictions) const override {}
+
+  int NumPredictionDimension() const override { return 1; }
+
+  const FeaturesDefinition& features() const override { return features_; }
+
+ private:
+  bool* destroyed_;
+  FeaturesDefinition features_;
+};
+
+TEST(HotSwapEngine, SnapshotOutlivesSwap) {
+  bool first_destroyed = false;
+  bool second_destroyed = false;
+
+  HotSwapEngine holder;
+  EXPECT_EQ(holder.engine(), nullptr);
+
+  holder.Swap(absl::make_unique<FakeEngine>(&first_destroyed));
+  auto snapshot = holder.engine();
+  ASSERT_NE(snapshot, nullptr);
+
+  // The snapshot keeps the first version alive across the swap.
+  holder.Swap(absl::make_unique<FakeEngine>(&second_destroyed));
+  EXPECT_NE(holder.engine(), snapshot);
+  EXPECT_FALSE(first_destroyed);
+
+  // Releasing the last snapshot retires the first version.
+  snapshot.reset();
+  EXPECT_TRUE(first_destroyed);
+  EXPECT_FALSE(second_destroyed);
+}
+
+TEST(HotSwapEngine, FailedUpdateKeepsCurrentEngine) {
+  bool destroyed = false;
+  HotSwapEngine holder(absl::make_unique<FakeEngine>(&destroyed));
+  const auto before = holder.engine();
+
+  EXPECT_THAT(
+      holder.Update([]() { return absl::InvalidArgumentError("no engine"); }),
+      test::StatusIs(absl::StatusCode::kInvalidArgument, "no engine"));
+  EXPECT_EQ(holder.engine(), before);
+  EXPECT_FALSE(destroyed);
+}
+
+TEST(HotSwapEngine, UpdateInBackground) {
+  bool first_destroyed = false;
+  bool second_destroyed = false;
+  HotSwapEngine holder(absl::make_unique<FakeEngine>(&first_destroyed));
+  const auto before = holder.engine();
+
+  holder.UpdateInBackground([&second_destroyed]() {
+    return utils::StatusOr<std::unique_ptr<FastEngine>>(
+        absl::make_unique<FakeEngine>(&second_destroyed));
+  });
+  EXPECT_OK(holder.WaitForPendingUpdate());
+  EXPECT_NE(holder.engine(), before);
+
+  holder.UpdateInBackground(
+      []() { return absl::InvalidArgumentError("no engine"); });
+  EXPECT_THAT(
+      holder.WaitForPendingUpdate(),
+      test::StatusIs(absl::StatusCode::kInvalidArgument, "no engine"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
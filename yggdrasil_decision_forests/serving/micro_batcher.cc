@@ -0,0 +1,140 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/micro_batcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+MicroBatcher::MicroBatcher(const FastEngine* engine, const Options& options)
+    : engine_(engine),
+      options_(options),
+      batch_examples_(engine->AllocateExamples(options.max_batch_size)) {
+  worker_ = absl::make_unique<utils::concurrency::Thread>(
+      [this]() { WorkerMain(); });
+}
+
+MicroBatcher::~MicroBatcher() { Stop(); }
+
+void MicroBatcher::Stop() {
+  {
+    utils::concurrency::MutexLock lock(&mutex_);
+    if (stop_) {
+      return;
+    }
+    stop_ = true;
+  }
+  cond_var_.SignalAll();
+  worker_->Join();
+}
+
+std::future<utils::StatusOr<std::vector<float>>> MicroBatcher::Predict(
+    std::unique_ptr<AbstractExampleSet> example) {
+  PendingExample item;
+  item.example = std::move(example);
+  auto future = item.prediction.get_future();
+  {
+    utils::concurrency::MutexLock lock(&mutex_);
+    if (stop_) {
+      item.prediction.set_value(
+          absl::FailedPreconditionError("The MicroBatcher is stopped."));
+      return future;
+    }
+    pending_.push_back(std::move(item));
+  }
+  cond_var_.Signal();
+  return future;
+}
+
+void MicroBatcher::WorkerMain() {
+  while (true) {
+    std::vector<PendingExample> batch;
+    {
+      utils::concurrency::MutexLock lock(&mutex_);
+      // Wait for the first example of the batch.
+      while (pending_.empty() && !stop_) {
+        cond_var_.Wait(&mutex_, &lock);
+      }
+      if (pending_.empty() && stop_) {
+        break;
+      }
+      // Wait for the batch to fill up, or for the latency budget to expire.
+      const auto deadline =
+          std::chrono::steady_clock::now() +
+          std::chrono::microseconds(options_.max_latency_us);
+      while (pending_.size() <
+                 static_cast<size_t>(options_.max_batch_size) &&
+             !stop_) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+          break;
+        }
+        const int64_t remaining_us =
+            std::chrono::duration_cast<std::chrono::microseconds>(deadline -
+                                                                  now)
+                .count();
+        cond_var_.WaitWithTimeout(&mutex_, &lock, remaining_us);
+      }
+      const size_t batch_size =
+          std::min<size_t>(pending_.size(), options_.max_batch_size);
+      batch.assign(std::make_move_iterator(pending_.begin()),
+                   std::make_move_iterator(pending_.begin() + batch_size));
+      pending_.erase(pending_.begin(), pending_.begin() + batch_size);
+    }
+    FlushBatch(std::move(batch));
+  }
+}
+
+void MicroBatcher::FlushBatch(std::vector<PendingExample> batch) {
+  const int batch_size = batch.size();
+  const auto& features = engine_->features();
+  batch_examples_->Resize(batch_size, features);
+  batch_examples_->Clear();
+
+  absl::Status status;
+  for (int example_idx = 0; example_idx < batch_size && status.ok();
+       example_idx++) {
+    status = batch[example_idx].example->CopyTo(
+        /*begin=*/0, /*end=*/1, /*dst_begin=*/example_idx, features,
+        batch_examples_.get());
+  }
+  if (!status.ok()) {
+    for (auto& item : batch) {
+      item.prediction.set_value(status);
+    }
+    return;
+  }
+
+  engine_->Predict(*batch_examples_, batch_size, &batch_predictions_);
+  const int num_dims = engine_->NumPredictionDimension();
+  for (int example_idx = 0; example_idx < batch_size; example_idx++) {
+    batch[example_idx].prediction.set_value(std::vector<float>(
+        batch_predictions_.begin() + example_idx * num_dims,
+        batch_predictions_.begin() + (example_idx + 1) * num_dims));
+  }
+}
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
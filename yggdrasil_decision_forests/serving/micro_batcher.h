@@ -0,0 +1,116 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Asynchronous single-example inference on top of a FastEngine with
+// transparent micro-batching.
+//
+// The engines reach peak throughput on batches of examples (e.g. the SIMD
+// tree traversal of the QuickScorer engine), but RPC servers often receive
+// examples one at a time. The MicroBatcher accepts individual examples and
+// coalesces them into batches of up to "max_batch_size" examples or
+// "max_latency_us" microseconds (whichever comes first) before calling the
+// engine, trading a small bounded latency for batched throughput.
+//
+// The MicroBatcher is thread safe: any number of threads can submit examples
+// concurrently.
+//
+// Usage example:
+//
+//   MicroBatcher batcher(engine.get(), /*options=*/{});
+//   auto example = engine->AllocateExamples(1);
+//   example->FillMissing(engine->features());
+//   ... set the feature values of example #0 ...
+//   auto future_prediction = batcher.Predict(std::move(example));
+//   ...
+//   const std::vector<float> prediction = future_prediction.get().value();
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_MICRO_BATCHER_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_MICRO_BATCHER_H_
+
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+class MicroBatcher {
+ public:
+  struct Options {
+    // Maximum number of examples scored in a single engine call. A pending
+    // batch is flushed as soon as it reaches this size.
+    int max_batch_size = 32;
+
+    // Maximum time an example can wait in a partial batch before the batch is
+    // flushed.
+    int64_t max_latency_us = 100;
+  };
+
+  // Starts the worker thread. "engine" should outlive the MicroBatcher.
+  MicroBatcher(const FastEngine* engine, const Options& options);
+
+  // Flushes the pending examples and stops the worker thread.
+  ~MicroBatcher();
+
+  // Submits a single example for inference. "example" should contain exactly
+  // one example, allocated with "engine->AllocateExamples(1)", with all its
+  // feature values set. Returns a future resolving to the prediction of the
+  // example ("NumPredictionDimension" values), or to an error status if the
+  // example could not be scored.
+  std::future<utils::StatusOr<std::vector<float>>> Predict(
+      std::unique_ptr<AbstractExampleSet> example);
+
+  // Flushes the pending examples and stops the worker thread. Examples
+  // submitted after this call are rejected with an error. Called by the
+  // destructor.
+  void Stop();
+
+ private:
+  struct PendingExample {
+    std::unique_ptr<AbstractExampleSet> example;
+    std::promise<utils::StatusOr<std::vector<float>>> prediction;
+  };
+
+  // Running loop of the worker thread.
+  void WorkerMain();
+
+  // Scores a batch of pending examples and resolves their promises.
+  void FlushBatch(std::vector<PendingExample> batch);
+
+  const FastEngine* engine_;
+  const Options options_;
+
+  utils::concurrency::Mutex mutex_;
+  utils::concurrency::CondVar cond_var_;
+  bool stop_ GUARDED_BY(mutex_) = false;
+  std::vector<PendingExample> pending_ GUARDED_BY(mutex_);
+
+  // Re-used batch storage. Only accessed by the worker thread.
+  std::unique_ptr<AbstractExampleSet> batch_examples_;
+  std::vector<float> batch_predictions_;
+
+  std::unique_ptr<utils::concurrency::Thread> worker_;
+};
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_MICRO_BATCHER_H_
@@ -0,0 +1,133 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/micro_batcher.h"
+
+#include <future>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "yggdrasil_decision_forests/serving/example_set.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace {
+
+using testing::ElementsAre;
+
+// Engine with a single numerical input feature "a". The prediction of an
+// example is twice the value of "a".
+class FakeEngine : public FastEngine {
+ public:
+  FakeEngine() {
+    const dataset::proto::DataSpecification data_spec = PARSE_TEST_PROTO(
+        R"pb(
+          columns {
+            type: NUMERICAL
+            name: "a"
+            numerical { mean: 1.0 }
+          }
+        )pb");
+    CHECK_OK(model_.Initialize({0}, data_spec));
+  }
+
+  std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      const int num_examples) const override {
+    return absl::make_unique<EmptyModel::ExampleSet>(num_examples, model_);
+  }
+
+  void Predict(const AbstractExampleSet& examples, const int num_examples,
+               std::vector<float>* predictions) const override {
+    const auto& casted_examples =
+        dynamic_cast<const EmptyModel::ExampleSet&>(examples);
+    const auto feature =
+        EmptyModel::ExampleSet::GetNumericalFeatureId("a", model_).value();
+    predictions->resize(num_examples);
+    for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+      (*predictions)[example_idx] =
+          2 * casted_examples.GetNumerical(example_idx, feature, model_);
+    }
+    batch_sizes_.push_back(num_examples);
+  }
+
+  int NumPredictionDimension() const override { return 1; }
+
+  const FeaturesDefinition& features() const override {
+    return model_.features();
+  }
+
+  // Sizes of the scored batches.
+  mutable std::vector<int> batch_sizes_;
+
+ private:
+  EmptyModel model_;
+};
+
+TEST(MicroBatcher, PredictSingleExamples) {
+  FakeEngine engine;
+  MicroBatcher::Options options;
+  options.max_batch_size = 4;
+  options.max_latency_us = 1000;
+  MicroBatcher batcher(&engine, options);
+
+  const auto feature = engine.features().GetNumericalFeatureId("a").value();
+
+  const int num_examples = 10;
+  std::vector<std::future<utils::StatusOr<std::vector<float>>>> futures;
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    auto example = engine.AllocateExamples(1);
+    example->FillMissing(engine.features());
+    example->SetNumerical(0, feature, example_idx, engine.features());
+    futures.push_back(batcher.Predict(std::move(example)));
+  }
+
+  for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+    const auto prediction = futures[example_idx].get();
+    ASSERT_TRUE(prediction.ok());
+    EXPECT_THAT(prediction.value(), ElementsAre(2.f * example_idx));
+  }
+
+  batcher.Stop();
+  // All the examples have been scored, in batches of at most
+  // "max_batch_size".
+  int total = 0;
+  for (const int batch_size : engine.batch_sizes_) {
+    EXPECT_GE(batch_size, 1);
+    EXPECT_LE(batch_size, options.max_batch_size);
+    total += batch_size;
+  }
+  EXPECT_EQ(total, num_examples);
+}
+
+TEST(MicroBatcher, RejectsAfterStop) {
+  FakeEngine engine;
+  MicroBatcher batcher(&engine, /*options=*/{});
+  batcher.Stop();
+
+  auto example = engine.AllocateExamples(1);
+  example->FillMissing(engine.features());
+  auto future = batcher.Predict(std::move(example));
+  EXPECT_FALSE(future.get().ok());
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
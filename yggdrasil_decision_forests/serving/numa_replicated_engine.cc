@@ -0,0 +1,203 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/numa_replicated_engine.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/substitute.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/status_macros.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace {
+
+// Binds the calling thread to a set of CPUs. No-op on non-Linux platforms.
+void BindThreadToCpus(const std::vector<int>& cpus) {
+#if defined(__linux__)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (const int cpu : cpus) {
+    CPU_SET(cpu, &cpuset);
+  }
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#else
+  (void)cpus;
+#endif
+}
+
+}  // namespace
+
+namespace internal {
+
+utils::StatusOr<std::vector<int>> ParseCpuList(
+    const absl::string_view cpu_list) {
+  std::vector<int> cpus;
+  for (const auto& item :
+       absl::StrSplit(cpu_list, ',', absl::SkipWhitespace())) {
+    const std::pair<absl::string_view, absl::string_view> bounds =
+        absl::StrSplit(item, absl::MaxSplits('-', 1));
+    int begin, end;
+    if (!absl::SimpleAtoi(bounds.first, &begin)) {
+      return absl::InvalidArgumentError(
+          absl::Substitute("Cannot parse the cpu list \"$0\"", cpu_list));
+    }
+    if (bounds.second.empty()) {
+      end = begin;
+    } else if (!absl::SimpleAtoi(bounds.second, &end) || end < begin) {
+      return absl::InvalidArgumentError(
+          absl::Substitute("Cannot parse the cpu list \"$0\"", cpu_list));
+    }
+    for (int cpu = begin; cpu <= end; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::vector<std::vector<int>> GetNumaTopology() {
+  std::vector<std::vector<int>> topology;
+#if defined(__linux__)
+  for (int node_idx = 0;; node_idx++) {
+    std::ifstream cpu_list_file(absl::Substitute(
+        "/sys/devices/system/node/node$0/cpulist", node_idx));
+    if (!cpu_list_file.is_open()) {
+      break;
+    }
+    std::string cpu_list;
+    std::getline(cpu_list_file, cpu_list);
+    auto cpus_or = ParseCpuList(cpu_list);
+    if (!cpus_or.ok()) {
+      LOG(WARNING) << "Cannot read the NUMA topology: "
+                   << cpus_or.status().message();
+      return {};
+    }
+    // Nodes without CPUs (e.g. CXL memory-only nodes) are skipped: no thread
+    // can be local to them.
+    if (!cpus_or.value().empty()) {
+      topology.push_back(std::move(cpus_or).value());
+    }
+  }
+#endif
+  return topology;
+}
+
+}  // namespace internal
+
+utils::StatusOr<std::unique_ptr<FastEngine>> NumaReplicatedEngine::Create(
+    const std::function<utils::StatusOr<std::unique_ptr<FastEngine>>()>&
+        build_engine) {
+  const auto topology = internal::GetNumaTopology();
+  if (topology.size() <= 1) {
+    return build_engine();
+  }
+
+  // Build one replica per node. Each builder thread is bound to the CPUs of
+  // its node so that the first-touch policy places the engine memory there.
+  // The replicas are built one after the other: "build_engine" is not
+  // required to support concurrent calls (e.g. the engine calibration cache
+  // of "AbstractModel::BuildFastEngine" is not synchronized).
+  const int num_nodes = topology.size();
+  std::vector<std::unique_ptr<FastEngine>> replicas(num_nodes);
+  for (int node_idx = 0; node_idx < num_nodes; node_idx++) {
+    absl::Status status;
+    utils::concurrency::Thread builder([&]() {
+      BindThreadToCpus(topology[node_idx]);
+      auto replica_or = build_engine();
+      if (!replica_or.ok()) {
+        status = replica_or.status();
+        return;
+      }
+      replicas[node_idx] = std::move(replica_or).value();
+    });
+    builder.Join();
+    RETURN_IF_ERROR(status);
+  }
+
+  int num_cpus = 0;
+  for (const auto& node_cpus : topology) {
+    num_cpus = std::max(num_cpus,
+                        *std::max_element(node_cpus.begin(), node_cpus.end()) +
+                            1);
+  }
+  std::vector<int> cpu_to_node(num_cpus, 0);
+  for (int node_idx = 0; node_idx < num_nodes; node_idx++) {
+    for (const int cpu : topology[node_idx]) {
+      cpu_to_node[cpu] = node_idx;
+    }
+  }
+
+  LOG_INFO_EVERY_N_SEC(10, _ << "Engine replicated on " << num_nodes
+                             << " NUMA nodes");
+  return absl::WrapUnique(
+      new NumaReplicatedEngine(std::move(replicas), std::move(cpu_to_node)));
+}
+
+NumaReplicatedEngine::NumaReplicatedEngine(
+    std::vector<std::unique_ptr<FastEngine>> replicas,
+    std::vector<int> cpu_to_node)
+    : replicas_(std::move(replicas)), cpu_to_node_(std::move(cpu_to_node)) {}
+
+const FastEngine& NumaReplicatedEngine::LocalReplica() const {
+#if defined(__linux__)
+  const int cpu = sched_getcpu();
+  if (cpu >= 0 && cpu < static_cast<int>(cpu_to_node_.size())) {
+    return *replicas_[cpu_to_node_[cpu]];
+  }
+#endif
+  return *replicas_.front();
+}
+
+std::unique_ptr<AbstractExampleSet> NumaReplicatedEngine::AllocateExamples(
+    const int num_examples) const {
+  return LocalReplica().AllocateExamples(num_examples);
+}
+
+void NumaReplicatedEngine::Predict(const AbstractExampleSet& examples,
+                                   const int num_examples,
+                                   std::vector<float>* predictions) const {
+  LocalReplica().Predict(examples, num_examples, predictions);
+}
+
+absl::Status NumaReplicatedEngine::GetLeaves(const AbstractExampleSet& examples,
+                                             const int num_examples,
+                                             absl::Span<int32_t> leaves) const {
+  return LocalReplica().GetLeaves(examples, num_examples, leaves);
+}
+
+int NumaReplicatedEngine::NumPredictionDimension() const {
+  return replicas_.front()->NumPredictionDimension();
+}
+
+const serving::FeaturesDefinition& NumaReplicatedEngine::features() const {
+  return replicas_.front()->features();
+}
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// NUMA-aware replication of a FastEngine.
+//
+// On multi-socket hosts, the node arrays of a compiled engine live on the
+// NUMA node where the engine was built, and serving threads running on
+// another socket pay remote-memory latency for every node fetch. Since a
+// compiled engine is immutable after construction, it can be replicated:
+// "NumaReplicatedEngine" builds one replica of the engine per NUMA node --
+// each one from a thread bound to the CPUs of this node, so that the
+// first-touch policy places its memory in node-local RAM -- and routes each
+// "Predict" call to the replica local to the calling thread.
+//
+// The NUMA topology is read from sysfs and is therefore only available on
+// Linux. On other platforms, or on single-node hosts, "Create" returns the
+// engine built by "build_engine" directly, without wrapper indirection.
+
+#ifndef YGGDRASIL_DECISION_FORESTS_SERVING_NUMA_REPLICATED_ENGINE_H_
+#define YGGDRASIL_DECISION_FORESTS_SERVING_NUMA_REPLICATED_ENGINE_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/serving/fast_engine.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+
+class NumaReplicatedEngine : public FastEngine {
+ public:
+  // Builds one engine replica per NUMA node of the host. "build_engine" is
+  // called once per node, each time from a thread bound to the CPUs of this
+  // node, and should build independent engines (i.e. no shared buffers). If
+  // the host has a single NUMA node, or if the topology cannot be determined,
+  // the single engine built by "build_engine" is returned directly.
+  static utils::StatusOr<std::unique_ptr<FastEngine>> Create(
+      const std::function<utils::StatusOr<std::unique_ptr<FastEngine>>()>&
+          build_engine);
+
+  // FastEngine interface. All the calls are forwarded to the replica local to
+  // the calling thread.
+  std::unique_ptr<AbstractExampleSet> AllocateExamples(
+      int num_examples) const override;
+  void Predict(const AbstractExampleSet& examples, int num_examples,
+               std::vector<float>* predictions) const override;
+  absl::Status GetLeaves(const AbstractExampleSet& examples, int num_examples,
+                         absl::Span<int32_t> leaves) const override;
+  int NumPredictionDimension() const override;
+  const serving::FeaturesDefinition& features() const override;
+
+  int num_replicas() const { return replicas_.size(); }
+
+ private:
+  NumaReplicatedEngine(std::vector<std::unique_ptr<FastEngine>> replicas,
+                       std::vector<int> cpu_to_node);
+
+  // Replica on the NUMA node of the calling thread. Falls back to the first
+  // replica if the current CPU cannot be determined.
+  const FastEngine& LocalReplica() const;
+
+  // One replica per NUMA node, indexed by node.
+  std::vector<std::unique_ptr<FastEngine>> replicas_;
+
+  // NUMA node of each CPU of the host.
+  std::vector<int> cpu_to_node_;
+};
+
+namespace internal {
+
+// Parses a sysfs cpu list (e.g. "0-3,8,10-11") into a list of CPU indices.
+utils::StatusOr<std::vector<int>> ParseCpuList(absl::string_view cpu_list);
+
+// CPUs of each NUMA node of the host, indexed by node, read from
+// "/sys/devices/system/node". Empty if the topology cannot be determined
+// (e.g. non-Linux platform).
+std::vector<std::vector<int>> GetNumaTopology();
+
+}  // namespace internal
+
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_SERVING_NUMA_REPLICATED_ENGINE_H_
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/serving/numa_replicated_engine.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "yggdrasil_decision_forests/utils/test.h"
+
+namespace yggdrasil_decision_forests {
+namespace serving {
+namespace {
+
+using testing::ElementsAre;
+
+TEST(ParseCpuList, Base) {
+  EXPECT_THAT(internal::ParseCpuList("0-3").value(), ElementsAre(0, 1, 2, 3));
+  EXPECT_THAT(internal::ParseCpuList("5").value(), ElementsAre(5));
+  EXPECT_THAT(internal::ParseCpuList("0,2,4-6").value(),
+              ElementsAre(0, 2, 4, 5, 6));
+  EXPECT_TRUE(internal::ParseCpuList("").value().empty());
+}
+
+TEST(ParseCpuList, Invalid) {
+  EXPECT_FALSE(internal::ParseCpuList("hello").ok());
+  EXPECT_FALSE(internal::ParseCpuList("3-1").ok());
+}
+
+TEST(GetNumaTopology, Base) {
+  const auto topology = internal::GetNumaTopology();
+  // The topology is only available on Linux, and may contain any number of
+  // nodes depending on the test machine.
+  for (const auto& node_cpus : topology) {
+    EXPECT_FALSE(node_cpus.empty());
+  }
+}
+
+TEST(NumaReplicatedEngine, PropagatesBuildError) {
+  // Both the single-node fallback and the replicated path surface the error
+  // of the engine builder.
+  const auto engine_or = NumaReplicatedEngine::Create(
+      []() { return absl::InvalidArgumentError("no engine"); });
+  EXPECT_THAT(engine_or.status(),
+              test::StatusIs(absl::StatusCode::kInvalidArgument, "no engine"));
+}
+
+}  // namespace
+}  // namespace serving
+}  // namespace yggdrasil_decision_forests
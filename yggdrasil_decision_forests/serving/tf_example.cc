@@ -23,6 +23,7 @@
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
@@ -205,5 +206,53 @@ absl::Status TfExampleToExampleSet(const tensorflow::Example& src,
   return absl::OkStatus();
 }
 
+absl::Status TfExamplesToExampleSet(
+    const absl::Span<const tensorflow::Example> srcs,
+    const serving::FeaturesDefinition& features,
+    serving::AbstractExampleSet* dst) {
+  const int num_examples = srcs.size();
+
+  // The feature definitions are resolved once, and the values are copied
+  // feature by feature.
+  for (const auto& feature_def : features.input_features()) {
+    if (features.data_spec().columns(feature_def.spec_idx).is_unstacked()) {
+      // The units of unstacked features are fed through the original
+      // multi-dimensional feature below.
+      continue;
+    }
+    for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+      const auto& feature_map = srcs[example_idx].features().feature();
+      const auto it_value = feature_map.find(feature_def.name);
+      if (it_value == feature_map.end()) {
+        // The feature value is missing for this example.
+        continue;
+      }
+      RETURN_IF_ERROR(ParseBaseFeatureFromTfExample(
+          example_idx, feature_def, feature_def.name, it_value->second,
+          features, dst));
+    }
+  }
+
+  for (const auto& unstacked : features.data_spec().unstackeds()) {
+    const auto unstacked_def =
+        features.FindUnstackedFeatureDefByName(unstacked.original_name());
+    if (!unstacked_def.ok()) {
+      // The unstacked feature is not used by the model.
+      continue;
+    }
+    for (int example_idx = 0; example_idx < num_examples; example_idx++) {
+      const auto& feature_map = srcs[example_idx].features().feature();
+      const auto it_value = feature_map.find(unstacked.original_name());
+      if (it_value == feature_map.end()) {
+        continue;
+      }
+      RETURN_IF_ERROR(ParseUnstackedFeatureFromTfExample(
+          example_idx, *unstacked_def.value(), unstacked.original_name(),
+          it_value->second, features, dst));
+    }
+  }
+  return absl::OkStatus();
+}
+
 }  // namespace serving
 }  // namespace yggdrasil_decision_forests
@@ -18,6 +18,7 @@
 #define YGGDRASIL_DECISION_FORESTS_SERVING_TF_EXAMPLE_H_
 
 #include "absl/status/status.h"
+#include "absl/types/span.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "yggdrasil_decision_forests/serving/example_set.h"
 
@@ -30,6 +31,17 @@ absl::Status TfExampleToExampleSet(const tensorflow::Example& src,
                                    const FeaturesDefinition& features,
                                    AbstractExampleSet* dst);
 
+// Writes a batch of TensorFlow Examples into the "srcs.size()" first examples
+// of an ExampleSet. Equivalent to calling "TfExampleToExampleSet" on each
+// example, but the feature names are resolved against "features" once for the
+// whole batch and the values are copied feature by feature, which removes the
+// per-example name resolution and writes sequentially in feature-major
+// example sets. Features absent from an example keep their current value in
+// "dst": call "dst->FillMissing" beforehand.
+absl::Status TfExamplesToExampleSet(absl::Span<const tensorflow::Example> srcs,
+                                    const FeaturesDefinition& features,
+                                    AbstractExampleSet* dst);
+
 }  // namespace serving
 }  // namespace yggdrasil_decision_forests
 
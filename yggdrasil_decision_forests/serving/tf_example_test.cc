@@ -18,6 +18,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -304,6 +305,78 @@ TEST(ExampleSet, FromTensorflowExample) {
       StatusIs(absl::StatusCode::kInvalidArgument, "Wrong number of values."));
 }
 
+TEST(ExampleSet, FromTensorflowExampleBatch) {
+  ToyModel model;
+  ToyModel::ExampleSet example_set(2, model);
+
+  tensorflow::Example example;
+  tensorflow::SetFeatureValues({3.0f}, "a", &example);
+  tensorflow::SetFeatureValues<int64_t>({1}, "b", &example);
+  tensorflow::SetFeatureValues({"y_c"}, "c", &example);
+  tensorflow::SetFeatureValues<int64_t>({2, 3}, "d", &example);
+  tensorflow::SetFeatureValues({"y_d", "z_d"}, "e", &example);
+  tensorflow::SetFeatureValues({1.9}, "f", &example);
+  tensorflow::SetFeatureValues({10.f, 11.f, 12.f}, "g", &example);
+  tensorflow::SetFeatureValues({1.5f, 1.5f}, "i", &example);
+  tensorflow::SetFeatureValues({1.0f}, "j", &example);
+
+  tensorflow::Example example_1 = example;
+  tensorflow::SetFeatureValues({1.0f}, "a", &example_1);
+
+  const std::vector<tensorflow::Example> examples = {example, example_1};
+  EXPECT_OK(TfExamplesToExampleSet(examples, model.features(), &example_set));
+
+  // Same expected values as the example-by-example conversion above.
+  const dataset::proto::Example expected_example = PARSE_TEST_PROTO(
+      R"pb(
+        attributes { numerical: 3.0 }
+        attributes { categorical: 1 }
+        attributes { categorical: 1 }
+        attributes { categorical_set { values: 2 values: 3 } }
+        attributes { categorical_set { values: 1 values: 2 } }
+        attributes {}
+        attributes { discretized_numerical: 2 }
+        attributes { numerical: 10 }
+        attributes { numerical: 11 }
+        attributes { numerical: 12 }
+        attributes {}
+        attributes {}
+        attributes { discretized_numerical: 2 }
+        attributes { discretized_numerical: 2 }
+        attributes { boolean: true }
+      )pb");
+  const dataset::proto::Example expected_example_1 = PARSE_TEST_PROTO(
+      R"pb(
+        attributes { numerical: 1.0 }
+        attributes { categorical: 1 }
+        attributes { categorical: 1 }
+        attributes { categorical_set { values: 2 values: 3 } }
+        attributes { categorical_set { values: 1 values: 2 } }
+        attributes {}
+        attributes { discretized_numerical: 2 }
+        attributes { numerical: 10 }
+        attributes { numerical: 11 }
+        attributes { numerical: 12 }
+        attributes {}
+        attributes {}
+        attributes { discretized_numerical: 2 }
+        attributes { discretized_numerical: 2 }
+        attributes { boolean: true }
+      )pb");
+  EXPECT_THAT(example_set.ExtractProtoExample(0, model).value(),
+              EqualsProto(expected_example));
+  EXPECT_THAT(example_set.ExtractProtoExample(1, model).value(),
+              EqualsProto(expected_example_1));
+
+  // Invalid values are detected like in the example-by-example conversion.
+  tensorflow::Example example_2 = example;
+  tensorflow::SetFeatureValues({1.0f, 2.0f}, "a", &example_2);
+  EXPECT_THAT(TfExamplesToExampleSet({example, example_2}, model.features(),
+                                     &example_set),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "Too many values for feature: a"));
+}
+
 }  // namespace
 }  // namespace serving
 }  // namespace yggdrasil_decision_forests
@@ -15,8 +15,11 @@
 
 #include "yggdrasil_decision_forests/utils/accurate_sum.h"
 
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/types/span.h"
 
 namespace yggdrasil_decision_forests {
 namespace utils {
@@ -56,6 +59,41 @@ TEST(AccurateSum, SumOfSquares) {
   EXPECT_NE(basic_sum, expected_sum_double);
 }
 
+TEST(AccurateSum, AddSpan) {
+  std::vector<double> values;
+  const int64_t n = 1e6;
+  for (int64_t i = 1; i <= n; i++) {
+    values.push_back(static_cast<double>(i) * i);
+  }
+  AccurateSum s;
+  s.AddSpan(absl::Span<const double>(values));
+  const int64_t expected_sum = n * (n + 1) * (2 * n + 1) / 6;
+  EXPECT_EQ(s.Sum(), static_cast<double>(expected_sum));
+}
+
+TEST(AccurateSum, AddSpanTail) {
+  // Fewer values than accumulator lanes.
+  std::vector<float> values = {1.f, 2.f, 3.f};
+  AccurateSum s;
+  s.Add(10.);
+  s.AddSpan(absl::Span<const float>(values));
+  EXPECT_EQ(s.Sum() + s.ErrorSum(), 16.);
+}
+
+TEST(AccurateSum, AddSpanCancellation) {
+  // Each of the eight accumulator lanes sees 1e100 + 1 - 1e100 + 1. The
+  // TwoSum error terms retain the small values exactly.
+  std::vector<double> values;
+  for (const double value : {1e100, 1., -1e100, 1.}) {
+    for (int lane = 0; lane < 8; lane++) {
+      values.push_back(value);
+    }
+  }
+  AccurateSum s;
+  s.AddSpan(absl::Span<const double>(values));
+  EXPECT_EQ(s.Sum() + s.ErrorSum(), 16.);
+}
+
 }  // namespace
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
@@ -62,5 +62,54 @@ double AdaptativeWork::OptimalApproximationFactor() const {
   return utils::clamp(approximation_factor, min_factor_, 1.);
 }
 
+DeadlineAwareWork::DeadlineAwareWork(const int num_tasks,
+                                     const double budget_seconds,
+                                     const double warming_up_seconds,
+                                     const double min_factor)
+    : num_tasks_(num_tasks),
+      budget_seconds_(budget_seconds),
+      warming_up_seconds_(warming_up_seconds),
+      min_factor_(min_factor) {
+  DCHECK_GT(budget_seconds, 0.0);
+  DCHECK_GE(warming_up_seconds, 0.0);
+}
+
+void DeadlineAwareWork::ReportTaskDone(const double approximation_factor,
+                                       const double duration_seconds) {
+  utils::concurrency::MutexLock lock(&mu_);
+  DCHECK_GE(approximation_factor, 0.0);
+  DCHECK_LE(approximation_factor, 1.0);
+  consumed_seconds_ += duration_seconds;
+  num_ran_tasks_++;
+  sum_approximation_factors_ += approximation_factor;
+}
+
+double DeadlineAwareWork::NextApproximationFactor() const {
+  utils::concurrency::MutexLock lock(&mu_);
+  if (consumed_seconds_ < warming_up_seconds_ ||
+      sum_approximation_factors_ == 0.0) {
+    return 1.;
+  }
+  const int num_remaining_tasks = num_tasks_ - num_ran_tasks_;
+  if (num_remaining_tasks <= 0) {
+    return 1.;
+  }
+  // Time of a fully executed task, estimated from the reported tasks.
+  const double full_task_seconds =
+      consumed_seconds_ / sum_approximation_factors_;
+  const double remaining_seconds = budget_seconds_ - consumed_seconds_;
+  const double approximation_factor =
+      remaining_seconds / (num_remaining_tasks * full_task_seconds);
+  return utils::clamp(approximation_factor, min_factor_, 1.);
+}
+
+double DeadlineAwareWork::AchievedFraction() const {
+  utils::concurrency::MutexLock lock(&mu_);
+  if (num_ran_tasks_ == 0) {
+    return 1.;
+  }
+  return sum_approximation_factors_ / num_ran_tasks_;
+}
+
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
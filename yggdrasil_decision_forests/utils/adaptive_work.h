@@ -63,6 +63,61 @@ class AdaptativeWork {
   mutable utils::concurrency::Mutex mu_;
 };
 
+// Given a wall-clock budget and a number of equally complex tasks that can be
+// approximated (i.e. partially executed) by an approximation factor, and a
+// stream of how long each task took, returns the fraction of each remaining
+// task to execute such that all the tasks complete within the budget.
+//
+// Unlike "AdaptativeWork", the factor only applies to the remaining tasks:
+// the work already done is not reconsidered. This is intended for interactive
+// tooling with a deadline e.g. "evaluate the model in at most 30 seconds, and
+// report how much of the computation was effectively done".
+//
+// If several worker threads consume the tasks, the budget should be scaled by
+// the number of threads (the manager accumulates per-task durations, not
+// elapsed wall-clock time).
+//
+// This class is thread safe.
+class DeadlineAwareWork {
+ public:
+  // Args:
+  //   num_tasks: Total number of tasks.
+  //   budget_seconds: Wall-clock budget for all the tasks.
+  //   warming_up_seconds: Minimum amount of consumed time before producing an
+  //     estimate.
+  //   min_factor: Minimum value returned by "NextApproximationFactor".
+  DeadlineAwareWork(int num_tasks, double budget_seconds,
+                    double warming_up_seconds, double min_factor);
+
+  // Reports a task. "approximation_factor" is the effectively executed
+  // fraction of the task: 1 for a fully executed task, 0 for a skipped task.
+  void ReportTaskDone(double approximation_factor, double duration_seconds)
+      LOCKS_EXCLUDED(mu_);
+
+  // Fraction of each of the remaining tasks to execute for all the tasks to
+  // complete within the budget. Returns 1 during the warming-up period.
+  double NextApproximationFactor() const LOCKS_EXCLUDED(mu_);
+
+  // Mean executed fraction of the reported tasks. Returns 1 if no task was
+  // reported.
+  double AchievedFraction() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  // Note: See constructor documentation.
+  const int num_tasks_;
+  const double budget_seconds_;
+  const double warming_up_seconds_;
+  const double min_factor_;
+
+  // Total consumed time so far.
+  double consumed_seconds_ GUARDED_BY(mu_) = 0.0;
+  // Number of tasks reported so far.
+  int num_ran_tasks_ GUARDED_BY(mu_) = 0;
+  // Sum of the executed fractions of the reported tasks.
+  double sum_approximation_factors_ GUARDED_BY(mu_) = 0.0;
+  mutable utils::concurrency::Mutex mu_;
+};
+
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
 
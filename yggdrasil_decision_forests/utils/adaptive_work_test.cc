@@ -42,6 +42,36 @@ TEST(AdaptativeWork, Base) {
   manager.ReportTaskDone(0.5, 5.);
 }
 
+TEST(DeadlineAwareWork, Base) {
+  DeadlineAwareWork manager(10, 100., 20., 0.);
+
+  EXPECT_NEAR(manager.NextApproximationFactor(), 1.0, kEpsilon);
+  EXPECT_NEAR(manager.AchievedFraction(), 1.0, kEpsilon);
+
+  // Still warming up.
+  manager.ReportTaskDone(1.0, 10.);
+  EXPECT_NEAR(manager.NextApproximationFactor(), 1.0, kEpsilon);
+
+  // 8 tasks of ~10s remain and 80s are left: everything fits.
+  manager.ReportTaskDone(1.0, 10.);
+  EXPECT_NEAR(manager.NextApproximationFactor(), 1.0, kEpsilon);
+
+  // A full task takes (10+10+40)/3=20s, 7 tasks remain and 40s are left.
+  manager.ReportTaskDone(1.0, 40.);
+  EXPECT_NEAR(manager.NextApproximationFactor(), 40. / (7 * 20.), kEpsilon);
+
+  // A skipped task consumes no time but counts in the achieved fraction.
+  manager.ReportTaskDone(0.0, 0.);
+  EXPECT_NEAR(manager.NextApproximationFactor(), 40. / (6 * 20.), kEpsilon);
+  EXPECT_NEAR(manager.AchievedFraction(), 3. / 4., kEpsilon);
+}
+
+TEST(DeadlineAwareWork, PastDeadline) {
+  DeadlineAwareWork manager(10, 100., 20., 0.25);
+  manager.ReportTaskDone(1.0, 120.);
+  EXPECT_NEAR(manager.NextApproximationFactor(), 0.25, kEpsilon);
+}
+
 }  // namespace
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
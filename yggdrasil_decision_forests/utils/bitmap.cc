@@ -18,12 +18,14 @@
 #include <stddef.h>
 
 #include <algorithm>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/numeric/bits.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/utils/bitmap.pb.h"
@@ -91,6 +93,122 @@ void BitmapToVectorBool(const std::string& bitmap, const uint64_t size,
   }
 }
 
+namespace {
+
+// Applies "op(dst, src)" on the bits of "dst" in [begin, end). "Op" operates
+// indifferently on uint8_t (for the partial bytes at the boundaries of the
+// range) and on uint64_t (for the full bytes, eight at a time).
+template <typename Op>
+void ApplyBitwiseOperation(const Op& op, const std::string& src,
+                           const uint64_t begin, const uint64_t end,
+                           std::string* dst) {
+  if (begin >= end) {
+    return;
+  }
+  DCHECK_LE((end + 7) / 8, src.size());
+  DCHECK_LE((end + 7) / 8, dst->size());
+
+  const auto apply_masked = [&](const uint64_t byte_idx, const uint8_t mask) {
+    uint8_t& dst_byte = SafeGetRef(*dst, byte_idx);
+    const uint8_t result = op(dst_byte, SafeGet(src, byte_idx));
+    dst_byte = (result & mask) | (dst_byte & ~mask);
+  };
+
+  uint64_t begin_byte = begin / 8;
+  uint64_t end_byte = end / 8;  // Last+1 full byte.
+  if (begin_byte == end_byte) {
+    // "begin" and "end" are in the same byte.
+    apply_masked(begin_byte,
+                 ((uint8_t{1} << (end - begin)) - 1) << (begin & 7));
+    return;
+  }
+  if ((begin & 7) != 0) {
+    // Partial first byte.
+    apply_masked(begin_byte, uint8_t{0xFF} << (begin & 7));
+    begin_byte++;
+  }
+  if ((end & 7) != 0) {
+    // Partial last byte.
+    apply_masked(end_byte, (uint8_t{1} << (end & 7)) - 1);
+  }
+  // Full bytes, eight at a time.
+  uint64_t byte_idx = begin_byte;
+  for (; byte_idx + 8 <= end_byte; byte_idx += 8) {
+    uint64_t src_word, dst_word;
+    std::memcpy(&src_word, src.data() + byte_idx, 8);
+    std::memcpy(&dst_word, dst->data() + byte_idx, 8);
+    dst_word = op(dst_word, src_word);
+    std::memcpy(&(*dst)[byte_idx], &dst_word, 8);
+  }
+  for (; byte_idx < end_byte; byte_idx++) {
+    uint8_t& dst_byte = SafeGetRef(*dst, byte_idx);
+    dst_byte = op(dst_byte, SafeGet(src, byte_idx));
+  }
+}
+
+struct AndOp {
+  template <typename T>
+  T operator()(const T dst, const T src) const {
+    return dst & src;
+  }
+};
+
+struct OrOp {
+  template <typename T>
+  T operator()(const T dst, const T src) const {
+    return dst | src;
+  }
+};
+
+struct AndNotOp {
+  template <typename T>
+  T operator()(const T dst, const T src) const {
+    return dst & static_cast<T>(~src);
+  }
+};
+
+}  // namespace
+
+void BitAnd(const std::string& src, const uint64_t begin, const uint64_t end,
+            std::string* dst) {
+  ApplyBitwiseOperation(AndOp(), src, begin, end, dst);
+}
+
+void BitOr(const std::string& src, const uint64_t begin, const uint64_t end,
+           std::string* dst) {
+  ApplyBitwiseOperation(OrOp(), src, begin, end, dst);
+}
+
+void BitAndNot(const std::string& src, const uint64_t begin,
+               const uint64_t end, std::string* dst) {
+  ApplyBitwiseOperation(AndNotOp(), src, begin, end, dst);
+}
+
+uint64_t CountSetBits(const std::string& bitmap, const uint64_t begin,
+                      const uint64_t end) {
+  if (begin >= end) {
+    return 0;
+  }
+  const uint64_t num_bytes = (end + 7) / 8;
+  DCHECK_LE(num_bytes, bitmap.size());
+  uint64_t count = 0;
+  for (uint64_t byte_idx = (begin / 8) & ~uint64_t{7}; byte_idx < num_bytes;
+       byte_idx += 8) {
+    uint64_t word = 0;
+    std::memcpy(&word, bitmap.data() + byte_idx,
+                std::min<uint64_t>(8, num_bytes - byte_idx));
+    const uint64_t first_bit = byte_idx * 8;
+    if (first_bit < begin) {
+      word &= ~uint64_t{0} << (begin - first_bit);
+    }
+    if (end - first_bit < 64) {
+      word &= (uint64_t{1} << (end - first_bit)) - 1;
+    }
+    count += absl::popcount(word);
+  }
+  return count;
+}
+
 uint64_t GetValueMultibit(const std::string& bitmap,
                           const int32_t bits_by_elements,
                           const uint64_t index) {
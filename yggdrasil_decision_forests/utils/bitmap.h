@@ -46,10 +46,13 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_TOOL_BITMAP_H_
 #define YGGDRASIL_DECISION_FORESTS_TOOL_BITMAP_H_
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/numeric/bits.h"
 #include "absl/status/status.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 
@@ -71,6 +74,33 @@ std::string ToStringBit(const std::string& bitmap, const uint64_t size);
 void BitmapToVectorBool(const std::string& bitmap, uint64_t size,
                         std::vector<bool>* bools);
 
+// Bulk operations over (single) bitmaps. "begin" and "end" are bit indexes.
+// All the operations run word-at-a-time and are significantly faster than
+// calling "GetValueBit" / "SetValueBit" on each bit. Both bitmaps should
+// contain at least ceil(end/8) bytes.
+
+// Applies "dst &= src" on the bits in [begin, end). The bits outside of the
+// range are not modified.
+void BitAnd(const std::string& src, uint64_t begin, uint64_t end,
+            std::string* dst);
+// Applies "dst |= src" on the bits in [begin, end).
+void BitOr(const std::string& src, uint64_t begin, uint64_t end,
+           std::string* dst);
+// Applies "dst &= ~src" on the bits in [begin, end).
+void BitAndNot(const std::string& src, uint64_t begin, uint64_t end,
+               std::string* dst);
+
+// Number of bits set to 1 in [begin, end). Uses the hardware popcount.
+uint64_t CountSetBits(const std::string& bitmap, uint64_t begin, uint64_t end);
+
+// Calls "callback(index)" for each bit set to 1 in [begin, end), in
+// increasing index order. Iterates with a count-trailing-zeros loop i.e. the
+// cost is proportional to the number of set bits (plus one word load per 64
+// bits of range).
+template <typename Callback>
+void ForEachSetBit(const std::string& bitmap, uint64_t begin, uint64_t end,
+                   const Callback& callback);
+
 // Allocate the memory of the bitmap.
 void AllocateMultibitmap(const int32_t bits_by_elements, const uint64_t size,
                          std::string* bitmap);
@@ -311,6 +341,36 @@ class ShardedMultiBitmap {
   std::vector<std::string> shards_;
 };
 
+template <typename Callback>
+void ForEachSetBit(const std::string& bitmap, const uint64_t begin,
+                   const uint64_t end, const Callback& callback) {
+  if (begin >= end) {
+    return;
+  }
+  const uint64_t num_bytes = (end + 7) / 8;
+  DCHECK_LE(num_bytes, bitmap.size());
+  // Iterate over 64 bit words aligned on the bytes of the bitmap.
+  for (uint64_t byte_idx = (begin / 8) & ~uint64_t{7}; byte_idx < num_bytes;
+       byte_idx += 8) {
+    uint64_t word = 0;
+    std::memcpy(&word, bitmap.data() + byte_idx,
+                std::min<uint64_t>(8, num_bytes - byte_idx));
+    const uint64_t first_bit = byte_idx * 8;
+    if (first_bit < begin) {
+      // Drop the bits before "begin".
+      word &= ~uint64_t{0} << (begin - first_bit);
+    }
+    if (end - first_bit < 64) {
+      // Drop the bits after "end".
+      word &= (uint64_t{1} << (end - first_bit)) - 1;
+    }
+    while (word != 0) {
+      callback(first_bit + absl::countr_zero(word));
+      word &= word - 1;
+    }
+  }
+}
+
 template <typename T>
 bool GetValueBit(const std::string& bitmap, const T index) {
   const T byte_index = index / 8;
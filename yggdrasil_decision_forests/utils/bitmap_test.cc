@@ -71,6 +71,110 @@ TEST(Bitmap, BitmapToVectorBool) {
   EXPECT_EQ(bools, std::vector<bool>({false, true, true, false}));
 }
 
+TEST(Bitmap, BulkBitwiseOperations) {
+  const int size = 20;
+  std::string src, dst;
+  AllocateAndZeroBitMap(size, &src);
+  for (int index : {0, 3, 9, 10, 17}) {
+    SetValueBit(index, &src);
+  }
+
+  AllocateAndZeroBitMap(size, &dst);
+  BitOr(src, 0, size, &dst);
+  EXPECT_EQ(ToStringBit(dst, size), ToStringBit(src, size));
+  // The bits outside of [4, 16) are not modified.
+  BitAndNot(src, 4, 16, &dst);
+  EXPECT_EQ(ToStringBit(dst, size), "10010000000000000100");
+  BitAnd(src, 0, 10, &dst);
+  EXPECT_EQ(ToStringBit(dst, size), "10010000000000000100");
+  BitAnd(src, 10, size, &dst);
+  EXPECT_EQ(ToStringBit(dst, size), "10010000000000000100");
+}
+
+TEST(Bitmap, BulkBitwiseOperationsRandom) {
+  auto test = [&](int size) {
+    std::default_random_engine rnd(size);
+    std::string src, dst_and, dst_or, dst_andnot;
+    AllocateAndZeroBitMap(size, &src);
+    AllocateAndZeroBitMap(size, &dst_and);
+    std::vector<bool> src_values(size, false), dst_values(size, false);
+    for (int j = 0; j < size; j++) {
+      if ((rnd() % 2) == 0) {
+        src_values[j] = true;
+        SetValueBit(j, &src);
+      }
+      if ((rnd() % 2) == 0) {
+        dst_values[j] = true;
+        SetValueBit(j, &dst_and);
+      }
+    }
+    dst_or = dst_and;
+    dst_andnot = dst_and;
+    const uint64_t begin = rnd() % (size + 1);
+    const uint64_t end = begin + rnd() % (size - begin + 1);
+    BitAnd(src, begin, end, &dst_and);
+    BitOr(src, begin, end, &dst_or);
+    BitAndNot(src, begin, end, &dst_andnot);
+    for (int j = 0; j < size; j++) {
+      const bool in_range = j >= begin && j < end;
+      CHECK_EQ(GetValueBit(dst_and, j),
+               in_range ? (dst_values[j] && src_values[j]) : dst_values[j]);
+      CHECK_EQ(GetValueBit(dst_or, j),
+               in_range ? (dst_values[j] || src_values[j]) : dst_values[j]);
+      CHECK_EQ(GetValueBit(dst_andnot, j),
+               in_range ? (dst_values[j] && !src_values[j]) : dst_values[j]);
+    }
+  };
+  for (int size = 1; size < 512; size++) test(size);
+}
+
+TEST(Bitmap, CountSetBits) {
+  auto test = [&](int size) {
+    std::default_random_engine rnd(size);
+    std::string map;
+    AllocateAndZeroBitMap(size, &map);
+    std::vector<bool> values(size, false);
+    for (int j = 0; j < size; j++) {
+      if ((rnd() % 2) == 0) {
+        values[j] = true;
+        SetValueBit(j, &map);
+      }
+    }
+    const uint64_t begin = rnd() % (size + 1);
+    const uint64_t end = begin + rnd() % (size - begin + 1);
+    uint64_t expected_count = 0;
+    for (uint64_t j = begin; j < end; j++) {
+      expected_count += values[j];
+    }
+    CHECK_EQ(CountSetBits(map, begin, end), expected_count);
+  };
+  for (int size = 1; size < 512; size++) test(size);
+}
+
+TEST(Bitmap, ForEachSetBit) {
+  auto test = [&](int size) {
+    std::default_random_engine rnd(size);
+    std::string map;
+    AllocateAndZeroBitMap(size, &map);
+    std::vector<uint64_t> expected_indexes;
+    const uint64_t begin = rnd() % (size + 1);
+    const uint64_t end = begin + rnd() % (size - begin + 1);
+    for (int j = 0; j < size; j++) {
+      if ((rnd() % 2) == 0) {
+        SetValueBit(j, &map);
+        if (j >= begin && j < end) {
+          expected_indexes.push_back(j);
+        }
+      }
+    }
+    std::vector<uint64_t> indexes;
+    ForEachSetBit(map, begin, end,
+                  [&](const uint64_t index) { indexes.push_back(index); });
+    CHECK(indexes == expected_indexes);
+  };
+  for (int size = 1; size < 512; size++) test(size);
+}
+
 TEST(Bitmap, SetValueBit) {
   std::string map;
   std::vector<bool> check_map;
@@ -15,11 +15,78 @@
 
 #include "yggdrasil_decision_forests/utils/blob_sequence.h"
 
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
 namespace utils {
 namespace blob_sequence {
+namespace {
+
+// Reads and decompresses the payload of a compressed block record.
+// "header_length" is the host-order "RecordHeader::length" of the record
+// (with the "kCompressedBlockFlag" bit set). The stream should be positioned
+// right after the record header.
+absl::Status ReadCompressedBlock(utils::InputByteStream* stream,
+                                 const uint32_t header_length,
+                                 std::string* raw_block) {
+  const uint32_t payload_size = header_length & ~internal::kCompressedBlockFlag;
+  if (payload_size < sizeof(uint32_t)) {
+    return absl::InvalidArgumentError("Invalid compressed block");
+  }
+  std::string payload(payload_size, 0);
+  ASSIGN_OR_RETURN(const auto has_content,
+                   stream->ReadExactly(&payload[0], payload_size));
+  if (!has_content) {
+    return absl::InvalidArgumentError("Truncated compressed block");
+  }
+  uint32_t raw_size;
+  std::memcpy(&raw_size, payload.data(), sizeof(uint32_t));
+  raw_size = absl::little_endian::ToHost32(raw_size);
+  if (raw_size == 0) {
+    return absl::InvalidArgumentError("Invalid compressed block");
+  }
+  raw_block->resize(raw_size);
+  uLongf decompressed_size = raw_size;
+  if (uncompress((Bytef*)&(*raw_block)[0], &decompressed_size,
+                 (const Bytef*)payload.data() + sizeof(uint32_t),
+                 payload_size - sizeof(uint32_t)) != Z_OK ||
+      decompressed_size != raw_size) {
+    return absl::InvalidArgumentError("Corrupted compressed block");
+  }
+  return absl::OkStatus();
+}
+
+// Extracts the "ordinal"-th blob record of a decompressed block.
+absl::Status GetBlobInBlock(const std::string& block, size_t ordinal,
+                            std::string* blob) {
+  size_t offset = 0;
+  while (true) {
+    internal::RecordHeader header;
+    if (offset + sizeof(internal::RecordHeader) > block.size()) {
+      return absl::InvalidArgumentError("Truncated compressed block");
+    }
+    std::memcpy(&header, block.data() + offset,
+                sizeof(internal::RecordHeader));
+    header.length = absl::little_endian::ToHost32(header.length);
+    offset += sizeof(internal::RecordHeader);
+    if (offset + header.length > block.size()) {
+      return absl::InvalidArgumentError("Truncated compressed block");
+    }
+    if (ordinal == 0) {
+      blob->assign(block, offset, header.length);
+      return absl::OkStatus();
+    }
+    offset += header.length;
+    ordinal--;
+  }
+}
+
+}  // namespace
 
 utils::StatusOr<Reader> Reader::Create(utils::InputByteStream* stream) {
   Reader reader;
@@ -36,11 +103,33 @@ utils::StatusOr<Reader> Reader::Create(utils::InputByteStream* stream) {
     return absl::InvalidArgumentError("Invalid header");
   }
   reader.version_ = absl::little_endian::ToHost16(header.version);
+  if (reader.version_ > 3) {
+    return absl::InvalidArgumentError(
+        "The blob sequence was created with a newer version of the library");
+  }
 
   return reader;
 }
 
 utils::StatusOr<bool> Reader::Read(std::string* blob) {
+  // Serve the next record of the last decompressed block (if any).
+  if (block_offset_ < block_buffer_.size()) {
+    internal::RecordHeader header;
+    if (block_offset_ + sizeof(internal::RecordHeader) > block_buffer_.size()) {
+      return absl::InvalidArgumentError("Truncated compressed block");
+    }
+    std::memcpy(&header, block_buffer_.data() + block_offset_,
+                sizeof(internal::RecordHeader));
+    header.length = absl::little_endian::ToHost32(header.length);
+    block_offset_ += sizeof(internal::RecordHeader);
+    if (block_offset_ + header.length > block_buffer_.size()) {
+      return absl::InvalidArgumentError("Truncated compressed block");
+    }
+    blob->assign(block_buffer_, block_offset_, header.length);
+    block_offset_ += header.length;
+    return true;
+  }
+
   internal::RecordHeader header;
   ASSIGN_OR_RETURN(
       auto has_content,
@@ -51,6 +140,18 @@ utils::StatusOr<bool> Reader::Read(std::string* blob) {
   }
 
   header.length = absl::little_endian::ToHost32(header.length);
+  if (header.length & internal::kInternalRecordFlag) {
+    // Internal record (e.g. the index): end of the blobs.
+    return false;
+  }
+
+  if (header.length & internal::kCompressedBlockFlag) {
+    // Decompress the block and serve its first record.
+    RETURN_IF_ERROR(
+        ReadCompressedBlock(stream_, header.length, &block_buffer_));
+    block_offset_ = 0;
+    return Read(blob);
+  }
 
   blob->resize(header.length);
   ASSIGN_OR_RETURN(has_content,
@@ -64,17 +165,125 @@ utils::StatusOr<bool> Reader::Read(std::string* blob) {
 
 absl::Status Reader::Close() { return absl::OkStatus(); }
 
-utils::StatusOr<Writer> Writer::Create(utils::OutputByteStream* stream) {
+utils::StatusOr<IndexedReader> IndexedReader::Create(
+    utils::InputByteStream* stream) {
+  IndexedReader reader;
+  reader.stream_ = stream;
+
+  // Validate the file header.
+  RETURN_IF_ERROR(stream->Seek(0));
+  RETURN_IF_ERROR(Reader::Create(stream).status());
+
+  // Read the trailer.
+  internal::FileTrailer trailer;
+  RETURN_IF_ERROR(
+      stream->Seek(-static_cast<int64_t>(sizeof(internal::FileTrailer))));
+  ASSIGN_OR_RETURN(auto has_content,
+                   stream->ReadExactly((char*)&trailer,
+                                       sizeof(internal::FileTrailer)));
+  if (!has_content || trailer.magic[0] != 'B' || trailer.magic[1] != 'I') {
+    return absl::InvalidArgumentError(
+        "The blob sequence does not contain an index");
+  }
+
+  // Read the index record.
+  RETURN_IF_ERROR(stream->Seek(
+      absl::little_endian::ToHost64(trailer.index_record_offset)));
+  internal::RecordHeader header;
+  ASSIGN_OR_RETURN(has_content,
+                   stream->ReadExactly((char*)&header,
+                                       sizeof(internal::RecordHeader)));
+  header.length = absl::little_endian::ToHost32(header.length);
+  if (!has_content || !(header.length & internal::kInternalRecordFlag)) {
+    return absl::InvalidArgumentError("Invalid index record");
+  }
+  const uint32_t index_size = header.length & ~internal::kInternalRecordFlag;
+  reader.index_.resize(index_size / sizeof(uint64_t));
+  ASSIGN_OR_RETURN(
+      has_content,
+      stream->ReadExactly((char*)reader.index_.data(), index_size));
+  if (!has_content) {
+    return absl::InvalidArgumentError("Truncated index record");
+  }
+  for (auto& offset : reader.index_) {
+    offset = absl::little_endian::ToHost64(offset);
+  }
+
+  return reader;
+}
+
+absl::Status IndexedReader::ReadAt(const int64_t blob_idx, std::string* blob) {
+  if (blob_idx < 0 || blob_idx >= num_blobs()) {
+    return absl::InvalidArgumentError("Blob index out of range");
+  }
+  const uint64_t record_offset = index_[blob_idx];
+
+  // Ordinal of the blob in its compressed block: the blobs of a same block
+  // all reference the block record, and the index is sorted by offset.
+  const auto ordinal_in_block = [&]() -> size_t {
+    return blob_idx - (std::lower_bound(index_.begin(), index_.end(),
+                                        record_offset) -
+                       index_.begin());
+  };
+
+  // Serve the blob from the cached decompressed block (if any).
+  if (record_offset == block_buffer_offset_) {
+    return GetBlobInBlock(block_buffer_, ordinal_in_block(), blob);
+  }
+
+  RETURN_IF_ERROR(stream_->Seek(record_offset));
+
+  internal::RecordHeader header;
+  ASSIGN_OR_RETURN(
+      auto has_content,
+      stream_->ReadExactly((char*)&header, sizeof(internal::RecordHeader)));
+  header.length = absl::little_endian::ToHost32(header.length);
+  if (!has_content || (header.length & internal::kInternalRecordFlag)) {
+    return absl::InvalidArgumentError("Invalid blob record");
+  }
+
+  if (header.length & internal::kCompressedBlockFlag) {
+    RETURN_IF_ERROR(
+        ReadCompressedBlock(stream_, header.length, &block_buffer_));
+    block_buffer_offset_ = record_offset;
+    return GetBlobInBlock(block_buffer_, ordinal_in_block(), blob);
+  }
+
+  blob->resize(header.length);
+  ASSIGN_OR_RETURN(has_content,
+                   stream_->ReadExactly(&(*blob)[0], header.length));
+  if (!has_content) {
+    return absl::InvalidArgumentError("Truncated blob");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status IndexedReader::Close() { return absl::OkStatus(); }
+
+utils::StatusOr<Writer> Writer::Create(utils::OutputByteStream* stream,
+                                       const WriterOptions& options) {
   Writer writer;
   writer.stream_ = stream;
+  writer.write_index_ = options.write_index;
+  writer.compression_ = options.compression;
+
+  uint16_t version = 0;
+  if (options.write_index && options.compression) {
+    version = 3;
+  } else if (options.write_index) {
+    version = 1;
+  } else if (options.compression) {
+    version = 2;
+  }
 
   internal::FileHeader header;
   header.magic[0] = 'B';
   header.magic[1] = 'S';
-  header.version = absl::little_endian::FromHost16(0);
+  header.version = absl::little_endian::FromHost16(version);
 
   RETURN_IF_ERROR(writer.stream_->Write(
       absl::string_view((char*)&header, sizeof(internal::FileHeader))));
+  writer.offset_ = sizeof(internal::FileHeader);
 
   return writer;
 }
@@ -83,13 +292,93 @@ absl::Status Writer::Write(const absl::string_view blob) {
   internal::RecordHeader header;
   header.length = absl::little_endian::FromHost32(blob.size());
 
+  if (compression_) {
+    // Accumulate the record in the current block.
+    num_blobs_in_block_++;
+    block_buffer_.append((char*)&header, sizeof(internal::RecordHeader));
+    block_buffer_.append(blob.data(), blob.size());
+    if (block_buffer_.size() >= internal::kCompressedBlockSizeBytes) {
+      return FlushBlock();
+    }
+    return absl::OkStatus();
+  }
+
+  if (write_index_) {
+    record_offsets_.push_back(offset_);
+  }
   RETURN_IF_ERROR(stream_->Write(
       absl::string_view((char*)&header, sizeof(internal::RecordHeader))));
+  RETURN_IF_ERROR(stream_->Write(blob));
+  offset_ += sizeof(internal::RecordHeader) + blob.size();
+  return absl::OkStatus();
+}
+
+absl::Status Writer::FlushBlock() {
+  if (block_buffer_.empty()) {
+    return absl::OkStatus();
+  }
+  if (write_index_) {
+    // All the blobs of the block reference the block record.
+    record_offsets_.insert(record_offsets_.end(), num_blobs_in_block_,
+                           offset_);
+  }
+  num_blobs_in_block_ = 0;
+  const uint32_t raw_size = static_cast<uint32_t>(block_buffer_.size());
 
-  return stream_->Write(blob);
+  // Payload: decompressed size followed by the compressed records.
+  std::string payload(sizeof(uint32_t) + compressBound(raw_size), 0);
+  const uint32_t le_raw_size = absl::little_endian::FromHost32(raw_size);
+  std::memcpy(&payload[0], &le_raw_size, sizeof(uint32_t));
+  uLongf compressed_size = payload.size() - sizeof(uint32_t);
+  if (compress2((Bytef*)&payload[sizeof(uint32_t)], &compressed_size,
+                (const Bytef*)block_buffer_.data(), raw_size,
+                Z_DEFAULT_COMPRESSION) != Z_OK) {
+    return absl::InternalError("Cannot compress the block");
+  }
+  payload.resize(sizeof(uint32_t) + compressed_size);
+
+  internal::RecordHeader header;
+  header.length = absl::little_endian::FromHost32(
+      internal::kCompressedBlockFlag | static_cast<uint32_t>(payload.size()));
+  RETURN_IF_ERROR(stream_->Write(
+      absl::string_view((char*)&header, sizeof(internal::RecordHeader))));
+  RETURN_IF_ERROR(stream_->Write(payload));
+  offset_ += sizeof(internal::RecordHeader) + payload.size();
+  block_buffer_.clear();
+  return absl::OkStatus();
 }
 
-absl::Status Writer::Close() { return absl::OkStatus(); }
+absl::Status Writer::Close() {
+  if (compression_) {
+    RETURN_IF_ERROR(FlushBlock());
+  }
+
+  if (!write_index_) {
+    return absl::OkStatus();
+  }
+
+  // Write the index as an internal record, followed by a trailer pointing to
+  // it.
+  internal::FileTrailer trailer;
+  trailer.index_record_offset = absl::little_endian::FromHost64(offset_);
+  trailer.magic[0] = 'B';
+  trailer.magic[1] = 'I';
+
+  internal::RecordHeader header;
+  header.length = absl::little_endian::FromHost32(
+      internal::kInternalRecordFlag |
+      static_cast<uint32_t>(record_offsets_.size() * sizeof(uint64_t)));
+  RETURN_IF_ERROR(stream_->Write(
+      absl::string_view((char*)&header, sizeof(internal::RecordHeader))));
+  for (auto& offset : record_offsets_) {
+    offset = absl::little_endian::FromHost64(offset);
+  }
+  RETURN_IF_ERROR(stream_->Write(
+      absl::string_view((char*)record_offsets_.data(),
+                        record_offsets_.size() * sizeof(uint64_t))));
+  return stream_->Write(
+      absl::string_view((char*)&trailer, sizeof(internal::FileTrailer)));
+}
 
 }  // namespace blob_sequence
 }  // namespace utils
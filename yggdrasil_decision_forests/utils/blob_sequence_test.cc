@@ -17,6 +17,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 
@@ -52,6 +53,163 @@ TEST(BlobSequence, Base) {
   CHECK_OK(input_stream->Close());
 }
 
+TEST(BlobSequence, IndexedRead) {
+  auto path = file::JoinPath(test::TmpDirectory(), "blob_sequence.bin");
+
+  // Create a BS with three blobs and an index.
+  auto output_stream = file::OpenOutputFile(path).value();
+  WriterOptions options;
+  options.write_index = true;
+  auto writer =
+      blob_sequence::Writer::Create(output_stream.get(), options).value();
+  CHECK_OK(writer.Write("HELLO"));
+  CHECK_OK(writer.Write(""));  // Empty blob.
+  CHECK_OK(writer.Write("WORLD"));
+  CHECK_OK(writer.Close());
+  CHECK_OK(output_stream->Close());
+
+  // Read the blobs in a random order.
+  auto input_stream = file::OpenInputFile(path).value();
+  auto reader = blob_sequence::IndexedReader::Create(input_stream.get())
+                    .value();
+  EXPECT_EQ(reader.num_blobs(), 3);
+  std::string blob;
+  CHECK_OK(reader.ReadAt(2, &blob));
+  CHECK_EQ(blob, "WORLD");
+  CHECK_OK(reader.ReadAt(0, &blob));
+  CHECK_EQ(blob, "HELLO");
+  CHECK_OK(reader.ReadAt(1, &blob));
+  CHECK_EQ(blob, "");
+  EXPECT_THAT(reader.ReadAt(3, &blob),
+              test::StatusIs(absl::StatusCode::kInvalidArgument));
+  CHECK_OK(reader.Close());
+  CHECK_OK(input_stream->Close());
+}
+
+TEST(BlobSequence, SequentialReadOfIndexedFile) {
+  auto path = file::JoinPath(test::TmpDirectory(), "blob_sequence.bin");
+
+  // Create a BS with two blobs and an index.
+  auto output_stream = file::OpenOutputFile(path).value();
+  WriterOptions options;
+  options.write_index = true;
+  auto writer =
+      blob_sequence::Writer::Create(output_stream.get(), options).value();
+  CHECK_OK(writer.Write("HELLO"));
+  CHECK_OK(writer.Write("WORLD"));
+  CHECK_OK(writer.Close());
+  CHECK_OK(output_stream->Close());
+
+  // The sequential reader does not return the index as a blob.
+  auto input_stream = file::OpenInputFile(path).value();
+  auto reader = blob_sequence::Reader::Create(input_stream.get()).value();
+  std::string blob;
+  CHECK(reader.Read(&blob).value());
+  CHECK_EQ(blob, "HELLO");
+  CHECK(reader.Read(&blob).value());
+  CHECK_EQ(blob, "WORLD");
+  CHECK(!reader.Read(&blob).value());
+  CHECK_OK(reader.Close());
+  CHECK_OK(input_stream->Close());
+}
+
+TEST(BlobSequence, IndexedReadWithoutIndex) {
+  auto path = file::JoinPath(test::TmpDirectory(), "blob_sequence.bin");
+
+  // Create a BS without an index.
+  auto output_stream = file::OpenOutputFile(path).value();
+  auto writer = blob_sequence::Writer::Create(output_stream.get()).value();
+  CHECK_OK(writer.Write("HELLO"));
+  CHECK_OK(writer.Close());
+  CHECK_OK(output_stream->Close());
+
+  auto input_stream = file::OpenInputFile(path).value();
+  EXPECT_THAT(blob_sequence::IndexedReader::Create(input_stream.get()).status(),
+              test::StatusIs(absl::StatusCode::kInvalidArgument));
+  CHECK_OK(input_stream->Close());
+}
+
+TEST(BlobSequence, CompressedReadAndWrite) {
+  auto path = file::JoinPath(test::TmpDirectory(), "blob_sequence.bin");
+
+  // Create a compressed BS spanning several blocks.
+  auto output_stream = file::OpenOutputFile(path).value();
+  WriterOptions options;
+  options.compression = true;
+  auto writer =
+      blob_sequence::Writer::Create(output_stream.get(), options).value();
+  const int num_blobs = 1000;
+  const std::string filler(10000, 'x');
+  for (int blob_idx = 0; blob_idx < num_blobs; blob_idx++) {
+    CHECK_OK(writer.Write(absl::StrCat("HELLO ", blob_idx, " ", filler)));
+  }
+  CHECK_OK(writer.Close());
+  CHECK_OK(output_stream->Close());
+
+  // The compression reduces the file size.
+  CHECK_LT(file::GetContent(path).value().size(),
+           num_blobs * filler.size() / 4);
+
+  // The sequential reader decompresses the blobs transparently.
+  auto input_stream = file::OpenInputFile(path).value();
+  auto reader = blob_sequence::Reader::Create(input_stream.get()).value();
+  std::string blob;
+  for (int blob_idx = 0; blob_idx < num_blobs; blob_idx++) {
+    CHECK(reader.Read(&blob).value());
+    CHECK_EQ(blob, absl::StrCat("HELLO ", blob_idx, " ", filler));
+  }
+  CHECK(!reader.Read(&blob).value());
+  CHECK_OK(reader.Close());
+  CHECK_OK(input_stream->Close());
+}
+
+TEST(BlobSequence, IndexedReadOfCompressedFile) {
+  auto path = file::JoinPath(test::TmpDirectory(), "blob_sequence.bin");
+
+  // Create a compressed and indexed BS spanning several blocks.
+  auto output_stream = file::OpenOutputFile(path).value();
+  WriterOptions options;
+  options.write_index = true;
+  options.compression = true;
+  auto writer =
+      blob_sequence::Writer::Create(output_stream.get(), options).value();
+  const int num_blobs = 1000;
+  const std::string filler(10000, 'x');
+  for (int blob_idx = 0; blob_idx < num_blobs; blob_idx++) {
+    CHECK_OK(writer.Write(absl::StrCat("HELLO ", blob_idx, " ", filler)));
+  }
+  CHECK_OK(writer.Close());
+  CHECK_OK(output_stream->Close());
+
+  // Read the blobs in a random order. Each read decompresses (at most) one
+  // block.
+  auto input_stream = file::OpenInputFile(path).value();
+  auto reader =
+      blob_sequence::IndexedReader::Create(input_stream.get()).value();
+  EXPECT_EQ(reader.num_blobs(), num_blobs);
+  std::string blob;
+  for (const int blob_idx : {999, 0, 500, 501, 250}) {
+    CHECK_OK(reader.ReadAt(blob_idx, &blob));
+    CHECK_EQ(blob, absl::StrCat("HELLO ", blob_idx, " ", filler));
+  }
+  EXPECT_THAT(reader.ReadAt(num_blobs, &blob),
+              test::StatusIs(absl::StatusCode::kInvalidArgument));
+  CHECK_OK(reader.Close());
+
+  // The sequential reader still reads the blobs in order.
+  CHECK_OK(input_stream->Close());
+  input_stream = file::OpenInputFile(path).value();
+  auto sequential_reader =
+      blob_sequence::Reader::Create(input_stream.get()).value();
+  for (int blob_idx = 0; blob_idx < num_blobs; blob_idx++) {
+    CHECK(sequential_reader.Read(&blob).value());
+    CHECK_EQ(blob, absl::StrCat("HELLO ", blob_idx, " ", filler));
+  }
+  CHECK(!sequential_reader.Read(&blob).value());
+  CHECK_OK(sequential_reader.Close());
+  CHECK_OK(input_stream->Close());
+}
+
 TEST(BlobSequence, NotABs) {
   auto path = file::JoinPath(test::TmpDirectory(), "blob_sequence.bin");
 
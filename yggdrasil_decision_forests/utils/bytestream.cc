@@ -59,5 +59,16 @@ utils::StatusOr<bool> StringInputByteStream::ReadExactly(char* buffer,
   return true;
 }
 
+absl::Status StringInputByteStream::Seek(const int64_t position) {
+  const int64_t target =
+      position >= 0 ? position
+                    : static_cast<int64_t>(content_.size()) + position;
+  if (target < 0 || target > static_cast<int64_t>(content_.size())) {
+    return absl::OutOfRangeError("Seek outside of the stream");
+  }
+  current_ = target;
+  return absl::OkStatus();
+}
+
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
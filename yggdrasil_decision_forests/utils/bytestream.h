@@ -18,9 +18,12 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_UTILS_BYTESTREAM_H_
 #define YGGDRASIL_DECISION_FORESTS_UTILS_BYTESTREAM_H_
 
+#include <stdint.h>
+
 #include <string>
 
 #include "absl/base/macros.h"
+#include "absl/status/status.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
 
 namespace yggdrasil_decision_forests {
@@ -42,6 +45,14 @@ class InputByteStream {
 
   // Reads and returns the entire content of the stream.
   utils::StatusOr<std::string> ReadAll();
+
+  // Moves the read head to "position", expressed in bytes from the start of
+  // the stream. If "position" is negative, it is interpreted relative to the
+  // end of the stream (e.g. -4 designates the fourth byte from the end). Not
+  // all the streams support seeking.
+  virtual absl::Status Seek(int64_t position) {
+    return absl::UnimplementedError("Seek is not supported by this stream");
+  }
 };
 
 // Wraps a InputByteStream around a std::string.
@@ -53,6 +64,8 @@ class StringInputByteStream : public InputByteStream {
 
   utils::StatusOr<bool> ReadExactly(char* buffer, int num_read) override;
 
+  absl::Status Seek(int64_t position) override;
+
  private:
   // String content.
   std::string content_;
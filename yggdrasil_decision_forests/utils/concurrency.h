@@ -20,6 +20,8 @@
 //   StreamProcessor: Parallel processing of a stream of "Input" into a stream
 //     of "Output" using a pre-determined number of threads. Does not implement
 //     a maximum capacity.
+//   ParallelFor: Blocking parallel loop over a range of indices, with
+//     grain-size control and automatic load balancing.
 //
 // Usage examples:
 //
@@ -41,6 +43,10 @@
 //     result = processor.GetResult();
 //   }
 //
+//   # ParallelFor
+//   ParallelFor(0, n, /*min_block_size=*/1024, &pool,
+//               [&](size_t begin_idx, size_t end_idx) {...});
+//
 
 #ifndef YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_H_
 #define YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_H_
@@ -50,6 +56,9 @@
 #include "yggdrasil_decision_forests/utils/concurrency_default.h"
 
 #include "yggdrasil_decision_forests/utils/concurrency_channel.h"
+#include "yggdrasil_decision_forests/utils/concurrency_lockfreechannel.h"
+#include "yggdrasil_decision_forests/utils/concurrency_parallelfor.h"
+#include "yggdrasil_decision_forests/utils/concurrency_spscchannel.h"
 #include "yggdrasil_decision_forests/utils/concurrency_streamprocessor.h"
 
 #endif  // YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_H_
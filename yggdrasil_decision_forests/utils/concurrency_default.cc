@@ -17,16 +17,56 @@
 
 #include <iostream>
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "yggdrasil_decision_forests/utils/logging.h"
+
 namespace yggdrasil_decision_forests {
 namespace utils {
 namespace concurrency {
+namespace {
+
+// Pool and worker index of the current thread, if the current thread is a
+// ThreadPool worker. Used to push the jobs scheduled by a worker on this
+// worker's own deque.
+thread_local ThreadPool* current_thread_pool = nullptr;
+thread_local int current_worker_idx = -1;
+
+// Pins the calling thread to a single CPU core. No-op on non-Linux platforms.
+void PinThreadToCore(const int thread_idx) {
+#if defined(__linux__)
+  const int num_cores = std::thread::hardware_concurrency();
+  if (num_cores <= 0) {
+    return;
+  }
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(thread_idx % num_cores, &cpuset);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+#else
+  (void)thread_idx;
+#endif
+}
+
+}  // namespace
 
 Thread::Thread(std::function<void(void)> call) : thread_(std::move(call)) {}
 
 void Thread::Join() { thread_.join(); }
 
 ThreadPool::ThreadPool(std::string name, int num_threads)
-    : name_(std::move(name)), num_threads_(num_threads) {}
+    : ThreadPool(std::move(name), num_threads, Options()) {}
+
+ThreadPool::ThreadPool(std::string name, int num_threads, Options options)
+    : name_(std::move(name)), num_threads_(num_threads), options_(options) {
+  queues_.reserve(num_threads_);
+  for (int queue_idx = 0; queue_idx < num_threads_; queue_idx++) {
+    queues_.push_back(std::unique_ptr<PerThreadQueue>(new PerThreadQueue()));
+  }
+}
 
 ThreadPool::~ThreadPool() { JoinAllAndStopThreads(); }
 
@@ -34,7 +74,11 @@ void ThreadPool::JoinAllAndStopThreads() {
   if (num_threads_ == 0) {
     return;
   }
-  jobs_.Close();
+  stop_.store(true);
+  {
+    MutexLock lock(&idle_mutex_);
+    idle_cond_var_.SignalAll();
+  }
   for (auto& thread : threads_) {
     thread.join();
   }
@@ -43,29 +87,106 @@ void ThreadPool::JoinAllAndStopThreads() {
 
 void ThreadPool::StartWorkers() {
   while (threads_.size() < num_threads_) {
-    threads_.emplace_back(&ThreadPool::ThreadLoop, this);
+    const int thread_idx = threads_.size();
+    threads_.emplace_back([this, thread_idx]() { ThreadLoop(thread_idx); });
   }
 }
 
 void ThreadPool::Schedule(std::function<void()> callback) {
   if (num_threads_ == 0) {
     callback();
+    return;
+  }
+  if (stop_.load()) {
+    LOG(ERROR) << "Ignoring job scheduled on a stopped thread pool.";
+    return;
+  }
+
+  // Jobs scheduled by a worker go on this worker's deque. Jobs scheduled from
+  // outside of the pool are distributed round-robin over the deques.
+  int queue_idx;
+  if (current_thread_pool == this) {
+    queue_idx = current_worker_idx;
   } else {
-    jobs_.Push(std::move(callback));
+    queue_idx = next_queue_idx_.fetch_add(1) % num_threads_;
+  }
+
+  {
+    MutexLock lock(&queues_[queue_idx]->mutex);
+    queues_[queue_idx]->jobs.push_back(std::move(callback));
+  }
+  num_pending_jobs_.fetch_add(1);
+
+  // Wake-up an idle worker, if any. Both "num_pending_jobs_" and
+  // "num_idle_workers_" are sequentially consistent: either this thread sees
+  // the idle worker, or the worker sees the pending job before parking.
+  if (num_idle_workers_.load() > 0) {
+    MutexLock lock(&idle_mutex_);
+    idle_cond_var_.Signal();
   }
 }
 
-void ThreadPool::ThreadLoop() {
+bool ThreadPool::TryGetJob(const int thread_idx, std::function<void()>* job) {
+  // The worker's own deque first, most recently pushed job first.
+  {
+    auto& queue = *queues_[thread_idx];
+    MutexLock lock(&queue.mutex);
+    if (!queue.jobs.empty()) {
+      *job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+      num_pending_jobs_.fetch_sub(1);
+      return true;
+    }
+  }
+  // Steal the oldest job of another worker.
+  for (int offset = 1; offset < num_threads_; offset++) {
+    auto& queue = *queues_[(thread_idx + offset) % num_threads_];
+    MutexLock lock(&queue.mutex);
+    if (!queue.jobs.empty()) {
+      *job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+      num_pending_jobs_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::ThreadLoop(const int thread_idx) {
+  current_thread_pool = this;
+  current_worker_idx = thread_idx;
+  if (options_.pin_threads_to_cores) {
+    PinThreadToCore(thread_idx);
+  }
+
+  std::function<void()> job;
   while (true) {
-    // Get a job.
-    auto optional_input = jobs_.Pop();
-    if (!optional_input.has_value()) {
+    if (TryGetJob(thread_idx, &job)) {
+      // Run the job.
+      job();
+      job = nullptr;
+      continue;
+    }
+
+    if (stop_.load() && num_pending_jobs_.load() == 0) {
       break;
     }
+    if (num_pending_jobs_.load() > 0) {
+      // A job was pushed (or is being popped) concurrently. Retry.
+      continue;
+    }
 
-    // Run the job.
-    std::move(optional_input).value()();
+    // Park until a job is scheduled or the pool is stopped.
+    MutexLock lock(&idle_mutex_);
+    num_idle_workers_.fetch_add(1);
+    while (num_pending_jobs_.load() == 0 && !stop_.load()) {
+      idle_cond_var_.Wait(&idle_mutex_, &lock);
+    }
+    num_idle_workers_.fetch_sub(1);
   }
+
+  current_thread_pool = nullptr;
+  current_worker_idx = -1;
 }
 
 }  // namespace concurrency
@@ -16,6 +16,9 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_DEFAULT_H_
 #define YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_DEFAULT_H_
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <queue>
 #include <string>
 #include <thread>
@@ -37,12 +40,26 @@ class Thread {
   std::thread thread_;
 };
 
+// Pool of threads with per-thread work-stealing job deques: a worker pops
+// jobs from its own deque and steals from the other workers when its deque is
+// empty, so scheduling does not contend on a single shared queue. Jobs
+// scheduled from within a worker are pushed on that worker's deque, which
+// keeps a job close to the data touched by the job that created it.
 class ThreadPool {
  public:
+  struct Options {
+    // If true, each worker is pinned to a CPU core (round-robin over the
+    // available cores). Only effective on Linux; ignored on other platforms.
+    // Combined with worker-local scheduling, pinning keeps a worker and the
+    // memory it first-touched on the same socket on NUMA machines.
+    bool pin_threads_to_cores = false;
+  };
+
   // Creates the thread pool. Don't start any thread yet.
   // If "num_threads==0", callback are executed synchronously without threading
   // during "Schedule" calls.
   ThreadPool(std::string name, int num_threads);
+  ThreadPool(std::string name, int num_threads, Options options);
 
   // Ensure all the jobs are done and all the threads have been joined.
   ~ThreadPool();
@@ -59,11 +76,23 @@ class ThreadPool {
   int num_threads() const { return threads_.size(); }
 
  private:
+  // Job deque of a worker, guarded by its own mutex. The worker pops from the
+  // back of its deque (most recently pushed first) while the other workers
+  // steal from the front (oldest first).
+  struct PerThreadQueue {
+    Mutex mutex;
+    std::deque<std::function<void()>> jobs GUARDED_BY(mutex);
+  };
+
   // Ensure all the jobs are done and all the threads have been joined.
   void JoinAllAndStopThreads();
 
   // Running loop for the threads.
-  void ThreadLoop();
+  void ThreadLoop(int thread_idx);
+
+  // Pops a job from the worker's deque, or steals one from another worker.
+  // Returns false if no job is available.
+  bool TryGetJob(int thread_idx, std::function<void()>* job);
 
   // Name of the pool.
   std::string name_;
@@ -71,11 +100,29 @@ class ThreadPool {
   // Number of threads.
   int num_threads_;
 
+  Options options_;
+
   // Active threads.
   std::vector<std::thread> threads_;
 
-  // Scheduled jobs.
-  Channel<std::function<void()>> jobs_;
+  // One job deque per worker.
+  std::vector<std::unique_ptr<PerThreadQueue>> queues_;
+
+  // Deque receiving the next job scheduled from outside of the pool
+  // (round-robin).
+  std::atomic<int64_t> next_queue_idx_{0};
+
+  // Number of jobs pushed and not yet popped, over all the deques.
+  std::atomic<int64_t> num_pending_jobs_{0};
+
+  // No more jobs can be scheduled. The workers stop when all the pending jobs
+  // are done.
+  std::atomic<bool> stop_{false};
+
+  // Parking of the workers when all the deques are empty.
+  std::atomic<int> num_idle_workers_{0};
+  CondVar idle_cond_var_;
+  Mutex idle_mutex_;
 };
 
 }  // namespace concurrency
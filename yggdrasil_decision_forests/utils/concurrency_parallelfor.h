@@ -0,0 +1,85 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_PARALLELFOR_H_
+#define YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_PARALLELFOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+#include "yggdrasil_decision_forests/utils/concurrency_default.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+namespace concurrency {
+
+// Applies "function" in parallel over contiguous blocks of the index range
+// [begin, end).
+//
+// The range is divided into blocks of at least "min_block_size" items
+// ("min_block_size" is the smallest amount of work worth scheduling as a
+// job). When the range is large enough, about three blocks are created per
+// worker so that workers that finish their blocks early pick up the remaining
+// ones (load balancing). "function" is called as "function(begin_idx,
+// end_idx)" once per block, possibly concurrently. The call blocks until all
+// the blocks have been processed.
+//
+// The whole range is processed synchronously in the calling thread if
+// "thread_pool" is null, if the pool has no worker, or if the range is too
+// small for more than one block. In particular, pass thread_pool=nullptr when
+// calling from within a job of the same pool: scheduling and waiting on the
+// pool that runs the caller can dead-lock if all the workers do so at the
+// same time.
+inline void ParallelFor(
+    const size_t begin, const size_t end, const size_t min_block_size,
+    ThreadPool* thread_pool,
+    const std::function<void(size_t begin_idx, size_t end_idx)>& function) {
+  const size_t num_items = end - begin;
+  const size_t num_workers =
+      (thread_pool != nullptr) ? thread_pool->num_threads() : 0;
+
+  size_t num_blocks = 1;
+  if (num_workers > 0 && min_block_size > 0) {
+    num_blocks = std::min(num_items / min_block_size, num_workers * 3);
+  }
+  if (num_blocks <= 1) {
+    if (num_items > 0) {
+      function(begin, end);
+    }
+    return;
+  }
+
+  const size_t block_size = (num_items + num_blocks - 1) / num_blocks;
+  num_blocks = (num_items + block_size - 1) / block_size;
+
+  BlockingCounter blocker(num_blocks);
+  for (size_t block_begin = begin; block_begin < end;
+       block_begin += block_size) {
+    const size_t block_end = std::min(block_begin + block_size, end);
+    thread_pool->Schedule([block_begin, block_end, &blocker, &function]() {
+      function(block_begin, block_end);
+      blocker.DecrementCount();
+    });
+  }
+  blocker.Wait();
+}
+
+}  // namespace concurrency
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_PARALLELFOR_H_
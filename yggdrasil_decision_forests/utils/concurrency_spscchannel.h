@@ -0,0 +1,258 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// A bounded single-producer single-consumer channel with the same interface
+// as "Channel" (see concurrency_channel.h) but without a mutex or an atomic
+// read-modify-write on the "Push" / "Pop" fast path. Preferred over "Channel"
+// and "LockFreeChannel" when exactly one thread pushes and exactly one thread
+// pops, e.g. a reading thread feeding a processing thread: for small items,
+// the channel synchronization otherwise dominates the per-item work.
+
+#ifndef YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_SPSCCHANNEL_H_
+#define YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_SPSCCHANNEL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+namespace concurrency {
+
+// Thread safe bounded channel for ONE producer thread and ONE consumer
+// thread. "Push" and "Pop" operate on a lock-free ring buffer: the producer
+// only writes the tail index and the consumer only writes the head index, so
+// the fast path is a plain store/load pair. Both sides keep a cached copy of
+// the other side's index and only re-read it (a cache line transfer) when the
+// cached value indicates a full (resp. empty) ring.
+//
+// "PushBatch" and "PopBatch" move several items with a single index
+// publication, amortizing the synchronization over the batch.
+//
+// "Pop" on an empty channel spins briefly and then parks on a condition
+// variable; "Push" on a full channel yields until a slot is released, so the
+// capacity should be dimensioned to make a full channel rare.
+//
+// "Input" should be default-constructible and move-assignable.
+template <typename Input>
+class SpscChannel {
+ public:
+  // "capacity" is rounded up to the next power of two.
+  explicit SpscChannel(size_t capacity = kDefaultCapacity) {
+    size_t rounded_capacity = 2;
+    while (rounded_capacity < capacity) {
+      rounded_capacity <<= 1;
+    }
+    mask_ = rounded_capacity - 1;
+    buffer_ = std::unique_ptr<Input[]>(new Input[rounded_capacity]);
+  }
+
+  // Close the channel. No new items can be push in the channel.
+  void Close() {
+    MutexLock lock(&mutex_);
+    closed_.store(true, std::memory_order_release);
+    cond_var_.SignalAll();
+  }
+
+  // Clear the content of a channel. Should be called by the consumer thread.
+  void Clear() {
+    const size_t tail = tail_.load(std::memory_order_acquire);
+    head_.store(tail, std::memory_order_release);
+  }
+
+  // Re-open a previously closed channel.
+  void Reopen() {
+    MutexLock lock(&mutex_);
+    closed_.store(false, std::memory_order_release);
+    cond_var_.SignalAll();
+  }
+
+  // Push an item in the channel. Busy-waits if the channel is full.
+  void Push(Input item) { PushBatch(&item, 1); }
+
+  // Pushes the "num_items" items of "items" with a single index publication.
+  // Busy-waits if the channel is full (publishing the items pushed so far, so
+  // batches larger than the capacity are allowed).
+  void PushBatch(Input* items, size_t num_items) {
+    if (closed_.load(std::memory_order_acquire)) {
+      LOG(ERROR) << "Ignoring value added to closed channel.";
+      return;
+    }
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    for (size_t item_idx = 0; item_idx < num_items; item_idx++) {
+      while (tail - cached_head_ > mask_) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail - cached_head_ <= mask_) {
+          break;
+        }
+        // The ring is full: publish the items pushed so far and let the
+        // consumer drain.
+        Publish(tail);
+        if (closed_.load(std::memory_order_acquire)) {
+          LOG(ERROR) << "Ignoring value added to closed channel.";
+          return;
+        }
+        std::this_thread::yield();
+      }
+      buffer_[tail & mask_] = std::move(items[item_idx]);
+      tail++;
+    }
+    Publish(tail);
+  }
+
+  // Pops a value from the channel. If the channel is closed and empty,
+  // returns {}. If the channel is empty but not closed, blocks. If the
+  // channel is not empty, returns the first added element.
+  //
+  // If "get_num_pop" is specified, the pointed value will be set the number
+  // of "Pop" results returned so far. Since there is a single consumer, the
+  // number of pops is unique, dense and in order.
+  absl::optional<Input> Pop(int64_t* get_num_pop = nullptr) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    int num_spins = 0;
+    while (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head != cached_tail_) {
+        break;
+      }
+      if (closed_.load(std::memory_order_acquire)) {
+        return {};
+      }
+      if (++num_spins < kNumSpinsBeforeParking) {
+        std::this_thread::yield();
+        continue;
+      }
+      MutexLock lock(&mutex_);
+      num_waiters_.fetch_add(1, std::memory_order_relaxed);
+      // Pairs with the fence in "Publish": either the producer sees the
+      // waiter, or the waiter sees the pushed item when re-checking before
+      // parking.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (head == tail_.load(std::memory_order_acquire) &&
+          !closed_.load(std::memory_order_acquire)) {
+        cond_var_.Wait(&mutex_, &lock);
+      }
+      num_waiters_.fetch_sub(1, std::memory_order_relaxed);
+      num_spins = 0;
+    }
+    Input value = std::move(buffer_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    if (get_num_pop) {
+      *get_num_pop = static_cast<int64_t>(head);
+    }
+    return std::move(value);
+  }
+
+  // Pops up to "max_items" immediately available items into "items" with a
+  // single index publication. Returns the number of popped items: 0 if the
+  // channel is empty (this function never blocks; use "Pop" to wait).
+  size_t PopBatch(Input* items, size_t max_items) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head == cached_tail_) {
+        return 0;
+      }
+    }
+    size_t num_items = cached_tail_ - head;
+    if (num_items > max_items) {
+      num_items = max_items;
+    }
+    for (size_t item_idx = 0; item_idx < num_items; item_idx++) {
+      items[item_idx] = std::move(buffer_[(head + item_idx) & mask_]);
+    }
+    head_.store(head + num_items, std::memory_order_release);
+    return num_items;
+  }
+
+  // Vector-based variants of "PushBatch" / "PopBatch" with the same interface
+  // as the other channels (see "Channel::PushMany" / "Channel::PopMany"), so
+  // the channel types are interchangeable in "StreamProcessor".
+  void PushMany(std::vector<Input>* items) {
+    PushBatch(items->data(), items->size());
+    items->clear();
+  }
+
+  // Like "Pop", blocks until at least one item is available or the channel
+  // is closed; the remaining items are drained without blocking. Returns the
+  // number of popped items; 0 iif the channel is closed and empty.
+  size_t PopMany(size_t max_num_items, std::vector<Input>* items) {
+    items->clear();
+    auto first = Pop();
+    if (!first.has_value()) {
+      return 0;
+    }
+    items->push_back(std::move(first).value());
+    if (items->size() < max_num_items) {
+      const size_t prev_size = items->size();
+      items->resize(max_num_items);
+      const size_t num_extra =
+          PopBatch(items->data() + prev_size, max_num_items - prev_size);
+      items->resize(prev_size + num_extra);
+    }
+    return items->size();
+  }
+
+ private:
+  static constexpr size_t kDefaultCapacity = 1024;
+  static constexpr int kNumSpinsBeforeParking = 64;
+
+  // Publishes the items up to (excluded) "tail" and wakes up the consumer if
+  // it is parked.
+  void Publish(const size_t tail) {
+    tail_.store(tail, std::memory_order_release);
+    // Pairs with the fence in "Pop" (see above).
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_waiters_.load(std::memory_order_relaxed) > 0) {
+      MutexLock lock(&mutex_);
+      cond_var_.Signal();
+    }
+  }
+
+  // Ring of "mask_ + 1" items.
+  std::unique_ptr<Input[]> buffer_;
+  size_t mask_;
+
+  // Index of the next pop and of the next push. Only written by respectively
+  // the consumer and the producer. On separate cache lines to avoid false
+  // sharing.
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+
+  // Copy of "head_" (resp. "tail_") as last seen by the producer (resp. the
+  // consumer). Only accessed by that side.
+  alignas(64) size_t cached_head_ = 0;
+  alignas(64) size_t cached_tail_ = 0;
+
+  std::atomic<bool> closed_{false};
+
+  // Parking of the consumer when the channel is empty.
+  std::atomic<int> num_waiters_{0};
+  CondVar cond_var_;
+  Mutex mutex_;
+};
+
+}  // namespace concurrency
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_UTILS_CONCURRENCY_SPSCCHANNEL_H_
@@ -19,6 +19,7 @@
 #include <memory>
 #include <queue>
 #include <string>
+#include <vector>
 
 #include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/concurrency_channel.h"
@@ -27,7 +28,15 @@ namespace yggdrasil_decision_forests {
 namespace utils {
 namespace concurrency {
 
-template <typename Input, typename Output>
+// "InputChannel" and "OutputChannel" are the channels distributing the
+// queries to the worker threads and returning the results. They default to
+// the mutex-based "Channel"; high-contention users (e.g. the splitter work
+// queue in the decision tree learner) can select "LockFreeChannel" instead,
+// and a processor with a single worker thread and a single submitting /
+// result-consuming thread can select "SpscChannel" on both sides.
+template <typename Input, typename Output,
+          typename InputChannel = Channel<Input>,
+          typename OutputChannel = Channel<Output>>
 class StreamProcessor {
  public:
   // Creates the processor. Don't start the threads yet.
@@ -57,10 +66,21 @@ class StreamProcessor {
   // Adds a new job.
   void Submit(Input input);
 
+  // Adds a batch of jobs with a single channel operation and leaves
+  // "*inputs" empty. Cheaper than one "Submit" per job when the jobs are
+  // created in batches.
+  void SubmitMany(std::vector<Input>* inputs);
+
   // Get the result of a job. Returns {} if the "JoinAllAndStopThreads" or
   // "CloseSubmits" has been called and all outputs have already been retrieved.
   absl::optional<Output> GetResult();
 
+  // Gets up to "max_num_results" job results with a single channel operation
+  // and stores them in "*outputs" (which is cleared first). Like "GetResult",
+  // blocks until at least one result is available. Returns the number of
+  // results; 0 iif no more results will be produced.
+  size_t GetResults(size_t max_num_results, std::vector<Output>* outputs);
+
   // Indicates that no more request can be submitted.
   void CloseSubmits();
 
@@ -84,8 +104,8 @@ class StreamProcessor {
   // Processing function.
   std::function<Output(Input, int)> call_;
 
-  Channel<Input> input_channel_;
-  Channel<Output> output_channel_;
+  InputChannel input_channel_;
+  OutputChannel output_channel_;
 
   // Should the results be returned in order.
   const bool result_in_order_;
@@ -99,8 +119,9 @@ class StreamProcessor {
   Mutex mutex_;
 };
 
-template <typename Input, typename Output>
-StreamProcessor<Input, Output>::StreamProcessor(
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+StreamProcessor<Input, Output, InputChannel, OutputChannel>::StreamProcessor(
     std::string name, int num_threads, std::function<Output(Input, int)> call,
     bool result_in_order)
     : num_threads_(num_threads),
@@ -108,8 +129,9 @@ StreamProcessor<Input, Output>::StreamProcessor(
       call_(std::move(call)),
       result_in_order_(result_in_order) {}
 
-template <typename Input, typename Output>
-StreamProcessor<Input, Output>::StreamProcessor(
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+StreamProcessor<Input, Output, InputChannel, OutputChannel>::StreamProcessor(
     std::string name, int num_threads, std::function<Output(Input)> call,
     bool result_in_order)
     : num_threads_(num_threads),
@@ -118,13 +140,17 @@ StreamProcessor<Input, Output>::StreamProcessor(
   call_ = [call](Input input, int) -> Output { return call(std::move(input)); };
 }
 
-template <typename Input, typename Output>
-StreamProcessor<Input, Output>::~StreamProcessor() {
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+StreamProcessor<Input, Output, InputChannel,
+                OutputChannel>::~StreamProcessor() {
   JoinAllAndStopThreads();
 }
 
-template <typename Input, typename Output>
-void StreamProcessor<Input, Output>::StartWorkers() {
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+void StreamProcessor<Input, Output, InputChannel,
+                     OutputChannel>::StartWorkers() {
   {
     MutexLock results_lock(&mutex_);
     num_active_threads_ = num_threads_;
@@ -136,13 +162,17 @@ void StreamProcessor<Input, Output>::StartWorkers() {
   }
 }
 
-template <typename Input, typename Output>
-void StreamProcessor<Input, Output>::CloseSubmits() {
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+void StreamProcessor<Input, Output, InputChannel,
+                     OutputChannel>::CloseSubmits() {
   input_channel_.Close();
 }
 
-template <typename Input, typename Output>
-void StreamProcessor<Input, Output>::JoinAllAndStopThreads() {
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+void StreamProcessor<Input, Output, InputChannel,
+                     OutputChannel>::JoinAllAndStopThreads() {
   CloseSubmits();
   for (auto& thread : threads_) {
     thread.Join();
@@ -151,8 +181,10 @@ void StreamProcessor<Input, Output>::JoinAllAndStopThreads() {
   threads_.clear();
 }
 
-template <typename Input, typename Output>
-void StreamProcessor<Input, Output>::ThreadLoop(const int thread_idx) {
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+void StreamProcessor<Input, Output, InputChannel, OutputChannel>::ThreadLoop(
+    const int thread_idx) {
   while (true) {
     int64_t query_id;
     auto optional_input = input_channel_.Pop(&query_id);
@@ -188,16 +220,34 @@ void StreamProcessor<Input, Output>::ThreadLoop(const int thread_idx) {
   }
 }
 
-template <typename Input, typename Output>
-void StreamProcessor<Input, Output>::Submit(Input input) {
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+void StreamProcessor<Input, Output, InputChannel, OutputChannel>::Submit(
+    Input input) {
   input_channel_.Push(std::move(input));
 }
 
-template <typename Input, typename Output>
-absl::optional<Output> StreamProcessor<Input, Output>::GetResult() {
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+void StreamProcessor<Input, Output, InputChannel, OutputChannel>::SubmitMany(
+    std::vector<Input>* inputs) {
+  input_channel_.PushMany(inputs);
+}
+
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+absl::optional<Output>
+StreamProcessor<Input, Output, InputChannel, OutputChannel>::GetResult() {
   return output_channel_.Pop();
 }
 
+template <typename Input, typename Output, typename InputChannel,
+          typename OutputChannel>
+size_t StreamProcessor<Input, Output, InputChannel, OutputChannel>::GetResults(
+    const size_t max_num_results, std::vector<Output>* outputs) {
+  return output_channel_.PopMany(max_num_results, outputs);
+}
+
 }  // namespace concurrency
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
@@ -13,6 +13,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -40,6 +42,40 @@ TEST(ThreadPool, Simple) {
   EXPECT_EQ(counter, n * (n + 1) / 2);
 }
 
+TEST(ThreadPool, NestedSchedule) {
+  std::atomic<int> counter = {0};
+  {
+    ThreadPool pool("MyPool", 4);
+    pool.StartWorkers();
+    for (int i = 0; i < 100; i++) {
+      // The nested job is pushed on the deque of the worker running the
+      // outer job.
+      pool.Schedule([&]() {
+        counter++;
+        pool.Schedule([&]() { counter++; });
+      });
+    }
+    while (counter < 200) {
+      std::this_thread::yield();
+    }
+  }
+  EXPECT_EQ(counter, 200);
+}
+
+TEST(ThreadPool, PinnedThreads) {
+  std::atomic<int> counter = {0};
+  {
+    ThreadPool::Options options;
+    options.pin_threads_to_cores = true;
+    ThreadPool pool("MyPool", 4, options);
+    pool.StartWorkers();
+    for (int i = 0; i < 100; i++) {
+      pool.Schedule([&]() { counter++; });
+    }
+  }
+  EXPECT_EQ(counter, 100);
+}
+
 TEST(StreamProcessor, Simple) {
   const int num_jobs = 1000;
   const int num_initially_planned_jobs = 10;
@@ -112,6 +148,178 @@ TEST(StreamProcessor, InOrder) {
   }
 }
 
+TEST(LockFreeChannel, Simple) {
+  LockFreeChannel<int> channel;
+  channel.Push(1);
+  channel.Push(2);
+  int64_t num_pop;
+  EXPECT_EQ(channel.Pop(&num_pop).value(), 1);
+  EXPECT_EQ(num_pop, 0);
+  EXPECT_EQ(channel.Pop(&num_pop).value(), 2);
+  EXPECT_EQ(num_pop, 1);
+  channel.Close();
+  EXPECT_FALSE(channel.Pop().has_value());
+}
+
+TEST(Channel, PushManyPopMany) {
+  Channel<int> channel;
+  std::vector<int> items = {1, 2, 3};
+  channel.PushMany(&items);
+  EXPECT_TRUE(items.empty());
+  channel.Push(4);
+  EXPECT_EQ(channel.PopMany(3, &items), 3);
+  EXPECT_EQ(items, std::vector<int>({1, 2, 3}));
+  channel.Close();
+  EXPECT_EQ(channel.PopMany(3, &items), 1);
+  EXPECT_EQ(items, std::vector<int>({4}));
+  EXPECT_EQ(channel.PopMany(3, &items), 0);
+}
+
+TEST(LockFreeChannel, PushManyPopMany) {
+  LockFreeChannel<int> channel;
+  std::vector<int> items = {1, 2, 3};
+  channel.PushMany(&items);
+  EXPECT_TRUE(items.empty());
+  channel.Push(4);
+  EXPECT_EQ(channel.PopMany(3, &items), 3);
+  EXPECT_EQ(items, std::vector<int>({1, 2, 3}));
+  channel.Close();
+  EXPECT_EQ(channel.PopMany(3, &items), 1);
+  EXPECT_EQ(items, std::vector<int>({4}));
+  EXPECT_EQ(channel.PopMany(3, &items), 0);
+}
+
+TEST(LockFreeChannel, MultiProducerMultiConsumer) {
+  const int num_producers = 4;
+  const int num_consumers = 4;
+  const int num_items_per_producer = 10000;
+
+  // Small capacity to exercise the full-channel path.
+  LockFreeChannel<int> channel(/*capacity=*/16);
+  std::atomic<int64_t> sum = {0};
+  std::atomic<int> num_items = {0};
+
+  std::vector<Thread> threads;
+  for (int producer_idx = 0; producer_idx < num_producers; producer_idx++) {
+    threads.emplace_back([&, producer_idx]() {
+      for (int i = 0; i < num_items_per_producer; i++) {
+        channel.Push(producer_idx * num_items_per_producer + i);
+      }
+    });
+  }
+  for (int consumer_idx = 0; consumer_idx < num_consumers; consumer_idx++) {
+    threads.emplace_back([&]() {
+      while (true) {
+        auto value = channel.Pop();
+        if (!value.has_value()) {
+          break;
+        }
+        sum += value.value();
+        num_items++;
+      }
+    });
+  }
+  for (int producer_idx = 0; producer_idx < num_producers; producer_idx++) {
+    threads[producer_idx].Join();
+  }
+  channel.Close();
+  for (int consumer_idx = 0; consumer_idx < num_consumers; consumer_idx++) {
+    threads[num_producers + consumer_idx].Join();
+  }
+
+  const int64_t total = num_producers * num_items_per_producer;
+  EXPECT_EQ(num_items, total);
+  EXPECT_EQ(sum, (total - 1) * total / 2);
+}
+
+TEST(SpscChannel, Simple) {
+  SpscChannel<int> channel;
+  channel.Push(1);
+  channel.Push(2);
+  int64_t num_pop;
+  EXPECT_EQ(channel.Pop(&num_pop).value(), 1);
+  EXPECT_EQ(num_pop, 0);
+  EXPECT_EQ(channel.Pop(&num_pop).value(), 2);
+  EXPECT_EQ(num_pop, 1);
+  channel.Close();
+  EXPECT_FALSE(channel.Pop().has_value());
+}
+
+TEST(SpscChannel, SingleProducerSingleConsumer) {
+  const int num_items = 100000;
+
+  // Small capacity to exercise the full-channel path, and batches larger
+  // than the capacity.
+  SpscChannel<int> channel(/*capacity=*/16);
+  Thread producer([&]() {
+    int next_value = 0;
+    int batch[40];
+    while (next_value < num_items) {
+      if (next_value % 3 == 0) {
+        const int batch_size = std::min(40, num_items - next_value);
+        for (int i = 0; i < batch_size; i++) {
+          batch[i] = next_value + i;
+        }
+        channel.PushBatch(batch, batch_size);
+        next_value += batch_size;
+      } else {
+        channel.Push(next_value++);
+      }
+    }
+    channel.Close();
+  });
+
+  int expected_value = 0;
+  int batch[32];
+  while (true) {
+    const size_t batch_size = channel.PopBatch(batch, 32);
+    if (batch_size > 0) {
+      for (size_t i = 0; i < batch_size; i++) {
+        EXPECT_EQ(batch[i], expected_value++);
+      }
+      continue;
+    }
+    // The channel is momentarily empty: block on a unit pop.
+    auto value = channel.Pop();
+    if (!value.has_value()) {
+      break;
+    }
+    EXPECT_EQ(value.value(), expected_value++);
+  }
+  EXPECT_EQ(expected_value, num_items);
+  producer.Join();
+}
+
+TEST(StreamProcessor, SpscChannels) {
+  StreamProcessor<int, int, SpscChannel<int>, SpscChannel<int>> processor(
+      "MyPipe", /*num_threads=*/1, [](int x) { return x; });
+
+  processor.StartWorkers();
+  for (int i = 0; i < 100; i++) {
+    processor.Submit(i);
+  }
+  processor.CloseSubmits();
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(processor.GetResult().value(), i);
+  }
+  CHECK(!processor.GetResult().has_value());
+}
+
+TEST(StreamProcessor, LockFreeInputChannel) {
+  StreamProcessor<int, int, LockFreeChannel<int>> processor(
+      "MyPipe", 5, [](int x) { return x; }, /*result_in_order=*/true);
+
+  processor.StartWorkers();
+  for (int i = 0; i < 100; i++) {
+    processor.Submit(i);
+  }
+  processor.CloseSubmits();
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(processor.GetResult().value(), i);
+  }
+  CHECK(!processor.GetResult().has_value());
+}
+
 TEST(StreamProcessor, EarlyClose) {
   StreamProcessor<int, int> processor(
       "MyPipe", 5, [](int x) { return x; }, /*result_in_order=*/true);
@@ -130,6 +338,42 @@ TEST(StreamProcessor, EarlyClose) {
   processor.JoinAllAndStopThreads();
 }
 
+TEST(ParallelFor, Simple) {
+  const size_t n = 10000;
+  std::vector<int> items(n, 0);
+  {
+    ThreadPool pool("MyPool", 4);
+    pool.StartWorkers();
+    ParallelFor(0, n, /*min_block_size=*/100, &pool,
+                [&items](size_t begin_idx, size_t end_idx) {
+                  for (size_t i = begin_idx; i < end_idx; i++) {
+                    items[i]++;
+                  }
+                });
+  }
+  EXPECT_EQ(std::count(items.begin(), items.end(), 1), n);
+}
+
+TEST(ParallelFor, InlineWithNullPool) {
+  // A null pool, or a range smaller than two blocks, is processed inline in
+  // the calling thread.
+  std::vector<int> items(10, 0);
+  ParallelFor(0, items.size(), /*min_block_size=*/100, nullptr,
+              [&items](size_t begin_idx, size_t end_idx) {
+                for (size_t i = begin_idx; i < end_idx; i++) {
+                  items[i]++;
+                }
+              });
+  EXPECT_EQ(std::count(items.begin(), items.end(), 1), items.size());
+}
+
+TEST(ParallelFor, EmptyRange) {
+  int num_calls = 0;
+  ParallelFor(5, 5, /*min_block_size=*/1, nullptr,
+              [&num_calls](size_t begin_idx, size_t end_idx) { num_calls++; });
+  EXPECT_EQ(num_calls, 0);
+}
+
 }  // namespace
 }  // namespace concurrency
 }  // namespace utils
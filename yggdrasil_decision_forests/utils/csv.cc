@@ -17,7 +17,6 @@
 
 #include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
-#include "absl/strings/str_replace.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
@@ -53,6 +52,47 @@ bool NeedsEscape(absl::string_view field) {
   return false;
 }
 
+// Size of the raw chunks sent to the parsing threads of a "ParallelReader".
+constexpr size_t kParallelChunkSize = 1 << 20;  // 1MB
+
+// Maximum number of chunks in flight, per parsing thread, in a
+// "ParallelReader".
+constexpr int kParallelChunksPerThread = 2;
+
+// Index just after the last new line character ('\n') of "data" that is not
+// contained in a quoted field, or -1 if there is none. Only scans from
+// "begin". "in_quotes" is the quoted-field state at "begin", and is updated to
+// the state at the end of "data".
+//
+// Double quotes are simply counted: an escaped quote ("") toggles the state
+// twice, leaving the state at the following characters unchanged. The scan
+// jumps from quote to quote with "find" (i.e. memchr) instead of looking at
+// individual characters.
+int64_t LastRowBoundary(const absl::string_view data, const size_t begin,
+                        bool* in_quotes) {
+  int64_t boundary = -1;
+  size_t pos = begin;
+  while (pos < data.size()) {
+    const size_t quote = data.find('"', pos);
+    if (!*in_quotes) {
+      const size_t region_end =
+          (quote == absl::string_view::npos) ? data.size() : quote;
+      if (region_end > pos) {
+        const size_t newline = data.rfind('\n', region_end - 1);
+        if (newline != absl::string_view::npos && newline >= pos) {
+          boundary = newline + 1;
+        }
+      }
+    }
+    if (quote == absl::string_view::npos) {
+      break;
+    }
+    *in_quotes = !*in_quotes;
+    pos = quote + 1;
+  }
+  return boundary;
+}
+
 }  // namespace
 
 Reader::Reader(InputByteStream* stream) : stream_(stream) {}
@@ -213,7 +253,140 @@ void Reader::FinalizeRowCache() {
   }
 }
 
-Writer::Writer(OutputByteStream* stream, NewLine newline) : stream_(stream) {
+ParallelReader::ParallelReader(InputByteStream* stream, int num_threads)
+    : stream_(stream),
+      num_threads_(num_threads),
+      processor_("CSVParallelReader", num_threads, ParseChunk,
+                 /*result_in_order=*/true) {
+  processor_.StartWorkers();
+}
+
+utils::StatusOr<ParallelReader::ParsedChunk> ParallelReader::ParseChunk(
+    std::string chunk) {
+  // Note: Since the chunks start and stop at row boundaries, the sequential
+  // reader can be used as is on each chunk. The reported line numbers, in case
+  // of invalid files, are relative to the chunk.
+  ParsedChunk parsed;
+  StringInputByteStream stream(std::move(chunk));
+  Reader reader(&stream);
+  std::vector<absl::string_view>* row;
+  while (true) {
+    ASSIGN_OR_RETURN(const bool has_row, reader.NextRow(&row));
+    if (!has_row) {
+      break;
+    }
+    for (const auto& field : *row) {
+      parsed.characters.append(field.data(), field.size());
+      parsed.field_ends.push_back(parsed.characters.size());
+    }
+    parsed.row_ends.push_back(parsed.field_ends.size());
+  }
+  return parsed;
+}
+
+utils::StatusOr<std::string> ParallelReader::ReadChunk() {
+  std::string chunk = std::move(carry_);
+  carry_.clear();
+  bool in_quotes = false;
+  size_t num_scanned = 0;
+  while (true) {
+    const size_t old_size = chunk.size();
+    chunk.resize(old_size + kParallelChunkSize);
+    ASSIGN_OR_RETURN(const int num_read,
+                     stream_->ReadUpTo(&chunk[old_size], kParallelChunkSize));
+    chunk.resize(old_size + num_read);
+    if (num_read == 0) {
+      // The last rows of the stream. A stream ending inside a quoted field is
+      // reported by the parsing state machine.
+      end_of_stream_ = true;
+      return chunk;
+    }
+    const int64_t boundary = LastRowBoundary(chunk, num_scanned, &in_quotes);
+    num_scanned = chunk.size();
+    if (boundary >= 0) {
+      carry_ = chunk.substr(boundary);
+      chunk.resize(boundary);
+      return chunk;
+    }
+    // No row boundary found so far (e.g. a field larger than the chunk size,
+    // or a file with Mac new lines only): keep growing the chunk.
+  }
+}
+
+absl::Status ParallelReader::FillPipeline() {
+  while (!end_of_stream_ &&
+         num_pending_chunks_ < kParallelChunksPerThread * num_threads_) {
+    ASSIGN_OR_RETURN(std::string chunk, ReadChunk());
+    if (chunk.empty()) {
+      continue;
+    }
+    processor_.Submit(std::move(chunk));
+    num_pending_chunks_++;
+  }
+  return absl::OkStatus();
+}
+
+utils::StatusOr<bool> ParallelReader::NextRow(
+    std::vector<absl::string_view>** fields) {
+  *fields = &cached_fields_;
+  cached_fields_.clear();
+
+  while (current_row_ >= current_chunk_.row_ends.size()) {
+    RETURN_IF_ERROR(FillPipeline());
+    if (num_pending_chunks_ == 0) {
+      // All the rows have been returned.
+      return false;
+    }
+    auto result = processor_.GetResult();
+    num_pending_chunks_--;
+    if (!result.has_value()) {
+      return absl::InternalError("Missing parsed CSV chunk");
+    }
+    ASSIGN_OR_RETURN(current_chunk_, std::move(result.value()));
+    current_row_ = 0;
+  }
+
+  const size_t begin_field =
+      (current_row_ == 0) ? 0 : current_chunk_.row_ends[current_row_ - 1];
+  const size_t end_field = current_chunk_.row_ends[current_row_];
+  cached_fields_.reserve(end_field - begin_field);
+  for (size_t field_idx = begin_field; field_idx < end_field; field_idx++) {
+    const size_t begin_char =
+        (field_idx == 0) ? 0 : current_chunk_.field_ends[field_idx - 1];
+    cached_fields_.push_back(
+        absl::string_view(current_chunk_.characters.data() + begin_char,
+                          current_chunk_.field_ends[field_idx] - begin_char));
+  }
+  current_row_++;
+  return true;
+}
+
+void AppendRow(const std::vector<absl::string_view>& fields,
+               const absl::string_view newline, std::string* dst) {
+  for (size_t field_idx = 0; field_idx < fields.size(); field_idx++) {
+    const auto& field = fields[field_idx];
+    if (field_idx > 0) {
+      dst->push_back(',');
+    }
+    if (NeedsEscape(field)) {
+      dst->push_back('"');
+      for (const char c : field) {
+        if (c == '"') {
+          dst->push_back('"');
+        }
+        dst->push_back(c);
+      }
+      dst->push_back('"');
+    } else {
+      dst->append(field.data(), field.size());
+    }
+  }
+  dst->append(newline.data(), newline.size());
+}
+
+Writer::Writer(OutputByteStream* stream, NewLine newline,
+               const int64_t buffer_size)
+    : stream_(stream), buffer_size_(buffer_size) {
   switch (newline) {
     case NewLine::UNIX:
       newline_ = "\n";
@@ -224,22 +397,22 @@ Writer::Writer(OutputByteStream* stream, NewLine newline) : stream_(stream) {
   }
 }
 
+Writer::~Writer() { CHECK_OK(Flush()); }
+
 absl::Status Writer::WriteRow(const std::vector<absl::string_view>& fields) {
-  for (int field_idx = 0; field_idx < fields.size(); field_idx++) {
-    const auto& field = fields[field_idx];
-    if (field_idx > 0) {
-      RETURN_IF_ERROR(stream_->Write(","));
-    }
-    if (NeedsEscape(field)) {
-      RETURN_IF_ERROR(stream_->Write("\""));
-      RETURN_IF_ERROR(
-          stream_->Write(absl::StrReplaceAll(field, {{"\"", "\"\""}})));
-      RETURN_IF_ERROR(stream_->Write("\""));
-    } else {
-      RETURN_IF_ERROR(stream_->Write(field));
-    }
+  AppendRow(fields, newline_, &buffer_);
+  if (static_cast<int64_t>(buffer_.size()) >= buffer_size_) {
+    return Flush();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status Writer::Flush() {
+  if (buffer_.empty()) {
+    return absl::OkStatus();
   }
-  RETURN_IF_ERROR(stream_->Write(newline_));
+  RETURN_IF_ERROR(stream_->Write(buffer_));
+  buffer_.clear();
   return absl::OkStatus();
 }
 
@@ -44,10 +44,14 @@
 #ifndef THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_CSV_H_
 #define THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_CSV_H_
 
+#include <stdint.h>
+
+#include <string>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "yggdrasil_decision_forests/utils/bytestream.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 
 namespace yggdrasil_decision_forests {
 namespace utils {
@@ -128,6 +132,82 @@ class Reader {
   int num_rows = 0;
 };
 
+// Multi-threaded CSV reader with the same interface and behavior as "Reader".
+//
+// The stream is read in large chunks cut at row boundaries (new lines outside
+// of quoted fields, located with a quote-parity scan), and the chunks are
+// parsed in parallel by a small pool of threads. Rows are returned in file
+// order.
+//
+// Use this reader to ingest large files. Prefer "Reader" to read a few rows or
+// when creating threads is not acceptable.
+class ParallelReader {
+ public:
+  // Creates a multi-threaded CSV reader and starts the parsing threads.
+  // Does not take ownership of the stream. If "stream" is a file, it is up to
+  // the caller to close it (after this object is deleted).
+  ParallelReader(InputByteStream* stream, int num_threads = 8);
+
+  // Reads the next row. Same semantic as "Reader::NextRow".
+  utils::StatusOr<bool> NextRow(std::vector<absl::string_view>** fields);
+
+ private:
+  // A chunk of rows parsed by one of the worker threads.
+  struct ParsedChunk {
+    // Unescaped field characters, concatenated.
+    std::string characters;
+
+    // End index, in "characters", of each field.
+    std::vector<size_t> field_ends;
+
+    // End index, in "field_ends", of each row.
+    std::vector<size_t> row_ends;
+  };
+
+  // Parses a chunk of complete rows. Runs in the worker threads.
+  static utils::StatusOr<ParsedChunk> ParseChunk(std::string chunk);
+
+  // Reads the next chunk of raw bytes, ending at a row boundary (or at the end
+  // of the stream). The returned chunk is empty iif. the stream is exhausted.
+  utils::StatusOr<std::string> ReadChunk();
+
+  // Reads and submits raw chunks until enough chunks are in flight or the
+  // stream is exhausted.
+  absl::Status FillPipeline();
+
+  // Non-owned input stream. Only accessed by the calling thread.
+  InputByteStream* stream_;
+
+  // Number of parsing threads.
+  const int num_threads_;
+
+  // Bytes read past the row boundary of the last submitted chunk.
+  std::string carry_;
+
+  // True when "stream_" is exhausted.
+  bool end_of_stream_ = false;
+
+  // Number of submitted chunks whose result was not yet retrieved.
+  int num_pending_chunks_ = 0;
+
+  // Chunk currently returned to the user, and the next row to return in it.
+  ParsedChunk current_chunk_;
+  size_t current_row_ = 0;
+
+  // Fields of the last read row. Points to "current_chunk_". Returned by the
+  // public "NextRow" function.
+  std::vector<absl::string_view> cached_fields_;
+
+  // Parsing threads. Returns the parsed chunks in submission order.
+  concurrency::StreamProcessor<std::string, utils::StatusOr<ParsedChunk>>
+      processor_;
+};
+
+// Appends a row to "dst", with the field escaping described in "Writer" and
+// a terminating new line.
+void AppendRow(const std::vector<absl::string_view>& fields,
+               absl::string_view newline, std::string* dst);
+
 class Writer {
  public:
   // CSV writer constructor.
@@ -138,7 +218,16 @@ class Writer {
   // Fields are printed without escaping unless necessary: fields
   // containing comma (','), new-lines symbols ('\n' or '\r') or double-quotes
   // ('"').
-  Writer(OutputByteStream* stream, NewLine newline = NewLine::UNIX);
+  //
+  // Each row is formatted in a memory buffer and written to the stream in a
+  // single "Write" call. If "buffer_size" is greater than zero, the rows are
+  // instead accumulated and written in blocks of approximately "buffer_size"
+  // bytes: "Flush" should then be called before closing the stream (the
+  // destructor flushes the remaining rows and CHECKs the status).
+  Writer(OutputByteStream* stream, NewLine newline = NewLine::UNIX,
+         int64_t buffer_size = 0);
+
+  ~Writer();
 
   // Writes a row of data.
   absl::Status WriteRow(const std::vector<absl::string_view>& fields);
@@ -146,12 +235,21 @@ class Writer {
   // Helper. Use "WriteRow" when possible.
   absl::Status WriteRowStrings(const std::vector<std::string>& fields);
 
+  // Writes the buffered rows (if any) to the stream.
+  absl::Status Flush();
+
  private:
   // Non-owned input stream.
   OutputByteStream* stream_;
 
   // Character(s) representing a new line.
   std::string newline_;
+
+  // Size, in bytes, above which "buffer_" is written to the stream.
+  const int64_t buffer_size_;
+
+  // Formatted rows not yet written to the stream.
+  std::string buffer_;
 };
 
 }  // namespace csv
@@ -17,6 +17,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 
@@ -172,6 +173,100 @@ TEST(Csv, EOFHalfQuote) {
   EXPECT_FALSE(reader.NextRow(&row).ok());
 }
 
+TEST(Csv, ParallelReadToy) {
+  auto file_handle =
+      file::OpenInputFile(file::JoinPath(DatasetDir(), "toy.csv")).value();
+  ParallelReader reader(file_handle.get());
+  std::vector<absl::string_view>* row;
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row, ElementsAre("Num_1", "Num_2", "Cat_1", "Cat_2", "Cat_set_1",
+                                "Cat_set_2", "Bool_1", "Bool_2", "Cat_3"));
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row, ElementsAre("1", "NA", "A", "A", "X", "", "0", "0", "1"));
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row, ElementsAre("2", "2", "B", "", "X Y", "X", "1", "NA", "2"));
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row,
+              ElementsAre("3", "NA", "A", "B", "Y X Z", "X Y", "0", "1", "1"));
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row,
+              ElementsAre("4", "4", "C", "", "X Y Z", "Z X Y", "1", "NA", "3"));
+
+  EXPECT_FALSE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row, ElementsAre());
+  EXPECT_OK(file_handle->Close());
+}
+
+TEST(Csv, ParallelReaderQuotes) {
+  StringInputByteStream stream(R"(a,b
+"c","d"
+"",""
+"""",""""
+"a""b",",c
+d")");
+  ParallelReader reader(&stream);
+  std::vector<absl::string_view>* row;
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row, ElementsAre("a", "b"));
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row, ElementsAre("c", "d"));
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row, ElementsAre("", ""));
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row, ElementsAre("\"", "\""));
+
+  EXPECT_TRUE(reader.NextRow(&row).value());
+  EXPECT_THAT(*row, ElementsAre("a\"b", ",c\nd"));
+
+  EXPECT_FALSE(reader.NextRow(&row).value());
+}
+
+TEST(Csv, ParallelReaderEOFOpenQuote) {
+  StringInputByteStream stream(R"(a,"b
+c,d
+)");
+  ParallelReader reader(&stream);
+  std::vector<absl::string_view>* row;
+  EXPECT_FALSE(reader.NextRow(&row).ok());
+}
+
+// Checks that the parallel reader returns the same rows, in the same order, as
+// the sequential reader on a file spanning multiple chunks and containing
+// quoted new lines and quotes close to the chunk boundaries.
+TEST(Csv, ParallelReaderMultipleChunks) {
+  std::string content = "f_1,f_2,f_3\n";
+  for (int row_idx = 0; row_idx < 100000; row_idx++) {
+    absl::StrAppend(&content, row_idx, ",\"a\nb\"\"c\",v", row_idx, "\n");
+  }
+
+  StringInputByteStream sequential_stream(content);
+  Reader sequential_reader(&sequential_stream);
+  StringInputByteStream parallel_stream(content);
+  ParallelReader parallel_reader(&parallel_stream);
+
+  std::vector<absl::string_view>*sequential_row, *parallel_row;
+  while (true) {
+    const bool sequential_has_row =
+        sequential_reader.NextRow(&sequential_row).value();
+    const bool parallel_has_row =
+        parallel_reader.NextRow(&parallel_row).value();
+    EXPECT_EQ(sequential_has_row, parallel_has_row);
+    if (!sequential_has_row) {
+      break;
+    }
+    EXPECT_EQ(*sequential_row, *parallel_row);
+  }
+}
+
 TEST(Csv, WriterWindows) {
   const auto file_path = file::JoinPath(test::TmpDirectory(), "my_file.csv");
   auto output_handle = file::OpenOutputFile(file_path).value();
@@ -256,6 +351,31 @@ TEST(Csv, WriterUnix) {
   EXPECT_OK(input_handle->Close());
 }
 
+TEST(Csv, WriterBuffered) {
+  const auto file_path = file::JoinPath(test::TmpDirectory(), "my_file.csv");
+  auto output_handle = file::OpenOutputFile(file_path).value();
+  {
+    Writer writer(output_handle.get(), NewLine::UNIX, /*buffer_size=*/1024);
+    for (int row_idx = 0; row_idx < 1000; row_idx++) {
+      EXPECT_OK(writer.WriteRow({"abc", absl::StrCat(row_idx)}));
+    }
+    EXPECT_OK(writer.Flush());
+  }
+  EXPECT_OK(output_handle->Close());
+
+  auto input_handle = file::OpenInputFile(file_path).value();
+  Reader reader(input_handle.get());
+  std::vector<absl::string_view>* row;
+  int row_idx = 0;
+  while (reader.NextRow(&row).value()) {
+    EXPECT_EQ((*row)[0], "abc");
+    EXPECT_EQ((*row)[1], absl::StrCat(row_idx));
+    row_idx++;
+  }
+  EXPECT_EQ(row_idx, 1000);
+  EXPECT_OK(input_handle->Close());
+}
+
 }  // namespace
 }  // namespace csv
 }  // namespace utils
@@ -15,6 +15,9 @@
 
 #include "yggdrasil_decision_forests/utils/distribute/core.h"
 
+#include "absl/memory/memory.h"
+#include "yggdrasil_decision_forests/utils/hash.h"
+
 namespace yggdrasil_decision_forests {
 namespace distribute {
 
@@ -47,6 +50,51 @@ utils::StatusOr<Blob> AbstractWorker::NextAsynchronousAnswerFromOtherWorker() {
   return hook_->NextAsynchronousAnswerFromOtherWorker(this);
 }
 
+void AbstractWorker::EnableAnswerCaching(const size_t max_size_bytes) {
+  answer_cache_ = absl::make_unique<AnswerCache>();
+  answer_cache_->max_size_bytes = max_size_bytes;
+}
+
+utils::StatusOr<Blob> AbstractWorker::RunRequestMaybeCached(Blob blob) {
+  if (!answer_cache_) {
+    return RunRequest(std::move(blob));
+  }
+  auto& cache = *answer_cache_;
+  const uint64_t digest = utils::hash::HashStringViewToUint64(blob);
+
+  {
+    utils::concurrency::MutexLock lock(&cache.mutex);
+    const auto it = cache.index.find(digest);
+    if (it != cache.index.end()) {
+      // The answer was already computed e.g. the manager re-emitted the
+      // request after a transient failure.
+      cache.entries.splice(cache.entries.begin(), cache.entries, it->second);
+      return it->second->answer;
+    }
+  }
+
+  ASSIGN_OR_RETURN(auto answer, RunRequest(std::move(blob)));
+
+  {
+    utils::concurrency::MutexLock lock(&cache.mutex);
+    // The same request might have been computed concurrently.
+    if (cache.index.find(digest) == cache.index.end()) {
+      cache.size_bytes += answer.size();
+      cache.entries.push_front({digest, answer});
+      cache.index[digest] = cache.entries.begin();
+      // Evict the least recently used answers. The most recent answer is
+      // always kept, even if larger than the cache.
+      while (cache.size_bytes > cache.max_size_bytes &&
+             cache.entries.size() > 1) {
+        cache.size_bytes -= cache.entries.back().answer.size();
+        cache.index.erase(cache.entries.back().digest);
+        cache.entries.pop_back();
+      }
+    }
+  }
+  return answer;
+}
+
 absl::Status AbstractWorkerHook::AsynchronousRequestToOtherWorker(
     Blob blob, int target_worker_idx, AbstractWorker* emitter_worker) {
   return absl::InternalError(
@@ -16,14 +16,19 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_UTILS_DISTRIBUTE_CORE_H_
 #define YGGDRASIL_DECISION_FORESTS_UTILS_DISTRIBUTE_CORE_H_
 
+#include <list>
+#include <memory>
 #include <string>
 
+#include "src/google/protobuf/message.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/status.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
 #include "yggdrasil_decision_forests/utils/distribute/distribute.pb.h"
 #include "yggdrasil_decision_forests/utils/protobuf.h"
 #include "yggdrasil_decision_forests/utils/registration.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 namespace yggdrasil_decision_forests {
 namespace distribute {
@@ -58,6 +63,35 @@ class AbstractWorker {
   // "RunRequest" implementation to handle thread safety.
   virtual utils::StatusOr<Blob> RunRequest(Blob blob) = 0;
 
+  // Typed version of "RunRequest": the request and the answer are exchanged
+  // as protos instead of serialized blobs. Only called by in-process
+  // distribution implementations (e.g. multi-thread) for requests emitted
+  // with "BlockingProtoRequest". The default implementation returns an
+  // UnimplementedError, in which case the caller falls back on "RunRequest"
+  // with a serialized request. Workers exchanging large messages with an
+  // in-process manager can override this method (in addition to "RunRequest")
+  // to skip the proto serialization+parsing round trip.
+  virtual utils::StatusOr<std::unique_ptr<google::protobuf::Message>>
+  RunTypedRequest(const google::protobuf::Message& request) {
+    return absl::UnimplementedError("Typed requests not implemented");
+  }
+
+  // Enables the memoization of the answers computed by
+  // "RunRequestMaybeCached". Answers are indexed by a digest of the request
+  // and evicted in least-recently-used order when the sum of the answer sizes
+  // exceeds "max_size_bytes". Caching is disabled by default. A worker
+  // implementation whose requests are deterministic and side-effect free can
+  // call this method (e.g. in "Setup") so that requests re-emitted by the
+  // manager (e.g. after a transient communication failure or a rescheduling)
+  // are answered without being re-computed.
+  void EnableAnswerCaching(size_t max_size_bytes);
+
+  // Runs a request through the answer cache (see "EnableAnswerCaching").
+  // Equivalent to "RunRequest" if caching is disabled. Failing requests are
+  // not cached. Called by the distribution implementations instead of
+  // "RunRequest".
+  utils::StatusOr<Blob> RunRequestMaybeCached(Blob blob);
+
   // Index of the worker.
   int WorkerIdx() const { return worker_idx_; }
 
@@ -89,9 +123,30 @@ class AbstractWorker {
   absl::Status InternalInitialize(int worker_idx, int num_workers,
                                   AbstractWorkerHook* worker_implementation);
 
+  // Answer cache of "RunRequestMaybeCached". Only allocated if
+  // "EnableAnswerCaching" was called. See "EnableAnswerCaching".
+  struct AnswerCache {
+    struct Entry {
+      uint64_t digest;
+      Blob answer;
+    };
+
+    utils::concurrency::Mutex mutex;
+    size_t max_size_bytes;
+    // Sum of the answer sizes currently in the cache.
+    size_t size_bytes GUARDED_BY(mutex) = 0;
+    // Cached answers, most recently used first.
+    std::list<Entry> entries GUARDED_BY(mutex);
+    // Index of the cached answers by request digest.
+    absl::flat_hash_map<uint64_t, std::list<Entry>::iterator> index
+        GUARDED_BY(mutex);
+  };
+
   int worker_idx_ = -1;
   int num_workers_ = -1;
 
+  std::unique_ptr<AnswerCache> answer_cache_;
+
   // Non owning implementation pointer.
   AbstractWorkerHook* hook_ = &default_hook_;
   static AbstractWorkerHook default_hook_;
@@ -137,10 +192,26 @@ class AbstractManager {
                                                 int worker_idx = -1) = 0;
 
   // Same as "BlockingRequest", but serialize the blob from a proto.
+  //
+  // If the implementation and the worker support it (see
+  // "BlockingTypedRequest"), the protos are exchanged directly, without
+  // serialization.
   template <typename Result, typename Request>
   utils::StatusOr<Result> BlockingProtoRequest(Request request,
                                                int worker_idx = -1);
 
+  // Same as "BlockingRequest", but exchanges the request and the answer as
+  // protos instead of serialized blobs. Only supported when the manager and
+  // the workers run in the same address space (e.g. the multi-thread
+  // implementation) and the worker implements "RunTypedRequest". Returns an
+  // UnimplementedError otherwise. Remote implementations (e.g. gRPC) keep
+  // serializing the messages.
+  virtual utils::StatusOr<std::unique_ptr<google::protobuf::Message>>
+  BlockingTypedRequest(const google::protobuf::Message& request,
+                       int worker_idx = -1) {
+    return absl::UnimplementedError("Typed requests not implemented");
+  }
+
   // Runs a task but do not wait for the result. The result can be retrieved by
   // "NextAsynchronousAnswer". If the worker idx is <0, it is up to the manager
   // to select a worker.
@@ -218,6 +289,20 @@ absl::Status InternalInitializeWorker(
 template <typename Result, typename Request>
 utils::StatusOr<Result> AbstractManager::BlockingProtoRequest(
     Request request, const int worker_idx) {
+  // In-process implementations can exchange the protos directly, without
+  // serialization.
+  auto typed_answer = BlockingTypedRequest(request, worker_idx);
+  if (typed_answer.ok()) {
+    auto* result = dynamic_cast<Result*>(typed_answer.value().get());
+    if (result == nullptr) {
+      return absl::InternalError("Unexpected answer type");
+    }
+    return std::move(*result);
+  }
+  if (!absl::IsUnimplemented(typed_answer.status())) {
+    return typed_answer.status();
+  }
+
   ASSIGN_OR_RETURN(auto serialized_result,
                    BlockingRequest(request.SerializeAsString(), worker_idx));
   return utils::ParseBinaryProto<Result>(serialized_result);
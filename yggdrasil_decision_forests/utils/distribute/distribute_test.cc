@@ -76,6 +76,42 @@ TEST(SingleThread, AsynchronousRequest) {
   all.Join();
 }
 
+TEST(SingleThread, TypedBlockingRequest) {
+  auto all = CreateSingleThreadManager();
+
+  // The request proto is moved to the worker without serialization.
+  proto::Config request;
+  request.set_implementation_key("identity");
+  request.set_verbosity(42);
+  const auto answer =
+      all.manager->BlockingProtoRequest<proto::Config>(request).value();
+  EXPECT_EQ(answer.implementation_key(), "identity");
+  EXPECT_EQ(answer.verbosity(), 42);
+
+  // Worker errors are propagated like with serialized requests.
+  request.set_implementation_key("gen_error");
+  EXPECT_THAT(
+      all.manager->BlockingProtoRequest<proto::Config>(request).status(),
+      test::StatusIs(absl::StatusCode::kInvalidArgument));
+
+  all.Join();
+}
+
+TEST(SingleThread, CachedBlockingRequest) {
+  auto all = CreateSingleThreadManager();
+
+  // Without caching, each request is re-computed.
+  EXPECT_EQ(all.manager->BlockingRequest("count", 0).value(), "1");
+  EXPECT_EQ(all.manager->BlockingRequest("count", 0).value(), "2");
+
+  // With caching, an already computed answer is served from the cache.
+  EXPECT_OK(all.manager->BlockingRequest("enable_cache", 0).status());
+  EXPECT_EQ(all.manager->BlockingRequest("count", 0).value(), "3");
+  EXPECT_EQ(all.manager->BlockingRequest("count", 0).value(), "3");
+
+  all.Join();
+}
+
 TEST(SingleThread, BlockingRequestWithSpecificWorker) {
   auto all = CreateSingleThreadManager();
   TestBlockingRequestWithSpecificWorker(all.manager.get());
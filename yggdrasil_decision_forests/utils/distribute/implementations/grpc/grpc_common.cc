@@ -0,0 +1,104 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/distribute/implementations/grpc/grpc_common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+#include "grpcpp/client_context.h"
+#include "absl/strings/str_cat.h"
+
+namespace yggdrasil_decision_forests {
+namespace distribute {
+namespace {
+
+// Maximum execution time of a request.
+constexpr int kDeadLineInHours = 24 * 40;
+
+}  // namespace
+
+bool IsTransientError(const grpc::Status& status) {
+  return status.error_message() == "Socket closed" ||
+         status.error_message() == "Transport closed" ||
+         status.error_message() == "Connection reset by peer" ||
+         status.error_message() == "Broken pipe" ||
+         status.error_message() == "keepalive watchdog timeout";
+}
+
+grpc::ChannelArguments CreateChannelArguments(const int channel_idx,
+                                              const bool use_compression) {
+  grpc::ChannelArguments channel_arguments;
+  channel_arguments.SetMaxReceiveMessageSize(std::numeric_limits<int>::max());
+  channel_arguments.SetMaxSendMessageSize(std::numeric_limits<int>::max());
+  channel_arguments.SetInt("yggdrasil.channel_idx", channel_idx);
+  if (use_compression) {
+    channel_arguments.SetCompressionAlgorithm(GRPC_COMPRESS_GZIP);
+  }
+  return channel_arguments;
+}
+
+grpc::Status StreamQuery(proto::Server::Stub* stub,
+                         const proto::QueryChunk& header, const Blob& blob,
+                         proto::AnswerChunk* answer_metadata,
+                         Blob* answer_blob) {
+  grpc::ClientContext context;
+  context.set_wait_for_ready(true);
+  context.set_deadline(std::chrono::system_clock::now() +
+                       std::chrono::hours(kDeadLineInHours));
+  auto stream = stub->Run(&context);
+
+  // Emit the query.
+  if (stream->Write(header)) {
+    size_t offset = 0;
+    while (offset < blob.size()) {
+      const size_t chunk_size = std::min(kBlobChunkSize, blob.size() - offset);
+      proto::QueryChunk chunk;
+      chunk.set_blob(blob.data() + offset, chunk_size);
+      if (!stream->Write(chunk)) {
+        break;
+      }
+      offset += chunk_size;
+    }
+  }
+  stream->WritesDone();
+
+  // Re-assemble the answer.
+  answer_metadata->Clear();
+  answer_blob->clear();
+  proto::AnswerChunk chunk;
+  while (stream->Read(&chunk)) {
+    if (chunk.has_blob()) {
+      if (answer_blob->empty()) {
+        *answer_blob = std::move(*chunk.mutable_blob());
+      } else {
+        absl::StrAppend(answer_blob, chunk.blob());
+      }
+    } else {
+      *answer_metadata = std::move(chunk);
+    }
+  }
+
+  const auto status = stream->Finish();
+  if (status.ok() && answer_metadata->type_case() ==
+                         proto::AnswerChunk::TYPE_NOT_SET) {
+    return grpc::Status(grpc::StatusCode::INTERNAL, "Missing answer metadata");
+  }
+  return status;
+}
+
+}  // namespace distribute
+}  // namespace yggdrasil_decision_forests
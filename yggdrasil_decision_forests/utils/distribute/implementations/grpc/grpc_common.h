@@ -0,0 +1,61 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Communication utilities shared by the GRPC distribute manager and worker.
+
+#ifndef THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_DISTRIBUTE_IMPLEMENTATIONS_GRPC_COMMON_H_
+#define THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_DISTRIBUTE_IMPLEMENTATIONS_GRPC_COMMON_H_
+
+#include "grpcpp/support/channel_arguments.h"
+#include "yggdrasil_decision_forests/utils/distribute/core.h"
+#include "yggdrasil_decision_forests/utils/distribute/implementations/grpc/grpc.grpc.pb.h"
+
+namespace yggdrasil_decision_forests {
+namespace distribute {
+
+// Size of the blob chunks exchanged through the streaming "Run" RPC. Blobs
+// larger than this value are split over multiple messages: a single gRPC
+// message cannot exceed 2GB.
+constexpr size_t kBlobChunkSize = size_t{4} * 1024 * 1024;
+
+// Checks if a gRPC error possibly indicates a temporary impossibility to
+// reach the server e.g. the worker is being rescheduled. Such a call can be
+// retried. The gRPC documentation does not specify those error messages.
+bool IsTransientError(const grpc::Status& status);
+
+// Creates the arguments of a channel to a worker. "channel_idx" makes the
+// arguments of each of the channels to a given worker unique: with equal
+// arguments, gRPC silently multiplexes the channels over a single connection.
+grpc::ChannelArguments CreateChannelArguments(int channel_idx,
+                                              bool use_compression);
+
+// Emits a query through the streaming "Run" RPC and re-assembles the answer.
+//
+// The first emitted message is "header" (the query metadata, without
+// payload). "blob" (the query payload) is then sent in chunks of
+// "kBlobChunkSize" bytes. Symmetrically, "answer_metadata" receives the
+// answer metadata and "answer_blob" the re-assembled answer payload.
+//
+// Communication errors are returned as a non-ok status and should be handled
+// (e.g. retried; see "IsTransientError") by the caller.
+grpc::Status StreamQuery(proto::Server::Stub* stub,
+                         const proto::QueryChunk& header, const Blob& blob,
+                         proto::AnswerChunk* answer_metadata,
+                         Blob* answer_blob);
+
+}  // namespace distribute
+}  // namespace yggdrasil_decision_forests
+
+#endif  // THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_DISTRIBUTE_IMPLEMENTATIONS_GRPC_COMMON_H_
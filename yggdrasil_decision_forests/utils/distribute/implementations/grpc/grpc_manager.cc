@@ -21,26 +21,15 @@
 #include "grpcpp/support/channel_arguments.h"
 #include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/distribute/implementations/grpc/grpc.grpc.pb.h"
+#include "yggdrasil_decision_forests/utils/distribute/implementations/grpc/grpc_common.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
+#include "yggdrasil_decision_forests/utils/instrument.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 #include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 namespace yggdrasil_decision_forests {
 namespace distribute {
-namespace {
-
-constexpr int kDeadLineInHours = 24 * 40;
-
-absl::Status GrpcStatusToAbslStatus(const grpc::Status& src) {
-  if (src.ok()) {
-    return absl::Status();
-  } else {
-    return absl::UnknownError(src.error_message());
-  }
-}
-
-}  // namespace
 
 constexpr char GRPCManager::kKey[];
 
@@ -82,24 +71,31 @@ absl::Status GRPCManager::InitializeWorkers(
     credential = grpc::InsecureChannelCredentials();
   }
 
+  const int num_channels_per_worker =
+      std::max(1, imp_config.num_channels_per_worker());
+
   for (int worker_idx = 0; worker_idx < worker_addresses.size(); worker_idx++) {
     auto worker = absl::make_unique<Worker>();
     worker->worker_idx = worker_idx;
 
     while (true) {
-      grpc::ChannelArguments channel_arguments;
-      channel_arguments.SetMaxReceiveMessageSize(
-          std::numeric_limits<int>::max());
-      channel_arguments.SetMaxSendMessageSize(std::numeric_limits<int>::max());
-
-      worker->channel = grpc::CreateCustomChannel(
-          worker_addresses[worker_idx], credential, channel_arguments);
-      worker->stub = proto::Server::NewStub(worker->channel);
+      worker->channels.clear();
+      worker->stubs.clear();
+      for (int channel_idx = 0; channel_idx < num_channels_per_worker;
+           channel_idx++) {
+        worker->channels.push_back(grpc::CreateCustomChannel(
+            worker_addresses[worker_idx], credential,
+            CreateChannelArguments(channel_idx,
+                                   imp_config.use_compression())));
+        worker->stubs.push_back(
+            proto::Server::NewStub(worker->channels.back()));
+      }
 
       grpc::ClientContext context;
       proto::Empty query;
       proto::Empty answer;
-      const auto ping_status = worker->stub->Ping(&context, query, &answer);
+      const auto ping_status =
+          worker->stubs.front()->Ping(&context, query, &answer);
       if (!ping_status.ok()) {
         if (verbosity_ >= 1) {
           LOG(INFO) << "Worker #" << worker_idx
@@ -172,31 +168,31 @@ absl::Status GRPCManager::SetParallelExecutionPerWorker(int num) {
 }
 
 void GRPCManager::WorkerRun(Blob blob, Worker* worker) {
-  proto::Query query;
-  *query.mutable_blob() = std::move(blob);
+  async_pending_answers_.Push(RunQueryOnWorker(std::move(blob), worker));
+}
+
+proto::Answer GRPCManager::RunQueryOnWorker(Blob blob, Worker* worker) {
+  YDF_INSTRUMENT_SPAN("distribute.grpc.round_trip");
+  YDF_INSTRUMENT_COUNTER("distribute.grpc.query_bytes", blob.size());
+  proto::QueryChunk header;
+  auto& query = *header.mutable_query();
   query.set_config_path(worker_config_path_);
   query.set_manager_uid(manager_uid_);
   query.set_worker_idx(worker->worker_idx);
 
   int num_re_emitting = 0;
-  proto::Answer answer;
   while (true) {
-    grpc::ClientContext context;
-    context.set_wait_for_ready(true);
-    context.set_deadline(std::chrono::system_clock::now() +
-                         std::chrono::hours(kDeadLineInHours));
-    const auto status = worker->stub->Run(&context, query, &answer);
+    proto::AnswerChunk answer_metadata;
+    Blob answer_blob;
+    const auto status = StreamQuery(worker->RoundRobinStub(), header, blob,
+                                    &answer_metadata, &answer_blob);
 
     if (!status.ok()) {
       if (verbosity_ >= 1) {
         LOG(WARNING) << "GRPC call to worker #" << worker->worker_idx
                      << " failed with error: " << status.error_message();
       }
-      if (status.error_message() == "Socket closed" ||
-          status.error_message() == "Transport closed" ||
-          status.error_message() == "Connection reset by peer" ||
-          status.error_message() == "Broken pipe" ||
-          status.error_message() == "keepalive watchdog timeout") {
+      if (IsTransientError(status)) {
         // The worker died during the execution (e.g. rescheduling).
         // Let's try again.
         if (verbosity_ >= 1) {
@@ -207,17 +203,18 @@ void GRPCManager::WorkerRun(Blob blob, Worker* worker) {
         continue;
       } else {
         // Something is not right.
+        proto::Answer answer;
         answer.set_error(status.error_message());
-        async_pending_answers_.Push(std::move(answer));
-        return;
+        return answer;
       }
     } else {
+      auto answer = std::move(*answer_metadata.mutable_answer());
+      *answer.mutable_blob() = std::move(answer_blob);
       if (verbosity_ >= 1 && answer.has_error()) {
         LOG(WARNING) << "Worker #" << worker->worker_idx
                      << " returned an error: " << answer.error();
       }
-      async_pending_answers_.Push(std::move(answer));
-      return;
+      return answer;
     }
   }
 }
@@ -259,6 +256,13 @@ absl::Status GRPCManager::InitializeConfigFile(
   worker_config.set_parallel_execution_per_worker(
       parallel_execution_per_worker);
 
+  const auto& imp_config = config.GetExtension(proto::grpc);
+  worker_config.set_num_channels_per_worker(
+      std::max(1, imp_config.num_channels_per_worker()));
+  worker_config.set_use_compression(imp_config.use_compression());
+  worker_config.set_max_inter_worker_execution(
+      imp_config.max_inter_worker_execution());
+
   for (const auto& worker : workers_) {
     worker_config.add_worker_addresses(worker->address);
   }
@@ -277,45 +281,8 @@ utils::StatusOr<Blob> GRPCManager::BlockingRequest(Blob blob, int worker_idx) {
   }
   auto* worker = workers_[worker_idx].get();
 
-  proto::Query query;
-  *query.mutable_blob() = std::move(blob);
-  query.set_config_path(worker_config_path_);
-  query.set_manager_uid(manager_uid_);
-  query.set_worker_idx(worker->worker_idx);
-
-  proto::Answer answer;
-  while (true) {
-    grpc::ClientContext context;
-    context.set_wait_for_ready(true);
-    context.set_deadline(std::chrono::system_clock::now() +
-                         std::chrono::hours(kDeadLineInHours));
-    const auto status = worker->stub->Run(&context, query, &answer);
-    if (!status.ok()) {
-      if (verbosity_ >= 1) {
-        LOG(WARNING) << "GRPC to worker #" << worker_idx
-                     << " failed with error: " << status.error_message();
-      }
-      if (status.error_message() == "Socket closed" ||
-          status.error_message() == "Transport closed" ||
-          status.error_message() == "Connection reset by peer" ||
-          status.error_message() == "Broken pipe" ||
-          status.error_message() == "keepalive watchdog timeout") {
-        // The worker died during the execution (e.g. rescheduling).
-        // Let's try again.
-        continue;
-      } else {
-        // Something is not right.
-        return GrpcStatusToAbslStatus(status);
-      }
-    }
-    break;
-  }
-
+  auto answer = RunQueryOnWorker(std::move(blob), worker);
   if (answer.has_error()) {
-    if (verbosity_ >= 1) {
-      LOG(WARNING) << "Worker #" << worker_idx
-                   << " returned an error: " << answer.error();
-    }
     return absl::InvalidArgumentError(answer.error());
   }
   return std::move(*answer.mutable_blob());
@@ -385,7 +352,8 @@ absl::Status GRPCManager::Done(absl::optional<bool> kill_worker_manager) {
     context.set_deadline(std::chrono::system_clock::now() +
                          std::chrono::minutes(2));
     proto::Empty ignored;
-    auto worker_shutdown = worker->stub->Shutdown(&context, query, &ignored);
+    auto worker_shutdown =
+        worker->stubs.front()->Shutdown(&context, query, &ignored);
     if (!worker_shutdown.ok()) {
       // It is not a big deal if the worker crashes during shutdown.
       LOG(WARNING) << "Error when shutting down the connection:"
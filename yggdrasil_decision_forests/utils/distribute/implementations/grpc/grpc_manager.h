@@ -59,9 +59,17 @@ class GRPCManager : public AbstractManager {
  private:
   struct Worker {
     int worker_idx;
-    std::unique_ptr<proto::Server::Stub> stub;
     std::string address;
-    std::shared_ptr<grpc::Channel> channel;
+
+    // Channels / stubs to the worker. Queries are distributed over the
+    // channels in round-robin (see "num_channels_per_worker").
+    std::vector<std::shared_ptr<grpc::Channel>> channels;
+    std::vector<std::unique_ptr<proto::Server::Stub>> stubs;
+    std::atomic<int> next_stub_idx = {0};
+
+    proto::Server::Stub* RoundRobinStub() {
+      return stubs[next_stub_idx.fetch_add(1) % stubs.size()].get();
+    }
 
     // Async query to execute specific to this worker.
     utils::concurrency::Channel<Blob> async_pending_queries_;
@@ -91,6 +99,11 @@ class GRPCManager : public AbstractManager {
   // Process a query and export the result to the answer queue.
   void WorkerRun(Blob blob, Worker* worker);
 
+  // Emits a query to a worker and waits for the answer. Transient
+  // communication errors (e.g. the worker is being rescheduled) are retried.
+  // Non-transient errors are reported in the "error" field of the answer.
+  proto::Answer RunQueryOnWorker(Blob blob, Worker* worker);
+
   void JoinWorkers();
 
   // Path to serialized worker configuration accessible by all workers.
@@ -31,7 +31,8 @@ namespace {
 
 // Create a GRPC manager and its workers.
 ManagerCreatorAndWorkers CreateGrpcManagerCreator(
-    int parallel_execution_per_worker = 1, int num_workers = 5) {
+    int parallel_execution_per_worker = 1, int num_workers = 5,
+    int max_inter_worker_execution = 0) {
   ManagerCreatorAndWorkers manager_and_workers;
   // Manager configuration.
   proto::Config config;
@@ -39,6 +40,8 @@ ManagerCreatorAndWorkers CreateGrpcManagerCreator(
   config.set_verbosity(1);
   config.set_working_directory(
       file::JoinPath(test::TmpDirectory(), "work_dir"));
+  config.MutableExtension(proto::grpc)->set_max_inter_worker_execution(
+      max_inter_worker_execution);
   auto* addresses =
       config.MutableExtension(proto::grpc)->mutable_socket_addresses();
   for (int worker_idx = 0; worker_idx < num_workers; worker_idx++) {
@@ -68,8 +71,11 @@ ManagerCreatorAndWorkers CreateGrpcManagerCreator(
   return manager_and_workers;
 }
 
-ManagerAndWorkers CreateGrpcManager(int parallel_execution_per_worker = 1) {
-  auto creator = CreateGrpcManagerCreator(parallel_execution_per_worker);
+ManagerAndWorkers CreateGrpcManager(int parallel_execution_per_worker = 1,
+                                    int max_inter_worker_execution = 0) {
+  auto creator =
+      CreateGrpcManagerCreator(parallel_execution_per_worker,
+                               /*num_workers=*/5, max_inter_worker_execution);
   ManagerAndWorkers m_and_w;
   m_and_w.worker_threads = std::move(creator.worker_threads);
   m_and_w.manager = creator.manager_creator();
@@ -112,6 +118,14 @@ TEST(GRPC, AsynchronousIntraWorkerCommunication) {
   all.Join();
 }
 
+TEST(GRPC, AsynchronousIntraWorkerCommunicationBounded) {
+  // Each worker executes at most one inter-worker request at a time.
+  auto all = CreateGrpcManager(/*parallel_execution_per_worker=*/1,
+                               /*max_inter_worker_execution=*/1);
+  TestAsynchronousIntraWorkerCommunication(all.manager.get());
+  all.Join();
+}
+
 TEST(GRPC, AsynchronousParallelWorkerExecution) {
   auto all = CreateGrpcManager(5);
   TestAsynchronousParallelWorkerExecution(all.manager.get());
@@ -19,10 +19,10 @@
 #include "grpcpp/server.h"
 #include "grpcpp/server_builder.h"
 #include "grpcpp/server_context.h"
-#include "grpcpp/support/channel_arguments.h"
 #include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/distribute/core.h"
 #include "yggdrasil_decision_forests/utils/distribute/implementations/grpc/grpc.grpc.pb.h"
+#include "yggdrasil_decision_forests/utils/distribute/implementations/grpc/grpc_common.h"
 #include "yggdrasil_decision_forests/utils/distribute/utils.h"
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
@@ -33,9 +33,6 @@ namespace yggdrasil_decision_forests {
 namespace distribute {
 namespace {
 
-// Maximum execution time of a request.
-constexpr int kDeadLineInHours = 24 * 40;
-
 grpc::Status AbslStatusToGrpcStatus(const absl::Status& src) {
   if (src.ok()) {
     return grpc::Status();
@@ -44,6 +41,43 @@ grpc::Status AbslStatusToGrpcStatus(const absl::Status& src) {
   }
 }
 
+// Bounds the number of requests of one class executing concurrently on the
+// worker. The gRPC server runs each incoming "Run" call on a dedicated
+// thread, so without a bound a flood of requests (e.g. split evaluations
+// queried by many peer workers at once) all execute at the same time and
+// oversubscribe the CPU. "Acquire" blocks until a slot is free. A capacity
+// <=0 disables the bound. The capacity should be large enough for the
+// requests of a class that block on the answers of other requests of the
+// same class (if any), otherwise the workers can deadlock.
+class ExecutionLane {
+ public:
+  void SetCapacity(const int capacity) {
+    utils::concurrency::MutexLock lock(&mutex_);
+    capacity_ = capacity;
+    free_slot_.SignalAll();
+  }
+
+  void Acquire() {
+    utils::concurrency::MutexLock lock(&mutex_);
+    while (capacity_ > 0 && num_running_ >= capacity_) {
+      free_slot_.Wait(&mutex_, &lock);
+    }
+    num_running_++;
+  }
+
+  void Release() {
+    utils::concurrency::MutexLock lock(&mutex_);
+    num_running_--;
+    free_slot_.Signal();
+  }
+
+ private:
+  utils::concurrency::Mutex mutex_;
+  utils::concurrency::CondVar free_slot_;
+  int capacity_ GUARDED_BY(mutex_) = 0;
+  int num_running_ GUARDED_BY(mutex_) = 0;
+};
+
 class WorkerService final : public proto::Server::Service {
  public:
   WorkerService(utils::concurrency::Notification* stop_server, bool use_loas)
@@ -91,18 +125,65 @@ class WorkerService final : public proto::Server::Service {
     WorkerService* parent_;
   };
 
-  // Execution of a query emitted by the manager.
-  grpc::Status Run(grpc::ServerContext* context, const proto::Query* request,
-                   proto::Answer* reply) override {
+  // Execution of a query streamed by the manager or by another worker. The
+  // first message contains the query metadata, the following ones the query
+  // payload. The answer is streamed back in the same way.
+  grpc::Status Run(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<proto::AnswerChunk, proto::QueryChunk>* stream)
+      override {
+    // Re-assemble the query.
+    proto::QueryChunk header;
+    Blob query_blob;
+    proto::QueryChunk chunk;
+    while (stream->Read(&chunk)) {
+      if (chunk.has_blob()) {
+        if (query_blob.empty()) {
+          query_blob = std::move(*chunk.mutable_blob());
+        } else {
+          absl::StrAppend(&query_blob, chunk.blob());
+        }
+      } else {
+        header = std::move(chunk);
+      }
+    }
+
+    proto::AnswerChunk answer_metadata;
+    Blob answer_blob;
+    switch (header.type_case()) {
+      case proto::QueryChunk::kQuery:
+        RETURN_IF_ERROR(RunManagerQuery(header.query(), std::move(query_blob),
+                                        answer_metadata.mutable_answer(),
+                                        &answer_blob));
+        break;
+      case proto::QueryChunk::kWorkerQuery:
+        RunWorkerQuery(std::move(query_blob),
+                       answer_metadata.mutable_worker_answer(), &answer_blob);
+        break;
+      default:
+        return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT,
+                            "Missing query metadata");
+    }
+
+    return StreamAnswer(context, answer_metadata, answer_blob, stream);
+  }
+
+  // Execution of a query emitted by the manager. Each query runs on its own
+  // server thread, so a cheap blocking request (e.g. a status check) is
+  // serviced while long pipelined requests execute. The manager bounds the
+  // number of pipelined requests in flight on each worker with
+  // "parallel_execution_per_worker".
+  grpc::Status RunManagerQuery(const proto::Query& query, Blob query_blob,
+                               proto::Answer* reply, Blob* reply_blob) {
     {
       utils::concurrency::MutexLock l(&mutex_);
       RETURN_IF_ERROR(AbslStatusToGrpcStatus(
-          EnsureReadyWorker(request->manager_uid(), request->config_path(),
-                            request->worker_idx(), &l)));
+          EnsureReadyWorker(query.manager_uid(), query.config_path(),
+                            query.worker_idx(), &l)));
       num_active_requests_++;
     }
 
-    auto result_or = worker_->RunRequest(request->blob());
+    auto result_or = worker_->RunRequestMaybeCached(std::move(query_blob));
 
     {
       utils::concurrency::MutexLock l(&mutex_);
@@ -116,32 +197,61 @@ class WorkerService final : public proto::Server::Service {
     }
 
     if (!result_or.ok()) {
-      reply->set_error(absl::StrCat("Worker #", request->worker_idx(), ": ",
+      reply->set_error(absl::StrCat("Worker #", query.worker_idx(), ": ",
                                     result_or.status().ToString()));
     } else {
-      *reply->mutable_blob() = std::move(result_or).value();
+      *reply_blob = std::move(result_or).value();
     }
     return grpc::Status::OK;
   }
 
-  // Execution of a query emitted by another worker.
-  grpc::Status WorkerRun(grpc::ServerContext* context,
-                         const proto::WorkerQuery* request,
-                         proto::WorkerAnswer* reply) override {
+  // Execution of a query emitted by another worker. Unlike the manager
+  // queries, the inter-worker queries are not bounded on the emission side:
+  // all the other workers can query this worker at the same time. The
+  // "inter_worker_lane_" bounds how many of those queries execute
+  // concurrently (see "max_inter_worker_execution").
+  void RunWorkerQuery(Blob query_blob, proto::WorkerAnswer* reply,
+                      Blob* reply_blob) {
     if (!worker_) {
       LOG(WARNING) << "Worker received an inter worker request before being "
                       "initialized by the manager";
       reply->set_error(
           "Worker received an inter worker request before being initialized by "
           "the manager");
-      return grpc::Status::OK;
+      return;
     }
 
-    auto result_or = worker_->RunRequest(request->blob());
+    inter_worker_lane_.Acquire();
+    auto result_or = worker_->RunRequestMaybeCached(std::move(query_blob));
+    inter_worker_lane_.Release();
     if (!result_or.ok()) {
       reply->set_error(result_or.status().ToString());
     } else {
-      *reply->mutable_blob() = std::move(result_or).value();
+      *reply_blob = std::move(result_or).value();
+    }
+  }
+
+  // Streams back an answer: first the metadata, then the payload in chunks of
+  // "kBlobChunkSize" bytes.
+  grpc::Status StreamAnswer(
+      grpc::ServerContext* context, const proto::AnswerChunk& metadata,
+      const Blob& blob,
+      grpc::ServerReaderWriter<proto::AnswerChunk, proto::QueryChunk>* stream) {
+    if (use_compression_) {
+      context->set_compression_algorithm(GRPC_COMPRESS_GZIP);
+    }
+    if (!stream->Write(metadata)) {
+      return grpc::Status(grpc::StatusCode::CANCELLED, "Connection closed");
+    }
+    size_t offset = 0;
+    while (offset < blob.size()) {
+      const size_t chunk_size = std::min(kBlobChunkSize, blob.size() - offset);
+      proto::AnswerChunk chunk;
+      chunk.set_blob(blob.data() + offset, chunk_size);
+      if (!stream->Write(chunk)) {
+        return grpc::Status(grpc::StatusCode::CANCELLED, "Connection closed");
+      }
+      offset += chunk_size;
     }
     return grpc::Status::OK;
   }
@@ -227,6 +337,16 @@ class WorkerService final : public proto::Server::Service {
 
     worker_addresses_ = {worker_config.worker_addresses().begin(),
                          worker_config.worker_addresses().end()};
+    num_channels_per_worker_ =
+        std::max(1, worker_config.num_channels_per_worker());
+    use_compression_ = worker_config.use_compression();
+
+    int max_inter_worker_execution = worker_config.max_inter_worker_execution();
+    if (max_inter_worker_execution <= 0) {
+      max_inter_worker_execution =
+          worker_config.parallel_execution_per_worker();
+    }
+    inter_worker_lane_.SetCapacity(max_inter_worker_execution);
 
     ASSIGN_OR_RETURN(
         worker_, AbstractWorkerRegisterer::Create(worker_config.worker_name()));
@@ -247,31 +367,22 @@ class WorkerService final : public proto::Server::Service {
                                                    const int target_worker) {
     RETURN_IF_ERROR(EnsureIntraWorkerStubIsReady(target_worker));
 
-    proto::WorkerQuery query;
-    *query.mutable_blob() = std::move(blob);
-    query.set_manager_uid(manager_uid_);
+    proto::QueryChunk header;
+    header.mutable_worker_query()->set_manager_uid(manager_uid_);
 
     int num_re_emitting = 0;
-    proto::WorkerAnswer answer;
     while (true) {
-      grpc::ClientContext context;
-      context.set_wait_for_ready(true);
-      context.set_deadline(std::chrono::system_clock::now() +
-                           std::chrono::hours(kDeadLineInHours));
-      const auto status =
+      proto::AnswerChunk answer_metadata;
+      Blob answer_blob;
+      const auto status = StreamQuery(
           intra_worker_communication_->other_workers[target_worker]
-              .stub->WorkerRun(&context, query, &answer);
+              ->RoundRobinStub(),
+          header, blob, &answer_metadata, &answer_blob);
 
       if (!status.ok()) {
         LOG(WARNING) << "Intra worker GRPC call failed with error: "
                      << status.error_message();
-        // List of non-documented GRPC errors that can indicate a temporary
-        // impossibility to reach the server.
-        if (status.error_message() == "Socket closed" ||
-            status.error_message() == "Transport closed" ||
-            status.error_message() == "Connection reset by peer" ||
-            status.error_message() == "Broken pipe" ||
-            status.error_message() == "keepalive watchdog timeout") {
+        if (IsTransientError(status)) {
           // The worker died during the execution (e.g. rescheduling).
           // Let's try again.
           num_re_emitting++;
@@ -283,13 +394,14 @@ class WorkerService final : public proto::Server::Service {
           return absl::UnknownError(status.error_message());
         }
       } else {
+        const auto& answer = answer_metadata.worker_answer();
         if (answer.has_error()) {
           LOG(WARNING)
               << "Worker called with intra worker GRPC call returned an error: "
               << answer.error();
           return absl::UnknownError(answer.error());
         } else {
-          return std::move(*answer.mutable_blob());
+          return std::move(answer_blob);
         }
       }
     }
@@ -320,16 +432,20 @@ class WorkerService final : public proto::Server::Service {
     intra_worker_communication_ = absl::make_unique<InterWorkerCommunication>();
     intra_worker_communication_->threads.Start(
         num_threads, [&]() { ProcessInterWorkerCommunication(); });
-    intra_worker_communication_->other_workers.resize(num_workers);
+    intra_worker_communication_->other_workers.reserve(num_workers);
+    for (int worker_idx = 0; worker_idx < num_workers; worker_idx++) {
+      intra_worker_communication_->other_workers.push_back(
+          absl::make_unique<InterWorkerCommunication::OtherWorkers>());
+    }
   }
 
   // Ensures that the communication with another worker is ready.
   absl::Status EnsureIntraWorkerStubIsReady(const int worker_idx) {
     CHECK(intra_worker_communication_);
     CHECK_LT(worker_idx, intra_worker_communication_->other_workers.size());
-    auto& worker = intra_worker_communication_->other_workers[worker_idx];
+    auto& worker = *intra_worker_communication_->other_workers[worker_idx];
 
-    if (worker.stub) {
+    if (!worker.stubs.empty()) {
       return absl::OkStatus();
     }
 
@@ -340,13 +456,13 @@ class WorkerService final : public proto::Server::Service {
       credential = grpc::InsecureChannelCredentials();
     }
 
-    grpc::ChannelArguments channel_arguments;
-    channel_arguments.SetMaxReceiveMessageSize(std::numeric_limits<int>::max());
-    channel_arguments.SetMaxSendMessageSize(std::numeric_limits<int>::max());
-
-    worker.channel = grpc::CreateCustomChannel(worker_addresses_[worker_idx],
-                                               credential, channel_arguments);
-    worker.stub = proto::Server::NewStub(worker.channel);
+    for (int channel_idx = 0; channel_idx < num_channels_per_worker_;
+         channel_idx++) {
+      worker.channels.push_back(grpc::CreateCustomChannel(
+          worker_addresses_[worker_idx], credential,
+          CreateChannelArguments(channel_idx, use_compression_)));
+      worker.stubs.push_back(proto::Server::NewStub(worker.channels.back()));
+    }
     return absl::OkStatus();
   }
 
@@ -374,6 +490,12 @@ class WorkerService final : public proto::Server::Service {
   // Socket address of all the workers.
   std::vector<std::string> worker_addresses_;
 
+  // Number of channels opened to each of the other workers.
+  int num_channels_per_worker_ = 1;
+
+  // If true, compress the streamed messages.
+  bool use_compression_ = false;
+
   // Fields related to the inter worker communication.
   struct InterWorkerCommunication {
     // List of target worker index and data emitted by this worker.
@@ -386,12 +508,19 @@ class WorkerService final : public proto::Server::Service {
     ThreadVector threads;
 
     struct OtherWorkers {
-      std::shared_ptr<grpc::Channel> channel;
-      std::unique_ptr<proto::Server::Stub> stub;
+      // Channels / stubs to the other worker. Queries are distributed over
+      // the channels in round-robin (see "num_channels_per_worker").
+      std::vector<std::shared_ptr<grpc::Channel>> channels;
+      std::vector<std::unique_ptr<proto::Server::Stub>> stubs;
+      std::atomic<int> next_stub_idx = {0};
+
+      proto::Server::Stub* RoundRobinStub() {
+        return stubs[next_stub_idx.fetch_add(1) % stubs.size()].get();
+      }
     };
 
     // Communication channel to other workers for intra worker communication.
-    std::vector<OtherWorkers> other_workers;
+    std::vector<std::unique_ptr<OtherWorkers>> other_workers;
   };
 
   std::unique_ptr<InterWorkerCommunication> intra_worker_communication_;
@@ -415,6 +544,10 @@ class WorkerService final : public proto::Server::Service {
   // Number of requests currently beeing processed.
   int num_active_requests_ GUARDED_BY(mutex_) = 0;
 
+  // Bound on the number of inter-worker requests executing concurrently.
+  // The capacity is set in "EnsureReadyWorker".
+  ExecutionLane inter_worker_lane_;
+
   // Does the worker uses LOAS.
   bool use_loas_;
 
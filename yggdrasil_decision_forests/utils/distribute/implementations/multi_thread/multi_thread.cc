@@ -36,7 +36,7 @@ utils::StatusOr<Blob> MultiThreadManager::BlockingRequest(Blob blob,
   }
 
   ASSIGN_OR_RETURN(Blob answer,
-                   workers_[worker_idx]->worker_imp->RunRequest(blob),
+                   workers_[worker_idx]->worker_imp->RunRequestMaybeCached(blob),
                    _ << "Error emitted by worker #" << worker_idx);
 
   if (verbosity_ >= 2) {
@@ -46,6 +46,29 @@ utils::StatusOr<Blob> MultiThreadManager::BlockingRequest(Blob blob,
   return answer;
 }
 
+utils::StatusOr<std::unique_ptr<google::protobuf::Message>>
+MultiThreadManager::BlockingTypedRequest(
+    const google::protobuf::Message& request, int worker_idx) {
+  if (verbosity_ >= 2) {
+    LOG(INFO) << "Emitting typed blocking request";
+  }
+
+  if (worker_idx < 0) {
+    worker_idx = next_worker_.fetch_add(1) % workers_.size();
+  }
+
+  // If the worker does not implement typed requests, the returned
+  // UnimplementedError makes the caller (e.g. "BlockingProtoRequest") fall
+  // back on the serialized "BlockingRequest".
+  ASSIGN_OR_RETURN(auto answer,
+                   workers_[worker_idx]->worker_imp->RunTypedRequest(request));
+
+  if (verbosity_ >= 2) {
+    LOG(INFO) << "Completed typed blocking request";
+  }
+  return answer;
+}
+
 absl::Status MultiThreadManager::AsynchronousRequest(Blob blob,
                                                      int worker_idx) {
   if (verbosity_ >= 2) {
@@ -84,8 +107,8 @@ void MultiThreadManager::ProcessGlobalQueries(Worker* worker) {
     if (!pending_blob_or.has_value()) {
       break;
     }
-    auto answer =
-        worker->worker_imp->RunRequest(std::move(pending_blob_or.value()));
+    auto answer = worker->worker_imp->RunRequestMaybeCached(
+        std::move(pending_blob_or.value()));
     pending_answers_.Push(std::move(answer));
   }
 }
@@ -96,8 +119,8 @@ void MultiThreadManager::ProcessLocalQueries(Worker* worker) {
     if (!pending_blob_or.has_value()) {
       break;
     }
-    auto answer =
-        worker->worker_imp->RunRequest(std::move(pending_blob_or.value()));
+    auto answer = worker->worker_imp->RunRequestMaybeCached(
+        std::move(pending_blob_or.value()));
     pending_answers_.Push(std::move(answer));
   }
 }
@@ -108,7 +131,7 @@ void MultiThreadManager::ProcessInterWorkersLocalQueries(Worker* worker) {
     if (!pending_blob_or.has_value()) {
       break;
     }
-    auto answer = worker->worker_imp->RunRequest(
+    auto answer = worker->worker_imp->RunRequestMaybeCached(
         std::move(pending_blob_or.value().second));
     workers_[pending_blob_or.value().first]->pending_inter_workers_answers.Push(
         std::move(answer));
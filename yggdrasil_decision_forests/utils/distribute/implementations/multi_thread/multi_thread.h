@@ -43,6 +43,13 @@ class MultiThreadManager : public AbstractManager,
 
   utils::StatusOr<Blob> BlockingRequest(Blob blob, int worker_idx) override;
 
+  // Since the workers run in the same address space as the manager, the
+  // request proto is given directly to the worker, skipping the
+  // serialization+parsing round trip of "BlockingRequest".
+  utils::StatusOr<std::unique_ptr<google::protobuf::Message>>
+  BlockingTypedRequest(const google::protobuf::Message& request,
+                       int worker_idx) override;
+
   absl::Status AsynchronousRequest(Blob blob, int worker_idx) override;
 
   utils::StatusOr<Blob> NextAsynchronousAnswer() override;
@@ -16,6 +16,7 @@
 #ifndef THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_DISTRIBUTE_TOY_WORKER_H_
 #define THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_DISTRIBUTE_TOY_WORKER_H_
 
+#include "absl/memory/memory.h"
 #include "absl/synchronization/barrier.h"
 #include "yggdrasil_decision_forests/utils/distribute/core.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
@@ -100,6 +101,11 @@ class ToyWorker final : public AbstractWorker {
     } else if (absl::StartsWith(blob, "sleep")) {
       absl::SleepFor(absl::Seconds(5));
       return "";
+    } else if (blob == "enable_cache") {
+      EnableAnswerCaching(/*max_size_bytes=*/1024);
+      return "";
+    } else if (blob == "count") {
+      return absl::StrCat(++count_);
     } else if (absl::StartsWith(blob, "num_existing_toy_workers")) {
       return absl::StrCat(num_existing_toy_workers_.load());
     } else if (absl::StartsWith(blob, "max_num_existing_toy_workers")) {
@@ -108,6 +114,26 @@ class ToyWorker final : public AbstractWorker {
     return absl::InvalidArgumentError("Unknown task");
   }
 
+  // Typed tasks. The request and the answer are "proto::Config" messages and
+  // the task is encoded in the "implementation_key" field.
+  //
+  // Tasks:
+  //   "identity" -> return the request unchanged.
+  //   "gen_error" -> Raise an error.
+  utils::StatusOr<std::unique_ptr<google::protobuf::Message>> RunTypedRequest(
+      const google::protobuf::Message& request) override {
+    const auto* typed_request = dynamic_cast<const proto::Config*>(&request);
+    if (typed_request == nullptr) {
+      return absl::InvalidArgumentError("Unexpected request type");
+    }
+    LOG(INFO) << "RunTypedRequest " << typed_request->implementation_key()
+              << " on worker " << WorkerIdx();
+    if (typed_request->implementation_key() == "gen_error") {
+      return absl::InvalidArgumentError("Some error");
+    }
+    return absl::make_unique<proto::Config>(*typed_request);
+  }
+
  private:
   // Number of "ToyWorker" objects initialized in memory.
   static std::atomic<int> num_existing_toy_workers_;
@@ -117,6 +143,8 @@ class ToyWorker final : public AbstractWorker {
 
   std::string value_;  // For the "get/set" task.
 
+  int count_ = 0;  // For the "count" task.
+
   absl::Barrier *barrier_ = nullptr;
 };
 
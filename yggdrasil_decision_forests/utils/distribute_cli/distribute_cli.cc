@@ -83,6 +83,14 @@ absl::Status DistributeCLIManager::Initialize() {
                                 /*welcome_blob=*/welcome.SerializeAsString(),
                                 /*parallel_execution_per_worker=*/
                                 config_.parallel_execution_per_worker()));
+
+  // Index the stage concurrency limits.
+  for (const auto& stage_concurrency : config_.stage_concurrency()) {
+    if (stage_concurrency.max_concurrent_commands() > 0) {
+      max_concurrent_per_stage_[stage_concurrency.stage()] =
+          stage_concurrency.max_concurrent_commands();
+    }
+  }
   return absl::OkStatus();
 }
 
@@ -101,6 +109,103 @@ absl::Status DistributeCLIManager::Schedule(
   return absl::OkStatus();
 }
 
+absl::Status DistributeCLIManager::ScheduleDag(
+    const absl::string_view command,
+    const std::vector<std::string>& dependencies,
+    const absl::optional<std::string>& uid, const absl::string_view stage) {
+  if (config_.distribute_config().verbosity() >= 2) {
+    LOG(INFO) << "Schedule dag command: " << command;
+  }
+  const auto internal_command_id =
+      CommandToInternalCommandId(uid.has_value() ? uid.value() : command);
+  if (dag_command_idxs_.find(internal_command_id) != dag_command_idxs_.end()) {
+    return absl::InvalidArgumentError(absl::Substitute(
+        "The dag command $0 was scheduled multiple times.", command));
+  }
+
+  const int dag_command_idx = dag_commands_.size();
+  DagCommand dag_command;
+  dag_command.command = std::string(command);
+  dag_command.uid = uid;
+  dag_command.stage = std::string(stage);
+  for (const auto& dependency : dependencies) {
+    const auto it =
+        dag_command_idxs_.find(CommandToInternalCommandId(dependency));
+    if (it == dag_command_idxs_.end()) {
+      return absl::InvalidArgumentError(absl::Substitute(
+          "Unknown dependency \"$0\". Dependencies should be scheduled (with "
+          "\"ScheduleDag\") before their dependents.",
+          dependency));
+    }
+    auto& dependency_command = dag_commands_[it->second];
+    if (!dependency_command.done) {
+      dependency_command.dependents.push_back(dag_command_idx);
+      dag_command.num_pending_dependencies++;
+    }
+  }
+  dag_command_idxs_[internal_command_id] = dag_command_idx;
+  dag_commands_.push_back(std::move(dag_command));
+
+  if (dag_commands_[dag_command_idx].num_pending_dependencies == 0) {
+    return MaybeStartDagCommand(dag_command_idx);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status DistributeCLIManager::MaybeStartDagCommand(
+    const int dag_command_idx) {
+  auto& dag_command = dag_commands_[dag_command_idx];
+  if (!dag_command.stage.empty()) {
+    const auto limit_it = max_concurrent_per_stage_.find(dag_command.stage);
+    if (limit_it != max_concurrent_per_stage_.end()) {
+      auto& num_running = num_running_per_stage_[dag_command.stage];
+      if (num_running >= limit_it->second) {
+        stage_queues_[dag_command.stage].push_back(dag_command_idx);
+        return absl::OkStatus();
+      }
+      num_running++;
+    }
+  }
+  return ScheduleNow(dag_command.command, dag_command.uid);
+}
+
+absl::Status DistributeCLIManager::OnDagCommandDone(
+    const absl::string_view internal_command_id) {
+  const auto it = dag_command_idxs_.find(internal_command_id);
+  if (it == dag_command_idxs_.end()) {
+    // Not a dag command.
+    return absl::OkStatus();
+  }
+  auto& dag_command = dag_commands_[it->second];
+  if (dag_command.done) {
+    return absl::OkStatus();
+  }
+  dag_command.done = true;
+
+  // Release the stage slot and start the next queued command of this stage.
+  if (!dag_command.stage.empty() &&
+      max_concurrent_per_stage_.find(dag_command.stage) !=
+          max_concurrent_per_stage_.end()) {
+    num_running_per_stage_[dag_command.stage]--;
+    auto& stage_queue = stage_queues_[dag_command.stage];
+    if (!stage_queue.empty()) {
+      const int next_dag_command_idx = stage_queue.front();
+      stage_queue.pop_front();
+      RETURN_IF_ERROR(MaybeStartDagCommand(next_dag_command_idx));
+    }
+  }
+
+  // Start the dependents that became ready.
+  for (const int dependent_idx : dag_command.dependents) {
+    auto& dependent = dag_commands_[dependent_idx];
+    dependent.num_pending_dependencies--;
+    if (dependent.num_pending_dependencies == 0) {
+      RETURN_IF_ERROR(MaybeStartDagCommand(dependent_idx));
+    }
+  }
+  return absl::OkStatus();
+}
+
 absl::Status DistributeCLIManager::ScheduleNow(
     const absl::string_view command, const absl::optional<std::string>& uid) {
   proto::Request generic_request;
@@ -164,6 +269,8 @@ absl::Status DistributeCLIManager::WaitCompletion() {
         distribute_manager_->NextAsynchronousProtoAnswer<proto::Result>());
     pending_commands_--;
     finished_commands_since_last_log++;
+    RETURN_IF_ERROR(
+        OnDagCommandDone(generic_result.command().internal_command_id()));
     if (config_.distribute_config().verbosity() >= 1 &&
         absl::Now() >= next_log) {
       next_log = absl::Now() + absl::Seconds(30);
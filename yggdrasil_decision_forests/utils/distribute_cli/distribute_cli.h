@@ -33,9 +33,11 @@
 #ifndef THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_DISTRIBUTE_CLI_H_
 #define THIRD_PARTY_YGGDRASIL_DECISION_FORESTS_UTILS_DISTRIBUTE_CLI_H_
 
+#include <deque>
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "yggdrasil_decision_forests/utils/distribute/distribute.h"
@@ -83,6 +85,26 @@ class DistributeCLIManager {
   absl::Status Schedule(const absl::string_view command,
                         const absl::optional<std::string>& uid = {});
 
+  // Schedules a new command that only starts after other commands completed
+  // successfully. Commands without pending dependencies run in parallel i.e.
+  // independent branches of the DAG proceed while slow stages finish.
+  // Args:
+  //   command: Command to run.
+  //   dependencies: Uids of the commands (scheduled with a previous
+  //     "ScheduleDag" call) that should complete before this command starts.
+  //     Since dependencies are scheduled first, cycles are impossible.
+  //   uid: Unique identifier of the command. Same semantic as in "Schedule".
+  //   stage: If non-empty, the number of commands of this stage running at
+  //     the same time can be limited with the "stage_concurrency" field of
+  //     the config.
+  //
+  // If a command fails, "WaitCompletion" returns its error and the commands
+  // that transitively depend on it are never started.
+  absl::Status ScheduleDag(const absl::string_view command,
+                           const std::vector<std::string>& dependencies,
+                           const absl::optional<std::string>& uid = {},
+                           const absl::string_view stage = "");
+
   // Waits for all the previously scheduled commands to run. If a command fails,
   // returns immediately with the error. Following an error, the manager can be
   // stopped (using "Shutdown"), or "WaitCompletion" can be called again to wait
@@ -106,6 +128,15 @@ class DistributeCLIManager {
   absl::Status ScheduleNow(const absl::string_view command,
                            const absl::optional<std::string>& uid);
 
+  // Starts a dag command unless its stage is at its concurrency limit. In
+  // this case, the command is queued until a command of the same stage
+  // completes.
+  absl::Status MaybeStartDagCommand(int dag_command_idx);
+
+  // Releases the dependents and the stage queue of a completed dag command.
+  // No-op if "internal_command_id" is not a dag command.
+  absl::Status OnDagCommandDone(const absl::string_view internal_command_id);
+
   std::unique_ptr<distribute::AbstractManager> distribute_manager_;
   proto::Config config_;
   std::string log_dir_;
@@ -121,6 +152,33 @@ class DistributeCLIManager {
   int pending_commands_ = 0;
 
   absl::flat_hash_set<std::string> past_commands_;
+
+  // A command scheduled with "ScheduleDag".
+  struct DagCommand {
+    std::string command;
+    absl::optional<std::string> uid;
+    std::string stage;
+    // Indices (in "dag_commands_") of the commands waiting on this command.
+    std::vector<int> dependents;
+    // Number of dependencies that did not complete yet.
+    int num_pending_dependencies = 0;
+    bool done = false;
+  };
+  std::vector<DagCommand> dag_commands_;
+
+  // Mapping from internal command id to index in "dag_commands_".
+  absl::flat_hash_map<std::string, int> dag_command_idxs_;
+
+  // Dag commands ready to run but waiting for their stage concurrency limit,
+  // in scheduling order.
+  absl::flat_hash_map<std::string, std::deque<int>> stage_queues_;
+
+  // Number of currently running commands, per stage.
+  absl::flat_hash_map<std::string, int> num_running_per_stage_;
+
+  // Maximum number of concurrent commands per stage. Stages without an entry
+  // are not limited. Extracted from the config in "Initialize".
+  absl::flat_hash_map<std::string, int> max_concurrent_per_stage_;
 };
 
 }  // namespace distribute_cli
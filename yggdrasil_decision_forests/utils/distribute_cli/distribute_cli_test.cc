@@ -16,7 +16,9 @@
 #include "yggdrasil_decision_forests/utils/distribute_cli/distribute_cli.h"
 
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/utils/distribute/implementations/multi_thread/multi_thread.pb.h"
+#include "yggdrasil_decision_forests/utils/filesystem.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 
 namespace yggdrasil_decision_forests {
@@ -46,6 +48,38 @@ TEST(DistributeCLI, Ls) {
   EXPECT_OK(manager.Shutdown());
 }
 
+TEST(DistributeCLI, Dag) {
+  auto config = CreateConfig();
+  auto* stage_concurrency = config.add_stage_concurrency();
+  stage_concurrency->set_stage("make");
+  stage_concurrency->set_max_concurrent_commands(1);
+
+  auto manager = DistributeCLIManager(config);
+  EXPECT_OK(manager.Initialize());
+
+  // The "make" commands create files that the "join" command requires: "join"
+  // fails if it runs before its dependencies complete.
+  const auto tmp_dir = test::TmpDirectory();
+  const auto file_a = file::JoinPath(tmp_dir, "a");
+  const auto file_b = file::JoinPath(tmp_dir, "b");
+  EXPECT_OK(manager.ScheduleDag(CommandBuilder("touch").Arg(file_a).Build(),
+                                /*dependencies=*/{}, /*uid=*/"make_a",
+                                /*stage=*/"make"));
+  EXPECT_OK(manager.ScheduleDag(CommandBuilder("touch").Arg(file_b).Build(),
+                                /*dependencies=*/{}, /*uid=*/"make_b",
+                                /*stage=*/"make"));
+  EXPECT_OK(manager.ScheduleDag(
+      absl::StrCat("test -f \"", file_a, "\" -a -f \"", file_b, "\""),
+      /*dependencies=*/{"make_a", "make_b"}, /*uid=*/"join"));
+
+  // Unknown dependencies are rejected.
+  EXPECT_THAT(manager.ScheduleDag("ls", /*dependencies=*/{"non_existing"}),
+              test::StatusIs(absl::StatusCode::kInvalidArgument));
+
+  EXPECT_OK(manager.WaitCompletion());
+  EXPECT_OK(manager.Shutdown());
+}
+
 TEST(DistributeCLI, Error) {
   auto manager = DistributeCLIManager(CreateConfig());
   EXPECT_OK(manager.Initialize());
@@ -42,7 +42,12 @@ void InitializeConfusionMatrixProto(
   confusion->set_nrow(nr);
   confusion->set_ncol(nc);
   confusion->set_sum(0);
-  confusion->mutable_counts()->Resize(nr * nc, 0.);
+  if (nr == nc && nr >= kSparseConfusionMatrixMinNumRows) {
+    confusion->set_sparse(true);
+    confusion->mutable_diagonal()->Resize(nr, 0.);
+  } else {
+    confusion->mutable_counts()->Resize(nr * nc, 0.);
+  }
 }
 
 void AddToConfusionMatrixProto(
@@ -52,9 +57,19 @@ void AddToConfusionMatrixProto(
   DCHECK_GE(c, 0);
   DCHECK_LT(r, confusion->nrow());
   DCHECK_LT(c, confusion->ncol());
-  const int index =
-      IntegersConfusionMatrixDouble::Index(r, c, confusion->nrow());
-  confusion->set_counts(index, confusion->counts(index) + value);
+  if (confusion->sparse()) {
+    if (r == c) {
+      confusion->set_diagonal(r, confusion->diagonal(r) + value);
+    } else {
+      const int64_t index =
+          r + static_cast<int64_t>(c) * confusion->nrow();
+      (*confusion->mutable_sparse_counts())[index] += value;
+    }
+  } else {
+    const int index =
+        IntegersConfusionMatrixDouble::Index(r, c, confusion->nrow());
+    confusion->set_counts(index, confusion->counts(index) + value);
+  }
   confusion->set_sum(confusion->sum() + value);
 }
 
@@ -62,9 +77,20 @@ void AddToConfusionMatrixProto(const proto::IntegersConfusionMatrixDouble& src,
                                proto::IntegersConfusionMatrixDouble* dst) {
   DCHECK_EQ(src.nrow(), dst->nrow());
   DCHECK_EQ(src.ncol(), dst->ncol());
-  DCHECK_EQ(src.counts_size(), dst->counts_size());
-  for (int i = 0; i < src.counts_size(); i++) {
-    dst->set_counts(i, src.counts(i) + dst->counts(i));
+  DCHECK_EQ(src.sparse(), dst->sparse());
+  if (src.sparse()) {
+    DCHECK_EQ(src.diagonal_size(), dst->diagonal_size());
+    for (int i = 0; i < src.diagonal_size(); i++) {
+      dst->set_diagonal(i, src.diagonal(i) + dst->diagonal(i));
+    }
+    for (const auto& cell : src.sparse_counts()) {
+      (*dst->mutable_sparse_counts())[cell.first] += cell.second;
+    }
+  } else {
+    DCHECK_EQ(src.counts_size(), dst->counts_size());
+    for (int i = 0; i < src.counts_size(); i++) {
+      dst->set_counts(i, src.counts(i) + dst->counts(i));
+    }
   }
   dst->set_sum(dst->sum() + src.sum());
 }
@@ -73,6 +99,12 @@ double ConfusionMatrixProtoTrace(
     const proto::IntegersConfusionMatrixDouble& confusion) {
   DCHECK_EQ(confusion.nrow(), confusion.ncol());
   double sum = 0;
+  if (confusion.sparse()) {
+    for (const double value : confusion.diagonal()) {
+      sum += value;
+    }
+    return sum;
+  }
   for (int row = 0; row < confusion.ncol(); row++) {
     const int index =
         IntegersConfusionMatrixDouble::Index(row, row, confusion.nrow());
@@ -84,6 +116,15 @@ double ConfusionMatrixProtoTrace(
 double ConfusionMatrixProtoSumColumns(
     const proto::IntegersConfusionMatrixDouble& confusion, int32_t row) {
   double sum = 0;
+  if (confusion.sparse()) {
+    sum = confusion.diagonal(row);
+    for (const auto& cell : confusion.sparse_counts()) {
+      if (cell.first % confusion.nrow() == row) {
+        sum += cell.second;
+      }
+    }
+    return sum;
+  }
   for (int col = 0; col < confusion.ncol(); col++) {
     sum += confusion.counts(
         IntegersConfusionMatrixDouble::Index(row, col, confusion.nrow()));
@@ -91,6 +132,27 @@ double ConfusionMatrixProtoSumColumns(
   return sum;
 }
 
+std::vector<double> ConfusionMatrixProtoRowSums(
+    const proto::IntegersConfusionMatrixDouble& confusion) {
+  std::vector<double> sums(confusion.nrow(), 0.);
+  if (confusion.sparse()) {
+    for (int row = 0; row < confusion.diagonal_size(); row++) {
+      sums[row] = confusion.diagonal(row);
+    }
+    for (const auto& cell : confusion.sparse_counts()) {
+      sums[cell.first % confusion.nrow()] += cell.second;
+    }
+    return sums;
+  }
+  for (int col = 0; col < confusion.ncol(); col++) {
+    for (int row = 0; row < confusion.nrow(); row++) {
+      sums[row] += confusion.counts(
+          IntegersConfusionMatrixDouble::Index(row, col, confusion.nrow()));
+    }
+  }
+  return sums;
+}
+
 int TopClass(const proto::IntegerDistributionFloat& dist) {
   int top_index = 0;
   float top_value = 0.;
@@ -20,6 +20,7 @@
 #include <cmath>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/container/inlined_vector.h"
@@ -288,6 +289,98 @@ using IntegerDistributionDouble = IntegerDistribution<double>;
 using IntegerDistributionInt64 = IntegerDistribution<int64_t>;
 using IntegerDistributionFloat = IntegerDistribution<float>;
 
+// Discrete distribution over [0, NumClasses()) optimized for the case where
+// only a small fraction of the classes is observed e.g. the per-bucket label
+// statistics of a categorical split with an extreme multi-class label. The
+// observed (class, count) pairs are stored in a small sorted array, and the
+// representation switches automatically to a dense count vector (equivalent
+// to "IntegerDistribution") when more than "1/kDenseRatio" of the classes are
+// observed. Exposes the subset of the "IntegerDistribution" API used by the
+// splitter accumulators.
+template <typename T>
+class SparseIntegerDistribution {
+ public:
+  SparseIntegerDistribution() {}
+
+  explicit SparseIntegerDistribution(const int num_classes)
+      : num_classes_(num_classes) {}
+
+  // Remove all observations and return to the sparse representation.
+  void Clear() {
+    sum_ = 0;
+    sparse_.clear();
+    dense_.clear();
+  }
+
+  // Number of classes i.e. max integer value + 1.
+  int NumClasses() const { return num_classes_; }
+
+  // Define the number of classes.
+  void SetNumClasses(const int c);
+
+  // Add one observation.
+  void Add(int v);
+  void Add(int v, T weight);
+
+  // Subtract one observation.
+  void Sub(int v);
+  void Sub(int v, T weight);
+
+  // Add the content of another SparseIntegerDistribution.
+  void Add(const SparseIntegerDistribution<T>& v);
+
+  // Subtract the content of another SparseIntegerDistribution.
+  void Sub(const SparseIntegerDistribution<T>& v);
+
+  // Add (resp. subtract) the content of "this" to a dense distribution. Costs
+  // O(number of observed classes) in the sparse representation.
+  void AddTo(IntegerDistribution<T>* dst) const;
+  void SubTo(IntegerDistribution<T>* dst) const;
+
+  // Number of observations.
+  T NumObservations() const { return sum_; }
+
+  // Query a value. Costs O(log(number of observed classes)) in the sparse
+  // representation.
+  T count(int i) const;
+
+  // Entropy of the observations.
+  double Entropy() const;
+
+  // Proportion of observations equal to "value". If the distribution is
+  // empty, returns minus infinity.
+  float SafeProportionOrMinusInfinity(const int value) const {
+    if (sum_ > 0) {
+      return count(value) / sum_;
+    }
+    return -std::numeric_limits<float>::infinity();
+  }
+
+  // Whether the distribution currently uses the dense representation.
+  bool is_dense() const { return !dense_.empty(); }
+
+ private:
+  // The representation becomes dense when more than "NumClasses() /
+  // kDenseRatio" classes are observed.
+  static constexpr int kDenseRatio = 4;
+
+  // Add "weight" to class "v" in the sparse representation.
+  void AddSparse(int v, T weight);
+
+  // Switch to the dense representation.
+  void Densify();
+
+  T sum_ = 0;
+  int num_classes_ = 0;
+  // Observed (class, count) pairs, sorted by class. Empty in the dense
+  // representation.
+  absl::InlinedVector<std::pair<int32_t, T>, 8> sparse_;
+  // Dense counts. Empty in the sparse representation.
+  std::vector<T> dense_;
+};
+
+using SparseIntegerDistributionDouble = SparseIntegerDistribution<double>;
+
 // Confusion matrix between a binary attribute and an integer attribute.
 template <typename T>
 class BinaryToIntegerConfusionMatrix {
@@ -412,7 +505,15 @@ int TopClass(const proto::IntegerDistributionDouble& dist);
 using IntegersConfusionMatrixDouble = IntegersConfusionMatrix<double>;
 using IntegersConfusionMatrixInt64 = IntegersConfusionMatrix<int64_t>;
 
-// Initialize a confusion matrix.
+// Number of classes at which "InitializeConfusionMatrixProto" switches a
+// square confusion matrix to the sparse representation (hash-based cells with
+// a dense diagonal). At this size, a dense "counts" weights ~130MB and is
+// mostly-zero.
+constexpr int32_t kSparseConfusionMatrixMinNumRows = 4096;
+
+// Initialize a confusion matrix. Square matrices with at least
+// "kSparseConfusionMatrixMinNumRows" rows are stored in the sparse
+// representation.
 void InitializeConfusionMatrixProto(
     int32_t nr, int32_t nc, proto::IntegersConfusionMatrixDouble* confusion);
 
@@ -420,7 +521,8 @@ void InitializeConfusionMatrixProto(
 void AddToConfusionMatrixProto(int32_t r, int32_t c, double value,
                                proto::IntegersConfusionMatrixDouble* confusion);
 
-// Add two initialized confusion matrices.
+// Add two initialized confusion matrices. The matrices should use the same
+// representation (dense or sparse).
 void AddToConfusionMatrixProto(const proto::IntegersConfusionMatrixDouble& src,
                                proto::IntegersConfusionMatrixDouble* dst);
 
@@ -428,10 +530,16 @@ void AddToConfusionMatrixProto(const proto::IntegersConfusionMatrixDouble& src,
 double ConfusionMatrixProtoTrace(
     const proto::IntegersConfusionMatrixDouble& confusion);
 
-// Sum all the elements of a given row.
+// Sum all the elements of a given row. On a sparse matrix, this function
+// iterates over all the non-zero cells: use "ConfusionMatrixProtoRowSums" to
+// get the sums of all the rows in a single pass.
 double ConfusionMatrixProtoSumColumns(
     const proto::IntegersConfusionMatrixDouble& confusion, int32_t row);
 
+// Sum of the elements of each row i.e. sums[i] is the sum of the i-th row.
+std::vector<double> ConfusionMatrixProtoRowSums(
+    const proto::IntegersConfusionMatrixDouble& confusion);
+
 // Initialize an IntegerDistributionProto.
 template <typename T>
 void InitializeIntegerDistributionProto(const int num_classes,
@@ -857,6 +965,167 @@ double IntegerDistribution<T>::Entropy() const {
   return entropy;
 }
 
+template <typename T>
+void SparseIntegerDistribution<T>::SetNumClasses(const int c) {
+  num_classes_ = c;
+  if (!dense_.empty()) {
+    dense_.resize(c);
+  }
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::Densify() {
+  dense_.assign(num_classes_, T{0});
+  for (const auto& entry : sparse_) {
+    dense_[entry.first] = entry.second;
+  }
+  sparse_.clear();
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::AddSparse(const int v, const T weight) {
+  const auto it = std::lower_bound(
+      sparse_.begin(), sparse_.end(), v,
+      [](const std::pair<int32_t, T>& entry, const int value) {
+        return entry.first < value;
+      });
+  if (it != sparse_.end() && it->first == v) {
+    it->second += weight;
+    return;
+  }
+  sparse_.insert(it, {v, weight});
+  if (static_cast<int>(sparse_.size()) * kDenseRatio > num_classes_) {
+    Densify();
+  }
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::Add(const int v) {
+  Add(v, T{1});
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::Add(const int v, const T weight) {
+  DCHECK_GE(v, 0);
+  DCHECK_LT(v, num_classes_);
+  sum_ += weight;
+  if (!dense_.empty()) {
+    dense_[v] += weight;
+    return;
+  }
+  AddSparse(v, weight);
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::Sub(const int v) {
+  Add(v, -T{1});
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::Sub(const int v, const T weight) {
+  Add(v, -weight);
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::Add(const SparseIntegerDistribution<T>& v) {
+  DCHECK_EQ(num_classes_, v.num_classes_);
+  if (v.dense_.empty()) {
+    for (const auto& entry : v.sparse_) {
+      Add(entry.first, entry.second);
+    }
+    return;
+  }
+  if (dense_.empty()) {
+    Densify();
+  }
+  sum_ += v.sum_;
+  for (int i = 0; i < num_classes_; i++) {
+    dense_[i] += v.dense_[i];
+  }
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::Sub(const SparseIntegerDistribution<T>& v) {
+  DCHECK_EQ(num_classes_, v.num_classes_);
+  if (v.dense_.empty()) {
+    for (const auto& entry : v.sparse_) {
+      Add(entry.first, -entry.second);
+    }
+    return;
+  }
+  if (dense_.empty()) {
+    Densify();
+  }
+  sum_ -= v.sum_;
+  for (int i = 0; i < num_classes_; i++) {
+    dense_[i] -= v.dense_[i];
+  }
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::AddTo(IntegerDistribution<T>* dst) const {
+  DCHECK_EQ(num_classes_, dst->NumClasses());
+  if (dense_.empty()) {
+    for (const auto& entry : sparse_) {
+      dst->Add(entry.first, entry.second);
+    }
+    return;
+  }
+  for (int i = 0; i < num_classes_; i++) {
+    dst->Add(i, dense_[i]);
+  }
+}
+
+template <typename T>
+void SparseIntegerDistribution<T>::SubTo(IntegerDistribution<T>* dst) const {
+  DCHECK_EQ(num_classes_, dst->NumClasses());
+  if (dense_.empty()) {
+    for (const auto& entry : sparse_) {
+      dst->Sub(entry.first, entry.second);
+    }
+    return;
+  }
+  for (int i = 0; i < num_classes_; i++) {
+    dst->Sub(i, dense_[i]);
+  }
+}
+
+template <typename T>
+T SparseIntegerDistribution<T>::count(const int i) const {
+  DCHECK_GE(i, 0);
+  DCHECK_LT(i, num_classes_);
+  if (!dense_.empty()) {
+    return dense_[i];
+  }
+  const auto it = std::lower_bound(
+      sparse_.begin(), sparse_.end(), i,
+      [](const std::pair<int32_t, T>& entry, const int value) {
+        return entry.first < value;
+      });
+  if (it != sparse_.end() && it->first == i) {
+    return it->second;
+  }
+  return T{0};
+}
+
+template <typename T>
+double SparseIntegerDistribution<T>::Entropy() const {
+  if (sum_ == 0) {
+    return 0;
+  }
+  double entropy = 0;
+  if (dense_.empty()) {
+    for (const auto& entry : sparse_) {
+      entropy += ProtectedPLogPDouble(entry.second, sum_);
+    }
+  } else {
+    for (const auto count : dense_) {
+      entropy += ProtectedPLogPDouble(count, sum_);
+    }
+  }
+  return entropy;
+}
+
 // Entropy of a distribution [p, 1-p]. This function is safe and always returns
 // a non-NAN value.
 inline double BinaryDistributionEntropyD(const double p) {
@@ -31,6 +31,7 @@ namespace utils {
 namespace {
 
 using test::EqualsProto;
+using testing::ElementsAre;
 
 TEST(Distribution, NormalDistribution) {
   NormalDistributionDouble dist;
@@ -130,6 +131,70 @@ TEST(Distribution, IntegerDistributionDoubleNormalization) {
   EXPECT_EQ(dist.count(2), 3.5 / 6.);
 }
 
+TEST(Distribution, SparseIntegerDistributionDouble) {
+  SparseIntegerDistributionDouble dist;
+  dist.SetNumClasses(100);
+  dist.Add(10, 2.5);
+  dist.Add(90, 3.5);
+  dist.Add(10, 1.5);
+
+  EXPECT_FALSE(dist.is_dense());
+  EXPECT_EQ(dist.count(10), 4.);
+  EXPECT_EQ(dist.count(90), 3.5);
+  EXPECT_EQ(dist.count(50), 0.);
+  EXPECT_EQ(dist.NumClasses(), 100);
+  EXPECT_EQ(dist.NumObservations(), 7.5);
+
+  // entropy(c(4,3.5)) = 0.6909233 in R.
+  EXPECT_NEAR(dist.Entropy(), 0.6909233, 0.0001);
+
+  IntegerDistributionDouble dense;
+  dense.SetNumClasses(100);
+  dist.AddTo(&dense);
+  EXPECT_EQ(dense.count(10), 4.);
+  EXPECT_EQ(dense.count(90), 3.5);
+  EXPECT_EQ(dense.NumObservations(), 7.5);
+  dist.SubTo(&dense);
+  EXPECT_EQ(dense.NumObservations(), 0.);
+
+  SparseIntegerDistributionDouble dist2;
+  dist2.SetNumClasses(100);
+  dist2.Add(10, 1.);
+  dist2.Add(20, 2.);
+  dist2.Add(dist);
+  EXPECT_EQ(dist2.count(10), 5.);
+  EXPECT_EQ(dist2.count(20), 2.);
+  EXPECT_EQ(dist2.count(90), 3.5);
+  dist2.Sub(dist);
+  EXPECT_EQ(dist2.count(10), 1.);
+  EXPECT_EQ(dist2.count(90), 0.);
+  EXPECT_EQ(dist2.NumObservations(), 3.);
+}
+
+TEST(Distribution, SparseIntegerDistributionDoubleDensify) {
+  SparseIntegerDistributionDouble dist;
+  dist.SetNumClasses(8);
+  for (int v = 0; v < 8; v++) {
+    dist.Add(v, v + 1.);
+  }
+  // More than 1/4 of the classes are observed.
+  EXPECT_TRUE(dist.is_dense());
+  for (int v = 0; v < 8; v++) {
+    EXPECT_EQ(dist.count(v), v + 1.);
+  }
+  EXPECT_EQ(dist.NumObservations(), 36.);
+
+  IntegerDistributionDouble dense;
+  dense.SetNumClasses(8);
+  dist.AddTo(&dense);
+  EXPECT_EQ(dense.NumObservations(), 36.);
+  EXPECT_NEAR(dense.Entropy(), dist.Entropy(), 0.0001);
+
+  dist.Clear();
+  EXPECT_FALSE(dist.is_dense());
+  EXPECT_EQ(dist.NumObservations(), 0.);
+}
+
 TEST(Distribution, IntegerDistributionDoubleNormalizeAndClampPositive) {
   IntegerDistributionDouble dist;
   dist.SetNumClasses(4);
@@ -343,6 +408,40 @@ TEST(Distribution, ConfusionMatrixProtoSumColumns) {
   EXPECT_EQ(ConfusionMatrixProtoSumColumns(confusion, 0), 2);
   EXPECT_EQ(ConfusionMatrixProtoSumColumns(confusion, 1), 2);
   EXPECT_EQ(ConfusionMatrixProtoSumColumns(confusion, 2), 1);
+  EXPECT_THAT(ConfusionMatrixProtoRowSums(confusion),
+              ElementsAre(2., 2., 1.));
+}
+
+TEST(Distribution, SparseConfusionMatrixProto) {
+  const int32_t n = kSparseConfusionMatrixMinNumRows;
+  proto::IntegersConfusionMatrixDouble confusion;
+  InitializeConfusionMatrixProto(n, n, &confusion);
+  EXPECT_TRUE(confusion.sparse());
+  EXPECT_EQ(confusion.counts_size(), 0);
+
+  AddToConfusionMatrixProto(0, 0, 1, &confusion);
+  AddToConfusionMatrixProto(0, 1, 1, &confusion);
+  AddToConfusionMatrixProto(1, 1, 2, &confusion);
+  AddToConfusionMatrixProto(n - 1, 0, 1, &confusion);
+  EXPECT_EQ(confusion.sum(), 5);
+  EXPECT_EQ(confusion.sparse_counts_size(), 2);
+  EXPECT_EQ(ConfusionMatrixProtoTrace(confusion), 3);
+  EXPECT_EQ(ConfusionMatrixProtoSumColumns(confusion, 0), 2);
+  EXPECT_EQ(ConfusionMatrixProtoSumColumns(confusion, 1), 2);
+  EXPECT_EQ(ConfusionMatrixProtoSumColumns(confusion, n - 1), 1);
+
+  const auto row_sums = ConfusionMatrixProtoRowSums(confusion);
+  EXPECT_EQ(row_sums[0], 2);
+  EXPECT_EQ(row_sums[1], 2);
+  EXPECT_EQ(row_sums[n - 1], 1);
+
+  proto::IntegersConfusionMatrixDouble dst;
+  InitializeConfusionMatrixProto(n, n, &dst);
+  AddToConfusionMatrixProto(1, 0, 1, &dst);
+  AddToConfusionMatrixProto(confusion, &dst);
+  EXPECT_EQ(dst.sum(), 6);
+  EXPECT_EQ(ConfusionMatrixProtoTrace(dst), 3);
+  EXPECT_EQ(ConfusionMatrixProtoSumColumns(dst, 1), 3);
 }
 
 TEST(Distribution, IntegersConfusionMatrix_AppendHtmlReport) {
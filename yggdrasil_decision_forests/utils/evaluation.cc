@@ -13,6 +13,11 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "absl/status/status.h"
 #if defined YGG_TFRECORD_PREDICTIONS
 #include "yggdrasil_decision_forests/utils/sharded_io_tfrecord.h"
@@ -21,9 +26,11 @@
 #include "yggdrasil_decision_forests/dataset/data_spec.h"
 #include "yggdrasil_decision_forests/dataset/example_writer.h"
 #include "yggdrasil_decision_forests/dataset/formats.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/distribution.h"
 #include "yggdrasil_decision_forests/utils/distribution.pb.h"
 #include "yggdrasil_decision_forests/utils/evaluation.h"
+#include "yggdrasil_decision_forests/utils/sharded_io.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace yggdrasil_decision_forests {
@@ -46,6 +53,34 @@ utils::StatusOr<PredictionFormat> ParsePredictionFormat(
   return absl::InvalidArgumentError(absl::StrCat("Unknown format ", value));
 }
 
+namespace {
+
+// Converts and writes a range of predictions into a single shard.
+absl::Status ExportPredictionRange(
+    const std::vector<model::proto::Prediction>& predictions,
+    const model::proto::Task task, const dataset::proto::Column& label_column,
+    const dataset::proto::DataSpecification& dataspec,
+    const absl::string_view typed_shard_path,
+    const absl::optional<std::string>& prediction_key,
+    const PredictionFormat format, const size_t begin_idx,
+    const size_t end_idx) {
+  ASSIGN_OR_RETURN(auto writer,
+                   dataset::CreateExampleWriter(typed_shard_path, dataspec,
+                                                /*num_records_by_shard=*/-1));
+  dataset::proto::Example prediction_as_example;
+  for (size_t prediction_idx = begin_idx; prediction_idx < end_idx;
+       prediction_idx++) {
+    RETURN_IF_ERROR(PredictionToExample(task, label_column,
+                                        predictions[prediction_idx],
+                                        &prediction_as_example, prediction_key,
+                                        format));
+    RETURN_IF_ERROR(writer->Write(prediction_as_example));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
 absl::Status ExportPredictions(
     const std::vector<model::proto::Prediction>& predictions,
     model::proto::Task task, const dataset::proto::Column& label_column,
@@ -76,6 +111,53 @@ absl::Status ExportPredictions(
   // proto::Examples.
   ASSIGN_OR_RETURN(auto dataspec, PredictionDataspec(task, label_column,
                                                      prediction_key, format));
+
+  // If the output is divided in multiple shards, the shards are converted and
+  // written by parallel threads.
+  if (num_records_by_shard_in_output > 0 && !predictions.empty()) {
+    std::vector<std::string> shards;
+    RETURN_IF_ERROR(ExpandOutputShards(prediction_path, &shards));
+    // Like the sequential writer, each shard receives
+    // "num_records_by_shard_in_output" predictions, the last used shard
+    // receives the remaining ones, and the extra shards are not created.
+    const size_t num_used_shards = std::min(
+        shards.size(),
+        static_cast<size_t>(predictions.size() +
+                            num_records_by_shard_in_output - 1) /
+            num_records_by_shard_in_output);
+    if (num_used_shards > 1) {
+      std::vector<absl::Status> shard_status(num_used_shards);
+      {
+        utils::concurrency::ThreadPool pool(
+            "export_predictions",
+            std::min<size_t>(num_used_shards,
+                             std::max<unsigned int>(
+                                 1, std::thread::hardware_concurrency())));
+        pool.StartWorkers();
+        for (size_t shard_idx = 0; shard_idx < num_used_shards; shard_idx++) {
+          const size_t begin_idx = shard_idx * num_records_by_shard_in_output;
+          const size_t end_idx =
+              (shard_idx + 1 == num_used_shards)
+                  ? predictions.size()
+                  : begin_idx + num_records_by_shard_in_output;
+          const std::string typed_shard_path =
+              absl::StrCat(prediction_format, ":", shards[shard_idx]);
+          pool.Schedule([&predictions, &label_column, &dataspec,
+                         &prediction_key, &shard_status, task, format,
+                         typed_shard_path, shard_idx, begin_idx, end_idx]() {
+            shard_status[shard_idx] = ExportPredictionRange(
+                predictions, task, label_column, dataspec, typed_shard_path,
+                prediction_key, format, begin_idx, end_idx);
+          });
+        }
+      }
+      for (const auto& status : shard_status) {
+        RETURN_IF_ERROR(status);
+      }
+      return absl::OkStatus();
+    }
+  }
+
   ASSIGN_OR_RETURN(auto writer, dataset::CreateExampleWriter(
                                     typed_prediction_path, dataspec,
                                     num_records_by_shard_in_output));
@@ -147,6 +147,41 @@ TEST(Evaluation, ExportPredictionsWithKeyToDataset) {
   EXPECT_EQ(csv_content, "label,key\n1,k1\n2,k2\n3,k3\n");
 }
 
+TEST(Evaluation, ExportPredictionsToShardedDataset) {
+  std::vector<model::proto::Prediction> predictions;
+  for (int prediction_idx = 0; prediction_idx < 5; prediction_idx++) {
+    model::proto::Prediction prediction;
+    prediction.mutable_regression()->set_value(prediction_idx);
+    predictions.push_back(prediction);
+  }
+
+  dataset::proto::DataSpecification dataspec = PARSE_TEST_PROTO(R"pb(
+    columns { type: NUMERICAL name: "label" }
+  )pb");
+
+  // The shards are written by parallel threads.
+  const auto prediction_path =
+      file::JoinPath(test::TmpDirectory(), "sharded_predictions.csv");
+  EXPECT_OK(ExportPredictions(predictions, model::proto::Task::REGRESSION,
+                              dataspec.columns(0),
+                              absl::StrCat("csv:", prediction_path, "@3"),
+                              /*num_records_by_shard_in_output=*/2,
+                              /*prediction_key=*/{}, PredictionFormat::kRaw));
+
+  EXPECT_EQ(file::GetContent(
+                absl::StrCat(prediction_path, "-00000-of-00003"))
+                .value(),
+            "label\n0\n1\n");
+  EXPECT_EQ(file::GetContent(
+                absl::StrCat(prediction_path, "-00001-of-00003"))
+                .value(),
+            "label\n2\n3\n");
+  EXPECT_EQ(file::GetContent(
+                absl::StrCat(prediction_path, "-00002-of-00003"))
+                .value(),
+            "label\n4\n");
+}
+
 TEST(Evaluation, ExportClassificationPredictionsToDatasetRaw) {
   std::vector<model::proto::Prediction> predictions;
   predictions.push_back(PARSE_TEST_PROTO(R"pb(
@@ -33,7 +33,9 @@
 #include "yggdrasil_decision_forests/model/abstract_model.h"
 #include "yggdrasil_decision_forests/model/abstract_model.pb.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/random.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
 
 namespace yggdrasil_decision_forests {
 namespace utils {
@@ -72,7 +74,7 @@ absl::Status ComputePermutationFeatureImportance(
         utils::StatusOr<absl::optional<metric::proto::EvaluationResults>>(
             const int feature_idx)>
         get_permutation_evaluation,
-    model::AbstractModel* model, int num_rounds) {
+    model::AbstractModel* model, int num_rounds, int num_threads) {
   const auto metrics =
       metric::DefaultMetrics(model->task(), model->label_col_spec());
 
@@ -85,18 +87,43 @@ absl::Status ComputePermutationFeatureImportance(
         metric.name));
   }
 
-  // Evaluate the impact of permuting each feature on each metric.
-  for (int feature_idx = 0; feature_idx < model->data_spec().columns_size();
-       feature_idx++) {
-    std::vector<metric::proto::EvaluationResults> permuted_evaluations;
-    for (int round_idx = 0; round_idx < num_rounds; round_idx++) {
-      ASSIGN_OR_RETURN(auto permuted_evaluation,
-                       get_permutation_evaluation(feature_idx));
-      if (!permuted_evaluation.has_value()) {
-        continue;
-      }
-      permuted_evaluations.push_back(std::move(permuted_evaluation).value());
+  // Evaluate the permuted datasets, one feature per thread.
+  const int num_features = model->data_spec().columns_size();
+  std::vector<std::vector<metric::proto::EvaluationResults>>
+      permuted_evaluations_per_feature(num_features);
+  std::vector<absl::Status> permuted_statuses(num_features);
+  {
+    utils::concurrency::ThreadPool pool(
+        "PermutationFeatureImportance",
+        std::max(1, std::min(num_threads, num_features)));
+    pool.StartWorkers();
+    for (int feature_idx = 0; feature_idx < num_features; feature_idx++) {
+      pool.Schedule([&get_permutation_evaluation,
+                     &permuted_evaluations_per_feature, &permuted_statuses,
+                     feature_idx, num_rounds]() {
+        permuted_statuses[feature_idx] = [&]() -> absl::Status {
+          auto& permuted_evaluations =
+              permuted_evaluations_per_feature[feature_idx];
+          for (int round_idx = 0; round_idx < num_rounds; round_idx++) {
+            ASSIGN_OR_RETURN(auto permuted_evaluation,
+                             get_permutation_evaluation(feature_idx));
+            if (!permuted_evaluation.has_value()) {
+              continue;
+            }
+            permuted_evaluations.push_back(
+                std::move(permuted_evaluation).value());
+          }
+          return absl::OkStatus();
+        }();
+      });
     }
+  }
+
+  // Measure the impact of permuting each feature on each metric.
+  for (int feature_idx = 0; feature_idx < num_features; feature_idx++) {
+    RETURN_IF_ERROR(permuted_statuses[feature_idx]);
+    const auto& permuted_evaluations =
+        permuted_evaluations_per_feature[feature_idx];
 
     if (permuted_evaluations.empty()) {
       // The feature is not used by the model.
@@ -146,7 +173,7 @@ absl::Status ComputePermutationFeatureImportance(
 
 absl::Status ComputePermutationFeatureImportance(
     const dataset::VerticalDataset& dataset, model::AbstractModel* model,
-    int num_rounds) {
+    int num_rounds, int num_threads) {
   utils::RandomEngine rnd_permutation_vi;
 
   // Setup the evaluation configuration.
@@ -157,6 +184,8 @@ absl::Status ComputePermutationFeatureImportance(
   const auto base_evaluation =
       model->Evaluate(dataset, eval_options, &rnd_permutation_vi);
 
+  // Protects "rnd_permutation_vi": the features are scored concurrently.
+  utils::concurrency::Mutex rnd_mutex;
   const auto permutation_evaluation = [&](const int feature_idx)
       -> absl::optional<metric::proto::EvaluationResults> {
     const auto it_input_feature =
@@ -165,14 +194,19 @@ absl::Status ComputePermutationFeatureImportance(
     if (it_input_feature == model->input_features().end()) {
       return {};
     }
-    const auto perturbed_dataset = utils::ShuffleDatasetColumns(
-        dataset, {feature_idx}, &rnd_permutation_vi);
-    return model->Evaluate(perturbed_dataset, eval_options,
-                           &rnd_permutation_vi);
+    utils::RandomEngine::result_type seed;
+    {
+      utils::concurrency::MutexLock lock(&rnd_mutex);
+      seed = rnd_permutation_vi();
+    }
+    utils::RandomEngine local_rnd(seed);
+    const auto perturbed_dataset =
+        utils::ShuffleDatasetColumns(dataset, {feature_idx}, &local_rnd);
+    return model->Evaluate(perturbed_dataset, eval_options, &local_rnd);
   };
 
   return utils::ComputePermutationFeatureImportance(
-      base_evaluation, permutation_evaluation, model, num_rounds);
+      base_evaluation, permutation_evaluation, model, num_rounds, num_threads);
 }
 
 }  // namespace utils
@@ -28,18 +28,24 @@ namespace yggdrasil_decision_forests {
 namespace utils {
 
 // Computes and adds to the model permutation feature importances.
+//
+// If "num_threads>1", the features are scored in parallel and
+// "get_permutation_evaluation" should be thread-safe.
 absl::Status ComputePermutationFeatureImportance(
     const metric::proto::EvaluationResults& base_evaluation,
     const std::function<
         utils::StatusOr<absl::optional<metric::proto::EvaluationResults>>(
             const int feature_idx)>
         get_permutation_evaluation,
-    model::AbstractModel* model, int num_rounds = 1);
+    model::AbstractModel* model, int num_rounds = 1, int num_threads = 1);
 
 // Computes and adds to the model permutation feature importances.
+//
+// The permuted datasets are evaluated with the fast serving engines (through
+// "AbstractModel::Evaluate"), "num_threads" features at a time.
 absl::Status ComputePermutationFeatureImportance(
     const dataset::VerticalDataset& dataset, model::AbstractModel* model,
-    int num_rounds = 1);
+    int num_rounds = 1, int num_threads = 1);
 
 // Builds a copy of the dataset with the values of the columns in
 // "shuffle_column_idxs" are shuffled randomly.
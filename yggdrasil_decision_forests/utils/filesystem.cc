@@ -15,15 +15,20 @@
 
 #include "yggdrasil_decision_forests/utils/filesystem.h"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "yggdrasil_decision_forests/utils/concurrency.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
 
 namespace file {
 
 yggdrasil_decision_forests::utils::StatusOr<
     std::unique_ptr<FileInputByteStream>>
-OpenInputFile(absl::string_view path) {
+OpenInputFile(absl::string_view path, const InputFileHint hint) {
   auto reader = absl::make_unique<FileInputByteStream>();
-  RETURN_IF_ERROR(reader->Open(path));
+  RETURN_IF_ERROR(reader->Open(path, hint));
   return std::move(reader);
 }
 
@@ -44,6 +49,40 @@ yggdrasil_decision_forests::utils::StatusOr<std::string> GetContent(
   return content;
 }
 
+yggdrasil_decision_forests::utils::StatusOr<std::vector<std::string>>
+BatchGetContent(const std::vector<std::string>& paths,
+                const int max_in_flight) {
+  std::vector<std::string> contents(paths.size());
+  const int num_readers =
+      std::min<int>(std::max(max_in_flight, 1), paths.size());
+  if (num_readers <= 1) {
+    for (size_t path_idx = 0; path_idx < paths.size(); path_idx++) {
+      ASSIGN_OR_RETURN(contents[path_idx], GetContent(paths[path_idx]));
+    }
+    return contents;
+  }
+  std::vector<absl::Status> statuses(paths.size());
+  {
+    yggdrasil_decision_forests::utils::concurrency::ThreadPool pool(
+        "BatchGetContent", num_readers);
+    pool.StartWorkers();
+    for (size_t path_idx = 0; path_idx < paths.size(); path_idx++) {
+      pool.Schedule([&, path_idx]() {
+        auto content_or = GetContent(paths[path_idx]);
+        if (content_or.ok()) {
+          contents[path_idx] = std::move(content_or).value();
+        } else {
+          statuses[path_idx] = content_or.status();
+        }
+      });
+    }
+  }
+  for (const auto& status : statuses) {
+    RETURN_IF_ERROR(status);
+  }
+  return contents;
+}
+
 absl::Status SetContent(absl::string_view path, absl::string_view content) {
   ASSIGN_OR_RETURN(auto file_handle, OpenOutputFile(path));
   OutputFileCloser closer(std::move(file_handle));
@@ -28,10 +28,12 @@
 
 namespace file {
 
-// Open a file for reading.
+// Open a file for reading. "hint" describes the expected access pattern (see
+// "InputFileHint"); it never changes the reading semantics.
 yggdrasil_decision_forests::utils::StatusOr<
     std::unique_ptr<FileInputByteStream>>
-OpenInputFile(absl::string_view path);
+OpenInputFile(absl::string_view path,
+              InputFileHint hint = InputFileHint::kDefault);
 
 // Open a file for writing.
 yggdrasil_decision_forests::utils::StatusOr<
@@ -42,6 +44,15 @@ OpenOutputFile(absl::string_view path);
 yggdrasil_decision_forests::utils::StatusOr<std::string> GetContent(
     absl::string_view path);
 
+// Reads the content of a set of files with up to "max_in_flight" reads in
+// flight. Equivalent to, but faster than, calling "GetContent" on each path
+// sequentially when reading many files from storage that serves concurrent
+// requests well (e.g. NVMe drives, network filesystems): each read completes
+// while the next ones are already issued. The results are in the same order
+// as "paths". Fails if any of the reads fails.
+yggdrasil_decision_forests::utils::StatusOr<std::vector<std::string>>
+BatchGetContent(const std::vector<std::string>& paths, int max_in_flight = 32);
+
 // Sets the content of a file.
 absl::Status SetContent(absl::string_view path, absl::string_view content);
 
@@ -15,6 +15,10 @@
 
 #include "yggdrasil_decision_forests/utils/filesystem_default.h"
 
+#if defined(__linux__)
+#include <fcntl.h>
+#endif
+
 #include <filesystem>
 #include <regex>  // NOLINT
 
@@ -129,12 +133,21 @@ absl::Status RecursivelyDelete(absl::string_view path, int options) {
   }
 }
 
-absl::Status FileInputByteStream::Open(absl::string_view path) {
+absl::Status FileInputByteStream::Open(absl::string_view path,
+                                       const InputFileHint hint) {
   file_ = std::fopen(std::string(path).c_str(), "rb");
   if (!file_) {
     return absl::Status(absl::StatusCode::kUnknown,
                         absl::StrCat("Failed to open ", path));
   }
+  hint_ = hint;
+#if defined(__linux__)
+  if (hint == InputFileHint::kSequentialScan) {
+    // Enable aggressive kernel read-ahead. Best effort: a failure does not
+    // impact the reading.
+    posix_fadvise(fileno(file_), 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+#endif
   return absl::OkStatus();
 }
 
@@ -157,7 +170,21 @@ ygg::utils::StatusOr<bool> FileInputByteStream::ReadExactly(char* buffer,
   return read_count > 0 || num_read == 0;
 }
 
+absl::Status FileInputByteStream::Seek(const int64_t position) {
+  if (std::fseek(file_, position, position >= 0 ? SEEK_SET : SEEK_END) != 0) {
+    return absl::Status(absl::StatusCode::kUnknown, "Failed to seek");
+  }
+  return absl::OkStatus();
+}
+
 absl::Status FileInputByteStream::Close() {
+#if defined(__linux__)
+  if (hint_ == InputFileHint::kSequentialScan) {
+    // The file was scanned once: release its pages from the page cache
+    // instead of letting them evict more valuable entries.
+    posix_fadvise(fileno(file_), 0, 0, POSIX_FADV_DONTNEED);
+  }
+#endif
   std::fclose(file_);
   return absl::OkStatus();
 }
@@ -99,18 +99,32 @@ absl::Status Rename(absl::string_view from, absl::string_view to, int options);
 // Placeholder empty function used in the "options" argument of some functions.
 constexpr int Defaults() { return 0; }
 
+// Access pattern hint for the opening of an input file. Hints never change
+// the reading semantics; backends that cannot apply a hint ignore it.
+enum class InputFileHint {
+  // No expected access pattern.
+  kDefault,
+  // The file is read once, sequentially, from beginning to end (e.g. a
+  // dataset shard scan). Enables aggressive kernel read-ahead and releases
+  // the file's pages from the page cache when the stream is closed.
+  kSequentialScan,
+};
+
 class FileInputByteStream
     : public yggdrasil_decision_forests::utils::InputByteStream {
  public:
-  absl::Status Open(absl::string_view path);
+  absl::Status Open(absl::string_view path,
+                    InputFileHint hint = InputFileHint::kDefault);
   yggdrasil_decision_forests::utils::StatusOr<int> ReadUpTo(
       char* buffer, int max_read) override;
   yggdrasil_decision_forests::utils::StatusOr<bool> ReadExactly(
       char* buffer, int num_read) override;
+  absl::Status Seek(int64_t position) override;
   absl::Status Close();
 
  private:
   std::FILE* file_;
+  InputFileHint hint_ = InputFileHint::kDefault;
 };
 
 class FileOutputByteStream
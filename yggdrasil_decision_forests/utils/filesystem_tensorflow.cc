@@ -100,10 +100,13 @@ absl::Status RecursivelyDelete(absl::string_view path, int options) {
                                                     &ignore_1, &ignore_2));
 }
 
-absl::Status FileInputByteStream::Open(absl::string_view path) {
+absl::Status FileInputByteStream::Open(absl::string_view path,
+                                       InputFileHint /*hint*/) {
   std::unique_ptr<tensorflow::RandomAccessFile> file;
   RETURN_IF_ERROR(ToUtilStatus(tensorflow::Env::Default()->NewRandomAccessFile(
       std::string(path), &file)));
+  RETURN_IF_ERROR(ToUtilStatus(
+      tensorflow::Env::Default()->GetFileSize(std::string(path), &file_size_)));
   file_ =
       absl::make_unique<tensorflow::RandomAccessFileWrapper>(file.release());
   offset_ = 0;
@@ -146,6 +149,16 @@ FileInputByteStream::ReadExactly(char* buffer, int num_read) {
   return true;
 }
 
+absl::Status FileInputByteStream::Seek(const int64_t position) {
+  const int64_t target =
+      position >= 0 ? position : static_cast<int64_t>(file_size_) + position;
+  if (target < 0 || target > static_cast<int64_t>(file_size_)) {
+    return absl::OutOfRangeError("Seek outside of the file");
+  }
+  offset_ = target;
+  return absl::OkStatus();
+}
+
 absl::Status FileInputByteStream::Close() {
   file_.reset();
   return absl::OkStatus();
@@ -119,19 +119,32 @@ absl::Status RecursivelyDelete(absl::string_view path, int options);
 // Placeholder empty function used in the "options" argument of some functions.
 constexpr int Defaults() { return 0; }
 
+// Access pattern hint for the opening of an input file. Hints never change
+// the reading semantics. This backend delegates the IO to the TensorFlow
+// filesystems and ignores the hints.
+enum class InputFileHint {
+  // No expected access pattern.
+  kDefault,
+  // The file is read once, sequentially, from beginning to end.
+  kSequentialScan,
+};
+
 class FileInputByteStream
     : public yggdrasil_decision_forests::utils::InputByteStream {
  public:
-  absl::Status Open(absl::string_view path);
+  absl::Status Open(absl::string_view path,
+                    InputFileHint hint = InputFileHint::kDefault);
   yggdrasil_decision_forests::utils::StatusOr<int> ReadUpTo(
       char* buffer, int max_read) override;
   yggdrasil_decision_forests::utils::StatusOr<bool> ReadExactly(
       char* buffer, int num_read) override;
+  absl::Status Seek(int64_t position) override;
   absl::Status Close();
 
  private:
   std::unique_ptr<tensorflow::RandomAccessFileWrapper> file_;
   uint64_t offset_ = 0;
+  uint64_t file_size_ = 0;
   std::string scrath_;
 };
 
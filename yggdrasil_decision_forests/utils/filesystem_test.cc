@@ -17,6 +17,7 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
 #include "yggdrasil_decision_forests/utils/distribution.pb.h"
 #include "yggdrasil_decision_forests/utils/test.h"
 
@@ -77,6 +78,20 @@ TEST(Filesystem, FileIO) {
   EXPECT_EQ(content, read_content_again);
 }
 
+TEST(Filesystem, FileIOSequentialScanHint) {
+  auto tmp_dir = yggdrasil_decision_forests::test::TmpDirectory();
+  auto file_path = JoinPath(tmp_dir, "my_file.txt");
+  const std::string content = "hello world";
+  EXPECT_OK(SetContent(file_path, content));
+
+  // The hint does not change the reading semantics.
+  auto input_handle =
+      OpenInputFile(file_path, InputFileHint::kSequentialScan).value();
+  auto read_content = input_handle->ReadAll().value();
+  EXPECT_OK(input_handle->Close());
+  EXPECT_EQ(content, read_content);
+}
+
 TEST(Filesystem, Override) {
   auto file_path =
       JoinPath(yggdrasil_decision_forests::test::TmpDirectory(), "file.txt");
@@ -87,6 +102,30 @@ TEST(Filesystem, Override) {
   EXPECT_EQ(GetContent(file_path).value(), "b");
 }
 
+TEST(Filesystem, BatchGetContent) {
+  auto tmp_dir = yggdrasil_decision_forests::test::TmpDirectory();
+  const int num_files = 50;
+  std::vector<std::string> paths;
+  for (int file_idx = 0; file_idx < num_files; file_idx++) {
+    paths.push_back(
+        JoinPath(tmp_dir, absl::StrCat("file_", file_idx, ".txt")));
+    EXPECT_OK(SetContent(paths.back(), absl::StrCat("content ", file_idx)));
+  }
+
+  const auto contents = BatchGetContent(paths, /*max_in_flight=*/8).value();
+  EXPECT_EQ(contents.size(), num_files);
+  for (int file_idx = 0; file_idx < num_files; file_idx++) {
+    EXPECT_EQ(contents[file_idx], absl::StrCat("content ", file_idx));
+  }
+
+  // Sequential fallback.
+  EXPECT_EQ(BatchGetContent(paths, /*max_in_flight=*/1).value(), contents);
+
+  // A missing file fails the batch.
+  paths.push_back(JoinPath(tmp_dir, "does_not_exist.txt"));
+  EXPECT_FALSE(BatchGetContent(paths).ok());
+}
+
 TEST(Filesystem, LargeContent) {
   auto file_path =
       JoinPath(yggdrasil_decision_forests::test::TmpDirectory(), "file.txt");
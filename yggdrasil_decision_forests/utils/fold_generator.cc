@@ -74,17 +74,28 @@ absl::Status GenerateFoldsTrainTest(const proto::FoldGenerator& generator,
 absl::Status GenerateFoldsCrossValidationWithoutGroups(
     const proto::FoldGenerator& generator,
     const dataset::VerticalDataset& dataset, FoldList* folds) {
-  utils::RandomEngine rnd(generator.seed());
-  std::vector<dataset::VerticalDataset::row_t> shuffled_row_indices(
-      dataset.nrow());
-  std::iota(shuffled_row_indices.begin(), shuffled_row_indices.end(), 0);
-  std::shuffle(shuffled_row_indices.begin(), shuffled_row_indices.end(), rnd);
   folds->assign(generator.cross_validation().num_folds(), Fold());
-  for (dataset::VerticalDataset::row_t row_idx = 0; row_idx < dataset.nrow();
-       row_idx++) {
-    const auto fold_idx = shuffled_row_indices[row_idx] %
-                          generator.cross_validation().num_folds();
-    (*folds)[fold_idx].push_back(row_idx);
+  if (generator.cross_validation().hashed_fold_assignment()) {
+    // The fold of each example is computed on the fly, without the shuffled
+    // index vector.
+    ASSIGN_OR_RETURN(const auto view,
+                     FoldMembershipView::Create(generator, dataset.nrow()));
+    for (dataset::VerticalDataset::row_t row_idx = 0; row_idx < dataset.nrow();
+         row_idx++) {
+      (*folds)[view.FoldOfExample(row_idx)].push_back(row_idx);
+    }
+  } else {
+    utils::RandomEngine rnd(generator.seed());
+    std::vector<dataset::VerticalDataset::row_t> shuffled_row_indices(
+        dataset.nrow());
+    std::iota(shuffled_row_indices.begin(), shuffled_row_indices.end(), 0);
+    std::shuffle(shuffled_row_indices.begin(), shuffled_row_indices.end(), rnd);
+    for (dataset::VerticalDataset::row_t row_idx = 0; row_idx < dataset.nrow();
+         row_idx++) {
+      const auto fold_idx = shuffled_row_indices[row_idx] %
+                            generator.cross_validation().num_folds();
+      (*folds)[fold_idx].push_back(row_idx);
+    }
   }
   for (const auto& fold : *folds) {
     if (fold.empty()) {
@@ -167,6 +178,10 @@ absl::Status GenerateFoldsCrossValidation(
     const proto::FoldGenerator& generator,
     const dataset::VerticalDataset& dataset, FoldList* folds) {
   if (generator.cross_validation().has_fold_group()) {
+    if (generator.cross_validation().hashed_fold_assignment()) {
+      return absl::InvalidArgumentError(
+          "\"hashed_fold_assignment\" is incompatible with \"fold_group\".");
+    }
     return GenerateFoldsCrossValidationWithGroups(generator, dataset, folds);
   } else {
     return GenerateFoldsCrossValidationWithoutGroups(generator, dataset, folds);
@@ -361,6 +376,64 @@ Fold ExtractTestExampleIndices(const proto::FoldGenerator& generator,
   return testing_indices;
 }
 
+utils::StatusOr<FoldMembershipView> FoldMembershipView::Create(
+    const proto::FoldGenerator& generator,
+    const dataset::VerticalDataset::row_t num_rows) {
+  switch (generator.generator_case()) {
+    case proto::FoldGenerator::GeneratorCase::kCrossValidation:
+    // By default, we performs a cross-validation.
+    case proto::FoldGenerator::GeneratorCase::GENERATOR_NOT_SET:
+      break;
+    default:
+      return absl::InvalidArgumentError(
+          "A fold membership view requires a cross-validation fold "
+          "generator.");
+  }
+  if (generator.cross_validation().has_fold_group()) {
+    return absl::InvalidArgumentError(
+        "A fold membership view does not support fold groups.");
+  }
+  const int num_folds = generator.cross_validation().num_folds();
+  if (num_folds < 2) {
+    return absl::InvalidArgumentError(
+        "At least two folds should be provided for a cross-validation.");
+  }
+  if (num_rows < num_folds) {
+    return absl::InvalidArgumentError(
+        "The dataset does not have enough examples.");
+  }
+  return FoldMembershipView(static_cast<uint64_t>(generator.seed()), num_folds,
+                            num_rows);
+}
+
+Fold FoldMembershipView::TestIndices(const int fold_idx) const {
+  DCHECK_GE(fold_idx, 0);
+  DCHECK_LT(fold_idx, num_folds_);
+  Fold fold;
+  fold.reserve(num_rows_ / num_folds_ + 1);
+  for (dataset::VerticalDataset::row_t row_idx = 0; row_idx < num_rows_;
+       row_idx++) {
+    if (FoldOfExample(row_idx) == fold_idx) {
+      fold.push_back(row_idx);
+    }
+  }
+  return fold;
+}
+
+Fold FoldMembershipView::TrainingIndices(const int fold_idx) const {
+  DCHECK_GE(fold_idx, 0);
+  DCHECK_LT(fold_idx, num_folds_);
+  Fold fold;
+  fold.reserve(num_rows_ - num_rows_ / num_folds_);
+  for (dataset::VerticalDataset::row_t row_idx = 0; row_idx < num_rows_;
+       row_idx++) {
+    if (FoldOfExample(row_idx) != fold_idx) {
+      fold.push_back(row_idx);
+    }
+  }
+  return fold;
+}
+
 absl::Status ExportFoldsToCsv(const FoldList& folds, absl::string_view path) {
   ASSIGN_OR_RETURN(auto file_handle, file::OpenOutputFile(path));
   file::OutputFileCloser closer(std::move(file_handle));
@@ -21,6 +21,7 @@
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/dataset/vertical_dataset.h"
 #include "yggdrasil_decision_forests/utils/fold_generator.pb.h"
+#include "yggdrasil_decision_forests/utils/random.h"
 
 namespace yggdrasil_decision_forests {
 namespace utils {
@@ -68,6 +69,45 @@ Fold ExtractTestExampleIndices(const proto::FoldGenerator& generator,
                                const utils::FoldList& folds,
                                bool ensure_sorted);
 
+// Stateless view over the folds of a cross-validation without groups. The
+// fold of each example is computed on the fly by mixing the generator seed
+// and the example index: the view uses constant memory regardless of the
+// dataset size, unlike a "FoldList" which stores all the example indices.
+// Requires "hashed_fold_assignment" semantics i.e., for a given seed, the
+// fold composition matches "GenerateFolds" with "hashed_fold_assignment" set,
+// and differs from the default shuffled assignment.
+class FoldMembershipView {
+ public:
+  // Creates a view. Fails if the generator is not a cross-validation without
+  // groups, or if the dataset is too small.
+  static utils::StatusOr<FoldMembershipView> Create(
+      const proto::FoldGenerator& generator,
+      dataset::VerticalDataset::row_t num_rows);
+
+  int num_folds() const { return num_folds_; }
+  dataset::VerticalDataset::row_t num_rows() const { return num_rows_; }
+
+  // Fold containing the example. Computed in constant time, with no
+  // per-example storage.
+  int FoldOfExample(const dataset::VerticalDataset::row_t row_idx) const {
+    return static_cast<int>(DeriveSeed(seed_, row_idx) % num_folds_);
+  }
+
+  // Materializes the sorted test (resp. training) example indices of a fold,
+  // for the consumers that require an explicit index vector.
+  Fold TestIndices(int fold_idx) const;
+  Fold TrainingIndices(int fold_idx) const;
+
+ private:
+  FoldMembershipView(const uint64_t seed, const int num_folds,
+                     const dataset::VerticalDataset::row_t num_rows)
+      : seed_(seed), num_folds_(num_folds), num_rows_(num_rows) {}
+
+  uint64_t seed_;
+  int num_folds_;
+  dataset::VerticalDataset::row_t num_rows_;
+};
+
 // Exports the folds in a csv file.
 //
 // The created csv file has a single column, a header ("fold_idx"). The fold
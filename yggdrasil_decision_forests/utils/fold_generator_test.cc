@@ -165,6 +165,37 @@ TEST_F(FoldGenerator, CrossValidation) {
   CheckFoldValidity();
 }
 
+TEST_F(FoldGenerator, CrossValidationHashedAssignment) {
+  generator_.mutable_cross_validation()->set_num_folds(10);
+  generator_.mutable_cross_validation()->set_hashed_fold_assignment(true);
+  EXPECT_EQ(NumberOfFolds(generator_, folds_), 10);
+  EXPECT_OK(GenerateFolds());
+  EXPECT_EQ(folds_.size(), 10);
+  CheckFoldValidity();
+
+  // The view agrees with the materialized folds.
+  const auto view =
+      FoldMembershipView::Create(generator_, dataset_.nrow()).value();
+  EXPECT_EQ(view.num_folds(), 10);
+  for (int fold_idx = 0; fold_idx < folds_.size(); fold_idx++) {
+    EXPECT_EQ(view.TestIndices(fold_idx), folds_[fold_idx]);
+    auto expected_training = MergeIndicesExceptOneFold(folds_, fold_idx);
+    std::sort(expected_training.begin(), expected_training.end());
+    EXPECT_EQ(view.TrainingIndices(fold_idx), expected_training);
+  }
+}
+
+// The hashed assignment cannot be combined with fold groups.
+TEST_F(FoldGenerator, CrossValidationHashedAssignmentWithGroupFails) {
+  generator_.mutable_cross_validation()->set_num_folds(10);
+  generator_.mutable_cross_validation()->set_hashed_fold_assignment(true);
+  generator_.mutable_cross_validation()
+      ->mutable_fold_group()
+      ->set_group_attribute("education");
+  EXPECT_THAT(GenerateFolds().status(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 // Fold grouping on the "education" attribute.
 TEST_F(FoldGenerator, CrossValidationCategoricalGroup) {
   generator_.mutable_cross_validation()->set_num_folds(10);
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/instrument.h"
+
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include "yggdrasil_decision_forests/utils/logging.h"
+#include "yggdrasil_decision_forests/utils/synchronization_primitives.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+namespace instrument {
+namespace {
+
+// Registry of all the counters and span statistics. The std::map keeps the
+// export sorted by name and, being node based, guarantees that the Counter
+// pointers remain stable.
+struct Registry {
+  Mutex mutex;
+  std::map<std::string, std::unique_ptr<Counter>> counters GUARDED_BY(mutex);
+  std::map<std::string, std::unique_ptr<Counter>> spans GUARDED_BY(mutex);
+};
+
+Registry& GlobalRegistry() {
+  static Registry* const registry = new Registry();
+  return *registry;
+}
+
+Counter* GetOrCreate(std::map<std::string, std::unique_ptr<Counter>>* items,
+                     const absl::string_view name) {
+  auto& item = (*items)[std::string(name)];
+  if (!item) {
+    item = std::unique_ptr<Counter>(new Counter());
+  }
+  return item.get();
+}
+
+void ExportEntries(
+    const std::map<std::string, std::unique_ptr<Counter>>& items,
+    google::protobuf::RepeatedPtrField<proto::Profile::Entry>* entries) {
+  for (const auto& item : items) {
+    auto* entry = entries->Add();
+    entry->set_name(item.first);
+    entry->set_count(item.second->count());
+    entry->set_sum(item.second->sum());
+    entry->set_max(item.second->max());
+  }
+}
+
+}  // namespace
+
+Counter* GetCounter(const absl::string_view name) {
+  auto& registry = GlobalRegistry();
+  MutexLock lock(&registry.mutex);
+  return GetOrCreate(&registry.counters, name);
+}
+
+Counter* GetSpanStats(const absl::string_view name) {
+  auto& registry = GlobalRegistry();
+  MutexLock lock(&registry.mutex);
+  return GetOrCreate(&registry.spans, name);
+}
+
+proto::Profile ExportProfile() {
+  auto& registry = GlobalRegistry();
+  MutexLock lock(&registry.mutex);
+  proto::Profile profile;
+  ExportEntries(registry.counters, profile.mutable_counters());
+  ExportEntries(registry.spans, profile.mutable_spans());
+  return profile;
+}
+
+void ResetProfile() {
+  auto& registry = GlobalRegistry();
+  MutexLock lock(&registry.mutex);
+  for (auto& counter : registry.counters) {
+    counter.second->Reset();
+  }
+  for (auto& span : registry.spans) {
+    span.second->Reset();
+  }
+}
+
+int64_t CurrentRSSBytes() {
+#if defined(__linux__)
+  std::FILE* file = std::fopen("/proc/self/statm", "r");
+  if (file == nullptr) {
+    return -1;
+  }
+  // Second field of statm: resident set size in pages.
+  long long num_pages;
+  const int num_read = std::fscanf(file, "%*lld %lld", &num_pages);
+  std::fclose(file);
+  if (num_read != 1) {
+    return -1;
+  }
+  return num_pages * sysconf(_SC_PAGESIZE);
+#else
+  return -1;
+#endif
+}
+
+int64_t PeakRSSBytes() {
+#if defined(__linux__)
+  std::FILE* file = std::fopen("/proc/self/status", "r");
+  if (file == nullptr) {
+    return -1;
+  }
+  int64_t peak = -1;
+  char line[128];
+  while (std::fgets(line, sizeof(line), file) != nullptr) {
+    long long value_kb;
+    if (std::sscanf(line, "VmHWM: %lld kB", &value_kb) == 1) {
+      peak = value_kb * 1024;
+      break;
+    }
+  }
+  std::fclose(file);
+  return peak;
+#else
+  return -1;
+#endif
+}
+
+void ResetPeakRSSBytes() {
+#if defined(__linux__)
+  std::FILE* file = std::fopen("/proc/self/clear_refs", "w");
+  if (file == nullptr) {
+    return;
+  }
+  // "5" resets the peak-RSS watermark (VmHWM) of the process.
+  std::fputs("5", file);
+  std::fclose(file);
+#endif
+}
+
+ScopedMemoryPhase::ScopedMemoryPhase(const absl::string_view name,
+                                     Counter* stats)
+    : name_(name), stats_(stats), rss_at_entry_(CurrentRSSBytes()) {
+  ResetPeakRSSBytes();
+}
+
+ScopedMemoryPhase::~ScopedMemoryPhase() {
+  const int64_t peak = PeakRSSBytes();
+  if (peak < 0) {
+    // Peak RSS is not available on this platform.
+    return;
+  }
+  stats_->Add(peak);
+  LOG(INFO) << "Memory of phase \"" << name_ << "\": peak rss "
+            << (peak >> 20) << "MB (rss at entry " << (rss_at_entry_ >> 20)
+            << "MB)";
+}
+
+}  // namespace instrument
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Lightweight performance instrumentation: atomic counters and scoped trace
+// spans, aggregated in a global registry and exported as a proto profile.
+//
+// Usage example:
+//
+//   void MyHotFunction(const std::vector<int>& items) {
+//     YDF_INSTRUMENT_SPAN("my_module.my_function");
+//     ...
+//     YDF_INSTRUMENT_COUNTER("my_module.num_items", items.size());
+//   }
+//
+//   // At the start of a training / serving session.
+//   utils::instrument::ResetProfile();
+//   ...
+//   // At the end of the session.
+//   LOG(INFO) << utils::instrument::ExportProfile().DebugString();
+//
+// When enabled, a counter update costs two relaxed atomic additions and a
+// relaxed running-maximum update, and a span adds one steady clock read at
+// entry and one at exit; the registry
+// lookup happens once per call site. The instrumentation compiles to nothing
+// if YGG_DISABLE_INSTRUMENTATION is defined.
+
+#ifndef YGGDRASIL_DECISION_FORESTS_UTILS_INSTRUMENT_H_
+#define YGGDRASIL_DECISION_FORESTS_UTILS_INSTRUMENT_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/utils/instrument.pb.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+namespace instrument {
+
+// Number of events, sum and maximum of event values. Thread safe.
+class Counter {
+ public:
+  void Add(const int64_t value) {
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    int64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max &&
+           !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  int64_t count() const { return count_.load(std::memory_order_relaxed); }
+  int64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+  int64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+  void Reset() {
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<int64_t> count_{0};
+  std::atomic<int64_t> sum_{0};
+  std::atomic<int64_t> max_{0};
+};
+
+// Returns the counter (resp. the span statistics) registered under "name",
+// creating it on the first call. The returned pointer is stable for the
+// lifetime of the process: the YDF_INSTRUMENT_* macros cache it in a static
+// local variable so the registry is only locked once per call site.
+Counter* GetCounter(absl::string_view name);
+Counter* GetSpanStats(absl::string_view name);
+
+// Exports all the counters and span statistics. The entries are sorted by
+// name.
+proto::Profile ExportProfile();
+
+// Resets all the counters and span statistics to zero. Call at the start of a
+// session to get a per-session profile.
+void ResetProfile();
+
+// Resident set size (RSS) of the process in bytes, or -1 if not available on
+// this platform (only implemented on Linux).
+int64_t CurrentRSSBytes();
+
+// Peak RSS of the process in bytes since the process start or since the last
+// call to "ResetPeakRSSBytes", or -1 if not available on this platform.
+int64_t PeakRSSBytes();
+
+// Resets the kernel peak-RSS watermark so that "PeakRSSBytes" reports the
+// peak of the following code. No-op on non-Linux platforms.
+void ResetPeakRSSBytes();
+
+// Adds the time between its construction and its destruction to a span
+// statistics counter. Use through YDF_INSTRUMENT_SPAN.
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(Counter* stats)
+      : stats_(stats), begin_(std::chrono::steady_clock::now()) {}
+
+  ~ScopedSpan() {
+    stats_->Add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - begin_)
+                    .count());
+  }
+
+ private:
+  Counter* stats_;
+  std::chrono::steady_clock::time_point begin_;
+};
+
+// Attributes the peak RSS reached in the enclosing scope to a named training
+// phase: the peak-RSS watermark is reset at entry; at exit, the peak is
+// recorded in the phase counter ("max" is the peak over all the executions of
+// the phase) and written to the log with the RSS at entry. Use through
+// YDF_INSTRUMENT_MEMORY_PHASE.
+//
+// The watermark is process global: if two phases overlap, each reports the
+// peak of the process over its lifetime. Use on the sequential, top-level
+// phases of a job (dataset loading, pre-sorting, per-tree training).
+class ScopedMemoryPhase {
+ public:
+  ScopedMemoryPhase(absl::string_view name, Counter* stats);
+  ~ScopedMemoryPhase();
+
+ private:
+  absl::string_view name_;
+  Counter* stats_;
+  int64_t rss_at_entry_;
+};
+
+}  // namespace instrument
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
+
+#define YDF_INSTRUMENT_INTERNAL_CONCAT2(x, y) x##y
+#define YDF_INSTRUMENT_INTERNAL_CONCAT(x, y) \
+  YDF_INSTRUMENT_INTERNAL_CONCAT2(x, y)
+
+#ifndef YGG_DISABLE_INSTRUMENTATION
+
+// Adds "value" to the counter "name". "name" should be a string literal.
+#define YDF_INSTRUMENT_COUNTER(name, value)                                  \
+  do {                                                                       \
+    static ::yggdrasil_decision_forests::utils::instrument::Counter* const  \
+        ydf_instrument_counter =                                             \
+            ::yggdrasil_decision_forests::utils::instrument::GetCounter(    \
+                name);                                                       \
+    ydf_instrument_counter->Add(value);                                      \
+  } while (false)
+
+// Records the time spent in the enclosing scope under the span "name".
+// "name" should be a string literal.
+#define YDF_INSTRUMENT_SPAN(name)                                            \
+  static ::yggdrasil_decision_forests::utils::instrument::Counter* const    \
+      YDF_INSTRUMENT_INTERNAL_CONCAT(ydf_instrument_span_stats_, __LINE__) = \
+          ::yggdrasil_decision_forests::utils::instrument::GetSpanStats(    \
+              name);                                                         \
+  ::yggdrasil_decision_forests::utils::instrument::ScopedSpan               \
+      YDF_INSTRUMENT_INTERNAL_CONCAT(ydf_instrument_span_, __LINE__)(       \
+          YDF_INSTRUMENT_INTERNAL_CONCAT(ydf_instrument_span_stats_,        \
+                                         __LINE__))
+
+// Records and logs the peak RSS reached in the enclosing scope under the
+// counter "name.peak_rss_bytes" (see ScopedMemoryPhase). "name" should be a
+// string literal.
+#define YDF_INSTRUMENT_MEMORY_PHASE(name)                                    \
+  static ::yggdrasil_decision_forests::utils::instrument::Counter* const    \
+      YDF_INSTRUMENT_INTERNAL_CONCAT(ydf_instrument_mem_stats_, __LINE__) =  \
+          ::yggdrasil_decision_forests::utils::instrument::GetCounter(      \
+              name ".peak_rss_bytes");                                       \
+  ::yggdrasil_decision_forests::utils::instrument::ScopedMemoryPhase        \
+      YDF_INSTRUMENT_INTERNAL_CONCAT(ydf_instrument_mem_phase_, __LINE__)(  \
+          name, YDF_INSTRUMENT_INTERNAL_CONCAT(ydf_instrument_mem_stats_,   \
+                                               __LINE__))
+
+#else  // YGG_DISABLE_INSTRUMENTATION
+
+#define YDF_INSTRUMENT_COUNTER(name, value) \
+  do {                                      \
+  } while (false)
+#define YDF_INSTRUMENT_SPAN(name)
+#define YDF_INSTRUMENT_MEMORY_PHASE(name)
+
+#endif  // YGG_DISABLE_INSTRUMENTATION
+
+#endif  // YGGDRASIL_DECISION_FORESTS_UTILS_INSTRUMENT_H_
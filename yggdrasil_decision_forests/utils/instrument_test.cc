@@ -0,0 +1,103 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/instrument.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+namespace instrument {
+namespace {
+
+void InstrumentedFunction(const int num_items) {
+  YDF_INSTRUMENT_SPAN("test.function");
+  YDF_INSTRUMENT_COUNTER("test.num_items", num_items);
+}
+
+TEST(Instrument, CounterAndSpan) {
+  ResetProfile();
+  InstrumentedFunction(3);
+  InstrumentedFunction(5);
+
+  const auto profile = ExportProfile();
+
+  const Counter* counter = GetCounter("test.num_items");
+  EXPECT_EQ(counter->count(), 2);
+  EXPECT_EQ(counter->sum(), 8);
+  EXPECT_EQ(counter->max(), 5);
+
+  const Counter* span = GetSpanStats("test.function");
+  EXPECT_EQ(span->count(), 2);
+  EXPECT_GE(span->sum(), 0);
+
+  bool found_counter = false;
+  for (const auto& entry : profile.counters()) {
+    if (entry.name() == "test.num_items") {
+      EXPECT_EQ(entry.count(), 2);
+      EXPECT_EQ(entry.sum(), 8);
+      found_counter = true;
+    }
+  }
+  EXPECT_TRUE(found_counter);
+
+  bool found_span = false;
+  for (const auto& entry : profile.spans()) {
+    if (entry.name() == "test.function") {
+      EXPECT_EQ(entry.count(), 2);
+      found_span = true;
+    }
+  }
+  EXPECT_TRUE(found_span);
+}
+
+TEST(Instrument, Reset) {
+  InstrumentedFunction(3);
+  ResetProfile();
+  EXPECT_EQ(GetCounter("test.num_items")->count(), 0);
+  EXPECT_EQ(GetSpanStats("test.function")->count(), 0);
+}
+
+TEST(Instrument, StablePointers) {
+  Counter* counter = GetCounter("test.stable");
+  counter->Add(1);
+  EXPECT_EQ(GetCounter("test.stable"), counter);
+}
+
+TEST(Instrument, MemoryPhase) {
+  ResetProfile();
+  {
+    YDF_INSTRUMENT_MEMORY_PHASE("test.memory_phase");
+    // Allocate 16MB to move the peak RSS watermark.
+    std::vector<char> buffer(16 * 1024 * 1024);
+    std::fill(buffer.begin(), buffer.end(), 1);
+  }
+  if (CurrentRSSBytes() < 0) {
+    // Memory instrumentation is not available on this platform.
+    return;
+  }
+  const Counter* counter = GetCounter("test.memory_phase.peak_rss_bytes");
+  EXPECT_EQ(counter->count(), 1);
+  EXPECT_GE(counter->max(), 16 * 1024 * 1024);
+}
+
+}  // namespace
+}  // namespace instrument
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
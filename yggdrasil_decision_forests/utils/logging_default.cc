@@ -15,6 +15,15 @@
 
 #include "yggdrasil_decision_forests/utils/logging_default.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
 #include "absl/flags/usage.h"
@@ -22,7 +31,125 @@
 namespace yggdrasil_decision_forests {
 namespace logging {
 int logging_level = 2;
+
+namespace {
+
+// Maximum number of pending messages of the asynchronous sink. When the
+// queue is full (e.g. stderr is a stalled pipe), new messages are dropped.
+constexpr size_t kMaxPendingMessages = 4096;
+
+// Serializes the writes to std::clog. Never destroyed: log messages can be
+// emitted during the program tear-down.
+std::mutex& ClogMutex() {
+  static std::mutex* mutex = new std::mutex();
+  return *mutex;
+}
+
+// Bounded log message queue drained to std::clog by a dedicated thread.
+class AsyncLogSink {
+ public:
+  AsyncLogSink() : thread_(&AsyncLogSink::Loop, this) {}
+
+  // Queues a log line. Drops it (and counts the drop) if the queue is full.
+  void Emit(std::string line) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (queue_.size() >= kMaxPendingMessages) {
+        // The drain thread reports the number of dropped messages.
+        num_dropped_++;
+        return;
+      }
+      queue_.push_back(std::move(line));
+    }
+    has_work_.notify_one();
+  }
+
+  // Blocks until all the queued lines are written.
+  void Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    drained_.wait(lock, [&] { return queue_.empty() && !writing_; });
+  }
+
+ private:
+  void Loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      has_work_.wait(lock, [&] { return !queue_.empty(); });
+      // Steal the whole queue and write it without holding the lock.
+      std::deque<std::string> batch;
+      batch.swap(queue_);
+      const size_t num_dropped = num_dropped_;
+      num_dropped_ = 0;
+      writing_ = true;
+      lock.unlock();
+      {
+        std::lock_guard<std::mutex> clog_lock(ClogMutex());
+        for (const auto& line : batch) {
+          std::clog << line << "\n";
+        }
+        if (num_dropped > 0) {
+          std::clog << "[WARNING logging] " << num_dropped
+                    << " log messages dropped (queue overload)\n";
+        }
+        std::clog.flush();
+      }
+      lock.lock();
+      writing_ = false;
+      drained_.notify_all();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable has_work_;
+  std::condition_variable drained_;
+  std::deque<std::string> queue_;
+  size_t num_dropped_ = 0;
+  bool writing_ = false;
+  // Last field: the drain thread uses the fields above.
+  std::thread thread_;
+};
+
+// The sink (and its thread) is created on the first use and never destroyed:
+// it can be draining messages when the program exits.
+AsyncLogSink& Sink() {
+  static AsyncLogSink* sink = new AsyncLogSink();
+  return *sink;
 }
+
+std::atomic<bool> async_logging{false};
+
+}  // namespace
+
+void SetAsyncLogging(const bool enabled) {
+  if (enabled) {
+    Sink();  // Start the drain thread before publishing the flag.
+  }
+  const bool was_enabled = async_logging.exchange(enabled);
+  if (was_enabled && !enabled) {
+    Sink().Flush();
+  }
+}
+
+void FlushLogging() {
+  if (async_logging.load()) {
+    Sink().Flush();
+  }
+}
+
+namespace internal {
+
+void EmitLogLine(std::string line) {
+  if (async_logging.load(std::memory_order_relaxed)) {
+    Sink().Emit(std::move(line));
+    return;
+  }
+  std::lock_guard<std::mutex> lock(ClogMutex());
+  std::clog << line << std::endl;
+}
+
+}  // namespace internal
+
+}  // namespace logging
 }  // namespace yggdrasil_decision_forests
 
 ABSL_FLAG(bool, alsologtostderr, true,
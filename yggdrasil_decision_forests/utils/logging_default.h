@@ -20,6 +20,8 @@
 #define YGGDRASIL_DECISION_FORESTS_UTILS_LOGGING_DEFAULT_H_
 
 #include <iostream>
+#include <sstream>
+#include <string>
 
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
@@ -57,6 +59,28 @@ extern int logging_level;
 // 2: Info, warning and fatal i.e. all logging. Default.
 inline void SetLoggingLevel(int level) { logging_level = level; }
 
+// If enabled, the log messages are pushed to a bounded in-memory queue and
+// written to std::clog by a dedicated thread: logging in a hot path costs a
+// queue push instead of a write to a possibly slow stderr (e.g. a stalled
+// pipe). Under overload (full queue), new messages are dropped and the drop
+// count is reported in the log. Messages emitted just before the program
+// exits can be lost; call "FlushLogging" (or disable the asynchronous
+// logging, which flushes) before exiting. Disabled by default: messages are
+// then written synchronously.
+void SetAsyncLogging(bool enabled);
+
+// Blocks until all the log messages emitted so far are written. No-op if the
+// asynchronous logging is disabled.
+void FlushLogging();
+
+namespace internal {
+
+// Writes a formatted log line to std::clog, directly or through the
+// asynchronous sink (see "SetAsyncLogging").
+void EmitLogLine(std::string line);
+
+}  // namespace internal
+
 // Tests if a given logging level should be visible.
 inline bool IsLoggingEnabled(Severity severity) {
 #ifdef YDF_ALWAYS_LOG
@@ -180,6 +204,10 @@ inline absl::string_view ExtractFilename(absl::string_view path) {
   return path.substr(last_sep + 1);
 }
 
+// A log message is accumulated in a local buffer and emitted as a whole line
+// when the message object is destroyed: messages from concurrent threads are
+// never interleaved, and the (possibly asynchronous, see "SetAsyncLogging")
+// emission is a single call.
 class LogMessage {
  public:
   LogMessage(Severity sev, absl::string_view file, int line) : sev_(sev) {
@@ -187,29 +215,29 @@ class LogMessage {
       return;
     }
 
-    std::clog << "[";
+    stream_ << "[";
     switch (sev) {
       case INFO:
-        std::clog << "INFO";
+        stream_ << "INFO";
         break;
       case WARNING:
-        std::clog << "WARNING";
+        stream_ << "WARNING";
         break;
       case FATAL:
-        std::clog << "FATAL";
+        stream_ << "FATAL";
         break;
       default:
-        std::clog << "UNDEF";
+        stream_ << "UNDEF";
         break;
     }
-    std::clog << " " << ExtractFilename(file) << ":" << line << "] ";
+    stream_ << " " << ExtractFilename(file) << ":" << line << "] ";
   }
 
   virtual ~LogMessage() {
     if (!yggdrasil_decision_forests::logging::IsLoggingEnabled(sev_)) {
       return;
     }
-    std::clog << std::endl;
+    yggdrasil_decision_forests::logging::internal::EmitLogLine(stream_.str());
   }
 
   template <typename T>
@@ -217,12 +245,13 @@ class LogMessage {
     if (!yggdrasil_decision_forests::logging::IsLoggingEnabled(sev_)) {
       return *this;
     }
-    std::clog << v;
+    stream_ << v;
     return *this;
   }
 
  protected:
   Severity sev_;
+  std::ostringstream stream_;
 };
 
 class FatalLogMessage : public LogMessage {
@@ -230,11 +259,14 @@ class FatalLogMessage : public LogMessage {
   FatalLogMessage(absl::string_view file, int line)
       : LogMessage(FATAL, file, line) {}
 
+  // Note: "std::exit" prevents the base destructor from emitting the message
+  // a second time.
   [[noreturn]] ~FatalLogMessage() {
     if (yggdrasil_decision_forests::logging::IsLoggingEnabled(sev_)) {
-      std::clog << std::endl;
-      std::clog.flush();
+      yggdrasil_decision_forests::logging::internal::EmitLogLine(
+          stream_.str());
     }
+    yggdrasil_decision_forests::logging::FlushLogging();
     std::exit(1);
   }
 };
@@ -24,6 +24,16 @@ namespace {
 
 TEST(Logging, LogInfo) { LOG(INFO) << "Hello world"; }
 
+TEST(Logging, AsyncLogging) {
+  logging::SetAsyncLogging(true);
+  for (int i = 0; i < 100; i++) {
+    LOG(INFO) << "Async hello " << i;
+  }
+  logging::FlushLogging();
+  logging::SetAsyncLogging(false);
+  LOG(INFO) << "Sync hello";
+}
+
 }  // namespace
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
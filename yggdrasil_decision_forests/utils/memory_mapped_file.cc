@@ -0,0 +1,89 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/memory_mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define YDF_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/strings/substitute.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+
+MemoryMappedFile::~MemoryMappedFile() {
+  // Errors in the destructor are ignored: the mapping is read-only.
+  Close().IgnoreError();
+}
+
+utils::StatusOr<bool> MemoryMappedFile::TryOpen(const absl::string_view path) {
+#ifdef YDF_USE_MMAP
+  const std::string filename(path);
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    // The path is not accessible with the posix API (e.g. remote file
+    // system).
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    close(fd);
+    return false;
+  }
+  size_ = file_stat.st_size;
+  if (size_ == 0) {
+    // Mapping an empty file is not allowed.
+    close(fd);
+    return true;
+  }
+  void* const mapping = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping retains the file content independently of the descriptor.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return absl::InvalidArgumentError(
+        absl::Substitute("Cannot memory map $0", path));
+  }
+  data_ = reinterpret_cast<const char*>(mapping);
+  return true;
+#else
+  return false;
+#endif
+}
+
+absl::Status MemoryMappedFile::Close() {
+#ifdef YDF_USE_MMAP
+  if (data_ != nullptr && size_ > 0) {
+    if (munmap(const_cast<char*>(data_), size_) == -1) {
+      data_ = nullptr;
+      size_ = 0;
+      return absl::InternalError("Cannot unmap file");
+    }
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  return absl::OkStatus();
+}
+
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef YGGDRASIL_DECISION_FORESTS_UTILS_MEMORY_MAPPED_FILE_H_
+#define YGGDRASIL_DECISION_FORESTS_UTILS_MEMORY_MAPPED_FILE_H_
+
+#include <stddef.h>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+
+// Read-only memory mapping of an immutable file.
+//
+// Because the mapping is backed by the page cache, re-reading a file already
+// read by this or another process (e.g. after a load-balancer rebalance or a
+// worker restart) does not copy the data again.
+class MemoryMappedFile {
+ public:
+  ~MemoryMappedFile();
+
+  // Tries to map the file. Returns false if memory mapping is not available
+  // for this path (e.g. non-local file system) or platform. In this case, the
+  // caller should fall back to stream reads.
+  utils::StatusOr<bool> TryOpen(absl::string_view path);
+
+  // Mapped file content. Only valid if "TryOpen" returned true.
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  absl::Status Close();
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_UTILS_MEMORY_MAPPED_FILE_H_
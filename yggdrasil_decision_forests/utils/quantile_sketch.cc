@@ -0,0 +1,201 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/quantile_sketch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+
+QuantileSketch::QuantileSketch(const int max_entries)
+    : max_entries_(std::max(max_entries, 2)) {
+  buffer_.reserve(max_entries_);
+}
+
+QuantileSketch QuantileSketch::FromEntries(const int max_entries,
+                                           std::vector<Entry> entries) {
+  QuantileSketch sketch(max_entries);
+  sketch.entries_ = std::move(entries);
+  if (!sketch.entries_.empty()) {
+    // The last tuple is the maximum value: its maximum rank is the total
+    // weight of the stream.
+    sketch.total_weight_ = sketch.entries_.back().max_rank;
+  }
+  return sketch;
+}
+
+void QuantileSketch::Add(const float value, const double weight) {
+  total_weight_ += weight;
+  buffer_.emplace_back(value, weight);
+  if (buffer_.size() >= static_cast<size_t>(max_entries_)) {
+    Flush();
+  }
+}
+
+void QuantileSketch::Merge(QuantileSketch other) {
+  Flush();
+  other.Flush();
+  if (other.entries_.empty()) {
+    return;
+  }
+  total_weight_ += other.total_weight_;
+  if (entries_.empty()) {
+    entries_ = std::move(other.entries_);
+  } else {
+    entries_ = MergeSummaries(entries_, other.entries_);
+  }
+  Prune();
+}
+
+utils::StatusOr<float> QuantileSketch::Quantile(const double q) {
+  Flush();
+  if (entries_.empty()) {
+    return absl::InvalidArgumentError(
+        "Cannot query the quantiles of an empty sketch.");
+  }
+  const double target = q * entries_.back().max_rank;
+  for (const auto& entry : entries_) {
+    if ((entry.min_rank + entry.max_rank) / 2 >= target) {
+      return entry.value;
+    }
+  }
+  return entries_.back().value;
+}
+
+const std::vector<QuantileSketch::Entry>& QuantileSketch::entries() {
+  Flush();
+  return entries_;
+}
+
+void QuantileSketch::Flush() {
+  if (buffer_.empty()) {
+    return;
+  }
+  std::sort(buffer_.begin(), buffer_.end());
+
+  // Exact summary of the buffered values. Equal values are combined and the
+  // ranks are the cumulative weights.
+  std::vector<Entry> buffer_summary;
+  double cum_weight = 0;
+  for (size_t item_idx = 0; item_idx < buffer_.size(); item_idx++) {
+    double weight = buffer_[item_idx].second;
+    while (item_idx + 1 < buffer_.size() &&
+           buffer_[item_idx + 1].first == buffer_[item_idx].first) {
+      item_idx++;
+      weight += buffer_[item_idx].second;
+    }
+    buffer_summary.push_back(
+        {buffer_[item_idx].first, cum_weight, cum_weight + weight, weight});
+    cum_weight += weight;
+  }
+  buffer_.clear();
+
+  if (entries_.empty()) {
+    entries_ = std::move(buffer_summary);
+  } else {
+    entries_ = MergeSummaries(entries_, buffer_summary);
+  }
+  Prune();
+}
+
+std::vector<QuantileSketch::Entry> QuantileSketch::MergeSummaries(
+    const std::vector<Entry>& a, const std::vector<Entry>& b) {
+  // For a tuple of one summary, the rank bounds of the other summary are
+  // interpolated from its surrounding tuples.
+  std::vector<Entry> merged;
+  merged.reserve(a.size() + b.size());
+  size_t a_idx = 0;
+  size_t b_idx = 0;
+  const auto merge_one = [&merged](const Entry& entry,
+                                   const std::vector<Entry>& other,
+                                   const size_t other_idx) {
+    // All the tuples of "other" before "other_idx" have smaller values, all
+    // the tuples from "other_idx" have greater values.
+    const double other_min_rank =
+        (other_idx > 0) ? other[other_idx - 1].min_rank +
+                              other[other_idx - 1].weight
+                        : 0;
+    const double other_max_rank = (other_idx < other.size())
+                                      ? other[other_idx].max_rank -
+                                            other[other_idx].weight
+                                      : (other.empty() ? 0
+                                                       : other.back().max_rank);
+    merged.push_back({entry.value, entry.min_rank + other_min_rank,
+                      entry.max_rank + other_max_rank, entry.weight});
+  };
+  while (a_idx < a.size() || b_idx < b.size()) {
+    if (a_idx < a.size() && b_idx < b.size() &&
+        a[a_idx].value == b[b_idx].value) {
+      merged.push_back({a[a_idx].value, a[a_idx].min_rank + b[b_idx].min_rank,
+                        a[a_idx].max_rank + b[b_idx].max_rank,
+                        a[a_idx].weight + b[b_idx].weight});
+      a_idx++;
+      b_idx++;
+    } else if (b_idx >= b.size() ||
+               (a_idx < a.size() && a[a_idx].value < b[b_idx].value)) {
+      merge_one(a[a_idx], b, b_idx);
+      a_idx++;
+    } else {
+      merge_one(b[b_idx], a, a_idx);
+      b_idx++;
+    }
+  }
+  return merged;
+}
+
+void QuantileSketch::Prune() {
+  if (entries_.size() <= static_cast<size_t>(max_entries_)) {
+    return;
+  }
+  // Keep the tuples with mid-ranks closest to "max_entries_" evenly spaced
+  // ranks. The first and last tuples (i.e. the minimum and maximum values)
+  // are always kept. The dropped weights remain accounted for in the rank
+  // bounds of the kept tuples.
+  std::vector<Entry> pruned;
+  pruned.reserve(max_entries_);
+  pruned.push_back(entries_.front());
+  const double max_rank = entries_.back().max_rank;
+  size_t entry_idx = 1;
+  for (int slot_idx = 1; slot_idx < max_entries_ - 1; slot_idx++) {
+    const double target = max_rank * slot_idx / (max_entries_ - 1);
+    while (entry_idx + 1 < entries_.size() - 1 &&
+           std::abs((entries_[entry_idx + 1].min_rank +
+                     entries_[entry_idx + 1].max_rank) /
+                        2 -
+                    target) <= std::abs((entries_[entry_idx].min_rank +
+                                         entries_[entry_idx].max_rank) /
+                                            2 -
+                                        target)) {
+      entry_idx++;
+    }
+    if (entry_idx < entries_.size() - 1 &&
+        pruned.back().value != entries_[entry_idx].value) {
+      pruned.push_back(entries_[entry_idx]);
+    }
+  }
+  if (pruned.back().value != entries_.back().value) {
+    pruned.push_back(entries_.back());
+  }
+  entries_ = std::move(pruned);
+}
+
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
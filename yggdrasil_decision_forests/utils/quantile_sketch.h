@@ -0,0 +1,110 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Streaming quantile sketch.
+//
+// Bounded-memory summary of a stream of weighted float values supporting
+// approximate quantile queries. The sketch is a Greenwald-Khanna style
+// summary: a sorted list of tuples (value, minimum rank, maximum rank,
+// weight) that is periodically merged with the buffered values and pruned
+// back to "max_entries" tuples. Each prune adds at most
+// "total_weight / (max_entries - 1)" of rank error.
+//
+// Usage example:
+//
+//   QuantileSketch sketch(/*max_entries=*/1000);
+//   for (const float value : values) {
+//     sketch.Add(value);
+//   }
+//   const float median = sketch.Quantile(0.5).value();
+//
+#ifndef YGGDRASIL_DECISION_FORESTS_UTILS_QUANTILE_SKETCH_H_
+#define YGGDRASIL_DECISION_FORESTS_UTILS_QUANTILE_SKETCH_H_
+
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "yggdrasil_decision_forests/utils/compatibility.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+
+class QuantileSketch {
+ public:
+  // Summary tuple. The rank of a value "v" is the total weight of the stream
+  // items smaller than "v". "min_rank" and "max_rank" bound the rank of
+  // "value" in the stream, and "weight" is the total weight of the stream
+  // items collapsed into the tuple.
+  struct Entry {
+    float value;
+    double min_rank;
+    double max_rank;
+    double weight;
+  };
+
+  // "max_entries" bounds both the memory usage and the rank error of the
+  // sketch. Should be at least 2.
+  explicit QuantileSketch(int max_entries = 1000);
+
+  // Creates a sketch from previously exported entries (see "entries()").
+  static QuantileSketch FromEntries(int max_entries,
+                                    std::vector<Entry> entries);
+
+  // Adds a weighted value to the sketch.
+  void Add(float value, double weight = 1.);
+
+  // Merges the content of "other" into "this".
+  void Merge(QuantileSketch other);
+
+  // Approximate value of the quantile "q" in [0,1]. Fails if the sketch is
+  // empty.
+  utils::StatusOr<float> Quantile(double q);
+
+  // Sum of the weights added to the sketch.
+  double total_weight() const { return total_weight_; }
+
+  // Summary tuples, sorted by value. Used to serialize the sketch.
+  const std::vector<Entry>& entries();
+
+ private:
+  // Merges the buffered values into the summary and prunes the summary back
+  // to "max_entries_" tuples.
+  void Flush();
+
+  // Merges two summaries sorted by value into a single sorted summary.
+  static std::vector<Entry> MergeSummaries(const std::vector<Entry>& a,
+                                           const std::vector<Entry>& b);
+
+  // Replaces "entries_" with at most "max_entries_" tuples.
+  void Prune();
+
+  // Maximum number of summary tuples.
+  int max_entries_;
+
+  // Summary tuples, sorted by value.
+  std::vector<Entry> entries_;
+
+  // Values not yet merged into "entries_", unsorted.
+  std::vector<std::pair<float, double>> buffer_;
+
+  // Sum of the weights added to the sketch.
+  double total_weight_ = 0;
+};
+
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
+
+#endif  // YGGDRASIL_DECISION_FORESTS_UTILS_QUANTILE_SKETCH_H_
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2022 Google LLC.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "yggdrasil_decision_forests/utils/quantile_sketch.h"
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace yggdrasil_decision_forests {
+namespace utils {
+namespace {
+
+TEST(QuantileSketch, Exact) {
+  // Fewer values than entries: the quantiles are exact.
+  QuantileSketch sketch(/*max_entries=*/100);
+  for (int value = 0; value < 10; value++) {
+    sketch.Add(value);
+  }
+  EXPECT_EQ(sketch.total_weight(), 10.);
+  EXPECT_EQ(sketch.Quantile(0.).value(), 0.f);
+  EXPECT_EQ(sketch.Quantile(1.).value(), 9.f);
+  EXPECT_NEAR(sketch.Quantile(0.5).value(), 4.5f, 1.f);
+}
+
+TEST(QuantileSketch, Empty) {
+  QuantileSketch sketch;
+  EXPECT_FALSE(sketch.Quantile(0.5).ok());
+}
+
+TEST(QuantileSketch, UniformStream) {
+  QuantileSketch sketch(/*max_entries=*/1000);
+  std::mt19937 rnd(1234);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  const int num_values = 1000000;
+  for (int value_idx = 0; value_idx < num_values; value_idx++) {
+    sketch.Add(dist(rnd));
+  }
+  EXPECT_LE(sketch.entries().size(), 1000);
+  EXPECT_EQ(sketch.total_weight(), num_values);
+  for (const double q : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99}) {
+    EXPECT_NEAR(sketch.Quantile(q).value(), q, 0.02);
+  }
+}
+
+TEST(QuantileSketch, SkewedWeightedStream) {
+  QuantileSketch sketch(/*max_entries=*/1000);
+  // Half of the weight on the value 0, the rest uniform in [0,1].
+  sketch.Add(0.f, 100000.);
+  std::mt19937 rnd(1234);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  for (int value_idx = 0; value_idx < 100000; value_idx++) {
+    sketch.Add(dist(rnd));
+  }
+  EXPECT_NEAR(sketch.Quantile(0.25).value(), 0.f, 0.02);
+  EXPECT_NEAR(sketch.Quantile(0.75).value(), 0.5f, 0.02);
+}
+
+TEST(QuantileSketch, FromEntries) {
+  QuantileSketch sketch(/*max_entries=*/1000);
+  std::mt19937 rnd(1234);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  for (int value_idx = 0; value_idx < 100000; value_idx++) {
+    sketch.Add(dist(rnd));
+  }
+  auto restored = QuantileSketch::FromEntries(1000, sketch.entries());
+  EXPECT_EQ(restored.total_weight(), sketch.total_weight());
+  EXPECT_EQ(restored.Quantile(0.5).value(), sketch.Quantile(0.5).value());
+  // The restored sketch accepts new values.
+  restored.Add(0.5f);
+  EXPECT_EQ(restored.total_weight(), sketch.total_weight() + 1);
+}
+
+TEST(QuantileSketch, Merge) {
+  QuantileSketch sketch_1(/*max_entries=*/1000);
+  QuantileSketch sketch_2(/*max_entries=*/1000);
+  std::mt19937 rnd(1234);
+  std::uniform_real_distribution<float> dist_1(0.f, 1.f);
+  std::uniform_real_distribution<float> dist_2(1.f, 2.f);
+  for (int value_idx = 0; value_idx < 100000; value_idx++) {
+    sketch_1.Add(dist_1(rnd));
+    sketch_2.Add(dist_2(rnd));
+  }
+  sketch_1.Merge(std::move(sketch_2));
+  EXPECT_EQ(sketch_1.total_weight(), 200000);
+  EXPECT_LE(sketch_1.entries().size(), 1000);
+  for (const double q : {0.1, 0.25, 0.5, 0.75, 0.9}) {
+    EXPECT_NEAR(sketch_1.Quantile(q).value(), 2 * q, 0.02);
+  }
+}
+
+}  // namespace
+}  // namespace utils
+}  // namespace yggdrasil_decision_forests
@@ -18,6 +18,8 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_UTILS_RANDOM_H_
 #define YGGDRASIL_DECISION_FORESTS_UTILS_RANDOM_H_
 
+#include <stdint.h>
+
 #include <random>
 
 namespace yggdrasil_decision_forests {
@@ -25,6 +27,18 @@ namespace utils {
 
 using RandomEngine = std::mt19937;
 
+// Derives a seed from a base seed and the index of a "stream" (e.g. a tree, a
+// split job, a random projection). Seeding parallel units of work with
+// "DeriveSeed" (instead of drawing their seeds from a shared generator) makes
+// the generated random sequences independent of the number of threads and of
+// the scheduling order of the units. The mixing is the SplitMix64 finalizer.
+inline uint64_t DeriveSeed(const uint64_t seed, const uint64_t stream) {
+  uint64_t state = seed + (stream + 1) * 0x9e3779b97f4a7c15ull;
+  state = (state ^ (state >> 30)) * 0xbf58476d1ce4e5b9ull;
+  state = (state ^ (state >> 27)) * 0x94d049bb133111ebull;
+  return state ^ (state >> 31);
+}
+
 }  // namespace utils
 }  // namespace yggdrasil_decision_forests
 
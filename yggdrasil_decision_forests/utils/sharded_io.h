@@ -18,13 +18,21 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_TOOL_SHARDED_IO_H_
 #define YGGDRASIL_DECISION_FORESTS_TOOL_SHARDED_IO_H_
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "yggdrasil_decision_forests/utils/compatibility.h"
+#include "yggdrasil_decision_forests/utils/concurrency.h"
+#include "yggdrasil_decision_forests/utils/instrument.h"
 #include "yggdrasil_decision_forests/utils/logging.h"
 #include "yggdrasil_decision_forests/utils/protobuf.h"
 #include "yggdrasil_decision_forests/utils/status_macros.h"
@@ -89,6 +97,251 @@ class ShardedReader : public ProtoReaderInterface<T> {
   int cur_path_idx_ = -1;
 };
 
+// Wraps a "ShardedReader" and reads up to "buffer_size" records ahead on a
+// background thread. While the caller processes a record, the wrapped reader
+// keeps reading and opens the following shards, overlapping the file reads
+// (e.g. from a remote file system) with the processing of the records.
+//
+// The wrapped reader must not be used directly anymore. Like "ShardedReader",
+// this class supports a single "Open" call. The records are returned in the
+// same order as by the wrapped reader.
+template <typename T>
+class PrefetchingShardedReader : public ProtoReaderInterface<T> {
+ public:
+  explicit PrefetchingShardedReader(std::unique_ptr<ShardedReader<T>> reader,
+                                    int buffer_size = 1000)
+      : reader_(std::move(reader)), buffer_size_(buffer_size) {}
+
+  virtual ~PrefetchingShardedReader() { StopProducer(); }
+
+  // Open a typed sharded path, and start the background reading.
+  absl::Status Open(absl::string_view sharded_path) {
+    RETURN_IF_ERROR(reader_->Open(sharded_path));
+    StartProducer();
+    return absl::OkStatus();
+  }
+
+  // Open a list of files to read, and start the background reading.
+  absl::Status Open(const std::vector<std::string>& paths) {
+    RETURN_IF_ERROR(reader_->Open(paths));
+    StartProducer();
+    return absl::OkStatus();
+  }
+
+  // Try to retrieve the next available value. If no more value are
+  // available, returns false. Blocks if the background thread is late.
+  utils::StatusOr<bool> Next(T* value) {
+    auto record = records_.Pop();
+    if (!record.has_value()) {
+      // The background thread read all the records.
+      return false;
+    }
+    ASSIGN_OR_RETURN(*value, std::move(record.value()));
+    // Return the buffer slot of the record to the background thread.
+    tokens_.Push(1);
+    return true;
+  }
+
+ private:
+  void StartProducer() {
+    DCHECK(!producer_);
+    for (int i = 0; i < buffer_size_; i++) {
+      tokens_.Push(1);
+    }
+    producer_ =
+        absl::make_unique<concurrency::Thread>([this]() { ProducerLoop(); });
+  }
+
+  void StopProducer() {
+    if (!producer_) {
+      return;
+    }
+    tokens_.Close();  // Wakes-up and stops the background thread.
+    producer_->Join();
+    producer_.reset();
+  }
+
+  // Running loop of the background thread. Each buffered record holds one
+  // token: the buffer is full when all the tokens are consumed.
+  void ProducerLoop() {
+    while (tokens_.Pop().has_value()) {
+      T value;
+      auto has_value = reader_->Next(&value);
+      if (!has_value.ok()) {
+        records_.Push(has_value.status());
+        break;
+      }
+      if (!has_value.value()) {
+        break;
+      }
+      records_.Push(std::move(value));
+    }
+    records_.Close();
+  }
+
+  // Wrapped reader. Only accessed by the background thread after "Open".
+  std::unique_ptr<ShardedReader<T>> reader_;
+
+  // Maximum number of records read ahead.
+  const int buffer_size_;
+
+  // Records read by the background thread, in reading order. An error
+  // interrupts the reading and is returned (once) by "Next".
+  concurrency::Channel<utils::StatusOr<T>> records_;
+
+  // Buffer capacity tokens. See "ProducerLoop".
+  concurrency::Channel<int> tokens_;
+
+  // Background reading thread.
+  std::unique_ptr<concurrency::Thread> producer_;
+};
+
+// Reads several shards in parallel, each on its own background thread with its
+// own wrapped reader. Unlike "PrefetchingShardedReader", the decompression and
+// decoding of the records (e.g. the GZIP inflate of a TFRecord shard) runs on
+// the worker threads, in parallel with the consumer and with the other shards.
+//
+// The records of a same shard are returned in order. Records of different
+// shards are interleaved: use "PrefetchingShardedReader" if the global record
+// order matters.
+//
+// "reader_factory" creates the per-worker readers. Like "ShardedReader", this
+// class supports a single "Open" call.
+template <typename T>
+class ParallelShardedReader : public ProtoReaderInterface<T> {
+ public:
+  ParallelShardedReader(
+      std::function<std::unique_ptr<ShardedReader<T>>()> reader_factory,
+      int num_threads = 8, int buffer_size = 1000)
+      : reader_factory_(std::move(reader_factory)),
+        num_threads_(num_threads),
+        buffer_size_(buffer_size) {}
+
+  virtual ~ParallelShardedReader() { StopWorkers(); }
+
+  // Open a typed sharded path, and start the background reading.
+  absl::Status Open(absl::string_view sharded_path) {
+    std::vector<std::string> paths;
+    RETURN_IF_ERROR(ExpandInputShards(sharded_path, &paths));
+    return Open(paths);
+  }
+
+  // Open a list of files to read, and start the background reading.
+  absl::Status Open(const std::vector<std::string>& paths) {
+    if (paths.empty()) {
+      return absl::NotFoundError("No file provided.");
+    }
+    DCHECK(workers_.empty());
+    for (const auto& path : paths) {
+      pending_shards_.Push(path);
+    }
+    pending_shards_.Close();
+    for (int i = 0; i < buffer_size_; i++) {
+      tokens_.Push(1);
+    }
+    num_active_workers_ = num_threads_;
+    workers_.reserve(num_threads_);
+    for (int i = 0; i < num_threads_; i++) {
+      workers_.push_back(
+          absl::make_unique<concurrency::Thread>([this]() { WorkerLoop(); }));
+    }
+    return absl::OkStatus();
+  }
+
+  // Try to retrieve the next available value. If no more value are
+  // available, returns false. Blocks if the worker threads are late.
+  utils::StatusOr<bool> Next(T* value) {
+    auto record = records_.Pop();
+    if (!record.has_value()) {
+      // The worker threads read all the shards.
+      return false;
+    }
+    ASSIGN_OR_RETURN(*value, std::move(record.value()));
+    // Return the buffer slot of the record to the worker threads.
+    tokens_.Push(1);
+    return true;
+  }
+
+ private:
+  void StopWorkers() {
+    // Wakes-up and stops the worker threads.
+    pending_shards_.Close();
+    tokens_.Close();
+    for (auto& worker : workers_) {
+      worker->Join();
+    }
+    workers_.clear();
+  }
+
+  // Running loop of the worker threads. Each worker consumes the shards one at
+  // a time, keeping the records of a shard in order. Each buffered record
+  // holds one token: the buffer is full when all the tokens are consumed.
+  void WorkerLoop() {
+    while (true) {
+      auto shard = pending_shards_.Pop();
+      if (!shard.has_value()) {
+        break;
+      }
+      auto reader = reader_factory_();
+      auto open_status =
+          reader->Open(std::vector<std::string>{std::move(shard).value()});
+      if (!open_status.ok()) {
+        if (tokens_.Pop().has_value()) {
+          records_.Push(open_status);
+        }
+        break;
+      }
+      bool stop = false;
+      while (tokens_.Pop().has_value()) {
+        T value;
+        auto has_value = reader->Next(&value);
+        if (!has_value.ok()) {
+          records_.Push(has_value.status());
+          stop = true;
+          break;
+        }
+        if (!has_value.value()) {
+          // End of the shard. The token was not used.
+          tokens_.Push(1);
+          break;
+        }
+        records_.Push(std::move(value));
+      }
+      if (stop) {
+        break;
+      }
+    }
+    if (--num_active_workers_ == 0) {
+      records_.Close();
+    }
+  }
+
+  // Creates the reader of each worker thread.
+  const std::function<std::unique_ptr<ShardedReader<T>>()> reader_factory_;
+
+  // Number of worker threads.
+  const int num_threads_;
+
+  // Maximum number of records read ahead.
+  const int buffer_size_;
+
+  // Shards not yet assigned to a worker.
+  concurrency::Channel<std::string> pending_shards_;
+
+  // Records read by the worker threads. An error interrupts the reading of
+  // the worker and is returned (once per failed worker) by "Next".
+  concurrency::Channel<utils::StatusOr<T>> records_;
+
+  // Buffer capacity tokens. See "WorkerLoop".
+  concurrency::Channel<int> tokens_;
+
+  // Number of workers that did not yet terminate.
+  std::atomic<int> num_active_workers_{0};
+
+  // Worker threads.
+  std::vector<std::unique_ptr<concurrency::Thread>> workers_;
+};
+
 // Helper class for the sequential writing of sharded files.
 template <typename T>
 class ShardedWriter : public ProtoWriterInterface<T> {
@@ -100,6 +353,10 @@ class ShardedWriter : public ProtoWriterInterface<T> {
   absl::Status Open(absl::string_view sharded_path,
                     const int64_t num_records_by_shard);
 
+  // Open a list of files to write.
+  absl::Status Open(const std::vector<std::string>& paths,
+                    const int64_t num_records_by_shard);
+
   // Write a new record.
   absl::Status Write(const T& value);
 
@@ -134,6 +391,157 @@ class ShardedWriter : public ProtoWriterInterface<T> {
   int64_t num_records_in_cur_shard_;
 };
 
+// Writes the shards in parallel, each worker thread writing its own subset of
+// the shards with its own wrapped writer. The records are distributed
+// round-robin across the workers and the shards are strided accordingly: the
+// record order within a shard and the number of records per shard match the
+// output of a plain "ShardedWriter", but the global record-to-shard
+// assignment differs (record "i" goes to shard "i % num_workers" first, etc.).
+// The file writes run on the worker threads, overlapping the stream flushes
+// (e.g. to a remote file system) with the producer and with the other shards.
+//
+// "writer_factory" creates the per-worker writers. At most
+// "min(num_threads, num_shards)" workers are created. Like "ShardedWriter",
+// this class supports a single "Open" call. An error in a worker is returned
+// by "CloseWithStatus" (or crashes the destructor, like "ShardedWriter").
+template <typename T>
+class ParallelShardedWriter : public ProtoWriterInterface<T> {
+ public:
+  ParallelShardedWriter(
+      std::function<std::unique_ptr<ShardedWriter<T>>()> writer_factory,
+      int num_threads = 8, int buffer_size = 1000)
+      : writer_factory_(std::move(writer_factory)),
+        num_threads_(num_threads),
+        buffer_size_(buffer_size) {}
+
+  virtual ~ParallelShardedWriter() { CHECK_OK(CloseWithStatus()); }
+
+  // Open a typed sharded path and start the worker threads. If
+  // num_records_by_shard==-1, each worker writes all its records in its first
+  // shard.
+  absl::Status Open(absl::string_view sharded_path,
+                    const int64_t num_records_by_shard) {
+    std::vector<std::string> paths;
+    RETURN_IF_ERROR(ExpandOutputShards(sharded_path, &paths));
+    DCHECK(workers_.empty());
+    const int num_workers =
+        std::max(1, std::min(num_threads_, static_cast<int>(paths.size())));
+    slots_.reserve(num_workers);
+    for (int worker_idx = 0; worker_idx < num_workers; worker_idx++) {
+      auto slot = absl::make_unique<WriterSlot>();
+      slot->writer = writer_factory_();
+      // Stride the shards to match the round-robin distribution of the
+      // records in "Write".
+      for (size_t path_idx = worker_idx; path_idx < paths.size();
+           path_idx += num_workers) {
+        slot->paths.push_back(paths[path_idx]);
+      }
+      for (int i = 0; i < std::max(1, buffer_size_ / num_workers); i++) {
+        slot->tokens.Push(1);
+      }
+      slots_.push_back(std::move(slot));
+    }
+    workers_.reserve(num_workers);
+    for (int worker_idx = 0; worker_idx < num_workers; worker_idx++) {
+      workers_.push_back(absl::make_unique<concurrency::Thread>(
+          [this, worker_idx, num_records_by_shard]() {
+            WorkerLoop(worker_idx, num_records_by_shard);
+          }));
+    }
+    return absl::OkStatus();
+  }
+
+  // Write a new record. Blocks if the record's worker thread is late.
+  absl::Status Write(const T& value) override {
+    auto& slot = *slots_[next_worker_];
+    next_worker_ = (next_worker_ + 1) % slots_.size();
+    // Each buffered record holds one token: back pressure on the producer.
+    slot.tokens.Pop();
+    slot.records.Push(value);
+    return absl::OkStatus();
+  }
+
+  // Flushes and closes all the shards, and returns the first worker error (if
+  // any).
+  absl::Status CloseWithStatus() {
+    if (workers_.empty()) {
+      return absl::OkStatus();
+    }
+    for (auto& slot : slots_) {
+      slot->records.Close();
+    }
+    for (auto& worker : workers_) {
+      worker->Join();
+    }
+    workers_.clear();
+    absl::Status status;
+    for (auto& slot : slots_) {
+      status.Update(slot->status);
+    }
+    slots_.clear();
+    return status;
+  }
+
+ private:
+  // Per-worker state.
+  struct WriterSlot {
+    std::unique_ptr<ShardedWriter<T>> writer;
+
+    // Shards written by the worker, in writing order.
+    std::vector<std::string> paths;
+
+    // Records pending to be written by the worker.
+    concurrency::Channel<T> records;
+
+    // Buffer capacity tokens. See "Write".
+    concurrency::Channel<int> tokens;
+
+    // Worker result. Only read after the worker joined.
+    absl::Status status;
+  };
+
+  // Running loop of the worker threads. On error, the worker keeps consuming
+  // (and dropping) its records so the producer never blocks; the error is
+  // reported by "CloseWithStatus".
+  void WorkerLoop(const int worker_idx, const int64_t num_records_by_shard) {
+    auto& slot = *slots_[worker_idx];
+    auto status = slot.writer->Open(slot.paths, num_records_by_shard);
+    while (true) {
+      auto record = slot.records.Pop();
+      if (!record.has_value()) {
+        break;
+      }
+      if (status.ok()) {
+        status = slot.writer->Write(record.value());
+      }
+      slot.tokens.Push(1);
+    }
+    if (status.ok()) {
+      status = slot.writer->CloseWithStatus();
+    }
+    slot.status = status;
+  }
+
+  // Creates the writer of each worker thread.
+  const std::function<std::unique_ptr<ShardedWriter<T>>()> writer_factory_;
+
+  // Maximum number of worker threads.
+  const int num_threads_;
+
+  // Maximum number of records buffered ahead of the workers, across all the
+  // workers.
+  const int buffer_size_;
+
+  // Per-worker states.
+  std::vector<std::unique_ptr<WriterSlot>> slots_;
+
+  // Worker threads.
+  std::vector<std::unique_ptr<concurrency::Thread>> workers_;
+
+  // Worker receiving the next record.
+  int next_worker_ = 0;
+};
+
 template <typename T>
 absl::Status ShardedWriter<T>::Open(absl::string_view sharded_path,
                                     const int64_t num_records_by_shard) {
@@ -143,6 +551,15 @@ absl::Status ShardedWriter<T>::Open(absl::string_view sharded_path,
   return OpenNextShard();
 }
 
+template <typename T>
+absl::Status ShardedWriter<T>::Open(const std::vector<std::string>& paths,
+                                    const int64_t num_records_by_shard) {
+  paths_ = paths;
+  num_records_by_shard_ = num_records_by_shard;
+  num_records_in_cur_shard_ = 0;
+  return OpenNextShard();
+}
+
 template <typename T>
 absl::Status ShardedWriter<T>::Write(const T& value) {
   if (num_records_by_shard_ != -1 &&
@@ -205,6 +622,7 @@ utils::StatusOr<bool> ShardedReader<T>::OpenNextShard() {
   if (cur_path_idx_ >= paths_.size()) {
     return false;
   }
+  YDF_INSTRUMENT_SPAN("sharded_io.open_shard");
   RETURN_IF_ERROR(OpenShard(paths_[cur_path_idx_]));
   return true;
 }
@@ -50,6 +50,9 @@ template <typename T>
 class BlobSequenceShardedWriter : public ShardedWriter<T> {
  public:
   BlobSequenceShardedWriter() = default;
+  explicit BlobSequenceShardedWriter(
+      const blob_sequence::WriterOptions& options)
+      : options_(options) {}
   ~BlobSequenceShardedWriter() override;
   absl::Status OpenShard(absl::string_view path) final;
   absl::Status WriteInShard(const T& value) final;
@@ -57,6 +60,7 @@ class BlobSequenceShardedWriter : public ShardedWriter<T> {
 
  private:
   blob_sequence::Writer writer_;
+  blob_sequence::WriterOptions options_;
   file::OutputFileCloser file_closer_;
   std::string buffer_;
 
@@ -66,7 +70,9 @@ class BlobSequenceShardedWriter : public ShardedWriter<T> {
 template <typename T>
 absl::Status BlobSequenceShardedReader<T>::OpenShard(
     const absl::string_view path) {
-  ASSIGN_OR_RETURN(auto stream, file::OpenInputFile(path));
+  ASSIGN_OR_RETURN(
+      auto stream,
+      file::OpenInputFile(path, file::InputFileHint::kSequentialScan));
   RETURN_IF_ERROR(file_closer_.reset(std::move(stream)));
   ASSIGN_OR_RETURN(reader_,
                    blob_sequence::Reader::Create(file_closer_.stream()));
@@ -90,8 +96,8 @@ absl::Status BlobSequenceShardedWriter<T>::OpenShard(
 
   ASSIGN_OR_RETURN(auto stream, file::OpenOutputFile(path));
   RETURN_IF_ERROR(file_closer_.reset(std::move(stream)));
-  ASSIGN_OR_RETURN(writer_,
-                   blob_sequence::Writer::Create(file_closer_.stream()));
+  ASSIGN_OR_RETURN(
+      writer_, blob_sequence::Writer::Create(file_closer_.stream(), options_));
   return absl::OkStatus();
 }
 
@@ -15,11 +15,13 @@
 
 #include "yggdrasil_decision_forests/utils/sharded_io.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -75,6 +77,144 @@ TEST(ShardedIO, ShardedReader) {
   EXPECT_FALSE(test.Next(&value).value());
 }
 
+TEST(ShardedIO, PrefetchingShardedReader) {
+  class TestShardedReader : public ShardedReader<std::string> {
+   public:
+    ~TestShardedReader() override = default;
+    absl::Status OpenShard(absl::string_view path) override {
+      last_path_ = std::string(path);
+      next_value_ = 0;
+      return absl::OkStatus();
+    }
+    utils::StatusOr<bool> NextInShard(std::string* value) override {
+      if (next_value_ == 2) {
+        return false;
+      }
+      value->clear();
+      absl::StrAppend(value, last_path_, next_value_++);
+      return true;
+    }
+
+   private:
+    int next_value_ = 0;
+    std::string last_path_;
+  };
+
+  // A buffer smaller than the number of records, to exercise the back
+  // pressure on the background thread.
+  PrefetchingShardedReader<std::string> test(
+      absl::make_unique<TestShardedReader>(), /*buffer_size=*/2);
+  EXPECT_OK(test.Open(std::vector<std::string>{"a", "b"}));
+  std::string value;
+  EXPECT_TRUE(test.Next(&value).value());
+  EXPECT_EQ(value, "a0");
+  EXPECT_TRUE(test.Next(&value).value());
+  EXPECT_EQ(value, "a1");
+  EXPECT_TRUE(test.Next(&value).value());
+  EXPECT_EQ(value, "b0");
+  EXPECT_TRUE(test.Next(&value).value());
+  EXPECT_EQ(value, "b1");
+  EXPECT_FALSE(test.Next(&value).value());
+}
+
+TEST(ShardedIO, PrefetchingShardedReaderError) {
+  class FailingShardedReader : public ShardedReader<std::string> {
+   public:
+    ~FailingShardedReader() override = default;
+    absl::Status OpenShard(absl::string_view path) override {
+      return absl::OkStatus();
+    }
+    utils::StatusOr<bool> NextInShard(std::string* value) override {
+      if (next_value_ == 2) {
+        return absl::InvalidArgumentError("Corrupted shard");
+      }
+      *value = absl::StrCat(next_value_++);
+      return true;
+    }
+
+   private:
+    int next_value_ = 0;
+  };
+
+  PrefetchingShardedReader<std::string> test(
+      absl::make_unique<FailingShardedReader>());
+  EXPECT_OK(test.Open(std::vector<std::string>{"a"}));
+  std::string value;
+  EXPECT_TRUE(test.Next(&value).value());
+  EXPECT_TRUE(test.Next(&value).value());
+  EXPECT_FALSE(test.Next(&value).ok());
+}
+
+TEST(ShardedIO, ParallelShardedReader) {
+  class TestShardedReader : public ShardedReader<std::string> {
+   public:
+    ~TestShardedReader() override = default;
+    absl::Status OpenShard(absl::string_view path) override {
+      last_path_ = std::string(path);
+      next_value_ = 0;
+      return absl::OkStatus();
+    }
+    utils::StatusOr<bool> NextInShard(std::string* value) override {
+      if (next_value_ == 2) {
+        return false;
+      }
+      value->clear();
+      absl::StrAppend(value, last_path_, next_value_++);
+      return true;
+    }
+
+   private:
+    int next_value_ = 0;
+    std::string last_path_;
+  };
+
+  // More shards than threads, and a buffer smaller than the number of records,
+  // to exercise the shard queue and the back pressure on the worker threads.
+  ParallelShardedReader<std::string> test(
+      []() { return absl::make_unique<TestShardedReader>(); },
+      /*num_threads=*/2, /*buffer_size=*/2);
+  EXPECT_OK(test.Open(std::vector<std::string>{"a", "b", "c"}));
+  std::vector<std::string> values;
+  std::string value;
+  while (test.Next(&value).value()) {
+    values.push_back(value);
+  }
+
+  // The order of the records of a same shard is preserved.
+  for (const auto& shard : {"a", "b", "c"}) {
+    const auto first = std::find(values.begin(), values.end(),
+                                 absl::StrCat(shard, 0)) -
+                       values.begin();
+    const auto second = std::find(values.begin(), values.end(),
+                                  absl::StrCat(shard, 1)) -
+                        values.begin();
+    EXPECT_LT(first, second);
+  }
+
+  std::sort(values.begin(), values.end());
+  EXPECT_THAT(values, ElementsAre("a0", "a1", "b0", "b1", "c0", "c1"));
+}
+
+TEST(ShardedIO, ParallelShardedReaderError) {
+  class FailingShardedReader : public ShardedReader<std::string> {
+   public:
+    ~FailingShardedReader() override = default;
+    absl::Status OpenShard(absl::string_view path) override {
+      return absl::OkStatus();
+    }
+    utils::StatusOr<bool> NextInShard(std::string* value) override {
+      return absl::InvalidArgumentError("Corrupted shard");
+    }
+  };
+
+  ParallelShardedReader<std::string> test(
+      []() { return absl::make_unique<FailingShardedReader>(); },
+      /*num_threads=*/1);
+  EXPECT_OK(test.Open(std::vector<std::string>{"a"}));
+  std::string value;
+  EXPECT_FALSE(test.Next(&value).ok());
+}
+
 TEST(ShardedIO, ShardedWriter) {
   class TestShardedWriter : public ShardedWriter<std::string> {
    public:
@@ -109,6 +249,71 @@ TEST(ShardedIO, ShardedWriter) {
             " O[f-00000-of-00002] W[a] W[b] O[f-00001-of-00002] W[c] W[d]");
 }
 
+TEST(ShardedIO, ParallelShardedWriter) {
+  class TestShardedWriter : public ShardedWriter<std::string> {
+   public:
+    explicit TestShardedWriter(std::string* logs) : logs_(logs) {}
+    ~TestShardedWriter() override = default;
+    absl::Status CloseWithStatus() final { return absl::OkStatus(); }
+    absl::Status OpenShard(absl::string_view path) final {
+      absl::StrAppend(logs_, " O[", path, "]");
+      return absl::OkStatus();
+    }
+    absl::Status WriteInShard(const std::string& value) final {
+      absl::StrAppend(logs_, " W[", value, "]");
+      return absl::OkStatus();
+    }
+
+   private:
+    // String representation of the operations. One log per worker: no
+    // synchronization needed.
+    std::string* logs_;
+  };
+
+  std::vector<std::unique_ptr<std::string>> logs;
+  // A buffer smaller than the number of records, to exercise the back
+  // pressure on the producer.
+  ParallelShardedWriter<std::string> test(
+      [&logs]() {
+        logs.push_back(absl::make_unique<std::string>());
+        return absl::make_unique<TestShardedWriter>(logs.back().get());
+      },
+      /*num_threads=*/2, /*buffer_size=*/2);
+  EXPECT_OK(test.Open("f@4", 2));
+  for (int record_idx = 0; record_idx < 8; record_idx++) {
+    EXPECT_OK(test.Write(absl::StrCat(record_idx)));
+  }
+  EXPECT_OK(test.CloseWithStatus());
+
+  // The records are distributed round-robin over the strided shards.
+  ASSERT_EQ(logs.size(), 2);
+  EXPECT_EQ(*logs[0],
+            " O[f-00000-of-00004] W[0] W[2] O[f-00002-of-00004] W[4] W[6]");
+  EXPECT_EQ(*logs[1],
+            " O[f-00001-of-00004] W[1] W[3] O[f-00003-of-00004] W[5] W[7]");
+}
+
+TEST(ShardedIO, ParallelShardedWriterError) {
+  class FailingShardedWriter : public ShardedWriter<std::string> {
+   public:
+    ~FailingShardedWriter() override = default;
+    absl::Status CloseWithStatus() final { return absl::OkStatus(); }
+    absl::Status OpenShard(absl::string_view path) final {
+      return absl::OkStatus();
+    }
+    absl::Status WriteInShard(const std::string& value) final {
+      return absl::InvalidArgumentError("Cannot write");
+    }
+  };
+
+  ParallelShardedWriter<std::string> test(
+      []() { return absl::make_unique<FailingShardedWriter>(); },
+      /*num_threads=*/1);
+  EXPECT_OK(test.Open("f@1", -1));
+  EXPECT_OK(test.Write("a"));
+  EXPECT_FALSE(test.CloseWithStatus().ok());
+}
+
 TEST(ShardedIO, ExpandInputShards) {
   // If EXTERNAL_FILESYSTEM is test, patterns on the directory name are not
   // tested.
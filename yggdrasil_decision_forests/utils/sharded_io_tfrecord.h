@@ -49,6 +49,23 @@ class TFRecordShardedReader : public ShardedReader<T> {
   DISALLOW_COPY_AND_ASSIGN(TFRecordShardedReader);
 };
 
+// Specialization of ShardedReader for the raw (serialized) records of
+// sharded TFRecords. Used to delegate the parsing of the records to other
+// threads.
+class TFRecordRawShardedReader : public ShardedReader<std::string> {
+ public:
+  TFRecordRawShardedReader() = default;
+  absl::Status OpenShard(absl::string_view path) override;
+  utils::StatusOr<bool> NextInShard(std::string* record) override;
+
+ private:
+  std::unique_ptr<tensorflow::io::SequentialRecordReader> reader_;
+  std::unique_ptr<tensorflow::RandomAccessFile> file_;
+  tensorflow::tstring buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(TFRecordRawShardedReader);
+};
+
 // Specialization of ShardedWriter for TFRecords: Class for the sequential
 // writing of sharded TFRecords.
 template <typename T>
@@ -95,6 +112,33 @@ utils::StatusOr<bool> TFRecordShardedReader<T>::NextInShard(T* example) {
   }
 }
 
+inline absl::Status TFRecordRawShardedReader::OpenShard(
+    const absl::string_view path) {
+  RETURN_IF_ERROR(ToUtilStatus(tensorflow::Env::Default()->NewRandomAccessFile(
+      std::string(path), &file_)));
+  reader_ = absl::make_unique<tensorflow::io::SequentialRecordReader>(
+      file_.get(),
+      tensorflow::io::RecordReaderOptions::CreateRecordReaderOptions("GZIP"));
+
+  return absl::OkStatus();
+}
+
+inline utils::StatusOr<bool> TFRecordRawShardedReader::NextInShard(
+    std::string* record) {
+  const auto tf_status = reader_->ReadRecord(&buffer_);
+  if (tf_status.ok()) {
+    // Valid record.
+    record->assign(buffer_.data(), buffer_.size());
+    return true;
+  } else if (tf_status.code() == tensorflow::error::OUT_OF_RANGE) {
+    // No more records available.
+    return false;
+  } else {
+    // Reading error.
+    return ToUtilStatus(tf_status);
+  }
+}
+
 template <typename T>
 absl::Status TFRecordShardedWriter<T>::OpenShard(const absl::string_view path) {
   RETURN_IF_ERROR(CloseWithStatus());
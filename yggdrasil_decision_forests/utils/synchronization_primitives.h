@@ -22,11 +22,13 @@
 #define YGGDRASIL_DECISION_FORESTS_UTILS_SYNCHRONIZATION_PRIMITIVES_H_
 
 #ifdef YGG_STD_MUTEX
+#include <chrono>              // c++11
 #include <condition_variable>  // c++11
 #include <mutex>               // c++11
 #include <shared_mutex>        // c++14 and c++17
 #else
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #endif
 
 #ifdef YGG_STD_BLOCKING_COUNTER_AND_NOTIFICATION
@@ -98,6 +100,15 @@ class CondVar {
   void SignalAll() { cv_.notify_all(); }
   void Wait(Mutex* mutex, MutexLock* lock) { cv_.wait(lock->std()); }
 
+  // Waits until signaled or until "timeout_usec" microseconds have elapsed.
+  // Returns true if the timeout expired.
+  bool WaitWithTimeout(Mutex* mutex, MutexLock* lock,
+                       const int64_t timeout_usec) {
+    return cv_.wait_for(lock->std(), std::chrono::microseconds(
+                                         timeout_usec)) ==
+           std::cv_status::timeout;
+  }
+
  private:
   std::condition_variable cv_;
 };
@@ -116,6 +127,13 @@ class CondVar {
   void SignalAll() { cv_.SignalAll(); }
   void Wait(Mutex* mutex, MutexLock* lock) { cv_.Wait(mutex); }
 
+  // Waits until signaled or until "timeout_usec" microseconds have elapsed.
+  // Returns true if the timeout expired.
+  bool WaitWithTimeout(Mutex* mutex, MutexLock* lock,
+                       const int64_t timeout_usec) {
+    return cv_.WaitWithTimeout(mutex, absl::Microseconds(timeout_usec));
+  }
+
  private:
   absl::CondVar cv_;
 };
@@ -22,6 +22,7 @@
 #ifndef YGGDRASIL_DECISION_FORESTS_TOOL_USAGE_H_
 #define YGGDRASIL_DECISION_FORESTS_TOOL_USAGE_H_
 
+#include "absl/strings/string_view.h"
 #include "absl/time/time.h"
 #include "yggdrasil_decision_forests/dataset/data_spec.pb.h"
 #include "yggdrasil_decision_forests/learner/abstract_learner.pb.h"
@@ -48,6 +49,13 @@ void OnTrainingEnd(const dataset::proto::DataSpecification& data_spec,
                    int64_t num_examples, const model::AbstractModel& model,
                    absl::Duration training_duration);
 
+// Completion of a training phase (e.g. dataset cache loading, pre-sorting,
+// gradient storage allocation) with the peak resident memory (in bytes)
+// reached during the phase, as measured by
+// utils::instrument::ScopedMemoryPhase. "peak_rss_bytes" is -1 if the
+// measure is not available on the platform.
+void OnTrainingPhaseMemory(absl::string_view phase, int64_t peak_rss_bytes);
+
 // Inference of a model.
 //
 // The inference on model containing other models (e.g. the ensembler or the
@@ -35,6 +35,11 @@ void OnTrainingEnd(const dataset::proto::DataSpecification& data_spec,
   // Add usage tracking here.
 }
 
+void OnTrainingPhaseMemory(const absl::string_view phase,
+                           const int64_t peak_rss_bytes) {
+  // Add usage tracking here.
+}
+
 void OnInference(const int64_t num_examples,
                  const model::proto::Metadata& metadata) {
   // Add usage tracking here.